@@ -17,6 +17,7 @@ EXE_MAIN:=$(OUTDIR)/plundersquad.exe
 EXE_TEST:=$(OUTDIR)/test.exe
 EXE_EDIT:=$(OUTDIR)/edit.exe
 EXE_RESPACK:=$(OUTDIR)/respack.exe
+EXE_HEADLESS:=$(OUTDIR)/headless.exe
 
 # Wasn't a problem on my old Windows box, but the new one, in msys terminal, doesn't print stderr or stdout from app.
 # However if we redirect that output and explicitly 'echo' it, there it is.
@@ -29,14 +29,17 @@ OFILES_MAIN:=$(filter $(MIDDIR)/main/%,$(OFILES_ALL))
 OFILES_TEST:=$(filter $(MIDDIR)/test/%,$(OFILES_ALL))
 OFILES_EDIT:=$(filter $(MIDDIR)/edit/%,$(OFILES_ALL))
 OFILES_RESPACK:=$(filter $(MIDDIR)/respack/%,$(OFILES_ALL))
-OFILES_COMMON:=$(filter-out $(OFILES_MAIN) $(OFILES_TEST) $(OFILES_EDIT) $(OFILES_RESPACK),$(OFILES_ALL))
+OFILES_HEADLESS:=$(filter $(MIDDIR)/headless/%,$(OFILES_ALL))
+OFILES_COMMON:=$(filter-out $(OFILES_MAIN) $(OFILES_TEST) $(OFILES_EDIT) $(OFILES_RESPACK) $(OFILES_HEADLESS),$(OFILES_ALL))
 OFILES_MAIN:=$(OFILES_COMMON) $(OFILES_MAIN)
 OFILES_TEST:=$(OFILES_COMMON) $(OFILES_TEST)
 OFILES_EDIT:=$(OFILES_COMMON) $(OFILES_EDIT)
 OFILES_RESPACK:=$(OFILES_COMMON) $(OFILES_RESPACK)
+OFILES_HEADLESS:=$(OFILES_COMMON) $(OFILES_HEADLESS)
 
 # Some extra rules to reduce the size of the main executable.
 OFILES_MAIN:=$(filter-out $(MIDDIR)/gui/editor/%,$(OFILES_MAIN))
+OFILES_HEADLESS:=$(filter-out $(MIDDIR)/gui/editor/%,$(OFILES_HEADLESS))
 
 ifneq (,$(strip $(SRCFILES_M)))
   ifeq (,$(strip $(OBJC)))
@@ -59,19 +62,22 @@ ifeq ($(PS_ARCH),mswin)
   OFILES_LIST_TEST:=$(MIDDIR)/ofiles-list-test
   OFILES_LIST_EDIT:=$(MIDDIR)/ofiles-list-edit
   OFILES_LIST_RESPACK:=$(MIDDIR)/ofiles-list-respack
+  OFILES_LIST_HEADLESS:=$(MIDDIR)/ofiles-list-headless
   ifeq (rebuild file lists,rebuild file lists)
     OFILES_LIST:=$(MIDDIR)/ofiles-list
     $(shell rm -f $(OFILES_LIST))
     $(foreach F,$(OFILES_ALL),$(shell echo $F >>$(OFILES_LIST)))
-    $(shell sed -E '/$(PS_CONFIG)\/(test|edit|respack)\//d' $(OFILES_LIST) > $(OFILES_LIST_MAIN))
-    $(shell sed -E '/$(PS_CONFIG)\/(main|edit|respack)\//d' $(OFILES_LIST) > $(OFILES_LIST_TEST))
-    $(shell sed -E '/$(PS_CONFIG)\/(test|main|respack)\//d' $(OFILES_LIST) > $(OFILES_LIST_EDIT))
-    $(shell sed -E '/$(PS_CONFIG)\/(test|edit|main)\//d' $(OFILES_LIST) > $(OFILES_LIST_RESPACK))
+    $(shell sed -E '/$(PS_CONFIG)\/(test|edit|respack|headless)\//d' $(OFILES_LIST) > $(OFILES_LIST_MAIN))
+    $(shell sed -E '/$(PS_CONFIG)\/(main|edit|respack|headless)\//d' $(OFILES_LIST) > $(OFILES_LIST_TEST))
+    $(shell sed -E '/$(PS_CONFIG)\/(test|main|respack|headless)\//d' $(OFILES_LIST) > $(OFILES_LIST_EDIT))
+    $(shell sed -E '/$(PS_CONFIG)\/(test|edit|main|headless)\//d' $(OFILES_LIST) > $(OFILES_LIST_RESPACK))
+    $(shell sed -E '/$(PS_CONFIG)\/(test|edit|main|respack|gui\/editor)\//d' $(OFILES_LIST) > $(OFILES_LIST_HEADLESS))
   endif
   $(EXE_MAIN):$(OFILES_MAIN) $(DATA_ARCHIVE) $(INPUTCFG) $(MAINCFG);$(PRECMD) $(LD) -o $@ @$(OFILES_LIST_MAIN) $(LDPOST)
   $(EXE_TEST):$(OFILES_TEST);$(PRECMD) $(LD) -o $@ @$(OFILES_LIST_TEST) $(LDPOST)
   $(EXE_EDIT):$(OFILES_EDIT) $(INPUTCFG) $(MAINCFG);$(PRECMD) $(LD) -o $@ @$(OFILES_LIST_EDIT) $(LDPOST)
   $(EXE_RESPACK):$(OFILES_RESPACK);$(PRECMD) $(LD) -o $@ @$(OFILES_LIST_RESPACK) $(LDPOST)
+  $(EXE_HEADLESS):$(OFILES_HEADLESS);$(PRECMD) $(LD) -o $@ @$(OFILES_LIST_HEADLESS) $(LDPOST)
 
 # Meanwhile, in the civilized world:
 else
@@ -79,12 +85,13 @@ else
   $(EXE_TEST):$(OFILES_TEST);$(PRECMD) $(LD) -o $@ $(OFILES_TEST) $(LDPOST)
   $(EXE_EDIT):$(OFILES_EDIT) $(INPUTCFG) $(MAINCFG);$(PRECMD) $(LD) -o $@ $(OFILES_EDIT) $(LDPOST)
   $(EXE_RESPACK):$(OFILES_RESPACK);$(PRECMD) $(LD) -o $@ $(OFILES_RESPACK) $(LDPOST)
+  $(EXE_HEADLESS):$(OFILES_HEADLESS);$(PRECMD) $(LD) -o $@ $(OFILES_HEADLESS) $(LDPOST)
 endif
 
-all:$(EXE_MAIN) $(EXE_TEST) $(EXE_EDIT) $(EXE_RESPACK) $(DATA_ARCHIVE)
+all:$(EXE_MAIN) $(EXE_TEST) $(EXE_EDIT) $(EXE_RESPACK) $(EXE_HEADLESS) $(DATA_ARCHIVE)
 
 DATA_SRC_FILES:=$(shell find src/data -type f)
-$(DATA_ARCHIVE):$(DATA_SRC_FILES) $(EXE_RESPACK);$(PRECMD) $(CMD_RESPACK) $@ src/data
+$(DATA_ARCHIVE):$(DATA_SRC_FILES) $(EXE_RESPACK);$(PRECMD) $(CMD_RESPACK) --indexed $@ src/data
 
 $(INPUTCFG):etc/input.cfg;$(PRECMD) cp $< $@
 $(MAINCFG):etc/plundersquad.cfg;$(PRECMD) cp $< $@
@@ -9,6 +9,8 @@ test:$(EXE_TEST);$(CMD_TEST) $(POST_CMD_TEST)
 test-%:$(EXE_TEST);$(CMD_TEST) $* $(POST_CMD_TEST)
 edit:$(EXE_EDIT);$(CMD_EDIT) --resources=src/data $(POST_CMD_EDIT)
 edit-%:$(EXE_EDIT);$(CMD_EDIT) --resources=src/data $* $(POST_CMD_EDIT)
+headless:$(EXE_HEADLESS);$(CMD_HEADLESS) $(POST_CMD_HEADLESS)
+headless-%:$(EXE_HEADLESS);$(CMD_HEADLESS) $(subst +,=,$*) $(POST_CMD_HEADLESS)
 
 clean:;rm -rf mid out
 
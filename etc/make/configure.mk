@@ -40,10 +40,12 @@ EXE_MAIN:=$(OUTDIR)/plundersquad
 EXE_TEST:=$(OUTDIR)/test
 EXE_EDIT:=$(OUTDIR)/plundersquad-editor
 EXE_RESPACK:=$(OUTDIR)/respack
+EXE_HEADLESS:=$(OUTDIR)/plundersquad-headless
 CMD_MAIN=$(EXE_MAIN)
 CMD_TEST=$(EXE_TEST)
 CMD_EDIT=$(EXE_EDIT) --resources=src/data
 CMD_RESPACK=$(EXE_RESPACK)
+CMD_HEADLESS=$(EXE_HEADLESS) --resources=src/data
 DATA_ARCHIVE:=$(OUTDIR)/ps-data
 INPUTCFG:=$(OUTDIR)/input.cfg
 MAINCFG:=$(OUTDIR)/plundersquad.cfg
@@ -7,12 +7,14 @@
 #include <stdint.h>
 
 #include "akau_driver.h"
+#include "akau_period.h"
 #include "akau_pcm.h"
 #include "akau_wavegen.h"
 #include "akau_instrument.h"
 #include "akau_song.h"
 #include "akau_mixer.h"
 #include "akau_store.h"
+#include "akau_songcache.h"
 
 #define AKAU_LOGLEVEL_DEBUG       1
 #define AKAU_LOGLEVEL_INFO        2
@@ -59,6 +61,8 @@ int akau_update();
 /* Find a sampled sound effect in the global store and begin playing it.
  * "intent" was shoe-horned in late, and I didn't want to break the existing interface.
  * Default intent is 1 (AKAU_INTENT_SFX), or use the "_as" versions for a specific intent.
+ * These don't take the lock: The request is queued and the callback starts it before its next block.
+ * So there's no channel ID to return, only 0 for success.
  */
 int akau_play_sound(int ipcmid,uint8_t trim,int8_t pan);
 int akau_play_loop(int ipcmid,uint8_t trim,int8_t pan);
@@ -68,6 +72,7 @@ int akau_play_loop_as(int ipcmid,uint8_t trim,int8_t pan,uint8_t intent);
 /* Find a song in the global store and replace the current song with it.
  * Use (songid==0) to play silence.
  * Use (restart!=0) if this might be the current song and you want it to play from the beginning.
+ * Song changes are rare and can start or cancel songprinter threads, so unlike sound effects they do take the lock.
  */
 int akau_play_song(int songid,int restart);
 int akau_play_song_as(int songid,int restart,uint8_t intent);
@@ -80,6 +85,18 @@ int akau_play_song_as(int songid,int restart,uint8_t intent);
 int akau_lock();
 int akau_unlock();
 
+/* Sound effects and trims are queued for the callback by default.
+ * Disable to take the lock and apply each one immediately, as we used to. For testing and measurement.
+ */
+int akau_set_queue_commands(int enable);
+
+/* Period size, latency, and underrun count, from drivers that report them.
+ * <0 if we're not initialized or the driver doesn't say.
+ */
+int akau_get_driver_status(struct akau_driver_status *status);
+
+/* Trim changes are queued like sound effects; get returns the last value set.
+ */
 int akau_set_trim_for_intent(uint8_t intent,uint8_t trim);
 uint8_t akau_get_trim_for_intent(uint8_t intent);
 
@@ -92,6 +109,11 @@ struct akau_mixer *akau_get_mixer();
  */
 struct akau_store *akau_get_store();
 
+/* Return the global cache of printed songs, which the global mixer uses.
+ * It only keeps songs in memory until you give it a path.
+ */
+struct akau_songcache *akau_get_songcache();
+
 /* Register a callback to be notified when the song hits a SYNC command.
  * These callbacks will fire from the main thread, during akau_update().
  * Returns (syncwatcherid), which you can use later to remove the watcher. (always >0)
@@ -104,7 +126,8 @@ int akau_watch_sync_tokens(
 
 int akau_unwatch_sync_tokens(int syncwatcherid);
 
-/* For use by mixer.
+/* For use by mixer, from the callback.
+ * Tokens pass to the main thread through a queue, no lock.
  */
 int akau_queue_sync_token(uint16_t token);
 
@@ -13,11 +13,20 @@
  */
 typedef void (*akau_cb_fn)(int16_t *dst,int dstc);
 
+/* Optional report from drivers that know it.
+ */
+struct akau_driver_status {
+  int period; // Frames per refill.
+  int latency_us; // Worst-case delay from callback to speaker.
+  int xrunc; // Underruns since init.
+};
+
 struct akau_driver {
   int (*init)(const char *device,int rate,int chanc,akau_cb_fn cb);
   void (*quit)();
   int (*lock)();
   int (*unlock)();
+  int (*get_status)(struct akau_driver_status *status); // Optional.
 };
 
 /* These drivers are defined in their respective units.
@@ -14,6 +14,7 @@ struct akau_mixer;
 struct akau_instrument;
 struct akau_ipcm;
 struct akau_song;
+struct akau_songcache;
 
 struct akau_mixer *akau_mixer_new();
 void akau_mixer_del(struct akau_mixer *mixer);
@@ -27,6 +28,12 @@ int akau_mixer_ref(struct akau_mixer *mixer);
 int akau_mixer_set_print_songs(struct akau_mixer *mixer,int print);
 int akau_mixer_get_print_songs(const struct akau_mixer *mixer);
 
+/* With print_songs, a cache of printed songs lets us skip printing one we've printed before.
+ * The global mixer has one by default. Null to print every song fresh.
+ */
+int akau_mixer_set_songcache(struct akau_mixer *mixer,struct akau_songcache *cache);
+struct akau_songcache *akau_mixer_get_songcache(const struct akau_mixer *mixer);
+
 /* Update all running channels into the given buffer.
  * Any prior content in the buffer is obliterated.
  * (dst) contains samples arranged L,R,L,R,etc.
@@ -34,6 +41,16 @@ int akau_mixer_get_print_songs(const struct akau_mixer *mixer);
  */
 int akau_mixer_update(int16_t *dst,int dstc,struct akau_mixer *mixer);
 
+/* Advance everything by (framec) frames exactly as akau_mixer_update() would, but produce no output.
+ * That's a lot cheaper. Clip counts do not change.
+ */
+int akau_mixer_skip(struct akau_mixer *mixer,int framec);
+
+/* Block mixing is enabled by default: Each channel renders a block of frames at a time.
+ * Output is identical either way; this is only for testing and measurement.
+ */
+int akau_mixer_set_block_mixing(struct akau_mixer *mixer,int enable);
+
 /* Get the clip counts per channel, and reset them internally.
  */
 int akau_mixer_get_clip(int *l,int *r,struct akau_mixer *mixer);
@@ -115,6 +132,18 @@ int akau_mixer_stop_by_intent(struct akau_mixer *mixer,uint8_t intent,int durati
  */
 int akau_mixer_play_song(struct akau_mixer *mixer,struct akau_song *song,int restart,uint8_t intent);
 
+/* Same as akau_mixer_play_song(), with the song's cache key already computed (see akau_songcache_key()).
+ * Hashing a song is expensive, so if you're holding the audio lock, compute the key before taking it.
+ * Null (cache_key) to compute it here, only if we need it.
+ */
+int akau_mixer_play_song_with_key(
+  struct akau_mixer *mixer,
+  struct akau_song *song,
+  const uint64_t *cache_key,
+  int restart,
+  uint8_t intent
+);
+
 /* Stop whatever is playing and start this song at the given beat.
  */
 int akau_mixer_play_song_from_beat(struct akau_mixer *mixer,struct akau_song *song,int beatp,uint8_t intent);
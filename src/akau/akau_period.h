@@ -0,0 +1,46 @@
+/* akau_period.h
+ * Policy for sizing a driver's hardware period, shared by drivers that can choose it.
+ * The driver refills one period at a time, and keeps (periodc) of them in the hardware buffer.
+ * Smaller periods mean less latency between akau_play_sound() and the speaker, but more risk of underrun.
+ * Report each underrun and each clean period, and we tell you when to change the size:
+ * Double on underrun, and halve again after a long enough clean stretch.
+ * Each underrun also doubles the stretch we wait before shrinking, so a marginal size doesn't flap.
+ * This is pure arithmetic, no I/O; the driver does the actual reconfiguring.
+ */
+
+#ifndef AKAU_PERIOD_H
+#define AKAU_PERIOD_H
+
+#define AKAU_PERIOD_MIN           32 /* frames */
+#define AKAU_PERIOD_MAX         8192 /* frames */
+#define AKAU_PERIOD_DEFAULT     1024 /* frames, normal mode */
+#define AKAU_PERIOD_LOW_LATENCY  256 /* frames, default for low-latency mode */
+#define AKAU_PERIOD_COUNT          2 /* periods per hardware buffer */
+
+struct akau_period {
+  int period; // Current size in frames, always a power of two.
+  int periodc; // Periods per hardware buffer.
+  int min,max; // Limits for (period).
+  int rate; // Frames per second, for reporting latency.
+  int clean; // Consecutive periods without underrun.
+  int shrink_after; // How many clean periods before we try a smaller size.
+  int xrunc; // Underruns since init.
+};
+
+/* Normal mode starts at AKAU_PERIOD_DEFAULT and may grow but never shrinks below it.
+ * Low-latency mode starts at (request), or AKAU_PERIOD_LOW_LATENCY if it's <1, and adapts in both directions.
+ * (request) is rounded up to a power of two.
+ */
+int akau_period_init(struct akau_period *period,int rate,int low_latency,int request);
+
+/* Report an underrun or a clean period.
+ * Returns >0 if (period->period) changed and the driver should reconfigure, 0 if not.
+ */
+int akau_period_xrun(struct akau_period *period);
+int akau_period_ok(struct akau_period *period);
+
+/* Worst-case delay from the callback to the speaker, ie the whole hardware buffer.
+ */
+int akau_period_get_latency_us(const struct akau_period *period);
+
+#endif
@@ -0,0 +1,57 @@
+/* akau_songcache.h
+ * Printed songs, kept so we don't have to print them again.
+ * Entries are keyed by a hash of everything that goes into printing: Change any of it and the old entry is never found.
+ * They live in memory, and optionally as files in a directory so they survive between runs.
+ * Each tier is limited by total size, and evicts the least recently used entries first.
+ * All functions are thread-safe, except the path accessors (see below).
+ */
+
+#ifndef AKAU_SONGCACHE_H
+#define AKAU_SONGCACHE_H
+
+#include <stdint.h>
+
+struct akau_songcache;
+struct akau_song;
+struct akau_ipcm;
+
+struct akau_songcache *akau_songcache_new();
+void akau_songcache_del(struct akau_songcache *cache);
+int akau_songcache_ref(struct akau_songcache *cache);
+
+/* Total bytes of samples to keep in memory and on disk.
+ * Defaults are 64 MB and 256 MB. Zero disables that tier.
+ */
+int akau_songcache_set_limits(struct akau_songcache *cache,int memory_limit,int disk_limit);
+
+/* Directory for the persistent tier, created when we first write to it.
+ * Null or empty, the default, to keep entries in memory only.
+ * "get" returns the cache's own copy, which "set" frees: Don't change the path while another thread might be reading it.
+ */
+int akau_songcache_set_path(struct akau_songcache *cache,const char *path);
+const char *akau_songcache_get_path(const struct akau_songcache *cache);
+
+/* Hash everything that affects a song's printed output:
+ * Its serial form (tempo, instruments, and commands), the samples of each linked drum, and the master rate.
+ * Song must be linked.
+ */
+int akau_songcache_key(uint64_t *key,const struct akau_song *song);
+
+/* Return a NEW reference to the cached IPCM for (key), or null if we don't have it.
+ * "get" only consults memory, so it's cheap enough to call with the audio lock held.
+ * "load" also reads from the disk tier, leaving the entry in memory for "get". Returns >0 if present.
+ */
+struct akau_ipcm *akau_songcache_get(struct akau_songcache *cache,uint64_t key);
+int akau_songcache_load(struct akau_songcache *cache,uint64_t key);
+
+/* Add a fully printed song. We retain (ipcm); it must not change after this.
+ * If there is a disk tier, we write it there too, before returning.
+ */
+int akau_songcache_add(struct akau_songcache *cache,uint64_t key,struct akau_ipcm *ipcm);
+
+/* Total bytes of samples currently held in memory, and count of entries.
+ */
+int akau_songcache_get_memory_usage(const struct akau_songcache *cache);
+int akau_songcache_count_entries(const struct akau_songcache *cache);
+
+#endif
@@ -1,5 +1,7 @@
 /* akau_songprinter.h
  * Coordinator for generating a flat IPCM from a song.
+ * The song is divided into ranges of beats, printed in parallel by a pool of worker threads.
+ * Output is identical to playing the song straight through one mixer.
  */
 
 #ifndef AKAU_SONGPRINTER_H
@@ -8,6 +10,7 @@
 struct akau_songprinter;
 struct akau_ipcm;
 struct akau_song;
+struct akau_songcache;
 
 struct akau_songprinter *akau_songprinter_new(struct akau_song *song);
 void akau_songprinter_del(struct akau_songprinter *printer);
@@ -21,11 +24,11 @@ int akau_songprinter_get_progress(const struct akau_songprinter *printer);
 /* 1..99 mean asynchronous printing is in progress. */
 #define AKAU_SONGPRINTER_PROGRESS_READY     100 /* Printing complete. */
 
-/* Use "begin" to spin off a background thread for asynchronous printing.
+/* Use "begin" to spin off background threads for asynchronous printing.
  * That will return immediately.
  * Once started, use "cancel" to discard all work or "finish" to block until complete.
  * "finish" without "begin" is legal; that requests to print the song synchronously.
- * In that case, a background thread is never started.
+ * In that case, the calling thread is one of the workers, and all are joined before it returns.
  */
 int akau_songprinter_begin(struct akau_songprinter *printer);
 int akau_songprinter_cancel(struct akau_songprinter *printer);
@@ -39,4 +42,26 @@ struct akau_ipcm *akau_songprinter_get_ipcm(const struct akau_songprinter *print
 // Return IPCM regardless of progress. Samples may be zero, unwritten yet.
 struct akau_ipcm *akau_songprinter_get_ipcm_even_if_incomplete(const struct akau_songprinter *printer);
 
+/* Count of samples from the start of the IPCM that are printed and will not change.
+ * This only grows while printing.
+ */
+int akau_songprinter_get_ready_sample_count(const struct akau_songprinter *printer);
+
+/* Nonzero if playback of the incomplete IPCM could start now and stay behind the printed part to the end.
+ * That's an estimate based on the printing speed so far; a player should still check the ready count as it goes.
+ */
+int akau_songprinter_ready_to_stream(const struct akau_songprinter *printer);
+
+/* Consult (cache) before printing, and add our output to it after.
+ * On a hit, "begin" or "finish" completes immediately, and the IPCM is the cached one.
+ * (key) is from akau_songcache_key() on this song, in its final state.
+ * Computing it is expensive, so it's up to you, eg before taking the audio lock.
+ */
+int akau_songprinter_set_cache(struct akau_songprinter *printer,struct akau_songcache *cache,uint64_t key);
+
+/* Worker threads to use, default one per core up to 8.
+ * (threadc<1) restores the default. Can't change while printing.
+ */
+int akau_songprinter_set_thread_count(struct akau_songprinter *printer,int threadc);
+
 #endif
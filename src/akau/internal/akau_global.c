@@ -6,10 +6,32 @@
 
 struct akau akau={0};
 
+/* Execute queued commands.
+ * Only the callback calls this, or a main-thread caller holding the driver lock, so there is only ever one consumer.
+ */
+
+static void akau_execute_command(const struct akau_cmd *cmd) {
+  switch (cmd->op) {
+    case AKAU_CMD_PLAY_IPCM: {
+        if (akau_mixer_play_ipcm(akau.mixer,cmd->obj,cmd->trim,cmd->pan,cmd->loop,cmd->intent)<0) akau.error=1;
+        akau_ipcm_del(cmd->obj);
+      } break;
+    case AKAU_CMD_SET_TRIM: {
+        akau_mixer_set_trim_for_intent(akau.mixer,cmd->intent,cmd->trim);
+      } break;
+  }
+}
+
+static void akau_drain_commands() {
+  struct akau_cmd cmd;
+  while (akau_ring_pop(&cmd,&akau.cmdq)>0) akau_execute_command(&cmd);
+}
+
 /* Main callback.
  */
  
 static void akau_cb(int16_t *dst,int dstc) {
+  akau_drain_commands();
   if (akau_mixer_update(dst,dstc,akau.mixer)<0) {
     akau.error=1;
     memset(dst,0,dstc<<1);
@@ -54,6 +76,26 @@ int akau_init(
     return -1;
   }
 
+  if (
+    !(akau.songcache=akau_songcache_new())||
+    (akau_mixer_set_songcache(akau.mixer,akau.songcache)<0)
+  ) {
+    akau_quit();
+    return -1;
+  }
+
+  if (
+    (akau_ring_init(&akau.cmdq,sizeof(struct akau_cmd),AKAU_CMD_QUEUE_SIZE)<0)||
+    (akau_ring_init(&akau.tokenq,sizeof(uint16_t),AKAU_TOKEN_QUEUE_SIZE)<0)
+  ) {
+    akau_quit();
+    return -1;
+  }
+  akau.queue_commands=1;
+  int intent=0; for (;intent<256;intent++) {
+    akau.trim_by_intent[intent]=akau_mixer_get_trim_for_intent(akau.mixer,intent);
+  }
+
   if ((rate>=200)&&(rate<=200000)) akau.rate=rate;
   else akau.rate=44100;
   //const int chanc=2; // Can change this to 1, just comment out one channel in akau_mixer.c:akau_mixer_update().
@@ -78,8 +120,19 @@ void akau_quit() {
 
   if (akau.driver.quit) akau.driver.quit();
 
+  /* The callback is gone; discard anything it didn't get to. */
+  if (akau.cmdq.v) {
+    struct akau_cmd cmd;
+    while (akau_ring_pop(&cmd,&akau.cmdq)>0) {
+      if (cmd.op==AKAU_CMD_PLAY_IPCM) akau_ipcm_del(cmd.obj);
+    }
+  }
+  akau_ring_cleanup(&akau.cmdq);
+  akau_ring_cleanup(&akau.tokenq);
+
   akau_mixer_del(akau.mixer);
   akau_store_del(akau.store);
+  akau_songcache_del(akau.songcache);
 
   if (akau.syncwatcherv) {
     while (akau.syncwatcherc>0) {
@@ -89,8 +142,6 @@ void akau_quit() {
     free(akau.syncwatcherv);
   }
 
-  if (akau.tokenv) free(akau.tokenv);
-
   memset(&akau,0,sizeof(struct akau));
 }
 
@@ -126,17 +177,10 @@ int akau_update() {
   }
 
   /* Fire synchronization tokens. */
-  if (akau.tokenc) {
-    if (akau.driver.lock()<0) return -1;
-    int i; for (i=0;i<akau.tokenc;i++) {
-      int err=akau_fire_sync_token(akau.tokenv[i]);
-      if (err<0) {
-        akau.driver.unlock();
-        return err;
-      }
-    }
-    akau.tokenc=0;
-    if (akau.driver.unlock()<0) return -1;
+  uint16_t token;
+  while (akau_ring_pop(&token,&akau.tokenq)>0) {
+    int err=akau_fire_sync_token(token);
+    if (err<0) return err;
   }
   
   /* Fire clip callback if needed. */
@@ -155,38 +199,76 @@ int akau_update() {
   return 0;
 }
 
-/* Play sound or song.
+/* Send a command to the callback.
+ * If the queue is full, the callback must be stalled: Take the lock and do its draining for it.
+ * Queueing disabled, we do the same thing every time, which is how it used to work.
  */
- 
-int akau_play_sound_as(int ipcmid,uint8_t trim,int8_t pan,uint8_t intent) {
+
+static int akau_send_command(const struct akau_cmd *cmd) {
+  if (akau.queue_commands&&(akau_ring_push(&akau.cmdq,cmd)>=0)) return 0;
+  if (akau_lock()<0) return -1;
+  akau_drain_commands();
+  akau_execute_command(cmd);
+  akau_unlock();
+  return 0;
+}
+
+int akau_set_queue_commands(int enable) {
   if (!akau.init) return -1;
-  struct akau_ipcm *ipcm=akau_store_get_ipcm(akau.store,ipcmid);
-  if (!ipcm) return -1;
   if (akau_lock()<0) return -1;
-  int err=akau_mixer_play_ipcm(akau.mixer,ipcm,trim,pan,0,intent);
+  akau_drain_commands();
+  akau.queue_commands=enable?1:0;
   akau_unlock();
-  return err;
+  return 0;
 }
- 
-int akau_play_loop_as(int ipcmid,uint8_t trim,int8_t pan,uint8_t intent) {
+
+/* Play sound or song.
+ */
+
+static int akau_play_ipcm_as(int ipcmid,uint8_t trim,int8_t pan,int loop,uint8_t intent) {
   if (!akau.init) return -1;
   struct akau_ipcm *ipcm=akau_store_get_ipcm(akau.store,ipcmid);
   if (!ipcm) return -1;
-  if (akau_lock()<0) return -1;
-  int err=akau_mixer_play_ipcm(akau.mixer,ipcm,trim,pan,1,intent);
-  akau_unlock();
-  return err;
+  if (akau_ipcm_ref(ipcm)<0) return -1;
+  struct akau_cmd cmd={
+    .op=AKAU_CMD_PLAY_IPCM,
+    .obj=ipcm,
+    .trim=trim,
+    .pan=pan,
+    .intent=intent,
+    .loop=loop,
+  };
+  return akau_send_command(&cmd);
+}
+ 
+int akau_play_sound_as(int ipcmid,uint8_t trim,int8_t pan,uint8_t intent) {
+  return akau_play_ipcm_as(ipcmid,trim,pan,0,intent);
+}
+ 
+int akau_play_loop_as(int ipcmid,uint8_t trim,int8_t pan,uint8_t intent) {
+  return akau_play_ipcm_as(ipcmid,trim,pan,1,intent);
 }
 
 int akau_play_song_as(int songid,int restart,uint8_t intent) {
   if (!akau.init) return -1;
   struct akau_song *song=0;
+  uint64_t key;
+  const uint64_t *cache_key=0;
   if (songid) {
     song=akau_store_get_song(akau.store,songid);
     if (!song) return -1;
+    /* Hash the song and read a cached print from disk now.
+     * While we hold the lock, the mixer only has to look in memory.
+     */
+    if (akau_mixer_get_print_songs(akau.mixer)) {
+      if (akau_songcache_key(&key,song)>=0) {
+        cache_key=&key;
+        akau_songcache_load(akau.songcache,key);
+      }
+    }
   }
   if (akau_lock()<0) return -1;
-  int err=akau_mixer_play_song(akau.mixer,song,restart,intent);
+  int err=akau_mixer_play_song_with_key(akau.mixer,song,cache_key,restart,intent);
   akau_unlock();
   return err;
 }
@@ -207,11 +289,18 @@ int akau_play_song(int songid,int restart) {
 }
  
 int akau_set_trim_for_intent(uint8_t intent,uint8_t trim) {
-  return akau_mixer_set_trim_for_intent(akau.mixer,intent,trim);
+  if (!akau.init) return -1;
+  akau.trim_by_intent[intent]=trim;
+  struct akau_cmd cmd={
+    .op=AKAU_CMD_SET_TRIM,
+    .trim=trim,
+    .intent=intent,
+  };
+  return akau_send_command(&cmd);
 }
 
 uint8_t akau_get_trim_for_intent(uint8_t intent) {
-  return akau_mixer_get_trim_for_intent(akau.mixer,intent);
+  return akau.trim_by_intent[intent];
 }
 
 /* Lock.
@@ -229,6 +318,17 @@ int akau_unlock() {
   return akau.driver.unlock();
 }
 
+/* Driver status.
+ */
+
+int akau_get_driver_status(struct akau_driver_status *status) {
+  if (!status) return -1;
+  if (!akau.init) return -1;
+  if (!akau.driver.get_status) return -1;
+  memset(status,0,sizeof(struct akau_driver_status));
+  return akau.driver.get_status(status);
+}
+
 /* Trivial accessors.
  */
  
@@ -240,6 +340,10 @@ struct akau_store *akau_get_store() {
   return akau.store;
 }
 
+struct akau_songcache *akau_get_songcache() {
+  return akau.songcache;
+}
+
 int akau_load_resources(const char *path) {
   if (!akau.init) return -1;
   return akau_store_load(akau.store,path);
@@ -381,23 +485,12 @@ int akau_unwatch_sync_tokens(int syncwatcherid) {
 }
 
 /* Queue sync token.
+ * If the main thread falls a full queue behind, we drop tokens.
  */
  
 int akau_queue_sync_token(uint16_t token) {
   if (!akau.init) return -1;
-  
-  if (akau.tokenc>=akau.tokena) {
-    int na=akau.tokena+32;
-    if (na>INT_MAX/sizeof(uint16_t)) return -1;
-    void *nv=realloc(akau.tokenv,sizeof(uint16_t)*na);
-    if (!nv) return -1;
-    akau.tokenv=nv;
-    akau.tokena=na;
-  }
-
-  akau.tokenv[akau.tokenc++]=token;
-
-  return 0;
+  return akau_ring_push(&akau.tokenq,&token);
 }
 
 /* Set observer.
@@ -3,6 +3,26 @@
 
 #include <string.h>
 #include "../akau.h"
+#include "akau_ring.h"
+
+/* Commands from the main thread, executed by the audio callback before each block.
+ * The command holds a reference to (obj).
+ */
+
+#define AKAU_CMD_PLAY_IPCM   1
+#define AKAU_CMD_SET_TRIM    2
+
+#define AKAU_CMD_QUEUE_SIZE    256
+#define AKAU_TOKEN_QUEUE_SIZE  256
+
+struct akau_cmd {
+  int op;
+  void *obj;
+  uint8_t trim;
+  int8_t pan;
+  uint8_t intent;
+  uint8_t loop;
+};
 
 struct akau_syncwatcher {
   int id;
@@ -20,12 +40,15 @@ extern struct akau {
   
   struct akau_mixer *mixer;
   struct akau_store *store;
+  struct akau_songcache *songcache;
 
   struct akau_syncwatcher *syncwatcherv;
   int syncwatcherc,syncwatchera;
 
-  uint16_t *tokenv;
-  int tokenc,tokena;
+  struct akau_ring cmdq; // main thread to callback
+  struct akau_ring tokenq; // callback to main thread, uint16_t
+  int queue_commands;
+  uint8_t trim_by_intent[256]; // As last requested; the mixer catches up at the next block.
 
   int (*cb_clip)(int l,int r);
   int cliplc,cliprc;
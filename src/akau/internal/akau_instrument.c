@@ -96,7 +96,7 @@ struct akau_instrument *akau_instrument_new_default(
 
 void akau_instrument_del(struct akau_instrument *instrument) {
   if (!instrument) return;
-  if (instrument->refc-->1) return;
+  if (__atomic_sub_fetch(&instrument->refc,1,__ATOMIC_ACQ_REL)>0) return;
 
   akau_fpcm_unlock(instrument->fpcm);
   akau_fpcm_del(instrument->fpcm);
@@ -107,13 +107,14 @@ void akau_instrument_del(struct akau_instrument *instrument) {
 }
 
 /* Retain.
+ * Atomic, since songprinter's workers share instruments.
  */
  
 int akau_instrument_ref(struct akau_instrument *instrument) {
   if (!instrument) return -1;
   if (instrument->refc<1) return -1;
   if (instrument->refc==INT_MAX) return -1;
-  instrument->refc++;
+  __atomic_add_fetch(&instrument->refc,1,__ATOMIC_RELAXED);
   return 0;
 }
 
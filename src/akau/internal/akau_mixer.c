@@ -1,6 +1,7 @@
 #include "akau_mixer_internal.h"
 #include "../akau.h"
 #include "../akau_songprinter.h"
+#include "../akau_songcache.h"
 #include "os/ps_log.h"
 #include "os/ps_clockassist.h"
 
@@ -63,6 +64,7 @@ struct akau_mixer *akau_mixer_new() {
   mixer->chanid_next=1;
   memset(mixer->trim_by_intent,0xff,sizeof(mixer->trim_by_intent));
   mixer->print_songs=1;
+  mixer->block_mixing=1;
 
   return mixer;
 }
@@ -82,6 +84,7 @@ void akau_mixer_del(struct akau_mixer *mixer) {
   }
 
   akau_songprinter_del(mixer->printer);
+  akau_songcache_del(mixer->songcache);
 
   free(mixer);
 }
@@ -121,6 +124,20 @@ int akau_mixer_get_print_songs(const struct akau_mixer *mixer) {
   return mixer->print_songs;
 }
 
+int akau_mixer_set_songcache(struct akau_mixer *mixer,struct akau_songcache *cache) {
+  if (!mixer) return -1;
+  if (cache==mixer->songcache) return 0;
+  if (cache&&(akau_songcache_ref(cache)<0)) return -1;
+  akau_songcache_del(mixer->songcache);
+  mixer->songcache=cache;
+  return 0;
+}
+
+struct akau_songcache *akau_mixer_get_songcache(const struct akau_mixer *mixer) {
+  if (!mixer) return 0;
+  return mixer->songcache;
+}
+
 /* Update trim and pan sliders.
  */
 
@@ -264,40 +281,104 @@ static int akau_mixer_check_printer_progress(struct akau_mixer *mixer) {
     if (akau_songprinter_finish(mixer->printer)<0) return -1;
 
   /* We don't actually need the songprinter to finish before we start using its output.
-   * If it takes longer than one second, wait for it to reach 15% completion, then start playing.
-   * Those thresholds are more or less arbitrary.
-   * Experimentally, songprinter runs much faster than real-time, even on the slowest hardware.
-   * If these assumptions fail, the worst that could happen is that the music cuts out ungracefully.
+   * It prints front to back, and tells us once it's far enough ahead that playback won't catch up.
+   * If that estimate is wrong, akau_mixer_hold_printed_song() pauses the song rather than play unprinted samples.
    */
-  } else if (progress>=15) {
+  } else if (akau_songprinter_ready_to_stream(mixer->printer)) {
     int64_t now=ps_time_now();
     int64_t elapsed=now-mixer->print_start_time;
-    if (elapsed>=1000000) {
-      ps_log(AUDIO,DEBUG,"Starting song playbback at %d%% printed, elapsed %d.%06d.",progress,(int)(elapsed/1000000),(int)(elapsed%1000000));
-      struct akau_ipcm *ipcm=akau_songprinter_get_ipcm_even_if_incomplete(mixer->printer);
-      if (!ipcm) return -1;
-      if (akau_mixer_play_ipcm(mixer,ipcm,0xff,0,1,AKAU_INTENT_BGM)<0) return -1;
-      mixer->printed_song_running=1;
-    }
+    ps_log(AUDIO,DEBUG,"Starting song playback at %d%% printed, elapsed %d.%06d.",progress,(int)(elapsed/1000000),(int)(elapsed%1000000));
+    struct akau_ipcm *ipcm=akau_songprinter_get_ipcm_even_if_incomplete(mixer->printer);
+    if (!ipcm) return -1;
+    if (akau_mixer_play_ipcm(mixer,ipcm,0xff,0,1,AKAU_INTENT_BGM)<0) return -1;
+    mixer->printed_song_running=1;
   }
   
   return 0;
 }
 
-/* Update.
+/* While the song is still printing, never let its channel play past the printed part.
+ * If it would this time, it holds still for the whole update.
  */
 
-int akau_mixer_update(int16_t *dst,int dstc,struct akau_mixer *mixer) {
-  if (!dst||(dstc<2)||!mixer) return -1;
-  if (mixer->stereo) dstc&=~1;
+static void akau_mixer_hold_printed_song(struct akau_mixer *mixer,int framec) {
+  const struct akau_ipcm *ipcm=akau_songprinter_get_ipcm_even_if_incomplete(mixer->printer);
+  int readyc=INT_MAX;
+  if (akau_songprinter_get_progress(mixer->printer)!=AKAU_SONGPRINTER_PROGRESS_READY) {
+    readyc=akau_songprinter_get_ready_sample_count(mixer->printer);
+  }
+  struct akau_mixer_chan *chan=mixer->chanv;
+  int i=mixer->chanc; for (;i-->0;chan++) {
+    if (chan->mode!=AKAU_MIXER_CHAN_MODE_VERBATIM) continue;
+    if (chan->verbatim.ipcm!=ipcm) continue;
+    if (chan->verbatim.p>readyc-framec) {
+      if (!chan->verbatim.hold) ps_log(AUDIO,WARN,"Song playback caught up to songprinter at %d. Holding.",chan->verbatim.p);
+      chan->verbatim.hold=1;
+    } else {
+      chan->verbatim.hold=0;
+    }
+  }
+}
 
-  /* If we are printing a song, check its progress.
-   * Only do this at the start of the update cycle, no need to poll it every frame.
-   */
-  if (mixer->printer&&!mixer->printed_song_running) {
-    if (akau_mixer_check_printer_progress(mixer)<0) return -1;
+/* Update one channel for one frame and add its output to (l,r).
+ * This is the reference behavior; block mixing must produce exactly the same thing.
+ */
+
+static int akau_mixer_chan_step(struct akau_mixer *mixer,struct akau_mixer_chan *chan,int *l,int *r) {
+  int sample=0;
+
+  if (akau_mixer_chan_update_shared_sliders(chan)<0) return -1;
+
+  switch (chan->mode) {
+    case AKAU_MIXER_CHAN_MODE_TUNED: sample=akau_mixer_chan_tuned_update(chan); break;
+    case AKAU_MIXER_CHAN_MODE_VERBATIM: if (!chan->verbatim.hold) sample=akau_mixer_chan_verbatim_update(chan); break;
   }
-  
+  if (!sample) return 0;
+
+  uint8_t itrim=mixer->trim_by_intent[chan->intent];
+  if (!itrim) return 0;
+  if (itrim!=0xff) {
+    sample=(sample*itrim)>>8;
+    if (!sample) return 0;
+  }
+
+  sample=(sample*chan->trim)>>8;
+  if (!sample) return 0;
+
+  if (!mixer->stereo) {
+    (*l)+=sample;
+  } else if (!chan->pan) {
+    (*l)+=sample;
+    (*r)+=sample;
+  } else if (chan->pan==-128) {
+    (*l)+=sample;
+  } else if (chan->pan==127) {
+    (*r)+=sample;
+  } else if (chan->pan<0) {
+    (*l)+=sample;
+    (*r)+=(sample*(-128-chan->pan))>>7;
+  } else {
+    (*l)+=(sample*(127-chan->pan))>>7;
+    (*r)+=sample;
+  }
+
+  return 0;
+}
+
+/* Clip one output sample.
+ */
+
+static inline int16_t akau_mixer_clip(int v,int *clipc) {
+  if (v<-32768) { (*clipc)++; return -32768; }
+  if (v>32767) { (*clipc)++; return 32767; }
+  return v;
+}
+
+/* Update one frame at a time.
+ * This is how we always used to do it. It's still here for reference.
+ */
+
+static int akau_mixer_update_per_frame(int16_t *dst,int dstc,struct akau_mixer *mixer) {
   while (dstc>0) {
     int l=0,r=0;
 
@@ -313,71 +394,323 @@ int akau_mixer_update(int16_t *dst,int dstc,struct akau_mixer *mixer) {
     /* Update channels. */
     struct akau_mixer_chan *chan=mixer->chanv;
     int i=mixer->chanc; for (;i-->0;chan++) {
-      int sample=0;
+      if (akau_mixer_chan_step(mixer,chan,&l,&r)<0) return -1;
+    }
 
-      if (akau_mixer_chan_update_shared_sliders(chan)<0) return -1;
+    /* Clip and output. */
+    *dst++=akau_mixer_clip(l,&mixer->cliplc);
+    dstc--;
+    if (mixer->stereo) {
+      *dst++=akau_mixer_clip(r,&mixer->cliprc);
+      dstc--;
+    }
+    
+  }
+  return 0;
+}
 
+/* Channel gains for block mixing.
+ * Every step of the per-frame math is a multiply and a right shift, and we preserve each step's rounding.
+ * Full scale is (1<<shift), which passes samples through unchanged: (s*256)>>8==s exactly.
+ */
+
+struct akau_mixer_gain {
+  int itrim; // >>8
+  int trim; // >>8
+  int l,r; // >>7
+};
+
+static void akau_mixer_chan_get_gain(struct akau_mixer_gain *gain,const struct akau_mixer *mixer,const struct akau_mixer_chan *chan) {
+  gain->itrim=mixer->trim_by_intent[chan->intent];
+  if (gain->itrim==0xff) gain->itrim=0x100;
+  gain->trim=chan->trim;
+  if (!mixer->stereo) { gain->l=0x80; gain->r=0; }
+  else if (!chan->pan) { gain->l=0x80; gain->r=0x80; }
+  else if (chan->pan==-128) { gain->l=0x80; gain->r=0; }
+  else if (chan->pan==127) { gain->l=0; gain->r=0x80; }
+  else if (chan->pan<0) { gain->l=0x80; gain->r=-128-chan->pan; }
+  else { gain->l=127-chan->pan; gain->r=0x80; }
+}
+
+static inline void akau_mixer_accumulate(int32_t *l,int32_t *r,int sample,const struct akau_mixer_gain *gain) {
+  sample=(sample*gain->itrim)>>8;
+  sample=(sample*gain->trim)>>8;
+  (*l)+=(sample*gain->l)>>7;
+  (*r)+=(sample*gain->r)>>7;
+}
+
+/* Render a run of verbatim frames where nothing changes but the PCM position.
+ * Null (l,r) to only advance, as if rendered.
+ * Returns the count of frames rendered, possibly zero.
+ */
+
+static int akau_mixer_chan_verbatim_run(int32_t *l,int32_t *r,int c,struct akau_mixer_chan *chan,const struct akau_mixer_gain *gain) {
+  if (chan->verbatim.hold) return 0;
+  const struct akau_ipcm *ipcm=chan->verbatim.ipcm;
+  int limit=ipcm->c;
+  if (chan->verbatim.loop&&(ipcm->loopap>=0)&&(ipcm->loopzp<limit)) limit=ipcm->loopzp;
+  // The frame that reaches (limit) loops or ends the channel. Leave that one for akau_mixer_chan_step().
+  int n=limit-chan->verbatim.p-1;
+  if (n>c) n=c;
+  if (n<=0) return 0;
+  if (l) {
+    const int16_t *src=ipcm->v+chan->verbatim.p;
+    int i=0; for (;i<n;i++) akau_mixer_accumulate(l+i,r+i,src[i],gain);
+  }
+  chan->verbatim.p+=n;
+  return n;
+}
+
+/* Render a run of tuned frames where nothing changes but the PCM position and envelope.
+ * We stop at the next envelope phase boundary, so the phase is constant.
+ * Null (l,r) to only advance, as if rendered. The position must still step frame by frame, to round the same way.
+ * Returns the count of frames rendered, possibly zero.
+ */
+
+static int akau_mixer_chan_tuned_run(int32_t *l,int32_t *r,int c,struct akau_mixer_chan *chan,const struct akau_mixer_gain *gain) {
+  const struct akau_ipcm *ipcm=chan->tuned.instrument->ipcm;
+  int lcp=chan->tuned.lcp+1; // Lifecycle position of our first frame.
+  int phasea,phasez,ampa,ampz;
+  if (lcp>=chan->tuned.lcp_end) return 0;
+  if (lcp>=chan->tuned.lcp_decay) {
+    phasea=chan->tuned.lcp_decay; phasez=chan->tuned.lcp_end;
+    ampa=chan->tuned.amp_drawback; ampz=0;
+  } else if (lcp>=chan->tuned.lcp_drawback) {
+    phasea=chan->tuned.lcp_drawback; phasez=chan->tuned.lcp_decay;
+    ampa=ampz=chan->tuned.amp_drawback;
+  } else if (lcp>=chan->tuned.lcp_attack) {
+    phasea=chan->tuned.lcp_attack; phasez=chan->tuned.lcp_drawback;
+    ampa=chan->tuned.amp_attack; ampz=chan->tuned.amp_drawback;
+  } else {
+    phasea=0; phasez=chan->tuned.lcp_attack;
+    ampa=0; ampz=chan->tuned.amp_attack;
+  }
+  // Stop at whichever boundary comes first, in case the envelope's points are out of order.
+  int n=c;
+  if ((chan->tuned.lcp_attack>lcp)&&(chan->tuned.lcp_attack-lcp<n)) n=chan->tuned.lcp_attack-lcp;
+  if ((chan->tuned.lcp_drawback>lcp)&&(chan->tuned.lcp_drawback-lcp<n)) n=chan->tuned.lcp_drawback-lcp;
+  if ((chan->tuned.lcp_decay>lcp)&&(chan->tuned.lcp_decay-lcp<n)) n=chan->tuned.lcp_decay-lcp;
+  if (chan->tuned.lcp_end-lcp<n) n=chan->tuned.lcp_end-lcp;
+  if (n<=0) return 0;
+
+  double p=chan->tuned.p,dp=chan->tuned.dp;
+  if (!l) {
+    int i=0; for (;i<n;i++) {
+      p+=dp;
+      while ((int)p>=ipcm->c) p-=ipcm->c;
+    }
+    chan->tuned.p=p;
+    chan->tuned.lcp+=n;
+    return n;
+  }
+  int i=0; for (;i<n;i++,lcp++) {
+    p+=dp;
+    int ip=(int)p;
+    while (ip>=ipcm->c) {
+      p-=ipcm->c;
+      ip=(int)p;
+    }
+    uint8_t amp;
+    if (ampa==ampz) amp=ampa;
+    else amp=akau_mixer_tuned_calculate_amplitude(lcp-phasea,phasez-phasea,ampa,ampz);
+    akau_mixer_accumulate(l+i,r+i,(ipcm->v[ip]*amp)>>8,gain);
+  }
+  chan->tuned.p=p;
+  chan->tuned.lcp=lcp-1;
+  return n;
+}
+
+/* Render (c) frames of one channel into (l,r), or null to only advance.
+ * Runs where the sliders are at rest go fast; anything else goes through akau_mixer_chan_step() one frame at a time.
+ */
+
+static int akau_mixer_chan_render(struct akau_mixer *mixer,struct akau_mixer_chan *chan,int32_t *l,int32_t *r,int c) {
+  struct akau_mixer_gain gain;
+  while ((c>0)&&chan->mode) {
+    int n=0;
+    if (!chan->trimc&&!chan->panc) {
+      akau_mixer_chan_get_gain(&gain,mixer,chan);
       switch (chan->mode) {
-        case AKAU_MIXER_CHAN_MODE_TUNED: sample=akau_mixer_chan_tuned_update(chan); break;
-        case AKAU_MIXER_CHAN_MODE_VERBATIM: sample=akau_mixer_chan_verbatim_update(chan); break;
+        case AKAU_MIXER_CHAN_MODE_TUNED: {
+            if (!chan->tuned.dpc) n=akau_mixer_chan_tuned_run(l,r,c,chan,&gain);
+          } break;
+        case AKAU_MIXER_CHAN_MODE_VERBATIM: {
+            n=akau_mixer_chan_verbatim_run(l,r,c,chan,&gain);
+          } break;
+      }
+    }
+    if (!n) {
+      int sl=0,sr=0;
+      if (akau_mixer_chan_step(mixer,chan,&sl,&sr)<0) return -1;
+      if (l) {
+        (*l)+=sl;
+        (*r)+=sr;
       }
-      if (!sample) continue;
+      n=1;
+    }
+    if (l) {
+      l+=n;
+      r+=n;
+    }
+    c-=n;
+  }
+  return 0;
+}
+
+/* Clip accumulators and write output.
+ * Vectorized where we know how; the scalar version is the reference.
+ */
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+
+static inline int akau_mixer_count_clips_sse2(__m128i v,__m128i hi,__m128i lo) {
+  __m128i clip=_mm_or_si128(_mm_cmpgt_epi32(v,hi),_mm_cmplt_epi32(v,lo));
+  return __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(clip)));
+}
+
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
 
-      uint8_t itrim=mixer->trim_by_intent[chan->intent];
-      if (!itrim) continue;
-      if (itrim!=0xff) {
-        sample=(sample*itrim)>>8;
-        if (!sample) continue;
+static inline int akau_mixer_count_clips_neon(int32x4_t v,int32x4_t hi,int32x4_t lo) {
+  uint32x4_t clip=vshrq_n_u32(vorrq_u32(vcgtq_s32(v,hi),vcltq_s32(v,lo)),31);
+  uint32x2_t sum=vadd_u32(vget_low_u32(clip),vget_high_u32(clip));
+  return vget_lane_u32(sum,0)+vget_lane_u32(sum,1);
+}
+
+#endif
+
+static void akau_mixer_output_block(int16_t *dst,struct akau_mixer *mixer,int c) {
+  const int32_t *l=mixer->accl,*r=mixer->accr;
+  int i=0;
+
+  if (mixer->stereo) {
+    #if defined(__SSE2__)
+      const __m128i hi=_mm_set1_epi32(32767),lo=_mm_set1_epi32(-32768);
+      for (;i<=c-4;i+=4,dst+=8) {
+        __m128i vl=_mm_loadu_si128((const __m128i*)(l+i));
+        __m128i vr=_mm_loadu_si128((const __m128i*)(r+i));
+        mixer->cliplc+=akau_mixer_count_clips_sse2(vl,hi,lo);
+        mixer->cliprc+=akau_mixer_count_clips_sse2(vr,hi,lo);
+        __m128i a=_mm_unpacklo_epi32(vl,vr);
+        __m128i b=_mm_unpackhi_epi32(vl,vr);
+        _mm_storeu_si128((__m128i*)dst,_mm_packs_epi32(a,b));
+      }
+    #elif defined(__ARM_NEON)
+      const int32x4_t hi=vdupq_n_s32(32767),lo=vdupq_n_s32(-32768);
+      for (;i<=c-4;i+=4,dst+=8) {
+        int32x4_t vl=vld1q_s32(l+i);
+        int32x4_t vr=vld1q_s32(r+i);
+        mixer->cliplc+=akau_mixer_count_clips_neon(vl,hi,lo);
+        mixer->cliprc+=akau_mixer_count_clips_neon(vr,hi,lo);
+        int16x4x2_t lr={{vqmovn_s32(vl),vqmovn_s32(vr)}};
+        vst2_s16(dst,lr);
       }
+    #endif
+    for (;i<c;i++) {
+      *dst++=akau_mixer_clip(l[i],&mixer->cliplc);
+      *dst++=akau_mixer_clip(r[i],&mixer->cliprc);
+    }
+
+  } else {
+    #if defined(__SSE2__)
+      const __m128i hi=_mm_set1_epi32(32767),lo=_mm_set1_epi32(-32768);
+      for (;i<=c-8;i+=8,dst+=8) {
+        __m128i a=_mm_loadu_si128((const __m128i*)(l+i));
+        __m128i b=_mm_loadu_si128((const __m128i*)(l+i+4));
+        mixer->cliplc+=akau_mixer_count_clips_sse2(a,hi,lo)+akau_mixer_count_clips_sse2(b,hi,lo);
+        _mm_storeu_si128((__m128i*)dst,_mm_packs_epi32(a,b));
+      }
+    #elif defined(__ARM_NEON)
+      const int32x4_t hi=vdupq_n_s32(32767),lo=vdupq_n_s32(-32768);
+      for (;i<=c-4;i+=4,dst+=4) {
+        int32x4_t v=vld1q_s32(l+i);
+        mixer->cliplc+=akau_mixer_count_clips_neon(v,hi,lo);
+        vst1_s16(dst,vqmovn_s32(v));
+      }
+    #endif
+    for (;i<c;i++) {
+      *dst++=akau_mixer_clip(l[i],&mixer->cliplc);
+    }
+  }
+}
+
+/* Update in blocks.
+ * Render each channel across the whole block into int32 accumulators, then clip them all at once.
+ * An unprinted song can start and adjust channels on any frame, so we cut blocks short wherever it does.
+ * With null (dst), we only advance (framec) frames.
+ */
 
-      sample=(sample*chan->trim)>>8;
-      if (!sample) continue;
-
-      if (!mixer->stereo) {
-        l+=sample;
-      } else if (!chan->pan) {
-        l+=sample;
-        r+=sample;
-      } else if (chan->pan==-128) {
-        l+=sample;
-      } else if (chan->pan==127) {
-        r+=sample;
-      } else if (chan->pan<0) {
-        l+=sample;
-        r+=(sample*(-128-chan->pan))>>7;
+static int akau_mixer_update_blocks(int16_t *dst,int framec,struct akau_mixer *mixer) {
+  while (framec>0) {
+    int c=framec;
+    if (c>AKAU_MIXER_BLOCK_SIZE) c=AKAU_MIXER_BLOCK_SIZE;
+
+    /* Song updates happen at the start of a frame, then it waits (song_delay) frames before the next. */
+    if (mixer->song) {
+      if (mixer->song_delay>0) {
+        if (c>mixer->song_delay) c=mixer->song_delay;
+        mixer->song_delay-=c;
       } else {
-        l+=(sample*(127-chan->pan))>>7;
-        r+=sample;
+        if (akau_song_update(mixer->song,mixer,mixer->song_cmdp,mixer->song_intent)<0) return -1;
+        if (c>mixer->song_delay+1) c=mixer->song_delay+1;
+        mixer->song_delay-=c-1;
       }
+    }
 
+    int32_t *accl=0,*accr=0;
+    if (dst) {
+      accl=mixer->accl;
+      accr=mixer->accr;
+      memset(accl,0,sizeof(int32_t)*c);
+      memset(accr,0,sizeof(int32_t)*c);
+    }
+    struct akau_mixer_chan *chan=mixer->chanv;
+    int i=mixer->chanc; for (;i-->0;chan++) {
+      if (akau_mixer_chan_render(mixer,chan,accl,accr,c)<0) return -1;
     }
 
-    /* Clip and output. */
-    if (l<-32768) {
-      *dst=-32768;
-      mixer->cliplc++;
-    } else if (l>32767) {
-      *dst=32767; 
-      mixer->cliplc++;
-    } else *dst=l;
-    dst++;
-    dstc--;
-    if (mixer->stereo) {
-      if (r<-32768) {
-        *dst=-32768;
-        mixer->cliprc++;
-      } else if (r>32767) {
-        *dst=32767; 
-        mixer->cliprc++;
-      } else *dst=r;
-      dst++;
-      dstc--;
+    if (dst) {
+      akau_mixer_output_block(dst,mixer,c);
+      dst+=mixer->stereo?(c<<1):c;
     }
-    
+    framec-=c;
   }
   return 0;
 }
 
+/* Update.
+ */
+
+int akau_mixer_update(int16_t *dst,int dstc,struct akau_mixer *mixer) {
+  if (!dst||(dstc<2)||!mixer) return -1;
+  if (mixer->stereo) dstc&=~1;
+
+  /* If we are printing a song, check its progress.
+   * Only do this at the start of the update cycle, no need to poll it every frame.
+   */
+  if (mixer->printer&&!mixer->printed_song_running) {
+    if (akau_mixer_check_printer_progress(mixer)<0) return -1;
+  }
+  if (mixer->printer&&mixer->printed_song_running) {
+    akau_mixer_hold_printed_song(mixer,mixer->stereo?(dstc>>1):dstc);
+  }
+
+  if (mixer->block_mixing) return akau_mixer_update_blocks(dst,mixer->stereo?(dstc>>1):dstc,mixer);
+  return akau_mixer_update_per_frame(dst,dstc,mixer);
+}
+
+int akau_mixer_skip(struct akau_mixer *mixer,int framec) {
+  if (!mixer||(framec<0)) return -1;
+  return akau_mixer_update_blocks(0,framec,mixer);
+}
+
+int akau_mixer_set_block_mixing(struct akau_mixer *mixer,int enable) {
+  if (!mixer) return -1;
+  mixer->block_mixing=enable?1:0;
+  return 0;
+}
+
 /* Allocate channel.
  */
 
@@ -745,7 +1078,13 @@ static int akau_mixer_restart_songprinter(struct akau_mixer *mixer) {
  * TODO: If we toggle fast between two songs, we might switch to one that's still fading out. Can we keep that IPCM instead of reprinting?
  */
 
-static int akau_mixer_register_song_for_printing(struct akau_mixer *mixer,struct akau_song *song,int restart,uint8_t intent) {
+static int akau_mixer_register_song_for_printing(
+  struct akau_mixer *mixer,
+  struct akau_song *song,
+  const uint64_t *cache_key,
+  int restart,
+  uint8_t intent
+) {
 
   if (mixer->printer) {
   
@@ -775,8 +1114,19 @@ static int akau_mixer_register_song_for_printing(struct akau_mixer *mixer,struct
   mixer->print_start_time=ps_time_now();
   ps_log(AUDIO,DEBUG,"%lld begin printing song",(long long)mixer->print_start_time);
   if (!(mixer->printer=akau_songprinter_new(song))) return -1;
+  if (mixer->songcache) {
+    uint64_t key;
+    if (cache_key) key=*cache_key;
+    else if (akau_songcache_key(&key,song)<0) return -1;
+    if (akau_songprinter_set_cache(mixer->printer,mixer->songcache,key)<0) return -1;
+  }
   if (akau_songprinter_begin(mixer->printer)<0) return -1;
 
+  /* If it came from the cache, it's ready now. Start playing without waiting for the next update. */
+  if (akau_songprinter_get_progress(mixer->printer)==AKAU_SONGPRINTER_PROGRESS_READY) {
+    if (akau_mixer_check_printer_progress(mixer)<0) return -1;
+  }
+
   return 0;
 }
 
@@ -839,9 +1189,19 @@ static int akau_mixer_replace_unprinted_song(struct akau_mixer *mixer,struct aka
  */
  
 int akau_mixer_play_song(struct akau_mixer *mixer,struct akau_song *song,int restart,uint8_t intent) {
+  return akau_mixer_play_song_with_key(mixer,song,0,restart,intent);
+}
+
+int akau_mixer_play_song_with_key(
+  struct akau_mixer *mixer,
+  struct akau_song *song,
+  const uint64_t *cache_key,
+  int restart,
+  uint8_t intent
+) {
   if (!mixer) return -1;
   if (mixer->print_songs) {
-    return akau_mixer_register_song_for_printing(mixer,song,restart,intent);
+    return akau_mixer_register_song_for_printing(mixer,song,cache_key,restart,intent);
   } else {
     return akau_mixer_replace_unprinted_song(mixer,song,restart,intent);
   }
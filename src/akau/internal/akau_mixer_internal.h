@@ -15,6 +15,8 @@
 #define AKAU_MIXER_CHAN_MODE_TUNED      1
 #define AKAU_MIXER_CHAN_MODE_VERBATIM   2
 
+#define AKAU_MIXER_BLOCK_SIZE 256 /* Frames. */
+
 struct akau_mixer_chan {
   int chanid;
   int mode;
@@ -57,6 +59,7 @@ struct akau_mixer_chan {
       struct akau_ipcm *ipcm;
       int p;
       int loop;
+      int hold; // Don't advance; we're waiting for songprinter.
     } verbatim;
     
   };
@@ -76,8 +79,12 @@ struct akau_mixer {
   uint8_t trim_by_intent[256];
   int print_songs;
   struct akau_songprinter *printer;
+  struct akau_songcache *songcache;
   int printed_song_running;
   int64_t print_start_time;
+  int block_mixing;
+  int32_t accl[AKAU_MIXER_BLOCK_SIZE]; // Block mixing accumulators. Mono uses only (accl).
+  int32_t accr[AKAU_MIXER_BLOCK_SIZE];
 };
 
 void akau_mixer_chan_cleanup(struct akau_mixer_chan *chan);
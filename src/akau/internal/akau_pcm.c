@@ -50,18 +50,19 @@ struct akau_fpcm *akau_fpcm_new(int samplec) {
   
 void akau_ipcm_del(struct akau_ipcm *ipcm) {
   if (!ipcm) return;
-  if (ipcm->refc-->1) return;
+  if (__atomic_sub_fetch(&ipcm->refc,1,__ATOMIC_ACQ_REL)>0) return;
   free(ipcm);
 }
 
 /* Retain.
+ * Atomic, since songprinter's workers and the audio thread can share IPCMs.
  */
  
 int akau_ipcm_ref(struct akau_ipcm *ipcm) {
   if (!ipcm) return -1;
   if (ipcm->refc<1) return -1;
   if (ipcm->refc==INT_MAX) return -1;
-  ipcm->refc++;
+  __atomic_add_fetch(&ipcm->refc,1,__ATOMIC_RELAXED);
   return 0;
 }
 
@@ -0,0 +1,67 @@
+#include "akau_internal.h"
+#include "../akau_period.h"
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+
+// Clean periods before the first attempt to shrink, and the most we'll ever wait.
+#define AKAU_PERIOD_SHRINK_AFTER_INITIAL   1024
+#define AKAU_PERIOD_SHRINK_AFTER_LIMIT   262144
+
+/* Init.
+ */
+
+int akau_period_init(struct akau_period *period,int rate,int low_latency,int request) {
+  if (!period) return -1;
+  if (rate<1) return -1;
+  memset(period,0,sizeof(struct akau_period));
+  period->rate=rate;
+  period->periodc=AKAU_PERIOD_COUNT;
+  period->max=AKAU_PERIOD_MAX;
+  period->shrink_after=AKAU_PERIOD_SHRINK_AFTER_INITIAL;
+
+  if (low_latency) {
+    if (request<1) request=AKAU_PERIOD_LOW_LATENCY;
+    period->min=AKAU_PERIOD_MIN;
+  } else {
+    if (request<1) request=AKAU_PERIOD_DEFAULT;
+    period->min=request;
+  }
+  if (request>AKAU_PERIOD_MAX) request=AKAU_PERIOD_MAX;
+  if (request<AKAU_PERIOD_MIN) request=AKAU_PERIOD_MIN;
+  period->period=AKAU_PERIOD_MIN;
+  while (period->period<request) period->period<<=1;
+  if (period->min>period->period) period->min=period->period;
+
+  return 0;
+}
+
+/* Events.
+ */
+
+int akau_period_xrun(struct akau_period *period) {
+  if (!period) return 0;
+  if (period->xrunc<INT_MAX) period->xrunc++;
+  period->clean=0;
+  if (period->shrink_after<AKAU_PERIOD_SHRINK_AFTER_LIMIT) period->shrink_after<<=1;
+  if (period->period>=period->max) return 0;
+  period->period<<=1;
+  return 1;
+}
+
+int akau_period_ok(struct akau_period *period) {
+  if (!period) return 0;
+  if (++(period->clean)<period->shrink_after) return 0;
+  period->clean=0;
+  if (period->period<=period->min) return 0;
+  period->period>>=1;
+  return 1;
+}
+
+/* Latency.
+ */
+
+int akau_period_get_latency_us(const struct akau_period *period) {
+  if (!period||(period->rate<1)) return 0;
+  return (int)(((int64_t)period->period*period->periodc*1000000)/period->rate);
+}
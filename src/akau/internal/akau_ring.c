@@ -0,0 +1,61 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "akau_ring.h"
+
+/* Init.
+ */
+
+int akau_ring_init(struct akau_ring *ring,int elemsize,int capacity) {
+  if (!ring) return -1;
+  if (elemsize<1) return -1;
+  if ((capacity<1)||(capacity&(capacity-1))) return -1;
+  if (capacity>INT32_MAX/elemsize) return -1;
+  if (!(ring->v=malloc(elemsize*capacity))) return -1;
+  ring->elemsize=elemsize;
+  ring->mask=capacity-1;
+  ring->head=0;
+  ring->tail=0;
+  return 0;
+}
+
+void akau_ring_cleanup(struct akau_ring *ring) {
+  if (!ring) return;
+  if (ring->v) free(ring->v);
+  memset(ring,0,sizeof(struct akau_ring));
+}
+
+/* Push.
+ * Indices run freely and wrap at UINT_MAX; unsigned subtraction still gives the count.
+ * The release store on (head) publishes the element to the consumer.
+ */
+
+int akau_ring_push(struct akau_ring *ring,const void *src) {
+  unsigned int head=ring->head;
+  unsigned int tail=__atomic_load_n(&ring->tail,__ATOMIC_ACQUIRE);
+  if (head-tail>(unsigned int)ring->mask) return -1;
+  memcpy(ring->v+(head&ring->mask)*ring->elemsize,src,ring->elemsize);
+  __atomic_store_n(&ring->head,head+1,__ATOMIC_RELEASE);
+  return 0;
+}
+
+/* Pop.
+ */
+
+int akau_ring_pop(void *dst,struct akau_ring *ring) {
+  unsigned int tail=ring->tail;
+  unsigned int head=__atomic_load_n(&ring->head,__ATOMIC_ACQUIRE);
+  if (head==tail) return 0;
+  memcpy(dst,ring->v+(tail&ring->mask)*ring->elemsize,ring->elemsize);
+  __atomic_store_n(&ring->tail,tail+1,__ATOMIC_RELEASE);
+  return 1;
+}
+
+/* Count.
+ */
+
+int akau_ring_count(const struct akau_ring *ring) {
+  unsigned int head=__atomic_load_n(&ring->head,__ATOMIC_ACQUIRE);
+  unsigned int tail=__atomic_load_n(&ring->tail,__ATOMIC_ACQUIRE);
+  return head-tail;
+}
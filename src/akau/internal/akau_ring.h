@@ -0,0 +1,33 @@
+/* akau_ring.h
+ * Fixed-size single-producer single-consumer queue, for passing messages across the audio thread without a lock.
+ * Exactly one thread may push and exactly one may pop; they may be different threads, or the same.
+ * If you need a second producer or consumer, you need a lock after all.
+ */
+
+#ifndef AKAU_RING_H
+#define AKAU_RING_H
+
+struct akau_ring {
+  uint8_t *v;
+  int elemsize;
+  int mask; // capacity-1
+  unsigned int head; // Next slot to write. Only the producer stores.
+  unsigned int tail; // Next slot to read. Only the consumer stores.
+};
+
+/* (capacity) must be a power of two.
+ */
+int akau_ring_init(struct akau_ring *ring,int elemsize,int capacity);
+void akau_ring_cleanup(struct akau_ring *ring);
+
+/* Copy one element in or out.
+ * Push returns <0 if the ring is full, and pop returns 0 if it's empty.
+ */
+int akau_ring_push(struct akau_ring *ring,const void *src);
+int akau_ring_pop(void *dst,struct akau_ring *ring);
+
+/* Count of elements waiting, as seen from either end.
+ */
+int akau_ring_count(const struct akau_ring *ring);
+
+#endif
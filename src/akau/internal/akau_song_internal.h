@@ -37,4 +37,12 @@ struct akau_song {
   void *userdata;
 };
 
+/* Play commands from (cmdp) through the next BEAT, like akau_song_update(), for songprinter.
+ * We use (chanid_ref) instead of the song's own, and don't touch the song or the mixer's song state,
+ * so several threads can play the same song at once.
+ * If (lenient), adjustments to channels the mixer doesn't have are skipped instead of failing.
+ * Returns the position of the next beat's first command.
+ */
+int akau_song_update_detached(struct akau_song *song,struct akau_mixer *mixer,int cmdp,uint8_t intent,int *chanid_ref,int lenient);
+
 #endif
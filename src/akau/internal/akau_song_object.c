@@ -34,7 +34,7 @@ struct akau_song *akau_song_new() {
  
 void akau_song_del(struct akau_song *song) {
   if (!song) return;
-  if (song->refc-->1) return;
+  if (__atomic_sub_fetch(&song->refc,1,__ATOMIC_ACQ_REL)>0) return;
 
   if (song->drumv) {
     while (song->drumc-->0) akau_song_drum_cleanup(song->drumv+song->drumc);
@@ -52,13 +52,14 @@ void akau_song_del(struct akau_song *song) {
 }
 
 /* Retain.
+ * Atomic, since the main thread can retain a song the audio thread is about to release.
  */
  
 int akau_song_ref(struct akau_song *song) {
   if (!song) return -1;
   if (song->refc<1) return -1;
   if (song->refc==INT_MAX) return -1;
-  song->refc++;
+  __atomic_add_fetch(&song->refc,1,__ATOMIC_RELAXED);
   return 0;
 }
 
@@ -3,14 +3,37 @@
 
 /* Update single command.
  * Return >0 to finish update, <0 on error, or 0 to proceed.
+ * (chanid_ref) is usually the song's own, but detached updates supply their own.
+ * Detached updates don't touch the song or the mixer's song state, and may skip adjustments to unknown channels.
  */
 
-static int akau_song_execute_command(struct akau_song *song,const union akau_song_command *cmd,struct akau_mixer *mixer,uint8_t intent) {
+#define AKAU_SONG_UPDATE_DETACHED  0x01
+#define AKAU_SONG_UPDATE_LENIENT   0x02
+
+static int akau_song_get_channel_for_adjustment(
+  uint8_t *pitch,uint8_t *trim,int8_t *pan,
+  struct akau_mixer *mixer,int chanid,int flags
+) {
+  if (akau_mixer_get_channel(pitch,trim,pan,mixer,chanid)>=0) return 1;
+  if (flags&AKAU_SONG_UPDATE_LENIENT) return 0;
+  return -1;
+}
+
+static int akau_song_execute_command(
+  struct akau_song *song,
+  const union akau_song_command *cmd,
+  struct akau_mixer *mixer,
+  uint8_t intent,
+  int *chanid_ref,
+  int flags
+) {
+  int err;
   switch (cmd->op) {
 
     case AKAU_SONG_OP_NOOP: return 0;
 
     case AKAU_SONG_OP_BEAT: {
+        if (flags&AKAU_SONG_UPDATE_DETACHED) return 1;
         if (song->cb_sync) {
           if (song->cb_sync(song,song->beatp,song->userdata)<0) return -1;
         }
@@ -21,40 +44,40 @@ static int akau_song_execute_command(struct akau_song *song,const union akau_son
     case AKAU_SONG_OP_NOTE: {
         if (cmd->NOTE.instrid>=song->instrc) return -1;
         struct akau_instrument *instrument=song->instrv[cmd->NOTE.instrid].instrument;
-        int err=akau_mixer_play_note(mixer,instrument,cmd->NOTE.pitch,cmd->NOTE.trim,cmd->NOTE.pan,cmd->NOTE.duration*song->frames_per_beat,intent);
+        err=akau_mixer_play_note(mixer,instrument,cmd->NOTE.pitch,cmd->NOTE.trim,cmd->NOTE.pan,cmd->NOTE.duration*song->frames_per_beat,intent);
         if (err<0) return -1;
-        song->chanid_ref[cmd->NOTE.ref]=err;
+        chanid_ref[cmd->NOTE.ref]=err;
       } return 0;
 
     case AKAU_SONG_OP_DRUM: {
         if (cmd->DRUM.drumid>=song->drumc) return -1;
         struct akau_ipcm *ipcm=song->drumv[cmd->DRUM.drumid].ipcm;
-        int err=akau_mixer_play_ipcm(mixer,ipcm,cmd->DRUM.trim,cmd->DRUM.pan,0,intent);
+        err=akau_mixer_play_ipcm(mixer,ipcm,cmd->DRUM.trim,cmd->DRUM.pan,0,intent);
         if (err<0) return -1;
-        song->chanid_ref[cmd->DRUM.ref]=err;
+        chanid_ref[cmd->DRUM.ref]=err;
       } return 0;
 
     case AKAU_SONG_OP_ADJPITCH: {
-        int chanid=song->chanid_ref[cmd->ADJ.ref];
+        int chanid=chanid_ref[cmd->ADJ.ref];
         uint8_t pitch,trim;
         int8_t pan;
-        if (akau_mixer_get_channel(&pitch,&trim,&pan,mixer,chanid)<0) return -1;
+        if ((err=akau_song_get_channel_for_adjustment(&pitch,&trim,&pan,mixer,chanid,flags))<=0) return err;
         if (akau_mixer_adjust_channel(mixer,chanid,cmd->ADJ.v,trim,pan,cmd->ADJ.duration*song->frames_per_beat)<0) return -1;
       } return 0;
 
     case AKAU_SONG_OP_ADJTRIM: {
-        int chanid=song->chanid_ref[cmd->ADJ.ref];
+        int chanid=chanid_ref[cmd->ADJ.ref];
         uint8_t pitch,trim;
         int8_t pan;
-        if (akau_mixer_get_channel(&pitch,&trim,&pan,mixer,chanid)<0) return -1;
+        if ((err=akau_song_get_channel_for_adjustment(&pitch,&trim,&pan,mixer,chanid,flags))<=0) return err;
         if (akau_mixer_adjust_channel(mixer,chanid,pitch,cmd->ADJ.v,pan,cmd->ADJ.duration*song->frames_per_beat)<0) return -1;
       } return 0;
 
     case AKAU_SONG_OP_ADJPAN: {
-        int chanid=song->chanid_ref[cmd->ADJ.ref];
+        int chanid=chanid_ref[cmd->ADJ.ref];
         uint8_t pitch,trim;
         int8_t pan;
-        if (akau_mixer_get_channel(&pitch,&trim,&pan,mixer,chanid)<0) return -1;
+        if ((err=akau_song_get_channel_for_adjustment(&pitch,&trim,&pan,mixer,chanid,flags))<=0) return err;
         if (akau_mixer_adjust_channel(mixer,chanid,pitch,trim,cmd->ADJ.v,cmd->ADJ.duration*song->frames_per_beat)<0) return -1;
       } return 0;
       
@@ -76,7 +99,7 @@ int akau_song_update(struct akau_song *song,struct akau_mixer *mixer,int cmdp,ui
 
   while (cmdp<song->cmdc) {
     const union akau_song_command *cmd=song->cmdv+cmdp;
-    int err=akau_song_execute_command(song,cmd,mixer,intent);
+    int err=akau_song_execute_command(song,cmd,mixer,intent,song->chanid_ref,0);
     if (err<0) return -1;
     cmdp++;
     if (err>0) break;
@@ -85,3 +108,24 @@ int akau_song_update(struct akau_song *song,struct akau_mixer *mixer,int cmdp,ui
   if (akau_mixer_set_song_position(mixer,cmdp)<0) return -1;
   return 0;
 }
+
+/* Detached update.
+ */
+
+int akau_song_update_detached(struct akau_song *song,struct akau_mixer *mixer,int cmdp,uint8_t intent,int *chanid_ref,int lenient) {
+  if (!song||!mixer||!chanid_ref) return -1;
+  if (song->cmdc<1) return -1;
+  if ((cmdp<0)||(cmdp>=song->cmdc)) cmdp=0;
+  int flags=AKAU_SONG_UPDATE_DETACHED;
+  if (lenient) flags|=AKAU_SONG_UPDATE_LENIENT;
+
+  while (cmdp<song->cmdc) {
+    const union akau_song_command *cmd=song->cmdv+cmdp;
+    int err=akau_song_execute_command(song,cmd,mixer,intent,chanid_ref,flags);
+    if (err<0) return -1;
+    cmdp++;
+    if (err>0) break;
+  }
+
+  return cmdp;
+}
@@ -0,0 +1,461 @@
+#include "akau_internal.h"
+#include "akau_song_internal.h"
+#include "../akau_songcache.h"
+#include "../akau_song.h"
+#include "../akau_pcm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <utime.h>
+#include <sys/stat.h>
+#define HAVE_STRUCT_TIMESPEC 1
+#include <pthread.h>
+#include "os/ps_log.h"
+#include "os/ps_fs.h"
+
+#define AKAU_SONGCACHE_MEMORY_LIMIT_DEFAULT (64<<20)
+#define AKAU_SONGCACHE_DISK_LIMIT_DEFAULT (256<<20)
+#define AKAU_SONGCACHE_VERSION 1 /* Part of every key. Bump it if the printed output of a song changes. */
+#define AKAU_SONGCACHE_SUFFIX ".akaupcm"
+#define AKAU_SONGCACHE_PATH_LIMIT 1024
+#define AKAU_SONGCACHE_FILE_HEADER_SIZE 24
+
+/* Object definition.
+ */
+
+struct akau_songcache_entry {
+  uint64_t key;
+  struct akau_ipcm *ipcm;
+  int size; // Bytes of samples.
+  int64_t usetime; // From (useseq), higher is more recent.
+};
+
+struct akau_songcache {
+  int refc;
+  pthread_mutex_t mutex;
+  int memory_limit,disk_limit;
+  char *path;
+  // Guarded by (mutex):
+  struct akau_songcache_entry *entryv;
+  int entryc,entrya;
+  int memory_usage;
+  int64_t useseq;
+  int tmpseq;
+};
+
+/* Object lifecycle.
+ */
+
+struct akau_songcache *akau_songcache_new() {
+  struct akau_songcache *cache=calloc(1,sizeof(struct akau_songcache));
+  if (!cache) return 0;
+  if (pthread_mutex_init(&cache->mutex,0)) {
+    free(cache);
+    return 0;
+  }
+  cache->refc=1;
+  cache->memory_limit=AKAU_SONGCACHE_MEMORY_LIMIT_DEFAULT;
+  cache->disk_limit=AKAU_SONGCACHE_DISK_LIMIT_DEFAULT;
+  return cache;
+}
+
+void akau_songcache_del(struct akau_songcache *cache) {
+  if (!cache) return;
+  if (__atomic_sub_fetch(&cache->refc,1,__ATOMIC_ACQ_REL)>0) return;
+  if (cache->entryv) {
+    while (cache->entryc-->0) akau_ipcm_del(cache->entryv[cache->entryc].ipcm);
+    free(cache->entryv);
+  }
+  if (cache->path) free(cache->path);
+  pthread_mutex_destroy(&cache->mutex);
+  free(cache);
+}
+
+int akau_songcache_ref(struct akau_songcache *cache) {
+  if (!cache) return -1;
+  if (cache->refc<1) return -1;
+  if (cache->refc==INT_MAX) return -1;
+  __atomic_add_fetch(&cache->refc,1,__ATOMIC_RELAXED);
+  return 0;
+}
+
+/* Drop least recently used entries from memory until (addc) more bytes would fit.
+ * Caller must hold the mutex.
+ */
+
+static void akau_songcache_evict_memory(struct akau_songcache *cache,int addc) {
+  while ((cache->entryc>0)&&(cache->memory_usage>cache->memory_limit-addc)) {
+    int oldp=0,i=1;
+    for (;i<cache->entryc;i++) {
+      if (cache->entryv[i].usetime<cache->entryv[oldp].usetime) oldp=i;
+    }
+    struct akau_songcache_entry *entry=cache->entryv+oldp;
+    cache->memory_usage-=entry->size;
+    akau_ipcm_del(entry->ipcm);
+    cache->entryc--;
+    memmove(entry,entry+1,sizeof(struct akau_songcache_entry)*(cache->entryc-oldp));
+  }
+}
+
+/* Limits and path.
+ */
+
+int akau_songcache_set_limits(struct akau_songcache *cache,int memory_limit,int disk_limit) {
+  if (!cache) return -1;
+  if ((memory_limit<0)||(disk_limit<0)) return -1;
+  if (pthread_mutex_lock(&cache->mutex)) return -1;
+  cache->memory_limit=memory_limit;
+  cache->disk_limit=disk_limit;
+  akau_songcache_evict_memory(cache,0);
+  pthread_mutex_unlock(&cache->mutex);
+  return 0;
+}
+
+int akau_songcache_set_path(struct akau_songcache *cache,const char *path) {
+  if (!cache) return -1;
+  char *npath=0;
+  if (path&&path[0]) {
+    int pathc=0; while (path[pathc]) pathc++;
+    if (pathc>=AKAU_SONGCACHE_PATH_LIMIT-32) return -1; // Leave room for file names.
+    if (!(npath=malloc(pathc+1))) return -1;
+    memcpy(npath,path,pathc+1);
+  }
+  if (pthread_mutex_lock(&cache->mutex)) {
+    if (npath) free(npath);
+    return -1;
+  }
+  if (cache->path) free(cache->path);
+  cache->path=npath;
+  pthread_mutex_unlock(&cache->mutex);
+  return 0;
+}
+
+const char *akau_songcache_get_path(const struct akau_songcache *cache) {
+  if (!cache) return 0;
+  return cache->path;
+}
+
+/* Usage.
+ */
+
+int akau_songcache_get_memory_usage(const struct akau_songcache *cache) {
+  if (!cache) return 0;
+  pthread_mutex_t *mutex=(pthread_mutex_t*)&cache->mutex;
+  if (pthread_mutex_lock(mutex)) return 0;
+  int usage=cache->memory_usage;
+  pthread_mutex_unlock(mutex);
+  return usage;
+}
+
+int akau_songcache_count_entries(const struct akau_songcache *cache) {
+  if (!cache) return 0;
+  pthread_mutex_t *mutex=(pthread_mutex_t*)&cache->mutex;
+  if (pthread_mutex_lock(mutex)) return 0;
+  int entryc=cache->entryc;
+  pthread_mutex_unlock(mutex);
+  return entryc;
+}
+
+/* Key.
+ * 64-bit FNV-1a. Integers go in big-endian, so the key doesn't depend on the host.
+ */
+
+static uint64_t akau_songcache_hash(uint64_t h,const void *src,int srcc) {
+  const uint8_t *v=src;
+  for (;srcc-->0;v++) {
+    h^=*v;
+    h*=0x100000001b3ull;
+  }
+  return h;
+}
+
+static uint64_t akau_songcache_hash_int(uint64_t h,int src) {
+  uint8_t tmp[4]={src>>24,src>>16,src>>8,src};
+  return akau_songcache_hash(h,tmp,4);
+}
+
+int akau_songcache_key(uint64_t *key,const struct akau_song *song) {
+  if (!key||!song) return -1;
+
+  uint64_t h=0xcbf29ce484222325ull;
+  h=akau_songcache_hash_int(h,AKAU_SONGCACHE_VERSION);
+  h=akau_songcache_hash_int(h,akau_get_master_rate());
+
+  void *serial=0;
+  int serialc=akau_song_encode(&serial,song);
+  if ((serialc<0)||!serial) return -1;
+  h=akau_songcache_hash_int(h,serialc);
+  h=akau_songcache_hash(h,serial,serialc);
+  free(serial);
+
+  /* The serial form only names drums by ID. What matters is the samples they're linked to. */
+  const struct akau_song_drum *drum=song->drumv;
+  int i=song->drumc; for (;i-->0;drum++) {
+    if (!drum->ipcm) return -1;
+    int samplec=akau_ipcm_get_sample_count(drum->ipcm);
+    h=akau_songcache_hash_int(h,samplec);
+    h=akau_songcache_hash_int(h,akau_ipcm_get_loop_start(drum->ipcm));
+    h=akau_songcache_hash_int(h,akau_ipcm_get_loop_end(drum->ipcm));
+    const int16_t *v=akau_ipcm_get_sample_buffer(drum->ipcm);
+    int j=samplec; for (;j-->0;v++) {
+      uint8_t tmp[2]={(*v)>>8,*v};
+      h=akau_songcache_hash(h,tmp,2);
+    }
+  }
+
+  *key=h;
+  return 0;
+}
+
+/* Memory tier.
+ */
+
+static int akau_songcache_search(const struct akau_songcache *cache,uint64_t key) {
+  const struct akau_songcache_entry *entry=cache->entryv;
+  int i=0; for (;i<cache->entryc;i++,entry++) {
+    if (entry->key==key) return i;
+  }
+  return -1;
+}
+
+struct akau_ipcm *akau_songcache_get(struct akau_songcache *cache,uint64_t key) {
+  if (!cache) return 0;
+  if (pthread_mutex_lock(&cache->mutex)) return 0;
+  struct akau_ipcm *ipcm=0;
+  int p=akau_songcache_search(cache,key);
+  if (p>=0) {
+    struct akau_songcache_entry *entry=cache->entryv+p;
+    entry->usetime=++(cache->useseq);
+    if (akau_ipcm_ref(entry->ipcm)>=0) ipcm=entry->ipcm;
+  }
+  pthread_mutex_unlock(&cache->mutex);
+  return ipcm;
+}
+
+/* Add to memory, evicting as needed.
+ * Returns >0 if added, 0 if it doesn't fit.
+ */
+
+static int akau_songcache_add_memory(struct akau_songcache *cache,uint64_t key,struct akau_ipcm *ipcm) {
+  int samplec=akau_ipcm_get_sample_count(ipcm);
+  if (samplec>INT_MAX>>1) return 0;
+  int size=samplec<<1;
+  if (size>cache->memory_limit) return 0;
+  if (pthread_mutex_lock(&cache->mutex)) return -1;
+
+  int p=akau_songcache_search(cache,key);
+  if (p>=0) {
+    cache->entryv[p].usetime=++(cache->useseq);
+    pthread_mutex_unlock(&cache->mutex);
+    return 1;
+  }
+
+  akau_songcache_evict_memory(cache,size);
+  if (cache->entryc>=cache->entrya) {
+    int na=cache->entrya+8;
+    void *nv=realloc(cache->entryv,sizeof(struct akau_songcache_entry)*na);
+    if (!nv) {
+      pthread_mutex_unlock(&cache->mutex);
+      return -1;
+    }
+    cache->entryv=nv;
+    cache->entrya=na;
+  }
+  if (akau_ipcm_ref(ipcm)<0) {
+    pthread_mutex_unlock(&cache->mutex);
+    return -1;
+  }
+  struct akau_songcache_entry *entry=cache->entryv+cache->entryc++;
+  entry->key=key;
+  entry->ipcm=ipcm;
+  entry->size=size;
+  entry->usetime=++(cache->useseq);
+  cache->memory_usage+=size;
+
+  pthread_mutex_unlock(&cache->mutex);
+  return 1;
+}
+
+/* Disk tier.
+ * Each entry is one file in AKAUPCM format, named for its key.
+ * File modification time stands in for last use.
+ */
+
+static int akau_songcache_compose_path(char *dst,struct akau_songcache *cache,uint64_t key) {
+  if (pthread_mutex_lock(&cache->mutex)) return -1;
+  int dstc=-1;
+  if (cache->path&&(cache->disk_limit>0)) {
+    dstc=snprintf(dst,AKAU_SONGCACHE_PATH_LIMIT,"%s/%016llx" AKAU_SONGCACHE_SUFFIX,cache->path,(unsigned long long)key);
+    if (dstc>=AKAU_SONGCACHE_PATH_LIMIT) dstc=-1;
+  }
+  pthread_mutex_unlock(&cache->mutex);
+  return dstc;
+}
+
+static int akau_songcache_encode_file(void *dstpp,struct akau_ipcm *ipcm) {
+  int samplec=akau_ipcm_get_sample_count(ipcm);
+  if (samplec>(INT_MAX-AKAU_SONGCACHE_FILE_HEADER_SIZE)>>1) return -1;
+  int dstc=AKAU_SONGCACHE_FILE_HEADER_SIZE+(samplec<<1);
+  uint8_t *dst=malloc(dstc);
+  if (!dst) return -1;
+  int loopa=akau_ipcm_get_loop_start(ipcm);
+  int loopz=akau_ipcm_get_loop_end(ipcm);
+  int rate=akau_get_master_rate();
+  #if BYTE_ORDER==LITTLE_ENDIAN
+    int format=1;
+  #else
+    int format=2;
+  #endif
+  memcpy(dst,"\0AKAUPCM",8);
+  dst[8]=rate>>24; dst[9]=rate>>16; dst[10]=rate>>8; dst[11]=rate;
+  dst[12]=loopa>>24; dst[13]=loopa>>16; dst[14]=loopa>>8; dst[15]=loopa;
+  dst[16]=loopz>>24; dst[17]=loopz>>16; dst[18]=loopz>>8; dst[19]=loopz;
+  dst[20]=format>>24; dst[21]=format>>16; dst[22]=format>>8; dst[23]=format;
+  memcpy(dst+AKAU_SONGCACHE_FILE_HEADER_SIZE,akau_ipcm_get_sample_buffer(ipcm),samplec<<1);
+  *(void**)dstpp=dst;
+  return dstc;
+}
+
+struct akau_songcache_file {
+  char name[32];
+  off_t size;
+  time_t mtime;
+};
+
+static int akau_songcache_file_cmp(const void *a,const void *b) {
+  const struct akau_songcache_file *A=a,*B=b;
+  if (A->mtime<B->mtime) return -1;
+  if (A->mtime>B->mtime) return 1;
+  return 0;
+}
+
+/* Delete the least recently used files until the directory is within (limit).
+ * We only touch files named like our own.
+ */
+
+static int akau_songcache_evict_disk(const char *dirpath,int limit) {
+  DIR *dir=opendir(dirpath);
+  if (!dir) return -1;
+  struct akau_songcache_file *filev=0;
+  int filec=0,filea=0;
+  int64_t total=0;
+  char path[AKAU_SONGCACHE_PATH_LIMIT];
+  struct dirent *de;
+  while (de=readdir(dir)) {
+    int namec=0; while (de->d_name[namec]) namec++;
+    const int suffixc=sizeof(AKAU_SONGCACHE_SUFFIX)-1;
+    if (namec!=16+suffixc) continue;
+    if (memcmp(de->d_name+16,AKAU_SONGCACHE_SUFFIX,suffixc)) continue;
+    if (snprintf(path,sizeof(path),"%s/%s",dirpath,de->d_name)>=sizeof(path)) continue;
+    struct stat st;
+    if (stat(path,&st)<0) continue;
+    if (filec>=filea) {
+      int na=filea+32;
+      void *nv=realloc(filev,sizeof(struct akau_songcache_file)*na);
+      if (!nv) break;
+      filev=nv;
+      filea=na;
+    }
+    struct akau_songcache_file *file=filev+filec++;
+    memcpy(file->name,de->d_name,namec+1);
+    file->size=st.st_size;
+    file->mtime=st.st_mtime;
+    total+=st.st_size;
+  }
+  closedir(dir);
+
+  if (total>limit) {
+    qsort(filev,filec,sizeof(struct akau_songcache_file),akau_songcache_file_cmp);
+    int i=0; for (;(i<filec)&&(total>limit);i++) {
+      if (snprintf(path,sizeof(path),"%s/%s",dirpath,filev[i].name)>=sizeof(path)) continue;
+      if (unlink(path)<0) continue;
+      ps_log(AUDIO,DEBUG,"Evicted printed song %s from disk cache.",filev[i].name);
+      total-=filev[i].size;
+    }
+  }
+  if (filev) free(filev);
+  return 0;
+}
+
+/* Write one entry, then evict others if we're over the limit.
+ * We write to a temporary file first, so readers never see a partial entry.
+ */
+
+static int akau_songcache_add_disk(struct akau_songcache *cache,uint64_t key,struct akau_ipcm *ipcm) {
+  char path[AKAU_SONGCACHE_PATH_LIMIT];
+  int pathc=akau_songcache_compose_path(path,cache,key);
+  if (pathc<0) return 0;
+  if (access(path,F_OK)>=0) return 0;
+
+  void *src=0;
+  int srcc=akau_songcache_encode_file(&src,ipcm);
+  if (srcc<0) return -1;
+  if (srcc>cache->disk_limit) {
+    free(src);
+    return 0;
+  }
+
+  char tmppath[AKAU_SONGCACHE_PATH_LIMIT+32];
+  int tmpseq=__atomic_add_fetch(&cache->tmpseq,1,__ATOMIC_RELAXED);
+  snprintf(tmppath,sizeof(tmppath),"%s.%d.%d.tmp",path,(int)getpid(),tmpseq);
+  if (
+    (ps_mkdir_parents(path)<0)||
+    (ps_file_write(tmppath,src,srcc)<0)||
+    (rename(tmppath,path)<0)
+  ) {
+    ps_log(AUDIO,WARN,"Failed to write printed song to '%s'.",path);
+    unlink(tmppath);
+    free(src);
+    return -1;
+  }
+  free(src);
+
+  char dirpath[AKAU_SONGCACHE_PATH_LIMIT];
+  int dirpathc=ps_file_dirname(dirpath,sizeof(dirpath),path,pathc);
+  if ((dirpathc>0)&&(dirpathc<sizeof(dirpath))) {
+    akau_songcache_evict_disk(dirpath,cache->disk_limit);
+  }
+  return 1;
+}
+
+int akau_songcache_load(struct akau_songcache *cache,uint64_t key) {
+  if (!cache) return -1;
+
+  struct akau_ipcm *ipcm=akau_songcache_get(cache,key);
+  if (ipcm) {
+    akau_ipcm_del(ipcm);
+    return 1;
+  }
+
+  char path[AKAU_SONGCACHE_PATH_LIMIT];
+  if (akau_songcache_compose_path(path,cache,key)<0) return 0;
+  void *src=0;
+  int srcc=ps_file_read(&src,path);
+  if ((srcc<0)||!src) return 0;
+  ipcm=akau_ipcm_decode(src,srcc);
+  free(src);
+  if (!ipcm) {
+    ps_log(AUDIO,WARN,"Removing unreadable printed song '%s'.",path);
+    unlink(path);
+    return 0;
+  }
+  utime(path,0); // Mark it recently used.
+
+  int err=akau_songcache_add_memory(cache,key,ipcm);
+  akau_ipcm_del(ipcm);
+  if (err<0) return -1;
+  return err;
+}
+
+/* Add.
+ */
+
+int akau_songcache_add(struct akau_songcache *cache,uint64_t key,struct akau_ipcm *ipcm) {
+  if (!cache||!ipcm) return -1;
+  if (akau_songcache_add_memory(cache,key,ipcm)<0) return -1;
+  if (akau_songcache_add_disk(cache,key,ipcm)<0) return -1;
+  return 0;
+}
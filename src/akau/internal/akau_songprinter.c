@@ -1,8 +1,11 @@
 #include "akau_internal.h"
+#include "akau_song_internal.h"
 #include "../akau_songprinter.h"
+#include "../akau_songcache.h"
 #include "../akau_mixer.h"
 #include "../akau_song.h"
 #include "../akau_pcm.h"
+#include "../akau_instrument.h"
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -10,21 +13,65 @@
 #define HAVE_STRUCT_TIMESPEC 1
 #include <pthread.h>
 #include "os/ps_log.h"
+#include "os/ps_clockassist.h"
+
+#define AKAU_SONGPRINTER_THREAD_LIMIT 8
+#define AKAU_SONGPRINTER_RANGE_MS 2000 /* Minimum. Shorter ranges start playback sooner, but spend more time on preroll. */
 
 /* Object definition.
+ * The song is printed in ranges of whole beats, each independently by one worker with a private mixer.
+ * Anything still sounding at the start of a range was begun on some earlier beat.
+ * So each range begins with a "preroll" of the beats before it, which we skip through without output.
+ * The preroll reaches back far enough that the range's output is exactly what a single pass would produce.
  */
 
+struct akau_songprinter_range {
+  int prerollp; // First beat to play; output before (beatp) is discarded.
+  int cmdp; // Command position of (prerollp).
+  int beatp,beatc; // Beats to output.
+  int samplep,samplec; // Output position in (ipcm).
+  int done;
+};
+
 struct akau_songprinter {
   int refc;
   struct akau_song *song;
-  struct akau_mixer *mixer;
+  int song_locked;
   struct akau_ipcm *ipcm;
-  pthread_t thread;
+  int frames_per_beat; // Mixer frames per beat, which is one more than the song's.
+  struct akau_songprinter_range *rangev;
+  int rangec;
+  int lead_samplec; // Minimum lead for streaming: Ranges finish out of order, so allow one per thread.
+  pthread_t threadv[AKAU_SONGPRINTER_THREAD_LIMIT];
+  int threadc; // Workers to run, including the caller when printing synchronously.
+  int thread_in_flight; // Count of (threadv) to join.
   pthread_mutex_t mutex;
   int progress;
-  int thread_in_flight;
+  volatile int cancel;
+  int64_t start_time;
+  struct akau_songcache *cache;
+  uint64_t cache_key;
+  // Guarded by (mutex):
+  int rangep; // Next range to print.
+  int readyc; // Count of leading ranges complete.
+  int ready_samplec; // Samples from the start that are final.
+  int printed_samplec; // Samples final in total.
 };
 
+/* Default thread count.
+ */
+
+static int akau_songprinter_count_cores() {
+  #ifdef _SC_NPROCESSORS_ONLN
+    int c=sysconf(_SC_NPROCESSORS_ONLN);
+    if (c<1) return 1;
+    if (c>AKAU_SONGPRINTER_THREAD_LIMIT) return AKAU_SONGPRINTER_THREAD_LIMIT;
+    return c;
+  #else
+    return 2;
+  #endif
+}
+
 /* Initialize.
  */
 
@@ -34,12 +81,8 @@ static int akau_songprinter_init(struct akau_songprinter *printer,struct akau_so
 
   if (akau_song_ref(song)<0) return -1;
   printer->song=song;
-  
-  if (!(printer->mixer=akau_mixer_new())) return -1;
-  if (akau_mixer_set_stereo(printer->mixer,0)<0) return -1;
-  if (akau_mixer_set_print_songs(printer->mixer,0)<0) return -1; // Very important!
 
-  ps_log(AUDIO,DEBUG,"%s allocated inner mixer, measuring song...",__func__);
+  ps_log(AUDIO,DEBUG,"%s measuring song...",__func__);
 
   int beatc=akau_song_count_beats(song);
   if (beatc<1) return -1;
@@ -50,12 +93,19 @@ static int akau_songprinter_init(struct akau_songprinter *printer,struct akau_so
   if (rate>INT_MAX/tempo) return -1;
   int samples_per_beat=(rate*60)/tempo;
   if (samples_per_beat<1) return -1;
+  if (samples_per_beat>INT_MAX/beatc) return -1;
   int samplec=beatc*samples_per_beat;
   if (!(printer->ipcm=akau_ipcm_new(samplec))) {
     ps_log(AUDIO,ERROR,"Failed to allocate %d-sample IPCM buffer for song.",samplec);
     return -1;
   }
 
+  /* The mixer updates a song on one frame, then waits (frames_per_beat) frames before the next.
+   * Songs have always printed that way, so we do too.
+   */
+  printer->frames_per_beat=samples_per_beat+1;
+  printer->threadc=akau_songprinter_count_cores();
+
   if (pthread_mutex_init(&printer->mutex,0)) return -1;
 
   ps_log(AUDIO,DEBUG,"%s ok",__func__);
@@ -65,7 +115,7 @@ static int akau_songprinter_init(struct akau_songprinter *printer,struct akau_so
 
 /* Object lifecycle.
  */
- 
+
 struct akau_songprinter *akau_songprinter_new(struct akau_song *song) {
   if (!song) return 0;
   struct akau_songprinter *printer=calloc(1,sizeof(struct akau_songprinter));
@@ -80,6 +130,13 @@ struct akau_songprinter *akau_songprinter_new(struct akau_song *song) {
   return printer;
 }
 
+static void akau_songprinter_join(struct akau_songprinter *printer) {
+  while (printer->thread_in_flight>0) {
+    printer->thread_in_flight--;
+    pthread_join(printer->threadv[printer->thread_in_flight],0);
+  }
+}
+
 void akau_songprinter_del(struct akau_songprinter *printer) {
   if (!printer) return;
   if (printer->refc-->1) return;
@@ -87,15 +144,17 @@ void akau_songprinter_del(struct akau_songprinter *printer) {
   ps_log(AUDIO,DEBUG,"%s %p",__func__,printer);
 
   if (printer->thread_in_flight) {
-    ps_log(AUDIO,DEBUG,"Kill in-flight printer thread.");
-    pthread_cancel(printer->thread);
-    pthread_join(printer->thread,0);
-    ps_log(AUDIO,DEBUG,"...killed");
+    ps_log(AUDIO,DEBUG,"Stop in-flight printer threads.");
+    printer->cancel=1;
+    akau_songprinter_join(printer);
+    ps_log(AUDIO,DEBUG,"...stopped");
   }
 
+  if (printer->song_locked) akau_song_unlock(printer->song);
   akau_song_del(printer->song);
   akau_ipcm_del(printer->ipcm);
-  akau_mixer_del(printer->mixer);
+  akau_songcache_del(printer->cache);
+  if (printer->rangev) free(printer->rangev);
   pthread_mutex_destroy(&printer->mutex);
 
   free(printer);
@@ -111,7 +170,7 @@ int akau_songprinter_ref(struct akau_songprinter *printer) {
 
 /* Accessors.
  */
- 
+
 struct akau_song *akau_songprinter_get_song(const struct akau_songprinter *printer) {
   if (!printer) return 0;
   return printer->song;
@@ -119,7 +178,11 @@ struct akau_song *akau_songprinter_get_song(const struct akau_songprinter *print
 
 int akau_songprinter_get_progress(const struct akau_songprinter *printer) {
   if (!printer) return AKAU_SONGPRINTER_PROGRESS_ERROR;
-  return printer->progress;
+  pthread_mutex_t *mutex=(pthread_mutex_t*)&printer->mutex;
+  if (pthread_mutex_lock(mutex)) return AKAU_SONGPRINTER_PROGRESS_ERROR;
+  int progress=printer->progress;
+  pthread_mutex_unlock(mutex);
+  return progress;
 }
 
 struct akau_ipcm *akau_songprinter_get_ipcm(const struct akau_songprinter *printer) {
@@ -132,45 +195,354 @@ struct akau_ipcm *akau_songprinter_get_ipcm_even_if_incomplete(const struct akau
   return printer->ipcm;
 }
 
-/* Asynchronous printing (background thread main).
- * We don't make just one call to akau_mixer_update() like the synchronous version.
- * Because we need to insert cancellation points at reasonable intervals.
- * The mixer doesn't really care about the buffer sizes we pass in, it's all good.
+int akau_songprinter_set_thread_count(struct akau_songprinter *printer,int threadc) {
+  if (!printer) return -1;
+  if (printer->thread_in_flight) return -1;
+  if (threadc<1) threadc=akau_songprinter_count_cores();
+  else if (threadc>AKAU_SONGPRINTER_THREAD_LIMIT) threadc=AKAU_SONGPRINTER_THREAD_LIMIT;
+  printer->threadc=threadc;
+  return 0;
+}
+
+int akau_songprinter_set_cache(struct akau_songprinter *printer,struct akau_songcache *cache,uint64_t key) {
+  if (!printer) return -1;
+  if (printer->progress!=AKAU_SONGPRINTER_PROGRESS_INIT) return -1;
+  if (cache&&(akau_songcache_ref(cache)<0)) return -1;
+  akau_songcache_del(printer->cache);
+  printer->cache=cache;
+  printer->cache_key=key;
+  return 0;
+}
+
+int akau_songprinter_get_ready_sample_count(const struct akau_songprinter *printer) {
+  int progress=akau_songprinter_get_progress(printer);
+  if (progress==AKAU_SONGPRINTER_PROGRESS_READY) return akau_ipcm_get_sample_count(printer->ipcm);
+  if (progress<=0) return 0;
+  pthread_mutex_t *mutex=(pthread_mutex_t*)&printer->mutex;
+  if (pthread_mutex_lock(mutex)) return 0;
+  int samplec=printer->ready_samplec;
+  pthread_mutex_unlock(mutex);
+  return samplec;
+}
+
+/* Streaming: Can playback start now and never reach a sample that isn't printed yet?
+ * Ranges are handed out front to back, at a throughput we measure as we go.
+ * If that's slower than playback, the lead must cover the difference over the time remaining.
  */
 
-static void *akau_songprinter_bgthd(void *arg) {
-  struct akau_songprinter *printer=arg;
-  
-  int16_t *samplev=akau_ipcm_get_sample_buffer(printer->ipcm);
+int akau_songprinter_ready_to_stream(const struct akau_songprinter *printer) {
+  int progress=akau_songprinter_get_progress(printer);
+  if (progress==AKAU_SONGPRINTER_PROGRESS_READY) return 1;
+  if (progress<=0) return 0;
+
+  pthread_mutex_t *mutex=(pthread_mutex_t*)&printer->mutex;
+  if (pthread_mutex_lock(mutex)) return 0;
+  int ready_samplec=printer->ready_samplec;
+  int printed_samplec=printer->printed_samplec;
+  pthread_mutex_unlock(mutex);
+  if (ready_samplec<printer->lead_samplec) return 0;
+
+  int64_t elapsed=ps_time_now()-printer->start_time;
+  if (elapsed<1) return 0;
+  double print_rate=(printed_samplec*1000000.0)/elapsed;
+  if (print_rate<=0.0) return 0;
+  double play_rate=akau_get_master_rate();
+  if (print_rate>=play_rate) return 1;
+  double remaining=akau_ipcm_get_sample_count(printer->ipcm)-ready_samplec;
+  double lead=printer->lead_samplec+(play_rate-print_rate)*(remaining/print_rate);
+  return (ready_samplec>=lead)?1:0;
+}
+
+/* How long can anything begun on each beat keep sounding, in frames?
+ * Notes last exactly as long as akau_mixer_play_note() makes them, and drums until the end of their IPCM.
+ * The mixer suppresses a drum that started within the last 1/30 s, which can carry a difference forward; we allow twice that.
+ */
+
+static int akau_songprinter_measure_lifetimes(int *lifev,int beatc,const struct akau_song *song) {
+  int margin=akau_get_master_rate()/15;
+  memset(lifev,0,sizeof(int)*beatc);
+  int beatp=0;
+  const union akau_song_command *cmd=song->cmdv;
+  int i=song->cmdc; for (;(i-->0)&&(beatp<beatc);cmd++) {
+    int life;
+    switch (cmd->op) {
+
+      case AKAU_SONG_OP_BEAT: beatp++; continue;
+
+      case AKAU_SONG_OP_NOTE: {
+          if (cmd->NOTE.instrid>=song->instrc) return -1;
+          const struct akau_instrument *instrument=song->instrv[cmd->NOTE.instrid].instrument;
+          if (!instrument) return -1;
+          int attack=akau_instrument_get_attack_time(instrument);
+          if (attack<1) attack=1;
+          int drawback=attack+akau_instrument_get_drawback_time(instrument);
+          if (drawback<=attack) drawback=attack+1;
+          int decay=cmd->NOTE.duration*song->frames_per_beat;
+          if (decay<=drawback) decay=drawback+1;
+          life=cmd->NOTE.duration*song->frames_per_beat+akau_instrument_get_decay_time(instrument);
+          if (life<=decay) life=decay+1;
+        } break;
+
+      case AKAU_SONG_OP_DRUM: {
+          if (cmd->DRUM.drumid>=song->drumc) return -1;
+          life=akau_ipcm_get_sample_count(song->drumv[cmd->DRUM.drumid].ipcm)+margin;
+        } break;
+
+      default: continue;
+    }
+    if (life>lifev[beatp]) lifev[beatp]=life;
+  }
+  return 0;
+}
+
+/* Divide the song into ranges.
+ */
+
+static int akau_songprinter_plan(struct akau_songprinter *printer) {
+  if (printer->rangev) return 0;
   int samplec=akau_ipcm_get_sample_count(printer->ipcm);
-  if (!samplev||(samplec<1)) {
-    printer->progress=AKAU_SONGPRINTER_PROGRESS_ERROR;
+  int beatc=akau_song_count_beats(printer->song);
+  int stride=printer->frames_per_beat;
+  int printbeatc=(samplec+stride-1)/stride;
+  if (printbeatc>beatc) printbeatc=beatc;
+  if (printbeatc<1) return -1;
+
+  int *lifev=malloc(sizeof(int)*beatc);
+  if (!lifev) return -1;
+  if (akau_songprinter_measure_lifetimes(lifev,beatc,printer->song)<0) {
+    free(lifev);
+    return -1;
+  }
+
+  int range_beatc=((akau_get_master_rate()/1000)*AKAU_SONGPRINTER_RANGE_MS+stride-1)/stride;
+  if (range_beatc<1) range_beatc=1;
+  int rangec=(printbeatc+range_beatc-1)/range_beatc;
+  if (!(printer->rangev=calloc(rangec,sizeof(struct akau_songprinter_range)))) {
+    free(lifev);
+    return -1;
+  }
+  printer->rangec=rangec;
+
+  struct akau_songprinter_range *range=printer->rangev;
+  int i=0; for (;i<rangec;i++,range++) {
+    range->beatp=i*range_beatc;
+    range->beatc=printbeatc-range->beatp;
+    if (range->beatc>range_beatc) range->beatc=range_beatc;
+    range->samplep=range->beatp*stride;
+    range->samplec=(range->beatp+range->beatc)*stride;
+    if (range->samplec>samplec) range->samplec=samplec;
+    range->samplec-=range->samplep;
+
+    /* Preroll starts at the earliest beat that is still sounding when the range begins. */
+    range->prerollp=range->beatp;
+    int rangestart=range->samplep,beatp=0;
+    for (;beatp<range->beatp;beatp++) {
+      if (beatp*stride+lifev[beatp]>rangestart) {
+        range->prerollp=beatp;
+        break;
+      }
+    }
+    if ((range->cmdp=akau_song_cmdp_from_beatp(printer->song,range->prerollp))<0) {
+      free(lifev);
+      return -1;
+    }
+  }
+
+  free(lifev);
+  return 0;
+}
+
+/* Prepare to print.
+ */
+
+static int akau_songprinter_prepare(struct akau_songprinter *printer) {
+  if (!printer->song_locked) {
+    if (akau_song_lock(printer->song)<0) return -1;
+    printer->song_locked=1;
+  }
+  if (akau_songprinter_plan(printer)<0) return -1;
+  int i=printer->rangec; while (i-->0) printer->rangev[i].done=0;
+  printer->rangep=0;
+  printer->readyc=0;
+  printer->ready_samplec=0;
+  printer->printed_samplec=0;
+  printer->cancel=0;
+  int lead_rangec=printer->threadc;
+  if (lead_rangec>printer->rangec) lead_rangec=printer->rangec;
+  printer->lead_samplec=printer->rangev[0].samplec*lead_rangec;
+  printer->start_time=ps_time_now();
+  return 0;
+}
+
+/* Mix (c) frames into (dst).
+ * akau_mixer_update() wants at least 2 samples. For a lone frame, which can only be the song's last, we mix one extra.
+ */
+
+static int akau_songprinter_mix(int16_t *dst,int c,struct akau_mixer *mixer) {
+  if (c==1) {
+    int16_t tmp[2];
+    if (akau_mixer_update(tmp,2,mixer)<0) return -1;
+    *dst=tmp[0];
     return 0;
   }
+  return akau_mixer_update(dst,c,mixer);
+}
 
-  ps_log(AUDIO,DEBUG,"Begin asynchronous song print...");
+/* Print one range.
+ */
 
-  int samplep=0;
-  while (samplep<samplec) {
+static int akau_songprinter_print_range(
+  struct akau_songprinter *printer,
+  struct akau_mixer *mixer,
+  const struct akau_songprinter_range *range
+) {
+  int16_t *dst=akau_ipcm_get_sample_buffer(printer->ipcm);
+  if (!dst) return -1;
+  dst+=range->samplep;
+  int dstc=range->samplec;
+  int chanid_ref[256]={0};
+  if (akau_mixer_stop_all(mixer,0)<0) return -1;
+
+  int cmdp=range->cmdp;
+  int beatp=range->prerollp;
+  for (;(beatp<range->beatp+range->beatc)&&(dstc>0);beatp++) {
+    if (printer->cancel) return 0;
+    int preroll=(beatp<range->beatp);
+    if ((cmdp=akau_song_update_detached(printer->song,mixer,cmdp,0,chanid_ref,preroll))<0) return -1;
+    if (preroll) {
+      if (akau_mixer_skip(mixer,printer->frames_per_beat)<0) return -1;
+    } else {
+      int c=printer->frames_per_beat;
+      if (c>dstc) c=dstc;
+      if (akau_songprinter_mix(dst,c,mixer)<0) return -1;
+      dst+=c;
+      dstc-=c;
+    }
+  }
+  return 0;
+}
 
-    pthread_testcancel();
+/* If the cache has our song, take its IPCM in place of ours and we're done.
+ * Returns >0 if so.
+ */
 
-    int progress=(samplep*100)/samplec;
-    if (progress<1) progress=1; else if (progress>99) progress=99;
-    printer->progress=progress;
-    
-    int subsamplec=10000;
-    if (samplep>samplec-subsamplec) subsamplec=samplec-samplep;
-    if (akau_mixer_update(samplev+samplep,subsamplec,printer->mixer)<0) {
-      ps_log(AUDIO,ERROR,"Error from akau_mixer_update() during asynchronous song print.");
-      printer->progress=AKAU_SONGPRINTER_PROGRESS_ERROR;
-      return 0;
+static int akau_songprinter_use_cache(struct akau_songprinter *printer) {
+  if (!printer->cache) return 0;
+  struct akau_ipcm *ipcm=akau_songcache_get(printer->cache,printer->cache_key);
+  if (!ipcm) return 0;
+  int samplec=akau_ipcm_get_sample_count(printer->ipcm);
+  if (akau_ipcm_get_sample_count(ipcm)!=samplec) {
+    ps_log(AUDIO,WARN,"Ignoring cached song with %d samples, expected %d.",akau_ipcm_get_sample_count(ipcm),samplec);
+    akau_ipcm_del(ipcm);
+    return 0;
+  }
+  ps_log(AUDIO,DEBUG,"Song %016llx found in cache.",(unsigned long long)printer->cache_key);
+  akau_ipcm_del(printer->ipcm);
+  printer->ipcm=ipcm;
+  printer->ready_samplec=samplec;
+  printer->printed_samplec=samplec;
+  printer->progress=AKAU_SONGPRINTER_PROGRESS_READY;
+  return 1;
+}
+
+/* Record a finished range.
+ * Caller must hold the mutex.
+ * Returns nonzero if that was the last one; caller must then call akau_songprinter_complete().
+ */
+
+static int akau_songprinter_range_done(struct akau_songprinter *printer,struct akau_songprinter_range *range) {
+  range->done=1;
+  printer->printed_samplec+=range->samplec;
+  while ((printer->readyc<printer->rangec)&&printer->rangev[printer->readyc].done) {
+    const struct akau_songprinter_range *ready=printer->rangev+printer->readyc++;
+    printer->ready_samplec=ready->samplep+ready->samplec;
+  }
+  if (printer->readyc>=printer->rangec) return 1;
+  int progress=(int)(((int64_t)printer->printed_samplec*100)/akau_ipcm_get_sample_count(printer->ipcm));
+  if (progress<1) progress=1; else if (progress>99) progress=99;
+  printer->progress=progress;
+  return 0;
+}
+
+/* All ranges are printed. Add to the cache if we have one, then report READY.
+ * Cache first, so nothing waiting on READY also waits for the disk.
+ */
+
+static void akau_songprinter_complete(struct akau_songprinter *printer) {
+  if (printer->cache) {
+    if (akau_songcache_add(printer->cache,printer->cache_key,printer->ipcm)<0) {
+      ps_log(AUDIO,WARN,"Failed to cache printed song.");
     }
-    samplep+=subsamplec;
-    
   }
-  ps_log(AUDIO,DEBUG,"...asynchronous song print complete");
+  if (pthread_mutex_lock(&printer->mutex)) return;
   printer->progress=AKAU_SONGPRINTER_PROGRESS_READY;
+  pthread_mutex_unlock(&printer->mutex);
+}
+
+/* Worker: Print ranges until there are none left.
+ * Ranges are claimed in order, so the printed part grows from the front.
+ */
+
+static int akau_songprinter_work(struct akau_songprinter *printer) {
+  struct akau_mixer *mixer=akau_mixer_new();
+  if (
+    !mixer||
+    (akau_mixer_set_stereo(mixer,0)<0)||
+    (akau_mixer_set_print_songs(mixer,0)<0) // Very important!
+  ) {
+    akau_mixer_del(mixer);
+    if (pthread_mutex_lock(&printer->mutex)) return -1;
+    printer->progress=AKAU_SONGPRINTER_PROGRESS_ERROR;
+    pthread_mutex_unlock(&printer->mutex);
+    return -1;
+  }
+
+  while (1) {
+    if (pthread_mutex_lock(&printer->mutex)) break;
+    if (printer->cancel||(printer->progress<0)||(printer->rangep>=printer->rangec)) {
+      pthread_mutex_unlock(&printer->mutex);
+      break;
+    }
+    struct akau_songprinter_range *range=printer->rangev+printer->rangep++;
+    pthread_mutex_unlock(&printer->mutex);
+
+    int err=akau_songprinter_print_range(printer,mixer,range);
+    if (printer->cancel) break;
+
+    if (pthread_mutex_lock(&printer->mutex)) break;
+    int complete=0;
+    if (err<0) {
+      ps_log(AUDIO,ERROR,"Error printing beats %d..%d of song.",range->beatp,range->beatp+range->beatc-1);
+      printer->progress=AKAU_SONGPRINTER_PROGRESS_ERROR;
+    } else {
+      complete=akau_songprinter_range_done(printer,range);
+    }
+    pthread_mutex_unlock(&printer->mutex);
+    if (complete) akau_songprinter_complete(printer);
+  }
+
+  akau_mixer_del(mixer);
+  return 0;
+}
+
+static void *akau_songprinter_bgthd(void *arg) {
+  akau_songprinter_work(arg);
+  return 0;
+}
+
+/* Spawn worker threads.
+ * Fails only if we can't start any of them.
+ */
+
+static int akau_songprinter_spawn(struct akau_songprinter *printer,int threadc) {
+  while (printer->thread_in_flight<threadc) {
+    if (pthread_create(printer->threadv+printer->thread_in_flight,0,akau_songprinter_bgthd,printer)) {
+      if (!printer->thread_in_flight) return -1;
+      ps_log(AUDIO,WARN,"Only %d of %d songprinter threads started.",printer->thread_in_flight,threadc);
+      break;
+    }
+    printer->thread_in_flight++;
+  }
   return 0;
 }
 
@@ -180,13 +552,14 @@ static void *akau_songprinter_bgthd(void *arg) {
 int akau_songprinter_begin(struct akau_songprinter *printer) {
   if (!printer) return -1;
   if (printer->progress!=AKAU_SONGPRINTER_PROGRESS_INIT) return -1;
-  if (akau_mixer_play_song(printer->mixer,printer->song,1,0)<0) return -1;
+  if (akau_songprinter_use_cache(printer)) return 0;
+  if (akau_songprinter_prepare(printer)<0) return -1;
   printer->progress=1;
-  printer->thread_in_flight=1;
-  ps_log(AUDIO,DEBUG,"Spawning thread for asynchronous song print.");
-  if (pthread_create(&printer->thread,0,akau_songprinter_bgthd,printer)) {
+  int threadc=printer->threadc;
+  if (threadc>printer->rangec) threadc=printer->rangec;
+  ps_log(AUDIO,DEBUG,"Spawning %d threads to print %d ranges of song.",threadc,printer->rangec);
+  if (akau_songprinter_spawn(printer,threadc)<0) {
     printer->progress=0;
-    printer->thread_in_flight=0;
     return -1;
   }
   return 0;
@@ -194,21 +567,20 @@ int akau_songprinter_begin(struct akau_songprinter *printer) {
 
 /* Cancel asynchronous print.
  */
- 
+
 int akau_songprinter_cancel(struct akau_songprinter *printer) {
   if (!printer) return -1;
-  if ((printer->progress>0)&&(printer->progress<100)) {
-    pthread_cancel(printer->thread);
-    pthread_join(printer->thread,0);
-    printer->progress=0;
-    printer->thread_in_flight=0;
+  if (printer->thread_in_flight) {
+    printer->cancel=1;
+    akau_songprinter_join(printer);
+    if (printer->progress<AKAU_SONGPRINTER_PROGRESS_READY) printer->progress=0;
   }
   return 0;
 }
 
 /* Print synchronously or block until complete.
  */
- 
+
 int akau_songprinter_finish(struct akau_songprinter *printer) {
   if (!printer) return -1;
 
@@ -216,25 +588,26 @@ int akau_songprinter_finish(struct akau_songprinter *printer) {
   if (!printer->thread_in_flight&&(printer->progress>=100)) return 0;
 
   /* Failed out? */
-  if (printer->progress<0) return -1;
+  if (akau_songprinter_get_progress(printer)<0) return -1;
 
   /* If asynchronous printing is in progress, join it.
    */
   if (printer->thread_in_flight) {
-    pthread_join(printer->thread,0);
-    printer->thread_in_flight=0;
+    akau_songprinter_join(printer);
     if (printer->progress!=AKAU_SONGPRINTER_PROGRESS_READY) return -1;
     return 0;
   }
-  
-  /* Print song synchronously.
+
+  /* Print song synchronously, with this thread as one of the workers.
    */
-  if (akau_mixer_play_song(printer->mixer,printer->song,1,0)<0) return -1;
-  int16_t *samplev=akau_ipcm_get_sample_buffer(printer->ipcm);
-  if (!samplev) return -1;
-  int samplec=akau_ipcm_get_sample_count(printer->ipcm);
-  if (samplec<1) return -1;
-  if (akau_mixer_update(samplev,samplec,printer->mixer)<0) return -1;
-  printer->progress=AKAU_SONGPRINTER_PROGRESS_READY;
+  if (akau_songprinter_use_cache(printer)) return 0;
+  if (akau_songprinter_prepare(printer)<0) return -1;
+  printer->progress=1;
+  int threadc=printer->threadc;
+  if (threadc>printer->rangec) threadc=printer->rangec;
+  if (threadc>1) akau_songprinter_spawn(printer,threadc-1);
+  akau_songprinter_work(printer);
+  akau_songprinter_join(printer);
+  if (printer->progress!=AKAU_SONGPRINTER_PROGRESS_READY) return -1;
   return 0;
 }
@@ -35,6 +35,7 @@ struct ps_sdraw_image;
 
 #define AKGL_STRATEGY_SOFT      1 /* Software compositor, OpenGL 1 for framebuffer transfer. */
 #define AKGL_STRATEGY_GL2       2 /* OpenGL/GLES 2 for everything. */
+#define AKGL_STRATEGY_HEADLESS  3 /* Software compositor and no OpenGL at all. Reports itself as SOFT. */
 
 int akgl_init(int strategy);
 void akgl_quit();
@@ -63,6 +64,19 @@ struct ps_sdraw_image *akgl_get_output_image();
 
 void akgl_log_command_count();
 
+/* Draw commands issued since init or the last akgl_log_command_count().
+ * Every program draw counts as one, in the soft renderer too.
+ */
+int akgl_get_command_count();
+
+/* With GL 2, programs can copy their vertices into one streaming buffer object, one upload per draw,
+ * instead of giving the driver client-side arrays to copy during the draw.
+ * Off by default: It only measured faster at batches far bigger than the game draws, and not yet on real hardware.
+ * The game turns it on with userconfig "video-vbo".
+ * If the buffer can't be created, we quietly fall back to client-side arrays.
+ */
+void akgl_set_vbo_enabled(int enable);
+
 /* Texture.
  *****************************************************************************/
 
@@ -132,6 +146,9 @@ int akgl_program_use(struct akgl_program *program);
  *  - maxtile: Point sprites with all the bells and whistles.
  *  - textile: Axis-aligned 1:2 point sprites tuned for text.
  * You are of course free to add custom programs, but these six should cover everything I want to do.
+ *
+ * The tile programs can also draw from an atlas: a square texture holding (pagecolc*pagecolc) tilesheets of equal size,
+ * LRTB, and each vertex's (page) says which one. With (pagecolc) 1 it's a plain tilesheet and (page) is ignored.
  *****************************************************************************/
 
 struct akgl_vtx_raw {
@@ -159,10 +176,11 @@ int akgl_program_tex_draw(struct akgl_program *program,struct akgl_texture *text
 struct akgl_vtx_mintile {
   int16_t x,y;
   uint8_t tileid;
+  uint8_t page; // Tilesheet within an atlas.
 };
 
 struct akgl_program *akgl_program_mintile_new();
-int akgl_program_mintile_draw(struct akgl_program *program,struct akgl_texture *texture,const struct akgl_vtx_mintile *vtxv,int vtxc,int size);
+int akgl_program_mintile_draw(struct akgl_program *program,struct akgl_texture *texture,const struct akgl_vtx_mintile *vtxv,int vtxc,int size,int pagecolc);
 
 struct akgl_vtx_maxtile {
   int16_t x,y;
@@ -173,10 +191,11 @@ struct akgl_vtx_maxtile {
   uint8_t a; // Alpha multiplier.
   uint8_t t; // Rotation clockwise in (0..255)
   uint8_t xform; // Axis transform; See constants above.
+  uint8_t page; // Tilesheet within an atlas.
 };
 
 struct akgl_program *akgl_program_maxtile_new();
-int akgl_program_maxtile_draw(struct akgl_program *program,struct akgl_texture *texture,const struct akgl_vtx_maxtile *vtxv,int vtxc);
+int akgl_program_maxtile_draw(struct akgl_program *program,struct akgl_texture *texture,const struct akgl_vtx_maxtile *vtxv,int vtxc,int pagecolc);
 
 struct akgl_vtx_textile {
   int16_t x,y;
@@ -33,6 +33,10 @@ void akgl_log_command_count() {
   akgl.cmdc=0;
 }
 
+int akgl_get_command_count() {
+  return akgl.cmdc;
+}
+
 /* Init.
  */
 
@@ -65,6 +69,8 @@ int akgl_init(int strategy) {
           return -1;
         #endif
       } break;
+
+    case AKGL_STRATEGY_HEADLESS: break;
       
     default: akgl.init=0; return -1;
   }
@@ -74,6 +80,12 @@ int akgl_init(int strategy) {
   akgl.screenh=480;
   akgl.glsl_version=120;
 
+  if (strategy==AKGL_STRATEGY_HEADLESS) {
+    // Nothing will ever be transferred to a screen, so the rest is just the soft compositor.
+    akgl.strategy=AKGL_STRATEGY_SOFT;
+    return 0;
+  }
+
   #ifdef GL_POINT_SPRITE
     glEnable(GL_POINT_SPRITE);
   #endif
@@ -86,6 +98,7 @@ int akgl_init(int strategy) {
 
 void akgl_quit() {
   akgl_framebuffer_del(akgl.framebuffer);
+  akgl_vbo_quit();
   if (akgl.soft_fbtexid) glDeleteTextures(1,&akgl.soft_fbtexid);
   memset(&akgl,0,sizeof(struct akgl));
 }
@@ -8,6 +8,7 @@
 #include <stdlib.h>
 #include <limits.h>
 #include <string.h>
+#include <stddef.h>
 
 #if PS_ARCH==PS_ARCH_macos
   #include <OpenGL/gl.h>
@@ -55,6 +56,7 @@ struct akgl_program {
   GLuint programid;
   GLuint location_screensize;
   GLuint location_tilesize;
+  GLint location_pagecolc;
   char *error_log;
   int error_logc;
 };
@@ -68,8 +70,21 @@ extern struct akgl {
   GLuint soft_fbtexid;
   int cmdc;
   int cmdc_logged;
+  GLuint vboid;
+  int vboa,vbop; // Capacity and next free byte, see akgl_vbo_upload().
+  int vbo_enabled;
 } akgl;
 
 void akgl_set_uniform_screen_size(GLuint location);
 
+/* Stream (srcc) bytes of vertices for the next draw, and set (*base) to what glVertexAttribPointer wants for the first.
+ * That's an offset into our buffer object, which is left bound, or (src) itself if we're using client-side arrays.
+ * Call akgl_vbo_release() after the draw.
+ * AKGL_VTX_ATTR() resolves a vertex field against (base).
+ */
+int akgl_vbo_upload(const void **base,const void *src,int srcc);
+void akgl_vbo_release();
+void akgl_vbo_quit();
+#define AKGL_VTX_ATTR(base,type,field) ((const char*)(base)+offsetof(type,field))
+
 #endif
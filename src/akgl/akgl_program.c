@@ -194,6 +194,7 @@ int akgl_program_compile(
   
   program->location_screensize=glGetUniformLocation(program->programid,"screensize");
   program->location_tilesize=glGetUniformLocation(program->programid,"tilesize");
+  program->location_pagecolc=glGetUniformLocation(program->programid,"pagecolc");
 
   return 0;
 }
@@ -90,11 +90,14 @@ int akgl_program_fbxfer_draw(struct akgl_program *program,struct akgl_framebuffe
     {x+w,y+h,1,0},
   };
 
+  const void *base;
+  if (akgl_vbo_upload(&base,vtxv,sizeof(struct akgl_vtx_fbxfer)*4)<0) return -1;
   glEnableVertexAttribArray(0);
   glEnableVertexAttribArray(1);
-  glVertexAttribPointer(0,2,GL_SHORT,0,sizeof(struct akgl_vtx_fbxfer),&vtxv[0].x);
-  glVertexAttribPointer(1,2,GL_UNSIGNED_BYTE,0,sizeof(struct akgl_vtx_fbxfer),&vtxv[0].tx);
+  glVertexAttribPointer(0,2,GL_SHORT,0,sizeof(struct akgl_vtx_fbxfer),AKGL_VTX_ATTR(base,struct akgl_vtx_fbxfer,x));
+  glVertexAttribPointer(1,2,GL_UNSIGNED_BYTE,0,sizeof(struct akgl_vtx_fbxfer),AKGL_VTX_ATTR(base,struct akgl_vtx_fbxfer,tx));
   glDrawArrays(GL_TRIANGLE_STRIP,0,4);
+  akgl_vbo_release();
   glDisableVertexAttribArray(0);
   glDisableVertexAttribArray(1);
 
@@ -4,8 +4,8 @@
 
 struct akgl_program *akgl_program_maxtile_new() { return 0; }
 
-int akgl_program_maxtile_draw(struct akgl_program *program,struct akgl_texture *texture,const struct akgl_vtx_maxtile *vtxv,int vtxc) {
-  return akgl_soft_maxtile_draw(texture,vtxv,vtxc);
+int akgl_program_maxtile_draw(struct akgl_program *program,struct akgl_texture *texture,const struct akgl_vtx_maxtile *vtxv,int vtxc,int pagecolc) {
+  return akgl_soft_maxtile_draw(texture,vtxv,vtxc,pagecolc);
 }
 
 #else
@@ -15,6 +15,7 @@ int akgl_program_maxtile_draw(struct akgl_program *program,struct akgl_texture *
 
 static const char akgl_vsrc_maxtile[]=
   "uniform vec2 screensize;\n"
+  "uniform float pagecolc;\n"
   "attribute vec2 position;\n"
   "attribute float tile;\n"
   "attribute float size;\n"
@@ -22,6 +23,7 @@ static const char akgl_vsrc_maxtile[]=
   "attribute vec4 primary;\n"
   "attribute float rotation;\n"
   "attribute float xform;\n"
+  "attribute float page;\n"
   "varying vec2 vtexoffset;\n"
   "varying vec4 vtint;\n"
   "varying vec4 vprimary;\n"
@@ -50,6 +52,7 @@ static const char akgl_vsrc_maxtile[]=
     
     "gl_Position=vec4(adjposition,0.0,1.0);\n"
     "vtexoffset=vec2(floor(mod(tile+0.5,16.0)),floor((tile+0.5)/16.0))/16.0;\n"
+    "vtexoffset=(vtexoffset+vec2(floor(mod(page+0.5,pagecolc)),floor((page+0.5)/pagecolc)))/pagecolc;\n"
     "vtint=tint;\n"
     "vprimary=primary;\n"
 
@@ -69,6 +72,7 @@ static const char akgl_vsrc_maxtile[]=
 
 static const char akgl_fsrc_maxtile[]=
   "uniform vec2 screensize;\n"
+  "uniform float pagecolc;\n"
   "uniform sampler2D sampler;\n"
   "varying vec2 vtexoffset;\n"
   "varying vec4 vtint;\n"
@@ -129,7 +133,7 @@ static const char akgl_fsrc_maxtile[]=
     "if (texcoord.y>=1.0) discard;\n"
 
     /* Read color from texture. */
-    "texcoord=texcoord/16.0+vtexoffset;\n"
+    "texcoord=texcoord/(16.0*pagecolc)+vtexoffset;\n"
     "vec4 color=texture2D(sampler,texcoord);\n"
 
     /* Apply master alpha. */
@@ -182,15 +186,16 @@ struct akgl_program *akgl_program_maxtile_new() {
 /* Draw.
  */
  
-int akgl_program_maxtile_draw(struct akgl_program *program,struct akgl_texture *texture,const struct akgl_vtx_maxtile *vtxv,int vtxc) {
+int akgl_program_maxtile_draw(struct akgl_program *program,struct akgl_texture *texture,const struct akgl_vtx_maxtile *vtxv,int vtxc,int pagecolc) {
 
   if (akgl.strategy==AKGL_STRATEGY_SOFT) {
-    return akgl_soft_maxtile_draw(texture,vtxv,vtxc);
+    return akgl_soft_maxtile_draw(texture,vtxv,vtxc,pagecolc);
   }
 
   if (!program||!texture) return -1;
   if (vtxc<1) return 0;
   if (!vtxv) return -1;
+  if (pagecolc<1) return -1;
   
   if (akgl_program_use(program)<0) return -1;
   #if PS_ARCH!=PS_ARCH_raspi
@@ -204,6 +209,8 @@ int akgl_program_maxtile_draw(struct akgl_program *program,struct akgl_texture *
     glEnable(GL_POINT_SPRITE);
   #endif
 
+  const void *base;
+  if (akgl_vbo_upload(&base,vtxv,sizeof(struct akgl_vtx_maxtile)*vtxc)<0) return -1;
   glEnableVertexAttribArray(0);
   glEnableVertexAttribArray(1);
   glEnableVertexAttribArray(2);
@@ -211,14 +218,23 @@ int akgl_program_maxtile_draw(struct akgl_program *program,struct akgl_texture *
   glEnableVertexAttribArray(4);
   glEnableVertexAttribArray(5);
   glEnableVertexAttribArray(6);
-  glVertexAttribPointer(0,2,GL_SHORT,0,sizeof(struct akgl_vtx_maxtile),&vtxv[0].x);
-  glVertexAttribPointer(1,1,GL_UNSIGNED_BYTE,0,sizeof(struct akgl_vtx_maxtile),&vtxv[0].tileid);
-  glVertexAttribPointer(2,1,GL_UNSIGNED_BYTE,0,sizeof(struct akgl_vtx_maxtile),&vtxv[0].size);
-  glVertexAttribPointer(3,4,GL_UNSIGNED_BYTE,1,sizeof(struct akgl_vtx_maxtile),&vtxv[0].tr);
-  glVertexAttribPointer(4,4,GL_UNSIGNED_BYTE,1,sizeof(struct akgl_vtx_maxtile),&vtxv[0].pr);
-  glVertexAttribPointer(5,1,GL_UNSIGNED_BYTE,1,sizeof(struct akgl_vtx_maxtile),&vtxv[0].t);
-  glVertexAttribPointer(6,1,GL_UNSIGNED_BYTE,0,sizeof(struct akgl_vtx_maxtile),&vtxv[0].xform);
+  glVertexAttribPointer(0,2,GL_SHORT,0,sizeof(struct akgl_vtx_maxtile),AKGL_VTX_ATTR(base,struct akgl_vtx_maxtile,x));
+  glVertexAttribPointer(1,1,GL_UNSIGNED_BYTE,0,sizeof(struct akgl_vtx_maxtile),AKGL_VTX_ATTR(base,struct akgl_vtx_maxtile,tileid));
+  glVertexAttribPointer(2,1,GL_UNSIGNED_BYTE,0,sizeof(struct akgl_vtx_maxtile),AKGL_VTX_ATTR(base,struct akgl_vtx_maxtile,size));
+  glVertexAttribPointer(3,4,GL_UNSIGNED_BYTE,1,sizeof(struct akgl_vtx_maxtile),AKGL_VTX_ATTR(base,struct akgl_vtx_maxtile,tr));
+  glVertexAttribPointer(4,4,GL_UNSIGNED_BYTE,1,sizeof(struct akgl_vtx_maxtile),AKGL_VTX_ATTR(base,struct akgl_vtx_maxtile,pr));
+  glVertexAttribPointer(5,1,GL_UNSIGNED_BYTE,1,sizeof(struct akgl_vtx_maxtile),AKGL_VTX_ATTR(base,struct akgl_vtx_maxtile,t));
+  glVertexAttribPointer(6,1,GL_UNSIGNED_BYTE,0,sizeof(struct akgl_vtx_maxtile),AKGL_VTX_ATTR(base,struct akgl_vtx_maxtile,xform));
+  /* Plain tilesheets might not bother setting (page), so hold it at zero. */
+  glUniform1f(program->location_pagecolc,pagecolc);
+  if (pagecolc>1) {
+    glEnableVertexAttribArray(7);
+    glVertexAttribPointer(7,1,GL_UNSIGNED_BYTE,0,sizeof(struct akgl_vtx_maxtile),AKGL_VTX_ATTR(base,struct akgl_vtx_maxtile,page));
+  } else {
+    glVertexAttrib1f(7,0.0f);
+  }
   glDrawArrays(GL_POINTS,0,vtxc);
+  akgl_vbo_release();
   glDisableVertexAttribArray(0);
   glDisableVertexAttribArray(1);
   glDisableVertexAttribArray(2);
@@ -226,6 +242,7 @@ int akgl_program_maxtile_draw(struct akgl_program *program,struct akgl_texture *
   glDisableVertexAttribArray(4);
   glDisableVertexAttribArray(5);
   glDisableVertexAttribArray(6);
+  glDisableVertexAttribArray(7);
 
   akgl.cmdc++;
 
@@ -4,8 +4,8 @@
 
 struct akgl_program *akgl_program_mintile_new() { return 0; }
 
-int akgl_program_mintile_draw(struct akgl_program *program,struct akgl_texture *texture,const struct akgl_vtx_mintile *vtxv,int vtxc,int size) {
-  return akgl_soft_mintile_draw(texture,vtxv,vtxc,size);
+int akgl_program_mintile_draw(struct akgl_program *program,struct akgl_texture *texture,const struct akgl_vtx_mintile *vtxv,int vtxc,int size,int pagecolc) {
+  return akgl_soft_mintile_draw(texture,vtxv,vtxc,size,pagecolc);
 }
 
 #else
@@ -15,25 +15,29 @@ int akgl_program_mintile_draw(struct akgl_program *program,struct akgl_texture *
 
 static const char akgl_vsrc_mintile[]=
   "uniform vec2 screensize;\n"
+  "uniform float pagecolc;\n"
   "attribute vec2 position;\n"
   "attribute float tile;\n"
+  "attribute float page;\n"
   "varying vec2 vtexoffset;\n"
   "void main() {\n"
     "vec2 adjposition=(position*2.0)/screensize-1.0;\n"
     "adjposition.y=-adjposition.y;\n"
     "gl_Position=vec4(adjposition,0.0,1.0);\n"
     "vtexoffset=vec2(floor(mod(tile+0.5,16.0)),floor((tile+0.5)/16.0))/16.0;\n"
+    "vtexoffset=(vtexoffset+vec2(floor(mod(page+0.5,pagecolc)),floor((page+0.5)/pagecolc)))/pagecolc;\n"
     "gl_PointSize=16.0;\n"
   "}\n"
 "";
 
 static const char akgl_fsrc_mintile[]=
   "uniform vec2 screensize;\n"
+  "uniform float pagecolc;\n"
   "uniform sampler2D sampler;\n"
   "varying vec2 vtexoffset;\n"
   "void main() {\n"
     "vec2 texcoord=gl_PointCoord;\n"
-    "texcoord=texcoord/16.0+vtexoffset;\n"
+    "texcoord=texcoord/(16.0*pagecolc)+vtexoffset;\n"
     "gl_FragColor=texture2D(sampler,texcoord);\n"
   "}\n"
 "";
@@ -65,16 +69,17 @@ struct akgl_program *akgl_program_mintile_new() {
 /* Draw.
  */
  
-int akgl_program_mintile_draw(struct akgl_program *program,struct akgl_texture *texture,const struct akgl_vtx_mintile *vtxv,int vtxc,int size) {
+int akgl_program_mintile_draw(struct akgl_program *program,struct akgl_texture *texture,const struct akgl_vtx_mintile *vtxv,int vtxc,int size,int pagecolc) {
 
   if (akgl.strategy==AKGL_STRATEGY_SOFT) {
-    return akgl_soft_mintile_draw(texture,vtxv,vtxc,size);
+    return akgl_soft_mintile_draw(texture,vtxv,vtxc,size,pagecolc);
   }
 
   if (!program||!texture) return -1;
   if (vtxc<1) return 0;
   if (!vtxv) return -1;
   if (size<1) return 0;
+  if (pagecolc<1) return -1;
 
   //ps_log(VIDEO,DEBUG,"%s texid=%d vtxc=%d",__func__,texture->texid,vtxc);
 
@@ -95,13 +100,25 @@ int akgl_program_mintile_draw(struct akgl_program *program,struct akgl_texture *
     return -1;
   }
 
+  /* Plain tilesheets might not bother setting (page), so hold it at zero. */
+  glUniform1f(program->location_pagecolc,pagecolc);
+  const void *base;
+  if (akgl_vbo_upload(&base,vtxv,sizeof(struct akgl_vtx_mintile)*vtxc)<0) return -1;
   glEnableVertexAttribArray(0);
   glEnableVertexAttribArray(1);
-  glVertexAttribPointer(0,2,GL_SHORT,0,sizeof(struct akgl_vtx_mintile),&vtxv[0].x);
-  glVertexAttribPointer(1,1,GL_UNSIGNED_BYTE,0,sizeof(struct akgl_vtx_mintile),&vtxv[0].tileid);
+  glVertexAttribPointer(0,2,GL_SHORT,0,sizeof(struct akgl_vtx_mintile),AKGL_VTX_ATTR(base,struct akgl_vtx_mintile,x));
+  glVertexAttribPointer(1,1,GL_UNSIGNED_BYTE,0,sizeof(struct akgl_vtx_mintile),AKGL_VTX_ATTR(base,struct akgl_vtx_mintile,tileid));
+  if (pagecolc>1) {
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2,1,GL_UNSIGNED_BYTE,0,sizeof(struct akgl_vtx_mintile),AKGL_VTX_ATTR(base,struct akgl_vtx_mintile,page));
+  } else {
+    glVertexAttrib1f(2,0.0f);
+  }
   glDrawArrays(GL_POINTS,0,vtxc);
+  akgl_vbo_release();
   glDisableVertexAttribArray(0);
   glDisableVertexAttribArray(1);
+  glDisableVertexAttribArray(2);
 
   akgl.cmdc++;
 
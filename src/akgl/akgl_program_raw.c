@@ -73,11 +73,14 @@ static int akgl_program_raw_draw_primitives(struct akgl_program *program,const s
   if (akgl_program_use(program)<0) return -1;
   if (akgl_texture_use(0)<0) return -1;
   
+  const void *base;
+  if (akgl_vbo_upload(&base,vtxv,sizeof(struct akgl_vtx_raw)*vtxc)<0) return -1;
   glEnableVertexAttribArray(0);
   glEnableVertexAttribArray(1);
-  glVertexAttribPointer(0,2,GL_SHORT,0,sizeof(struct akgl_vtx_raw),&vtxv[0].x);
-  glVertexAttribPointer(1,4,GL_UNSIGNED_BYTE,1,sizeof(struct akgl_vtx_raw),&vtxv[0].r);
+  glVertexAttribPointer(0,2,GL_SHORT,0,sizeof(struct akgl_vtx_raw),AKGL_VTX_ATTR(base,struct akgl_vtx_raw,x));
+  glVertexAttribPointer(1,4,GL_UNSIGNED_BYTE,1,sizeof(struct akgl_vtx_raw),AKGL_VTX_ATTR(base,struct akgl_vtx_raw,r));
   glDrawArrays(type,0,vtxc);
+  akgl_vbo_release();
   glDisableVertexAttribArray(0);
   glDisableVertexAttribArray(1);
 
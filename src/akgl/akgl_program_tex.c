@@ -78,11 +78,14 @@ int akgl_program_tex_draw(struct akgl_program *program,struct akgl_texture *text
   #endif
   glBindTexture(GL_TEXTURE_2D,texture->texid);
 
+  const void *base;
+  if (akgl_vbo_upload(&base,vtxv,sizeof(struct akgl_vtx_tex)*vtxc)<0) return -1;
   glEnableVertexAttribArray(0);
   glEnableVertexAttribArray(1);
-  glVertexAttribPointer(0,2,GL_SHORT,0,sizeof(struct akgl_vtx_tex),&vtxv[0].x);
-  glVertexAttribPointer(1,2,GL_UNSIGNED_BYTE,0,sizeof(struct akgl_vtx_tex),&vtxv[0].tx);
+  glVertexAttribPointer(0,2,GL_SHORT,0,sizeof(struct akgl_vtx_tex),AKGL_VTX_ATTR(base,struct akgl_vtx_tex,x));
+  glVertexAttribPointer(1,2,GL_UNSIGNED_BYTE,0,sizeof(struct akgl_vtx_tex),AKGL_VTX_ATTR(base,struct akgl_vtx_tex,tx));
   glDrawArrays(GL_TRIANGLE_STRIP,0,vtxc);
+  akgl_vbo_release();
   glDisableVertexAttribArray(0);
   glDisableVertexAttribArray(1);
 
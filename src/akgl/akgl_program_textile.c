@@ -93,15 +93,18 @@ int akgl_program_textile_draw(struct akgl_program *program,struct akgl_texture *
     glEnable(GL_PROGRAM_POINT_SIZE);
   #endif
 
+  const void *base;
+  if (akgl_vbo_upload(&base,vtxv,sizeof(struct akgl_vtx_textile)*vtxc)<0) return -1;
   glEnableVertexAttribArray(0);
   glEnableVertexAttribArray(1);
   glEnableVertexAttribArray(2);
   glEnableVertexAttribArray(3);
-  glVertexAttribPointer(0,2,GL_SHORT,0,sizeof(struct akgl_vtx_textile),&vtxv[0].x);
-  glVertexAttribPointer(1,1,GL_UNSIGNED_BYTE,0,sizeof(struct akgl_vtx_textile),&vtxv[0].tileid);
-  glVertexAttribPointer(2,4,GL_UNSIGNED_BYTE,1,sizeof(struct akgl_vtx_textile),&vtxv[0].r);
-  glVertexAttribPointer(3,1,GL_UNSIGNED_BYTE,0,sizeof(struct akgl_vtx_textile),&vtxv[0].size);
+  glVertexAttribPointer(0,2,GL_SHORT,0,sizeof(struct akgl_vtx_textile),AKGL_VTX_ATTR(base,struct akgl_vtx_textile,x));
+  glVertexAttribPointer(1,1,GL_UNSIGNED_BYTE,0,sizeof(struct akgl_vtx_textile),AKGL_VTX_ATTR(base,struct akgl_vtx_textile,tileid));
+  glVertexAttribPointer(2,4,GL_UNSIGNED_BYTE,1,sizeof(struct akgl_vtx_textile),AKGL_VTX_ATTR(base,struct akgl_vtx_textile,r));
+  glVertexAttribPointer(3,1,GL_UNSIGNED_BYTE,0,sizeof(struct akgl_vtx_textile),AKGL_VTX_ATTR(base,struct akgl_vtx_textile,size));
   glDrawArrays(GL_POINTS,0,vtxc);
+  akgl_vbo_release();
   glDisableVertexAttribArray(0);
   glDisableVertexAttribArray(1);
   glDisableVertexAttribArray(2);
@@ -0,0 +1,109 @@
+#include "akgl_internal.h"
+
+/* Buffer grows to fit the largest single draw, in powers of two from here.
+ * Uploads are aligned for the sake of GLES.
+ */
+#define AKGL_VBO_MIN_SIZE (64<<10)
+#define AKGL_VBO_ALIGN 16
+
+#if PS_NO_OPENGL2
+
+void akgl_set_vbo_enabled(int enable) {}
+
+int akgl_vbo_upload(const void **base,const void *src,int srcc) {
+  *base=src;
+  return 0;
+}
+
+void akgl_vbo_release() {}
+void akgl_vbo_quit() {}
+
+#else
+
+/* Enable or disable.
+ */
+
+void akgl_set_vbo_enabled(int enable) {
+  akgl.vbo_enabled=enable?1:0;
+}
+
+/* Delete buffer.
+ */
+
+void akgl_vbo_quit() {
+  if (akgl.vboid) {
+    glBindBuffer(GL_ARRAY_BUFFER,0);
+    glDeleteBuffers(1,&akgl.vboid);
+    akgl.vboid=0;
+  }
+  akgl.vboa=0;
+  akgl.vbop=0;
+}
+
+/* Give up on the buffer and use client-side arrays from now on.
+ */
+
+static void akgl_vbo_fail(const char *what) {
+  ps_log(VIDEO,WARN,"Failed to %s vertex buffer. Falling back to client-side arrays.",what);
+  akgl_vbo_quit();
+  akgl.vbo_enabled=0;
+}
+
+/* Replace the buffer's storage, at least (size) bytes.
+ * The driver keeps the old storage alive for draws still in flight, so we never wait on the GPU.
+ * This is the only place we check for errors: glGetError() makes threaded drivers sync, so not on every upload.
+ */
+
+static int akgl_vbo_orphan(int size) {
+  int nsize=(akgl.vboa>AKGL_VBO_MIN_SIZE)?akgl.vboa:AKGL_VBO_MIN_SIZE;
+  while (nsize<size) {
+    if (nsize>INT_MAX>>1) return -1;
+    nsize<<=1;
+  }
+  glBufferData(GL_ARRAY_BUFFER,nsize,0,GL_STREAM_DRAW);
+  if (akgl_clear_error()) return -1;
+  akgl.vboa=nsize;
+  akgl.vbop=0;
+  return 0;
+}
+
+/* Upload vertices.
+ */
+
+int akgl_vbo_upload(const void **base,const void *src,int srcc) {
+  *base=src;
+  if (!akgl.vbo_enabled||(akgl.strategy!=AKGL_STRATEGY_GL2)) return 0;
+  if (!src||(srcc<1)) return -1;
+
+  if (!akgl.vboid) {
+    glGenBuffers(1,&akgl.vboid);
+    if (!akgl.vboid) {
+      akgl_vbo_fail("create");
+      return 0;
+    }
+  }
+  glBindBuffer(GL_ARRAY_BUFFER,akgl.vboid);
+
+  /* Ring: Append until full, then orphan and start over. */
+  if (akgl.vbop>akgl.vboa-srcc) {
+    if (akgl_vbo_orphan(srcc)<0) {
+      akgl_vbo_fail("allocate");
+      return 0;
+    }
+  }
+
+  glBufferSubData(GL_ARRAY_BUFFER,akgl.vbop,srcc,src);
+  *base=(const void*)(uintptr_t)akgl.vbop;
+  akgl.vbop+=(srcc+AKGL_VBO_ALIGN-1)&~(AKGL_VBO_ALIGN-1);
+  if (akgl.vbop>akgl.vboa) akgl.vbop=akgl.vboa;
+  return 0;
+}
+
+/* Unbind after drawing, so nobody else's client-side arrays get read as offsets.
+ */
+
+void akgl_vbo_release() {
+  if (akgl.vboid) glBindBuffer(GL_ARRAY_BUFFER,0);
+}
+
+#endif
@@ -13,8 +13,8 @@ struct ps_sdraw_image;
  */
 int akgl_soft_fbxfer_draw(struct ps_sdraw_image *fb,int x,int y,int w,int h);
 
-int akgl_soft_maxtile_draw(struct akgl_texture *texture,const struct akgl_vtx_maxtile *vtxv,int vtxc);
-int akgl_soft_mintile_draw(struct akgl_texture *texture,const struct akgl_vtx_mintile *vtxv,int vtxc,int size);
+int akgl_soft_maxtile_draw(struct akgl_texture *texture,const struct akgl_vtx_maxtile *vtxv,int vtxc,int pagecolc);
+int akgl_soft_mintile_draw(struct akgl_texture *texture,const struct akgl_vtx_mintile *vtxv,int vtxc,int size,int pagecolc);
 
 // XXX Decide whether we actually want 1:1 correspondence with the akgl interface.
 // In any case, ps_video_draw will use ps_sdraw directly where warranted.
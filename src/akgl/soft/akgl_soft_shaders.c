@@ -45,41 +45,64 @@ int akgl_soft_fbxfer_draw(struct ps_sdraw_image *src,int x,int y,int w,int h) {
   return 0;
 }
 
+/* View one page of an atlas as its own image, sharing the pixels.
+ * Never delete or reallocate the view.
+ */
+
+static int akgl_soft_atlas_page(struct ps_sdraw_image *page,const struct ps_sdraw_image *atlas,int pagecolc,int pageid) {
+  int col=pageid%pagecolc,row=pageid/pagecolc;
+  if (row>=pagecolc) return -1;
+  memcpy(page,atlas,sizeof(struct ps_sdraw_image));
+  page->refc=0;
+  page->w=atlas->w/pagecolc;
+  page->h=atlas->h/pagecolc;
+  page->pixels=atlas->pixels+row*page->h*atlas->rowstride+col*page->w*atlas->colstride;
+  return 0;
+}
+
 /* maxtile
  */
  
-int akgl_soft_maxtile_draw(struct akgl_texture *texture,const struct akgl_vtx_maxtile *vtxv,int vtxc) {
+int akgl_soft_maxtile_draw(struct akgl_texture *texture,const struct akgl_vtx_maxtile *vtxv,int vtxc,int pagecolc) {
   if (vtxc<1) return 0;
   if (!texture||!vtxv) return -1;
+  if (pagecolc<1) return -1;
   if (akgl.strategy!=AKGL_STRATEGY_SOFT) return -1;
   if (!akgl.framebuffer) return -1;
   struct ps_sdraw_image *src=(struct ps_sdraw_image*)texture;
   struct ps_sdraw_image *dst=(struct ps_sdraw_image*)akgl.framebuffer;
-
-  int srccolw=src->w>>4;
-  int srcrowh=src->h>>4;
-
-  for (;vtxc--;vtxv++) {
-    if (ps_sdraw_blit_maxtile(dst,vtxv,src)<0) return -1;
+  akgl.cmdc++;
+  if (pagecolc==1) return ps_sdraw_blit_maxtiles(dst,vtxv,vtxc,src);
+
+  /* Atlas: One batch for each run of vertices on the same page. */
+  while (vtxc>0) {
+    int runc=1;
+    while ((runc<vtxc)&&(vtxv[runc].page==vtxv[0].page)) runc++;
+    struct ps_sdraw_image page;
+    if (akgl_soft_atlas_page(&page,src,pagecolc,vtxv[0].page)<0) return -1;
+    if (ps_sdraw_blit_maxtiles(dst,vtxv,runc,&page)<0) return -1;
+    vtxv+=runc;
+    vtxc-=runc;
   }
-
   return 0;
 }
 
 /* mintile
  */
 
-int akgl_soft_mintile_draw(struct akgl_texture *texture,const struct akgl_vtx_mintile *vtxv,int vtxc,int size) {
+int akgl_soft_mintile_draw(struct akgl_texture *texture,const struct akgl_vtx_mintile *vtxv,int vtxc,int size,int pagecolc) {
   if (vtxc<1) return 0;
   if (size<1) return 0;
   if (!texture||!vtxv) return -1;
+  if (pagecolc<1) return -1;
   if (akgl.strategy!=AKGL_STRATEGY_SOFT) return -1;
   if (!akgl.framebuffer) return -1;
   struct ps_sdraw_image *src=(struct ps_sdraw_image*)texture;
   struct ps_sdraw_image *dst=(struct ps_sdraw_image*)akgl.framebuffer;
+  akgl.cmdc++;
 
-  int srccolw=src->w>>4;
-  int srcrowh=src->h>>4;
+  int srccolw=src->w/(pagecolc<<4);
+  int srcrowh=src->h/(pagecolc<<4);
   int halfsize=size>>1;
 
   for (;vtxc-->0;vtxv++) {
@@ -87,6 +110,11 @@ int akgl_soft_mintile_draw(struct akgl_texture *texture,const struct akgl_vtx_mi
     int dsty=vtxv->y-halfsize;
     int srcx=(vtxv->tileid&0x0f)*srccolw;
     int srcy=(vtxv->tileid>>4)*srcrowh;
+    if (pagecolc>1) {
+      srcx+=(vtxv->page%pagecolc)*(srccolw<<4);
+      srcy+=(vtxv->page/pagecolc)*(srcrowh<<4);
+      if (srcy>=src->h) return -1;
+    }
     if (ps_sdraw_blit(dst,dstx,dsty,size,size,src,srcx,srcy,srccolw,srcrowh)<0) return -1;
   }
 
@@ -100,6 +128,7 @@ int akgl_soft_raw_draw_line_strip(const struct akgl_vtx_raw *vtxv,int vtxc,int w
   if (akgl.strategy!=AKGL_STRATEGY_SOFT) return -1;
   if (!akgl.framebuffer) return -1;
   struct ps_sdraw_image *dst=(struct ps_sdraw_image*)akgl.framebuffer;
+  akgl.cmdc++;
   
   if (width!=1) {
     ps_log(VIDEO,ERROR,"Line width %d not supported.",width);
@@ -146,6 +175,7 @@ int akgl_soft_textile_draw(struct akgl_texture *tex,const struct akgl_vtx_textil
   if (!akgl.framebuffer) return -1;
   struct ps_sdraw_image *src=(struct ps_sdraw_image*)tex;
   struct ps_sdraw_image *dst=(struct ps_sdraw_image*)akgl.framebuffer;
+  akgl.cmdc++;
 
   int srccolw=src->w>>4;
   int srcrowh=src->h>>4;
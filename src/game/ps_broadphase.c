@@ -0,0 +1,279 @@
+#include "ps.h"
+#include "ps_broadphase.h"
+#include "ps_sprite.h"
+#include <math.h>
+
+/* Object lifecycle.
+ */
+
+struct ps_broadphase *ps_broadphase_new() {
+  struct ps_broadphase *broadphase=calloc(1,sizeof(struct ps_broadphase));
+  if (!broadphase) return 0;
+  return broadphase;
+}
+
+void ps_broadphase_del(struct ps_broadphase *broadphase) {
+  if (!broadphase) return;
+  if (broadphase->entryv) free(broadphase->entryv);
+  if (broadphase->cellv) free(broadphase->cellv);
+  if (broadphase->pairv) free(broadphase->pairv);
+  if (broadphase->neighborv) free(broadphase->neighborv);
+  free(broadphase);
+}
+
+/* Convert a pixel position to a clamped cell index.
+ */
+
+static inline uint8_t ps_broadphase_col(double x) {
+  double col=floor(x/PS_TILESIZE)+PS_BROADPHASE_MARGIN;
+  if (col<0.0) return 0;
+  if (col>=PS_BROADPHASE_COLC) return PS_BROADPHASE_COLC-1;
+  if (col!=col) return 0;
+  return (uint8_t)col;
+}
+
+static inline uint8_t ps_broadphase_row(double y) {
+  double row=floor(y/PS_TILESIZE)+PS_BROADPHASE_MARGIN;
+  if (row<0.0) return 0;
+  if (row>=PS_BROADPHASE_ROWC) return PS_BROADPHASE_ROWC-1;
+  if (row!=row) return 0;
+  return (uint8_t)row;
+}
+
+/* Grow buffers.
+ */
+
+static int ps_broadphase_require_entries(struct ps_broadphase *broadphase,int c) {
+  if (c<=broadphase->entrya) return 0;
+  int na=(c+64)&~63;
+  if (na>INT_MAX/sizeof(struct ps_broadphase_entry)) return -1;
+  void *nv=realloc(broadphase->entryv,sizeof(struct ps_broadphase_entry)*na);
+  if (!nv) return -1;
+  broadphase->entryv=nv;
+  broadphase->entrya=na;
+  return 0;
+}
+
+static int ps_broadphase_require_cells(struct ps_broadphase *broadphase,int c) {
+  if (c<=broadphase->cella) return 0;
+  int na=(c+256)&~255;
+  if (na>INT_MAX/sizeof(int)) return -1;
+  void *nv=realloc(broadphase->cellv,sizeof(int)*na);
+  if (!nv) return -1;
+  broadphase->cellv=nv;
+  broadphase->cella=na;
+  return 0;
+}
+
+static struct ps_broadphase_pair *ps_broadphase_add_pair(struct ps_broadphase *broadphase) {
+  if (broadphase->pairc>=broadphase->paira) {
+    int na=broadphase->paira+256;
+    if (na>INT_MAX/sizeof(struct ps_broadphase_pair)) return 0;
+    void *nv=realloc(broadphase->pairv,sizeof(struct ps_broadphase_pair)*na);
+    if (!nv) return 0;
+    broadphase->pairv=nv;
+    broadphase->paira=na;
+  }
+  return broadphase->pairv+broadphase->pairc++;
+}
+
+static int ps_broadphase_add_neighbor(struct ps_broadphase *broadphase,int p) {
+  if (broadphase->neighborc>=broadphase->neighbora) {
+    int na=broadphase->neighbora+64;
+    if (na>INT_MAX/sizeof(int)) return -1;
+    void *nv=realloc(broadphase->neighborv,sizeof(int)*na);
+    if (!nv) return -1;
+    broadphase->neighborv=nv;
+    broadphase->neighbora=na;
+  }
+  broadphase->neighborv[broadphase->neighborc++]=p;
+  return 0;
+}
+
+/* Rebuild.
+ * A counting sort: Count entries per cell, then lay them out contiguously.
+ */
+
+int ps_broadphase_rebuild(
+  struct ps_broadphase *broadphase,
+  const struct ps_sprgrp *grp,
+  int (*filter)(const struct ps_sprite *spr)
+) {
+  if (!broadphase) return -1;
+  broadphase->entryc=0;
+  broadphase->cellc=0;
+  broadphase->pairc=0;
+  broadphase->neighborc=0;
+  memset(broadphase->cellstartv,0,sizeof(broadphase->cellstartv));
+  if (!grp||(grp->sprc<1)) return 0;
+  if (ps_broadphase_require_entries(broadphase,grp->sprc)<0) return -1;
+
+  /* Record each sprite's cell range, and count in (cellstartv) how many entries land in each cell. */
+  int i=0; for (;i<grp->sprc;i++) {
+    struct ps_sprite *spr=grp->sprv[i];
+    if (filter&&!filter(spr)) continue;
+    struct ps_broadphase_entry *entry=broadphase->entryv+broadphase->entryc++;
+    entry->spr=spr;
+    entry->sprp=i;
+    entry->cola=ps_broadphase_col(spr->x-spr->radius);
+    entry->colz=ps_broadphase_col(spr->x+spr->radius);
+    entry->rowa=ps_broadphase_row(spr->y-spr->radius);
+    entry->rowz=ps_broadphase_row(spr->y+spr->radius);
+    int row=entry->rowa; for (;row<=entry->rowz;row++) {
+      int *count=broadphase->cellstartv+row*PS_BROADPHASE_COLC+entry->cola;
+      int col=entry->cola; for (;col<=entry->colz;col++,count++) (*count)++;
+    }
+  }
+
+  /* Convert counts to start positions. */
+  int total=0;
+  for (i=0;i<PS_BROADPHASE_CELLC;i++) {
+    int count=broadphase->cellstartv[i];
+    broadphase->cellstartv[i]=total;
+    total+=count;
+  }
+  broadphase->cellstartv[PS_BROADPHASE_CELLC]=total;
+  if (ps_broadphase_require_cells(broadphase,total)<0) return -1;
+  broadphase->cellc=total;
+
+  /* Lay out entries, using each cell's start as a cursor.
+   * After that, each start is where the next cell begins, so shift them all up by one.
+   */
+  const struct ps_broadphase_entry *entry=broadphase->entryv;
+  for (i=0;i<broadphase->entryc;i++,entry++) {
+    int row=entry->rowa; for (;row<=entry->rowz;row++) {
+      int *cursor=broadphase->cellstartv+row*PS_BROADPHASE_COLC+entry->cola;
+      int col=entry->cola; for (;col<=entry->colz;col++,cursor++) {
+        broadphase->cellv[(*cursor)++]=i;
+      }
+    }
+  }
+  memmove(broadphase->cellstartv+1,broadphase->cellstartv,sizeof(int)*PS_BROADPHASE_CELLC);
+  broadphase->cellstartv[0]=0;
+
+  return 0;
+}
+
+/* Find pairs.
+ * A pair sharing several cells is reported only from the first cell of their intersection.
+ */
+
+static int ps_broadphase_paircmp(const void *a,const void *b) {
+  const struct ps_broadphase_pair *A=a,*B=b;
+  if (A->a<B->a) return -1;
+  if (A->a>B->a) return 1;
+  if (A->b<B->b) return -1;
+  if (A->b>B->b) return 1;
+  return 0;
+}
+
+static void ps_broadphase_sort_pairs(struct ps_broadphase *broadphase) {
+  if (broadphase->pairc>1) {
+    qsort(broadphase->pairv,broadphase->pairc,sizeof(struct ps_broadphase_pair),ps_broadphase_paircmp);
+  }
+}
+
+int ps_broadphase_find_pairs(struct ps_broadphase *broadphase) {
+  if (!broadphase) return -1;
+  broadphase->pairc=0;
+  int cellp=0,row=0; for (;row<PS_BROADPHASE_ROWC;row++) {
+    int col=0; for (;col<PS_BROADPHASE_COLC;col++,cellp++) {
+      const int *v=broadphase->cellv+broadphase->cellstartv[cellp];
+      int c=broadphase->cellstartv[cellp+1]-broadphase->cellstartv[cellp];
+      int i=0; for (;i<c;i++) {
+        const struct ps_broadphase_entry *a=broadphase->entryv+v[i];
+        int j=i+1; for (;j<c;j++) {
+          const struct ps_broadphase_entry *b=broadphase->entryv+v[j];
+          if (((a->cola>b->cola)?a->cola:b->cola)!=col) continue;
+          if (((a->rowa>b->rowa)?a->rowa:b->rowa)!=row) continue;
+          struct ps_broadphase_pair *pair=ps_broadphase_add_pair(broadphase);
+          if (!pair) return -1;
+          pair->a=v[i]; // Entries were laid out in order, so (v[i]<v[j]).
+          pair->b=v[j];
+        }
+      }
+    }
+  }
+  ps_broadphase_sort_pairs(broadphase);
+  return broadphase->pairc;
+}
+
+/* Find pairs touching selected entries.
+ * Walk only the cells covered by selected entries.
+ * A pair of two selected entries is reported by the lower one.
+ */
+
+int ps_broadphase_find_pairs_selected(
+  struct ps_broadphase *broadphase,
+  int (*select)(const struct ps_sprite *spr)
+) {
+  if (!broadphase||!select) return -1;
+  broadphase->pairc=0;
+  struct ps_broadphase_entry *entry=broadphase->entryv;
+  int i=broadphase->entryc; for (;i-->0;entry++) {
+    entry->selected=select(entry->spr)?1:0;
+  }
+  entry=broadphase->entryv;
+  for (i=0;i<broadphase->entryc;i++,entry++) {
+    if (!entry->selected) continue;
+    int row=entry->rowa; for (;row<=entry->rowz;row++) {
+      int cellp=row*PS_BROADPHASE_COLC+entry->cola;
+      int col=entry->cola; for (;col<=entry->colz;col++,cellp++) {
+        const int *v=broadphase->cellv+broadphase->cellstartv[cellp];
+        int c=broadphase->cellstartv[cellp+1]-broadphase->cellstartv[cellp];
+        for (;c-->0;v++) {
+          if (*v==i) continue;
+          const struct ps_broadphase_entry *other=broadphase->entryv+*v;
+          if (other->selected&&(*v<i)) continue;
+          if (((entry->cola>other->cola)?entry->cola:other->cola)!=col) continue;
+          if (((entry->rowa>other->rowa)?entry->rowa:other->rowa)!=row) continue;
+          struct ps_broadphase_pair *pair=ps_broadphase_add_pair(broadphase);
+          if (!pair) return -1;
+          if (*v<i) {
+            pair->a=*v;
+            pair->b=i;
+          } else {
+            pair->a=i;
+            pair->b=*v;
+          }
+        }
+      }
+    }
+  }
+  ps_broadphase_sort_pairs(broadphase);
+  return broadphase->pairc;
+}
+
+/* Find neighbors of one sprite.
+ * Same rule as pairs: An entry sharing several cells with the query is reported only from the first.
+ */
+
+static int ps_broadphase_intcmp(const void *a,const void *b) {
+  return *(const int*)a-*(const int*)b;
+}
+
+int ps_broadphase_find_neighbors(struct ps_broadphase *broadphase,const struct ps_sprite *spr) {
+  if (!broadphase||!spr) return -1;
+  broadphase->neighborc=0;
+  uint8_t cola=ps_broadphase_col(spr->x-spr->radius);
+  uint8_t colz=ps_broadphase_col(spr->x+spr->radius);
+  uint8_t rowa=ps_broadphase_row(spr->y-spr->radius);
+  uint8_t rowz=ps_broadphase_row(spr->y+spr->radius);
+  int row=rowa; for (;row<=rowz;row++) {
+    int cellp=row*PS_BROADPHASE_COLC+cola;
+    int col=cola; for (;col<=colz;col++,cellp++) {
+      const int *v=broadphase->cellv+broadphase->cellstartv[cellp];
+      int c=broadphase->cellstartv[cellp+1]-broadphase->cellstartv[cellp];
+      for (;c-->0;v++) {
+        const struct ps_broadphase_entry *entry=broadphase->entryv+*v;
+        if (((entry->cola>cola)?entry->cola:cola)!=col) continue;
+        if (((entry->rowa>rowa)?entry->rowa:rowa)!=row) continue;
+        if (ps_broadphase_add_neighbor(broadphase,*v)<0) return -1;
+      }
+    }
+  }
+  if (broadphase->neighborc>1) {
+    qsort(broadphase->neighborv,broadphase->neighborc,sizeof(int),ps_broadphase_intcmp);
+  }
+  return broadphase->neighborc;
+}
@@ -0,0 +1,78 @@
+/* ps_broadphase.h
+ * Uniform grid of PS_TILESIZE cells, for quickly finding sprites that might touch each other.
+ * We only hold WEAK references; rebuild after anything moves.
+ * Sprites beyond the screen's edge are clamped into a margin of PS_BROADPHASE_MARGIN cells.
+ * That is only a performance concern: far-flung sprites share cells but are never missed.
+ */
+
+#ifndef PS_BROADPHASE_H
+#define PS_BROADPHASE_H
+
+struct ps_sprite;
+struct ps_sprgrp;
+
+#define PS_BROADPHASE_MARGIN 4
+#define PS_BROADPHASE_COLC (PS_GRID_COLC+(PS_BROADPHASE_MARGIN<<1))
+#define PS_BROADPHASE_ROWC (PS_GRID_ROWC+(PS_BROADPHASE_MARGIN<<1))
+#define PS_BROADPHASE_CELLC (PS_BROADPHASE_COLC*PS_BROADPHASE_ROWC)
+
+struct ps_broadphase_entry {
+  struct ps_sprite *spr; // WEAK
+  int sprp; // Index in the source group.
+  uint8_t cola,rowa,colz,rowz; // Covered cells, inclusive.
+  uint8_t selected; // Transient, for ps_broadphase_find_pairs_selected().
+};
+
+/* Indices in (entryv), with (a<b) always.
+ * Entries are in the same order as the source group, so these sort the same way.
+ */
+struct ps_broadphase_pair {
+  int a,b;
+};
+
+struct ps_broadphase {
+  struct ps_broadphase_entry *entryv;
+  int entryc,entrya;
+  int *cellv; // Indices in (entryv), grouped by cell.
+  int cellc,cella;
+  int cellstartv[PS_BROADPHASE_CELLC+1]; // Position in (cellv) of each cell's first entry.
+  struct ps_broadphase_pair *pairv;
+  int pairc,paira;
+  int *neighborv; // Indices in (entryv), from ps_broadphase_find_neighbors().
+  int neighborc,neighbora;
+};
+
+struct ps_broadphase *ps_broadphase_new();
+void ps_broadphase_del(struct ps_broadphase *broadphase);
+
+/* Drop all content and index every sprite in (grp).
+ * If (filter) is provided, only sprites for which it returns nonzero are included.
+ */
+int ps_broadphase_rebuild(
+  struct ps_broadphase *broadphase,
+  const struct ps_sprgrp *grp,
+  int (*filter)(const struct ps_sprite *spr)
+);
+
+/* Populate (pairv) with every pair of entries sharing at least one cell, each pair once.
+ * Pairs are sorted, so visiting them yields the same order as a naive nested loop over the group.
+ * Returns the count of pairs.
+ */
+int ps_broadphase_find_pairs(struct ps_broadphase *broadphase);
+
+/* Same as ps_broadphase_find_pairs(), but only pairs where at least one sprite satisfies (select).
+ * Cost is proportional to the selected sprites and their neighbors, not the whole group.
+ */
+int ps_broadphase_find_pairs_selected(
+  struct ps_broadphase *broadphase,
+  int (*select)(const struct ps_sprite *spr)
+);
+
+/* Populate (neighborv) with every entry sharing at least one cell with (spr), each entry once.
+ * (spr) does not need to be indexed; if it is, it reports itself too.
+ * Neighbors are sorted, ie in the same order as the source group.
+ * Returns the count of neighbors.
+ */
+int ps_broadphase_find_neighbors(struct ps_broadphase *broadphase,const struct ps_sprite *spr);
+
+#endif
@@ -3,6 +3,9 @@
 #include "ps_player.h"
 #include "ps_sprite.h"
 #include "ps_physics.h"
+#include "ps_broadphase.h"
+#include "ps_gridpath.h"
+#include "ps_particles.h"
 #include "ps_plrdef.h"
 #include "ps_stats.h"
 #include "ps_bloodhound_activator.h"
@@ -18,6 +21,7 @@
 #include "game/sprites/ps_sprite_hero.h"
 #include "scenario/ps_scenario.h"
 #include "scenario/ps_scgen.h"
+#include "scenario/ps_scgen_async.h"
 #include "scenario/ps_grid.h"
 #include "scenario/ps_blueprint.h"
 #include "scenario/ps_region.h"
@@ -29,6 +33,8 @@
 #include "input/ps_input.h"
 #include "util/ps_enums.h"
 #include "os/ps_userconfig.h"
+#include "os/ps_clockassist.h"
+#include <math.h>
 
 #define PS_PRIZE_SPRDEF_ID 17
 #define PS_SPLASH_SPRDEF_ID 24
@@ -47,8 +53,12 @@ int ps_game_adjust_sprites_for_grid_changes(struct ps_game *game,const struct ps
  */
 
 static int ps_game_initialize(struct ps_game *game,struct ps_userconfig *userconfig) {
+  int i;
 
   game->grpv[PS_SPRGRP_VISIBLE].order=PS_SPRGRP_ORDER_RENDER;
+  for (i=0;i<PS_SPRGRP_COUNT;i++) game->grpv[i].mask=1<<i;
+
+  ps_prng_init(&game->prng,game->seed);
 
   if (!(game->stats=ps_stats_new())) return -1;
   
@@ -58,6 +68,9 @@ static int ps_game_initialize(struct ps_game *game,struct ps_userconfig *usercon
   if (!(game->physics=ps_physics_new())) return -1;
   if (ps_physics_set_sprgrp_physics(game->physics,game->grpv+PS_SPRGRP_PHYSICS)<0) return -1;
   if (ps_physics_set_sprgrp_solid(game->physics,game->grpv+PS_SPRGRP_SOLID)<0) return -1;
+  if (ps_game_enable_damage_index(game,1)<0) return -1;
+  if (!(game->gridpath=ps_gridpath_new())) return -1;
+  if (!(game->particles=ps_particles_new())) return -1;
     
   if (!(game->bloodhound_activator=ps_bloodhound_activator_new())) return -1;
   if (!(game->dragoncharger=ps_dragoncharger_new())) return -1;
@@ -99,6 +112,10 @@ void ps_game_del(struct ps_game *game) {
   //ps_gamelog_save(game->gamelog);
 
   ps_physics_del(game->physics);
+  ps_gridpath_del(game->gridpath);
+  ps_particles_del(game->particles);
+  ps_broadphase_del(game->damage_index_fragile);
+  ps_broadphase_del(game->damage_index_hero);
   ps_statusreport_del(game->statusreport);
   ps_dragoncharger_del(game->dragoncharger);
   ps_bloodhound_activator_del(game->bloodhound_activator);
@@ -108,6 +125,7 @@ void ps_game_del(struct ps_game *game) {
   //ps_gamelog_del(game->gamelog);
   ps_score_store_del(game->score_store);
 
+  ps_scgen_async_del(game->pregen);
   ps_scenario_del(game->scenario);
   while (game->playerc-->0) ps_player_del(game->playerv[game->playerc]);
   for (i=PS_SPRGRP_COUNT;i-->0;) ps_sprgrp_cleanup(game->grpv+i);
@@ -160,13 +178,13 @@ static int ps_game_list_candidate_positions_for_large_random_sprite(struct ps_pa
 }
  
 static int ps_game_select_position_for_large_random_sprite(
-  int *x,int *y,const struct ps_game *game,const struct ps_sprdef *sprdef
+  int *x,int *y,struct ps_game *game,const struct ps_sprdef *sprdef
 ) {
   int result=-1;
   struct ps_path candidates={0};
   if (ps_game_list_candidate_positions_for_large_random_sprite(&candidates,game)>=0) {
     while (candidates.c>0) {
-      int p=rand()%candidates.c;
+      int p=ps_game_randint(game,candidates.c);
       *x=(candidates.v[p].x+1)*PS_TILESIZE;
       *y=(candidates.v[p].y+1)*PS_TILESIZE;
       if (!ps_game_sprite_position_conflicts_with_others(game,*x,*y,ps_sprdef_fld_get(sprdef,PS_SPRDEF_FLD_radius,0))) {
@@ -197,7 +215,7 @@ static int ps_game_sprite_position_is_barrier(const struct ps_game *game,int x,i
 }
 
 static int ps_game_select_position_for_random_sprite(
-  int *x,int *y,const struct ps_game *game,const struct ps_sprdef *sprdef,int *large_ok
+  int *x,int *y,struct ps_game *game,const struct ps_sprdef *sprdef,int *large_ok
 ) {
 
   if (ps_sprdef_fld_get(sprdef,PS_SPRDEF_FLD_radius,0)>PS_TILESIZE>>1) {
@@ -210,8 +228,8 @@ static int ps_game_select_position_for_random_sprite(
   const int margin=2; // Don't spawn on the edges.
   int attemptc=20;
   while (attemptc-->0) {
-    int col=margin+(rand()%(PS_GRID_COLC-(margin<<1)));
-    int row=margin+(rand()%(PS_GRID_ROWC-(margin<<1)));
+    int col=margin+ps_game_randint(game,PS_GRID_COLC-(margin<<1));
+    int row=margin+ps_game_randint(game,PS_GRID_ROWC-(margin<<1));
     uint8_t physics=game->grid->cellv[row*PS_GRID_COLC+col].physics;
     if (physics!=PS_BLUEPRINT_CELL_VACANT) continue; // Only spawn on vacant cells.
     if (ps_game_sprite_position_is_barrier(game,col,row)) continue; // We don't know whether barriers are open or closed, so skip them all.
@@ -239,12 +257,12 @@ static int ps_game_spawn_random_sprites(struct ps_game *game) {
 
   int monsterc_min=game->grid->monsterc_min;
   int monsterc_max=game->grid->monsterc_max;
-  int monsterc=monsterc_min+rand()%(monsterc_max-monsterc_min+1);
+  int monsterc=monsterc_min+ps_game_randint(game,monsterc_max-monsterc_min+1);
   if (monsterc<1) return 0;
 
   int large_ok=1;
   int i=monsterc; while (i-->0) {
-    int defp=rand()%defc;
+    int defp=ps_game_randint(game,defc);
     int sprdefid=ps_region_get_monster_at_difficulty(game->grid->region,defp,game->difficulty);
     if (sprdefid<1) {
       ps_log(GAME,ERROR,"Unexpected error: ps_region_count_monsters()==%d, ps_region_get_monster(%d)==%d",defc,defp,sprdefid);
@@ -541,6 +559,7 @@ int ps_game_restart(struct ps_game *game) {
 
   game->finished=0;
   game->paused=0;
+  ps_prng_init(&game->prng,game->seed);
   if (ps_stats_clear(game->stats)<0) return -1;
   if (ps_scenario_reset_visited(game->scenario)<0) return -1;
 
@@ -580,6 +599,7 @@ int ps_game_kill_nonhero_sprites(struct ps_game *game) {
     if (ps_sprgrp_add_sprite(game->grpv+PS_SPRGRP_DEATHROW,spr)) continue;
   }
   if (ps_sprgrp_kill(game->grpv+PS_SPRGRP_DEATHROW)<0) return -1;
+  if (ps_particles_clear(game->particles)<0) return -1;
   return 0;
 }
 
@@ -663,7 +683,7 @@ int ps_game_force_next_screen(struct ps_game *game,int dx,int dy) {
 /* Look for collisions between HAZARD and FRAGILE sprites, and take appropriate action.
  */
 
-static int ps_game_check_for_damage(struct ps_game *game) {
+static int ps_game_check_for_damage_naive(struct ps_game *game) {
 
   int i=0; for (;i<game->grpv[PS_SPRGRP_HAZARD].sprc;i++) {
     struct ps_sprite *hazard=game->grpv[PS_SPRGRP_HAZARD].sprv[i];
@@ -692,6 +712,101 @@ static int ps_game_check_for_damage(struct ps_game *game) {
   return 0;
 }
 
+/* Same thing, but only consider victims near each hazard.
+ * Victims are indexed in group order, so while the index is fresh, visiting neighbors makes the same calls as the naive loop.
+ * Damage can change groups, move sprites, or kill them outright.
+ * So after any damage, we finish that hazard with the naive loop over the live group, then reindex.
+ * That reproduces the naive loop's quirks exactly (eg skipping the sprite after a victim that leaves the group).
+ * We hold a reference to each indexed sprite, so none of them can be freed while the index points to it.
+ */
+
+static void ps_game_release_damage_index(struct ps_broadphase *broadphase) {
+  const struct ps_broadphase_entry *entry=broadphase->entryv;
+  int i=broadphase->entryc; for (;i-->0;entry++) ps_sprite_del(entry->spr);
+  broadphase->entryc=0;
+}
+
+static int ps_game_build_damage_index(struct ps_broadphase *broadphase,const struct ps_sprgrp *grp) {
+  if (ps_broadphase_rebuild(broadphase,grp,0)<0) return -1;
+  const struct ps_broadphase_entry *entry=broadphase->entryv;
+  int i=0; for (;i<broadphase->entryc;i++,entry++) {
+    if (ps_sprite_ref(entry->spr)<0) {
+      broadphase->entryc=i;
+      ps_game_release_damage_index(broadphase);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+static int ps_game_check_damage_naive_from(struct ps_game *game,struct ps_sprite *hazard,int victimgrp,int j) {
+  for (;j<game->grpv[victimgrp].sprc;j++) {
+    struct ps_sprite *victim=game->grpv[victimgrp].sprv[j];
+    if (hazard==victim) continue;
+    if (ps_sprites_collide(hazard,victim)) {
+      if ((victimgrp!=PS_SPRGRP_FRAGILE)&&!ps_sprgrp_has_sprite(game->grpv+PS_SPRGRP_FRAGILE,victim)) continue;
+      if (ps_sprite_receive_damage(game,victim,hazard)<0) return -1;
+    }
+  }
+  return 0;
+}
+
+static int ps_game_check_damage_against_index(
+  struct ps_game *game,
+  int hazardgrp,
+  int victimgrp,
+  struct ps_broadphase *broadphase
+) {
+  if (game->grpv[hazardgrp].sprc<1) return 0;
+  if (game->grpv[victimgrp].sprc<1) return 0;
+  if (ps_game_build_damage_index(broadphase,game->grpv+victimgrp)<0) return -1;
+  int i=0; for (;i<game->grpv[hazardgrp].sprc;i++) {
+    struct ps_sprite *hazard=game->grpv[hazardgrp].sprv[i];
+    if (ps_broadphase_find_neighbors(broadphase,hazard)<0) goto _error_;
+    const int *p=broadphase->neighborv;
+    int c=broadphase->neighborc; for (;c-->0;p++) {
+      const struct ps_broadphase_entry *entry=broadphase->entryv+*p;
+      struct ps_sprite *victim=entry->spr;
+      if (hazard==victim) continue;
+      if (!ps_sprites_collide(hazard,victim)) continue;
+      // We put a few things in HERO that are not actual heroes -- confirm that it is also FRAGILE.
+      if ((victimgrp!=PS_SPRGRP_FRAGILE)&&!ps_sprgrp_has_sprite(game->grpv+PS_SPRGRP_FRAGILE,victim)) continue;
+      if (ps_sprite_receive_damage(game,victim,hazard)<0) goto _error_;
+      if (ps_game_check_damage_naive_from(game,hazard,victimgrp,entry->sprp+1)<0) goto _error_;
+      ps_game_release_damage_index(broadphase);
+      if (ps_game_build_damage_index(broadphase,game->grpv+victimgrp)<0) return -1;
+      break;
+    }
+  }
+  ps_game_release_damage_index(broadphase);
+  return 0;
+ _error_:
+  ps_game_release_damage_index(broadphase);
+  return -1;
+}
+
+int ps_game_check_for_damage(struct ps_game *game) {
+  if (!game) return -1;
+  if (!game->damage_index_fragile||!game->damage_index_hero) return ps_game_check_for_damage_naive(game);
+  if (ps_game_check_damage_against_index(game,PS_SPRGRP_HAZARD,PS_SPRGRP_FRAGILE,game->damage_index_fragile)<0) return -1;
+  if (ps_game_check_damage_against_index(game,PS_SPRGRP_HEROHAZARD,PS_SPRGRP_HERO,game->damage_index_hero)<0) return -1;
+  return 0;
+}
+
+int ps_game_enable_damage_index(struct ps_game *game,int enable) {
+  if (!game) return -1;
+  if (enable) {
+    if (!game->damage_index_fragile&&!(game->damage_index_fragile=ps_broadphase_new())) return -1;
+    if (!game->damage_index_hero&&!(game->damage_index_hero=ps_broadphase_new())) return -1;
+  } else {
+    ps_broadphase_del(game->damage_index_fragile);
+    ps_broadphase_del(game->damage_index_hero);
+    game->damage_index_fragile=0;
+    game->damage_index_hero=0;
+  }
+  return 0;
+}
+
 /* Look for damaging collisions among the physics's events.
  */
 
@@ -855,6 +970,13 @@ static int ps_game_react_to_sprite_update_error(struct ps_game *game,struct ps_s
   return 0;
 }
 
+/* Random integer.
+ */
+
+int ps_game_randint(struct ps_game *game,int limit) {
+  return ps_prng_int(&game->prng,limit);
+}
+
 /* Update.
  */
 
@@ -869,12 +991,24 @@ int ps_game_update(struct ps_game *game) {
     if (ps_game_pause(game,1)<0) return -1;
     return 0;
   }
+
+  struct ps_game_timing *timing=game->timing;
+  int64_t t0=0,t1;
+  if (timing) {
+    timing->framec++;
+    t0=ps_time_now();
+  }
+  #define PS_GAME_TIMING(field) if (timing) { t1=ps_time_now(); timing->field+=t1-t0; t0=t1; }
+
+  /* Distance fields are shared within one frame only; anything might have changed the grid since the last. */
+  ps_gridpath_invalidate(game->gridpath);
   
   /* Externalized game logic. */
   //ps_gamelog_tick(game->gamelog); // Ignore errors.
   if (ps_bloodhound_activator_update(game->bloodhound_activator,game)<0) return -1;
   if (ps_dragoncharger_update(game->dragoncharger,game)<0) return -1;
   if (ps_summoner_update(game->summoner,game)<0) return -1;
+  PS_GAME_TIMING(logic)
   
   /* Update sprites. */
   struct ps_sprgrp *grp=game->grpv+PS_SPRGRP_UPDATE;
@@ -886,19 +1020,25 @@ int ps_game_update(struct ps_game *game) {
     }
   }
   
+  /* Cosmetic particles. Nothing can see them, so it doesn't matter that they're out of order with sprites. */
+  if (ps_particles_update(game->particles)<0) return -1;
+  
   /* Poll routine events and record stats. */
   if (ps_game_update_stats(game)<0) return -1;
+  PS_GAME_TIMING(sprites)
 
   /* Update physics, then consider any hazardous collisions. */
   if (ps_physics_update(game->physics)<0) return -1;
   if (ps_game_check_physics_for_damage(game)<0) return -1;
   if (ps_game_check_physics_for_heroonly_hack(game)<0) return -1;
   game->suppress_switch_effects=0; // Deferred from grid change, until after the first general update.
+  PS_GAME_TIMING(physics)
   
   /* Look for collisions between HAZARD and FRAGILE sprites.
    * Some damage methods, eg sword, are managed by individual sprite types.
    */
   if (ps_game_check_for_damage(game)<0) return -1;
+  PS_GAME_TIMING(damage)
 
   /* Clear death row. */
   if (ps_sprgrp_kill(game->grpv+PS_SPRGRP_DEATHROW)<0) return -1;
@@ -908,11 +1048,13 @@ int ps_game_update(struct ps_game *game) {
     if (ps_game_check_grid_change(game)<0) return -1;
   }
 
-  /* Sort rendering group, one pass. */
-  if (ps_sprgrp_sort(game->grpv+PS_SPRGRP_VISIBLE,0)<0) return -1;
+  /* Sort rendering group. */
+  if (ps_sprgrp_sort(game->grpv+PS_SPRGRP_VISIBLE)<0) return -1;
 
   /* Check for completion. */
   if (ps_game_check_completion(game)<0) return -1;
+  PS_GAME_TIMING(grid)
+  #undef PS_GAME_TIMING
   
   return 0;
 }
@@ -1043,18 +1185,69 @@ void ps_game_dump_stats(const struct ps_game *game) {
 /* Create fireworks when something dies.
  */
 
-#define PS_FIREWORKS_SPRITE_COUNT 20
+#define PS_FIREWORKS_PARTICLE_COUNT 20
+#define PS_FIREWORKS_TTL 60
+#define PS_FIREWORKS_SPEED_MIN 1.5
+#define PS_FIREWORKS_SPEED_MAX 3.0
+#define PS_FIREWORKS_ROTATION 5
+#define PS_FIREWORKS_LAYER 200
 
 int ps_game_create_fireworks(struct ps_game *game,int x,int y) {
   if (!game) return -1;
 
-  int i=PS_FIREWORKS_SPRITE_COUNT; while (i-->0) {
-    if (!ps_sprite_fireworks_new(game,x,y,i,PS_FIREWORKS_SPRITE_COUNT)) return -1;
+  struct ps_particle particle={
+    .x=x,
+    .y=y,
+    .ttl=PS_FIREWORKS_TTL,
+    .layer=PS_FIREWORKS_LAYER,
+    .tsid=0x04,
+    .tileid=0x0a,
+    .dt=PS_FIREWORKS_ROTATION<<8,
+    .size=PS_TILESIZE,
+    .fadeout=PS_FIREWORKS_TTL,
+  };
+  int i=PS_FIREWORKS_PARTICLE_COUNT; while (i-->0) {
+    double t=(i*M_PI*2.0)/PS_FIREWORKS_PARTICLE_COUNT;
+    double speed=PS_FIREWORKS_SPEED_MIN+(ps_game_randint(game,100)*(PS_FIREWORKS_SPEED_MAX-PS_FIREWORKS_SPEED_MIN+1))/100.0;
+    particle.dx=cos(t)*speed;
+    particle.dy=sin(t)*speed;
+    particle.t=ps_game_randint(game,0x100);
+    particle.rgba=(uint32_t)ps_game_randint(game,0x100)<<24;
+    particle.rgba|=(uint32_t)ps_game_randint(game,0x100)<<16;
+    particle.rgba|=(uint32_t)ps_game_randint(game,0x100)<<8;
+    particle.rgbz=particle.rgba;
+    if (ps_particles_add(game->particles,&particle)<0) return -1;
   }
   
   return 0;
 }
 
+/* Flash a tile that just changed, eg a barrier opening.
+ */
+
+#define PS_CHANGEINDICATOR_TTL 40
+#define PS_CHANGEINDICATOR_LAYER 150
+
+static int ps_game_create_change_indicator(struct ps_game *game,int col,int row) {
+  struct ps_particle particle={
+    .x=col*PS_TILESIZE+(PS_TILESIZE>>1),
+    .y=row*PS_TILESIZE+(PS_TILESIZE>>1),
+    .ttl=PS_CHANGEINDICATOR_TTL,
+    .layer=PS_CHANGEINDICATOR_LAYER,
+    .tsid=0x04,
+    .tileid=0xee,
+    .dt=(0xff<<8)/PS_CHANGEINDICATOR_TTL,
+    .size=PS_TILESIZE<<1,
+    .shrink=PS_CHANGEINDICATOR_TTL>>1,
+    .rgba=0xffff0000,
+    .rgbz=0x00ff0000,
+    .fadein=10,
+    .fadeout=PS_CHANGEINDICATOR_TTL,
+  };
+  if (ps_particles_add(game->particles,&particle)<0) return -1;
+  return 0;
+}
+
 /* Create prize when something dies.
  */
  
@@ -1171,6 +1364,7 @@ int ps_game_apply_nonpersistent_grid_change(struct ps_game *game,int col,int row
   npgc->shape=cell->shape;
 
   /* Finally, modify the live cell. */
+  ps_gridpath_invalidate(game->gridpath);
   cell->tileid=tileid;
   cell->physics=physics;
   cell->shape=shape;
@@ -1180,6 +1374,7 @@ int ps_game_apply_nonpersistent_grid_change(struct ps_game *game,int col,int row
 
 int ps_game_npgc_pop(struct ps_game *game) {
   if (!game||!game->grid) return -1;
+  ps_gridpath_invalidate(game->gridpath);
   while (game->npgcc>0) {
     struct ps_game_npgc *npgc=game->npgcv+(--(game->npgcc));
     struct ps_grid_cell *cell=game->grid->cellv+npgc->row*PS_GRID_COLC+npgc->col;
@@ -1210,6 +1405,7 @@ int ps_game_reverse_nonpersistent_grid_change(struct ps_game *game,int col,int r
   }
   if (!found) return 0;
 
+  ps_gridpath_invalidate(game->gridpath);
   struct ps_grid_cell *cell=game->grid->cellv+row*PS_GRID_COLC+col;
   cell->tileid=npgc.tileid;
   cell->physics=npgc.physics;
@@ -1236,13 +1432,17 @@ static int ps_game_cb_switch(int switchid,int value,void *userdata) {
       return -1;
     }
   }
+  ps_gridpath_invalidate(game->gridpath);
   if (ps_game_adjust_sprites_for_grid_changes(game,&changes)<0) {
     ps_path_cleanup(&changes);
     return -1;
   }
   if (!game->suppress_switch_effects) {
     while (changes.c-->0) {
-      struct ps_sprite *indicator=ps_sprite_changeindicator_spawn(game,changes.v[changes.c].x,changes.v[changes.c].y);
+      if (ps_game_create_change_indicator(game,changes.v[changes.c].x,changes.v[changes.c].y)<0) {
+        ps_path_cleanup(&changes);
+        return -1;
+      }
     }
   }
   ps_path_cleanup(&changes);
@@ -1460,6 +1660,7 @@ int ps_game_change_screen(struct ps_game *game,int x,int y,int mode) {
   if (ps_switchboard_clear(game->switchboard,1)<0) return -1;
   if (ps_game_renderer_cancel_fade(game->renderer)<0) return -1;
   game->grid=grid;
+  ps_gridpath_invalidate(game->gridpath);
   game->gridx=x;
   game->gridy=y;
   game->grid->visited=1;
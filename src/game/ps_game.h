@@ -6,12 +6,14 @@
 #define PS_GAME_H
 
 #include "ps_sprite.h"
+#include "util/ps_prng.h"
 
 struct ps_scenario;
 struct ps_player;
 struct ps_grid;
 struct ps_video_layer;
 struct ps_physics;
+struct ps_broadphase;
 struct ps_input_device;
 struct ps_stats;
 struct ps_path;
@@ -23,6 +25,9 @@ struct ps_summoner;
 struct ps_switchboard;
 struct ps_gamelog;
 struct ps_score_store;
+struct ps_scgen_async;
+struct ps_gridpath;
+struct ps_particles;
 
 /* Global sprite groups. */
 #define PS_SPRGRP_KEEPALIVE        0 /* All active sprites belong to this group. */
@@ -42,7 +47,19 @@ struct ps_score_store;
 #define PS_SPRGRP_TELEPORT        14 /* Can travel through teleporter. */
 #define PS_SPRGRP_HEROONLYHACK    15 /* For game's internal use, please ignore. */
 #define PS_SPRGRP_SWORDAWARE      16 /* Reacts to sword swipe (and only sword). */
-#define PS_SPRGRP_COUNT           17
+#define PS_SPRGRP_COUNT           17 /* Limit 32: Sprites track membership as a mask (ps_sprite.grpmask). */
+
+/* Optional timing of each phase of ps_game_update(), in microseconds.
+ * Install a zeroed one as (game->timing) and we add to it every frame.
+ */
+struct ps_game_timing {
+  int64_t framec;
+  int64_t logic; // Bloodhound, dragon charger, summoner.
+  int64_t sprites; // Sprite updates, particles, and stats.
+  int64_t physics; // Physics and its collision callbacks.
+  int64_t damage; // HAZARD vs FRAGILE.
+  int64_t grid; // Death row, screen changes, render sort, completion.
+};
 
 /* Non-persistent grid change (internal use; don't worry about it)
  */
@@ -58,6 +75,10 @@ struct ps_game {
   int playerc;
   int difficulty;
   int length;
+  uint32_t seed; // Generated the current scenario, and reseeds (prng) at each restart.
+  int seed_fixed; // Nonzero if the next ps_game_generate() must use (seed) instead of picking a fresh one.
+  struct ps_prng prng; // All gameplay randomness; see ps_game_randint().
+  struct ps_scgen_async *pregen; // Created by ps_game_pregenerate(), optional.
   int treasurev[PS_TREASURE_LIMIT];
   int treasurec;
   struct ps_stats *stats;
@@ -73,6 +94,10 @@ struct ps_game {
   struct ps_grid *grid; // WEAK
   int gridx,gridy; // Grid's position in world.
   struct ps_physics *physics;
+  struct ps_gridpath *gridpath; // Pathfinding scratch and shared distance fields, for the current grid.
+  struct ps_particles *particles; // Cosmetic effects that don't need to be sprites.
+  struct ps_broadphase *damage_index_fragile; // Null to check damage naively.
+  struct ps_broadphase *damage_index_hero;
   int inhibit_screen_switch; // Nonzero when we first move to a neighbor grid. Heroes reset it.
   int suppress_switch_effects; // Nonzero during screen change. Switches don't cause visual effects.
 
@@ -87,6 +112,8 @@ struct ps_game {
   int npgcc,npgca;
 
   int input_watchid;
+
+  struct ps_game_timing *timing; // WEAK, optional.
   
 };
 
@@ -108,6 +135,17 @@ int ps_game_set_difficulty(struct ps_game *game,int difficulty);
 int ps_game_set_length(struct ps_game *game,int length);
 int ps_game_generate(struct ps_game *game);
 
+/* Start generating in the background, with the settings we have now.
+ * Call whenever settings change; ps_game_generate() uses the result if the settings still match at commit.
+ * Noop if we're not ready to generate yet.
+ */
+int ps_game_pregenerate(struct ps_game *game);
+
+/* Optionally, before generating, fix the seed to reproduce a logged or saved game.
+ * It applies to the next generation only; after that we pick a fresh seed each time.
+ */
+int ps_game_set_seed(struct ps_game *game,uint32_t seed);
+
 /* For a test scenario, follow the same process but use this instead of ps_game_generate().
  * We will generate a scenario with one explicit region and only the blueprint IDs you provide.
  * There is some hacky logic to permit test games with no treasure; they will run until aborted.
@@ -143,6 +181,18 @@ int ps_game_change_screen(struct ps_game *game,int x,int y,int mode);
 
 int ps_game_update(struct ps_game *game);
 
+/* Random integer in 0..limit-1, from the game's own generator.
+ * Game logic and sprites must use this, never rand(), so that a seed replays the whole game.
+ */
+int ps_game_randint(struct ps_game *game,int limit);
+
+/* Look for collisions between HAZARD and FRAGILE, or HEROHAZARD and HERO, and deliver damage.
+ * ps_game_update() does this after physics; tests may call it directly.
+ * By default we use a spatial index. Results are identical either way.
+ */
+int ps_game_check_for_damage(struct ps_game *game);
+int ps_game_enable_damage_index(struct ps_game *game,int enable);
+
 /* Pause game and cause our owner to load the pause menu.
  */
 int ps_game_pause(struct ps_game *game,int pause);
@@ -193,11 +243,16 @@ int ps_game_measure_distance_between_screens(int *distance,int *direction,const
 // Wipe (path) and replace with the shortest path linking (srcx,srcy) to (dstx,dsty) based on the screens' door flags.
 int ps_game_compose_world_path(struct ps_path *path,const struct ps_game *game,int dstx,int dsty,int srcx,int srcy);
 
-/* Wipe (path) and replace with a path from (srcx,srcy) to (dstx,dsty) in the given grid.
+/* Wipe (path) and replace with a shortest path from (srcx,srcy) to (dstx,dsty) in the current grid.
  * If successful, the returned path will not contain any cells in (impassable).
- * The algorithm is fast and reliable but does not necessarily produce optimal results (there may be a shorter path).
+ * (srcx,srcy) may be just offscreen; see ps_gridpath_compose().
+ */
+int ps_game_compose_grid_path(struct ps_path *path,struct ps_game *game,int dstx,int dsty,int srcx,int srcy,uint16_t impassable);
+
+/* Distance in cells from every cell of the current grid to (x,y), avoiding (impassable).
+ * See ps_gridpath_get_field(). Sprites chasing the same target this frame share one field, so don't hesitate to ask.
  */
-int ps_game_compose_grid_path(struct ps_path *path,const struct ps_grid *grid,int dstx,int dsty,int srcx,int srcy,uint16_t impassable);
+const uint16_t *ps_game_get_grid_distance_field(struct ps_game *game,int x,int y,uint16_t impassable);
 
 /* Return a rectangle containing (x,y) where all cells have the same physics.
  * Precise behavior is undefined if the region is not rectangular.
@@ -243,7 +298,7 @@ int ps_game_highlight_enabled_players(struct ps_game *game);
 /* Select a cell at random that matches the given physics mask.
  * eg (1<<PS_BLUEPRINT_CELL_VACANT).
  */
-int ps_game_find_random_cell_with_physics(int *col,int *row,const struct ps_game *game,uint16_t mask);
+int ps_game_find_random_cell_with_physics(int *col,int *row,struct ps_game *game,uint16_t mask);
 
 /* Support for ps_sprite_chestkeeper.
  * When he dies, he calls this to create the real treasure chest.
@@ -256,12 +311,12 @@ int ps_game_save_to_score_store(struct ps_game *game);
  * We attempt to point towards passable cells.
  */
 int ps_game_select_random_travel_vector(
-  double *dx,double *dy,const struct ps_game *game,double x,double y,double speed,uint16_t impassable
+  double *dx,double *dy,struct ps_game *game,double x,double y,double speed,uint16_t impassable
 );
 
 /* ===== Serial Format =====
  *  0000   8 Signature: "\0PLSQD\n\xff"
- *  0008   4 Game Serial Version: 1
+ *  0008   4 Game Serial Version: 2 (1 is the same without seed)
  *  000c   4 Reserved for resources version or checksum.
  *  0010   1 Player count.
  *  0011   1 Difficulty.
@@ -270,7 +325,8 @@ int ps_game_select_random_travel_vector(
  *  0014   4 Treasure state, bitmap. treasurev[0]==0x00000001 etc
  *  0018   4 Play time.
  *  001c   2 Selected grid (x,y). (XXX not used; we restart at the home screen)
- *  001e ... Players:
+ *  001e   4 Seed. (version 2 only)
+ *  0022 ... Players:
  *    0000   2 plrdef id
  *    0002   1 Palette
  *    0003   1 unused
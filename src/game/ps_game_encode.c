@@ -13,9 +13,9 @@
 
 static int ps_game_encode_header(struct ps_buffer *dst,const struct ps_game *game) {
  
-  uint8_t tmp[30]={0};
+  uint8_t tmp[34]={0};
   memcpy(tmp,"\0PLSQD\n\xff",8);
-  tmp[11]=1; // Serial version
+  tmp[11]=2; // Serial version
   tmp[16]=game->playerc;
   tmp[17]=game->difficulty;
   tmp[18]=game->length;
@@ -31,8 +31,12 @@ static int ps_game_encode_header(struct ps_buffer *dst,const struct ps_game *gam
   tmp[27]=game->stats->playtime;
   tmp[28]=game->gridx;
   tmp[29]=game->gridy;
+  tmp[30]=game->seed>>24;
+  tmp[31]=game->seed>>16;
+  tmp[32]=game->seed>>8;
+  tmp[33]=game->seed;
 
-  if (ps_buffer_append(dst,tmp,30)<0) return -1;
+  if (ps_buffer_append(dst,tmp,34)<0) return -1;
   
   return 0;
 }
@@ -136,7 +140,20 @@ static int ps_game_decode_header(struct ps_game *game,const uint8_t *src,int src
 
   int gameversion=(src[8]<<24)|(src[9]<<16)|(src[10]<<8)|src[11];
   int resversion=(src[12]<<24)|(src[13]<<16)|(src[14]<<8)|src[15];
-  //TODO validate game and resource versions.
+  //TODO validate resource version.
+  int headerlen;
+  switch (gameversion) {
+    case 1: headerlen=30; break;
+    case 2: headerlen=34; break;
+    default: {
+        ps_log(RES,ERROR,"Unknown serialized game version %d.",gameversion);
+        return -1;
+      }
+  }
+  if (srcc<headerlen) {
+    ps_log(RES,ERROR,"Failed to decode game: short data");
+    return -1;
+  }
 
   int playerc=src[16];
   int difficulty=src[17];
@@ -170,7 +187,15 @@ static int ps_game_decode_header(struct ps_game *game,const uint8_t *src,int src
   game->gridx=src[28];
   game->gridy=src[29];
 
-  return 30;
+  if (headerlen>=34) {
+    game->seed=(src[30]<<24)|(src[31]<<16)|(src[32]<<8)|src[33];
+  } else {
+    game->seed=0;
+  }
+  game->seed_fixed=0;
+  ps_prng_init(&game->prng,game->seed);
+
+  return headerlen;
 }
 
 /* Decode players.
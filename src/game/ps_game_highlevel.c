@@ -6,6 +6,7 @@
 #include "ps_game.h"
 #include "ps_sprite.h"
 #include "ps_path.h"
+#include "ps_gridpath.h"
 #include "ps_sound_effects.h"
 #include "ps_physics.h"
 #include "ps_switchboard.h"
@@ -44,7 +45,7 @@ int ps_game_check_status_report(struct ps_game *game);
 /* Summon bloodhound.
  */
 
-static int ps_game_select_bloodhound_position(int *x,int *y,const struct ps_grid *grid) {
+static int ps_game_select_bloodhound_position(int *x,int *y,struct ps_game *game,const struct ps_grid *grid) {
 
   // Anything on the edge, not a corner, and vacant is a candidate.
   int candidatec=0,i;
@@ -58,7 +59,7 @@ static int ps_game_select_bloodhound_position(int *x,int *y,const struct ps_grid
   }
   if (candidatec<1) return -1;
 
-  int selection=rand()%candidatec;
+  int selection=ps_game_randint(game,candidatec);
   for (i=1;i<PS_GRID_COLC-1;i++) {
     if (grid->cellv[i].physics==PS_BLUEPRINT_CELL_VACANT) {
       if (!selection--) {
@@ -104,7 +105,7 @@ int ps_game_summon_bloodhound(struct ps_game *game) {
   }
 
   int x,y;
-  if (ps_game_select_bloodhound_position(&x,&y,game->grid)<0) return -1;
+  if (ps_game_select_bloodhound_position(&x,&y,game,game->grid)<0) return -1;
   struct ps_sprite *spr=ps_sprdef_instantiate(game,sprdef,0,0,x*PS_TILESIZE+(PS_TILESIZE>>1),y*PS_TILESIZE+(PS_TILESIZE>>1));
   if (!spr) return -1;
   
@@ -165,209 +166,51 @@ int ps_game_get_direction_to_nearest_treasure(const struct ps_game *game) {
 }
 
 /* Measure distance between screens.
+ * The scenario keeps a table of every pair, built when the doors are settled.
  */
  
-static int ps_game_measure_distance_between_screens_1(int *distance,const struct ps_game *game,int dstx,int dsty,int srcx,int srcy,struct ps_path *path) {
-  if ((srcx<0)||(srcx>=game->scenario->w)) return -1;
-  if ((srcy<0)||(srcy>=game->scenario->h)) return -1;
-  if ((dstx==srcx)&&(dsty==srcy)) return 0;
-  if (ps_path_has(path,srcx,srcy)) return -1; // Been here.
-  if (ps_path_add(path,srcx,srcy)<0) return -1; // Abort.
-
-  (*distance)++;
-  int distance0=(*distance);
-  int screenc0=path->c,err,eastd=INT_MAX,westd=INT_MAX,northd=INT_MAX,southd=INT_MAX;
-  const struct ps_screen *screen=game->scenario->screenv+srcy*game->scenario->w+srcx;
-
-  if (screen->doorw==PS_DOOR_OPEN) {
-    path->c=screenc0;
-    *distance=distance0;
-    if (ps_game_measure_distance_between_screens_1(distance,game,dstx,dsty,srcx-1,srcy,path)>=0) westd=*distance;
-  }
-
-  if (screen->doore==PS_DOOR_OPEN) {
-    path->c=screenc0;
-    *distance=distance0;
-    if (ps_game_measure_distance_between_screens_1(distance,game,dstx,dsty,srcx+1,srcy,path)>=0) eastd=*distance;
-  }
-
-  if (screen->doorn==PS_DOOR_OPEN) {
-    path->c=screenc0;
-    *distance=distance0;
-    if (ps_game_measure_distance_between_screens_1(distance,game,dstx,dsty,srcx,srcy-1,path)>=0) northd=*distance;
-  }
-
-  if (screen->doors==PS_DOOR_OPEN) {
-    path->c=screenc0;
-    *distance=distance0;
-    if (ps_game_measure_distance_between_screens_1(distance,game,dstx,dsty,srcx,srcy+1,path)>=0) southd=*distance;
-  }
-
-  if ((westd<=eastd)&&(westd<=northd)&&(westd<=southd)) { *distance=westd; return PS_DIRECTION_WEST; }
-  if ((eastd<=northd)&&(eastd<=southd)) { *distance=eastd; return PS_DIRECTION_EAST; }
-  if (northd<=southd) { *distance=northd; return PS_DIRECTION_NORTH; }
-  if (southd<INT_MAX) { *distance=southd; return PS_DIRECTION_SOUTH; }
-
-  return -1;
-}
- 
 int ps_game_measure_distance_between_screens(int *distance,int *direction,const struct ps_game *game,int dstx,int dsty,int srcx,int srcy) {
   if (!distance||!direction||!game) return -1;
   if ((dstx==srcx)&&(dsty==srcy)) { *distance=*direction=0; return 0; }
-  if ((dstx<0)||(dstx>=game->scenario->w)) return -1;
-  if ((dsty<0)||(dsty>=game->scenario->h)) return -1;
-  struct ps_path path={0};
-  *distance=0;
-  int err=ps_game_measure_distance_between_screens_1(distance,game,dstx,dsty,srcx,srcy,&path);
-  ps_path_cleanup(&path);
-  if (err<=0) return -1;
-  *direction=err;
+  int d=ps_scenario_get_route(direction,game->scenario,dstx,dsty,srcx,srcy);
+  if (d<=0) return -1;
+  *distance=d;
   return 0;
 }
 
-/* Similar to the above, but return a fully-formed path between screens.
- * Since the space of all screens is pretty small and paths between them are pretty limited, we go big and get the most correct answer.
+/* Similar to the above, but return a fully-formed path between screens, including both endpoints.
+ * We follow the first-step directions from the route table.
  */
  
-static int ps_game_compose_world_path_1(struct ps_path *path,const struct ps_game *game,int dstx,int dsty,int srcx,int srcy) {
-  if ((srcx<0)||(srcx>=game->scenario->w)) return -1;
-  if ((srcy<0)||(srcy>=game->scenario->h)) return -1;
-  if (ps_path_has(path,srcx,srcy)) return -1;
-  if (ps_path_add(path,srcx,srcy)<0) return -1;
-  if ((srcx==dstx)&&(srcy==dsty)) return 0;
-
-  int c0=path->c;
-  int scorew=INT_MAX,scoree=INT_MAX,scoren=INT_MAX,scores=INT_MAX;
-
-  path->c=c0;
-  if (ps_game_compose_world_path_1(path,game,dstx,dsty,srcx-1,srcy)>=0) scorew=path->c;
-
-  path->c=c0;
-  if (ps_game_compose_world_path_1(path,game,dstx,dsty,srcx+1,srcy)>=0) scoree=path->c;
-
-  path->c=c0;
-  if (ps_game_compose_world_path_1(path,game,dstx,dsty,srcx,srcy-1)>=0) scoren=path->c;
-
-  path->c=c0;
-  if (ps_game_compose_world_path_1(path,game,dstx,dsty,srcx,srcy+1)>=0) scores=path->c;
-
-  path->c=c0;
-  if ((scorew<scoree)&&(scorew<scoren)&&(scorew<scores)) {
-    return ps_game_compose_world_path_1(path,game,dstx,dsty,srcx-1,srcy);
-  } else if ((scoree<scoren)&&(scoree<scores)) {
-    return ps_game_compose_world_path_1(path,game,dstx,dsty,srcx+1,srcy);
-  } else if (scoren<scores) {
-    return ps_game_compose_world_path_1(path,game,dstx,dsty,srcx,srcy-1);
-  } else if (scores<INT_MAX) {
-    return ps_game_compose_world_path_1(path,game,dstx,dsty,srcx,srcy+1);
-  }
-  return -1;
-}
- 
 int ps_game_compose_world_path(struct ps_path *path,const struct ps_game *game,int dstx,int dsty,int srcx,int srcy) {
   if (!path||!game) return -1;
-  if ((dstx<0)||(dstx>=game->scenario->w)) return -1;
-  if ((dsty<0)||(dsty>=game->scenario->h)) return -1;
   path->c=0;
-  return ps_game_compose_world_path_1(path,game,dstx,dsty,srcx,srcy);
+  int x=srcx,y=srcy,direction;
+  int d=ps_scenario_get_route(&direction,game->scenario,dstx,dsty,x,y);
+  if (d<0) return -1;
+  if (ps_path_add(path,x,y)<0) return -1;
+  while (d-->0) {
+    if (ps_scenario_get_route(&direction,game->scenario,dstx,dsty,x,y)<0) return -1;
+    struct ps_vector offset=ps_vector_from_direction(direction);
+    x+=offset.dx;
+    y+=offset.dy;
+    if (ps_path_add(path,x,y)<0) return -1;
+  }
+  return 0;
 }
 
 /* Compose path in grid.
- * We do not use the same algorithm as the screen path generator.
- * The set of possible paths across a grid could be astronomically large, so we take an optimistic approach.
- * From each cell, examine the four possible moves in order of likelihood, and accept the first positive response.
- * We don't necessarily get the best path:
- *     +----------> (dst) <----+
- * === | ===================== | ===
- *     +--------------- (src)--+
- *          |                 |
- *      our result          ideal
+ * ps_gridpath does the real work, with scratch space we allocated at startup.
  */
  
-static int ps_game_compose_grid_path_1(struct ps_path *path,const struct ps_grid *grid,int dstx,int dsty,int srcx,int srcy,uint16_t impassable,struct ps_path *blacklist) {
-  if (ps_path_has(path,srcx,srcy)) return -1;
-  if (ps_path_has(blacklist,srcx,srcy)) return -1;
-  if ((srcx<-PS_GRID_COLC)||(srcx>PS_GRID_COLC<<1)) return -1;
-  if ((srcy<-PS_GRID_ROWC)||(srcy>PS_GRID_ROWC<<1)) return -1;
-
-  if (impassable) {
-    int effectivex=(srcx<0)?0:(srcx>=PS_SCREENW)?(PS_SCREENW-1):srcx;
-    int effectivey=(srcy<0)?0:(srcy>=PS_SCREENH)?(PS_SCREENH-1):srcy;
-    if ((1<<grid->cellv[effectivey*PS_GRID_COLC+effectivex].physics)&impassable) return -1;
-  }
-  
-  if (ps_path_add(path,srcx,srcy)<0) return -1;
-  if ((srcx==dstx)&&(srcy==dsty)) return 0;
-  int c0=path->c;
-
-  /* Select the directions we can move from here, ordered by likeliest match. */
-  int dirv[4];
-  int dirc=0;
-  int dx=dstx-srcx; int adx=(dx<0)?-dx:dx;
-  int dy=dsty-srcy; int ady=(dy<0)?-dy:dy;
-  if (adx>ady) { // horz first
-    if (dx<0) {
-      if (srcx>0) dirv[dirc++]=PS_DIRECTION_WEST;
-    } else {
-      if (srcx<PS_GRID_COLC-1) dirv[dirc++]=PS_DIRECTION_EAST;
-    }
-    if (dy<0) {
-      if (srcy<PS_GRID_ROWC-1) dirv[dirc++]=PS_DIRECTION_SOUTH;
-      if (srcy>0) dirv[dirc++]=PS_DIRECTION_NORTH;
-    } else {
-      if (srcy>0) dirv[dirc++]=PS_DIRECTION_NORTH;
-      if (srcy<PS_GRID_ROWC-1) dirv[dirc++]=PS_DIRECTION_SOUTH;
-    }
-    if (dx<0) {
-      if (srcx<PS_GRID_COLC-1) dirv[dirc++]=PS_DIRECTION_EAST;
-    } else {
-      if (srcx>0) dirv[dirc++]=PS_DIRECTION_WEST;
-    }
-  } else { // vert first
-    if (dy<0) {
-      if (srcy>0) dirv[dirc++]=PS_DIRECTION_NORTH;
-    } else {
-      if (srcy<PS_GRID_ROWC-1) dirv[dirc++]=PS_DIRECTION_SOUTH;
-    }
-    if (dx<0) {
-      if (srcx>0) dirv[dirc++]=PS_DIRECTION_WEST;
-      if (srcx<PS_GRID_COLC-1) dirv[dirc++]=PS_DIRECTION_EAST;
-    } else {
-      if (srcx<PS_GRID_COLC-1) dirv[dirc++]=PS_DIRECTION_EAST;
-      if (srcx>0) dirv[dirc++]=PS_DIRECTION_WEST;
-    }
-    if (dy<0) {
-      if (srcy<PS_GRID_ROWC-1) dirv[dirc++]=PS_DIRECTION_SOUTH;
-    } else {
-      if (srcy>0) dirv[dirc++]=PS_DIRECTION_NORTH;
-    }
-  }
-
-  /* Consider each of those directions in turn.
-   * If we get a match, return it immediately.
-   */
-  int i; for (i=0;i<dirc;i++) {
-    struct ps_vector d=ps_vector_from_direction(dirv[i]);
-    path->c=c0;
-    int err=ps_game_compose_grid_path_1(path,grid,dstx,dsty,srcx+d.dx,srcy+d.dy,impassable,blacklist);
-    if (err>=0) return 0;
-  }
-
-  /* Can't get there from here; ensure that we don't re-enter this cell. */
-  if (ps_path_add(blacklist,srcx,srcy)<0) return -1;
-  
-  return -1;
+int ps_game_compose_grid_path(struct ps_path *path,struct ps_game *game,int dstx,int dsty,int srcx,int srcy,uint16_t impassable) {
+  if (!path||!game) return -1;
+  return ps_gridpath_compose(path,game->gridpath,game->grid,dstx,dsty,srcx,srcy,impassable);
 }
- 
-int ps_game_compose_grid_path(struct ps_path *path,const struct ps_grid *grid,int dstx,int dsty,int srcx,int srcy,uint16_t impassable) {
-  if (!path||!grid) return -1;
-  if ((dstx<-PS_SCREENW)||(dstx>PS_SCREENW<<1)) return -1;
-  if ((dsty<-PS_SCREENH)||(dsty>PS_SCREENH<<1)) return -1;
-  struct ps_path blacklist={0};
-  path->c=0;
-  int err=ps_game_compose_grid_path_1(path,grid,dstx,dsty,srcx,srcy,impassable,&blacklist);
-  ps_path_cleanup(&blacklist);
-  return err;
+
+const uint16_t *ps_game_get_grid_distance_field(struct ps_game *game,int x,int y,uint16_t impassable) {
+  if (!game) return 0;
+  return ps_gridpath_get_field(game->gridpath,game->grid,x,y,impassable);
 }
 
 /* Locate contiguous physical rect.
@@ -774,7 +617,7 @@ int ps_game_highlight_enabled_players(struct ps_game *game) {
 /* Find random cell with physics.
  */
  
-int ps_game_find_random_cell_with_physics(int *col,int *row,const struct ps_game *game,uint16_t mask) {
+int ps_game_find_random_cell_with_physics(int *col,int *row,struct ps_game *game,uint16_t mask) {
   if (!col||!row||!game) return -1;
   if (!game->grid) return -1;
   if (!mask) return -1; // Impossible.
@@ -783,8 +626,8 @@ int ps_game_find_random_cell_with_physics(int *col,int *row,const struct ps_game
    */
   int repc=10;
   while (repc-->0) {
-    int x=rand()%PS_GRID_COLC;
-    int y=rand()%PS_GRID_ROWC;
+    int x=ps_game_randint(game,PS_GRID_COLC);
+    int y=ps_game_randint(game,PS_GRID_ROWC);
     uint8_t physics=game->grid->cellv[y*PS_GRID_COLC+x].physics;
     if (mask&(1<<physics)) {
       *col=x;
@@ -813,7 +656,7 @@ int ps_game_find_random_cell_with_physics(int *col,int *row,const struct ps_game
   /* Select one randomly.
    */
   if (coordc<1) return -1;
-  int coordp=rand()%coordc;
+  int coordp=ps_game_randint(game,coordc);
   *col=coordv[coordp].x;
   *row=coordv[coordp].y;
   return 0;
@@ -911,7 +754,7 @@ int ps_game_recreate_treasure_chest(struct ps_game *game,int x,int y) {
  */
  
 int ps_game_select_random_travel_vector(
-  double *dx,double *dy,const struct ps_game *game,double x,double y,double speed,uint16_t impassable
+  double *dx,double *dy,struct ps_game *game,double x,double y,double speed,uint16_t impassable
 ) {
   if (!dx||!dy||!game) return -1;
   if (speed<0.1) speed=0.1;
@@ -931,7 +774,7 @@ int ps_game_select_random_travel_vector(
   while (distance>=PS_TILESIZE) {
     int tryc=5;
     while (tryc-->0) {
-      double t=(rand()%6282)/1000.0;
+      double t=ps_game_randint(game,6282)/1000.0;
       *dx=-sin(t);
       *dy=cos(t);
       double dstx=x+(*dx)*distance;
@@ -3,6 +3,7 @@
 #include "ps_game.h"
 #include "ps_stats.h"
 #include "ps_statusreport.h"
+#include "ps_particles.h"
 #include "video/ps_video.h"
 #include "video/ps_video_layer.h"
 #include "akgl/akgl.h"
@@ -150,6 +151,23 @@ static int ps_game_draw_hud(struct ps_game *game) {
   return 0;
 }
 
+/* Sprites in render order, with each layer's particles right after that layer's sprites.
+ */
+
+static int ps_game_draw_sprites_and_particles(struct ps_game *game,int offx,int offy) {
+  const struct ps_sprgrp *grp=game->grpv+PS_SPRGRP_VISIBLE;
+  int sprp=0;
+  int layer=INT_MIN;
+  while ((layer=ps_particles_next_layer(game->particles,layer))<INT_MAX) {
+    int sprc=0;
+    while ((sprp+sprc<grp->sprc)&&(grp->sprv[sprp+sprc]->layer<=layer)) sprc++;
+    if (ps_video_draw_spritev(grp->sprv+sprp,sprc,offx,offy)<0) return -1;
+    sprp+=sprc;
+    if (ps_particles_draw(game->particles,layer,offx,offy)<0) return -1;
+  }
+  return ps_video_draw_spritev(grp->sprv+sprp,grp->sprc-sprp,offx,offy);
+}
+
 static int ps_game_renderer_draw(struct ps_video_layer *layer) {
   struct ps_game *game=LAYER->game;
   struct ps_game_renderer *renderer=LAYER->renderer;
@@ -184,7 +202,7 @@ static int ps_game_renderer_draw(struct ps_video_layer *layer) {
       if (ps_statusreport_draw(game->statusreport,slidex,slidey)<0) return -1;
     }
   
-    if (ps_video_draw_sprites(game->grpv+PS_SPRGRP_VISIBLE,slidex,slidey)<0) return -1;
+    if (ps_game_draw_sprites_and_particles(game,slidex,slidey)<0) return -1;
 
     if (!renderer->drawing_for_capture&&renderer->capture&&(slidex||slidey)) {
       int dstx=0,dsty=PS_SCREENH;
@@ -4,8 +4,10 @@
 #include "ps_plrdef.h"
 #include "scenario/ps_scenario.h"
 #include "scenario/ps_scgen.h"
+#include "scenario/ps_scgen_async.h"
 #include "input/ps_input.h"
 #include "res/ps_resmgr.h"
+#include "os/ps_clockassist.h"
 
 /* Set player count.
  */
@@ -61,6 +63,13 @@ int ps_game_configure_player(struct ps_game *game,int playerid,int plrdefid,int
 
 /* Configure generator.
  */
+
+int ps_game_set_seed(struct ps_game *game,uint32_t seed) {
+  if (!game) return -1;
+  game->seed=seed;
+  game->seed_fixed=1;
+  return 0;
+}
   
 int ps_game_set_difficulty(struct ps_game *game,int difficulty) {
   if (!game) return -1;
@@ -97,6 +106,76 @@ static int ps_game_ready_to_generate(const struct ps_game *game) {
   return 1;
 }
 
+/* Seed for the scenario about to generate: The one our owner fixed, or a fresh one.
+ * Fresh seeds differ even for games generated in the same microsecond.
+ */
+
+static uint32_t ps_game_fresh_seed() {
+  static uint32_t counter=0;
+  int64_t now=ps_time_now();
+  return (uint32_t)now^(uint32_t)(now>>32)^(__atomic_add_fetch(&counter,1,__ATOMIC_RELAXED)*0x9e3779b9);
+}
+
+static uint32_t ps_game_take_seed(struct ps_game *game) {
+  if (game->seed_fixed) {
+    game->seed_fixed=0;
+  } else {
+    game->seed=ps_game_fresh_seed();
+  }
+  return game->seed;
+}
+
+/* Everything the generator needs from us.
+ */
+
+static void ps_game_compose_scgen_request(struct ps_scgen_request *request,const struct ps_game *game) {
+  request->playerc=game->playerc;
+  request->difficulty=game->difficulty;
+  request->length=game->length;
+  request->skills=0;
+  int i; for (i=0;i<game->playerc;i++) request->skills|=game->playerv[i]->plrdef->skills;
+  request->seed=game->seed;
+}
+
+/* Begin background generation.
+ * A fixed seed is only peeked at here; it's consumed when ps_game_generate() commits.
+ */
+
+int ps_game_pregenerate(struct ps_game *game) {
+  if (!game) return -1;
+  if (!ps_game_ready_to_generate(game)) return 0;
+  if (!game->pregen) {
+    if (!(game->pregen=ps_scgen_async_new())) return -1;
+  }
+  struct ps_scgen_request request;
+  ps_game_compose_scgen_request(&request,game);
+  if (!game->seed_fixed) request.seed=ps_game_fresh_seed();
+  return ps_scgen_async_request(game->pregen,&request);
+}
+
+/* Take the background scenario, if there is one for our settings.
+ * Returns >0 if we did.
+ */
+
+static int ps_game_take_pregenerated(struct ps_game *game) {
+  if (!game->pregen) return 0;
+  struct ps_scgen_request request;
+  ps_game_compose_scgen_request(&request,game);
+  struct ps_scenario *scenario=0;
+  uint32_t seed=0;
+  int err=ps_scgen_async_take(&scenario,&seed,game->pregen,&request);
+  if (err<=0) return err;
+  if (game->seed_fixed&&(seed!=game->seed)) {
+    // Settings changed after the seed was fixed. Unusual, but the fixed seed wins.
+    ps_scenario_del(scenario);
+    return 0;
+  }
+  game->seed_fixed=0;
+  game->seed=seed;
+  game->scenario=scenario;
+  return 1;
+}
+
 /* Generate scenario.
  */
  
@@ -113,12 +192,21 @@ int ps_game_generate(struct ps_game *game) {
   }
   game->npgcc=0; // Don't pop them; we just deleted the grids.
 
+  int err=ps_game_take_pregenerated(game);
+  if (err<0) return -1;
+  if (err>0) {
+    game->gridx=-1;
+    game->gridy=-1;
+    return 0;
+  }
+
   struct ps_scgen *scgen=ps_scgen_new();
   if (!scgen) return -1;
 
   scgen->playerc=game->playerc;
   scgen->difficulty=game->difficulty;
   scgen->length=game->length;
+  scgen->seed=ps_game_take_seed(game);
 
   scgen->skills=0;
   int i; for (i=0;i<game->playerc;i++) scgen->skills|=game->playerv[i]->plrdef->skills;
@@ -161,6 +249,7 @@ int _ps_game_generate_test(struct ps_game *game,int regionid,int blueprintid,...
   scgen->playerc=game->playerc;
   scgen->difficulty=game->difficulty;
   scgen->length=game->length;
+  scgen->seed=ps_game_take_seed(game);
 
   scgen->skills=0;
   int i; for (i=0;i<game->playerc;i++) scgen->skills|=game->playerv[i]->plrdef->skills;
@@ -218,6 +307,7 @@ int ps_game_generate_all_blueprints_test(struct ps_game *game,int blueprintidlo,
   scgen->playerc=game->playerc;
   scgen->difficulty=game->difficulty;
   scgen->length=game->length;
+  scgen->seed=ps_game_take_seed(game);
   scgen->regionid=regionid;
 
   scgen->skills=0;
@@ -0,0 +1,326 @@
+#include "ps.h"
+#include "ps_gridpath.h"
+#include "ps_path.h"
+#include "scenario/ps_grid.h"
+#include "util/ps_geometry.h"
+
+/* Heap entries pack the estimate, a tie breaker, and the cell index into 32 bits.
+ * Among equal estimates, we prefer the cell farthest from the start; that keeps A* from flooding open rooms.
+ */
+
+#if PS_GRID_SIZE>512
+  #error "ps_gridpath heap packing assumes no more than 512 cells."
+#endif
+
+#define PS_GRIDPATH_KEY(estimate,cost,cellp) (((uint32_t)(estimate)<<18)|((uint32_t)(511-(cost))<<9)|(uint32_t)(cellp))
+#define PS_GRIDPATH_KEY_CELLP(key) ((key)&0x1ff)
+
+/* Object lifecycle.
+ */
+
+struct ps_gridpath *ps_gridpath_new() {
+  struct ps_gridpath *gridpath=calloc(1,sizeof(struct ps_gridpath));
+  if (!gridpath) return 0;
+  return gridpath;
+}
+
+void ps_gridpath_del(struct ps_gridpath *gridpath) {
+  if (!gridpath) return;
+  free(gridpath);
+}
+
+void ps_gridpath_invalidate(struct ps_gridpath *gridpath) {
+  if (!gridpath) return;
+  gridpath->fieldc=0;
+  gridpath->fieldp=0;
+}
+
+/* Cell helpers.
+ */
+
+static inline int ps_gridpath_passable(const struct ps_grid *grid,int cellp,uint16_t impassable) {
+  uint8_t physics=grid->cellv[cellp].physics;
+  if (physics>=16) return 1;
+  return !((1<<physics)&impassable);
+}
+
+static inline int ps_gridpath_clamp_col(int x) {
+  if (x<0) return 0;
+  if (x>=PS_GRID_COLC) return PS_GRID_COLC-1;
+  return x;
+}
+
+static inline int ps_gridpath_clamp_row(int y) {
+  if (y<0) return 0;
+  if (y>=PS_GRID_ROWC) return PS_GRID_ROWC-1;
+  return y;
+}
+
+static inline int ps_gridpath_abs(int n) {
+  return (n<0)?-n:n;
+}
+
+/* Binary heap.
+ */
+
+static void ps_gridpath_heap_push(struct ps_gridpath *gridpath,uint32_t key) {
+  int p=gridpath->heapc++;
+  while (p>0) {
+    int parentp=(p-1)>>1;
+    if (gridpath->heapv[parentp]<=key) break;
+    gridpath->heapv[p]=gridpath->heapv[parentp];
+    p=parentp;
+  }
+  gridpath->heapv[p]=key;
+}
+
+static uint32_t ps_gridpath_heap_pop(struct ps_gridpath *gridpath) {
+  uint32_t result=gridpath->heapv[0];
+  uint32_t key=gridpath->heapv[--(gridpath->heapc)];
+  int c=gridpath->heapc,p=0;
+  while (1) {
+    int childp=(p<<1)+1;
+    if (childp>=c) break;
+    if ((childp+1<c)&&(gridpath->heapv[childp+1]<gridpath->heapv[childp])) childp++;
+    if (key<=gridpath->heapv[childp]) break;
+    gridpath->heapv[p]=gridpath->heapv[childp];
+    p=childp;
+  }
+  if (c>0) gridpath->heapv[p]=key;
+  return result;
+}
+
+/* A* from (srcp) to (dstp), both in the grid and passable.
+ * On success, (fromv) links (dstp) back to (srcp).
+ */
+
+static int ps_gridpath_search(struct ps_gridpath *gridpath,const struct ps_grid *grid,int dstp,int srcp,uint16_t impassable) {
+  memset(gridpath->closedv,0,sizeof(gridpath->closedv));
+  memset(gridpath->openedv,0,sizeof(gridpath->openedv));
+  gridpath->heapc=0;
+
+  int dstx=dstp%PS_GRID_COLC,dsty=dstp/PS_GRID_COLC;
+  #define ESTIMATE(cellp) (ps_gridpath_abs((cellp)%PS_GRID_COLC-dstx)+ps_gridpath_abs((cellp)/PS_GRID_COLC-dsty))
+
+  gridpath->openedv[srcp>>5]|=1<<(srcp&31);
+  gridpath->costv[srcp]=0;
+  gridpath->fromv[srcp]=-1;
+  ps_gridpath_heap_push(gridpath,PS_GRIDPATH_KEY(ESTIMATE(srcp),0,srcp));
+
+  while (gridpath->heapc>0) {
+    int cellp=PS_GRIDPATH_KEY_CELLP(ps_gridpath_heap_pop(gridpath));
+    if (gridpath->closedv[cellp>>5]&(1<<(cellp&31))) continue; // Stale entry, we found a better way already.
+    if (cellp==dstp) return 0;
+    gridpath->closedv[cellp>>5]|=1<<(cellp&31);
+
+    int col=cellp%PS_GRID_COLC,row=cellp/PS_GRID_COLC;
+    int cost=gridpath->costv[cellp]+1;
+    int neighborv[4],neighborc=0;
+    if (row>0) neighborv[neighborc++]=cellp-PS_GRID_COLC;
+    if (row<PS_GRID_ROWC-1) neighborv[neighborc++]=cellp+PS_GRID_COLC;
+    if (col>0) neighborv[neighborc++]=cellp-1;
+    if (col<PS_GRID_COLC-1) neighborv[neighborc++]=cellp+1;
+    int i=0; for (;i<neighborc;i++) {
+      int np=neighborv[i];
+      if (gridpath->closedv[np>>5]&(1<<(np&31))) continue;
+      if (!ps_gridpath_passable(grid,np,impassable)) continue;
+      if (gridpath->openedv[np>>5]&(1<<(np&31))) {
+        if (gridpath->costv[np]<=cost) continue;
+      } else {
+        gridpath->openedv[np>>5]|=1<<(np&31);
+      }
+      gridpath->costv[np]=cost;
+      gridpath->fromv[np]=cellp;
+      ps_gridpath_heap_push(gridpath,PS_GRIDPATH_KEY(cost+ESTIMATE(np),cost,np));
+    }
+  }
+
+  #undef ESTIMATE
+  return -1;
+}
+
+/* Find a cached field.
+ */
+
+static struct ps_gridpath_field *ps_gridpath_find_field(
+  struct ps_gridpath *gridpath,const struct ps_grid *grid,int x,int y,uint16_t impassable
+) {
+  struct ps_gridpath_field *field=gridpath->fieldv;
+  int i=gridpath->fieldc; for (;i-->0;field++) {
+    if (field->grid!=grid) continue;
+    if ((field->x!=x)||(field->y!=y)) continue;
+    if (field->impassable!=impassable) continue;
+    return field;
+  }
+  return 0;
+}
+
+/* Build a field, breadth-first from the target.
+ */
+
+static void ps_gridpath_build_field(struct ps_gridpath *gridpath,struct ps_gridpath_field *field,const struct ps_grid *grid,int x,int y,uint16_t impassable) {
+  field->grid=grid;
+  field->x=x;
+  field->y=y;
+  field->impassable=impassable;
+  memset(field->distv,0xff,sizeof(field->distv));
+
+  int16_t *queuev=gridpath->queuev;
+  int queuep=0,queuec=0;
+  int cellp=y*PS_GRID_COLC+x;
+  field->distv[cellp]=0;
+  queuev[queuec++]=cellp;
+  while (queuep<queuec) {
+    cellp=queuev[queuep++];
+    int col=cellp%PS_GRID_COLC,row=cellp/PS_GRID_COLC;
+    uint16_t dist=field->distv[cellp]+1;
+    int neighborv[4],neighborc=0;
+    if (row>0) neighborv[neighborc++]=cellp-PS_GRID_COLC;
+    if (row<PS_GRID_ROWC-1) neighborv[neighborc++]=cellp+PS_GRID_COLC;
+    if (col>0) neighborv[neighborc++]=cellp-1;
+    if (col<PS_GRID_COLC-1) neighborv[neighborc++]=cellp+1;
+    int i=0; for (;i<neighborc;i++) {
+      int np=neighborv[i];
+      if (field->distv[np]!=PS_GRIDPATH_UNREACHABLE) continue;
+      if (!ps_gridpath_passable(grid,np,impassable)) continue;
+      field->distv[np]=dist;
+      queuev[queuec++]=np;
+    }
+  }
+}
+
+/* Get field, public.
+ */
+
+const uint16_t *ps_gridpath_get_field(
+  struct ps_gridpath *gridpath,const struct ps_grid *grid,
+  int x,int y,uint16_t impassable
+) {
+  if (!gridpath||!grid) return 0;
+  if ((x<0)||(x>=PS_GRID_COLC)) return 0;
+  if ((y<0)||(y>=PS_GRID_ROWC)) return 0;
+  if (!ps_gridpath_passable(grid,y*PS_GRID_COLC+x,impassable)) return 0;
+
+  struct ps_gridpath_field *field=ps_gridpath_find_field(gridpath,grid,x,y,impassable);
+  if (field) {
+    gridpath->field_hitc++;
+    return field->distv;
+  }
+
+  if (gridpath->fieldc<PS_GRIDPATH_FIELD_LIMIT) {
+    field=gridpath->fieldv+gridpath->fieldc++;
+  } else {
+    field=gridpath->fieldv+gridpath->fieldp;
+    if (++(gridpath->fieldp)>=PS_GRIDPATH_FIELD_LIMIT) gridpath->fieldp=0;
+  }
+  ps_gridpath_build_field(gridpath,field,grid,x,y,impassable);
+  gridpath->field_buildc++;
+  return field->distv;
+}
+
+/* Direction from field.
+ */
+
+int ps_gridpath_field_direction(const uint16_t *distv,int x,int y) {
+  if (!distv) return -1;
+  if ((x<0)||(x>=PS_GRID_COLC)) return -1;
+  if ((y<0)||(y>=PS_GRID_ROWC)) return -1;
+  int cellp=y*PS_GRID_COLC+x;
+  uint16_t dist=distv[cellp];
+  if (dist==PS_GRIDPATH_UNREACHABLE) return -1;
+  if (!dist) return 0;
+  dist--;
+  if ((y>0)&&(distv[cellp-PS_GRID_COLC]==dist)) return PS_DIRECTION_NORTH;
+  if ((y<PS_GRID_ROWC-1)&&(distv[cellp+PS_GRID_COLC]==dist)) return PS_DIRECTION_SOUTH;
+  if ((x>0)&&(distv[cellp-1]==dist)) return PS_DIRECTION_WEST;
+  if ((x<PS_GRID_COLC-1)&&(distv[cellp+1]==dist)) return PS_DIRECTION_EAST;
+  return -1;
+}
+
+/* Walk in from offscreen.
+ * Adds every cell from (srcx,srcy) up to but not including the nearest cell in the grid, and returns that cell's index.
+ * Offscreen cells take the physics of the nearest edge cell.
+ */
+
+static int ps_gridpath_enter(struct ps_path *path,const struct ps_grid *grid,int srcx,int srcy,uint16_t impassable) {
+  int entryx=ps_gridpath_clamp_col(srcx);
+  int entryy=ps_gridpath_clamp_row(srcy);
+  int x=srcx,y=srcy;
+  while ((x!=entryx)||(y!=entryy)) {
+    int cellp=ps_gridpath_clamp_row(y)*PS_GRID_COLC+ps_gridpath_clamp_col(x);
+    if (!ps_gridpath_passable(grid,cellp,impassable)) return -1;
+    if (ps_path_add(path,x,y)<0) return -1;
+    if (x<entryx) x++;
+    else if (x>entryx) x--;
+    else if (y<entryy) y++;
+    else y--;
+  }
+  int entryp=entryy*PS_GRID_COLC+entryx;
+  if (!ps_gridpath_passable(grid,entryp,impassable)) return -1;
+  return entryp;
+}
+
+/* Compose path, public.
+ */
+
+int ps_gridpath_compose(
+  struct ps_path *path,struct ps_gridpath *gridpath,const struct ps_grid *grid,
+  int dstx,int dsty,int srcx,int srcy,uint16_t impassable
+) {
+  if (!path||!gridpath||!grid) return -1;
+  path->c=0;
+  if ((srcx<-PS_GRID_COLC)||(srcx>PS_GRID_COLC<<1)) return -1;
+  if ((srcy<-PS_GRID_ROWC)||(srcy>PS_GRID_ROWC<<1)) return -1;
+  gridpath->pathc++;
+
+  if ((srcx==dstx)&&(srcy==dsty)) {
+    int cellp=ps_gridpath_clamp_row(srcy)*PS_GRID_COLC+ps_gridpath_clamp_col(srcx);
+    if (!ps_gridpath_passable(grid,cellp,impassable)) return -1;
+    return ps_path_add(path,srcx,srcy);
+  }
+  if ((dstx<0)||(dstx>=PS_GRID_COLC)) return -1;
+  if ((dsty<0)||(dsty>=PS_GRID_ROWC)) return -1;
+  int dstp=dsty*PS_GRID_COLC+dstx;
+  if (!ps_gridpath_passable(grid,dstp,impassable)) return -1;
+
+  int entryp=ps_gridpath_enter(path,grid,srcx,srcy,impassable);
+  if (entryp<0) {
+    path->c=0;
+    return -1;
+  }
+
+  /* If somebody already built a field to this destination, walk down it. */
+  struct ps_gridpath_field *field=ps_gridpath_find_field(gridpath,grid,dstx,dsty,impassable);
+  if (field) {
+    gridpath->field_hitc++;
+    if (field->distv[entryp]==PS_GRIDPATH_UNREACHABLE) {
+      path->c=0;
+      return -1;
+    }
+    int x=entryp%PS_GRID_COLC,y=entryp/PS_GRID_COLC,direction;
+    if (ps_path_add(path,x,y)<0) return -1;
+    while ((direction=ps_gridpath_field_direction(field->distv,x,y))>0) {
+      struct ps_vector d=ps_vector_from_direction(direction);
+      x+=d.dx;
+      y+=d.dy;
+      if (ps_path_add(path,x,y)<0) return -1;
+    }
+    return 0;
+  }
+
+  /* Search, then read the result backward into (queuev) and forward into (path). */
+  if (ps_gridpath_search(gridpath,grid,dstp,entryp,impassable)<0) {
+    path->c=0;
+    return -1;
+  }
+  int stepc=0,cellp=dstp;
+  while (cellp>=0) {
+    gridpath->queuev[stepc++]=cellp;
+    cellp=gridpath->fromv[cellp];
+  }
+  while (stepc-->0) {
+    cellp=gridpath->queuev[stepc];
+    if (ps_path_add(path,cellp%PS_GRID_COLC,cellp/PS_GRID_COLC)<0) return -1;
+  }
+  return 0;
+}
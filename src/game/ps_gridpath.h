@@ -0,0 +1,89 @@
+/* ps_gridpath.h
+ * Shortest paths and distance fields over one grid.
+ * All scratch space is allocated once with the object; queries never allocate, except to grow the output path.
+ * Moves are orthogonal, one cell at a time, never into a cell whose physics is in (impassable).
+ * ps_game owns one of these. Sprites should use ps_game_compose_grid_path() and ps_game_get_grid_distance_field().
+ */
+
+#ifndef PS_GRIDPATH_H
+#define PS_GRIDPATH_H
+
+struct ps_grid;
+struct ps_path;
+
+#define PS_GRIDPATH_UNREACHABLE 0xffff
+
+/* How many distance fields we keep at once.
+ * A frame with more distinct targets than this still works, it just rebuilds some fields.
+ */
+#define PS_GRIDPATH_FIELD_LIMIT 8
+
+/* Every cell can be pushed at most once per neighbor, so this heap can't overflow.
+ */
+#define PS_GRIDPATH_HEAP_LIMIT (PS_GRID_SIZE*4)
+
+struct ps_gridpath_field {
+  const struct ps_grid *grid; // WEAK, only for matching. Never dereferenced after build.
+  int x,y;
+  uint16_t impassable;
+  uint16_t distv[PS_GRID_SIZE]; // Steps from each cell to (x,y), or PS_GRIDPATH_UNREACHABLE.
+};
+
+struct ps_gridpath {
+
+  // A* scratch:
+  uint32_t closedv[(PS_GRID_SIZE+31)>>5]; // Visited bitmap, one bit per cell.
+  uint32_t openedv[(PS_GRID_SIZE+31)>>5]; // Nonzero if (costv,fromv) are valid for this cell.
+  uint16_t costv[PS_GRID_SIZE]; // Steps from start, best known.
+  int16_t fromv[PS_GRID_SIZE]; // Previous cell on the best known path.
+  uint32_t heapv[PS_GRIDPATH_HEAP_LIMIT]; // Open list, binary min-heap. Estimate, tie breaker, and cell, packed.
+  int heapc;
+
+  // Breadth-first scratch, for fields:
+  int16_t queuev[PS_GRID_SIZE];
+
+  struct ps_gridpath_field fieldv[PS_GRIDPATH_FIELD_LIMIT];
+  int fieldc;
+  int fieldp; // Next to evict, once full.
+
+  // Statistics, just for curiosity:
+  int pathc; // Paths composed.
+  int field_buildc; // Fields built from scratch.
+  int field_hitc; // Field requests answered from the cache, including paths that followed a field.
+};
+
+struct ps_gridpath *ps_gridpath_new();
+void ps_gridpath_del(struct ps_gridpath *gridpath);
+
+/* Drop all cached fields.
+ * Call whenever the grid changes. ps_game also does it at the start of every update.
+ */
+void ps_gridpath_invalidate(struct ps_gridpath *gridpath);
+
+/* Wipe (path) and replace with a shortest path from (srcx,srcy) to (dstx,dsty), including both endpoints.
+ * (srcx,srcy) may be outside the grid: We walk straight in, treating offscreen cells like the nearest edge cell.
+ * (dstx,dsty) must be in the grid, unless it equals the source.
+ * If a field to (dstx,dsty) is cached, we follow it instead of searching.
+ * Returns <0 if there is no such path.
+ */
+int ps_gridpath_compose(
+  struct ps_path *path,struct ps_gridpath *gridpath,const struct ps_grid *grid,
+  int dstx,int dsty,int srcx,int srcy,uint16_t impassable
+);
+
+/* Distance from every cell to (x,y), or PS_GRIDPATH_UNREACHABLE.
+ * Returns an array of PS_GRID_SIZE, indexed (row*PS_GRID_COLC+col), valid until the next invalidation.
+ * Returns null if (x,y) is outside the grid or impassable itself.
+ * Many sprites chasing the same target in one frame share one field.
+ */
+const uint16_t *ps_gridpath_get_field(
+  struct ps_gridpath *gridpath,const struct ps_grid *grid,
+  int x,int y,uint16_t impassable
+);
+
+/* Which way to step from (x,y) to get closer to the field's target?
+ * Returns PS_DIRECTION_*, or zero if (x,y) is the target, or <0 if unreachable or out of bounds.
+ */
+int ps_gridpath_field_direction(const uint16_t *distv,int x,int y);
+
+#endif
@@ -0,0 +1,267 @@
+#include "ps.h"
+#include "ps_particles.h"
+#include "video/ps_video.h"
+#include "akgl/akgl.h"
+
+/* New.
+ */
+
+struct ps_particles *ps_particles_new() {
+  struct ps_particles *particles=calloc(1,sizeof(struct ps_particles));
+  if (!particles) return 0;
+  return particles;
+}
+
+/* Delete.
+ */
+
+void ps_particles_del(struct ps_particles *particles) {
+  if (!particles) return;
+  if (particles->xv) free(particles->xv);
+  if (particles->yv) free(particles->yv);
+  if (particles->dxv) free(particles->dxv);
+  if (particles->dyv) free(particles->dyv);
+  if (particles->ttlv) free(particles->ttlv);
+  if (particles->lifev) free(particles->lifev);
+  if (particles->layerv) free(particles->layerv);
+  if (particles->tv) free(particles->tv);
+  if (particles->dtv) free(particles->dtv);
+  if (particles->tsidv) free(particles->tsidv);
+  if (particles->tileidv) free(particles->tileidv);
+  if (particles->sizev) free(particles->sizev);
+  if (particles->shrinkv) free(particles->shrinkv);
+  if (particles->fadeinv) free(particles->fadeinv);
+  if (particles->fadeoutv) free(particles->fadeoutv);
+  if (particles->rgbav) free(particles->rgbav);
+  if (particles->rgbzv) free(particles->rgbzv);
+  if (particles->vtxv) free(particles->vtxv);
+  free(particles);
+}
+
+/* Clear.
+ */
+
+int ps_particles_clear(struct ps_particles *particles) {
+  if (!particles) return -1;
+  particles->c=0;
+  return 0;
+}
+
+/* Grow every field array together.
+ */
+
+static int ps_particles_require(struct ps_particles *particles) {
+  if (particles->c<particles->a) return 0;
+  int na=particles->a+256;
+  if (na>PS_PARTICLES_LIMIT) na=PS_PARTICLES_LIMIT;
+  if (na<=particles->c) return -1;
+  void *nv;
+  #define GROW(field) { \
+    if (!(nv=realloc(particles->field,sizeof(*particles->field)*na))) return -1; \
+    particles->field=nv; \
+  }
+  GROW(xv)
+  GROW(yv)
+  GROW(dxv)
+  GROW(dyv)
+  GROW(ttlv)
+  GROW(lifev)
+  GROW(layerv)
+  GROW(tv)
+  GROW(dtv)
+  GROW(tsidv)
+  GROW(tileidv)
+  GROW(sizev)
+  GROW(shrinkv)
+  GROW(fadeinv)
+  GROW(fadeoutv)
+  GROW(rgbav)
+  GROW(rgbzv)
+  GROW(vtxv)
+  #undef GROW
+  particles->a=na;
+  return 0;
+}
+
+/* Add particle.
+ */
+
+static uint8_t ps_particles_clamp_u8(int n) {
+  if (n<0) return 0;
+  if (n>0xff) return 0xff;
+  return n;
+}
+
+int ps_particles_add(struct ps_particles *particles,const struct ps_particle *particle) {
+  if (!particles||!particle) return -1;
+  if (particle->ttl<1) return 0;
+  if (particles->c>=PS_PARTICLES_LIMIT) return 0;
+  if (ps_particles_require(particles)<0) return -1;
+
+  int p=particles->c++;
+  particles->xv[p]=particle->x;
+  particles->yv[p]=particle->y;
+  particles->dxv[p]=particle->dx;
+  particles->dyv[p]=particle->dy;
+  particles->ttlv[p]=particle->ttl;
+  particles->lifev[p]=particle->ttl;
+  particles->layerv[p]=particle->layer;
+  particles->tv[p]=particle->t<<8;
+  particles->dtv[p]=particle->dt;
+  particles->tsidv[p]=particle->tsid;
+  particles->tileidv[p]=particle->tileid;
+  particles->sizev[p]=particle->size;
+  particles->shrinkv[p]=ps_particles_clamp_u8(particle->shrink);
+  particles->fadeinv[p]=ps_particles_clamp_u8(particle->fadein);
+  particles->fadeoutv[p]=ps_particles_clamp_u8(particle->fadeout);
+  particles->rgbav[p]=particle->rgba;
+  particles->rgbzv[p]=particle->rgbz;
+
+  return 1;
+}
+
+/* Move a run of particles down, all fields.
+ */
+
+static void ps_particles_move(struct ps_particles *particles,int dstp,int srcp,int c) {
+  #define MOVE(field) memmove(particles->field+dstp,particles->field+srcp,sizeof(*particles->field)*c);
+  MOVE(xv)
+  MOVE(yv)
+  MOVE(dxv)
+  MOVE(dyv)
+  MOVE(ttlv)
+  MOVE(lifev)
+  MOVE(layerv)
+  MOVE(tv)
+  MOVE(dtv)
+  MOVE(tsidv)
+  MOVE(tileidv)
+  MOVE(sizev)
+  MOVE(shrinkv)
+  MOVE(fadeinv)
+  MOVE(fadeoutv)
+  MOVE(rgbav)
+  MOVE(rgbzv)
+  #undef MOVE
+}
+
+/* Update.
+ * Motion first, in one pass with no branches.
+ * Then squeeze out the expired ones, keeping order so the newest still draw on top.
+ * Particles are added in bursts of equal lifetime, so the dead ones are usually one run at the front.
+ */
+
+int ps_particles_update(struct ps_particles *particles) {
+  if (!particles) return -1;
+  int c=particles->c;
+  if (c<1) return 0;
+
+  float *xv=particles->xv,*yv=particles->yv;
+  const float *dxv=particles->dxv,*dyv=particles->dyv;
+  uint16_t *tv=particles->tv;
+  const uint16_t *dtv=particles->dtv;
+  int16_t *ttlv=particles->ttlv;
+  int i;
+  for (i=0;i<c;i++) {
+    xv[i]+=dxv[i];
+    yv[i]+=dyv[i];
+    tv[i]+=dtv[i];
+    ttlv[i]--;
+  }
+
+  int dstp=0,srcp=0;
+  while (srcp<c) {
+    if (ttlv[srcp]<=0) {
+      srcp++;
+      continue;
+    }
+    int runc=1;
+    while ((srcp+runc<c)&&(ttlv[srcp+runc]>0)) runc++;
+    if (dstp!=srcp) ps_particles_move(particles,dstp,srcp,runc);
+    dstp+=runc;
+    srcp+=runc;
+  }
+  particles->c=dstp;
+
+  return 0;
+}
+
+/* Compose vertices.
+ */
+
+int ps_particles_compose(struct akgl_vtx_maxtile **dst,struct ps_particles *particles,uint8_t tsid,int layer,int offx,int offy) {
+  if (!dst||!particles) return -1;
+  struct akgl_vtx_maxtile *vtx=particles->vtxv;
+  *dst=vtx;
+  int i=0; for (;i<particles->c;i++) {
+    if (particles->tsidv[i]!=tsid) continue;
+    if (particles->layerv[i]!=layer) continue;
+    int ttl=particles->ttlv[i];
+    int life=particles->lifev[i];
+    int age=life-ttl;
+
+    vtx->x=(int)particles->xv[i]+offx;
+    vtx->y=(int)particles->yv[i]+offy;
+    vtx->tileid=particles->tileidv[i];
+    vtx->t=particles->tv[i]>>8;
+    vtx->tr=vtx->tg=vtx->tb=vtx->ta=0;
+    vtx->xform=AKGL_XFORM_NONE;
+
+    if (age<particles->fadeinv[i]) vtx->a=(age*0xff)/particles->fadeinv[i];
+    else if (ttl<particles->fadeoutv[i]) vtx->a=(ttl*0xff)/particles->fadeoutv[i];
+    else vtx->a=0xff;
+
+    if (ttl<particles->shrinkv[i]) vtx->size=1+(ttl*(particles->sizev[i]-1))/particles->shrinkv[i];
+    else vtx->size=particles->sizev[i];
+
+    uint32_t rgba=particles->rgbav[i],rgbz=particles->rgbzv[i];
+    if (rgba==rgbz) {
+      vtx->pr=rgba>>24;
+      vtx->pg=rgba>>16;
+      vtx->pb=rgba>>8;
+    } else {
+      vtx->pr=(int)(rgba>>24)+((int)(rgbz>>24)-(int)(rgba>>24))*age/life;
+      vtx->pg=(int)((rgba>>16)&0xff)+((int)((rgbz>>16)&0xff)-(int)((rgba>>16)&0xff))*age/life;
+      vtx->pb=(int)((rgba>>8)&0xff)+((int)((rgbz>>8)&0xff)-(int)((rgba>>8)&0xff))*age/life;
+    }
+
+    vtx++;
+  }
+  return vtx-particles->vtxv;
+}
+
+/* Draw.
+ */
+
+int ps_particles_draw(struct ps_particles *particles,int layer,int offx,int offy) {
+  if (!particles) return -1;
+  if (particles->c<1) return 0;
+
+  /* Usually there's just one tilesheet. Send a batch for each, the first time we see it. */
+  uint8_t tsidv[32]={0};
+  int i=0; for (;i<particles->c;i++) {
+    if (particles->layerv[i]!=layer) continue;
+    uint8_t tsid=particles->tsidv[i];
+    if (tsidv[tsid>>3]&(1<<(tsid&7))) continue;
+    tsidv[tsid>>3]|=1<<(tsid&7);
+    struct akgl_vtx_maxtile *vtxv=0;
+    int vtxc=ps_particles_compose(&vtxv,particles,tsid,layer,offx,offy);
+    if (vtxc<0) return -1;
+    if (ps_video_draw_maxtile(vtxv,vtxc,tsid)<0) return -1;
+  }
+
+  return 0;
+}
+
+/* Next layer.
+ */
+
+int ps_particles_next_layer(const struct ps_particles *particles,int layer) {
+  int next=INT_MAX;
+  if (!particles) return next;
+  int i=0; for (;i<particles->c;i++) {
+    int q=particles->layerv[i];
+    if ((q>layer)&&(q<next)) next=q;
+  }
+  return next;
+}
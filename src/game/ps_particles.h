@@ -0,0 +1,68 @@
+/* ps_particles.h
+ * Pool of short-lived cosmetic effects: fireworks when something dies, and the flash on a changed tile.
+ * Particles are not sprites. They don't join any group, don't collide, and nobody can find them.
+ * Storage is one array per field, so the per-frame update is a single pass over plain numbers.
+ * Everything but motion (alpha, size, color) is derived from age at draw time.
+ * Each particle has a sprite layer, and draws after the sprites of that layer, one batch of maxtile vertices per tilesheet.
+ */
+
+#ifndef PS_PARTICLES_H
+#define PS_PARTICLES_H
+
+struct akgl_vtx_maxtile;
+
+/* Beyond this, new particles are quietly dropped. */
+#define PS_PARTICLES_LIMIT 32768
+
+/* Describes one particle at birth. Only used for ps_particles_add().
+ */
+struct ps_particle {
+  double x,y;
+  double dx,dy; // Pixels per frame.
+  int ttl; // Frames.
+  int layer; // Same as sprites. We draw on top of any sprite in this layer.
+  uint8_t tsid,tileid;
+  uint8_t t; // Initial rotation.
+  int dt; // Rotation per frame, 8.8 fixed point.
+  uint8_t size;
+  int shrink; // Size ramps down to 1 over so many frames at the end.
+  uint32_t rgba,rgbz; // Primary color at birth and death, linear between. (alpha ignored)
+  int fadein,fadeout; // Frames of alpha ramp at each end.
+};
+
+struct ps_particles {
+  int c,a;
+  float *xv,*yv,*dxv,*dyv;
+  int16_t *ttlv,*lifev,*layerv;
+  uint16_t *tv,*dtv;
+  uint8_t *tsidv,*tileidv,*sizev,*shrinkv,*fadeinv,*fadeoutv;
+  uint32_t *rgbav,*rgbzv;
+  struct akgl_vtx_maxtile *vtxv; // Scratch for drawing.
+};
+
+struct ps_particles *ps_particles_new();
+void ps_particles_del(struct ps_particles *particles);
+
+int ps_particles_clear(struct ps_particles *particles);
+
+/* Returns >0 if added, 0 if we're full, or <0 for real errors.
+ */
+int ps_particles_add(struct ps_particles *particles,const struct ps_particle *particle);
+
+/* Advance one frame and drop the expired ones.
+ */
+int ps_particles_update(struct ps_particles *particles);
+
+/* Compose vertices for every particle on one tilesheet and layer, into our scratch buffer.
+ * Returns the count, and we point (*dst) at them.
+ * For the game's renderer, ps_particles_draw() does this for each tilesheet in use on one layer and hands off to ps_video.
+ */
+int ps_particles_compose(struct akgl_vtx_maxtile **dst,struct ps_particles *particles,uint8_t tsid,int layer,int offx,int offy);
+int ps_particles_draw(struct ps_particles *particles,int layer,int offx,int offy);
+
+/* Lowest layer above (layer) that has any particles, or INT_MAX if none.
+ * Start from INT_MIN.
+ */
+int ps_particles_next_layer(const struct ps_particles *particles,int layer);
+
+#endif
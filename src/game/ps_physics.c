@@ -1,6 +1,7 @@
 #include "ps.h"
 #include "ps_physics.h"
 #include "ps_sprite.h"
+#include "ps_broadphase.h"
 #include "scenario/ps_grid.h"
 #include "scenario/ps_blueprint.h"
 #include <math.h>
@@ -16,6 +17,11 @@
 struct ps_physics *ps_physics_new() {
   struct ps_physics *physics=calloc(1,sizeof(struct ps_physics));
   if (!physics) return 0;
+  if (!(physics->broadphase=ps_broadphase_new())) {
+    free(physics);
+    return 0;
+  }
+  physics->incremental=1;
   return physics;
 }
 
@@ -26,6 +32,7 @@ void ps_physics_del(struct ps_physics *physics) {
   ps_grid_del(physics->grid);
   if (physics->collv) free(physics->collv);
   if (physics->eventv) free(physics->eventv);
+  ps_broadphase_del(physics->broadphase);
   free(physics);
 }
 
@@ -56,6 +63,24 @@ int ps_physics_set_grid(struct ps_physics *physics,struct ps_grid *grid) {
   return 0;
 }
 
+int ps_physics_enable_broadphase(struct ps_physics *physics,int enable) {
+  if (!physics) return -1;
+  if (enable) {
+    if (physics->broadphase) return 0;
+    if (!(physics->broadphase=ps_broadphase_new())) return -1;
+  } else {
+    ps_broadphase_del(physics->broadphase);
+    physics->broadphase=0;
+  }
+  return 0;
+}
+
+int ps_physics_enable_incremental(struct ps_physics *physics,int enable) {
+  if (!physics) return -1;
+  physics->incremental=enable?1:0;
+  return 0;
+}
+
 /* Search events.
  */
 
@@ -171,6 +196,7 @@ static inline struct ps_circle ps_sprite_circle(const struct ps_sprite *spr) {
  */
  
 static int ps_physics_check_sprites(struct ps_physics *physics,struct ps_sprite *a,struct ps_sprite *b) {
+  physics->stats.pairc_tested++;
   if ((a->type==b->type)&&a->type->ignore_collisions_on_same_type) return 0;
   struct ps_overlap overlap;
   switch (a->shape) {
@@ -346,7 +372,6 @@ static int ps_physics_check_grid(struct ps_physics *physics,struct ps_sprite *sp
  */
 
 static int ps_physics_recheck_grid(struct ps_physics *physics,struct ps_coll *coll) {
-return 1;
   struct ps_fbox cellbox=ps_fbox(coll->col*PS_TILESIZE,(coll->col+1)*PS_TILESIZE,coll->row*PS_TILESIZE,(coll->row+1)*PS_TILESIZE);
   struct ps_circle cellcircle=ps_circle(coll->col*PS_TILESIZE+(PS_TILESIZE>>1),coll->row*PS_TILESIZE+(PS_TILESIZE>>1),PS_TILESIZE>>1);
   switch (coll->a->shape) {
@@ -364,28 +389,43 @@ return 1;
   return 1;
 }
 
-/* Check collisions for one sprite.
- * (sprindex) is the first index to check; only examine sprites at a higher index than myself.
+/* Count the pairs a naive pass would test, and credit the ones we didn't to (pairc_skipped).
  */
 
-static int ps_physics_detect_collisions_1(struct ps_physics *physics,struct ps_sprite *spr,int sprindex) {
-  int i;
+static int ps_physics_count_colliding_solids(const struct ps_physics *physics) {
+  if (physics->broadphase) return physics->broadphase->entryc;
+  int c=0,i=physics->grp_solid->sprc;
+  while (i-->0) if (physics->grp_solid->sprv[i]->collide_sprites) c++;
+  return c;
+}
 
-  /* Check other sprites. */
-  if (spr->collide_sprites) {
-    for (i=0;i<physics->grp_solid->sprc;i++) {
-      struct ps_sprite *other=physics->grp_solid->sprv[i];
-      if (spr==other) continue;
-      if (!other->collide_sprites) continue;
-      if (ps_physics_check_sprites(physics,spr,other)<0) return -1;
-    }
-  }
+static void ps_physics_record_skipped_pairs(struct ps_physics *physics,int64_t testc) {
+  int64_t solidc=ps_physics_count_colliding_solids(physics);
+  int64_t skipc=((solidc*(solidc-1))>>1)-testc;
+  if (skipc>0) physics->stats.pairc_skipped+=skipc;
+}
 
-  /* Check grid. */
-  if (physics->grid) {
-    if (ps_physics_check_grid(physics,spr)<0) return -1;
-  }
+/* Filters for broadphase.
+ */
+
+static int ps_physics_sprite_collides_sprites(const struct ps_sprite *spr) {
+  return spr->collide_sprites;
+}
+
+static int ps_physics_sprite_is_dirty(const struct ps_sprite *spr) {
+  return spr->phdirty;
+}
 
+/* Detect sprite-on-sprite collisions for the pairs in our broadphase.
+ * Pairs come out in the same order as the naive loop, so resolution is not affected.
+ */
+
+static int ps_physics_check_broadphase_pairs(struct ps_physics *physics) {
+  const struct ps_broadphase_entry *entryv=physics->broadphase->entryv;
+  const struct ps_broadphase_pair *pair=physics->broadphase->pairv;
+  int i=physics->broadphase->pairc; for (;i-->0;pair++) {
+    if (ps_physics_check_sprites(physics,entryv[pair->a].spr,entryv[pair->b].spr)<0) return -1;
+  }
   return 0;
 }
 
@@ -393,6 +433,7 @@ static int ps_physics_detect_collisions_1(struct ps_physics *physics,struct ps_s
  */
 
 static int ps_physics_detect_collisions(struct ps_physics *physics) {
+  int64_t testc0=physics->stats.pairc_tested;
 
   if (physics->grid) {
     int i=0; for (;i<physics->grp_physics->sprc;i++) {
@@ -401,7 +442,11 @@ static int ps_physics_detect_collisions(struct ps_physics *physics) {
     }
   }
 
-  if (physics->grp_solid) {
+  if (physics->grp_solid&&physics->broadphase) {
+    if (ps_broadphase_rebuild(physics->broadphase,physics->grp_solid,ps_physics_sprite_collides_sprites)<0) return -1;
+    if (ps_broadphase_find_pairs(physics->broadphase)<0) return -1;
+    if (ps_physics_check_broadphase_pairs(physics)<0) return -1;
+  } else if (physics->grp_solid) {
     int i=0; for (;i<physics->grp_solid->sprc;i++) {
       struct ps_sprite *a=physics->grp_solid->sprv[i];
       if (!a->collide_sprites) continue;
@@ -413,9 +458,77 @@ static int ps_physics_detect_collisions(struct ps_physics *physics) {
     }
   }
 
+  if (physics->grp_solid) {
+    ps_physics_record_skipped_pairs(physics,physics->stats.pairc_tested-testc0);
+  }
+  return 0;
+}
+
+/* Detect collisions, only for sprites moved by the previous pass.
+ * Any collision not involving a moved sprite was either absent last time, or got resolved, which moves both sprites.
+ * So this finds exactly the same collisions as a full pass, in the same order.
+ */
+
+static int ps_physics_detect_collisions_incremental(struct ps_physics *physics) {
+  int64_t testc0=physics->stats.pairc_tested;
+
+  if (physics->grid) {
+    int i=0; for (;i<physics->grp_physics->sprc;i++) {
+      struct ps_sprite *spr=physics->grp_physics->sprv[i];
+      if (!spr->phdirty) continue;
+      if (ps_physics_check_grid(physics,spr)<0) return -1;
+    }
+  }
+
+  if (physics->grp_solid) {
+    if (ps_broadphase_rebuild(physics->broadphase,physics->grp_solid,ps_physics_sprite_collides_sprites)<0) return -1;
+    if (ps_broadphase_find_pairs_selected(physics->broadphase,ps_physics_sprite_is_dirty)<0) return -1;
+    if (ps_physics_check_broadphase_pairs(physics)<0) return -1;
+    ps_physics_record_skipped_pairs(physics,physics->stats.pairc_tested-testc0);
+  }
+
   return 0;
 }
 
+/* Copy each sprite's (phreconsider) into (phdirty), before ps_physics_begin() clears it.
+ * Returns the count of dirty sprites.
+ */
+
+static int ps_physics_mark_dirty(struct ps_physics *physics) {
+  int dirtyc=0,i;
+  if (physics->grp_solid) {
+    for (i=physics->grp_solid->sprc;i-->0;) {
+      struct ps_sprite *spr=physics->grp_solid->sprv[i];
+      spr->phdirty=0;
+    }
+  }
+  if (physics->grp_physics) {
+    for (i=physics->grp_physics->sprc;i-->0;) {
+      struct ps_sprite *spr=physics->grp_physics->sprv[i];
+      spr->phdirty=0;
+    }
+  }
+  if (physics->grp_solid) {
+    for (i=physics->grp_solid->sprc;i-->0;) {
+      struct ps_sprite *spr=physics->grp_solid->sprv[i];
+      if (spr->phreconsider&&!spr->phdirty) {
+        spr->phdirty=1;
+        dirtyc++;
+      }
+    }
+  }
+  if (physics->grp_physics) {
+    for (i=physics->grp_physics->sprc;i-->0;) {
+      struct ps_sprite *spr=physics->grp_physics->sprv[i];
+      if (spr->phreconsider&&!spr->phdirty) {
+        spr->phdirty=1;
+        dirtyc++;
+      }
+    }
+  }
+  return dirtyc;
+}
+
 /* Resolve one collision.
  */
 
@@ -475,18 +588,30 @@ int ps_physics_update(struct ps_physics *physics) {
   if (!physics) return -1;
 
   physics->eventc=0;
+  physics->stats.updatec++;
   if (ps_physics_unset_sprite_flags(physics)<0) return -1;
 
-  int repp=PS_PHYSICS_REPC;
-  while (repp-->0) {
+  int repp=PS_PHYSICS_REPC,passp=0;
+  for (;repp-->0;passp++) {
+
+    /* In incremental mode, note which sprites moved last time, and terminate if none did. */
+    int incremental=(passp&&physics->incremental&&physics->broadphase);
+    if (incremental) {
+      if (!ps_physics_mark_dirty(physics)) return 0;
+    }
 
     /* Clear our transient state and terminate if there's nothing to do. */
     if (ps_physics_begin(physics)<0) return -1;
     if (!physics->grp_physics) return 0;
     if (physics->grp_physics->sprc<1) return 0;
+    physics->stats.passc++;
 
     /* Detect collisions and terminate if there aren't any. */
-    if (ps_physics_detect_collisions(physics)<0) return -1;
+    if (incremental) {
+      if (ps_physics_detect_collisions_incremental(physics)<0) return -1;
+    } else {
+      if (ps_physics_detect_collisions(physics)<0) return -1;
+    }
     if (!physics->collc) return 0;
 
     /* Resolve collisions. */
@@ -13,10 +13,12 @@ struct ps_sprite;
 struct ps_sprgrp;
 struct ps_sprtype;
 struct ps_grid;
+struct ps_broadphase;
 
 struct ps_coll {
   struct ps_sprite *a,*b; // WEAK; (b) is null if against the grid
-  uint8_t col,row,cellshape; // Valid if (b) is null.
+  int16_t col,row; // Valid if (b) is null. May be OOB.
+  uint8_t cellshape; // Valid if (b) is null.
   struct ps_overlap overlap;
 };
 
@@ -25,6 +27,14 @@ struct ps_physics_event {
   struct ps_sprite *a,*b; // WEAK; (a) is null if against the grid; sorted (a,b); (a<b) always
 };
 
+// Cumulative counters, for measurement. Reset them whenever you like.
+struct ps_physics_stats {
+  int64_t updatec; // Calls to ps_physics_update().
+  int64_t passc; // Relaxation passes run.
+  int64_t pairc_tested; // Sprite pairs given to the narrowphase.
+  int64_t pairc_skipped; // Sprite pairs a naive all-pairs pass would have tested but we didn't.
+};
+
 struct ps_physics {
   struct ps_sprgrp *grp_physics;
   struct ps_sprgrp *grp_solid;
@@ -33,6 +43,9 @@ struct ps_physics {
   int collc,colla;
   struct ps_physics_event *eventv;
   int eventc,eventa;
+  struct ps_broadphase *broadphase; // Optional. Without it, we test every pair of solid sprites.
+  int incremental; // After the first pass, only examine sprites moved by the previous one. Requires broadphase.
+  struct ps_physics_stats stats;
 };
 
 struct ps_physics *ps_physics_new();
@@ -42,6 +55,12 @@ int ps_physics_set_sprgrp_physics(struct ps_physics *physics,struct ps_sprgrp *g
 int ps_physics_set_sprgrp_solid(struct ps_physics *physics,struct ps_sprgrp *grp);
 int ps_physics_set_grid(struct ps_physics *physics,struct ps_grid *grid);
 
+/* Broadphase and incremental detection are enabled by default.
+ * Results are identical either way; this is only for testing and measurement.
+ */
+int ps_physics_enable_broadphase(struct ps_physics *physics,int enable);
+int ps_physics_enable_incremental(struct ps_physics *physics,int enable);
+
 int ps_physics_update(struct ps_physics *physics);
 
 /* Return nonzero if (spr) in the last update collided with something.
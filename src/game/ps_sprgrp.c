@@ -1,6 +1,11 @@
 #include "ps.h"
 #include "ps_sprite.h"
 #include "ps_game.h"
+#include <math.h>
+
+#define PS_SPRGRP_RENDER_INSERTION_BUDGET 4 /* Per sprite, how many moves before insertion sort gives up. */
+#define PS_SPRGRP_RENDER_SCRAMBLED_FRAMES 8 /* After insertion sort gives up, go straight to bucket sort for so many frames. */
+#define PS_SPRGRP_RENDER_LAYER_LIMIT 16 /* Bucket sort only with this many distinct layers or fewer. */
 
 /* Object lifecycle.
  */
@@ -16,6 +21,8 @@ void ps_sprgrp_cleanup(struct ps_sprgrp *grp) {
   if (!grp) return;
   ps_sprgrp_clear(grp);
   if (grp->sprv) free(grp->sprv);
+  if (grp->keyv) free(grp->keyv);
+  if (grp->bucketv) free(grp->bucketv);
   memset(grp,0,sizeof(struct ps_sprgrp));
 }
 
@@ -64,18 +71,6 @@ static int _ps_sprgrp_search(const struct ps_sprgrp *grp,const struct ps_sprite
         return -lo-1;
       }
 
-    case PS_SPRGRP_ORDER_RENDER: {
-        // We could try a binary search first, but I'm not sure it buys us much.
-        int insp=0,i=0;
-        for (;i<grp->sprc;i++) {
-          struct ps_sprite *ckspr=grp->sprv[i];
-          if (ckspr==spr) return i;
-          if (ckspr->layer<spr->layer) insp=i+1;
-          else if ((ckspr->layer==spr->layer)&&(ckspr->y<=spr->y)) insp=i+1;
-        }
-        return -insp-1;
-      }
-
     default: {
         int i=grp->sprc; while (i-->0) if (grp->sprv[i]==spr) return i;
         return -grp->sprc-1;
@@ -83,6 +78,32 @@ static int _ps_sprgrp_search(const struct ps_sprgrp *grp,const struct ps_sprite
   }
 }
 
+/* Compare sprites for rendering.
+ */
+
+static int ps_sprite_rendercmp(const struct ps_sprite *a,const struct ps_sprite *b) {
+  if (a->layer<b->layer) return -1;
+  if (a->layer>b->layer) return 1;
+  if (a->y<b->y) return -1;
+  if (a->y>b->y) return 1;
+  return 0;
+}
+
+/* Insertion point in a RENDER group: After the last sprite that renders before or with (spr).
+ * The group is sorted completely each frame, and nearly sorted between, so a binary search is good enough.
+ * Anything slightly out of place gets fixed at the next ps_sprgrp_sort().
+ */
+
+static int _ps_sprgrp_render_insertion(const struct ps_sprgrp *grp,const struct ps_sprite *spr) {
+  int lo=0,hi=grp->sprc;
+  while (lo<hi) {
+    int ck=(lo+hi)>>1;
+    if (ps_sprite_rendercmp(spr,grp->sprv[ck])<0) hi=ck;
+    else lo=ck+1;
+  }
+  return lo;
+}
+
 /* Primitive insertion, private.
  */
 
@@ -90,8 +111,14 @@ static int _ps_sprite_add(struct ps_sprite *spr,int p,struct ps_sprgrp *grp) {
   if (spr->grpc>=spr->grpa) {
     int na=spr->grpa+4;
     if (na>INT_MAX/sizeof(void*)) return -1;
-    void *nv=realloc(spr->grpv,sizeof(void*)*na);
-    if (!nv) return -1;
+    void *nv;
+    if (spr->grpv==spr->grpv_inline) {
+      if (!(nv=malloc(sizeof(void*)*na))) return -1;
+      memcpy(nv,spr->grpv,sizeof(void*)*spr->grpc);
+      ps_sprite_pool_note_spill();
+    } else {
+      if (!(nv=realloc(spr->grpv,sizeof(void*)*na))) return -1;
+    }
     spr->grpv=nv;
     spr->grpa=na;
   }
@@ -99,6 +126,7 @@ static int _ps_sprite_add(struct ps_sprite *spr,int p,struct ps_sprgrp *grp) {
   memmove(spr->grpv+p+1,spr->grpv+p,sizeof(void*)*(spr->grpc-p));
   spr->grpv[p]=grp;
   spr->grpc++;
+  spr->grpmask|=grp->mask;
   return 0;
 }
 
@@ -125,6 +153,7 @@ static void _ps_sprite_remove(struct ps_sprite *spr,int p) {
   struct ps_sprgrp *grp=spr->grpv[p];
   spr->grpc--;
   memmove(spr->grpv+p,spr->grpv+p+1,sizeof(void*)*(spr->grpc-p));
+  spr->grpmask&=~grp->mask;
   ps_sprgrp_del(grp);
 }
 
@@ -140,6 +169,7 @@ static void _ps_sprgrp_remove(struct ps_sprgrp *grp,int p) {
 
 int ps_sprgrp_has_sprite(const struct ps_sprgrp *grp,const struct ps_sprite *spr) {
   if (!grp||!spr) return 0;
+  if (grp->mask) return (spr->grpmask&grp->mask)?1:0;
   /* Sprite's group list is always sorted and tends to be smaller than groups' sprite lists. */
   return (_ps_sprite_search(spr,grp)>=0)?1:0;
 }
@@ -149,10 +179,14 @@ int ps_sprgrp_add_sprite(struct ps_sprgrp *grp,struct ps_sprite *spr) {
 
   int grpp=_ps_sprite_search(spr,grp);
   if (grpp>=0) return 0; // Redundant.
-  int sprp=_ps_sprgrp_search(grp,spr);
-  if (sprp>=0) return -1; // Panic! Inconsistent lists.
   grpp=-grpp-1;
-  sprp=-sprp-1;
+  int sprp;
+  if (grp->order==PS_SPRGRP_ORDER_RENDER) {
+    sprp=_ps_sprgrp_render_insertion(grp,spr);
+  } else {
+    if ((sprp=_ps_sprgrp_search(grp,spr))>=0) return -1; // Panic! Inconsistent lists.
+    sprp=-sprp-1;
+  }
 
   if (_ps_sprite_add(spr,grpp,grp)<0) return -1;
   if (_ps_sprgrp_add(grp,sprp,spr)<0) { _ps_sprite_remove(spr,grpp); return -1; }
@@ -205,6 +239,7 @@ int ps_sprite_kill(struct ps_sprite *spr) {
   while (spr->grpc>0) {
     spr->grpc--;
     struct ps_sprgrp *grp=spr->grpv[spr->grpc];
+    spr->grpmask&=~grp->mask;
     int sprp=_ps_sprgrp_search(grp,spr);
     if (sprp>=0) _ps_sprgrp_remove(grp,sprp);
     ps_sprgrp_del(grp);
@@ -268,47 +303,126 @@ int ps_sprite_kill_later(struct ps_sprite *spr,struct ps_game *game) {
   return ps_sprgrp_add_sprite(game->grpv+PS_SPRGRP_DEATHROW,spr);
 }
 
-/* Compare sprites for rendering.
+/* Bucketing keys for RENDER groups.
+ * Bucket sort reads each sprite's layer and row several times, so we gather them once to avoid a cache miss each time.
+ * (keyv) has room for two copies of the group, the second half is scratch space for bucketing.
  */
 
-static int ps_sprite_rendercmp(const struct ps_sprite *a,const struct ps_sprite *b) {
-  if (a->layer<b->layer) return -1;
-  if (a->layer>b->layer) return 1;
-  if (a->y<b->y) return -1;
-  if (a->y>b->y) return 1;
+static int ps_sprgrp_require_renderkeys(struct ps_sprgrp *grp) {
+  if (grp->sprc<=grp->keya) return 0;
+  int na=(grp->sprc+32)&~31;
+  if (na>INT_MAX/(sizeof(struct ps_sprgrp_renderkey)*2)) return -1;
+  void *nv=realloc(grp->keyv,sizeof(struct ps_sprgrp_renderkey)*na*2);
+  if (!nv) return -1;
+  grp->keyv=nv;
+  grp->keya=na;
+  return 0;
+}
+
+static int ps_sprgrp_require_buckets(struct ps_sprgrp *grp,int c) {
+  if (c<=grp->bucketa) return 0;
+  int na=(c+256)&~255;
+  if (na>INT_MAX/sizeof(int)) return -1;
+  void *nv=realloc(grp->bucketv,sizeof(int)*na);
+  if (!nv) return -1;
+  grp->bucketv=nv;
+  grp->bucketa=na;
+  return 0;
+}
+
+/* Insertion sort on the sprite pointers.
+ * Stops and returns <0 if it has to move more than (budget) sprites.
+ * Whatever it did before stopping is still valid, and leaves less work for the next sort.
+ */
+
+static int ps_sprgrp_render_insertion_sort(struct ps_sprite **sprv,int c,int budget) {
+  int i=1; for (;i<c;i++) {
+    if (ps_sprite_rendercmp(sprv[i-1],sprv[i])<=0) continue;
+    struct ps_sprite *spr=sprv[i];
+    int j=i-1;
+    while ((j>0)&&(ps_sprite_rendercmp(sprv[j-1],spr)>0)) j--;
+    memmove(sprv+j+1,sprv+j,sizeof(void*)*(i-j));
+    sprv[j]=spr;
+    if ((budget-=i-j)<0) return -1;
+  }
+  return 0;
+}
+
+/* Bucket sort, for when the group is too scrambled for insertion.
+ * One bucket per layer per pixel row, which leaves the keys nearly sorted for a final insertion pass.
+ * Returns <0 without sorting if there are too many layers or the rows are too far apart to bucket sensibly.
+ */
+
+static int ps_sprgrp_renderkey_bucket_sort(struct ps_sprgrp *grp,struct ps_sprgrp_renderkey *keyv,int c) {
+  int layerv[PS_SPRGRP_RENDER_LAYER_LIMIT];
+  int layerc=0,i,rowlo=INT_MAX,rowhi=INT_MIN;
+  for (i=0;i<c;i++) {
+    if ((keyv[i].y<INT_MIN)||(keyv[i].y>=INT_MAX)||(keyv[i].y!=keyv[i].y)) return -1;
+    int row=(int)floor(keyv[i].y);
+    if (row<rowlo) rowlo=row;
+    if (row>rowhi) rowhi=row;
+    int p=0; while ((p<layerc)&&(layerv[p]<keyv[i].layer)) p++;
+    if ((p<layerc)&&(layerv[p]==keyv[i].layer)) continue;
+    if (layerc>=PS_SPRGRP_RENDER_LAYER_LIMIT) return -1;
+    memmove(layerv+p+1,layerv+p,sizeof(int)*(layerc-p));
+    layerv[p]=keyv[i].layer;
+    layerc++;
+  }
+  int64_t rowc=(int64_t)rowhi-rowlo+1;
+  if (rowc*layerc>(int64_t)c*4+4096) return -1;
+  int bucketc=rowc*layerc;
+  if (ps_sprgrp_require_buckets(grp,bucketc+1)<0) return -1;
+  int *bucketv=grp->bucketv;
+  memset(bucketv,0,sizeof(int)*(bucketc+1));
+
+  for (i=0;i<c;i++) {
+    int p=0; while (layerv[p]!=keyv[i].layer) p++;
+    keyv[i].bucket=p*rowc+(int)floor(keyv[i].y)-rowlo;
+    bucketv[keyv[i].bucket+1]++;
+  }
+  for (i=1;i<=bucketc;i++) bucketv[i]+=bucketv[i-1];
+  struct ps_sprgrp_renderkey *dst=keyv+c;
+  for (i=0;i<c;i++) dst[bucketv[keyv[i].bucket]++]=keyv[i];
+  memcpy(keyv,dst,sizeof(struct ps_sprgrp_renderkey)*c);
+  return 0;
+}
+
+/* Sort a RENDER group completely.
+ * Most frames, only a few sprites move out of place, and insertion sort on the pointers is linear.
+ * If it starts costing more than that, gather keys and bucket sort instead.
+ */
+
+static int ps_sprgrp_sort_render(struct ps_sprgrp *grp) {
+  int c=grp->sprc,i;
+  if (grp->scrambled) {
+    grp->scrambled--;
+  } else {
+    if (ps_sprgrp_render_insertion_sort(grp->sprv,c,c*PS_SPRGRP_RENDER_INSERTION_BUDGET)>=0) return 0;
+    grp->scrambled=PS_SPRGRP_RENDER_SCRAMBLED_FRAMES;
+  }
+  if (ps_sprgrp_require_renderkeys(grp)<0) return -1;
+  struct ps_sprgrp_renderkey *keyv=grp->keyv;
+  for (i=0;i<c;i++) {
+    const struct ps_sprite *spr=grp->sprv[i];
+    keyv[i].layer=spr->layer;
+    keyv[i].y=spr->y;
+    keyv[i].spr=grp->sprv[i];
+  }
+  if (ps_sprgrp_renderkey_bucket_sort(grp,keyv,c)>=0) {
+    for (i=0;i<c;i++) grp->sprv[i]=keyv[i].spr;
+  }
+  ps_sprgrp_render_insertion_sort(grp->sprv,c,INT_MAX);
   return 0;
 }
 
 /* Sort sprites.
  */
 
-int ps_sprgrp_sort(struct ps_sprgrp *grp,int completely) {
+int ps_sprgrp_sort(struct ps_sprgrp *grp) {
   if (!grp) return -1;
   if (grp->sprc<2) return 0;
   switch (grp->order) {
-  
-    case PS_SPRGRP_ORDER_RENDER: {
-        int lo=0,hi=grp->sprc-1;
-        while (lo<hi) {
-          int first,last,i,done=1;
-          if (grp->sortd==1) { first=lo; last=hi; }
-          else { grp->sortd=-1; first=hi; last=lo; }
-          for (i=first;i!=last;i+=grp->sortd) {
-            int cmp=ps_sprite_rendercmp(grp->sprv[i],grp->sprv[i+grp->sortd]);
-            if (cmp==grp->sortd) {
-              done=0;
-              struct ps_sprite *tmp=grp->sprv[i];
-              grp->sprv[i]=grp->sprv[i+grp->sortd];
-              grp->sprv[i+grp->sortd]=tmp;
-            }
-          }
-          if (grp->sortd==1) { grp->sortd=-1; hi--; }
-          else { grp->sortd=1; lo++; }
-          if (!completely) break;
-          if (done) break;
-        }
-      } break;
-      
+    case PS_SPRGRP_ORDER_RENDER: return ps_sprgrp_sort_render(grp);
   }
   return 0;
 }
@@ -16,11 +16,13 @@ struct ps_sprite *ps_sprite_new(const struct ps_sprtype *type) {
   if (!type) return 0;
   if (type->objlen<(int)sizeof(struct ps_sprite)) return 0;
 
-  struct ps_sprite *spr=calloc(1,type->objlen);
+  struct ps_sprite *spr=ps_sprite_pool_alloc(type);
   if (!spr) return 0;
   
   spr->type=type;
   spr->refc=1;
+  spr->grpv=spr->grpv_inline;
+  spr->grpa=PS_SPRITE_GRPV_INLINE;
   spr->layer=type->layer;
   spr->radius=type->radius;
   spr->shape=type->shape;
@@ -55,10 +57,10 @@ void ps_sprite_del(struct ps_sprite *spr) {
   if (spr->grpc) ps_log(SPRITE,ERROR,"Deleting sprite %p (type '%s'), grpc==%d.",spr,spr->type->name,spr->grpc);
   if (spr->grpv) {
     while (spr->grpc-->0) ps_sprgrp_del(spr->grpv[spr->grpc]);
-    free(spr->grpv);
+    if (spr->grpv!=spr->grpv_inline) free(spr->grpv);
   }
 
-  free(spr);
+  ps_sprite_pool_free(spr->type,spr);
 }
 
 /* Retain.
@@ -18,14 +18,21 @@ struct ps_circle;
 #define PS_SPRITE_SHAPE_SQUARE      0
 #define PS_SPRITE_SHAPE_CIRCLE      1
 
+/* Group memberships stored in the sprite itself, before (grpv) moves to the heap.
+ * Decorations are in three groups, most monsters in six to eight.
+ */
+#define PS_SPRITE_GRPV_INLINE       8
+
 /* ps_sprite: Generic sprite interface.
  *****************************************************************************/
 
 struct ps_sprite {
   const struct ps_sprtype *type; // Required, immutable.
   int refc;
-  struct ps_sprgrp **grpv; // All references are mutual.
+  struct ps_sprgrp **grpv; // All references are mutual. Points to (grpv_inline) until it outgrows it.
   int grpc,grpa;
+  struct ps_sprgrp *grpv_inline[PS_SPRITE_GRPV_INLINE];
+  uint32_t grpmask; // Union of (mask) of all groups in (grpv), ie which of the game's global groups I'm in.
   struct ps_sprdef *def; // Optional.
 
   double x,y;
@@ -43,6 +50,7 @@ struct ps_sprite {
   uint8_t opacity;
 
   int phreconsider; // For transient use by physics.
+  int phdirty; // For transient use by physics: Moved in the previous pass.
   int collided_grid; // Reset each frame for physics sprites.
 
   struct ps_sprgrp *master; // Optional. Set when some other sprite is controlling this one.
@@ -70,19 +78,56 @@ int ps_sprite_set_master(struct ps_sprite *slave,struct ps_sprite *master,struct
 struct ps_sprite *ps_sprite_get_master(const struct ps_sprite *slave);
 int ps_sprite_release_from_master(struct ps_sprite *slave,struct ps_game *game);
 
+/* ps_sprite_pool: Recycled storage for sprites.
+ * ps_sprite_new() and ps_sprite_del() use this; nothing else should need to.
+ * Each sprtype has its own free list, refilled a slab at a time, so short-lived sprites don't touch malloc.
+ * Main thread only.
+ *****************************************************************************/
+
+struct ps_sprite_pool_stats {
+  int64_t allocc; // Sprites handed out.
+  int64_t reusec; // Sprites handed out from a free list, ie without a new slab.
+  int64_t slabc; // Slabs allocated.
+  int64_t spillc; // Group lists that outgrew PS_SPRITE_GRPV_INLINE and went to the heap.
+  int livec; // Sprites currently allocated.
+  int64_t bytec; // Total size of all slabs.
+};
+
+void *ps_sprite_pool_alloc(const struct ps_sprtype *type); // Zeroed, (type->objlen) bytes.
+void ps_sprite_pool_free(const struct ps_sprtype *type,void *spr);
+
+/* Free the slabs of every sprtype that has no live sprites. Call at quit, or whenever you want the memory back.
+ */
+void ps_sprite_pool_release();
+
+void ps_sprite_pool_get_stats(struct ps_sprite_pool_stats *stats);
+void ps_sprite_pool_note_spill();
+
 /* ps_sprgrp: Mutual collection of sprites.
  *****************************************************************************/
 
 #define PS_SPRGRP_ORDER_ADDR       0 /* Order by address. Most efficient, and the default. */
 #define PS_SPRGRP_ORDER_EXPLICIT   1 /* Preserve order in which sprites are added. */
-#define PS_SPRGRP_ORDER_RENDER     2 /* Maintain rendering order, imperfectly. */
+#define PS_SPRGRP_ORDER_RENDER     2 /* Rendering order (layer,y), exact after each ps_sprgrp_sort(). */
+
+struct ps_sprgrp_renderkey {
+  int layer;
+  int bucket;
+  double y;
+  struct ps_sprite *spr;
+};
 
 struct ps_sprgrp {
   int refc; // 0==immortal
   struct ps_sprite **sprv;
   int sprc,spra;
   int order; // Change order only while the group is empty.
-  int sortd; // For PS_SPRGRP_ORDER_RENDER, toggle sorting order.
+  uint32_t mask; // Nonzero for the game's global groups, (1<<PS_SPRGRP_*). Change only while empty.
+  struct ps_sprgrp_renderkey *keyv; // For PS_SPRGRP_ORDER_RENDER, scratch space for sorting.
+  int keya;
+  int scrambled; // For PS_SPRGRP_ORDER_RENDER, sort count remaining before we try insertion sort again.
+  int *bucketv;
+  int bucketa;
 };
 
 struct ps_sprgrp *ps_sprgrp_new();
@@ -90,6 +135,9 @@ void ps_sprgrp_cleanup(struct ps_sprgrp *grp);
 void ps_sprgrp_del(struct ps_sprgrp *grp);
 int ps_sprgrp_ref(struct ps_sprgrp *grp);
 
+/* For groups with a (mask), this is a single bitwise test.
+ * Otherwise it's a binary search of the sprite's group list.
+ */
 int ps_sprgrp_has_sprite(const struct ps_sprgrp *grp,const struct ps_sprite *spr);
 int ps_sprgrp_add_sprite(struct ps_sprgrp *grp,struct ps_sprite *spr);
 int ps_sprgrp_remove_sprite(struct ps_sprgrp *grp,struct ps_sprite *spr);
@@ -111,7 +159,10 @@ int ps_sprite_join_all(struct ps_sprite *spr,struct ps_sprite *ref); // Add (spr
  */
 int ps_sprite_kill_later(struct ps_sprite *spr,struct ps_game *game);
 
-int ps_sprgrp_sort(struct ps_sprgrp *grp,int completely);
+/* Restore order after sprites have moved. Only meaningful for PS_SPRGRP_ORDER_RENDER.
+ * Cheap when the group is nearly sorted, which it will be if you call this every frame.
+ */
+int ps_sprgrp_sort(struct ps_sprgrp *grp);
 
 /* Add to (dst) every sprite which is in both (a) and (b).
  * Returns count added.
@@ -171,7 +222,6 @@ extern const struct ps_sprtype ps_sprtype_rabbit;
 extern const struct ps_sprtype ps_sprtype_prize;
 extern const struct ps_sprtype ps_sprtype_swordswitch;
 extern const struct ps_sprtype ps_sprtype_lobster;
-extern const struct ps_sprtype ps_sprtype_fireworks;
 extern const struct ps_sprtype ps_sprtype_bloodhound;
 extern const struct ps_sprtype ps_sprtype_turtle;
 extern const struct ps_sprtype ps_sprtype_dragon;
@@ -209,7 +259,6 @@ extern const struct ps_sprtype ps_sprtype_tortoise;
 extern const struct ps_sprtype ps_sprtype_singleswitch;
 extern const struct ps_sprtype ps_sprtype_chestkeeper;
 extern const struct ps_sprtype ps_sprtype_bullseye;
-extern const struct ps_sprtype ps_sprtype_changeindicator;
 //INSERT SPRTYPE DEFINITION HERE
 
 /* API for sprite types too trivial to warrant their own headers.
@@ -217,7 +266,6 @@ extern const struct ps_sprtype ps_sprtype_changeindicator;
 
 int ps_prize_fling(struct ps_sprite *spr,int dir);
 int ps_swordswitch_activate(struct ps_sprite *spr,struct ps_game *game,struct ps_sprite *hero);
-struct ps_sprite *ps_sprite_fireworks_new(struct ps_game *game,int x,int y,int p,int c);
 int ps_sprite_dragon_add_player(struct ps_sprite *spr,int playerid,struct ps_game *game);
 int ps_sprite_bomb_throw(struct ps_sprite *spr,int direction,int magnitude);
 int ps_sprite_flames_throw(struct ps_sprite *spr,int direction);
@@ -226,7 +274,6 @@ struct ps_sprite *ps_sprite_heroindicator_get_hero(const struct ps_sprite *spr);
 int ps_sprite_heroindicator_set_hero(struct ps_sprite *spr,struct ps_sprite *hero);
 int ps_sprite_react_to_sword(struct ps_sprite *spr,struct ps_game *game,struct ps_sprite *hero,int state); // Dispatcher for SWORDAWARE group. (state) in (0,1,2)
 int ps_sprite_inert_fling(struct ps_sprite *spr,struct ps_game *game,int dir);
-struct ps_sprite *ps_sprite_changeindicator_spawn(struct ps_game *game,int col,int row);
 
 /* Toggle a switch.
  * Works for 'switch' and 'swordswitch', and we'll add other types as needed.
@@ -0,0 +1,147 @@
+#include "ps.h"
+#include "ps_sprite.h"
+
+/* How much we allocate at once, per type. Big sprites get fewer per slab, but always at least one.
+ */
+#define PS_SPRITE_POOL_SLAB_SIZE 8192
+
+/* Open-addressed table of sprtypes, must be a power of two and comfortably more than the sprtype count.
+ * If it fills up anyway, the extra types just use calloc and free.
+ */
+#define PS_SPRITE_POOL_TYPE_LIMIT 256
+
+/* Globals.
+ */
+
+struct ps_sprite_pool_bucket {
+  const struct ps_sprtype *type; // WEAK. Null if unused.
+  int stride; // (type->objlen) rounded up to keep doubles aligned.
+  int objc; // Sprites per slab.
+  void *freel; // Unused sprites, linked through their first word.
+  void **slabv;
+  int slabc,slaba;
+  int livec;
+};
+
+static struct {
+  struct ps_sprite_pool_bucket bucketv[PS_SPRITE_POOL_TYPE_LIMIT];
+  struct ps_sprite_pool_stats stats;
+} ps_sprite_pool={0};
+
+/* Find bucket for type, creating if (create).
+ */
+
+static struct ps_sprite_pool_bucket *ps_sprite_pool_get_bucket(const struct ps_sprtype *type,int create) {
+  int p=((uintptr_t)type>>4)&(PS_SPRITE_POOL_TYPE_LIMIT-1);
+  int i=PS_SPRITE_POOL_TYPE_LIMIT; while (i-->0) {
+    struct ps_sprite_pool_bucket *bucket=ps_sprite_pool.bucketv+p;
+    if (bucket->type==type) return bucket;
+    if (!bucket->type) {
+      if (!create) return 0;
+      bucket->type=type;
+      bucket->stride=(type->objlen+15)&~15;
+      if ((bucket->objc=PS_SPRITE_POOL_SLAB_SIZE/bucket->stride)<1) bucket->objc=1;
+      return bucket;
+    }
+    if (++p>=PS_SPRITE_POOL_TYPE_LIMIT) p=0;
+  }
+  return 0;
+}
+
+/* Add a slab to bucket's free list.
+ */
+
+static int ps_sprite_pool_add_slab(struct ps_sprite_pool_bucket *bucket) {
+  if (bucket->slabc>=bucket->slaba) {
+    int na=bucket->slaba+8;
+    if (na>INT_MAX/sizeof(void*)) return -1;
+    void *nv=realloc(bucket->slabv,sizeof(void*)*na);
+    if (!nv) return -1;
+    bucket->slabv=nv;
+    bucket->slaba=na;
+  }
+  char *slab=malloc(bucket->stride*bucket->objc);
+  if (!slab) return -1;
+  bucket->slabv[bucket->slabc++]=slab;
+  ps_sprite_pool.stats.slabc++;
+  ps_sprite_pool.stats.bytec+=bucket->stride*bucket->objc;
+
+  /* Link in reverse so they come out in address order. */
+  int i=bucket->objc; while (i-->0) {
+    void *obj=slab+i*bucket->stride;
+    *(void**)obj=bucket->freel;
+    bucket->freel=obj;
+  }
+  return 0;
+}
+
+/* Allocate.
+ */
+
+void *ps_sprite_pool_alloc(const struct ps_sprtype *type) {
+  if (!type||(type->objlen<1)) return 0;
+  struct ps_sprite_pool_bucket *bucket=ps_sprite_pool_get_bucket(type,1);
+  void *obj;
+  if (!bucket) {
+    if (!(obj=calloc(1,type->objlen))) return 0;
+  } else {
+    if (bucket->freel) {
+      ps_sprite_pool.stats.reusec++;
+    } else if (ps_sprite_pool_add_slab(bucket)<0) {
+      return 0;
+    }
+    obj=bucket->freel;
+    bucket->freel=*(void**)obj;
+    memset(obj,0,type->objlen);
+    bucket->livec++;
+  }
+  ps_sprite_pool.stats.allocc++;
+  ps_sprite_pool.stats.livec++;
+  return obj;
+}
+
+/* Free.
+ */
+
+void ps_sprite_pool_free(const struct ps_sprtype *type,void *obj) {
+  if (!type||!obj) return;
+  struct ps_sprite_pool_bucket *bucket=ps_sprite_pool_get_bucket(type,0);
+  if (!bucket) {
+    free(obj);
+  } else {
+    *(void**)obj=bucket->freel;
+    bucket->freel=obj;
+    bucket->livec--;
+  }
+  ps_sprite_pool.stats.livec--;
+}
+
+/* Release unused slabs.
+ */
+
+void ps_sprite_pool_release() {
+  struct ps_sprite_pool_bucket *bucket=ps_sprite_pool.bucketv;
+  int i=PS_SPRITE_POOL_TYPE_LIMIT; for (;i-->0;bucket++) {
+    if (!bucket->type||bucket->livec) continue;
+    while (bucket->slabc>0) {
+      bucket->slabc--;
+      free(bucket->slabv[bucket->slabc]);
+      ps_sprite_pool.stats.bytec-=bucket->stride*bucket->objc;
+    }
+    free(bucket->slabv);
+    bucket->slabv=0;
+    bucket->slaba=0;
+    bucket->freel=0;
+  }
+}
+
+/* Statistics.
+ */
+
+void ps_sprite_pool_get_stats(struct ps_sprite_pool_stats *stats) {
+  if (stats) *stats=ps_sprite_pool.stats;
+}
+
+void ps_sprite_pool_note_spill() {
+  ps_sprite_pool.stats.spillc++;
+}
@@ -28,7 +28,6 @@ const struct ps_sprtype *ps_sprtype_by_name(const char *name,int namec) {
   if ((namec==5)&&!memcmp(name,"prize",5)) return &ps_sprtype_prize;
   if ((namec==11)&&!memcmp(name,"swordswitch",11)) return &ps_sprtype_swordswitch;
   if ((namec==7)&&!memcmp(name,"lobster",7)) return &ps_sprtype_lobster;
-  if ((namec==9)&&!memcmp(name,"fireworks",9)) return &ps_sprtype_fireworks;
   if ((namec==10)&&!memcmp(name,"bloodhound",10)) return &ps_sprtype_bloodhound;
   if ((namec==6)&&!memcmp(name,"turtle",6)) return &ps_sprtype_turtle;
   if ((namec==6)&&!memcmp(name,"dragon",6)) return &ps_sprtype_dragon;
@@ -66,7 +65,6 @@ const struct ps_sprtype *ps_sprtype_by_name(const char *name,int namec) {
   if ((namec==12)&&!memcmp(name,"singleswitch",12)) return &ps_sprtype_singleswitch;
   if ((namec==11)&&!memcmp(name,"chestkeeper",11)) return &ps_sprtype_chestkeeper;
   if ((namec==8)&&!memcmp(name,"bullseye",8)) return &ps_sprtype_bullseye;
-  if ((namec==15)&&!memcmp(name,"changeindicator",15)) return &ps_sprtype_changeindicator;
 //INSERT SPRTYPE NAME TEST HERE
 
   return 0;
@@ -95,7 +93,6 @@ const struct ps_sprtype *ps_all_sprtypes[]={
   &ps_sprtype_prize,
   &ps_sprtype_swordswitch,
   &ps_sprtype_lobster,
-  &ps_sprtype_fireworks,
   &ps_sprtype_bloodhound,
   &ps_sprtype_turtle,
   &ps_sprtype_dragon,
@@ -133,6 +130,5 @@ const struct ps_sprtype *ps_all_sprtypes[]={
   &ps_sprtype_singleswitch,
   &ps_sprtype_chestkeeper,
   &ps_sprtype_bullseye,
-  &ps_sprtype_changeindicator,
 //INSERT SPRTYPE REFERENCE HERE
 0};
@@ -323,7 +323,7 @@ static int ps_summoner_entry_spawn(struct ps_summoner_entry *entry,struct ps_gam
   int x,y,panic=10;
   while (1) {
     if (--panic<0) return 0;
-    int pathp=rand()%entry->cells->c;
+    int pathp=ps_game_randint(game,entry->cells->c);
     x=(entry->cells->v[pathp].x*PS_TILESIZE)+(PS_TILESIZE>>1);
     y=(entry->cells->v[pathp].y*PS_TILESIZE)+(PS_TILESIZE>>1);
     if (ps_summoner_ok_position(game,x,y)) break;
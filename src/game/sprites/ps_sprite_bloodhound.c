@@ -2,6 +2,7 @@
 #include "game/ps_sprite.h"
 #include "game/ps_game.h"
 #include "game/ps_path.h"
+#include "game/ps_gridpath.h"
 #include "game/ps_sound_effects.h"
 #include "scenario/ps_blueprint.h"
 #include "scenario/ps_grid.h"
@@ -81,17 +82,35 @@ static int ps_bloodhound_valid_destination(const struct ps_grid_cell *cellv,int
   return 1;
 }
 
+/* Nonzero if we composed a path to (x,y).
+ * (distv) is the distance field from our position, so we only search for cells we know we can reach.
+ */
+
+static int ps_bloodhound_try_destination(struct ps_sprite *spr,struct ps_game *game,const uint16_t *distv,int x,int y,int srcx,int srcy) {
+  if (!ps_bloodhound_valid_destination(game->grid->cellv,x,y)) return 0;
+  if (distv[y*PS_GRID_COLC+x]==PS_GRIDPATH_UNREACHABLE) return 0;
+  if (ps_game_compose_grid_path(&SPR->path,game,x,y,srcx,srcy,spr->impassable)<0) return 0;
+  return 1;
+}
+
 static int ps_bloodhound_generate_path(struct ps_sprite *spr,struct ps_game *game) {
 
   int srcx=(int)spr->x/PS_TILESIZE;
   int srcy=(int)spr->y/PS_TILESIZE;
 
+  /* We usually start just offscreen. Distance from the cell where we'll enter is close enough.
+   * If that cell itself is impassable, there's no path anywhere.
+   */
+  int entryx=(srcx<0)?0:(srcx>=PS_GRID_COLC)?(PS_GRID_COLC-1):srcx;
+  int entryy=(srcy<0)?0:(srcy>=PS_GRID_ROWC)?(PS_GRID_ROWC-1):srcy;
+  const uint16_t *distv=ps_game_get_grid_distance_field(game,entryx,entryy,spr->impassable);
+
   /* Start near the center and radiate outward until we find a VACANT cell with a valid path from where we are.
    */
   int midx=PS_GRID_COLC>>1;
   int midy=PS_GRID_ROWC>>1;
   int distance=0;
-  while (1) {
+  while (distv) {
     int xa=midx-distance;
     int xz=midx+distance;
     int ya=midy-distance;
@@ -99,23 +118,15 @@ static int ps_bloodhound_generate_path(struct ps_sprite *spr,struct ps_game *gam
     if ((xa<0)&&(ya<0)&&(xz>=PS_GRID_COLC)&&(yz>=PS_GRID_ROWC)) break;
     int i;
     for (i=ya;i<=yz;i++) {
-      if (ps_bloodhound_valid_destination(game->grid->cellv,xa,i)) {
-        if (ps_game_compose_grid_path(&SPR->path,game->grid,xa,i,srcx,srcy,spr->impassable)>=0) return 0;
-      }
+      if (ps_bloodhound_try_destination(spr,game,distv,xa,i,srcx,srcy)) return 0;
       if (xz!=xa) {
-        if (ps_bloodhound_valid_destination(game->grid->cellv,xz,i)) {
-          if (ps_game_compose_grid_path(&SPR->path,game->grid,xz,i,srcx,srcy,spr->impassable)>=0) return 0;
-        }
+        if (ps_bloodhound_try_destination(spr,game,distv,xz,i,srcx,srcy)) return 0;
       }
     }
     for (i=xa+1;i<=xz-1;i++) {
-      if (ps_bloodhound_valid_destination(game->grid->cellv,i,ya)) {
-        if (ps_game_compose_grid_path(&SPR->path,game->grid,i,ya,srcx,srcy,spr->impassable)>=0) return 0;
-      }
+      if (ps_bloodhound_try_destination(spr,game,distv,i,ya,srcx,srcy)) return 0;
       if (ya!=yz) {
-        if (ps_bloodhound_valid_destination(game->grid->cellv,i,yz)) {
-          if (ps_game_compose_grid_path(&SPR->path,game->grid,i,yz,srcx,srcy,spr->impassable)>=0) return 0;
-        }
+        if (ps_bloodhound_try_destination(spr,game,distv,i,yz,srcx,srcy)) return 0;
       }
     }
     distance++;
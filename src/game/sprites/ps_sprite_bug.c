@@ -56,7 +56,7 @@ static int _ps_bug_configure(struct ps_sprite *spr,struct ps_game *game,const in
 
 static int ps_bug_begin_wait(struct ps_sprite *spr,struct ps_game *game) {
   SPR->phase=PS_BUG_PHASE_WAIT;
-  SPR->phasetime=PS_BUG_WAIT_TIME_MIN+rand()%(PS_BUG_WAIT_TIME_MAX-PS_BUG_WAIT_TIME_MIN);
+  SPR->phasetime=PS_BUG_WAIT_TIME_MIN+ps_game_randint(game,PS_BUG_WAIT_TIME_MAX-PS_BUG_WAIT_TIME_MIN);
   return 0;
 }
 
@@ -145,7 +145,7 @@ static int ps_bug_select_walk_direction(struct ps_sprite *spr,struct ps_game *ga
   SPR->dstx=col*PS_TILESIZE+(PS_TILESIZE>>1);
   SPR->dsty=row*PS_TILESIZE+(PS_TILESIZE>>1);
   int direction;
-  if (optionc>1) direction=optionv[rand()%optionc];
+  if (optionc>1) direction=optionv[ps_game_randint(game,optionc)];
   else direction=optionv[0];
   switch (direction) {
     case PS_DIRECTION_WEST:  SPR->dstx-=PS_TILESIZE; break;
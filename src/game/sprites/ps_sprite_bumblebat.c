@@ -39,8 +39,8 @@ static void _ps_bumblebat_del(struct ps_sprite *spr) {
 /* Set reconsider time.
  */
 
-static void ps_bumblebat_set_reconsider_time(struct ps_sprite *spr) {
-  SPR->reconsidertime=PS_BUMBLEBAT_RECONSIDER_TIME_MIN+rand()%(PS_BUMBLEBAT_RECONSIDER_TIME_MAX-PS_BUMBLEBAT_RECONSIDER_TIME_MIN+1);
+static void ps_bumblebat_set_reconsider_time(struct ps_sprite *spr,struct ps_game *game) {
+  SPR->reconsidertime=PS_BUMBLEBAT_RECONSIDER_TIME_MIN+ps_game_randint(game,PS_BUMBLEBAT_RECONSIDER_TIME_MAX-PS_BUMBLEBAT_RECONSIDER_TIME_MIN+1);
 }
 
 /* Initialize.
@@ -49,11 +49,8 @@ static void ps_bumblebat_set_reconsider_time(struct ps_sprite *spr) {
 static int _ps_bumblebat_init(struct ps_sprite *spr) {
 
   if (!(SPR->target=ps_sprgrp_new())) return -1;
-  SPR->targetangle=(rand()%628)/100.0;
   SPR->targetdistance=PS_BUMBLEBAT_TARGET_DISTANCE;
 
-  ps_bumblebat_set_reconsider_time(spr);
-
   return 0;
 }
 
@@ -61,6 +58,8 @@ static int _ps_bumblebat_init(struct ps_sprite *spr) {
  */
 
 static int _ps_bumblebat_configure(struct ps_sprite *spr,struct ps_game *game,const int *argv,int argc,const struct ps_sprdef *sprdef) {
+  SPR->targetangle=ps_game_randint(game,628)/100.0;
+  ps_bumblebat_set_reconsider_time(spr,game);
   return 0;
 }
 
@@ -136,7 +135,7 @@ static int ps_bumblebat_update_chase(struct ps_sprite *spr,struct ps_game *game,
 
 static int ps_bumblebat_locate_target(struct ps_sprite *spr,struct ps_game *game) {
   if (game->grpv[PS_SPRGRP_HERO].sprc<1) return 0;
-  int p=rand()%game->grpv[PS_SPRGRP_HERO].sprc;
+  int p=ps_game_randint(game,game->grpv[PS_SPRGRP_HERO].sprc);
   struct ps_sprite *target=game->grpv[PS_SPRGRP_HERO].sprv[p];
   if (ps_sprgrp_clear(SPR->target)<0) return -1;
   if (ps_sprgrp_add_sprite(SPR->target,target)<0) return -1;
@@ -154,7 +153,7 @@ static int _ps_bumblebat_update(struct ps_sprite *spr,struct ps_game *game) {
   }
 
   if (--(SPR->reconsidertime)<=0) {
-    ps_bumblebat_set_reconsider_time(spr);
+    ps_bumblebat_set_reconsider_time(spr,game);
     ps_sprgrp_clear(SPR->target);
   }
 
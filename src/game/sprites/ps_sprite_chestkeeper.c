@@ -294,9 +294,9 @@ static int ps_chestkeeper_arm_update(struct ps_sprite *spr,struct ps_chestkeeper
  */
 
 static int ps_chestkeeper_adjust_walk(struct ps_sprite *spr,struct ps_game *game) {
-  double speed=PS_CHESTKEEPER_WALK_SPEED_LO+(rand()%1000)*((PS_CHESTKEEPER_WALK_SPEED_HI-PS_CHESTKEEPER_WALK_SPEED_LO)/1000.0);
+  double speed=PS_CHESTKEEPER_WALK_SPEED_LO+ps_game_randint(game,1000)*((PS_CHESTKEEPER_WALK_SPEED_HI-PS_CHESTKEEPER_WALK_SPEED_LO)/1000.0);
   if (ps_game_select_random_travel_vector(&SPR->walkdx,&SPR->walkdy,game,spr->x,spr->y,speed,spr->impassable)<0) return -1;
-  SPR->walktime=PS_CHESTKEEPER_WALK_TIME_LO+rand()%(PS_CHESTKEEPER_WALK_TIME_HI-PS_CHESTKEEPER_WALK_TIME_LO);
+  SPR->walktime=PS_CHESTKEEPER_WALK_TIME_LO+ps_game_randint(game,PS_CHESTKEEPER_WALK_TIME_HI-PS_CHESTKEEPER_WALK_TIME_LO);
   return 0;
 }
 
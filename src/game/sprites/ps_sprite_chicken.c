@@ -52,23 +52,31 @@ static void _ps_chicken_del(struct ps_sprite *spr) {
 
 static int _ps_chicken_init(struct ps_sprite *spr) {
 
-  SPR->facedx=(rand()&1)?1:-1;
+  SPR->facedx=1;
 
   return 0;
 }
 
+/* Configure.
+ */
+
+static int _ps_chicken_configure(struct ps_sprite *spr,struct ps_game *game,const int *argv,int argc,const struct ps_sprdef *sprdef) {
+  SPR->facedx=ps_game_randint(game,2)?1:-1;
+  return 0;
+}
+
 /* Phase initiators.
  */
 
 static int ps_chicken_begin_IDLE(struct ps_sprite *spr,struct ps_game *game) {
   SPR->phase=PS_CHICKEN_PHASE_IDLE;
-  SPR->phasetime=PS_CHICKEN_IDLE_TIME_MIN+rand()%(PS_CHICKEN_IDLE_TIME_MAX-PS_CHICKEN_IDLE_TIME_MIN);
+  SPR->phasetime=PS_CHICKEN_IDLE_TIME_MIN+ps_game_randint(game,PS_CHICKEN_IDLE_TIME_MAX-PS_CHICKEN_IDLE_TIME_MIN);
   return 0;
 }
 
 static int ps_chicken_begin_WALK(struct ps_sprite *spr,struct ps_game *game) {
   SPR->phase=PS_CHICKEN_PHASE_WALK;
-  SPR->phasetime=PS_CHICKEN_WALK_TIME_MIN+rand()%(PS_CHICKEN_WALK_TIME_MAX-PS_CHICKEN_WALK_TIME_MIN);
+  SPR->phasetime=PS_CHICKEN_WALK_TIME_MIN+ps_game_randint(game,PS_CHICKEN_WALK_TIME_MAX-PS_CHICKEN_WALK_TIME_MIN);
   SPR->animtime=0;
   SPR->animframe=0;
   
@@ -100,7 +108,7 @@ static int ps_chicken_advance_phase(struct ps_sprite *spr,struct ps_game *game)
   switch (SPR->phase) {
 
     case PS_CHICKEN_PHASE_IDLE: {
-        switch (rand()%3) {
+        switch (ps_game_randint(game,3)) {
           case 0: return ps_chicken_begin_WALK(spr,game);
           case 1: return ps_chicken_begin_PECK(spr,game);
           case 2: return ps_chicken_begin_CHAT(spr,game);
@@ -223,8 +231,8 @@ static int ps_chicken_lay_egg(struct ps_sprite *spr,struct ps_game *game) {
 
   // Wee randomization to ensure we don't get two eggs in precisely the same location.
   // If that happens in a horizontal corridor, physics gives us some unpleasant twitch.
-  double randomx=(rand()%100)/100.0;
-  double randomy=(rand()%100)/100.0;
+  double randomx=ps_game_randint(game,100)/100.0;
+  double randomy=ps_game_randint(game,100)/100.0;
 
   egg->x=spr->x+PS_TILESIZE*-SPR->facedx+randomx;
   egg->y=spr->y+randomy;
@@ -300,6 +308,7 @@ const struct ps_sprtype ps_sprtype_chicken={
 
   .init=_ps_chicken_init,
   .del=_ps_chicken_del,
+  .configure=_ps_chicken_configure,
   .update=_ps_chicken_update,
   .draw=_ps_chicken_draw,
   
@@ -61,10 +61,10 @@ static void _ps_dragonbug_del(struct ps_sprite *spr) {
 /* Set SPR->phasetime based on SPR->phase.
  */
 
-static void ps_dragonbug_reset_phase_time(struct ps_sprite *spr) {
+static void ps_dragonbug_reset_phase_time(struct ps_sprite *spr,struct ps_game *game) {
  _again_:
   #define RANGE(tag) \
-    SPR->phasetime=PS_DRAGONBUG_##tag##_TIME_MIN+rand()%(PS_DRAGONBUG_##tag##_TIME_MAX-PS_DRAGONBUG_##tag##_TIME_MIN+1);
+    SPR->phasetime=PS_DRAGONBUG_##tag##_TIME_MIN+ps_game_randint(game,PS_DRAGONBUG_##tag##_TIME_MAX-PS_DRAGONBUG_##tag##_TIME_MIN+1);
   switch (SPR->phase) {
     case PS_DRAGONBUG_PHASE_IDLE: RANGE(IDLE) break;
     case PS_DRAGONBUG_PHASE_WALK: RANGE(WALK) break;
@@ -82,7 +82,6 @@ static void ps_dragonbug_reset_phase_time(struct ps_sprite *spr) {
 static int _ps_dragonbug_init(struct ps_sprite *spr) {
 
   SPR->phase=PS_DRAGONBUG_PHASE_IDLE;
-  ps_dragonbug_reset_phase_time(spr);
 
   return 0;
 }
@@ -91,6 +90,7 @@ static int _ps_dragonbug_init(struct ps_sprite *spr) {
  */
 
 static int _ps_dragonbug_configure(struct ps_sprite *spr,struct ps_game *game,const int *argv,int argc,const struct ps_sprdef *sprdef) {
+  ps_dragonbug_reset_phase_time(spr,game);
   return 0;
 }
 
@@ -294,7 +294,7 @@ static int _ps_dragonbug_update(struct ps_sprite *spr,struct ps_game *game) {
   /* Switch phase based on timer. */
   if (--(SPR->phasetime)<=0) {
     if (ps_dragonbug_complete_phase(spr,game)<0) return -1;
-    ps_dragonbug_reset_phase_time(spr);
+    ps_dragonbug_reset_phase_time(spr,game);
   }
 
   /* Cycle the walk animation counter whether we're using it or not. */
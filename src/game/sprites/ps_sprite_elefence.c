@@ -39,7 +39,15 @@ static void _ps_elefence_del(struct ps_sprite *spr) {
  */
 
 static int _ps_elefence_init(struct ps_sprite *spr) {
-  SPR->facedx=(rand()&1)?-1:1;
+  SPR->facedx=1;
+  return 0;
+}
+
+/* Configure.
+ */
+
+static int _ps_elefence_configure(struct ps_sprite *spr,struct ps_game *game,const int *argv,int argc,const struct ps_sprdef *sprdef) {
+  SPR->facedx=ps_game_randint(game,2)?-1:1;
   return 0;
 }
 
@@ -135,6 +143,7 @@ const struct ps_sprtype ps_sprtype_elefence={
 
   .init=_ps_elefence_init,
   .del=_ps_elefence_del,
+  .configure=_ps_elefence_configure,
   .update=_ps_elefence_update,
   .draw=_ps_elefence_draw,
   
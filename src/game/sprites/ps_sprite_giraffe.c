@@ -88,7 +88,7 @@ static void _ps_giraffe_del(struct ps_sprite *spr) {
 
 static int _ps_giraffe_init(struct ps_sprite *spr) {
 
-  SPR->facedx=(rand()&1)?-1:1;
+  SPR->facedx=1;
   SPR->neck_length=PS_GIRAFFE_NECK_LENGTH_MAX;
   SPR->neck_angle=0.8;
   ps_giraffe_neck_angle_changed(spr);
@@ -104,6 +104,7 @@ static int _ps_giraffe_init(struct ps_sprite *spr) {
  */
 
 static int _ps_giraffe_configure(struct ps_sprite *spr,struct ps_game *game,const int *argv,int argc,const struct ps_sprdef *sprdef) {
+  SPR->facedx=ps_game_randint(game,2)?-1:1;
   return 0;
 }
 
@@ -212,7 +213,7 @@ static int ps_giraffe_update_EXTEND(struct ps_sprite *spr,struct ps_game *game)
 
 static int ps_giraffe_begin_IDLE(struct ps_sprite *spr,struct ps_game *game) {
   SPR->phase=PS_GIRAFFE_PHASE_IDLE;
-  SPR->phase_limit=PS_GIRAFFE_IDLE_TIME_MIN+rand()%(PS_GIRAFFE_IDLE_TIME_MAX-PS_GIRAFFE_IDLE_TIME_MIN);
+  SPR->phase_limit=PS_GIRAFFE_IDLE_TIME_MIN+ps_game_randint(game,PS_GIRAFFE_IDLE_TIME_MAX-PS_GIRAFFE_IDLE_TIME_MIN);
   SPR->neck_angle=0.0;
   ps_giraffe_neck_angle_changed(spr);
   return 0;
@@ -220,7 +221,7 @@ static int ps_giraffe_begin_IDLE(struct ps_sprite *spr,struct ps_game *game) {
 
 static int ps_giraffe_begin_WALK(struct ps_sprite *spr,struct ps_game *game) {
   SPR->phase=PS_GIRAFFE_PHASE_WALK;
-  SPR->phase_limit=PS_GIRAFFE_WALK_TIME_MIN+rand()%(PS_GIRAFFE_WALK_TIME_MAX-PS_GIRAFFE_WALK_TIME_MIN);
+  SPR->phase_limit=PS_GIRAFFE_WALK_TIME_MIN+ps_game_randint(game,PS_GIRAFFE_WALK_TIME_MAX-PS_GIRAFFE_WALK_TIME_MIN);
   
   if (ps_game_select_random_travel_vector(&SPR->walkdx,&SPR->walkdy,game,spr->x,spr->y,PS_GIRAFFE_WALK_SPEED,spr->impassable)<0) return -1;
 
@@ -273,7 +274,7 @@ static int ps_giraffe_begin_EXTEND(struct ps_sprite *spr,struct ps_game *game) {
  */
 
 static int ps_giraffe_choose_phase(struct ps_sprite *spr,struct ps_game *game) {
-  int selection=rand()%10;
+  int selection=ps_game_randint(game,10);
   if (selection<5) {
     return ps_giraffe_begin_WALK(spr,game);
   } else if (selection<6) {
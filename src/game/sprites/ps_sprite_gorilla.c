@@ -85,7 +85,7 @@ static void _ps_gorilla_del(struct ps_sprite *spr) {
 static int _ps_gorilla_init(struct ps_sprite *spr) {
 
   SPR->phase=PS_GORILLA_PHASE_IDLE;
-  SPR->phasetime=PS_GORILLA_IDLE_TIME_MIN+rand()%(PS_GORILLA_IDLE_TIME_MAX-PS_GORILLA_IDLE_TIME_MIN);
+  SPR->phasetime=PS_GORILLA_IDLE_TIME_MIN;
   SPR->state_left=PS_GORILLA_BODY_STATE_IDLE;
   SPR->state_right=PS_GORILLA_BODY_STATE_IDLE;
   SPR->state_head=PS_GORILLA_HEAD_STATE_IDLE;
@@ -98,6 +98,7 @@ static int _ps_gorilla_init(struct ps_sprite *spr) {
  */
 
 static int _ps_gorilla_configure(struct ps_sprite *spr,struct ps_game *game,const int *argv,int argc,const struct ps_sprdef *sprdef) {
+  SPR->phasetime+=ps_game_randint(game,PS_GORILLA_IDLE_TIME_MAX-PS_GORILLA_IDLE_TIME_MIN);
   return 0;
 }
 
@@ -111,7 +112,7 @@ static const char *_ps_gorilla_get_configure_argument_name(int argp) {
 
 static int ps_gorilla_begin_IDLE(struct ps_sprite *spr,struct ps_game *game) {
   SPR->phase=PS_GORILLA_PHASE_IDLE;
-  SPR->phasetime=PS_GORILLA_IDLE_TIME_MIN+rand()%(PS_GORILLA_IDLE_TIME_MAX-PS_GORILLA_IDLE_TIME_MIN);
+  SPR->phasetime=PS_GORILLA_IDLE_TIME_MIN+ps_game_randint(game,PS_GORILLA_IDLE_TIME_MAX-PS_GORILLA_IDLE_TIME_MIN);
   SPR->state_head=PS_GORILLA_HEAD_STATE_IDLE;
   SPR->state_left=PS_GORILLA_BODY_STATE_IDLE;
   SPR->state_right=PS_GORILLA_BODY_STATE_IDLE;
@@ -124,7 +125,7 @@ static int ps_gorilla_begin_IDLE(struct ps_sprite *spr,struct ps_game *game) {
 
 static int ps_gorilla_begin_WALK(struct ps_sprite *spr,struct ps_game *game) {
   SPR->phase=PS_GORILLA_PHASE_WALK;
-  SPR->phasetime=PS_GORILLA_WALK_TIME_MIN+rand()%(PS_GORILLA_WALK_TIME_MAX-PS_GORILLA_WALK_TIME_MIN);
+  SPR->phasetime=PS_GORILLA_WALK_TIME_MIN+ps_game_randint(game,PS_GORILLA_WALK_TIME_MAX-PS_GORILLA_WALK_TIME_MIN);
   SPR->animtime=0;
   SPR->animframe=0;
   SPR->state_head=PS_GORILLA_HEAD_STATE_IDLE;
@@ -142,7 +143,7 @@ static int ps_gorilla_begin_WALK(struct ps_sprite *spr,struct ps_game *game) {
 static int ps_gorilla_begin_HOWL(struct ps_sprite *spr,struct ps_game *game) {
   PS_SFX_GORILLA_ROAR
   SPR->phase=PS_GORILLA_PHASE_HOWL;
-  SPR->phasetime=PS_GORILLA_HOWL_TIME_MIN+rand()%(PS_GORILLA_HOWL_TIME_MAX-PS_GORILLA_HOWL_TIME_MIN);
+  SPR->phasetime=PS_GORILLA_HOWL_TIME_MIN+ps_game_randint(game,PS_GORILLA_HOWL_TIME_MAX-PS_GORILLA_HOWL_TIME_MIN);
   SPR->animtime=0;
   SPR->animframe=0;
   SPR->state_head=PS_GORILLA_HEAD_STATE_HOWL;
@@ -311,7 +312,7 @@ static int ps_gorilla_select_banana_destination(int *dstx,int *dsty,struct ps_sp
   if (grp->sprc>0) {
     int panic=10;
     while (panic-->0) {
-      int sprp=rand()%grp->sprc;
+      int sprp=ps_game_randint(game,grp->sprc);
       struct ps_sprite *target=grp->sprv[sprp];
       if (target->type!=&ps_sprtype_hero) continue;
       *dstx=target->x;
@@ -320,8 +321,8 @@ static int ps_gorilla_select_banana_destination(int *dstx,int *dsty,struct ps_sp
     }
   }
 
-  *dstx=rand()%PS_SCREENW;
-  *dsty=rand()%PS_SCREENH;
+  *dstx=ps_game_randint(game,PS_SCREENW);
+  *dsty=ps_game_randint(game,PS_SCREENH);
 
   return 0;
 }
@@ -353,7 +354,7 @@ static int ps_gorilla_update_SPIT(struct ps_sprite *spr,struct ps_game *game) {
 static int ps_gorilla_select_phase(struct ps_sprite *spr,struct ps_game *game) {
   switch (SPR->phase) {
     case PS_GORILLA_PHASE_IDLE: {
-        int choice=rand()%10;
+        int choice=ps_game_randint(game,10);
         if (choice<4) {
           if (ps_gorilla_begin_WALK(spr,game)<0) return -1;
         } else if (choice<8) {
@@ -38,9 +38,9 @@ int ps_hero_fly_end(struct ps_sprite *spr,struct ps_game *game);
 /* Reset blink time.
  */
 
-static void ps_hero_reset_blinktime(struct ps_sprite *spr) {
+static void ps_hero_reset_blinktime(struct ps_sprite *spr,struct ps_game *game) {
   SPR->blinktime=PS_HERO_BLINKTIME_SHUT+PS_HERO_BLINKTIME_OPEN_MIN;
-  SPR->blinktime+=rand()%(PS_HERO_BLINKTIME_OPEN_MAX-PS_HERO_BLINKTIME_OPEN_MIN);
+  SPR->blinktime+=ps_game_randint(game,PS_HERO_BLINKTIME_OPEN_MAX-PS_HERO_BLINKTIME_OPEN_MIN);
 }
 
 /* Delete.
@@ -59,7 +59,6 @@ static int _ps_hero_init(struct ps_sprite *spr) {
   SPR->state=PS_HERO_STATE_STOPINPUT;
   SPR->facedir=PS_DIRECTION_SOUTH;
   SPR->hp=PS_HERO_DEFAULT_HP;
-  ps_hero_reset_blinktime(spr);
 
   return 0;
 }
@@ -68,6 +67,7 @@ static int _ps_hero_init(struct ps_sprite *spr) {
  */
 
 static int _ps_hero_configure(struct ps_sprite *spr,struct ps_game *game,const int *argv,int argc,const struct ps_sprdef *sprdef) {
+  ps_hero_reset_blinktime(spr,game);
   return 0;
 }
 
@@ -215,11 +215,11 @@ static int ps_hero_rcvinput(struct ps_sprite *spr,uint16_t input,struct ps_game
 /* Update animation.
  */
 
-static int ps_hero_animate(struct ps_sprite *spr) {
+static int ps_hero_animate(struct ps_sprite *spr,struct ps_game *game) {
 
   /* Blink. */
   if (--(SPR->blinktime)<=0) {
-    ps_hero_reset_blinktime(spr);
+    ps_hero_reset_blinktime(spr,game);
   }
 
   /* Walk. */
@@ -354,7 +354,7 @@ static int _ps_hero_update(struct ps_sprite *spr,struct ps_game *game) {
   }
 
   /* Update animation. */
-  if (ps_hero_animate(spr)<0) return -1;
+  if (ps_hero_animate(spr,game)<0) return -1;
 
   /* Update movement. */
   if (ps_hero_walk(spr,game)<0) return -1;
@@ -219,9 +219,9 @@ static int ps_lobster_arm_update(struct ps_sprite *spr,struct ps_lobster_arm *ar
 
 static int ps_lobster_begin_WALK(struct ps_sprite *spr,struct ps_game *game) {
   SPR->phase=PS_LOBSTER_PHASE_WALK;
-  SPR->phasetime=PS_LOBSTER_WALK_TIME_MIN+(rand()%(PS_LOBSTER_WALK_TIME_MAX-PS_LOBSTER_WALK_TIME_MIN+1));
+  SPR->phasetime=PS_LOBSTER_WALK_TIME_MIN+ps_game_randint(game,PS_LOBSTER_WALK_TIME_MAX-PS_LOBSTER_WALK_TIME_MIN+1);
   
-  double walkangle=(rand()%628)/100.0;
+  double walkangle=ps_game_randint(game,628)/100.0;
   SPR->walkdx=cos(walkangle);
   SPR->walkdy=sin(walkangle);
 
@@ -303,7 +303,7 @@ static int ps_lobster_arm_acquire_target(struct ps_sprite *spr,struct ps_lobster
 static int ps_lobster_begin_KILL(struct ps_sprite *spr,struct ps_game *game) {
 
   SPR->phase=PS_LOBSTER_PHASE_KILL;
-  SPR->phasetime=PS_LOBSTER_KILL_TIME_MIN+(rand()%(PS_LOBSTER_KILL_TIME_MAX-PS_LOBSTER_KILL_TIME_MIN+1));
+  SPR->phasetime=PS_LOBSTER_KILL_TIME_MIN+ps_game_randint(game,PS_LOBSTER_KILL_TIME_MAX-PS_LOBSTER_KILL_TIME_MIN+1);
   SPR->killmidtime=SPR->phasetime>>1;
 
   if (ps_lobster_arm_acquire_target(spr,&SPR->arml,game,1)<0) return -1;
@@ -363,7 +363,7 @@ static int ps_lobster_advance_phase(struct ps_sprite *spr,struct ps_game *game)
       } break;
     default: {
         SPR->phase=PS_LOBSTER_PHASE_IDLE;
-        SPR->phasetime=PS_LOBSTER_IDLE_TIME_MIN+(rand()%(PS_LOBSTER_IDLE_TIME_MAX-PS_LOBSTER_IDLE_TIME_MIN+1));
+        SPR->phasetime=PS_LOBSTER_IDLE_TIME_MIN+ps_game_randint(game,PS_LOBSTER_IDLE_TIME_MAX-PS_LOBSTER_IDLE_TIME_MIN+1);
       }
   }
   return 0;
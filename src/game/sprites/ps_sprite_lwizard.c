@@ -78,7 +78,7 @@ static const char *_ps_lwizard_get_configure_argument_name(int argp) {
 
 static int ps_lwizard_begin_IDLE(struct ps_sprite *spr,struct ps_game *game) {
   SPR->phase=PS_LWIZARD_PHASE_IDLE;
-  SPR->phasetime=PS_LWIZARD_IDLE_TIME_MIN+rand()%(PS_LWIZARD_IDLE_TIME_MAX-PS_LWIZARD_IDLE_TIME_MIN);
+  SPR->phasetime=PS_LWIZARD_IDLE_TIME_MIN+ps_game_randint(game,PS_LWIZARD_IDLE_TIME_MAX-PS_LWIZARD_IDLE_TIME_MIN);
   return 0;
 }
 
@@ -116,7 +116,7 @@ static int ps_lwizard_begin_WALK(struct ps_sprite *spr,struct ps_game *game) {
       }
     }
     if (candidatec) {
-      int candidatep=rand()%candidatec;
+      int candidatep=ps_game_randint(game,candidatec);
       int x=candidatev[candidatep].dx;
       int y=candidatev[candidatep].dy;
       SPR->walkdstx=x*PS_TILESIZE+(PS_TILESIZE>>1);
@@ -176,7 +176,7 @@ static int ps_lwizard_end_SPELL(struct ps_sprite *spr,struct ps_game *game) {
  */
 
 static int ps_lwizard_select_phase(struct ps_sprite *spr,struct ps_game *game) {
-  int selection=rand()%20;
+  int selection=ps_game_randint(game,20);
   if (selection<=14) return ps_lwizard_begin_WALK(spr,game);
   if (selection<=18) return ps_lwizard_begin_SPELL(spr,game);
   return ps_lwizard_begin_IDLE(spr,game);
@@ -114,7 +114,7 @@ static int ps_mimic_find_player(struct ps_sprite *spr,struct ps_game *game) {
   /* Select one randomly. */
   int candidatec=ps_mimic_count_players(game);
   if (candidatec<1) return -1;
-  int candidatep=rand()%candidatec;
+  int candidatep=ps_game_randint(game,candidatec);
   struct ps_sprite *hero=ps_mimic_select_player(game,candidatep);
   if (!hero) return -1;
 
@@ -40,7 +40,7 @@ static int _ps_missile_init(struct ps_sprite *spr) {
 /* Set new destination.
  */
 
-static int ps_missile_set_destination(struct ps_sprite *spr,double dstx,double dsty) {
+static int ps_missile_set_destination(struct ps_sprite *spr,struct ps_game *game,double dstx,double dsty) {
   SPR->dstx=dstx;
   SPR->dsty=dsty;
   double distancex=dstx-spr->x;
@@ -49,7 +49,7 @@ static int ps_missile_set_destination(struct ps_sprite *spr,double dstx,double d
   if (distance>0.0) {
     SPR->dx=(distancex*PS_MISSILE_SPEED)/distance;
     SPR->dy=(distancey*PS_MISSILE_SPEED)/distance;
-  } else switch (rand()%3) {
+  } else switch (ps_game_randint(game,3)) {
     case 0: SPR->dx=PS_MISSILE_SPEED; SPR->dy=0.0; break;
     case 1: SPR->dx=-PS_MISSILE_SPEED; SPR->dy=0.0; break;
     case 2: SPR->dy=PS_MISSILE_SPEED; SPR->dx=0.0; break;
@@ -145,7 +145,7 @@ struct ps_sprite *ps_sprite_missile_new(int sprdefid,struct ps_sprite *user,doub
     return 0;
   }
 
-  if (ps_missile_set_destination(spr,dstx,dsty)<0) {
+  if (ps_missile_set_destination(spr,game,dstx,dsty)<0) {
     ps_sprite_kill(spr);
     return 0;
   }
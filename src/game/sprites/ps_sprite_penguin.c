@@ -106,13 +106,13 @@ static int ps_penguin_begin_DAZED(struct ps_sprite *spr,struct ps_game *game) {
 
 static int ps_penguin_begin_IDLE(struct ps_sprite *spr,struct ps_game *game) {
   SPR->phase=PS_PENGUIN_PHASE_IDLE;
-  SPR->phasetime=PS_PENGUIN_IDLE_TIME_MIN+rand()%(PS_PENGUIN_IDLE_TIME_MAX-PS_PENGUIN_IDLE_TIME_MIN);
+  SPR->phasetime=PS_PENGUIN_IDLE_TIME_MIN+ps_game_randint(game,PS_PENGUIN_IDLE_TIME_MAX-PS_PENGUIN_IDLE_TIME_MIN);
   return 0;
 }
 
 static int ps_penguin_begin_WALK(struct ps_sprite *spr,struct ps_game *game) {
   SPR->phase=PS_PENGUIN_PHASE_WALK;
-  SPR->phasetime=PS_PENGUIN_WALK_TIME_MIN+rand()%(PS_PENGUIN_WALK_TIME_MAX-PS_PENGUIN_WALK_TIME_MIN);
+  SPR->phasetime=PS_PENGUIN_WALK_TIME_MIN+ps_game_randint(game,PS_PENGUIN_WALK_TIME_MAX-PS_PENGUIN_WALK_TIME_MIN);
   if (ps_game_select_random_travel_vector(&SPR->walkdx,&SPR->walkdy,game,spr->x,spr->y,PS_PENGUIN_WALK_SPEED,spr->impassable)<0) return -1;
   return 0;
 }
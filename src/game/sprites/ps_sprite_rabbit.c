@@ -113,7 +113,7 @@ static int ps_rabbit_begin_IDLE(struct ps_sprite *spr,struct ps_game *game) {
 
   /* Remain in IDLE for a random duration within limits. */
   SPR->phase=PS_RABBIT_PHASE_IDLE;
-  SPR->counter=PS_RABBIT_IDLE_TIME_MIN+(rand()%(PS_RABBIT_IDLE_TIME_MAX-PS_RABBIT_IDLE_TIME_MIN+1));
+  SPR->counter=PS_RABBIT_IDLE_TIME_MIN+ps_game_randint(game,PS_RABBIT_IDLE_TIME_MAX-PS_RABBIT_IDLE_TIME_MIN+1);
 
   /* Face whichever direction has more heroes.
    * If equal, face towards the screen center.
@@ -144,11 +144,11 @@ static int ps_rabbit_begin_IDLE(struct ps_sprite *spr,struct ps_game *game) {
 static int ps_rabbit_begin_HOP(struct ps_sprite *spr,struct ps_game *game) {
 
   SPR->phase=PS_RABBIT_PHASE_HOP;
-  SPR->counter=PS_RABBIT_HOP_TIME_MIN+(rand()%(PS_RABBIT_HOP_TIME_MAX-PS_RABBIT_HOP_TIME_MIN+1));
+  SPR->counter=PS_RABBIT_HOP_TIME_MIN+ps_game_randint(game,PS_RABBIT_HOP_TIME_MAX-PS_RABBIT_HOP_TIME_MIN+1);
 
   /* Random direction and speed. */
-  double direction=(rand()%628)/100.0;
-  double speed=(PS_RABBIT_HOP_SPEED_MIN+(rand()%(PS_RABBIT_HOP_SPEED_MAX-PS_RABBIT_HOP_SPEED_MIN+1)))/PS_RABBIT_HOP_SPEED_SCALE;
+  double direction=ps_game_randint(game,628)/100.0;
+  double speed=(PS_RABBIT_HOP_SPEED_MIN+ps_game_randint(game,PS_RABBIT_HOP_SPEED_MAX-PS_RABBIT_HOP_SPEED_MIN+1))/PS_RABBIT_HOP_SPEED_SCALE;
   SPR->dx=cos(direction)*speed;
   SPR->dy=sin(direction)*speed;
 
@@ -233,14 +233,14 @@ static int ps_rabbit_choose_phase(struct ps_sprite *spr,struct ps_game *game) {
   /* Full belly: HOP, SPIT, IDLE. */
   if (SPR->slave->sprc) {
     const int odds_total=PS_RABBIT_FODDS_HOP+PS_RABBIT_FODDS_SPIT+PS_RABBIT_FODDS_IDLE;
-    int odds_selection=rand()%odds_total;
+    int odds_selection=ps_game_randint(game,odds_total);
     if ((odds_selection-=PS_RABBIT_FODDS_HOP)<0) return ps_rabbit_begin_HOP(spr,game);
     if ((odds_selection-=PS_RABBIT_FODDS_SPIT)<0) return ps_rabbit_begin_SPIT(spr,game);
 
   /* Empty belly: HOP, BURN, LICK, IDLE. */
   } else {
     const int odds_total=PS_RABBIT_ODDS_HOP+PS_RABBIT_ODDS_BURN+PS_RABBIT_ODDS_LICK+PS_RABBIT_ODDS_IDLE;
-    int odds_selection=rand()%odds_total;
+    int odds_selection=ps_game_randint(game,odds_total);
     if ((odds_selection-=PS_RABBIT_ODDS_HOP)<0) return ps_rabbit_begin_HOP(spr,game);
     if ((odds_selection-=PS_RABBIT_ODDS_BURN)<0) return ps_rabbit_begin_BURN(spr,game);
     if ((odds_selection-=PS_RABBIT_ODDS_LICK)<0) return ps_rabbit_begin_LICK(spr,game);
@@ -137,7 +137,7 @@ static int ps_sawblade_check_targets(struct ps_sprite *spr,struct ps_game *game)
   /* Check all four directions and engage the first one we find something.
    * Start in a random direction, so if blockages exist during the cooloff period the players won't know which way it will go.
    */
-  int startdir=rand()&3;
+  int startdir=ps_game_randint(game,4);
   int i=0; for (;i<4;i++) {
     int direction=((i+startdir)&3)+1;
     struct ps_vector vector=ps_vector_from_direction(direction);
@@ -76,7 +76,7 @@ static int _ps_seamonster_init(struct ps_sprite *spr) {
 
   SPR->phase=PS_SEAMONSTER_PHASE_RESET;
   SPR->first_update=1;
-  SPR->facedir=(rand()&1)?1:-1;
+  SPR->facedir=1;
   
   return 0;
 }
@@ -85,6 +85,7 @@ static int _ps_seamonster_init(struct ps_sprite *spr) {
  */
 
 static int _ps_seamonster_configure(struct ps_sprite *spr,struct ps_game *game,const int *argv,int argc,const struct ps_sprdef *sprdef) {
+  SPR->facedir=ps_game_randint(game,2)?1:-1;
   return 0;
 }
 
@@ -127,15 +128,15 @@ static int ps_seamonster_select_swim_dst(struct ps_sprite *spr,struct ps_game *g
   int holec=ps_seamonster_count_grid_holes(game->grid);
 
   if (holec>0) {
-    int holep=rand()%holec;
+    int holep=ps_game_randint(game,holec);
     int col,row;
     if (ps_seamonster_get_indexed_hole_cell(&col,&row,game->grid,holep)<0) return -1;
     SPR->dstx=col*PS_TILESIZE+(PS_TILESIZE>>1);
     SPR->dsty=row*PS_TILESIZE+(PS_TILESIZE>>1);
   } else {
     ps_log(GAME,ERROR,"Sea monster in a grid with no HOLE cells.");
-    SPR->dx=(rand()%1000)/1000.0;
-    SPR->dy=(rand()%1000)/1000.0;
+    SPR->dx=ps_game_randint(game,1000)/1000.0;
+    SPR->dy=ps_game_randint(game,1000)/1000.0;
     return 0;
   }
 
@@ -250,7 +251,7 @@ static int ps_seamonster_select_facedir(struct ps_sprite *spr,struct ps_game *ga
 
   if (herocleft>herocright) SPR->facedir=-1;
   else if (herocleft<herocright) SPR->facedir=1;
-  else SPR->facedir=(rand()&1)?1:-1;
+  else SPR->facedir=ps_game_randint(game,2)?1:-1;
 
   return 0;
 }
@@ -317,7 +318,7 @@ static void ps_seamonster_sort_tentacles_vertically(struct ps_tentacle *v,int c)
 
 static int ps_seamonster_calculate_tentacle_positions(struct ps_sprite *spr,struct ps_game *game) {
   SPR->tentaclec=0;
-  double t0=(rand()%100)/100.0; // Start randomly within about an eighth turn.
+  double t0=ps_game_randint(game,100)/100.0; // Start randomly within about an eighth turn.
   int i=0; for (;i<PS_SEAMONSTER_TENTACLE_LIMIT;i++) {
     double t=t0+(i*M_PI*2.0)/PS_SEAMONSTER_TENTACLE_LIMIT;
     if (ps_seamonster_initialize_tentacle(SPR->tentaclev+SPR->tentaclec,spr,game,t)>0) {
@@ -358,13 +359,13 @@ static struct ps_sprite *ps_seamonster_select_target(struct ps_sprite *spr,struc
 
   if (heroc<1) return 0;
   if (heroc==1) return herov[0];
-  return herov[rand()%heroc];
+  return herov[ps_game_randint(game,heroc)];
 }
 
 static int ps_seamonster_select_default_fireball_target(double *dstx,double *dsty,struct ps_sprite *spr,struct ps_game *game) {
   // Offset (*dstx) by a constant amount, then (*dsty) in either direction up to that same constant, randomly.
   if (SPR->facedir>0) *dstx=spr->x+100.0; else *dstx=spr->x-100.0;
-  *dsty=spr->y-100.0+rand()%200;
+  *dsty=spr->y-100.0+ps_game_randint(game,200);
   return 0;
 }
 
@@ -406,14 +407,14 @@ static int ps_seamonster_begin_swim(struct ps_sprite *spr,struct ps_game *game)
 
 static int ps_seamonster_begin_lurk(struct ps_sprite *spr,struct ps_game *game) {
   SPR->phase=PS_SEAMONSTER_PHASE_LURK;
-  SPR->phasetimer=PS_SEAMONSTER_LURK_TIME_MIN+rand()%(PS_SEAMONSTER_LURK_TIME_MAX-PS_SEAMONSTER_LURK_TIME_MIN+1);
+  SPR->phasetimer=PS_SEAMONSTER_LURK_TIME_MIN+ps_game_randint(game,PS_SEAMONSTER_LURK_TIME_MAX-PS_SEAMONSTER_LURK_TIME_MIN+1);
   return 0;
 }
 
 static int ps_seamonster_begin_prefire(struct ps_sprite *spr,struct ps_game *game) {
   PS_SFX_SEAMONSTER_SURFACE
   SPR->phase=PS_SEAMONSTER_PHASE_PREFIRE;
-  SPR->phasetimer=PS_SEAMONSTER_PREFIRE_TIME_MIN+rand()%(PS_SEAMONSTER_PREFIRE_TIME_MAX-PS_SEAMONSTER_PREFIRE_TIME_MIN+1);
+  SPR->phasetimer=PS_SEAMONSTER_PREFIRE_TIME_MIN+ps_game_randint(game,PS_SEAMONSTER_PREFIRE_TIME_MAX-PS_SEAMONSTER_PREFIRE_TIME_MIN+1);
   if (ps_sprgrp_add_sprite(game->grpv+PS_SPRGRP_FRAGILE,spr)<0) return -1;
   if (ps_sprgrp_add_sprite(game->grpv+PS_SPRGRP_HEROHAZARD,spr)<0) return -1;
   if (ps_seamonster_select_facedir(spr,game)<0) return -1;
@@ -430,7 +431,7 @@ static int ps_seamonster_begin_fire(struct ps_sprite *spr,struct ps_game *game)
 
 static int ps_seamonster_begin_postfire(struct ps_sprite *spr,struct ps_game *game) {
   SPR->phase=PS_SEAMONSTER_PHASE_POSTFIRE;
-  SPR->phasetimer=PS_SEAMONSTER_POSTFIRE_TIME_MIN+rand()%(PS_SEAMONSTER_POSTFIRE_TIME_MAX-PS_SEAMONSTER_POSTFIRE_TIME_MIN+1);
+  SPR->phasetimer=PS_SEAMONSTER_POSTFIRE_TIME_MIN+ps_game_randint(game,PS_SEAMONSTER_POSTFIRE_TIME_MAX-PS_SEAMONSTER_POSTFIRE_TIME_MIN+1);
   return 0;
 }
 
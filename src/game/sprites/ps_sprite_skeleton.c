@@ -99,8 +99,8 @@ static int ps_skeleton_update_walk(struct ps_sprite *spr,struct ps_game *game) {
   }
 
   if (SPR->walkcounter--<0) {
-    SPR->walkcounter=PS_SKELETON_WALK_TIME_MIN+rand()%(PS_SKELETON_WALK_TIME_MAX-PS_SKELETON_WALK_TIME_MIN);
-    switch (rand()&3) {
+    SPR->walkcounter=PS_SKELETON_WALK_TIME_MIN+ps_game_randint(game,PS_SKELETON_WALK_TIME_MAX-PS_SKELETON_WALK_TIME_MIN);
+    switch (ps_game_randint(game,4)) {
       case 0: SPR->dx=0; SPR->dy=-1; break;
       case 1: SPR->dx=0; SPR->dy=1; break;
       case 2: SPR->dx=-1; SPR->dy=0; break;
@@ -126,7 +126,7 @@ static int ps_skeleton_update_peekaboo_cranium(struct ps_sprite *spr,struct ps_g
   if (SPR->animcounter-->0) return 0;
   SPR->phase=PS_SKELETON_PHASE_PEEKABOO_PERISCOPE;
   SPR->animframe=0;
-  SPR->animcounter=PS_SKELETON_PERISCOPE_TIME_MIN+rand()%(PS_SKELETON_PERISCOPE_TIME_MAX-PS_SKELETON_PERISCOPE_TIME_MIN);
+  SPR->animcounter=PS_SKELETON_PERISCOPE_TIME_MIN+ps_game_randint(game,PS_SKELETON_PERISCOPE_TIME_MAX-PS_SKELETON_PERISCOPE_TIME_MIN);
   return 0;
 }
 
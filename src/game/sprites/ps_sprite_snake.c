@@ -123,7 +123,7 @@ static int ps_snake_spawn_children(struct ps_sprite *spr,struct ps_game *game) {
 
 static int ps_snake_update_leader(struct ps_sprite *spr,struct ps_game *game) {
 
-  double ddt=((rand()%1000-500)*PS_SNAKE_DDT)/1000.0;
+  double ddt=((ps_game_randint(game,1000)-500)*PS_SNAKE_DDT)/1000.0;
   SPR->dt+=ddt;
   if (SPR->dt<-PS_SNAKE_DT_LIMIT) SPR->dt=-PS_SNAKE_DT_LIMIT;
   if (SPR->dt>PS_SNAKE_DT_LIMIT) SPR->dt=PS_SNAKE_DT_LIMIT;
@@ -97,7 +97,7 @@ static int _ps_tortoise_init(struct ps_sprite *spr) {
   SPR->role=PS_TORTOISE_ROLE_INIT;
   SPR->phase=PS_TORTOISE_PHASE_INIT;
   SPR->hp=PS_TORTOISE_HP_DEFAULT;
-  SPR->facedir=(rand()&1)?-1:1;
+  SPR->facedir=1;
   return 0;
 }
 
@@ -105,6 +105,7 @@ static int _ps_tortoise_init(struct ps_sprite *spr) {
  */
 
 static int _ps_tortoise_configure(struct ps_sprite *spr,struct ps_game *game,const int *argv,int argc,const struct ps_sprdef *sprdef) {
+  SPR->facedir=ps_game_randint(game,2)?-1:1;
   return 0;
 }
 
@@ -119,7 +120,7 @@ static const char *_ps_tortoise_get_configure_argument_name(int argp) {
 static int ps_tortoise_setup(struct ps_sprite *spr,struct ps_game *game) {
   SPR->role=PS_TORTOISE_ROLE_SHELL;
   SPR->phase=PS_TORTOISE_PHASE_COWER;
-  SPR->phasetime=PS_TORTOISE_COWER_TIME_MIN+rand()%(PS_TORTOISE_COWER_TIME_MAX-PS_TORTOISE_COWER_TIME_MIN+1);
+  SPR->phasetime=PS_TORTOISE_COWER_TIME_MIN+ps_game_randint(game,PS_TORTOISE_COWER_TIME_MAX-PS_TORTOISE_COWER_TIME_MIN+1);
   return 0;
 }
 
@@ -201,7 +202,7 @@ static int ps_tortoise_retract_head(struct ps_sprite *spr,struct ps_game *game)
 
 static int ps_tortoise_shell_begin_WALK(struct ps_sprite *spr,struct ps_game *game) {
   SPR->phase=PS_TORTOISE_PHASE_WALK;
-  SPR->phasetime=PS_TORTOISE_COWER_TIME_MIN+rand()%(PS_TORTOISE_COWER_TIME_MAX-PS_TORTOISE_COWER_TIME_MIN+1);
+  SPR->phasetime=PS_TORTOISE_COWER_TIME_MIN+ps_game_randint(game,PS_TORTOISE_COWER_TIME_MAX-PS_TORTOISE_COWER_TIME_MIN+1);
 
   if (ps_game_select_random_travel_vector(&SPR->dx,&SPR->dy,game,spr->x,spr->y,PS_TORTOISE_WALK_SPEED,spr->impassable)<0) return -1;
 
@@ -220,7 +221,7 @@ static int ps_tortoise_shell_begin_WALK(struct ps_sprite *spr,struct ps_game *ga
 
 static int ps_tortoise_shell_begin_COWER(struct ps_sprite *spr,struct ps_game *game) {
   SPR->phase=PS_TORTOISE_PHASE_COWER;
-  SPR->phasetime=PS_TORTOISE_COWER_TIME_MIN+rand()%(PS_TORTOISE_COWER_TIME_MAX-PS_TORTOISE_COWER_TIME_MIN+1);
+  SPR->phasetime=PS_TORTOISE_COWER_TIME_MIN+ps_game_randint(game,PS_TORTOISE_COWER_TIME_MAX-PS_TORTOISE_COWER_TIME_MIN+1);
   if (ps_tortoise_retract_head(spr,game)<0) return -1;
   return 0;
 }
@@ -359,7 +360,7 @@ static int ps_tortoise_shell_select_phase(struct ps_sprite *spr,struct ps_game *
   if (SPR->phase==PS_TORTOISE_PHASE_WALK) return ps_tortoise_shell_begin_COWER(spr,game);
 
   /* Sometimes, throw a bomb and remain in COWER phase. */
-  if (!(rand()%PS_TORTOISE_BOMB_ODDS)) {
+  if (!ps_game_randint(game,PS_TORTOISE_BOMB_ODDS)) {
     int err=ps_tortoise_throw_bomb(spr,game);
     if (err<0) return err;
     if (err>0) return ps_tortoise_shell_begin_COWER(spr,game);
@@ -372,7 +373,7 @@ static int ps_tortoise_shell_select_phase(struct ps_sprite *spr,struct ps_game *
   }
 
   /* WALK or COWER, randomly. */
-  if (rand()&1) {
+  if (ps_game_randint(game,2)) {
     return ps_tortoise_shell_begin_WALK(spr,game);
   } else {
     return ps_tortoise_shell_begin_COWER(spr,game);
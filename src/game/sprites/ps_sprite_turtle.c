@@ -147,7 +147,7 @@ static int ps_turtle_accept_rider(struct ps_sprite *spr,struct ps_game *game,str
   int dirv[4];
   int dirc=ps_turtle_gather_possible_ferry_directions(dirv,spr,game);
   if (dirc>0) {
-    int dirp=rand()%dirc;
+    int dirp=ps_game_randint(game,dirc);
     switch (dirv[dirp]) {
       case PS_DIRECTION_NORTH: SPR->dx=0.0; SPR->dy=-1.0; break;
       case PS_DIRECTION_SOUTH: SPR->dx=0.0; SPR->dy=1.0; break;
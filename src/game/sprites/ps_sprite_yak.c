@@ -220,7 +220,7 @@ static int ps_yak_check_spit_victims(struct ps_sprite *spr,struct ps_game *game)
 
 static int ps_yak_begin_IDLE(struct ps_sprite *spr,struct ps_game *game) {
   SPR->phase=PS_YAK_PHASE_IDLE;
-  SPR->phaselimit=PS_YAK_IDLE_TIME_MIN+rand()%(PS_YAK_IDLE_TIME_MAX-PS_YAK_IDLE_TIME_MIN);
+  SPR->phaselimit=PS_YAK_IDLE_TIME_MIN+ps_game_randint(game,PS_YAK_IDLE_TIME_MAX-PS_YAK_IDLE_TIME_MIN);
   return 0;
 }
 
@@ -229,7 +229,7 @@ static int ps_yak_begin_IDLE(struct ps_sprite *spr,struct ps_game *game) {
 
 static int ps_yak_begin_WALK(struct ps_sprite *spr,struct ps_game *game) {
   SPR->phase=PS_YAK_PHASE_WALK;
-  SPR->phaselimit=PS_YAK_WALK_TIME_MIN+rand()%(PS_YAK_WALK_TIME_MAX-PS_YAK_WALK_TIME_MIN);
+  SPR->phaselimit=PS_YAK_WALK_TIME_MIN+ps_game_randint(game,PS_YAK_WALK_TIME_MAX-PS_YAK_WALK_TIME_MIN);
   SPR->animframe=0;
 
   if (ps_game_select_random_travel_vector(&SPR->walkdx,&SPR->walkdy,game,spr->x,spr->y,PS_YAK_WALK_SPEED,spr->impassable)<0) return -1;
@@ -375,14 +375,14 @@ static int ps_yak_choose_phase(struct ps_sprite *spr,struct ps_game *game) {
   /* If SPIT is an option, give it 1/4 odds.
    */
   if (SPR->full_of_water) {
-    if (!(rand()&3)) {
+    if (!ps_game_randint(game,4)) {
       return ps_yak_begin_SPIT(spr,game);
     }
   }
 
   /* Choose randomly between IDLE and WALK.
    */
-  int selection=rand()%10;
+  int selection=ps_game_randint(game,10);
   if (selection<5) {
     return ps_yak_begin_IDLE(spr,game);
   } else {
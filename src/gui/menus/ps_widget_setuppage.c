@@ -298,10 +298,27 @@ static int ps_setuppage_cb_menu(struct ps_widget *menu,struct ps_widget *widget)
   return 0;
 }
 
+/* Start generating in the background with the current settings.
+ * The game restarts it if anything changed, and uses it if we finish without changing anything else.
+ * Failure here is not fatal; we'd generate at finish instead.
+ */
+
+static int ps_setuppage_pregenerate(struct ps_widget *widget) {
+  struct ps_game *game=ps_gui_get_game(ps_widget_get_gui(widget));
+  if (!game) return 0;
+  if (ps_game_set_difficulty(game,ps_setuppage_get_difficulty(widget))<0) return 0;
+  if (ps_game_set_length(game,ps_setuppage_get_length(widget))<0) return 0;
+  if (ps_game_pregenerate(game)<0) {
+    ps_log(GUI,WARN,"Failed to start background generation.");
+  }
+  return 0;
+}
+
 /* Callback when difficulty or length slider changes.
  */
  
 static int ps_setuppage_cb_difflen(struct ps_widget *slider,struct ps_widget *widget) {
+  if (ps_setuppage_pregenerate(widget)<0) return -1;
   if (WIDGET->tshirt<1) return 0;
   if (widget->childc<2) return 0;
   if (ps_setuppage_populate_tshirt_banner(widget)<0) return -1;
@@ -346,6 +363,8 @@ int ps_widget_setuppage_acquire_initial_settings(struct ps_widget *widget) {
   if (WIDGET->tshirt>0) {
     if (ps_setuppage_populate_tshirt_banner(widget)<0) return -1;
   }
+
+  if (ps_setuppage_pregenerate(widget)<0) return -1;
   
   return 0;
 }
@@ -119,7 +119,7 @@ static int _ps_sprite_draw(struct ps_widget *widget,int parentx,int parenty) {
 
   struct ps_sprgrp *grp=WIDGET->game->grpv+PS_SPRGRP_VISIBLE;
 
-  if (ps_sprgrp_sort(grp,1)<0) return -1;
+  if (ps_sprgrp_sort(grp)<0) return -1;
 
   if (grp&&(grp->sprc>0)) {
     ps_sprite_position_all(grp,parentx+widget->x+(widget->w>>1),parenty+widget->y+(widget->h>>1));
@@ -0,0 +1,459 @@
+#include "ps.h"
+#include <time.h>
+#include "os/ps_userconfig.h"
+#include "os/ps_clockassist.h"
+#include "os/ps_fs.h"
+#include "video/ps_video.h"
+#include "input/ps_input.h"
+#include "input/ps_input_button.h"
+#include "input/ps_input_provider.h"
+#include "input/ps_input_provider_mock.h"
+#include "input/ps_input_record.h"
+#include "input/ps_input_device.h"
+#include "input/ps_input_map.h"
+#include "input/ps_input_maptm.h"
+#include "res/ps_resmgr.h"
+#include "res/ps_restype.h"
+#include "game/ps_game.h"
+#include "game/ps_stats.h"
+#include "game/ps_sprite.h"
+#include "scenario/ps_scenario.h"
+#include "util/ps_text.h"
+#include "util/ps_enums.h"
+#include "util/ps_prng.h"
+
+/* Headless game runner.
+ * Generates and plays seeded games back to back, as fast as the CPU allows, with no window and no audio.
+ * Players are fed from an input record: Random button mashing by default, or a script file.
+ * We log one line per game with its end state, and a summary of frame rate and time per phase of ps_game_update().
+ */
+
+#define PS_HEADLESS_DEFAULT_FRAMES (60*60*10) /* Ten minutes of game time. */
+
+/* Command-line arguments.
+ */
+
+struct ps_headless_args {
+  const char *resources;
+  const char *script; // Null for random input.
+  int gamec;
+  int seed;
+  int playerc;
+  int difficulty;
+  int length;
+  int framec; // Limit per game.
+};
+
+static void ps_headless_print_help(const char *exename) {
+  ps_log(MAIN,INFO,
+    "Usage: %s [OPTIONS]\n"
+    "  --resources=PATH      Data directory or archive (src/data).\n"
+    "  --games=INT           How many games to play (1).\n"
+    "  --seed=INT            Random seed for the first game; each game adds one (time).\n"
+    "  --players=1..8        (2)\n"
+    "  --difficulty=1..9     (4)\n"
+    "  --length=1..9         (4)\n"
+    "  --frames=INT          Limit per game, in frames at 60 Hz (%d).\n"
+    "  --script=PATH         Input script, default is random. Each line is 'FRAMES BUTTONS': Hold BUTTONS for so\n"
+    "                        many frames, eg '30 LEFT,A'. Every player plays the whole script, repeating.\n"
+    "  --log.DOMAIN=LEVEL    Set a log level (TRACE,DEBUG,INFO,WARN,ERROR).",
+    exename,PS_HEADLESS_DEFAULT_FRAMES
+  );
+}
+
+static int ps_headless_arg_int(int *dst,const char *v,int lo,int hi,const char *k) {
+  if ((ps_int_eval(dst,v,-1)<0)||(*dst<lo)||(*dst>hi)) {
+    ps_log(MAIN,ERROR,"Expected integer in %d..%d for '%s', found '%s'.",lo,hi,k,v);
+    return -1;
+  }
+  return 0;
+}
+
+static int ps_headless_args_read(struct ps_headless_args *args,struct ps_userconfig *userconfig,int argc,char **argv) {
+  args->resources="src/data";
+  args->gamec=1;
+  args->seed=time(0);
+  args->playerc=2;
+  args->difficulty=4;
+  args->length=4;
+  args->framec=PS_HEADLESS_DEFAULT_FRAMES;
+
+  int argp=1; for (;argp<argc;argp++) {
+    const char *arg=argv[argp];
+    if (!strcmp(arg,"--help")) {
+      ps_headless_print_help(argv[0]);
+      return -1;
+    }
+    if ((arg[0]!='-')||(arg[1]!='-')) {
+      ps_log(MAIN,ERROR,"Unexpected argument '%s'.",arg);
+      return -1;
+    }
+    const char *k=arg+2,*v=k;
+    int kc=0; while (k[kc]&&(k[kc]!='=')) kc++;
+    if (k[kc]!='=') {
+      ps_log(MAIN,ERROR,"Expected '--KEY=VALUE', found '%s'.",arg);
+      return -1;
+    }
+    v=k+kc+1;
+    #define KEY(name) ((kc==sizeof(name)-1)&&!memcmp(k,name,kc))
+    if (KEY("resources")) args->resources=v;
+    else if (KEY("script")) args->script=v;
+    else if (KEY("games")) { if (ps_headless_arg_int(&args->gamec,v,1,INT_MAX,"games")<0) return -1; }
+    else if (KEY("seed")) { if (ps_headless_arg_int(&args->seed,v,INT_MIN,INT_MAX,"seed")<0) return -1; }
+    else if (KEY("players")) { if (ps_headless_arg_int(&args->playerc,v,1,PS_PLAYER_LIMIT,"players")<0) return -1; }
+    else if (KEY("difficulty")) { if (ps_headless_arg_int(&args->difficulty,v,PS_DIFFICULTY_MIN,PS_DIFFICULTY_MAX,"difficulty")<0) return -1; }
+    else if (KEY("length")) { if (ps_headless_arg_int(&args->length,v,PS_LENGTH_MIN,PS_LENGTH_MAX,"length")<0) return -1; }
+    else if (KEY("frames")) { if (ps_headless_arg_int(&args->framec,v,1,INT_MAX,"frames")<0) return -1; }
+    else if ((kc>4)&&!memcmp(k,"log.",4)) {
+      if (ps_userconfig_set(userconfig,k,kc,v,-1)<0) return -1;
+    } else {
+      ps_log(MAIN,ERROR,"Unexpected option '%.*s'.",kc,k);
+      return -1;
+    }
+    #undef KEY
+  }
+  return 0;
+}
+
+/* Input records.
+ * A script is parsed once, and every player gets a fresh copy of it for each game.
+ * Random records are built per game from the game's seed, so a seed reproduces the whole game.
+ */
+
+static struct ps_input_record *ps_headless_record_from_script(const char *path) {
+  char *src=0;
+  int srcc=ps_file_read(&src,path);
+  if (srcc<0) {
+    ps_log(MAIN,ERROR,"%s: Failed to read input script.",path);
+    return 0;
+  }
+  struct ps_input_record *record=ps_input_record_new();
+  if (!record) { free(src); return 0; }
+
+  int srcp=0,lineno=0;
+  while (srcp<srcc) {
+    const char *line=src+srcp;
+    int linec=0;
+    while ((srcp<srcc)&&(src[srcp]!=0x0a)) { srcp++; linec++; }
+    if (srcp<srcc) srcp++;
+    lineno++;
+    int i=0; for (;i<linec;i++) if (line[i]=='#') { linec=i; break; }
+    while (linec&&((unsigned char)line[linec-1]<=0x20)) linec--;
+    while (linec&&((unsigned char)line[0]<=0x20)) { line++; linec--; }
+    if (!linec) continue;
+
+    int delayc=0; while ((delayc<linec)&&((unsigned char)line[delayc]>0x20)) delayc++;
+    int delay;
+    if ((ps_int_eval(&delay,line,delayc)<0)||(delay<0)) {
+      ps_log(MAIN,ERROR,"%s:%d: Expected delay in frames, found '%.*s'.",path,lineno,delayc,line);
+      goto _error_;
+    }
+    const char *btns=line+delayc;
+    int btnsc=linec-delayc;
+    while (btnsc&&((unsigned char)btns[0]<=0x20)) { btns++; btnsc--; }
+    uint16_t state=0;
+    while (btnsc>0) {
+      int tokenc=0; while ((tokenc<btnsc)&&(btns[tokenc]!=',')) tokenc++;
+      int btnid=ps_plrbtn_eval(btns,tokenc);
+      if ((btnid<0)&&(ps_int_eval(&btnid,btns,tokenc)<0)) {
+        ps_log(MAIN,ERROR,"%s:%d: Unknown button '%.*s'.",path,lineno,tokenc,btns);
+        goto _error_;
+      }
+      state|=btnid;
+      if (tokenc<btnsc) tokenc++;
+      btns+=tokenc;
+      btnsc-=tokenc;
+    }
+    if (ps_input_record_add_event(record,delay,state&PS_PLRBTN_MAPPABLE)<0) goto _error_;
+  }
+
+  free(src);
+  return record;
+ _error_:
+  free(src);
+  ps_input_record_del(record);
+  return 0;
+}
+
+/* Mash at random: Hold a direction for a while, with occasional attacks.
+ * Never START; that would pause the game.
+ */
+
+static struct ps_input_record *ps_headless_record_random(struct ps_prng *prng,int framec) {
+  static const uint16_t dirv[]={
+    0,PS_PLRBTN_UP,PS_PLRBTN_DOWN,PS_PLRBTN_LEFT,PS_PLRBTN_RIGHT,
+    PS_PLRBTN_UP|PS_PLRBTN_LEFT,PS_PLRBTN_UP|PS_PLRBTN_RIGHT,
+    PS_PLRBTN_DOWN|PS_PLRBTN_LEFT,PS_PLRBTN_DOWN|PS_PLRBTN_RIGHT,
+  };
+  struct ps_input_record *record=ps_input_record_new();
+  if (!record) return 0;
+  while (framec>0) {
+    uint16_t state=dirv[ps_prng_int(prng,sizeof(dirv)/sizeof(dirv[0]))];
+    switch (ps_prng_int(prng,4)) {
+      case 0: state|=PS_PLRBTN_A; break;
+      case 1: state|=PS_PLRBTN_B; break;
+    }
+    int delay=10+ps_prng_int(prng,80);
+    if (ps_input_record_add_event(record,delay,state)<0) {
+      ps_input_record_del(record);
+      return 0;
+    }
+    framec-=delay+1;
+  }
+  return record;
+}
+
+/* Records keep their own playback position, so each player needs a copy.
+ */
+
+static struct ps_input_record *ps_headless_record_copy(const struct ps_input_record *src) {
+  struct ps_input_record *record=ps_input_record_new();
+  if (!record) return 0;
+  int i=0; for (;i<src->eventc;i++) {
+    if (ps_input_record_add_event(record,src->eventv[i].delay,src->eventv[i].state)<0) {
+      ps_input_record_del(record);
+      return 0;
+    }
+  }
+  return record;
+}
+
+/* Global state.
+ */
+
+static struct {
+  struct ps_headless_args args;
+  struct ps_userconfig *userconfig;
+  struct ps_input_provider *provider;
+  struct ps_input_record *script;
+  struct ps_input_record *recordv[PS_PLAYER_LIMIT];
+  uint16_t statev[PS_PLAYER_LIMIT];
+  struct ps_game_timing timing;
+  int64_t elapsed_us;
+  int completec;
+  int failc;
+} ps_headless={0};
+
+static const char *ps_headless_device_name(int playerid) {
+  static const char *namev[PS_PLAYER_LIMIT]={
+    "headless-1","headless-2","headless-3","headless-4","headless-5","headless-6","headless-7","headless-8",
+  };
+  return namev[playerid-1];
+}
+
+/* Map a mock device's buttons straight through to the same player buttons.
+ * Normally a map comes from the input configuration, which we don't load.
+ */
+
+static int ps_headless_map_device(struct ps_input_device *device) {
+  struct ps_input_maptm *maptm=ps_input_maptm_generate_from_device(device);
+  if (!maptm) return -1;
+  uint16_t btnid=1; for (;btnid&PS_PLRBTN_MAPPABLE;btnid<<=1) {
+    struct ps_input_maptm_fld *fld=ps_input_maptm_fld_insert(maptm,-1,btnid);
+    if (!fld) {
+      ps_input_maptm_del(maptm);
+      return -1;
+    }
+    fld->dstbtnid=btnid;
+    fld->srclo=1;
+    fld->srchi=1;
+  }
+  struct ps_input_map *map=ps_input_maptm_apply_for_device(maptm,device);
+  ps_input_maptm_del(maptm);
+  if (!map) return -1;
+  int err=ps_input_device_set_map(device,map);
+  ps_input_map_del(map);
+  return err;
+}
+
+/* Init.
+ */
+
+static int ps_headless_init() {
+
+  if (ps_video_init_headless()<0) return -1;
+
+  if (ps_input_init()<0) return -1;
+  if (!(ps_headless.provider=ps_input_provider_mock_new())) return -1;
+  if (ps_input_install_provider(ps_headless.provider)<0) return -1;
+  int playerid=1; for (;playerid<=PS_PLAYER_LIMIT;playerid++) {
+    if (ps_input_provider_mock_add_device(ps_headless.provider,ps_headless_device_name(playerid))<0) return -1;
+    if (ps_headless_map_device(ps_headless.provider->devv[playerid-1])<0) return -1;
+  }
+
+  if (ps_resmgr_init(ps_headless.args.resources,0)<0) return -1;
+
+  if (ps_headless.args.script) {
+    if (!(ps_headless.script=ps_headless_record_from_script(ps_headless.args.script))) return -1;
+  }
+
+  return 0;
+}
+
+static void ps_headless_quit() {
+  ps_sprite_pool_release();
+  int i=PS_PLAYER_LIMIT; while (i-->0) ps_input_record_del(ps_headless.recordv[i]);
+  ps_input_record_del(ps_headless.script);
+  ps_resmgr_quit();
+  ps_input_quit();
+  ps_input_provider_del(ps_headless.provider);
+  ps_video_quit();
+  ps_userconfig_del(ps_headless.userconfig);
+}
+
+/* Deliver this frame's input to the mock devices.
+ */
+
+static int ps_headless_feed_input(int playerc) {
+  int playerid=1; for (;playerid<=playerc;playerid++) {
+    struct ps_input_record *record=ps_headless.recordv[playerid-1];
+    uint16_t state=ps_input_record_update(record);
+    uint16_t changed=state^ps_headless.statev[playerid-1];
+    if (!changed) continue;
+    ps_headless.statev[playerid-1]=state;
+    uint16_t btnid=1; for (;btnid&PS_PLRBTN_MAPPABLE;btnid<<=1) {
+      if (!(changed&btnid)) continue;
+      if (ps_input_provider_mock_set_button(ps_headless.provider,ps_headless_device_name(playerid),btnid,(state&btnid)?1:0)<0) return -1;
+    }
+  }
+  return 0;
+}
+
+/* Play one game.
+ */
+
+static int ps_headless_play(int gamep) {
+  const struct ps_headless_args *args=&ps_headless.args;
+  int seed=args->seed+gamep;
+  struct ps_prng prng;
+  ps_prng_init(&prng,seed);
+
+  struct ps_game *game=ps_game_new(ps_headless.userconfig);
+  if (!game) return -1;
+  int i,err=-1;
+
+  /* Configure players with random heroes, and give each an input record. */
+  if (ps_game_set_player_count(game,args->playerc)<0) goto _done_;
+  if (ps_input_set_player_count(args->playerc)<0) goto _done_;
+  const struct ps_restype *plrdefs=PS_RESTYPE(PLRDEF);
+  if (!plrdefs||(plrdefs->resc<1)) goto _done_;
+  for (i=1;i<=args->playerc;i++) {
+    struct ps_input_provider *provider=ps_headless.provider;
+    struct ps_input_device *device=provider->devv[i-1];
+    int plrdefid=plrdefs->resv[ps_prng_int(&prng,plrdefs->resc)].id;
+    if (ps_game_configure_player(game,i,plrdefid,i-1,device)<0) goto _done_;
+    ps_input_record_del(ps_headless.recordv[i-1]);
+    if (ps_headless.script) {
+      ps_headless.recordv[i-1]=ps_headless_record_copy(ps_headless.script);
+    } else {
+      ps_headless.recordv[i-1]=ps_headless_record_random(&prng,args->framec);
+    }
+    if (!ps_headless.recordv[i-1]) goto _done_;
+  }
+  if (ps_game_set_difficulty(game,args->difficulty)<0) goto _done_;
+  if (ps_game_set_length(game,args->length)<0) goto _done_;
+  if (ps_game_set_seed(game,seed)<0) goto _done_;
+  if (ps_game_generate(game)<0) {
+    ps_log(MAIN,ERROR,"Game %d (seed %d): Failed to generate scenario.",gamep,seed);
+    goto _done_;
+  }
+  if (ps_game_restart(game)<0) goto _done_;
+
+  /* Run until finished or out of time. Anything that would wait on the GUI, we dismiss. */
+  game->timing=&ps_headless.timing;
+  int64_t start=ps_time_now();
+  int framep=0;
+  for (;framep<args->framec;framep++) {
+    if (game->finished) break;
+    if (ps_headless_feed_input(args->playerc)<0) goto _done_;
+    if (ps_input_update()<0) goto _done_;
+    if (game->paused) {
+      if (ps_game_pause(game,0)<0) goto _done_;
+    }
+    game->got_treasure=0;
+    if (ps_game_update(game)<0) {
+      ps_log(MAIN,ERROR,"Game %d (seed %d): Update failed at frame %d.",gamep,seed,framep);
+      goto _done_;
+    }
+  }
+  ps_headless.elapsed_us+=ps_time_now()-start;
+
+  /* Report end state. */
+  int deathc=0,killc=0;
+  for (i=0;i<args->playerc;i++) {
+    deathc+=game->stats->playerv[i].deathc;
+    killc+=game->stats->playerv[i].killc_monster;
+  }
+  ps_log(MAIN,INFO,
+    "%6d %11d %8s %8d %3d/%-3d %5d %6d %5d",
+    gamep,seed,game->finished?"complete":"timeout",game->stats->playtime,
+    ps_game_count_collected_treasures(game),game->treasurec,
+    game->scenario->w*game->scenario->h,killc,deathc
+  );
+  if (game->finished) ps_headless.completec++;
+
+  err=0;
+ _done_:
+  game->timing=0;
+  ps_game_del(game);
+  return err;
+}
+
+/* Summary.
+ */
+
+static void ps_headless_report() {
+  const struct ps_game_timing *timing=&ps_headless.timing;
+  int gamec=ps_headless.args.gamec;
+  ps_log(MAIN,INFO,
+    "%d games, %d complete, %d failed, %lld frames in %d.%03d s",
+    gamec,ps_headless.completec,ps_headless.failc,(long long)timing->framec,
+    (int)(ps_headless.elapsed_us/1000000),(int)((ps_headless.elapsed_us%1000000)/1000)
+  );
+  if ((timing->framec<1)||(ps_headless.elapsed_us<1)) return;
+  double fps=(timing->framec*1000000.0)/ps_headless.elapsed_us;
+  double games_per_hour=((gamec-ps_headless.failc)*3600000000.0)/ps_headless.elapsed_us;
+  ps_log(MAIN,INFO,"%.0f frames per second, %.0f games per hour",fps,games_per_hour);
+  double n=(double)timing->framec;
+  ps_log(MAIN,INFO,
+    "us/frame: logic %.2f, sprites %.2f, physics %.2f, damage %.2f, grid %.2f, other %.2f",
+    timing->logic/n,timing->sprites/n,timing->physics/n,timing->damage/n,timing->grid/n,
+    (ps_headless.elapsed_us-timing->logic-timing->sprites-timing->physics-timing->damage-timing->grid)/n
+  );
+  struct ps_sprite_pool_stats pool;
+  ps_sprite_pool_get_stats(&pool);
+  ps_log(MAIN,INFO,
+    "sprites/frame: %.2f created, %.3f slabs, %.3f group lists spilled; %lld slabs, %lld kB total",
+    pool.allocc/n,pool.slabc/n,pool.spillc/n,(long long)pool.slabc,(long long)(pool.bytec>>10)
+  );
+}
+
+/* Main entry point.
+ */
+
+int main(int argc,char **argv) {
+
+  if (
+    !(ps_headless.userconfig=ps_userconfig_new())||
+    (ps_userconfig_declare_default_fields(ps_headless.userconfig)<0)
+  ) return 1;
+  if (ps_headless_args_read(&ps_headless.args,ps_headless.userconfig,argc,argv)<0) {
+    ps_userconfig_del(ps_headless.userconfig);
+    return 1;
+  }
+
+  if (ps_headless_init()<0) {
+    ps_log(MAIN,ERROR,"Failed to initialize.");
+    ps_headless_quit();
+    return 1;
+  }
+
+  ps_log(MAIN,INFO,"%6s %11s %8s %8s %7s %5s %6s %5s","game","seed","result","frames","treas","scrns","kills","deaths");
+  int gamep=0; for (;gamep<ps_headless.args.gamec;gamep++) {
+    if (ps_headless_play(gamep)<0) ps_headless.failc++;
+  }
+  ps_headless_report();
+
+  ps_headless_quit();
+  return ps_headless.failc?1:0;
+}
@@ -5,12 +5,15 @@
 #include "os/ps_userconfig.h"
 #include "util/ps_perfmon.h"
 #include "video/ps_video.h"
+#include "akgl/akgl.h"
 #include "input/ps_input.h"
 #include "input/ps_input_button.h"
 #include "input/ps_input_provider_mock.h"
 #include "input/ps_input_provider.h"
 #include "res/ps_resmgr.h"
 #include "game/ps_game.h"
+#include "game/ps_sprite.h"
+#include "scenario/ps_scgen_async.h"
 #include "gui/ps_gui.h"
 #include "gui/ps_widget.h"
 #include "gui/corewidgets/ps_corewidgets.h"
@@ -39,6 +42,9 @@
 #if PS_USE_mshid
   #include "opt/mshid/ps_mshid.h"
 #endif
+#if PS_USE_alsa
+  #include "opt/alsa/ps_alsa.h"
+#endif
 
 /* Globals.
  */
@@ -152,19 +158,54 @@ static void ps_log_akau(int level,const char *msg,int msgc) {
   }
 }
 
+/* Keep printed songs in a directory beside the config file, if we know where that is.
+ */
+
+static int ps_main_init_songcache(struct ps_userconfig *userconfig) {
+  const char *cfgpath=ps_userconfig_get_path(userconfig);
+  if (!cfgpath||!cfgpath[0]) return 0;
+  char path[1024];
+  int pathc=ps_file_dirname(path,sizeof(path),cfgpath,-1);
+  if ((pathc<0)||(pathc>sizeof(path)-11)) return 0;
+  if (!pathc) path[pathc++]='.';
+  memcpy(path+pathc,"/songcache",11);
+  ps_log(MAIN,DEBUG,"Caching printed songs in '%s'.",path);
+  return akau_songcache_set_path(akau_get_songcache(),path);
+}
+
+/* Background generator status, for perfmon.
+ */
+
+static int ps_main_get_generator_status(struct ps_scgen_async_status *status) {
+  if (!ps_game||!ps_game->pregen) return -1;
+  return ps_scgen_async_get_status(status,ps_game->pregen);
+}
+
 /* Init audio.
  */
 
+static int ps_main_get_audio_status(int *latency_us,int *xrunc) {
+  struct akau_driver_status status;
+  if (akau_get_driver_status(&status)<0) return -1;
+  *latency_us=status.latency_us;
+  *xrunc=status.xrunc;
+  return 0;
+}
+
 static int ps_main_init_audio(struct ps_userconfig *userconfig) {
 
   #define PS_AKAU_ENABLE 1
   const char *device=ps_userconfig_get_str(userconfig,"audio-device",-1);
   int rate=ps_userconfig_get_int(userconfig,"audio-rate",-1);
   int chanc=ps_userconfig_get_int(userconfig,"audio-chanc",-1);
+  if (ps_perfmon_set_audio_status_source(ps_perfmon,ps_main_get_audio_status)<0) return -1;
   
   #if PS_USE_akmacaudio
     if (akau_init(&akau_driver_akmacaudio,ps_log_akau,device,rate,chanc)<0) return -1;
   #elif PS_USE_alsa
+    int low_latency=ps_userconfig_get_int(userconfig,"audio-low-latency",-1);
+    int period=ps_userconfig_get_int(userconfig,"audio-period",-1);
+    if (ps_alsa_set_period(low_latency,period)<0) return -1;
     if (akau_init(&akau_driver_alsa,ps_log_akau,device,rate,chanc)<0) return -1;
   #elif PS_USE_msaudio
     if (akau_init(&akau_driver_msaudio,ps_log_akau,device,rate,chanc)<0) return -1;
@@ -180,6 +221,7 @@ static int ps_main_init_audio(struct ps_userconfig *userconfig) {
     int sfx_level=ps_userconfig_get_field_as_int(userconfig,ps_userconfig_search_field(userconfig,"sound",5));
     if (akau_set_trim_for_intent(AKAU_INTENT_BGM,bgm_level)<0) return -1;
     if (akau_set_trim_for_intent(AKAU_INTENT_SFX,sfx_level)<0) return -1;
+    if (ps_main_init_songcache(userconfig)<0) return -1;
   #endif
   
   return 0;
@@ -203,6 +245,7 @@ static int ps_main_init(struct ps_userconfig *userconfig) {
   srand(randseed);
   
   if (ps_video_init(userconfig)<0) return -1;
+  akgl_set_vbo_enabled(ps_userconfig_get_int(userconfig,"video-vbo",-1));
 
   if (ps_main_init_input(userconfig)<0) {
     ps_log(MAIN,ERROR,"Failed to initialize input.");
@@ -219,6 +262,7 @@ static int ps_main_init(struct ps_userconfig *userconfig) {
   if (ps_resmgr_init(resources_path,0)<0) return -1;
 
   if (!(ps_game=ps_game_new(userconfig))) return -1;
+  if (ps_perfmon_set_generator_status_source(ps_perfmon,ps_main_get_generator_status)<0) return -1;
 
   if (!(ps_gui=ps_gui_new())) return -1;
   if (ps_gui_set_game(ps_gui,ps_game)<0) return -1;
@@ -257,6 +301,7 @@ static void ps_main_quit() {
   ps_gui_del(ps_gui);
   ps_drop_global_gui();
   ps_game_del(ps_game);
+  ps_sprite_pool_release();
   
   ps_emergency_abort_set_message("Shutting down resource manager.");
   ps_resmgr_quit();
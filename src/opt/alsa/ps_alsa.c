@@ -1,15 +1,21 @@
 #include "ps_alsa.h"
 #include "os/ps_emergency_abort.h"
+#include "akau/akau_driver.h"
+#include "akau/akau_period.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
 #include <pthread.h>
 #include <alsa/asoundlib.h>
 
-// Size of hardware buffer in frames (ie 1/44100 of second).
-// Lower values increase likelihood of underrun.
-// Higher values uniformly increase latency.
-// Must be a power of two.
-// I find 2048 works, but haven't tested it under heavy load yet.
-#define PS_ALSA_BUFFER_SIZE 2048
+/* Hardware period, ie how much we refill at a time, is chosen by akau_period.
+ * Normal mode is 2 periods of 1024 frames, the same 2048-frame buffer we always used, and grows on underrun.
+ * Low-latency mode starts smaller and shrinks as far as the machine will tolerate.
+ * Device "null" accepts any configuration and consumes instantly, for trying this without a sound card.
+ * It never underruns on its own; see ps_alsa_simulate_xrun().
+ */
 
 /* Globals.
  */
@@ -22,17 +28,132 @@ static struct {
 
   int rate;
   int chanc;
-  int hwbuffersize;
-  int bufc; // frames
+  int hwbuffersize; // frames
+  int bufc; // frames, one period
   int bufc_samples;
   int16_t *buf;
 
+  int low_latency;
+  int period_request;
+  struct akau_period period; // Only the I/O thread touches this after init.
+  struct akau_driver_status status; // Published by the I/O thread with atomic stores.
+
   pthread_t iothd;
   pthread_mutex_t iomtx;
   int ioabort; // Extra cancellation flag for tidy shutdown (not technically necessary).
+  int simulate_xrun; // Atomic. Nonzero to fail the next write as an underrun.
   
 } ps_alsa={0};
 
+/* Negotiate hardware parameters for the current period size, and size our buffer to match.
+ * PCM must be freshly opened, or dropped.
+ */
+
+static int ps_alsa_configure_hw() {
+  unsigned int rate=ps_alsa.rate;
+  unsigned int chanc=ps_alsa.chanc;
+  snd_pcm_uframes_t period=ps_alsa.period.period;
+  unsigned int periodc=ps_alsa.period.periodc;
+  snd_pcm_uframes_t hwbuffersize=0;
+
+  if (snd_pcm_hw_params_any(ps_alsa.alsa,ps_alsa.hwparams)<0) return -1;
+  if (snd_pcm_hw_params_set_access(ps_alsa.alsa,ps_alsa.hwparams,SND_PCM_ACCESS_RW_INTERLEAVED)<0) return -1;
+  if (snd_pcm_hw_params_set_format(ps_alsa.alsa,ps_alsa.hwparams,SND_PCM_FORMAT_S16)<0) return -1;
+  if (snd_pcm_hw_params_set_rate_near(ps_alsa.alsa,ps_alsa.hwparams,&rate,0)<0) return -1;
+  if (snd_pcm_hw_params_set_channels_near(ps_alsa.alsa,ps_alsa.hwparams,&chanc)<0) return -1;
+  if (snd_pcm_hw_params_set_period_size_near(ps_alsa.alsa,ps_alsa.hwparams,&period,0)<0) return -1;
+  if (snd_pcm_hw_params_set_periods_near(ps_alsa.alsa,ps_alsa.hwparams,&periodc,0)<0) return -1;
+  if (snd_pcm_hw_params(ps_alsa.alsa,ps_alsa.hwparams)<0) return -1;
+  if (snd_pcm_hw_params_get_period_size(ps_alsa.hwparams,&period,0)<0) return -1;
+  if (snd_pcm_hw_params_get_buffer_size(ps_alsa.hwparams,&hwbuffersize)<0) return -1;
+  if (snd_pcm_prepare(ps_alsa.alsa)<0) return -1;
+
+  /* Channel count is fixed once the callback knows it. Rate could drift by a hair, and that's fine. */
+  if (ps_alsa.buf&&(chanc!=ps_alsa.chanc)) return -1;
+  if ((period<1)||(period>INT_MAX/(chanc*2))) return -1;
+
+  if ((int)period!=ps_alsa.bufc) {
+    void *nv=realloc(ps_alsa.buf,chanc*2*period);
+    if (!nv) return -1;
+    ps_alsa.buf=nv;
+  }
+  ps_alsa.rate=rate;
+  ps_alsa.chanc=chanc;
+  ps_alsa.bufc=period;
+  ps_alsa.bufc_samples=period*chanc;
+  ps_alsa.hwbuffersize=hwbuffersize;
+
+  __atomic_store_n(&ps_alsa.status.period,ps_alsa.bufc,__ATOMIC_RELAXED);
+  __atomic_store_n(&ps_alsa.status.latency_us,(int)(((int64_t)hwbuffersize*1000000)/rate),__ATOMIC_RELAXED);
+  return 0;
+}
+
+/* Fill one period from the callback.
+ */
+
+static void ps_alsa_fill() {
+  ps_emergency_abort_set_message("Refilling audio buffer.");
+  if (pthread_mutex_lock(&ps_alsa.iomtx)) return;
+  ps_alsa.cb(ps_alsa.buf,ps_alsa.bufc_samples);
+  pthread_mutex_unlock(&ps_alsa.iomtx);
+}
+
+/* Recover from a failed write.
+ * Returns >0 if it was an underrun, 0 for other recoverable errors, or <0 if we must stop.
+ */
+
+static int ps_alsa_recover(int err) {
+  int xrun=(err==-EPIPE);
+  if ((err=snd_pcm_recover(ps_alsa.alsa,err,0))<0) {
+    fprintf(stderr,"ps: snd_pcm_writei: %d (%s)\n",err,snd_strerror(err));
+    return -1;
+  }
+  ps_emergency_abort_set_message("Recovered from pcm write error.");
+  return xrun;
+}
+
+/* Send one period to ALSA.
+ * Returns >0 on underrun (recovered), 0 if all written, or <0 if we must stop.
+ */
+
+static int ps_alsa_write() {
+  int16_t *samplev=ps_alsa.buf;
+  int framep=0,framec=ps_alsa.bufc;
+  while (framep<framec) {
+    pthread_testcancel();
+    ps_emergency_abort_set_message("Sending audio to ALSA.");
+    int err=snd_pcm_writei(ps_alsa.alsa,samplev+framep*ps_alsa.chanc,framec-framep);
+    if (ps_alsa.ioabort) return -1;
+    if (err<=0) return ps_alsa_recover(err);
+    framep+=err;
+  }
+  return 0;
+}
+
+/* Change period size from the I/O thread.
+ * ALSA only renegotiates on a stopped stream, so drop whatever is buffered; after an underrun that's nothing anyway.
+ * Then refill the whole new buffer before returning, so playback resumes at once instead of starting from empty.
+ * The cost of shrinking is skipping what was still buffered, at most one old buffer, but never a gap of silence.
+ */
+
+static int ps_alsa_reconfigure() {
+  ps_emergency_abort_set_message("Reconfiguring ALSA period.");
+  if (snd_pcm_drop(ps_alsa.alsa)<0) return -1;
+  if (ps_alsa_configure_hw()<0) {
+    fprintf(stderr,"ps: Failed to reconfigure ALSA for period %d.\n",ps_alsa.period.period);
+    return -1;
+  }
+  int i=ps_alsa.hwbuffersize/ps_alsa.bufc; for (;i-->0;) {
+    ps_alsa_fill();
+    if (ps_alsa_write()<0) return -1;
+  }
+  fprintf(stderr,
+    "ALSA period %d frames, buffer %d frames, %d us latency, %d underruns\n",
+    ps_alsa.bufc,ps_alsa.hwbuffersize,ps_alsa.status.latency_us,ps_alsa.period.xrunc
+  );
+  return 0;
+}
+
 /* I/O thread.
  */
 
@@ -40,66 +161,67 @@ static void *ps_alsa_iothd(void *dummy) {
   pthread_setcancelstate(PTHREAD_CANCEL_DISABLE,NULL);
   while (1) {
     pthread_testcancel();
-    ps_emergency_abort_set_message("Refilling audio buffer.");
-    
-    // fill buffer
-    if (pthread_mutex_lock(&ps_alsa.iomtx)) return 0;
-    ps_alsa.cb(ps_alsa.buf,ps_alsa.bufc_samples);
-    pthread_mutex_unlock(&ps_alsa.iomtx);
-
-    // dump buffer to alsa
-    int16_t *samplev=ps_alsa.buf;
-    int samplep=0,samplec=ps_alsa.bufc;
-    while (samplep<samplec) {
-      pthread_testcancel();
-      ps_emergency_abort_set_message("Sending audio to ALSA.");
-      int err=snd_pcm_writei(ps_alsa.alsa,samplev+samplep,samplec-samplep);
-      if (ps_alsa.ioabort) return 0;
-      if (err<=0) {
-        if ((err=snd_pcm_recover(ps_alsa.alsa,err,0))<0) {
-          fprintf(stderr,"ps: snd_pcm_writei: %d (%s)\n",err,snd_strerror(err));
-          return 0;
-        }
-        ps_emergency_abort_set_message("Recovered from pcm write error.");
-        break;
-      }
-      samplep+=err;
+    ps_alsa_fill();
+    int xrun;
+    if (__atomic_exchange_n(&ps_alsa.simulate_xrun,0,__ATOMIC_RELAXED)) xrun=ps_alsa_recover(-EPIPE);
+    else xrun=ps_alsa_write();
+    if (xrun<0) return 0;
+
+    // adapt period size
+    int change;
+    if (xrun) {
+      change=akau_period_xrun(&ps_alsa.period);
+      __atomic_store_n(&ps_alsa.status.xrunc,ps_alsa.period.xrunc,__ATOMIC_RELAXED);
+    } else {
+      change=akau_period_ok(&ps_alsa.period);
     }
+    if ((change>0)&&(ps_alsa_reconfigure()<0)) return 0;
   }
   return 0;
 }
 
+/* Testing.
+ */
+
+int ps_alsa_simulate_xrun() {
+  if (!ps_alsa.alsa) return -1;
+  __atomic_store_n(&ps_alsa.simulate_xrun,1,__ATOMIC_RELAXED);
+  return 0;
+}
+
+/* Configure.
+ */
+
+int ps_alsa_set_period(int low_latency,int period) {
+  if (ps_alsa.alsa) return -1;
+  ps_alsa.low_latency=low_latency;
+  ps_alsa.period_request=period;
+  return 0;
+}
+
 /* Init.
  */
  
 int ps_alsa_init(const char *device,int rate,int chanc,void (*cb)(int16_t *dst,int dstac)) {
   if (!cb) return -1;
+  int low_latency=ps_alsa.low_latency;
+  int period_request=ps_alsa.period_request;
   memset(&ps_alsa,0,sizeof(ps_alsa));
   ps_alsa.cb=cb;
+  ps_alsa.low_latency=low_latency;
+  ps_alsa.period_request=period_request;
 
   ps_alsa.rate=rate;
   ps_alsa.chanc=chanc;
   if (!device||!device[0]) device="default";
-  fprintf(stderr,"ALSA pre init: %s %d %d\n",device,ps_alsa.rate,ps_alsa.chanc);
+  fprintf(stderr,"ALSA pre init: %s %d %d%s\n",device,ps_alsa.rate,ps_alsa.chanc,low_latency?" low-latency":"");
 
+  if (akau_period_init(&ps_alsa.period,rate,low_latency,period_request)<0) return -1;
   if (snd_pcm_open(&ps_alsa.alsa,device,SND_PCM_STREAM_PLAYBACK,0)<0) return -1;
   if (snd_pcm_hw_params_malloc(&ps_alsa.hwparams)<0) return -1;
-  if (snd_pcm_hw_params_any(ps_alsa.alsa,ps_alsa.hwparams)<0) return -1;
-  if (snd_pcm_hw_params_set_access(ps_alsa.alsa,ps_alsa.hwparams,SND_PCM_ACCESS_RW_INTERLEAVED)<0) return -1;
-  if (snd_pcm_hw_params_set_format(ps_alsa.alsa,ps_alsa.hwparams,SND_PCM_FORMAT_S16)<0) return -1;
-  if (snd_pcm_hw_params_set_rate_near(ps_alsa.alsa,ps_alsa.hwparams,&rate,0)<0) return -1;
-  if (snd_pcm_hw_params_set_channels_near(ps_alsa.alsa,ps_alsa.hwparams,&chanc)<0) return -1;
-  if (snd_pcm_hw_params_set_buffer_size(ps_alsa.alsa,ps_alsa.hwparams,PS_ALSA_BUFFER_SIZE)<0) return -1;
-  if (snd_pcm_hw_params(ps_alsa.alsa,ps_alsa.hwparams)<0) return -1;
-
+  if (ps_alsa_configure_hw()<0) return -1;
   if (snd_pcm_nonblock(ps_alsa.alsa,0)<0) return -1;
-  if (snd_pcm_prepare(ps_alsa.alsa)<0) return -1;
-  ps_alsa.rate=rate;
-  ps_alsa.chanc=chanc;
-  ps_alsa.bufc=PS_ALSA_BUFFER_SIZE;
-  ps_alsa.bufc_samples=PS_ALSA_BUFFER_SIZE*chanc;
-  ps_alsa.cb=cb;
-  if (!(ps_alsa.buf=malloc(chanc*2*ps_alsa.bufc))) return -1;
+  fprintf(stderr,"ALSA period %d frames, buffer %d frames\n",ps_alsa.bufc,ps_alsa.hwbuffersize);
 
   { pthread_mutexattr_t mattr;
     pthread_mutexattr_init(&mattr);
@@ -133,7 +255,11 @@ void ps_alsa_quit() {
   }
   if (ps_alsa.buf) free(ps_alsa.buf);
 
+  int low_latency=ps_alsa.low_latency;
+  int period_request=ps_alsa.period_request;
   memset(&ps_alsa,0,sizeof(ps_alsa));
+  ps_alsa.low_latency=low_latency;
+  ps_alsa.period_request=period_request;
   ps_emergency_abort_set_message("ALSA cleanup complete.");
 }
 
@@ -150,14 +276,25 @@ int ps_alsa_unlock() {
   return 0;
 }
 
-/* AKAU glue.
+/* Status.
  */
 
-#include "akau/akau_driver.h"
+int ps_alsa_get_status(struct akau_driver_status *status) {
+  if (!status) return -1;
+  if (!ps_alsa.alsa) return -1;
+  status->period=__atomic_load_n(&ps_alsa.status.period,__ATOMIC_RELAXED);
+  status->latency_us=__atomic_load_n(&ps_alsa.status.latency_us,__ATOMIC_RELAXED);
+  status->xrunc=__atomic_load_n(&ps_alsa.status.xrunc,__ATOMIC_RELAXED);
+  return 0;
+}
+
+/* AKAU glue.
+ */
 
 const struct akau_driver akau_driver_alsa={
   .init=ps_alsa_init,
   .quit=ps_alsa_quit,
   .lock=ps_alsa_lock,
   .unlock=ps_alsa_unlock,
+  .get_status=ps_alsa_get_status,
 };
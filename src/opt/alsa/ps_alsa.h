@@ -1,6 +1,6 @@
 /* ps_alsa.h
  * Shallow interface to ALSA.
- * Provides an I/O thread that hits your callback with a buffer ready for delivery.
+ * Provides an I/O thread that hits your callback with one period at a time, ready for delivery.
  * And that's all.
  */
 
@@ -9,9 +9,22 @@
 
 #include <stdint.h>
 
+struct akau_driver_status;
+
+/* Call before init. See akau_period.h.
+ * (period) is the starting size in frames, or zero for the default.
+ */
+int ps_alsa_set_period(int low_latency,int period);
+
 int ps_alsa_init(const char *device,int rate,int chanc,void (*cb)(int16_t *dst,int dstc));
 void ps_alsa_quit();
 int ps_alsa_lock();
 int ps_alsa_unlock();
+int ps_alsa_get_status(struct akau_driver_status *status);
+
+/* For testing: Fail the next write as if the device had run dry, and recover the usual way.
+ * The "null" device never underruns on its own.
+ */
+int ps_alsa_simulate_xrun();
 
 #endif
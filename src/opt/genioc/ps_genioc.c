@@ -41,12 +41,15 @@ static void ps_genioc_print_help(const char *exename) {
     "  --highscores=PATH     Location of high scores file (highscores).\n"
     "  --fullscreen=BOOL     Start in fullscreen mode if supported.\n"
     "  --soft-render=BOOL    Use software rendering if supported.\n"
+    "  --video-vbo=BOOL      OpenGL only. Stream vertices through a buffer object.\n"
     "  --video-device=PATH   DRM only.\n"
     "  --music=INT           0..255, background music volume.\n"
     "  --sound=INT           0..255, sound effects volume.\n"
     "  --audio-device=NAME   ALSA only.\n"
     "  --audio-rate=HZ\n"
     "  --audio-chanc=1..8\n"
+    "  --audio-low-latency=BOOL ALSA only. Small period, grows on underrun.\n"
+    "  --audio-period=FRAMES ALSA only. Starting period size, 0 for default.\n"
     "  --reopen-tty=PATH     (debug) Reopen standard streams.\n"
     "  --chdir=PATH          (debug) Change directory before loading.\n"
     "  --log.DOMAIN=LEVEL    Set a log level (TRACE,DEBUG,INFO,WARN,ERROR).\n"
@@ -125,6 +125,7 @@ int ps_userconfig_declare_default_fields(struct ps_userconfig *userconfig) {
   PATH("highscores","")
   BOOLEAN("fullscreen",1)
   BOOLEAN("soft-render",0)
+  BOOLEAN("video-vbo",0)
   INTEGER("music",127,0,255)
   INTEGER("sound",255,0,255)
   BOOLEAN("kiosk",0)
@@ -133,6 +134,8 @@ int ps_userconfig_declare_default_fields(struct ps_userconfig *userconfig) {
   PATH("audio-device","")
   INTEGER("audio-rate",44100,200,200000)
   INTEGER("audio-chanc",2,1,8)
+  BOOLEAN("audio-low-latency",0)
+  INTEGER("audio-period",0,0,8192)
 
   #undef BOOLEAN
   #undef INTEGER
@@ -27,6 +27,7 @@ int ps_userconfig_ref(struct ps_userconfig *userconfig);
  *   PATH highscores = ""
  *   BOOLEAN fullscreen = 1
  *   BOOLEAN soft-render = 0
+ *   BOOLEAN video-vbo = 0 # stream vertices through a buffer object (GL only)
  *   INTEGER music = 255
  *   INTEGER sound = 255
  *   BOOLEAN kiosk = 0 # don't allow quit or fullscreen toggle
@@ -35,6 +36,8 @@ int ps_userconfig_ref(struct ps_userconfig *userconfig);
  *   PATH audio-device = ""
  *   INTEGER audio-rate = 44100
  *   INTEGER audio-chanc = 2
+ *   BOOLEAN audio-low-latency = 0 # small hardware period, adapts to underruns
+ *   INTEGER audio-period = 0 # starting period in frames, 0 for default
  *
  * Other global command-line options which are not actually userconfig:
  *   PATH reopen-tty = ""
@@ -0,0 +1,240 @@
+#include "ps_res_internal.h"
+#include "os/ps_clockassist.h"
+#include <pthread.h>
+#include <unistd.h>
+
+/* Cleanup.
+ */
+
+static void ps_res_job_cleanup(struct ps_res_job *job) {
+  if (job->src) free(job->src);
+  if (job->refpath) free(job->refpath);
+  if (job->obj&&job->type->del) job->type->del(job->obj);
+}
+
+void ps_res_batch_cleanup(struct ps_res_batch *batch) {
+  if (!batch) return;
+  if (batch->jobv) {
+    while (batch->jobc-->0) ps_res_job_cleanup(batch->jobv+batch->jobc);
+    free(batch->jobv);
+  }
+  memset(batch,0,sizeof(struct ps_res_batch));
+}
+
+/* Add job.
+ */
+
+static struct ps_res_job *ps_res_batch_add_job(struct ps_res_batch *batch,struct ps_restype *type,int rid) {
+  if (!batch||!type||!type->decode) return 0;
+  if (batch->jobc>=batch->joba) {
+    int na=batch->joba+128;
+    if (na>INT_MAX/sizeof(struct ps_res_job)) return 0;
+    void *nv=realloc(batch->jobv,sizeof(struct ps_res_job)*na);
+    if (!nv) return 0;
+    batch->jobv=nv;
+    batch->joba=na;
+  }
+  struct ps_res_job *job=batch->jobv+batch->jobc++;
+  memset(job,0,sizeof(struct ps_res_job));
+  job->type=type;
+  job->rid=rid;
+  return job;
+}
+
+int ps_res_batch_add(struct ps_res_batch *batch,struct ps_restype *type,int rid,void *src_HANDOFF,int srcc,const char *refpath) {
+  if ((srcc<0)||(srcc&&!src_HANDOFF)) return -1;
+  if (!refpath) refpath="<unknown>";
+  struct ps_res_job *job=ps_res_batch_add_job(batch,type,rid);
+  if (!job) return -1;
+  if (!(job->refpath=strdup(refpath))) {
+    batch->jobc--;
+    return -1;
+  }
+  job->src=src_HANDOFF;
+  job->srcc=srcc;
+  return 0;
+}
+
+int ps_res_batch_add_pending(struct ps_res_batch *batch,struct ps_restype *type,int rid,const uint8_t *entry) {
+  if (!entry) return -1;
+  struct ps_res_job *job=ps_res_batch_add_job(batch,type,rid);
+  if (!job) return -1;
+  job->entry=entry;
+  return 0;
+}
+
+/* Decode one job, on any thread.
+ */
+
+static void ps_res_batch_decode_job(struct ps_res_job *job) {
+  int64_t starttime=ps_time_now();
+  const struct ps_restype *type=job->type;
+  if (job->entry) {
+    job->result=ps_resmgr_decode_pending(&job->obj,type,job->rid,job->entry);
+  } else if (type->decode(&job->obj,job->src,job->srcc,job->rid,job->refpath)<0) {
+    ps_log(RES,ERROR,"%s: Failed to decode resource %s:%d.",job->refpath,type->name,job->rid);
+    job->obj=0;
+    job->result=-1;
+  } else if (!job->obj) {
+    ps_log(RES,ERROR,"%s: Decoder for resource %s:%d returned null.",job->refpath,type->name,job->rid);
+    job->result=-1;
+  } else {
+    job->result=0;
+  }
+  job->elapsed_us=ps_time_now()-starttime;
+}
+
+/* Worker thread.
+ * Eager jobs belong to the main thread.
+ */
+
+static void *ps_res_batch_worker(void *arg) {
+  struct ps_res_batch *batch=arg;
+  while (1) {
+    int p=__atomic_fetch_add(&batch->nextp,1,__ATOMIC_RELAXED);
+    if (p>=batch->jobc) break;
+    struct ps_res_job *job=batch->jobv+p;
+    if (job->type->eager) continue;
+    ps_res_batch_decode_job(job);
+  }
+  return 0;
+}
+
+/* Finish and store one job, on the main thread.
+ */
+
+static int ps_res_batch_store_job(struct ps_res_job *job) {
+  struct ps_restype *type=job->type;
+  if (job->result<0) return -1;
+  const char *refpath=job->refpath?job->refpath:ps_resmgr.rootpath;
+
+  if (type->finish) {
+    int64_t starttime=ps_time_now();
+    int err=type->finish(job->obj);
+    job->elapsed_us+=ps_time_now()-starttime;
+    if (err<0) {
+      ps_log(RES,ERROR,"%s: Failed to finish resource %s:%d.",refpath,type->name,job->rid);
+      return -1;
+    }
+  }
+
+  int p=ps_restype_res_search(type,job->rid);
+  if (job->entry) {
+    if ((p<0)||(type->resv[p].pending!=job->entry)) return -1;
+    type->resv[p].obj=job->obj;
+    type->resv[p].pending=0;
+    type->pendingc--;
+  } else {
+    if (p>=0) {
+      ps_log(RES,ERROR,"%s: Duplicate resource %s:%d.",refpath,type->name,job->rid);
+      return -1;
+    }
+    if (ps_restype_res_insert(type,-p-1,job->rid,job->obj)<0) return -1;
+  }
+  job->obj=0;
+  return 0;
+}
+
+/* Link a pending job after everything is stored.
+ */
+
+static int ps_res_batch_link_job(struct ps_res_job *job) {
+  struct ps_restype *type=job->type;
+  if (!job->entry||!type->link) return 0;
+  int p=ps_restype_res_search(type,job->rid);
+  if ((p<0)||!type->resv[p].obj) return -1;
+  if (type->link(type->resv[p].obj)<0) {
+    ps_log(RES,ERROR,"Failed to link %s:%d.",type->name,job->rid);
+    ps_restype_res_remove(type,p);
+    return -1;
+  }
+  return 0;
+}
+
+/* Report decode time per type.
+ */
+
+static void ps_res_batch_report(const struct ps_res_batch *batch,int threadc,int64_t elapsed_us) {
+  int countv[PS_RESTYPE_COUNT]={0};
+  int64_t usv[PS_RESTYPE_COUNT]={0};
+  const struct ps_res_job *job=batch->jobv;
+  int i=batch->jobc; for (;i-->0;job++) {
+    int tid=job->type->tid;
+    if ((tid<0)||(tid>=PS_RESTYPE_COUNT)) continue;
+    countv[tid]++;
+    usv[tid]+=job->elapsed_us;
+  }
+  char msg[512];
+  int msgc=0;
+  for (i=0;i<PS_RESTYPE_COUNT;i++) {
+    if (!countv[i]) continue;
+    int err=snprintf(msg+msgc,sizeof(msg)-msgc,"%s%s %d in %d.%03d ms",
+      msgc?", ":"",ps_resmgr.typev[i].name,countv[i],(int)(usv[i]/1000),(int)(usv[i]%1000)
+    );
+    if ((err<0)||(msgc+err>=sizeof(msg))) break;
+    msgc+=err;
+  }
+  ps_log(RES,INFO,"Decoded %d resources on %d thread%s in %d.%03d ms: %.*s",
+    batch->jobc,threadc,(threadc==1)?"":"s",(int)(elapsed_us/1000),(int)(elapsed_us%1000),msgc,msg
+  );
+}
+
+/* Run, main entry point.
+ */
+
+int ps_res_batch_run(struct ps_res_batch *batch,int link) {
+  if (!batch) return -1;
+  if (batch->jobc<1) return 0;
+  int64_t starttime=ps_time_now();
+
+  int threadc=ps_resmgr_get_decode_thread_count();
+  if (threadc<1) {
+    threadc=sysconf(_SC_NPROCESSORS_ONLN);
+    if (threadc<1) threadc=1;
+  }
+  if (threadc>PS_RES_BATCH_THREAD_LIMIT) threadc=PS_RES_BATCH_THREAD_LIMIT;
+  int i,parallelc=0;
+  for (i=0;i<batch->jobc;i++) if (!batch->jobv[i].type->eager) parallelc++;
+  if (threadc>parallelc) threadc=parallelc;
+
+  /* Start the workers, then do the eager ones here in order, then join the workers.
+   * The calling thread is one of the workers.
+   */
+  batch->nextp=0;
+  pthread_t threadv[PS_RES_BATCH_THREAD_LIMIT];
+  int spawnc=0;
+  for (i=1;i<threadc;i++) {
+    if (pthread_create(threadv+spawnc,0,ps_res_batch_worker,batch)) {
+      ps_log(RES,WARN,"Failed to create decoder thread. Proceeding with %d.",spawnc+1);
+      break;
+    }
+    spawnc++;
+  }
+  struct ps_res_job *job=batch->jobv;
+  for (i=batch->jobc;i-->0;job++) {
+    if (job->type->eager) ps_res_batch_decode_job(job);
+  }
+  ps_res_batch_worker(batch);
+  for (i=0;i<spawnc;i++) pthread_join(threadv[i],0);
+
+  /* Store in order. Everything that succeeds is stored, even if something else failed. */
+  int result=0;
+  for (i=0,job=batch->jobv;i<batch->jobc;i++,job++) {
+    if (ps_res_batch_store_job(job)<0) {
+      result=job->result=-1;
+      if (job->entry) {
+        int p=ps_restype_res_search(job->type,job->rid);
+        if ((p>=0)&&(job->type->resv[p].pending==job->entry)) ps_restype_res_remove(job->type,p);
+      }
+    }
+  }
+  if (link) {
+    for (i=0,job=batch->jobv;i<batch->jobc;i++,job++) {
+      if (job->result<0) continue;
+      if (ps_res_batch_link_job(job)<0) result=-1;
+    }
+  }
+
+  ps_res_batch_report(batch,spawnc+1,ps_time_now()-starttime);
+  return result;
+}
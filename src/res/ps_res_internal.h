@@ -14,6 +14,57 @@ extern struct ps_resmgr {
 
   struct ps_restype typev[PS_RESTYPE_COUNT];
 
+  // Indexed archive, if that's what we loaded. Pending resources point into it.
+  uint8_t *archive;
+  int archivec;
+  int archive_mapped; // Nonzero if (archive) is mmap'd, otherwise it's from malloc.
+
 } ps_resmgr;
 
+/* Decode the resource described by an indexed archive TOC entry, without linking.
+ */
+int ps_resmgr_decode_pending(void *objpp,const struct ps_restype *type,int rid,const uint8_t *entry);
+
+void ps_resmgr_drop_archive();
+
+/* Decode stage: Many resources at once, across a pool of threads.
+ * Workers inflate and decode. Eager types decode on the main thread, in order, since their decoders have side effects.
+ * Afterward the main thread finishes each (eg texture upload) and stores it, in the order they were added.
+ * So the result is exactly what decoding them one at a time would produce.
+ */
+
+#define PS_RES_BATCH_THREAD_LIMIT 16
+
+struct ps_res_job {
+  struct ps_restype *type; // WEAK
+  int rid;
+  void *src; // STRONG, serialized resource...
+  int srcc;
+  const uint8_t *entry; // ...or TOC entry in the mapped indexed archive, for a resource already pending.
+  char *refpath; // STRONG
+  void *obj; // STRONG until stored.
+  int result;
+  int64_t elapsed_us;
+};
+
+struct ps_res_batch {
+  struct ps_res_job *jobv;
+  int jobc,joba;
+  int nextp;
+};
+
+void ps_res_batch_cleanup(struct ps_res_batch *batch);
+
+int ps_res_batch_add(struct ps_res_batch *batch,struct ps_restype *type,int rid,void *src_HANDOFF,int srcc,const char *refpath);
+int ps_res_batch_add_pending(struct ps_res_batch *batch,struct ps_restype *type,int rid,const uint8_t *entry);
+
+/* Decode and store everything.
+ * New resources are inserted; it's an error if the ID is already in use.
+ * Pending ones replace their placeholder, or are removed if they fail, like ps_restype_require().
+ * (link) nonzero to link pending ones once everything is stored. Otherwise caller links later.
+ * Everything that succeeds is stored, and we return <0 if anything failed.
+ * Logs the decode time per type at INFO.
+ */
+int ps_res_batch_run(struct ps_res_batch *batch,int link);
+
 #endif
@@ -7,14 +7,18 @@
 #include <dirent.h>
 #include <errno.h>
 #include <sys/stat.h>
+#include <zlib.h>
+#if PS_ARCH!=PS_ARCH_mswin
+  #include <sys/mman.h>
+#endif
 
-static int ps_resmgr_load_file(const char *path);
+static int ps_resmgr_load_file(struct ps_res_batch *batch,const char *path);
 
-/* Load one resource from a file.
+/* Read one resource from a file, to decode with the rest of the batch.
  * Type and ID are already known from the file's name.
  */
 
-static int ps_resmgr_load_single_file(const char *path,struct ps_restype *type,int rid) {
+static int ps_resmgr_load_single_file(struct ps_res_batch *batch,const char *path,struct ps_restype *type,int rid) {
   ps_log(RES,DEBUG,"Loading resource '%s:%d' from file '%s'...",type->name,rid,path);
 
   void *src=0;
@@ -24,13 +28,11 @@ static int ps_resmgr_load_single_file(const char *path,struct ps_restype *type,i
     return -1;
   }
 
-  if (ps_restype_decode(type,rid,src,srcc,path)<0) {
-    //ps_log(RES,ERROR,"%s: Failed to decode resource.",path); // Logged better by restype
+  if (ps_res_batch_add(batch,type,rid,src,srcc,path)<0) {
     free(src);
     return -1;
   }
   
-  free(src);
   return 0;
 }
 
@@ -57,7 +59,7 @@ static int ps_resmgr_id_from_basename(const char *src,int srcc) {
  * Each file must begin with a decimal integer, that is the resource ID.
  */
 
-static int ps_resmgr_load_typed_directory(const char *path,struct ps_restype *type) {
+static int ps_resmgr_load_typed_directory(struct ps_res_batch *batch,const char *path,struct ps_restype *type) {
   ps_log(RES,DEBUG,"Loading '%s' resources from directory '%s'...",type->name,path);
 
   char subpath[1024];
@@ -92,7 +94,7 @@ static int ps_resmgr_load_typed_directory(const char *path,struct ps_restype *ty
     }
     memcpy(subpath+pathc,base,basec+1);
 
-    if (ps_resmgr_load_single_file(subpath,type,rid)<0) {
+    if (ps_resmgr_load_single_file(batch,subpath,type,rid)<0) {
       closedir(dir);
       return -1;
     }
@@ -106,7 +108,7 @@ static int ps_resmgr_load_typed_directory(const char *path,struct ps_restype *ty
  * Contents of this directory are directories corresponding to one restype.
  */
 
-static int ps_resmgr_load_directory(const char *path) {
+static int ps_resmgr_load_directory(struct ps_res_batch *batch,const char *path) {
   ps_log(RES,DEBUG,"Loading resources from directory '%s'...",path);
 
   char subpath[1024];
@@ -142,7 +144,7 @@ static int ps_resmgr_load_directory(const char *path) {
     }
     memcpy(subpath+pathc,base,basec+1);
 
-    if (ps_resmgr_load_typed_directory(subpath,type)<0) {
+    if (ps_resmgr_load_typed_directory(batch,subpath,type)<0) {
       closedir(dir);
       return -1;
     }
@@ -176,15 +178,29 @@ int ps_resmgr_reload() {
   }
 
   if (ps_resmgr_clear()<0) return -1;
+  ps_resmgr_drop_archive();
 
+  /* Gather serialized resources, then decode them all at once.
+   * Indexed archives only gather the eager types; everything else stays pending.
+   */
+  struct ps_res_batch batch={0};
   if (S_ISDIR(st.st_mode)) {
-    if (ps_resmgr_load_directory(ps_resmgr.rootpath)<0) return -1;
+    if (ps_resmgr_load_directory(&batch,ps_resmgr.rootpath)<0) {
+      ps_res_batch_cleanup(&batch);
+      return -1;
+    }
   } else if (S_ISREG(st.st_mode)) {
-    if (ps_resmgr_load_file(ps_resmgr.rootpath)<0) return -1;
+    if (ps_resmgr_load_file(&batch,ps_resmgr.rootpath)<0) {
+      ps_res_batch_cleanup(&batch);
+      return -1;
+    }
   } else {
     ps_log(RES,ERROR,"%.*s: Not a file or directory (mode 0%o)",ps_resmgr.rootpathc,ps_resmgr.rootpath,st.st_mode);
     return -1;
   }
+  int err=ps_res_batch_run(&batch,0);
+  ps_res_batch_cleanup(&batch);
+  if (err<0) return -1;
 
   if (ps_resmgr_link()<0) return -1;
 
@@ -273,7 +289,7 @@ int ps_res_get_path_for_resource(char *dst,int dsta,int tid,int rid,int only_if_
 /* Load resources from archive file.
  */
  
-static int ps_resmgr_load_file_inner(struct ps_zlib_file *file,const char *path,struct ps_buffer *buffer) {
+static int ps_resmgr_load_file_inner(struct ps_res_batch *batch,struct ps_zlib_file *file,const char *path) {
   
   uint8_t header[16];
   int headerc=ps_zlib_read(header,16,file);
@@ -300,13 +316,16 @@ static int ps_resmgr_load_file_inner(struct ps_zlib_file *file,const char *path,
       return -1;
     }
     
-    buffer->c=0;
-    if (ps_buffer_require(buffer,len)<0) return -1;
-    int err=ps_zlib_read(buffer->v,len,file);
-    if (err<0) return -1;
-    if (err!=len) return -1;
+    void *src=malloc(len?len:1);
+    if (!src) return -1;
+    int err=ps_zlib_read(src,len,file);
+    if ((err<0)||(err!=len)) {
+      free(src);
+      return -1;
+    }
     
-    if (ps_restype_decode(restype,rid,buffer->v,len,path)<0) {
+    if (ps_res_batch_add(batch,restype,rid,src,len,path)<0) {
+      free(src);
       return -1;
     }
     
@@ -314,16 +333,191 @@ static int ps_resmgr_load_file_inner(struct ps_zlib_file *file,const char *path,
   return 0;
 }
 
-static int ps_resmgr_load_file(const char *path) {
+static int ps_resmgr_load_zlib_file(struct ps_res_batch *batch,const char *path) {
   struct ps_zlib_file *file=ps_zlib_open(path,0);
   if (!file) return -1;
-  struct ps_buffer buffer={0};
-  int err=ps_resmgr_load_file_inner(file,path,&buffer);
-  ps_buffer_cleanup(&buffer);
+  int err=ps_resmgr_load_file_inner(batch,file,path);
   ps_zlib_close(file);
   return err;
 }
 
+/* Map an indexed archive into memory.
+ * We keep it for as long as anything is pending.
+ */
+
+static int ps_resmgr_map_archive(const char *path) {
+  #if PS_ARCH==PS_ARCH_mswin
+    void *src=0;
+    int srcc=ps_file_read(&src,path);
+    if (srcc<0) return -1;
+    ps_resmgr.archive=src;
+    ps_resmgr.archivec=srcc;
+    ps_resmgr.archive_mapped=0;
+  #else
+    int fd=open(path,O_RDONLY);
+    if (fd<0) return -1;
+    off_t flen=lseek(fd,0,SEEK_END);
+    if ((flen<16)||(flen>INT_MAX)) {
+      close(fd);
+      return -1;
+    }
+    void *src=mmap(0,flen,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if (src==MAP_FAILED) return -1;
+    ps_resmgr.archive=src;
+    ps_resmgr.archivec=flen;
+    ps_resmgr.archive_mapped=1;
+  #endif
+  return 0;
+}
+
+void ps_resmgr_drop_archive() {
+  if (!ps_resmgr.archive) return;
+  #if PS_ARCH!=PS_ARCH_mswin
+    if (ps_resmgr.archive_mapped) {
+      munmap(ps_resmgr.archive,ps_resmgr.archivec);
+    } else
+  #endif
+  free(ps_resmgr.archive);
+  ps_resmgr.archive=0;
+  ps_resmgr.archivec=0;
+  ps_resmgr.archive_mapped=0;
+}
+
+/* Fields of an indexed archive TOC entry.
+ */
+
+#define PS_RES_TOC_ENTRY_SIZE 16
+#define PS_RES_TOC_FLAG_COMPRESSED 0x01
+
+static inline int ps_res_rd32(const uint8_t *src) {
+  return (src[0]<<24)|(src[1]<<16)|(src[2]<<8)|src[3];
+}
+
+/* Decode one resource from the indexed archive.
+ */
+
+int ps_resmgr_decode_pending(void *objpp,const struct ps_restype *type,int rid,const uint8_t *entry) {
+  if (!objpp||!type||!entry||!type->decode) return -1;
+  int flags=entry[2];
+  int offset=ps_res_rd32(entry+4);
+  int storedc=ps_res_rd32(entry+8);
+  int decodedc=ps_res_rd32(entry+12);
+  const void *src=ps_resmgr.archive+offset;
+  void *inflated=0;
+
+  if (flags&PS_RES_TOC_FLAG_COMPRESSED) {
+    if (!(inflated=malloc(decodedc?decodedc:1))) return -1;
+    uLongf len=decodedc;
+    if ((uncompress(inflated,&len,src,storedc)!=Z_OK)||(len!=decodedc)) {
+      ps_log(RES,ERROR,"%s: Failed to inflate %s:%d.",ps_resmgr.rootpath,type->name,rid);
+      free(inflated);
+      return -1;
+    }
+    src=inflated;
+  }
+
+  ps_log(RES,DEBUG,"Decoding from indexed archive. tid=%d rid=%d len=%d",type->tid,rid,decodedc);
+  void *obj=0;
+  int err=type->decode(&obj,src,decodedc,rid,ps_resmgr.rootpath);
+  if (inflated) free(inflated);
+  if (err<0) {
+    ps_log(RES,ERROR,"%s: Failed to decode resource %s:%d.",ps_resmgr.rootpath,type->name,rid);
+    return -1;
+  }
+  if (!obj) {
+    ps_log(RES,ERROR,"%s: Decoder for resource %s:%d returned null.",ps_resmgr.rootpath,type->name,rid);
+    return -1;
+  }
+  *(void**)objpp=obj;
+  return 0;
+}
+
+/* Load indexed archive.
+ * Only the TOC is read here. Resources decode when first requested, except for eager types.
+ */
+
+static int ps_resmgr_load_indexed_file(struct ps_res_batch *batch,const char *path) {
+  if (ps_resmgr_map_archive(path)<0) {
+    ps_log(RES,ERROR,"%s: Failed to map archive.",path);
+    return -1;
+  }
+  const uint8_t *src=ps_resmgr.archive;
+  int srcc=ps_resmgr.archivec;
+
+  int entryc=ps_res_rd32(src+8);
+  if ((entryc<0)||(entryc>(srcc-16)/PS_RES_TOC_ENTRY_SIZE)) {
+    ps_log(RES,ERROR,"%s: Invalid TOC length %d.",path,entryc);
+    return -1;
+  }
+
+  const uint8_t *entry=src+16;
+  int i=entryc; for (;i-->0;entry+=PS_RES_TOC_ENTRY_SIZE) {
+    int tid=entry[0]>>4;
+    int rid=((entry[0]&0x0f)<<8)|entry[1];
+    int offset=ps_res_rd32(entry+4);
+    int storedc=ps_res_rd32(entry+8);
+    int decodedc=ps_res_rd32(entry+12);
+    if ((offset<0)||(storedc<0)||(decodedc<0)||(offset>srcc-storedc)) {
+      ps_log(RES,ERROR,"%s: Invalid TOC entry for tid=%d rid=%d",path,tid,rid);
+      return -1;
+    }
+    if (!(entry[2]&PS_RES_TOC_FLAG_COMPRESSED)&&(storedc!=decodedc)) {
+      ps_log(RES,ERROR,"%s: Invalid TOC entry for tid=%d rid=%d",path,tid,rid);
+      return -1;
+    }
+
+    if (tid>=PS_RESTYPE_COUNT) {
+      ps_log(RES,ERROR,"%s: Invalid resource type ID %d",path,tid);
+      return -1;
+    }
+    struct ps_restype *restype=ps_resmgr.typev+tid;
+    int p=ps_restype_res_search(restype,rid);
+    if (p>=0) {
+      ps_log(RES,ERROR,"%s: Duplicate resource %s:%d.",path,restype->name,rid);
+      return -1;
+    }
+    if (ps_restype_res_insert_pending(restype,-p-1,rid,entry)<0) return -1;
+  }
+
+  /* Eager types decode with the batch, and link along with everything else.
+   */
+  struct ps_restype *restype=ps_resmgr.typev;
+  for (i=PS_RESTYPE_COUNT;i-->0;restype++) {
+    if (!restype->eager) continue;
+    const struct ps_res *res=restype->resv;
+    int resp=0; for (;resp<restype->resc;resp++,res++) {
+      if (!res->pending) continue;
+      if (ps_res_batch_add_pending(batch,restype,res->id,res->pending)<0) return -1;
+    }
+  }
+
+  ps_log(RES,DEBUG,"%s: Indexed %d resources.",path,entryc);
+  return 0;
+}
+
+/* Load archive, either format.
+ */
+
+static int ps_resmgr_load_file(struct ps_res_batch *batch,const char *path) {
+  uint8_t signature[8]={0};
+  #ifdef O_BINARY
+    int fd=open(path,O_RDONLY|O_BINARY);
+  #else
+    int fd=open(path,O_RDONLY);
+  #endif
+  if (fd<0) {
+    ps_log(RES,ERROR,"%s: %s",path,strerror(errno));
+    return -1;
+  }
+  int signaturec=read(fd,signature,sizeof(signature));
+  close(fd);
+  if ((signaturec==sizeof(signature))&&!memcmp(signature,"\0PLSQ\xffRI",8)) {
+    return ps_resmgr_load_indexed_file(batch,path);
+  }
+  return ps_resmgr_load_zlib_file(batch,path);
+}
+
 /* Encode resource for archive export.
  */
  
@@ -373,6 +567,17 @@ static int ps_res_export_resource(struct ps_zlib_file *file,const struct ps_rest
   return 0;
 }
 
+/* Decode anything pending, before export.
+ */
+
+static int ps_res_require_all_types() {
+  struct ps_restype *restype=ps_resmgr.typev;
+  int i=PS_RESTYPE_COUNT; for (;i-->0;restype++) {
+    if (ps_restype_require_all(restype)<0) return -1;
+  }
+  return 0;
+}
+
 /* Export archive into open file.
  * (path) is for reference only.
  */
@@ -411,6 +616,7 @@ static int ps_res_export_archive_to_zlib_file(struct ps_zlib_file *file,const ch
 int ps_res_export_archive(const char *path) {
   if (!ps_resmgr.init) return -1;
   if (!path||!path[0]) return -1;
+  if (ps_res_require_all_types()<0) return -1;
   
   struct ps_zlib_file *file=ps_zlib_open(path,1);
   if (!file) {
@@ -429,3 +635,109 @@ int ps_res_export_archive(const char *path) {
   ps_log(RES,INFO,"%s: Exported resource archive.",path);
   return 0;
 }
+
+/* Append one resource to an indexed archive under construction.
+ * We fill in the TOC entry at (toc), and append the body to (archive).
+ * Bodies are compressed unless that saves less than an eighth.
+ */
+
+static int ps_res_export_indexed_resource(
+  uint8_t *toc,struct ps_buffer *archive,
+  const struct ps_restype *restype,const struct ps_res *res,
+  struct ps_buffer *buffer
+) {
+  if (res->id>0xfff) {
+    ps_log(RES,ERROR,"%s:%d: ID too large for archive, limit 4095.",restype->name,res->id);
+    return -1;
+  }
+
+  buffer->c=0;
+  while (1) {
+    int err=ps_res_encode(buffer->v,buffer->a,restype,res->obj);
+    if (err<0) return -1;
+    if (err<=buffer->a) {
+      buffer->c=err;
+      break;
+    }
+    if (ps_buffer_require(buffer,err)<0) return -1;
+  }
+
+  int offset=archive->c;
+  int flags=0;
+  if (ps_buffer_compress_and_append(archive,buffer->v,buffer->c)<0) return -1;
+  if (archive->c-offset>buffer->c-(buffer->c>>3)) {
+    archive->c=offset;
+    if (ps_buffer_append(archive,buffer->v,buffer->c)<0) return -1;
+  } else {
+    flags|=PS_RES_TOC_FLAG_COMPRESSED;
+  }
+  int storedc=archive->c-offset;
+
+  ps_log(RES,DEBUG,
+    "Encoding to indexed archive. tid=%d rid=%d len=%d stored=%d",
+    restype->tid,res->id,buffer->c,storedc
+  );
+
+  toc[0]=(restype->tid<<4)|(res->id>>8);
+  toc[1]=res->id;
+  toc[2]=flags;
+  toc[3]=0;
+  toc[4]=offset>>24; toc[5]=offset>>16; toc[6]=offset>>8; toc[7]=offset;
+  toc[8]=storedc>>24; toc[9]=storedc>>16; toc[10]=storedc>>8; toc[11]=storedc;
+  toc[12]=buffer->c>>24; toc[13]=buffer->c>>16; toc[14]=buffer->c>>8; toc[15]=buffer->c;
+  return 0;
+}
+
+/* Export indexed archive.
+ */
+
+int ps_res_export_indexed_archive(const char *path) {
+  if (!ps_resmgr.init) return -1;
+  if (!path||!path[0]) return -1;
+  if (ps_res_require_all_types()<0) return -1;
+
+  int entryc=0,i;
+  for (i=0;i<PS_RESTYPE_COUNT;i++) entryc+=ps_resmgr.typev[i].resc;
+
+  /* Header and TOC go first in (archive), and bodies are appended after.
+   * Leave the TOC zeroed until each body's offset is known.
+   */
+  struct ps_buffer archive={0};
+  struct ps_buffer buffer={0};
+  int tocsize=16+entryc*PS_RES_TOC_ENTRY_SIZE;
+  if (ps_buffer_require(&archive,tocsize)<0) return -1;
+  memset(archive.v,0,tocsize);
+  memcpy(archive.v,"\0PLSQ\xffRI",8);
+  archive.v[8]=entryc>>24;
+  archive.v[9]=entryc>>16;
+  archive.v[10]=entryc>>8;
+  archive.v[11]=entryc;
+  archive.c=tocsize;
+
+  int tocp=16;
+  const struct ps_restype *restype=ps_resmgr.typev;
+  int tid=0; for (;tid<PS_RESTYPE_COUNT;tid++,restype++) {
+    const struct ps_res *res=restype->resv;
+    int resp=restype->resc; for (;resp-->0;res++,tocp+=PS_RES_TOC_ENTRY_SIZE) {
+      // (archive) may move as it grows, so fill the entry aside and copy it in after.
+      uint8_t toc[PS_RES_TOC_ENTRY_SIZE];
+      if (ps_res_export_indexed_resource(toc,&archive,restype,res,&buffer)<0) {
+        ps_log(RES,ERROR,"%s: Failed to export %s:%d",path,restype->name,res->id);
+        ps_buffer_cleanup(&archive);
+        ps_buffer_cleanup(&buffer);
+        return -1;
+      }
+      memcpy(archive.v+tocp,toc,PS_RES_TOC_ENTRY_SIZE);
+    }
+  }
+  ps_buffer_cleanup(&buffer);
+
+  if (ps_file_write(path,archive.v,archive.c)<0) {
+    ps_log(RES,ERROR,"%s: Failed to write file.",path);
+    ps_buffer_cleanup(&archive);
+    return -1;
+  }
+  ps_log(RES,INFO,"%s: Exported indexed resource archive, %d resources in %d bytes.",path,entryc,archive.c);
+  ps_buffer_cleanup(&archive);
+  return 0;
+}
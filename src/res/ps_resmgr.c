@@ -2,6 +2,9 @@
 
 struct ps_resmgr ps_resmgr={0};
 
+// Outside (ps_resmgr) because it must survive init.
+static int ps_resmgr_decode_threadc=0;
+
 /* Init.
  */
 
@@ -53,6 +56,8 @@ void ps_resmgr_quit() {
   int i;
 
   for (i=0;i<PS_RESTYPE_COUNT;i++) ps_restype_cleanup(ps_resmgr.typev+i);
+
+  ps_resmgr_drop_archive();
   
   if (ps_resmgr.rootpath) free(ps_resmgr.rootpath);
   
@@ -73,13 +78,16 @@ int ps_resmgr_clear() {
 }
 
 /* Get type by ID or name.
+ * Whoever asks for the type may read every resource in it, so decode anything pending.
  */
  
 struct ps_restype *ps_resmgr_get_type_by_id(int tid) {
   if (!ps_resmgr.init) return 0;
   if (tid<0) return 0;
   if (tid>=PS_RESTYPE_COUNT) return 0;
-  return ps_resmgr.typev+tid;
+  struct ps_restype *type=ps_resmgr.typev+tid;
+  if (type->pendingc) ps_restype_require_all(type);
+  return type;
 }
  
 struct ps_restype *ps_resmgr_get_type_by_name(const char *name,int namec) {
@@ -96,7 +104,44 @@ struct ps_restype *ps_resmgr_get_type_by_name(const char *name,int namec) {
   return 0;
 }
 
+/* Decode thread count.
+ */
+
+void ps_resmgr_set_decode_thread_count(int threadc) {
+  if (threadc<0) threadc=0;
+  ps_resmgr_decode_threadc=threadc;
+}
+
+int ps_resmgr_get_decode_thread_count() {
+  return ps_resmgr_decode_threadc;
+}
+
+/* Decode everything pending.
+ * Failures are logged and removed, same as doing them one at a time; that's not an error here.
+ */
+
+int ps_resmgr_require_all() {
+  if (!ps_resmgr.init) return -1;
+  struct ps_res_batch batch={0};
+  int i=0; for (;i<PS_RESTYPE_COUNT;i++) {
+    struct ps_restype *type=ps_resmgr.typev+i;
+    if (!type->pendingc) continue;
+    const struct ps_res *res=type->resv;
+    int resp=type->resc; for (;resp-->0;res++) {
+      if (!res->pending) continue;
+      if (ps_res_batch_add_pending(&batch,type,res->id,res->pending)<0) {
+        ps_res_batch_cleanup(&batch);
+        return -1;
+      }
+    }
+  }
+  ps_res_batch_run(&batch,1);
+  ps_res_batch_cleanup(&batch);
+  return 0;
+}
+
 /* Get resource by type and ID.
+ * From an indexed archive, this is where resources get decoded.
  */
  
 void *ps_res_get(int tid,int rid) {
@@ -104,6 +149,9 @@ void *ps_res_get(int tid,int rid) {
   struct ps_restype *type=ps_resmgr.typev+tid;
   int p=ps_restype_res_search(type,rid);
   if (p<0) return 0;
+  if (type->resv[p].pending) {
+    if (ps_restype_require(type,p)<0) return 0;
+  }
   return type->resv[p].obj;
 }
 
@@ -130,8 +178,13 @@ int ps_res_replace(int tid,int rid,void *obj) {
   int p=ps_restype_res_search(restype,rid);
   if (p>=0) {
     if (!restype->del) return -1;
-    restype->del(restype->resv[p].obj);
-    restype->resv[p].obj=obj;
+    struct ps_res *res=restype->resv+p;
+    if (res->obj) restype->del(res->obj);
+    if (res->pending) {
+      res->pending=0;
+      restype->pendingc--;
+    }
+    res->obj=obj;
   } else {
     p=-p-1;
     if (ps_restype_res_insert(restype,p,rid,obj)<0) return -1;
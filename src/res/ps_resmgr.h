@@ -16,6 +16,12 @@ int ps_resmgr_reload();
 
 int ps_resmgr_clear();
 
+/* How many threads decode resources at load.
+ * Zero, the default, means one per core. Takes effect at the next load.
+ */
+void ps_resmgr_set_decode_thread_count(int threadc);
+int ps_resmgr_get_decode_thread_count();
+
 #define PS_RESTYPE_TILESHEET      0
 #define PS_RESTYPE_IMAGE          1
 #define PS_RESTYPE_BLUEPRINT      2
@@ -33,6 +39,13 @@ struct ps_restype *ps_resmgr_get_type_by_name(const char *name,int namec);
 
 void *ps_res_get(int tid,int rid);
 
+/* Decode everything still pending from an indexed archive.
+ * Lookups only modify the manager when they decode something, so after this,
+ * ps_resmgr_get_type_by_id(), ps_res_get(), and ps_res_get_id_by_obj() are safe from any number of threads at once.
+ * Anything that edits resources (reload, replace, clear) is not, of course.
+ */
+int ps_resmgr_require_all();
+
 // Reverse lookup.
 int ps_res_get_id_by_obj(int tid,const void *obj);
 
@@ -50,11 +63,14 @@ int ps_res_get_path_for_resource(char *dst,int dsta,int tid,int rid,int only_if_
 /* Take all resources and bundle them into a compressed archive.
  * You can open archives just like directories (but can't edit from them).
  * See below for format.
+ * The indexed format is faster to open: We map it and decode each resource the first time it's asked for.
+ * Asking for a whole type (ps_resmgr_get_type_by_id) decodes everything in it.
  */
 int ps_res_export_archive(const char *path);
+int ps_res_export_indexed_archive(const char *path);
 
 /*------------------------------------------------------------------------
- * ARCHIVE FORMAT
+ * ARCHIVE FORMAT (ZLIB)
  *
  * File is a single zlib stream.
  *
@@ -72,6 +88,29 @@ int ps_res_export_archive(const char *path);
  *   0005
  *
  *------------------------------------------------------------------------
+ * ARCHIVE FORMAT (INDEXED)
+ *
+ * File is not compressed as a whole. All integers are big-endian.
+ *
+ * Header:
+ *   0000   8 Signature: "\0PLSQ\xffRI"
+ *   0008   4 Entry count
+ *   000c   4 Reserved
+ *   0010
+ *
+ * Table of contents follows immediately, one entry per resource:
+ *   0000   2 Identifier, as in the zlib format.
+ *   0002   1 Flags:
+ *              01 Compressed: Body is a zlib stream.
+ *   0003   1 Reserved
+ *   0004   4 Offset of body from start of file.
+ *   0008   4 Stored length.
+ *   000c   4 Uncompressed length. Same as stored length if not compressed.
+ *   0010
+ *
+ * Bodies follow the TOC.
+ *
+ *------------------------------------------------------------------------
  */
 
 #endif
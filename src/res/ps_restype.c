@@ -35,6 +35,7 @@ int ps_restype_clear(struct ps_restype *type) {
 
   type->resc=0;
   type->rescontigc=0;
+  type->pendingc=0;
   
   return 0;
 }
@@ -64,6 +65,11 @@ int ps_restype_decode(struct ps_restype *type,int rid,const void *src,int srcc,c
     ps_log(RES,ERROR,"%s: Decoder for resource %s:%d returned null.",refpath,type->name,rid);
     return -1;
   }
+  if (type->finish&&(type->finish(obj)<0)) {
+    ps_log(RES,ERROR,"%s: Failed to finish resource %s:%d.",refpath,type->name,rid);
+    if (type->del) type->del(obj);
+    return -1;
+  }
 
   if (ps_restype_res_insert(type,p,rid,obj)<0) {
     if (type->del) type->del(obj);
@@ -104,7 +110,7 @@ int ps_restype_index_by_object(const struct ps_restype *type,const void *obj) {
 /* Insert resource.
  */
 
-int ps_restype_res_insert(struct ps_restype *type,int p,int id,void *obj_HANDOFF) {
+static int ps_restype_res_insert_1(struct ps_restype *type,int p,int id,void *obj_HANDOFF,const uint8_t *pending) {
   if (!type) return -1;
   if ((p<0)||(p>type->resc)) {
     ps_log(RES,ERROR,"%s ID must be in 0..%d (found %d).",type->name,type->rid_limit,id);
@@ -113,7 +119,7 @@ int ps_restype_res_insert(struct ps_restype *type,int p,int id,void *obj_HANDOFF
   if (id>type->rid_limit) return -1;
   if (p&&(id<=type->resv[p-1].id)) return -1;
   if ((p<type->resc)&&(id>=type->resv[p].id)) return -1;
-  if (!obj_HANDOFF) return -1;
+  if (!obj_HANDOFF&&!pending) return -1;
 
   if (type->resc>=type->resa) {
     int na=type->resa+32;
@@ -131,12 +137,82 @@ int ps_restype_res_insert(struct ps_restype *type,int p,int id,void *obj_HANDOFF
   res->id=id;
   res->dirty=0;
   res->obj=obj_HANDOFF;
+  res->pending=pending;
+  if (pending) type->pendingc++;
 
   while ((type->rescontigc<type->resc)&&(type->resv[type->rescontigc].id==type->rescontigc)) type->rescontigc++;
 
   return 0;
 }
 
+int ps_restype_res_insert(struct ps_restype *type,int p,int id,void *obj_HANDOFF) {
+  return ps_restype_res_insert_1(type,p,id,obj_HANDOFF,0);
+}
+
+int ps_restype_res_insert_pending(struct ps_restype *type,int p,int id,const uint8_t *entry) {
+  if (!entry) return -1;
+  return ps_restype_res_insert_1(type,p,id,0,entry);
+}
+
+/* Remove resource.
+ */
+ 
+int ps_restype_res_remove(struct ps_restype *type,int p) {
+  if (!type) return -1;
+  if ((p<0)||(p>=type->resc)) return -1;
+  struct ps_res *res=type->resv+p;
+  if (res->obj&&type->del) type->del(res->obj);
+  if (res->pending) type->pendingc--;
+  type->resc--;
+  memmove(res,res+1,sizeof(struct ps_res)*(type->resc-p));
+  if (type->rescontigc>p) type->rescontigc=p;
+  return 0;
+}
+
+/* Decode pending resources.
+ */
+ 
+int ps_restype_require(struct ps_restype *type,int p) {
+  if (!type) return -1;
+  if ((p<0)||(p>=type->resc)) return -1;
+  struct ps_res *res=type->resv+p;
+  if (!res->pending) return res->obj?0:-1;
+  const uint8_t *entry=res->pending;
+  int rid=res->id;
+  res->pending=0;
+  type->pendingc--;
+
+  void *obj=0;
+  if (ps_resmgr_decode_pending(&obj,type,rid,entry)<0) {
+    ps_restype_res_remove(type,p);
+    return -1;
+  }
+  if (type->finish&&(type->finish(obj)<0)) {
+    ps_log(RES,ERROR,"Failed to finish %s:%d.",type->name,rid);
+    if (type->del) type->del(obj);
+    ps_restype_res_remove(type,p);
+    return -1;
+  }
+
+  // Linking may fetch other resources, but never inserts or removes any of this type.
+  type->resv[p].obj=obj;
+  if (type->link&&(type->link(obj)<0)) {
+    ps_log(RES,ERROR,"Failed to link %s:%d.",type->name,rid);
+    ps_restype_res_remove(type,p);
+    return -1;
+  }
+  return 0;
+}
+
+int ps_restype_require_all(struct ps_restype *type) {
+  if (!type) return -1;
+  int p=0; while (type->pendingc&&(p<type->resc)) {
+    if (!type->resv[p].pending) p++;
+    else if (ps_restype_require(type,p)>=0) p++;
+  }
+  return 0;
+}
+
 /* Link all resources.
  */
  
@@ -145,6 +221,7 @@ int ps_restype_link(struct ps_restype *restype) {
   if (!restype->link) return 0; // Link not necessary.
   const struct ps_res *res=restype->resv;
   int i=restype->resc; for (;i-->0;res++) {
+    if (!res->obj) continue; // Pending; links when decoded.
     if (restype->link(res->obj)<0) {
       ps_log(RES,ERROR,"Failed to link %s:%d.",restype->name,res->id);
       return -1;
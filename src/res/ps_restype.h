@@ -14,6 +14,7 @@ struct ps_res {
   int id;
   int dirty;
   void *obj;
+  const uint8_t *pending; // TOC entry in an indexed archive, if not decoded yet. (obj) is null while set.
 };
 
 struct ps_restype {
@@ -23,12 +24,19 @@ struct ps_restype {
 
   void (*del)(void *obj);
   int (*decode)(void *objpp,const void *src,int srcc,int id,const char *refpath);
+  int (*finish)(void *obj); // Optional, main thread only, after decode. eg uploading textures.
   int (*link)(void *obj);
   int (*encode)(void *dst,int dsta,const void *obj);
 
   struct ps_res *resv;
   int resc,resa;
   int rescontigc;
+  int pendingc;
+
+  // Decode everything at load, even from an indexed archive.
+  // For types whose decoder has side effects, like registering with the audio store.
+  // Eager types also decode on the main thread, in order. Everything else may decode on any thread.
+  int eager;
   
 };
 
@@ -54,6 +62,17 @@ int ps_restype_decode(struct ps_restype *type,int rid,const void *src,int srcc,c
 int ps_restype_res_search(const struct ps_restype *type,int id);
 int ps_restype_index_by_object(const struct ps_restype *type,const void *obj);
 int ps_restype_res_insert(struct ps_restype *type,int p,int id,void *obj_HANDOFF);
+int ps_restype_res_remove(struct ps_restype *type,int p);
+
+/* Add a resource to be decoded on first use, from a TOC entry in the mapped indexed archive.
+ */
+int ps_restype_res_insert_pending(struct ps_restype *type,int p,int id,const uint8_t *entry);
+
+/* Decode and link the pending resource at (p), or all of them.
+ * A resource that fails is logged and removed.
+ */
+int ps_restype_require(struct ps_restype *type,int p);
+int ps_restype_require_all(struct ps_restype *type);
 
 int ps_restype_link(struct ps_restype *restype);
 
@@ -61,8 +80,9 @@ int ps_restype_link(struct ps_restype *restype);
  *****************************************************************************/
 
 struct ps_res_TILESHEET {
-// If video is initialized before resources, only this is set:
+// If video is initialized before resources, only these are set:
   struct akgl_texture *texture;
+  int page; // Position in the video atlas, or <0 if not there.
 // If video is not initialized, these are set:
   void *pixels;
   int w,h,fmt;
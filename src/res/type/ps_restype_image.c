@@ -9,40 +9,47 @@
  */
 
 static void ps_restype_IMAGE_del(void *obj) {
+  if (!obj) return;
   akgl_texture_del(OBJ->texture);
   if (OBJ->pixels) free(OBJ->pixels);
+  free(obj);
 }
 
 /* Decode resource.
+ * Pixels only, so this can run on a worker thread.
  */
 
 static int ps_restype_IMAGE_decode(void *objpp,const void *src,int srcc,int rid,const char *refpath) {
   void *obj=calloc(1,sizeof(struct ps_res_IMAGE));
   if (!obj) return -1;
 
-  if (ps_video_is_init()) {
-    if (!(OBJ->texture=ps_image_decode(src,srcc,refpath))) {
-      ps_restype_IMAGE_del(obj);
-      free(obj);
-      return -1;
-    }
-    if (akgl_texture_set_filter(OBJ->texture,1)<0) {
-      // Whatever.
-    }
-  } else {
-    if (ps_image_decode_pixels(
-      &OBJ->pixels,&OBJ->fmt,&OBJ->w,&OBJ->h,src,srcc
-    )<0) {
-      ps_restype_IMAGE_del(obj);
-      free(obj);
-      return -1;
-    }
+  if (ps_image_decode_pixels(
+    &OBJ->pixels,&OBJ->fmt,&OBJ->w,&OBJ->h,src,srcc
+  )<0) {
+    ps_log(RES,ERROR,"%s: Failed to decode image.",refpath);
+    ps_restype_IMAGE_del(obj);
+    return -1;
   }
   
   *(void**)objpp=obj;
   return 0;
 }
 
+/* Finish resource.
+ * If video is running, trade the pixels for a texture.
+ */
+
+static int ps_restype_IMAGE_finish(void *obj) {
+  if (!ps_video_is_init()) return 0;
+  if (!(OBJ->texture=ps_image_upload_pixels(OBJ->pixels,OBJ->fmt,OBJ->w,OBJ->h))) return -1;
+  free(OBJ->pixels);
+  OBJ->pixels=0;
+  if (akgl_texture_set_filter(OBJ->texture,1)<0) {
+    // Whatever.
+  }
+  return 0;
+}
+
 /* Link resource.
  */
 
@@ -73,6 +80,7 @@ int ps_restype_setup_IMAGE(struct ps_restype *type) {
 
   type->del=ps_restype_IMAGE_del;
   type->decode=ps_restype_IMAGE_decode;
+  type->finish=ps_restype_IMAGE_finish;
   type->link=ps_restype_IMAGE_link;
   type->encode=ps_restype_IMAGE_encode;
 
@@ -83,6 +83,7 @@ int ps_restype_setup_IPCM(struct ps_restype *type) {
   type->tid=PS_RESTYPE_IPCM;
   type->name="ipcm";
   type->rid_limit=INT_MAX;
+  type->eager=1; // Decoding adds it to the audio store, which is where the mixer looks for it.
   
   if (ps_ipcm_fallback) {
     type->del=free;
@@ -91,6 +91,7 @@ int ps_restype_setup_SONG(struct ps_restype *type) {
   type->tid=PS_RESTYPE_SONG;
   type->name="song";
   type->rid_limit=INT_MAX;
+  type->eager=1; // Decoding adds it to the audio store, which is where the mixer looks for it.
   
   if (ps_song_fallback) {
     type->del=free;
@@ -9,41 +9,52 @@
  */
 
 static void ps_restype_TILESHEET_del(void *obj) {
+  if (!obj) return;
   akgl_texture_del(OBJ->texture);
+  ps_video_atlas_remove(OBJ->page);
   if (OBJ->pixels) free(OBJ->pixels);
+  free(obj);
 }
 
 /* Decode resource.
+ * Pixels only, so this can run on a worker thread.
  */
 
-static int ps_restype_TILESHEET_warned_about_stub_load=0;
-
 static int ps_restype_TILESHEET_decode(void *objpp,const void *src,int srcc,int rid,const char *refpath) {
   void *obj=calloc(1,sizeof(struct ps_res_TILESHEET));
   if (!obj) return -1;
+  OBJ->page=-1;
+  
+  if (ps_image_decode_pixels(
+    &OBJ->pixels,&OBJ->fmt,&OBJ->w,&OBJ->h,src,srcc
+  )<0) {
+    ps_log(RES,ERROR,"%s: Failed to decode image.",refpath);
+    ps_restype_TILESHEET_del(obj);
+    return -1;
+  }
   
+  *(void**)objpp=obj;
+  return 0;
+}
+
+/* Finish resource.
+ * If video is running, trade the pixels for a texture, and a page in the atlas if it fits.
+ */
+
+static int ps_restype_TILESHEET_warned_about_stub_load=0;
+
+static int ps_restype_TILESHEET_finish(void *obj) {
   if (ps_video_is_init()) {
-    if (!(OBJ->texture=ps_image_decode(src,srcc,refpath))) {
-      ps_restype_TILESHEET_del(obj);
-      free(obj);
-      return -1;
-    }
-    
+    if (!(OBJ->texture=ps_image_upload_pixels(OBJ->pixels,OBJ->fmt,OBJ->w,OBJ->h))) return -1;
+    OBJ->page=ps_video_atlas_add(OBJ->pixels,OBJ->fmt,OBJ->w,OBJ->h);
+    free(OBJ->pixels);
+    OBJ->pixels=0;
   } else {
     if (!ps_restype_TILESHEET_warned_about_stub_load) {
       ps_restype_TILESHEET_warned_about_stub_load=1;
       ps_log(RES,DEBUG,"Stubbing image decode because video provider is not initialized.");
     }
-    if (ps_image_decode_pixels(
-      &OBJ->pixels,&OBJ->fmt,&OBJ->w,&OBJ->h,src,srcc
-    )<0) {
-      ps_restype_TILESHEET_del(obj);
-      free(obj);
-      return -1;
-    }
   }
-  
-  *(void**)objpp=obj;
   return 0;
 }
 
@@ -77,6 +88,7 @@ int ps_restype_setup_TILESHEET(struct ps_restype *type) {
 
   type->del=ps_restype_TILESHEET_del;
   type->decode=ps_restype_TILESHEET_decode;
+  type->finish=ps_restype_TILESHEET_finish;
   type->link=ps_restype_TILESHEET_link;
   type->encode=ps_restype_TILESHEET_encode;
 
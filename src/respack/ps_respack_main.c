@@ -5,19 +5,27 @@
 
 /* Command-line arguments.
  * Nothing fancy here. We take two arguments, OUTPUT and INPUT.
+ * They may be preceded by "--indexed" to write the indexed format instead of one zlib stream.
  */
  
 struct ps_respack_args {
   const char *srcpath;
   const char *dstpath;
+  int indexed;
 };
 
 static int ps_respack_args_read(struct ps_respack_args *args,int argc,char **argv) {
 
+  if ((argc>=2)&&!strcmp(argv[1],"--indexed")) {
+    args->indexed=1;
+    argv++;
+    argc--;
+  }
+
   /* Verify count of arguments, and for safety's sake make sure they don't begin with a dash.
    */
   if ((argc!=3)||(argv[1][0]=='-')||(argv[2][0]=='-')) {
-    ps_log(RESPACK,ERROR,"Usage: %s OUTPUT INPUT",(argc>=1)?argv[0]:"respack");
+    ps_log(RESPACK,ERROR,"Usage: %s [--indexed] OUTPUT INPUT",(argc>=1)?argv[0]:"respack");
     return -1;
   }
   
@@ -46,7 +54,10 @@ int main(int argc,char **argv) {
     return 1;
   }
   
-  if (ps_res_export_archive(args.dstpath)<0) {
+  int err;
+  if (args.indexed) err=ps_res_export_indexed_archive(args.dstpath);
+  else err=ps_res_export_archive(args.dstpath);
+  if (err<0) {
     ps_log(RESPACK,ERROR,"Export failed.");
     return 1;
   }
@@ -22,7 +22,8 @@ struct ps_blueprint *ps_blueprint_new() {
  
 void ps_blueprint_del(struct ps_blueprint *blueprint) {
   if (!blueprint) return;
-  if (blueprint->refc-->1) return;
+  // Blueprints are shared by every scenario using them, possibly on other threads. See ps_scgen_batch.
+  if (__atomic_sub_fetch(&blueprint->refc,1,__ATOMIC_ACQ_REL)>0) return;
 
   if (blueprint->poiv) free(blueprint->poiv);
   if (blueprint->solutionv) free(blueprint->solutionv);
@@ -35,9 +36,11 @@ void ps_blueprint_del(struct ps_blueprint *blueprint) {
  
 int ps_blueprint_ref(struct ps_blueprint *blueprint) {
   if (!blueprint) return -1;
-  if (blueprint->refc<1) return -1;
-  if (blueprint->refc==INT_MAX) return -1;
-  blueprint->refc++;
+  int refc=__atomic_load_n(&blueprint->refc,__ATOMIC_RELAXED);
+  do {
+    if (refc<1) return -1;
+    if (refc==INT_MAX) return -1;
+  } while (!__atomic_compare_exchange_n(&blueprint->refc,&refc,refc+1,1,__ATOMIC_RELAXED,__ATOMIC_RELAXED));
   return 0;
 }
 
@@ -48,9 +51,9 @@ uint8_t ps_blueprint_get_cell(const struct ps_blueprint *blueprint,int x,int y,u
   if (!blueprint) return PS_BLUEPRINT_CELL_SOLID;
   if ((x<0)||(x>=PS_BLUEPRINT_COLC)) return PS_BLUEPRINT_CELL_SOLID;
   if ((y<0)||(y>=PS_BLUEPRINT_ROWC)) return PS_BLUEPRINT_CELL_SOLID;
-  if (xform&PS_BLUEPRINT_XFORM_HORZ) x=PS_GRID_COLC-x-1;
-  if (xform&PS_BLUEPRINT_XFORM_VERT) y=PS_GRID_ROWC-y-1;
-  return blueprint->cellv[y*PS_GRID_COLC+x];
+  if (xform&PS_BLUEPRINT_XFORM_HORZ) x=PS_BLUEPRINT_COLC-x-1;
+  if (xform&PS_BLUEPRINT_XFORM_VERT) y=PS_BLUEPRINT_ROWC-y-1;
+  return blueprint->cellv[y*PS_BLUEPRINT_COLC+x];
 }
 
 /* Get POIs.
@@ -65,8 +68,8 @@ int ps_blueprint_get_pois_for_cell(
   if (!blueprint) return 0;
   if ((x<0)||(y<0)||(x>=PS_BLUEPRINT_COLC)||(y>=PS_BLUEPRINT_ROWC)) return 0;
 
-  if (xform&PS_BLUEPRINT_XFORM_HORZ) x=PS_GRID_COLC-x-1;
-  if (xform&PS_BLUEPRINT_XFORM_VERT) y=PS_GRID_ROWC-y-1;
+  if (xform&PS_BLUEPRINT_XFORM_HORZ) x=PS_BLUEPRINT_COLC-x-1;
+  if (xform&PS_BLUEPRINT_XFORM_VERT) y=PS_BLUEPRINT_ROWC-y-1;
   
   int dstc=0,i=blueprint->poic;
   struct ps_blueprint_poi *poi=blueprint->poiv;
@@ -210,7 +210,7 @@ static struct ps_blueprint *ps_blueprint_chooser_choose_prime_challenge(struct p
  */
 
 static int ps_blueprint_chooser_choose_challenge(const struct ps_blueprint_chooser *chooser) {
-  int selection=rand()%chooser->challenge_weight_total;
+  int selection=ps_scgen_randint(chooser->scgen,chooser->challenge_weight_total);
   int i=chooser->challenges->c; while (i-->0) {
     selection-=chooser->challenge_weightv[i];
     if (selection<0) return i;
@@ -226,20 +226,20 @@ static struct ps_blueprint *ps_blueprint_chooser_choose_blueprint(struct ps_blue
   /* Use a random treasure blueprint if the TREASURE feature is set.
    */
   if (screen->features&PS_SCREEN_FEATURE_TREASURE) {
-    return chooser->treasures->v[rand()%chooser->treasures->c];
+    return chooser->treasures->v[ps_scgen_randint(chooser->scgen,chooser->treasures->c)];
   }
 
   /* Use a random home blueprint if the HOME feature is set.
    */
   if (screen->features&PS_SCREEN_FEATURE_HOME) {
-    return chooser->homes->v[rand()%chooser->homes->c];
+    return chooser->homes->v[ps_scgen_randint(chooser->scgen,chooser->homes->c)];
   }
 
   /* If this is a leaf node (not treasure, so it's a dead end), use filler.
    * If we don't have any filler, that's fine, skip this bit.
    */
   if ((chooser->fillers->c>0)&&(ps_screen_count_doors(screen)==1)) {
-    return chooser->fillers->v[rand()%chooser->fillers->c];
+    return chooser->fillers->v[ps_scgen_randint(chooser->scgen,chooser->fillers->c)];
   }
 
   /* If we have any challenge blueprints left, select one with weighted random.
@@ -255,7 +255,7 @@ static struct ps_blueprint *ps_blueprint_chooser_choose_blueprint(struct ps_blue
   /* No fillers? Shouldn't have been possible to reach this point.
    */
   if (chooser->fillers->c<1) return 0;
-  return chooser->fillers->v[rand()%chooser->fillers->c];
+  return chooser->fillers->v[ps_scgen_randint(chooser->scgen,chooser->fillers->c)];
 }
 
 /* Choose a transform for one screen. No errors.
@@ -266,8 +266,8 @@ static uint8_t ps_blueprint_chooser_choose_xform(const struct ps_blueprint_choos
   /* If the blueprint has no challenge, it's purely random and doesn't mean much.
    * And if some damn fool put a solution on a HOME or TREASURE blueprint, we'll ignore it.
    */
-  if (screen->blueprint->solutionc<1) return rand()&3;
-  if (screen->features&(PS_SCREEN_FEATURE_HOME|PS_SCREEN_FEATURE_TREASURE)) return rand()&3;
+  if (screen->blueprint->solutionc<1) return ps_scgen_randint(chooser->scgen,4);
+  if (screen->features&(PS_SCREEN_FEATURE_HOME|PS_SCREEN_FEATURE_TREASURE)) return ps_scgen_randint(chooser->scgen,4);
 
   int awayward=ps_screen_get_single_awayward_direction(screen);
   uint8_t alt_axis_bit=0;
@@ -299,7 +299,7 @@ static uint8_t ps_blueprint_chooser_choose_xform(const struct ps_blueprint_choos
 
   /* If (alt_axis_bit) is still set, apply it 50% of the time.
    */
-  if (alt_axis_bit&&(rand()&1)) {
+  if (alt_axis_bit&&ps_scgen_randint(chooser->scgen,2)) {
     xform|=alt_axis_bit;
   }
   
@@ -26,6 +26,7 @@ void ps_scenario_del(struct ps_scenario *scenario) {
   if (scenario->refc-->1) return;
 
   if (scenario->treasurev) free(scenario->treasurev);
+  ps_scenario_invalidate_routes(scenario);
 
   if (scenario->screenv) {
     int screenc=scenario->w*scenario->h;
@@ -117,6 +118,8 @@ int ps_scenario_reallocate_screens(struct ps_scenario *scenario,int w,int h) {
   if (w>PS_WORLD_W_LIMIT) return -1;
   if (h>PS_WORLD_H_LIMIT) return -1;
 
+  ps_scenario_invalidate_routes(scenario);
+
   struct ps_screen *nv=0;
   if (w&&h) {
     nv=calloc(sizeof(struct ps_screen),w*h);
@@ -396,6 +399,8 @@ int ps_scenario_decode(struct ps_scenario *scenario,const void *src,int srcc) {
     }
     srcp+=err;
   }
+
+  if (ps_scenario_build_routes(scenario)<0) return -1;
   
   return srcp;
 }
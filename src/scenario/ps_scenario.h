@@ -16,6 +16,7 @@ struct ps_scenario {
   struct ps_res_trdef **treasurev; // WEAK, owned by resource manager
   int w,h; // World size in screens.
   struct ps_screen *screenv;
+  uint16_t *routev; // See ps_scenario_route.c
 };
 
 struct ps_scenario *ps_scenario_new();
@@ -34,6 +35,16 @@ int ps_scenario_reallocate_screens(struct ps_scenario *scenario,int w,int h);
 // Set 'visited' of each grid to zero.
 int ps_scenario_reset_visited(struct ps_scenario *scenario);
 
+/* Shortest paths between screens, through open doors.
+ * The table is built after generating or decoding; if you change a door afterward, invalidate it.
+ * ps_scenario_get_route() rebuilds if needed, then returns the distance in screens from (src) to (dst),
+ * and the first step from (src) in (direction), or <0 if unreachable.
+ * Same screen is distance zero and direction zero.
+ */
+int ps_scenario_build_routes(struct ps_scenario *scenario);
+void ps_scenario_invalidate_routes(struct ps_scenario *scenario);
+int ps_scenario_get_route(int *direction,struct ps_scenario *scenario,int dstx,int dsty,int srcx,int srcy);
+
 /* ===== Serial format =====
  * TODO There should probably be some version control in here, for both code and data.
  * TODO We probably also need to encode the generator criteria.
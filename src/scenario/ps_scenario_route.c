@@ -0,0 +1,114 @@
+/* ps_scenario_route.c
+ * All-pairs shortest paths between screens, through open doors.
+ * One breadth-first search per destination screen, so building is O(screenc^2) and queries are O(1).
+ * Each entry is (distance<<3)|direction, where direction is the first step from the source screen.
+ */
+
+#include "ps.h"
+#include "ps_scenario.h"
+#include "ps_screen.h"
+#include "util/ps_geometry.h"
+
+#define PS_ROUTE_UNREACHABLE 0xffff
+
+/* Invalidate.
+ */
+
+void ps_scenario_invalidate_routes(struct ps_scenario *scenario) {
+  if (!scenario) return;
+  if (scenario->routev) {
+    free(scenario->routev);
+    scenario->routev=0;
+  }
+}
+
+/* Breadth-first search toward one destination, recording distances only.
+ * We walk edges backward: (u) joins the frontier when its door toward (v) is open.
+ */
+
+static void ps_scenario_route_search(uint16_t *row,int *queue,const struct ps_scenario *scenario,int dstp) {
+  int screenc=scenario->w*scenario->h;
+  int i=screenc; while (i-->0) row[i]=PS_ROUTE_UNREACHABLE;
+  row[dstp]=0;
+  queue[0]=dstp;
+  int queuep=0,queuec=1;
+  while (queuep<queuec) {
+    int v=queue[queuep++];
+    const struct ps_screen *screen=scenario->screenv+v;
+    uint16_t next=row[v]+(1<<3);
+    #define NEIGHBOR(cond,du,door) if (cond) { \
+      int u=v+(du); \
+      if ((row[u]==PS_ROUTE_UNREACHABLE)&&(scenario->screenv[u].door==PS_DOOR_OPEN)) { \
+        row[u]=next; \
+        queue[queuec++]=u; \
+      } \
+    }
+    NEIGHBOR(screen->x>0,-1,doore)
+    NEIGHBOR(screen->x<scenario->w-1,1,doorw)
+    NEIGHBOR(screen->y>0,-scenario->w,doors)
+    NEIGHBOR(screen->y<scenario->h-1,scenario->w,doorn)
+    #undef NEIGHBOR
+  }
+}
+
+/* With distances settled, pick the first step out of each screen.
+ * Ties prefer west, east, north, south, in that order.
+ */
+
+static void ps_scenario_route_directions(uint16_t *row,const struct ps_scenario *scenario) {
+  int screenc=scenario->w*scenario->h;
+  const struct ps_screen *screen=scenario->screenv;
+  int p=0; for (;p<screenc;p++,screen++) {
+    if (row[p]==PS_ROUTE_UNREACHABLE) continue;
+    if (!row[p]) continue;
+    // Neighbors may already have their direction; compare distances only.
+    int want=(row[p]>>3)-1;
+    if ((screen->doorw==PS_DOOR_OPEN)&&(screen->x>0)&&((row[p-1]>>3)==want)) row[p]|=PS_DIRECTION_WEST;
+    else if ((screen->doore==PS_DOOR_OPEN)&&(screen->x<scenario->w-1)&&((row[p+1]>>3)==want)) row[p]|=PS_DIRECTION_EAST;
+    else if ((screen->doorn==PS_DOOR_OPEN)&&(screen->y>0)&&((row[p-scenario->w]>>3)==want)) row[p]|=PS_DIRECTION_NORTH;
+    else row[p]|=PS_DIRECTION_SOUTH;
+  }
+}
+
+/* Build.
+ */
+
+int ps_scenario_build_routes(struct ps_scenario *scenario) {
+  if (!scenario) return -1;
+  ps_scenario_invalidate_routes(scenario);
+  int screenc=scenario->w*scenario->h;
+  if (screenc<1) return 0;
+
+  if (!(scenario->routev=malloc(sizeof(uint16_t)*screenc*screenc))) return -1;
+  int *queue=malloc(sizeof(int)*screenc);
+  if (!queue) {
+    ps_scenario_invalidate_routes(scenario);
+    return -1;
+  }
+
+  int dstp=0; for (;dstp<screenc;dstp++) {
+    uint16_t *row=scenario->routev+dstp*screenc;
+    ps_scenario_route_search(row,queue,scenario,dstp);
+    ps_scenario_route_directions(row,scenario);
+  }
+
+  free(queue);
+  return 0;
+}
+
+/* Query.
+ */
+
+int ps_scenario_get_route(int *direction,struct ps_scenario *scenario,int dstx,int dsty,int srcx,int srcy) {
+  if (!scenario) return -1;
+  if ((dstx<0)||(dstx>=scenario->w)||(dsty<0)||(dsty>=scenario->h)) return -1;
+  if ((srcx<0)||(srcx>=scenario->w)||(srcy<0)||(srcy>=scenario->h)) return -1;
+  if (!scenario->routev) {
+    if (ps_scenario_build_routes(scenario)<0) return -1;
+  }
+  int screenc=scenario->w*scenario->h;
+  uint16_t route=scenario->routev[(dsty*scenario->w+dstx)*screenc+srcy*scenario->w+srcx];
+  if (route==PS_ROUTE_UNREACHABLE) return -1;
+  if (direction) *direction=route&7;
+  return route>>3;
+}
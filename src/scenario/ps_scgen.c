@@ -84,6 +84,15 @@ int ps_scgen_fail(struct ps_scgen *scgen,const char *fmt,...) {
 
 #define FAIL_NULL(fmt,...) { ps_scgen_fail(scgen,fmt,##__VA_ARGS__); return 0; }
 
+/* Check for abort.
+ */
+
+int ps_scgen_check_abort(struct ps_scgen *scgen) {
+  if (!scgen->abort) return 0;
+  if (!__atomic_load_n(scgen->abort,__ATOMIC_ACQUIRE)) return 0;
+  return ps_scgen_fail(scgen,"Aborted.");
+}
+
 /* Add to screen buffer.
  */
 
@@ -115,12 +124,10 @@ static int ps_scgen_screenbuf_contains(struct ps_scgen *scgen,struct ps_screen *
 }
 
 /* Random integer.
- * We wrap each call to rand(), in case it needs to be mocked out or something.
  */
 
 int ps_scgen_randint(struct ps_scgen *scgen,int limit) {
-  if (limit<1) return 0;
-  return rand()%limit;
+  return ps_prng_int(&scgen->prng,limit);
 }
 
 /* Randomize directions.
@@ -952,9 +959,9 @@ static int ps_scgen_select_regions(struct ps_scgen *scgen) {
  * Select trdef resources from the resource manager.
  */
 
-static struct ps_res_trdef *ps_scgen_select_treasure_resource(const struct ps_restype *restype,struct ps_res_trdef **alreadyv,int alreadyc) {
+static struct ps_res_trdef *ps_scgen_select_treasure_resource(struct ps_scgen *scgen,const struct ps_restype *restype,struct ps_res_trdef **alreadyv,int alreadyc) {
   while (1) {
-    int p=rand()%restype->resc;
+    int p=ps_scgen_randint(scgen,restype->resc);
     struct ps_res_trdef *trdef=restype->resv[p].obj;
     int havec=0,i=alreadyc;
     while (i-->0) if (alreadyv[i]==trdef) havec++;
@@ -980,7 +987,7 @@ static int ps_scgen_select_treasure_resources(struct ps_scgen *scgen) {
 
   int i=0; for (;i<scgen->treasurec;i++) {
     if (!(scgen->scenario->treasurev[i]=ps_scgen_select_treasure_resource(
-      restype,scgen->scenario->treasurev,i
+      scgen,restype,scgen->scenario->treasurev,i
     ))) return -1;
   }
 
@@ -1043,6 +1050,7 @@ int ps_scgen_generate(struct ps_scgen *scgen) {
 
   /* Ensure our inputs are valid. */
   if (ps_scgen_validate(scgen)<0) return -1;
+  ps_prng_init(&scgen->prng,scgen->seed);
 
   /* Create a new blank scenario. */
   if (scgen->scenario) {
@@ -1057,6 +1065,7 @@ int ps_scgen_generate(struct ps_scgen *scgen) {
   if ((scgen->treasurec<1)||(scgen->treasurec>PS_TREASURE_LIMIT)) return ps_scgen_fail(scgen,"treasurec=%d",scgen->treasurec);
   if (ps_scgen_select_treasure_resources(scgen)<0) return -1;
   if (ps_scenario_reallocate_screens(scgen->scenario,w,h)<0) return -1;
+  if (ps_scgen_check_abort(scgen)<0) return -1;
 
   /* Place the home and treasure screens. */
   if (ps_scgen_place_home_and_treasure_screens(scgen)<0) return -1;
@@ -1081,15 +1090,18 @@ int ps_scgen_generate(struct ps_scgen *scgen) {
 
   /* Identify prime challenges. */
   if (ps_scgen_identify_prime_challenges(scgen)<0) return -1;
+  if (ps_scgen_check_abort(scgen)<0) return -1;
 
   /* Select blueprint and transform for each screen. */
   if (ps_scgen_select_blueprints(scgen)<0) return -1;
+  if (ps_scgen_check_abort(scgen)<0) return -1;
 
   /* Populate grid margins. */
   if (ps_scgen_populate_grid_margins(scgen)<0) return -1;
 
   /* Divide screens into thematic regions. */
   if (ps_scgen_select_regions(scgen)<0) return -1;
+  if (ps_scgen_check_abort(scgen)<0) return -1;
 
   /* Skin grids with graphics. */
   if (ps_scgen_generate_grids(scgen)<0) return -1;
@@ -1097,8 +1109,11 @@ int ps_scgen_generate(struct ps_scgen *scgen) {
   /* Assign treasure IDs and assert that all got assigned. */
   if (ps_scgen_assign_treasure_ids(scgen)<0) return -1;
 
+  /* Doors are final; measure distances between screens. */
+  if (ps_scenario_build_routes(scgen->scenario)<0) return -1;
+
   int64_t elapsed=ps_time_now()-starttime;
-  ps_log(GENERATOR,INFO,"Generated scenario in %d.%06d s.",(int)(elapsed/1000000),(int)(elapsed%1000000));
+  ps_log(GENERATOR,INFO,"Generated scenario in %d.%06d s, seed %u.",(int)(elapsed/1000000),(int)(elapsed%1000000),scgen->seed);
 
   return 0;
 }
@@ -1190,19 +1205,19 @@ static int ps_scgen_select_random_regions(struct ps_scgen *scgen) {
      */
     if (screen->y>0) {
       if (screen->x>0) {
-        switch (rand()%3) {
+        switch (ps_scgen_randint(scgen,3)) {
           case 0: screen->region=screen[-scgen->scenario->w].region; break;
           case 1: screen->region=screen[-1].region; break;
           case 2: screen->region=restype->resv[ps_scgen_randint(scgen,restype->resc)].obj; break;
         }
       } else {
-        switch (rand()&1) {
+        switch (ps_scgen_randint(scgen,2)) {
           case 0: screen->region=screen[-scgen->scenario->w].region; break;
           case 1: screen->region=restype->resv[ps_scgen_randint(scgen,restype->resc)].obj; break;
         }
       }
     } else if (screen->x>0) {
-      switch (rand()&1) {
+      switch (ps_scgen_randint(scgen,2)) {
         case 0: screen->region=screen[-1].region; break;
         case 1: screen->region=restype->resv[ps_scgen_randint(scgen,restype->resc)].obj; break;
       }
@@ -1262,6 +1277,7 @@ int ps_scgen_test_generate(struct ps_scgen *scgen) {
 
   /* Ensure our inputs are valid. */
   if (ps_scgen_validate(scgen)<0) return -1;
+  ps_prng_init(&scgen->prng,scgen->seed);
 
   /* Create a new blank scenario. */
   if (scgen->scenario) {
@@ -1298,7 +1314,7 @@ int ps_scgen_test_generate(struct ps_scgen *scgen) {
   if (ps_scgen_generate_grids(scgen)<0) return -1;
 
   int64_t elapsed=ps_time_now()-starttime;
-  ps_log(GENERATOR,INFO,"Generated scenario in %d.%06d s.",(int)(elapsed/1000000),(int)(elapsed%1000000));
+  ps_log(GENERATOR,INFO,"Generated scenario in %d.%06d s, seed %u.",(int)(elapsed/1000000),(int)(elapsed%1000000),scgen->seed);
 
   return 0;
 }
@@ -1426,7 +1442,7 @@ static int ps_scgen_select_test_blueprints_all(struct ps_scgen *scgen,const stru
       scgen->homex=scgen->scenario->homex=screen->x;
       scgen->homey=scgen->scenario->homey=screen->y;
     }
-    screen->xform=rand()&3;
+    screen->xform=ps_scgen_randint(scgen,4);
     if (ps_screen_build_inner_grid(screen)<0) return -1;
   }
   return 0;
@@ -1478,6 +1494,7 @@ int ps_scgen_test_generate_all_blueprints(struct ps_scgen *scgen,int blueprintid
 
   /* Ensure our inputs are valid. */
   if (ps_scgen_validate(scgen)<0) return -1;
+  ps_prng_init(&scgen->prng,scgen->seed);
 
   /* Gather requested blueprints. */
   struct ps_blueprint_list *blueprints=ps_scgen_generate_bounded_blueprint_list(scgen,blueprintidlo,blueprintidhi);
@@ -1489,7 +1506,7 @@ int ps_scgen_test_generate_all_blueprints(struct ps_scgen *scgen,int blueprintid
   if (err<0) return err;
 
   int64_t elapsed=ps_time_now()-starttime;
-  ps_log(GENERATOR,INFO,"Generated scenario in %d.%06d s.",(int)(elapsed/1000000),(int)(elapsed%1000000));
+  ps_log(GENERATOR,INFO,"Generated scenario in %d.%06d s, seed %u.",(int)(elapsed/1000000),(int)(elapsed%1000000),scgen->seed);
 
   return 0;
 }
@@ -8,6 +8,7 @@
  *     skills
  *     difficulty
  *     length
+ *     seed
  * 3. Call ps_scgen_generate()
  * 4. Pull result from (scenario) or error message from (msg,msgc).
  *
@@ -16,6 +17,8 @@
 #ifndef PS_SCGEN_H
 #define PS_SCGEN_H
 
+#include "util/ps_prng.h"
+
 struct ps_scenario;
 struct ps_blueprint_list;
 struct ps_zones;
@@ -27,6 +30,8 @@ struct ps_scgen {
   uint16_t skills;
   int difficulty;
   int length;
+  uint32_t seed; // Same inputs and seed always produce the same scenario.
+  const int *abort; // Optional, WEAK. Another thread sets it nonzero to make generation fail early.
 
   // Inputs for test generator only:
   struct ps_blueprint_list *blueprints_require;
@@ -44,6 +49,7 @@ struct ps_scgen {
   struct ps_blueprint_list *blueprints;
   struct ps_blueprint_list *blueprints_scratch;
   struct ps_zones *zones;
+  struct ps_prng prng; // Seeded from (seed) at the start of each generate call.
 };
 
 struct ps_scgen *ps_scgen_new();
@@ -70,7 +76,13 @@ int ps_scgen_failv(struct ps_scgen *scgen,const char *fmt,va_list vargs);
 int ps_scgen_fail(struct ps_scgen *scgen,const char *fmt,...);
 
 /* Internal use.
+ * All randomness in the generator must come from here, never rand().
  */
 int ps_scgen_randint(struct ps_scgen *scgen,int limit);
 
+/* Internal use.
+ * Fail with "Aborted." if (abort) is set. Generation checks between stages.
+ */
+int ps_scgen_check_abort(struct ps_scgen *scgen);
+
 #endif
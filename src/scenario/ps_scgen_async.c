@@ -0,0 +1,267 @@
+#include "ps.h"
+#include "ps_scgen_async.h"
+#include "ps_scgen.h"
+#include "ps_scenario.h"
+#include "res/ps_resmgr.h"
+#include "os/ps_clockassist.h"
+#include <pthread.h>
+
+/* Object.
+ * Everything below (mutex) is guarded by it, except (abort), which the running generator also reads.
+ */
+
+struct ps_scgen_async {
+  pthread_t thread;
+  int thread_running;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  int quit;
+
+  struct ps_scgen_request pending;
+  int has_pending;
+
+  struct ps_scgen_request running;
+  int has_running;
+  int abort;
+
+  struct ps_scgen_request result_request;
+  struct ps_scenario *result;
+
+  struct ps_scgen_async_status status;
+};
+
+/* Request helpers.
+ */
+
+static int ps_scgen_request_match(const struct ps_scgen_request *a,const struct ps_scgen_request *b) {
+  if (a->playerc!=b->playerc) return 0;
+  if (a->skills!=b->skills) return 0;
+  if (a->difficulty!=b->difficulty) return 0;
+  if (a->length!=b->length) return 0;
+  return 1;
+}
+
+static void ps_scgen_async_abort_locked(struct ps_scgen_async *async) {
+  if (async->has_running) __atomic_store_n(&async->abort,1,__ATOMIC_RELEASE);
+  async->has_pending=0;
+  if (async->result) {
+    ps_scenario_del(async->result);
+    async->result=0;
+  }
+}
+
+/* Generate one scenario, on the worker thread, without the lock.
+ */
+
+static struct ps_scenario *ps_scgen_async_generate(struct ps_scgen_async *async,const struct ps_scgen_request *request) {
+  struct ps_scgen *scgen=ps_scgen_new();
+  if (!scgen) return 0;
+  scgen->playerc=request->playerc;
+  scgen->skills=request->skills;
+  scgen->difficulty=request->difficulty;
+  scgen->length=request->length;
+  scgen->seed=request->seed;
+  scgen->abort=&async->abort;
+
+  struct ps_scenario *scenario=0;
+  if (ps_scgen_generate(scgen)<0) {
+    if (!__atomic_load_n(&async->abort,__ATOMIC_ACQUIRE)) {
+      ps_log(GENERATOR,ERROR,"Background generation failed: %.*s",scgen->msgc,scgen->msg);
+    }
+  } else {
+    scenario=scgen->scenario;
+    scgen->scenario=0;
+  }
+  ps_scgen_del(scgen);
+  return scenario;
+}
+
+/* Worker thread.
+ */
+
+static void *ps_scgen_async_thread(void *arg) {
+  struct ps_scgen_async *async=arg;
+  pthread_mutex_lock(&async->mutex);
+  while (1) {
+    while (!async->quit&&!async->has_pending) pthread_cond_wait(&async->cond,&async->mutex);
+    if (async->quit) break;
+
+    struct ps_scgen_request request=async->pending;
+    async->running=request;
+    async->has_running=1;
+    async->has_pending=0;
+    async->status.busy=1;
+    __atomic_store_n(&async->abort,0,__ATOMIC_RELEASE);
+    pthread_mutex_unlock(&async->mutex);
+
+    int64_t starttime=ps_time_now();
+    struct ps_scenario *scenario=ps_scgen_async_generate(async,&request);
+    int64_t elapsed=ps_time_now()-starttime;
+
+    pthread_mutex_lock(&async->mutex);
+    async->has_running=0;
+    async->status.busy=0;
+    if (__atomic_load_n(&async->abort,__ATOMIC_ACQUIRE)) {
+      ps_log(GENERATOR,DEBUG,"Abandoned background scenario after %d us.",(int)elapsed);
+      ps_scenario_del(scenario);
+      async->status.abortc++;
+    } else if (!scenario) {
+      async->status.failc++;
+    } else {
+      ps_log(GENERATOR,INFO,"Background scenario ready in %d.%06d s.",(int)(elapsed/1000000),(int)(elapsed%1000000));
+      if (async->result) ps_scenario_del(async->result);
+      async->result=scenario;
+      async->result_request=request;
+      async->status.finishc++;
+      async->status.last_generate_us=elapsed;
+    }
+    pthread_cond_broadcast(&async->cond);
+  }
+  pthread_mutex_unlock(&async->mutex);
+  return 0;
+}
+
+/* Object lifecycle.
+ */
+
+struct ps_scgen_async *ps_scgen_async_new() {
+  struct ps_scgen_async *async=calloc(1,sizeof(struct ps_scgen_async));
+  if (!async) return 0;
+  if (pthread_mutex_init(&async->mutex,0)) {
+    free(async);
+    return 0;
+  }
+  if (pthread_cond_init(&async->cond,0)) {
+    pthread_mutex_destroy(&async->mutex);
+    free(async);
+    return 0;
+  }
+  return async;
+}
+
+void ps_scgen_async_del(struct ps_scgen_async *async) {
+  if (!async) return;
+  if (async->thread_running) {
+    pthread_mutex_lock(&async->mutex);
+    async->quit=1;
+    ps_scgen_async_abort_locked(async);
+    pthread_cond_broadcast(&async->cond);
+    pthread_mutex_unlock(&async->mutex);
+    pthread_join(async->thread,0);
+  }
+  ps_scenario_del(async->result);
+  pthread_cond_destroy(&async->cond);
+  pthread_mutex_destroy(&async->mutex);
+  free(async);
+}
+
+/* Request.
+ */
+
+int ps_scgen_async_request(struct ps_scgen_async *async,const struct ps_scgen_request *request) {
+  if (!async||!request) return -1;
+
+  // The worker must only read resources. Decoding anything pending is our job, on the main thread.
+  if (ps_resmgr_require_all()<0) return -1;
+
+  if (pthread_mutex_lock(&async->mutex)) return -1;
+
+  if (async->has_running&&!__atomic_load_n(&async->abort,__ATOMIC_ACQUIRE)&&ps_scgen_request_match(&async->running,request)) {
+    async->has_pending=0;
+    pthread_mutex_unlock(&async->mutex);
+    return 0;
+  }
+  if (async->has_pending&&ps_scgen_request_match(&async->pending,request)) {
+    pthread_mutex_unlock(&async->mutex);
+    return 0;
+  }
+  if (async->result&&ps_scgen_request_match(&async->result_request,request)) {
+    async->has_pending=0;
+    if (async->has_running) __atomic_store_n(&async->abort,1,__ATOMIC_RELEASE);
+    pthread_mutex_unlock(&async->mutex);
+    return 0;
+  }
+
+  ps_scgen_async_abort_locked(async);
+  async->pending=*request;
+  async->has_pending=1;
+  async->status.requestc++;
+  ps_log(GENERATOR,DEBUG,
+    "Background generation: playerc=%d skills=0x%04x difficulty=%d length=%d seed=%u",
+    request->playerc,request->skills,request->difficulty,request->length,request->seed
+  );
+
+  if (!async->thread_running) {
+    if (pthread_create(&async->thread,0,ps_scgen_async_thread,async)) {
+      async->has_pending=0;
+      pthread_mutex_unlock(&async->mutex);
+      ps_log(GENERATOR,ERROR,"Failed to create background generator thread.");
+      return -1;
+    }
+    async->thread_running=1;
+  }
+
+  pthread_cond_broadcast(&async->cond);
+  pthread_mutex_unlock(&async->mutex);
+  return 0;
+}
+
+/* Take result.
+ */
+
+int ps_scgen_async_take(
+  struct ps_scenario **dst,uint32_t *seed,
+  struct ps_scgen_async *async,const struct ps_scgen_request *request
+) {
+  if (!dst||!async||!request) return -1;
+  if (pthread_mutex_lock(&async->mutex)) return -1;
+  int64_t starttime=ps_time_now();
+
+  while (1) {
+    if (async->result&&ps_scgen_request_match(&async->result_request,request)) {
+      *dst=async->result;
+      if (seed) *seed=async->result_request.seed;
+      async->result=0;
+      async->status.takec++;
+      async->status.last_wait_us=ps_time_now()-starttime;
+      ps_log(GENERATOR,INFO,"Using background scenario, waited %d us.",(int)async->status.last_wait_us);
+      pthread_mutex_unlock(&async->mutex);
+      return 1;
+    }
+    if (
+      (async->has_running&&!__atomic_load_n(&async->abort,__ATOMIC_ACQUIRE)&&ps_scgen_request_match(&async->running,request))||
+      (async->has_pending&&ps_scgen_request_match(&async->pending,request))
+    ) {
+      pthread_cond_wait(&async->cond,&async->mutex);
+      continue;
+    }
+    break;
+  }
+
+  ps_scgen_async_abort_locked(async);
+  async->status.missc++;
+  pthread_mutex_unlock(&async->mutex);
+  return 0;
+}
+
+/* Cancel.
+ */
+
+int ps_scgen_async_cancel(struct ps_scgen_async *async) {
+  if (!async) return -1;
+  if (pthread_mutex_lock(&async->mutex)) return -1;
+  ps_scgen_async_abort_locked(async);
+  pthread_mutex_unlock(&async->mutex);
+  return 0;
+}
+
+/* Status.
+ */
+
+int ps_scgen_async_get_status(struct ps_scgen_async_status *status,struct ps_scgen_async *async) {
+  if (!status||!async) return -1;
+  if (pthread_mutex_lock(&async->mutex)) return -1;
+  *status=async->status;
+  pthread_mutex_unlock(&async->mutex);
+  return 0;
+}
@@ -0,0 +1,61 @@
+/* ps_scgen_async.h
+ * Generate a scenario on a background thread, speculatively, while the user is still choosing settings.
+ * Post a request whenever the settings change; we abandon whatever is in flight and start over.
+ * When the user commits, take the result: Instantly if it's done, or wait for it if it's still going.
+ * If the committed settings don't match any request, take tells you so and the caller generates normally.
+ * We own one worker thread, created on the first request and joined at delete.
+ */
+
+#ifndef PS_SCGEN_ASYNC_H
+#define PS_SCGEN_ASYNC_H
+
+struct ps_scgen_async;
+struct ps_scenario;
+
+/* Everything that determines the scenario.
+ * Take matches on everything but (seed), which is chosen at request time.
+ */
+struct ps_scgen_request {
+  int playerc;
+  uint16_t skills;
+  int difficulty;
+  int length;
+  uint32_t seed;
+};
+
+struct ps_scgen_async_status {
+  int requestc; // Requests that started (or queued) a generation.
+  int abortc; // Generations abandoned because the settings changed first.
+  int failc; // Generations that failed on their own.
+  int finishc; // Generations completed.
+  int takec; // Results handed off at commit.
+  int missc; // Commits that didn't match any request.
+  int64_t last_generate_us; // Duration of the most recent completed generation.
+  int64_t last_wait_us; // How long the most recent take blocked. Zero if the scenario was ready.
+  int busy; // Nonzero if the worker is generating right now.
+};
+
+struct ps_scgen_async *ps_scgen_async_new();
+void ps_scgen_async_del(struct ps_scgen_async *async);
+
+/* Begin generating for (request), unless we already are or already have.
+ * Anything else in flight is aborted, and any finished result for other settings is dropped.
+ */
+int ps_scgen_async_request(struct ps_scgen_async *async,const struct ps_scgen_request *request);
+
+/* If we have or are making a scenario for these settings, wait for it and hand it off.
+ * Returns >0 on success, with a new reference in (*dst) and the seed that made it in (*seed).
+ * Returns 0 if we had nothing matching, or it failed; the worker is then idle and you should generate it yourself.
+ */
+int ps_scgen_async_take(
+  struct ps_scenario **dst,uint32_t *seed,
+  struct ps_scgen_async *async,const struct ps_scgen_request *request
+);
+
+/* Abort anything in flight and drop any result. Doesn't wait.
+ */
+int ps_scgen_async_cancel(struct ps_scgen_async *async);
+
+int ps_scgen_async_get_status(struct ps_scgen_async_status *status,struct ps_scgen_async *async);
+
+#endif
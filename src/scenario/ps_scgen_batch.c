@@ -0,0 +1,187 @@
+#include "ps.h"
+#include "ps_scgen_batch.h"
+#include "ps_scgen.h"
+#include "ps_scenario.h"
+#include "ps_screen.h"
+#include "ps_blueprint.h"
+#include "ps_grid.h"
+#include "res/ps_resmgr.h"
+#include "os/ps_clockassist.h"
+#include <pthread.h>
+#include <unistd.h>
+
+/* Shared state for one run.
+ * Workers claim jobs one at a time by bumping (nextp); nothing else is shared.
+ */
+
+struct ps_scgen_batch {
+  struct ps_scgen_batch_job *jobv;
+  int jobc;
+  int nextp;
+};
+
+/* Validate.
+ */
+
+static int ps_scgen_batch_invalid(char *msg,int msga,const char *fmt,...) {
+  if (msg&&(msga>0)) {
+    va_list vargs;
+    va_start(vargs,fmt);
+    vsnprintf(msg,msga,fmt,vargs);
+    va_end(vargs);
+  }
+  return -1;
+}
+
+int ps_scgen_batch_validate(char *msg,int msga,struct ps_scenario *scenario,int playerc,uint16_t skills) {
+  if (!scenario) return ps_scgen_batch_invalid(msg,msga,"No scenario.");
+  if ((scenario->w<1)||(scenario->h<1)||!scenario->screenv) return ps_scgen_batch_invalid(msg,msga,"Empty world.");
+  if ((scenario->homex<0)||(scenario->homex>=scenario->w)||(scenario->homey<0)||(scenario->homey>=scenario->h)) {
+    return ps_scgen_batch_invalid(msg,msga,"Home (%d,%d) outside world (%d,%d).",scenario->homex,scenario->homey,scenario->w,scenario->h);
+  }
+  if ((scenario->treasurec<1)||(scenario->treasurec>PS_TREASURE_LIMIT)) {
+    return ps_scgen_batch_invalid(msg,msga,"Treasure count %d.",scenario->treasurec);
+  }
+
+  uint8_t treasure_seen[PS_TREASURE_LIMIT]={0};
+  int treasurec=0;
+  int x,y;
+  for (y=0;y<scenario->h;y++) for (x=0;x<scenario->w;x++) {
+    const struct ps_screen *screen=PS_SCENARIO_SCREEN(scenario,x,y);
+
+    int direction;
+    if (ps_scenario_get_route(&direction,scenario,x,y,scenario->homex,scenario->homey)<0) {
+      return ps_scgen_batch_invalid(msg,msga,"Screen (%d,%d) unreachable from home.",x,y);
+    }
+
+    if (!screen->blueprint||!screen->region||!screen->grid) {
+      return ps_scgen_batch_invalid(msg,msga,"Screen (%d,%d) incomplete.",x,y);
+    }
+    if (!ps_blueprint_is_solvable(0,screen->blueprint,playerc,skills)) {
+      return ps_scgen_batch_invalid(msg,msga,
+        "Screen (%d,%d) blueprint:%d not solvable by %d players with skills 0x%04x.",
+        x,y,ps_res_get_id_by_obj(PS_RESTYPE_BLUEPRINT,screen->blueprint),playerc,skills
+      );
+    }
+
+    const struct ps_blueprint_poi *poi=screen->grid->poiv;
+    int i=screen->grid->poic;
+    for (;i-->0;poi++) {
+      if (poi->type!=PS_BLUEPRINT_POI_TREASURE) continue;
+      int treasureid=poi->argv[0];
+      if ((treasureid<0)||(treasureid>=scenario->treasurec)) {
+        return ps_scgen_batch_invalid(msg,msga,"Screen (%d,%d) has treasure %d, limit %d.",x,y,treasureid,scenario->treasurec);
+      }
+      if (treasure_seen[treasureid]) {
+        return ps_scgen_batch_invalid(msg,msga,"Treasure %d appears twice.",treasureid);
+      }
+      if (!scenario->treasurev||!scenario->treasurev[treasureid]) {
+        return ps_scgen_batch_invalid(msg,msga,"No definition for treasure %d.",treasureid);
+      }
+      treasure_seen[treasureid]=1;
+      treasurec++;
+    }
+  }
+  if (treasurec!=scenario->treasurec) {
+    return ps_scgen_batch_invalid(msg,msga,"Expected %d treasures, found %d.",scenario->treasurec,treasurec);
+  }
+
+  return 0;
+}
+
+/* Run one job.
+ */
+
+static void ps_scgen_batch_run_job(struct ps_scgen_batch_job *job) {
+  struct ps_scgen *scgen=ps_scgen_new();
+  if (!scgen) {
+    job->result=ps_scgen_batch_invalid(job->msg,sizeof(job->msg),"Failed to create generator.");
+    return;
+  }
+  scgen->playerc=job->playerc;
+  scgen->skills=job->skills;
+  scgen->difficulty=job->difficulty;
+  scgen->length=job->length;
+  scgen->seed=job->seed;
+
+  int64_t starttime=ps_time_now();
+  int err=ps_scgen_generate(scgen);
+  job->elapsed_us=ps_time_now()-starttime;
+
+  if (err<0) {
+    job->result=ps_scgen_batch_invalid(job->msg,sizeof(job->msg),"%.*s",scgen->msgc,scgen->msg?scgen->msg:"Generator failed.");
+  } else if (ps_scenario_ref(scgen->scenario)<0) {
+    job->result=ps_scgen_batch_invalid(job->msg,sizeof(job->msg),"Failed to retain scenario.");
+  } else {
+    job->scenario=scgen->scenario;
+    job->result=ps_scgen_batch_validate(job->msg,sizeof(job->msg),job->scenario,job->playerc,job->skills);
+  }
+
+  ps_scgen_del(scgen);
+}
+
+/* Worker thread.
+ */
+
+static void *ps_scgen_batch_worker(void *arg) {
+  struct ps_scgen_batch *batch=arg;
+  while (1) {
+    int p=__atomic_fetch_add(&batch->nextp,1,__ATOMIC_RELAXED);
+    if (p>=batch->jobc) break;
+    ps_scgen_batch_run_job(batch->jobv+p);
+  }
+  return 0;
+}
+
+/* Run batch, main entry point.
+ */
+
+int ps_scgen_batch_run(struct ps_scgen_batch_job *jobv,int jobc,int threadc) {
+  if ((jobc<0)||(jobc&&!jobv)) return -1;
+  ps_scgen_batch_cleanup(jobv,jobc);
+  if (!jobc) return 0;
+
+  if (ps_resmgr_require_all()<0) return -1;
+
+  if (threadc<1) {
+    threadc=sysconf(_SC_NPROCESSORS_ONLN);
+    if (threadc<1) threadc=1;
+  }
+  if (threadc>PS_SCGEN_BATCH_THREAD_LIMIT) threadc=PS_SCGEN_BATCH_THREAD_LIMIT;
+  if (threadc>jobc) threadc=jobc;
+
+  /* The calling thread is one of the workers. */
+  struct ps_scgen_batch batch={
+    .jobv=jobv,
+    .jobc=jobc,
+  };
+  pthread_t threadv[PS_SCGEN_BATCH_THREAD_LIMIT];
+  int i,spawnc=0;
+  for (i=1;i<threadc;i++) {
+    if (pthread_create(threadv+spawnc,0,ps_scgen_batch_worker,&batch)) {
+      ps_log(GENERATOR,WARN,"Failed to create scgen worker thread. Proceeding with %d.",spawnc+1);
+      break;
+    }
+    spawnc++;
+  }
+  ps_scgen_batch_worker(&batch);
+  for (i=0;i<spawnc;i++) pthread_join(threadv[i],0);
+
+  int failc=0;
+  for (i=0;i<jobc;i++) if (jobv[i].result<0) failc++;
+  return failc;
+}
+
+/* Cleanup.
+ */
+
+void ps_scgen_batch_cleanup(struct ps_scgen_batch_job *jobv,int jobc) {
+  if (!jobv) return;
+  for (;jobc-->0;jobv++) {
+    ps_scenario_del(jobv->scenario);
+    jobv->scenario=0;
+    jobv->result=0;
+    jobv->elapsed_us=0;
+    jobv->msg[0]=0;
+  }
+}
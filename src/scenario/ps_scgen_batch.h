@@ -0,0 +1,52 @@
+/* ps_scgen_batch.h
+ * Generate many scenarios at once, across a pool of threads.
+ * Each job gets its own ps_scgen, so results are the same as generating them one at a time with the same seeds.
+ * Every result is validated before we report success.
+ * For pre-generating scenario pools, and for measuring the generator.
+ */
+
+#ifndef PS_SCGEN_BATCH_H
+#define PS_SCGEN_BATCH_H
+
+#define PS_SCGEN_BATCH_THREAD_LIMIT 16
+#define PS_SCGEN_BATCH_MSG_LIMIT 128
+
+struct ps_scenario;
+
+struct ps_scgen_batch_job {
+
+  // Inputs, exactly as for ps_scgen:
+  int playerc;
+  uint16_t skills;
+  int difficulty;
+  int length;
+  uint32_t seed;
+
+  // Outputs:
+  int result; // <0 if generation or validation failed.
+  struct ps_scenario *scenario; // STRONG. Null if generation failed, present if only validation failed.
+  int64_t elapsed_us; // Generation only, not validation.
+  char msg[PS_SCGEN_BATCH_MSG_LIMIT]; // Reason for failure, if any.
+};
+
+/* Run all jobs, with at most (threadc) workers. (threadc<1) means one per core.
+ * We decode every pending resource first, so the workers only ever read the resource manager.
+ * Returns the count of failed jobs, which is not itself an error.
+ * <0 only if we couldn't run at all.
+ * Results already present in (jobv) are dropped first.
+ */
+int ps_scgen_batch_run(struct ps_scgen_batch_job *jobv,int jobc,int threadc);
+
+/* Drop all scenarios in (jobv), and clear their outputs.
+ */
+void ps_scgen_batch_cleanup(struct ps_scgen_batch_job *jobv,int jobc);
+
+/* Check a generated scenario against the inputs that made it:
+ *  - Every screen is reachable from home.
+ *  - Treasure count agrees with the treasure POIs, and each one has a treasure definition.
+ *  - Every screen's blueprint is solvable by this party.
+ * Returns <0 and describes the first problem in (msg) if invalid.
+ */
+int ps_scgen_batch_validate(char *msg,int msga,struct ps_scenario *scenario,int playerc,uint16_t skills);
+
+#endif
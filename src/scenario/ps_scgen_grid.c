@@ -461,6 +461,7 @@ int ps_scgen_generate_grids(struct ps_scgen *scgen) {
   int screenc=scgen->scenario->w*scgen->scenario->h;
   struct ps_screen *screen=scgen->scenario->screenv;
   for (;screenc-->0;screen++) {
+    if (ps_scgen_check_abort(scgen)<0) return -1;
     if (ps_scgen_generate_grid(scgen,screen)<0) return -1;
   }
   return 0;
@@ -219,7 +219,7 @@ static int ps_screen_find_widest_open_col(int *p,const struct ps_grid_cell *src)
   while (srcp<PS_GRID_ROWC-2) {
     if (ps_blueprint_cell_is_passable(src[srcp*PS_GRID_COLC].physics)) {
       int subc=1;
-      while ((srcp+subc<PS_GRID_COLC-2)&&ps_blueprint_cell_is_passable(src[(srcp+subc)*PS_GRID_COLC].physics)) subc++;
+      while ((srcp+subc<PS_GRID_ROWC-2)&&ps_blueprint_cell_is_passable(src[(srcp+subc)*PS_GRID_COLC].physics)) subc++;
       if (subc>widestc) {
         widestp=srcp;
         widestc=subc;
@@ -109,4 +109,18 @@ int ps_sdraw_blit_maxtile(
   const struct ps_sdraw_image *src
 );
 
+/* Same as ps_sdraw_blit_maxtile for each vertex, choosing the pixel loop once for the batch.
+ */
+int ps_sdraw_blit_maxtiles(
+  struct ps_sdraw_image *dst,
+  const struct akgl_vtx_maxtile *vtxv,int vtxc,
+  const struct ps_sdraw_image *src
+);
+
+/* Blits onto RGBX from RGBA, RGBX, and A use loops specialized for those formats.
+ * They produce exactly the same pixels as the generic path, only faster.
+ * Enabled by default; disabling is only useful for testing and measurement.
+ */
+void ps_sdraw_set_kernels_enabled(int enable);
+
 #endif
@@ -1,8 +1,95 @@
 #include "ps.h"
 #include "ps_sdraw.h"
+#include "ps_sdraw_kernel.h"
 #include "akgl/akgl.h" /* For struct akgl_vtx_maxtile */
 #include <math.h>
 
+/* Widest visible output of a scaled blit that the kernels will take.
+ */
+#define PS_SDRAW_SCALE_COLUMN_LIMIT 1024
+
+/* Source byte offsets for each column a scaled blit touches, exactly the columns the generic loop would.
+ * They are always contiguous, starting at output column (*dstxp0).
+ * Returns the count, or <0 if it exceeds (offa).
+ */
+
+static int ps_sdraw_scale_columns(
+  int *offv,int offa,int *dstxp0,
+  const struct ps_sdraw_image *dst,int dstx,int dstw,
+  const struct ps_sdraw_image *src,int srcx,int srcw
+) {
+  int offc=0;
+  int dstxz=dstx+dstw;
+  int dstxp=dstx; for (;dstxp<dstxz;dstxp++) {
+    if (dstxp<0) continue;
+    if (dstxp>=dst->w) break;
+    int srcxp=srcx+((dstxp-dstx)*srcw)/dstw;
+    if (srcxp<0) continue;
+    if (srcxp>=src->w) break;
+    if (!offc) *dstxp0=dstxp;
+    if (offc>=offa) return -1;
+    offv[offc++]=srcxp*src->colstride;
+  }
+  return offc;
+}
+
+/* Plain blit with scaling, RGBA, RGBX, or RGB onto RGBX.
+ * Returns >0 if handled, 0 if the generic path must do it.
+ */
+
+static int ps_sdraw_blit__scale_kernel(
+  struct ps_sdraw_image *dst,int dstx,int dsty,int dstw,int dsth,
+  const struct ps_sdraw_image *src,int srcx,int srcy,int srcw,int srch
+) {
+  if (dst->fmt!=PS_SDRAW_FMT_RGBX) return 0;
+  switch (src->fmt) {
+    case PS_SDRAW_FMT_RGBA:
+    case PS_SDRAW_FMT_RGBX:
+    case PS_SDRAW_FMT_RGB:
+      break;
+    default: return 0;
+  }
+
+  int offv[PS_SDRAW_SCALE_COLUMN_LIMIT];
+  int dstxp0=0;
+  int offc=ps_sdraw_scale_columns(offv,PS_SDRAW_SCALE_COLUMN_LIMIT,&dstxp0,dst,dstx,dstw,src,srcx,srcw);
+  if (offc<0) return 0;
+  if (!offc) return 1;
+
+  uint8_t tmp[PS_SDRAW_KERNEL_CHUNK<<2];
+  int dstyz=dsty+dsth;
+  int dstyp=dsty; for (;dstyp<dstyz;dstyp++) {
+    if (dstyp<0) continue;
+    if (dstyp>=dst->h) break;
+    int srcyp=srcy+((dstyp-dsty)*srch)/dsth;
+    if (srcyp<0) continue;
+    if (srcyp>=src->h) break;
+    uint8_t *dstp=dst->pixels+dstyp*dst->rowstride+(dstxp0<<2);
+    const uint8_t *srcrow=src->pixels+srcyp*src->rowstride;
+
+    if (src->fmt==PS_SDRAW_FMT_RGBA) {
+      int i=0; while (i<offc) {
+        int c=offc-i;
+        if (c>PS_SDRAW_KERNEL_CHUNK) c=PS_SDRAW_KERNEL_CHUNK;
+        uint8_t *p=tmp;
+        int j=0; for (;j<c;j++,p+=4) memcpy(p,srcrow+offv[i+j],4);
+        ps_sdraw_kernel_over_RGBX_RGBA(dstp+(i<<2),tmp,c);
+        i+=c;
+      }
+    } else {
+      const int *off=offv;
+      int i=offc; for (;i-->0;dstp+=4,off++) {
+        const uint8_t *srcp=srcrow+*off;
+        dstp[0]=srcp[0];
+        dstp[1]=srcp[1];
+        dstp[2]=srcp[2];
+        dstp[3]=0xff;
+      }
+    }
+  }
+  return 1;
+}
+
 /* Plain blit with scaling.
  */
 
@@ -11,9 +98,13 @@ static int ps_sdraw_blit__scale(
   const struct ps_sdraw_image *src,int srcx,int srcy,int srcw,int srch
 ) {
   if ((dstw<1)||(dsth<1)||(srcw<1)||(srch<1)) return 0;
-  
-  //TODO Optimize plain blit with scaling.
-  
+
+  if (ps_sdraw_kernels_enabled) {
+    int err=ps_sdraw_blit__scale_kernel(dst,dstx,dsty,dstw,dsth,src,srcx,srcy,srcw,srch);
+    if (err<0) return err;
+    if (err) return 0;
+  }
+
   ps_sdraw_pxrd_fn pxrd=ps_sdraw_pxrd_for_fmt(src->fmt);
   ps_sdraw_pxwr_fn pxwr=ps_sdraw_pxwr_for_fmt(dst->fmt);
   if (!pxrd||!pxwr) return -1;
@@ -84,7 +175,15 @@ int ps_sdraw_blit(
     return 0;
   }
 
-  //TODO More optimized format scenarios for plain blit.
+  // RGBA sprites and tiles onto the framebuffer.
+  if (ps_sdraw_kernels_enabled&&(dst->fmt==PS_SDRAW_FMT_RGBX)&&(src->fmt==PS_SDRAW_FMT_RGBA)) {
+    while (srch-->0) {
+      ps_sdraw_kernel_over_RGBX_RGBA(dstrow,srcrow,srcw);
+      dstrow+=dst->rowstride;
+      srcrow+=src->rowstride;
+    }
+    return 0;
+  }
 
   // General blit, one pixel at a time through generalized accessors.
   ps_sdraw_pxrd_fn pxrd=ps_sdraw_pxrd_for_fmt(src->fmt);
@@ -109,9 +208,37 @@ static int ps_sdraw_blit_replacergb__scale(
   struct ps_sdraw_rgba rgba
 ) {
   if ((dstw<1)||(dsth<1)||(srcw<1)||(srch<1)) return 0;
-  
-  //TODO Optimize blit with scaling.
-  
+
+  /* Text onto the framebuffer.
+   * Note that this path has always taken source alpha verbatim, ignoring (rgba.a).
+   */
+  if (ps_sdraw_kernels_enabled&&(dst->fmt==PS_SDRAW_FMT_RGBX)&&(src->fmt==PS_SDRAW_FMT_A)) {
+    int offv[PS_SDRAW_SCALE_COLUMN_LIMIT];
+    int dstxp0=0;
+    int offc=ps_sdraw_scale_columns(offv,PS_SDRAW_SCALE_COLUMN_LIMIT,&dstxp0,dst,dstx,dstw,src,srcx,srcw);
+    if (offc>=0) {
+      uint8_t tmp[PS_SDRAW_KERNEL_CHUNK];
+      int dstyz=dsty+dsth;
+      int dstyp=dsty; for (;dstyp<dstyz;dstyp++) {
+        if (dstyp<0) continue;
+        if (dstyp>=dst->h) break;
+        int srcyp=srcy+((dstyp-dsty)*srch)/dsth;
+        if (srcyp<0) continue;
+        if (srcyp>=src->h) break;
+        uint8_t *dstp=dst->pixels+dstyp*dst->rowstride+(dstxp0<<2);
+        const uint8_t *srcrow=src->pixels+srcyp*src->rowstride;
+        int i=0; while (i<offc) {
+          int c=offc-i;
+          if (c>PS_SDRAW_KERNEL_CHUNK) c=PS_SDRAW_KERNEL_CHUNK;
+          int j=0; for (;j<c;j++) tmp[j]=srcrow[offv[i+j]];
+          ps_sdraw_kernel_tint_RGBX_A(dstp+(i<<2),tmp,c,rgba.r,rgba.g,rgba.b,0x100);
+          i+=c;
+        }
+      }
+      return 0;
+    }
+  }
+
   ps_sdraw_pxrd_fn pxrd=ps_sdraw_pxrd_for_fmt(src->fmt);
   ps_sdraw_pxwr_fn pxwr=ps_sdraw_pxwr_for_fmt(dst->fmt);
   if (!pxrd||!pxwr) return -1;
@@ -184,7 +311,15 @@ int ps_sdraw_blit_replacergb(
   const uint8_t *srcrow=src->pixels+srcy*src->rowstride+srcx*src->colstride;
   uint8_t *dstrow=dst->pixels+dsty*dst->rowstride+dstx*dst->colstride;
 
-  //TODO More optimized format scenarios for color-replace blit.
+  // Text onto the framebuffer.
+  if (ps_sdraw_kernels_enabled&&(dst->fmt==PS_SDRAW_FMT_RGBX)&&(src->fmt==PS_SDRAW_FMT_A)) {
+    while (srch-->0) {
+      ps_sdraw_kernel_tint_RGBX_A(dstrow,srcrow,srcw,rgba.r,rgba.g,rgba.b,rgba.a);
+      dstrow+=dst->rowstride;
+      srcrow+=src->rowstride;
+    }
+    return 0;
+  }
 
   // Any output format, with the very likely input format of 'A'.
   ps_sdraw_pxwr_fn pxwr=ps_sdraw_pxwr_for_fmt(dst->fmt);
@@ -222,10 +357,11 @@ int ps_sdraw_blit_replacergb(
 /* Bells-and-whistles blit, rotation or similar required.
  */
  
-int ps_sdraw_blit_maxtile__rotate(
+static int ps_sdraw_blit_maxtile__rotate(
   struct ps_sdraw_image *dst,
   const struct akgl_vtx_maxtile *vtx,
-  const struct ps_sdraw_image *src
+  const struct ps_sdraw_image *src,
+  int kernel
 ) {
 
   /* Calculate source boundaries and center.
@@ -287,6 +423,59 @@ int ps_sdraw_blit_maxtile__rotate(
     };
     memcpy(mtx,prd,sizeof(prd));
   }
+
+  /* Without rotation, each source coordinate depends on just one output coordinate.
+   * The other product in each sum below is exactly zero, so tabulating per column and per row rounds identically.
+   */
+  int colc=dstr-dstl,rowc=dstb-dstt;
+  if (kernel&&!vtx->t&&(colc<=PS_SDRAW_KERNEL_CHUNK)&&(rowc<=PS_SDRAW_KERNEL_CHUNK)) {
+    int swap=0;
+    switch (vtx->xform) {
+      case AKGL_XFORM_90: case AKGL_XFORM_270: case AKGL_XFORM_FLOP90: case AKGL_XFORM_FLOP270: swap=1; break;
+    }
+    int colv[PS_SDRAW_KERNEL_CHUNK],rowv[PS_SDRAW_KERNEL_CHUNK];
+    int col0=colc,colz=0,i;
+    for (i=0;i<colc;i++) {
+      double fox=dstl+i-vtx->x;
+      if (swap) {
+        int iy=srcy+lround(fox*mtx[2]);
+        colv[i]=((iy<srct)||(iy>=srcb))?-1:(iy*src->rowstride);
+      } else {
+        int ix=srcx+lround(fox*mtx[0]);
+        colv[i]=((ix<srcl)||(ix>=srcr))?-1:(ix*src->colstride);
+      }
+      if (colv[i]>=0) {
+        if (i<col0) col0=i;
+        colz=i+1;
+      }
+    }
+    if (col0>=colz) return 0;
+    for (i=0;i<rowc;i++) {
+      double foy=dstt+i-vtx->y;
+      if (swap) {
+        int ix=srcx+lround(foy*mtx[1]);
+        rowv[i]=((ix<srcl)||(ix>=srcr))?-1:(ix*src->colstride);
+      } else {
+        int iy=srcy+lround(foy*mtx[3]);
+        rowv[i]=((iy<srct)||(iy>=srcb))?-1:(iy*src->rowstride);
+      }
+    }
+    uint8_t tmp[PS_SDRAW_KERNEL_CHUNK<<2];
+    int c=colz-col0;
+    uint8_t *dstrow=dst->pixels+dstt*dst->rowstride+((dstl+col0)<<2);
+    for (i=0;i<rowc;i++,dstrow+=dst->rowstride) {
+      if (rowv[i]<0) continue;
+      const uint8_t *srcrow=src->pixels+rowv[i];
+      uint8_t *p=tmp;
+      int j=col0; for (;j<colz;j++,p+=4) {
+        if (colv[j]<0) p[3]=0;
+        else memcpy(p,srcrow+colv[j],4);
+      }
+      ps_sdraw_kernel_shade_maxtile(tmp,c,vtx);
+      ps_sdraw_kernel_over_RGBX_RGBA(dstrow,tmp,c);
+    }
+    return 0;
+  }
   
   ps_sdraw_pxrd_fn pxrd=ps_sdraw_pxrd_for_fmt(src->fmt);
   ps_sdraw_pxwr_fn pxwr=ps_sdraw_pxwr_for_fmt(dst->fmt);
@@ -355,14 +544,15 @@ int ps_sdraw_blit_maxtile__rotate(
 }
 
 /* Bells-and-whistles blit.
+ * (kernel) nonzero if (dst) is RGBX and (src) RGBA, and we may use the specialized loops.
  */
  
-int ps_sdraw_blit_maxtile(
+static int ps_sdraw_blit_maxtile_1(
   struct ps_sdraw_image *dst,
   const struct akgl_vtx_maxtile *vtx,
-  const struct ps_sdraw_image *src
+  const struct ps_sdraw_image *src,
+  int kernel
 ) {
-  if (!dst||!vtx||!src) return -1;
   if (!vtx->a) return 0;
   if (vtx->size<1) return 0;
 
@@ -404,7 +594,7 @@ int ps_sdraw_blit_maxtile(
   /* If rotation or scaling is enabled, we use a rather different approach.
    */
   if (f_scale||f_rotate) {
-    return ps_sdraw_blit_maxtile__rotate(dst,vtx,src);
+    return ps_sdraw_blit_maxtile__rotate(dst,vtx,src,kernel);
   }
 
   /* If there's a transform and the output will clip, it's awkward.
@@ -413,7 +603,7 @@ int ps_sdraw_blit_maxtile(
    */
   if (f_xform) {
     if ((dstx<0)||(dsty<0)||(dstx>dst->w-srccolw)||(dsty>dst->h-srcrowh)) {
-      return ps_sdraw_blit_maxtile__rotate(dst,vtx,src);
+      return ps_sdraw_blit_maxtile__rotate(dst,vtx,src,kernel);
     }
   }
 
@@ -485,6 +675,27 @@ int ps_sdraw_blit_maxtile(
   int tgpm=vtx->tg*vtx->ta;
   int tbpm=vtx->tb*vtx->ta;
 
+  /* With the kernels, gather each row into a scratch buffer, apply effects there, then blend it all at once.
+   */
+  if (kernel) {
+    uint8_t tmp[PS_SDRAW_KERNEL_CHUNK<<2];
+    int yp=0; for (;yp<srcrowh;yp++,dstrow+=dst->rowstride,srcrow+=srcdy) {
+      uint8_t *dstp=dstrow;
+      const uint8_t *srcp=srcrow;
+      int xp=0; while (xp<srccolw) {
+        int c=srccolw-xp;
+        if (c>PS_SDRAW_KERNEL_CHUNK) c=PS_SDRAW_KERNEL_CHUNK;
+        uint8_t *p=tmp;
+        int i=c; for (;i-->0;p+=4,srcp+=srcdx) memcpy(p,srcp,4);
+        ps_sdraw_kernel_shade_maxtile(tmp,c,vtx);
+        ps_sdraw_kernel_over_RGBX_RGBA(dstp,tmp,c);
+        dstp+=c<<2;
+        xp+=c;
+      }
+    }
+    return 0;
+  }
+
   /* We are now ready to iterate.
    * Within the pixel transfer, we need to examine three features: tint, primary, alpha.
    */
@@ -531,3 +742,36 @@ int ps_sdraw_blit_maxtile(
 
   return 0;
 }
+
+/* Bells-and-whistles blit, public entry points.
+ */
+
+static int ps_sdraw_blit_maxtile_kernel(const struct ps_sdraw_image *dst,const struct ps_sdraw_image *src) {
+  if (!ps_sdraw_kernels_enabled) return 0;
+  if (dst->fmt!=PS_SDRAW_FMT_RGBX) return 0;
+  if (src->fmt!=PS_SDRAW_FMT_RGBA) return 0;
+  return 1;
+}
+ 
+int ps_sdraw_blit_maxtile(
+  struct ps_sdraw_image *dst,
+  const struct akgl_vtx_maxtile *vtx,
+  const struct ps_sdraw_image *src
+) {
+  if (!dst||!vtx||!src) return -1;
+  return ps_sdraw_blit_maxtile_1(dst,vtx,src,ps_sdraw_blit_maxtile_kernel(dst,src));
+}
+
+int ps_sdraw_blit_maxtiles(
+  struct ps_sdraw_image *dst,
+  const struct akgl_vtx_maxtile *vtxv,int vtxc,
+  const struct ps_sdraw_image *src
+) {
+  if (vtxc<1) return 0;
+  if (!dst||!vtxv||!src) return -1;
+  int kernel=ps_sdraw_blit_maxtile_kernel(dst,src);
+  for (;vtxc-->0;vtxv++) {
+    if (ps_sdraw_blit_maxtile_1(dst,vtxv,src,kernel)<0) return -1;
+  }
+  return 0;
+}
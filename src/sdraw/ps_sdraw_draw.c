@@ -38,16 +38,18 @@ int ps_sdraw_draw_rect(struct ps_sdraw_image *image,int x,int y,int w,int h,stru
         } break;
     
       case PS_SDRAW_FMT_RGBX: 
-      case PS_SDRAW_FMT_RGBA: { // RGBX or RGBA, no blending
-          while (h-->0) {
-            uint8_t *dst=dstrow;
+      case PS_SDRAW_FMT_RGBA: { // RGBX or RGBA, no blending. Fill one row, then copy it.
+          uint8_t *dst=dstrow;
+          int i=w; for (;i-->0;dst+=4) {
+            dst[0]=rgba.r;
+            dst[1]=rgba.g;
+            dst[2]=rgba.b;
+            dst[3]=0xff;
+          }
+          const uint8_t *src=dstrow;
+          while (--h>0) {
             dstrow+=image->rowstride;
-            int i=w; for (;i-->0;dst+=4) {
-              dst[0]=rgba.r;
-              dst[1]=rgba.g;
-              dst[2]=rgba.b;
-              dst[3]=0xff;
-            }
+            memcpy(dstrow,src,w<<2);
           }
         } break;
     
@@ -0,0 +1,150 @@
+#include "ps.h"
+#include "ps_sdraw.h"
+#include "ps_sdraw_kernel.h"
+#include "akgl/akgl.h" /* For struct akgl_vtx_maxtile */
+
+#if defined(__SSE2__)
+  #include <emmintrin.h>
+#endif
+
+int ps_sdraw_kernels_enabled=1;
+
+void ps_sdraw_set_kernels_enabled(int enable) {
+  ps_sdraw_kernels_enabled=enable?1:0;
+}
+
+/* RGBA over RGBX.
+ */
+
+static inline void ps_sdraw_kernel_over_1(uint8_t *dst,const uint8_t *src) {
+  uint8_t a=src[3];
+  if (!a) return;
+  if (a==0xff) {
+    dst[0]=src[0];
+    dst[1]=src[1];
+    dst[2]=src[2];
+  } else {
+    uint8_t dsta=0xff-a;
+    dst[0]=(dst[0]*dsta+src[0]*a)>>8;
+    dst[1]=(dst[1]*dsta+src[1]*a)>>8;
+    dst[2]=(dst[2]*dsta+src[2]*a)>>8;
+  }
+  dst[3]=0xff;
+}
+
+void ps_sdraw_kernel_over_RGBX_RGBA(uint8_t *dst,const uint8_t *src,int c) {
+
+  #if defined(__SSE2__)
+    /* Four pixels at a time.
+     * (d*(255-a)+s*a) never exceeds 255*255, so unsigned 16-bit lanes hold it.
+     * Fully transparent and fully opaque pixels are selected around the blend, exactly like the scalar path.
+     */
+    const __m128i zero=_mm_setzero_si128();
+    const __m128i amask=_mm_set1_epi32(0xff000000);
+    const __m128i c255=_mm_set1_epi16(0xff);
+    for (;c>=4;c-=4,dst+=16,src+=16) {
+      __m128i s=_mm_loadu_si128((const __m128i*)src);
+      __m128i alpha=_mm_and_si128(s,amask);
+      __m128i transparent=_mm_cmpeq_epi32(alpha,zero);
+      int transparentbits=_mm_movemask_epi8(transparent);
+      if (transparentbits==0xffff) continue;
+      __m128i opaque=_mm_cmpeq_epi32(alpha,amask);
+      if (_mm_movemask_epi8(opaque)==0xffff) {
+        _mm_storeu_si128((__m128i*)dst,s);
+        continue;
+      }
+      __m128i d=_mm_loadu_si128((const __m128i*)dst);
+      __m128i a32=_mm_srli_epi32(s,24);
+      __m128i a2=_mm_or_si128(a32,_mm_slli_epi32(a32,16));
+      __m128i alo=_mm_unpacklo_epi32(a2,a2);
+      __m128i ahi=_mm_unpackhi_epi32(a2,a2);
+      __m128i lo=_mm_add_epi16(
+        _mm_mullo_epi16(_mm_unpacklo_epi8(d,zero),_mm_sub_epi16(c255,alo)),
+        _mm_mullo_epi16(_mm_unpacklo_epi8(s,zero),alo)
+      );
+      __m128i hi=_mm_add_epi16(
+        _mm_mullo_epi16(_mm_unpackhi_epi8(d,zero),_mm_sub_epi16(c255,ahi)),
+        _mm_mullo_epi16(_mm_unpackhi_epi8(s,zero),ahi)
+      );
+      __m128i blend=_mm_or_si128(_mm_packus_epi16(_mm_srli_epi16(lo,8),_mm_srli_epi16(hi,8)),amask);
+      blend=_mm_or_si128(_mm_and_si128(opaque,s),_mm_andnot_si128(opaque,blend));
+      if (transparentbits) {
+        blend=_mm_or_si128(_mm_and_si128(transparent,d),_mm_andnot_si128(transparent,blend));
+      }
+      _mm_storeu_si128((__m128i*)dst,blend);
+    }
+  #endif
+
+  for (;c-->0;dst+=4,src+=4) ps_sdraw_kernel_over_1(dst,src);
+}
+
+/* Solid color with A mask over RGBX.
+ */
+
+void ps_sdraw_kernel_tint_RGBX_A(uint8_t *dst,const uint8_t *src,int c,uint8_t r,uint8_t g,uint8_t b,int ka) {
+  int rpm=0,gpm=0,bpm=0,pma=-1;
+  for (;c-->0;dst+=4,src++) {
+    uint8_t a=((*src)*ka)>>8;
+    if (!a) continue;
+    if (a==0xff) {
+      dst[0]=r;
+      dst[1]=g;
+      dst[2]=b;
+    } else {
+      // Runs of the same alpha are common at glyph edges and interiors.
+      if (a!=pma) {
+        pma=a;
+        rpm=r*a;
+        gpm=g*a;
+        bpm=b*a;
+      }
+      uint8_t dsta=0xff-a;
+      dst[0]=(dst[0]*dsta+rpm)>>8;
+      dst[1]=(dst[1]*dsta+gpm)>>8;
+      dst[2]=(dst[2]*dsta+bpm)>>8;
+    }
+    dst[3]=0xff;
+  }
+}
+
+/* Maxtile color effects.
+ */
+
+void ps_sdraw_kernel_shade_maxtile(uint8_t *v,int c,const struct akgl_vtx_maxtile *vtx) {
+  int pr=vtx->pr,pg=vtx->pg,pb=vtx->pb;
+  int ta=vtx->ta,inv=0xff-ta;
+  int trpm=vtx->tr*ta;
+  int tgpm=vtx->tg*ta;
+  int tbpm=vtx->tb*ta;
+  int alpha=vtx->a;
+  for (;c-->0;v+=4) {
+    if (!v[3]) continue;
+
+    /* Primary color. */
+    int level=v[0];
+    if (level&&(level!=0xff)&&(level==v[1])&&(level==v[2])) {
+      if (level<0x80) {
+        v[0]=(pr*level)>>7;
+        v[1]=(pg*level)>>7;
+        v[2]=(pb*level)>>7;
+      } else {
+        level-=0x80;
+        v[0]=pr+(((255-pr)*level)>>7);
+        v[1]=pg+(((255-pg)*level)>>7);
+        v[2]=pb+(((255-pb)*level)>>7);
+      }
+    }
+
+    /* Tint. */
+    if (ta) {
+      v[0]=(v[0]*inv+trpm)>>8;
+      v[1]=(v[1]*inv+tgpm)>>8;
+      v[2]=(v[2]*inv+tbpm)>>8;
+    }
+
+    /* Alpha. */
+    if (alpha!=0xff) {
+      v[3]=(v[3]*alpha)>>8;
+    }
+  }
+}
@@ -0,0 +1,35 @@
+/* ps_sdraw_kernel.h
+ * Pixel loops specialized for the format pairs we actually draw with: RGBA sprites and A text onto an RGBX framebuffer.
+ * Each produces exactly what the generic pxrd/pxwr path would.
+ * Private to sdraw.
+ */
+
+#ifndef PS_SDRAW_KERNEL_H
+#define PS_SDRAW_KERNEL_H
+
+struct akgl_vtx_maxtile;
+
+/* Nonzero to use the kernels where they apply (default).
+ */
+extern int ps_sdraw_kernels_enabled;
+
+/* Longest run of pixels any kernel is asked to handle at once.
+ * Callers working through scratch rows process longer rows in chunks.
+ */
+#define PS_SDRAW_KERNEL_CHUNK 256
+
+/* Blend (c) packed RGBA pixels onto an RGBX row, as pxwr_RGBX does.
+ * Vectorized where SSE2 is available.
+ */
+void ps_sdraw_kernel_over_RGBX_RGBA(uint8_t *dst,const uint8_t *src,int c);
+
+/* Blend (c) pixels of solid (r,g,b) onto an RGBX row, alpha from an A row multiplied by (ka).
+ * (ka) 0x100 takes the source alpha verbatim.
+ */
+void ps_sdraw_kernel_tint_RGBX_A(uint8_t *dst,const uint8_t *src,int c,uint8_t r,uint8_t g,uint8_t b,int ka);
+
+/* Apply primary color, tint, and alpha from (vtx) to (c) packed RGBA pixels in place.
+ */
+void ps_sdraw_kernel_shade_maxtile(uint8_t *v,int c,const struct akgl_vtx_maxtile *vtx);
+
+#endif
@@ -0,0 +1,128 @@
+#include "test/ps_test.h"
+#include "akau/akau.h"
+
+/* Period policy alone.
+ */
+
+PS_TEST(test_akau_period_init,akau) {
+  struct akau_period period={0};
+  PS_ASSERT_FAILURE(akau_period_init(&period,0,0,0))
+
+  PS_ASSERT_CALL(akau_period_init(&period,44100,0,0))
+  PS_ASSERT_INTS(period.period,AKAU_PERIOD_DEFAULT)
+  PS_ASSERT_INTS(period.min,AKAU_PERIOD_DEFAULT)
+  PS_ASSERT_INTS(period.periodc,AKAU_PERIOD_COUNT)
+  PS_ASSERT_INTS(akau_period_get_latency_us(&period),46439) // 2048 frames, same as before low-latency mode existed
+
+  PS_ASSERT_CALL(akau_period_init(&period,44100,1,0))
+  PS_ASSERT_INTS(period.period,AKAU_PERIOD_LOW_LATENCY)
+  PS_ASSERT_INTS(period.min,AKAU_PERIOD_MIN)
+
+  PS_ASSERT_CALL(akau_period_init(&period,44100,1,100))
+  PS_ASSERT_INTS(period.period,128)
+  PS_ASSERT_CALL(akau_period_init(&period,44100,1,1))
+  PS_ASSERT_INTS(period.period,AKAU_PERIOD_MIN)
+  PS_ASSERT_CALL(akau_period_init(&period,44100,1,100000))
+  PS_ASSERT_INTS(period.period,AKAU_PERIOD_MAX)
+
+  return 0;
+}
+
+PS_TEST(test_akau_period_adapt,akau) {
+  struct akau_period period={0};
+  PS_ASSERT_CALL(akau_period_init(&period,44100,1,64))
+  int i,shrink_after;
+
+  /* Underrun doubles, and waits twice as long before shrinking. */
+  shrink_after=period.shrink_after;
+  PS_ASSERT_INTS(akau_period_xrun(&period),1)
+  PS_ASSERT_INTS(period.period,128)
+  PS_ASSERT_INTS(period.xrunc,1)
+  PS_ASSERT_INTS(period.shrink_after,shrink_after*2)
+
+  /* A clean stretch halves again. */
+  for (i=1;i<period.shrink_after;i++) PS_ASSERT_INTS(akau_period_ok(&period),0)
+  PS_ASSERT_INTS(akau_period_ok(&period),1)
+  PS_ASSERT_INTS(period.period,64)
+
+  /* Not below the minimum. */
+  PS_ASSERT_CALL(akau_period_init(&period,44100,1,AKAU_PERIOD_MIN))
+  for (i=0;i<period.shrink_after;i++) PS_ASSERT_INTS(akau_period_ok(&period),0)
+  PS_ASSERT_INTS(period.period,AKAU_PERIOD_MIN)
+
+  /* Not above the maximum, but underruns still count. */
+  PS_ASSERT_CALL(akau_period_init(&period,44100,1,AKAU_PERIOD_MAX))
+  PS_ASSERT_INTS(akau_period_xrun(&period),0)
+  PS_ASSERT_INTS(period.period,AKAU_PERIOD_MAX)
+  PS_ASSERT_INTS(period.xrunc,1)
+
+  /* Normal mode grows, then comes back to where it started and no further. */
+  PS_ASSERT_CALL(akau_period_init(&period,44100,0,0))
+  PS_ASSERT_INTS(akau_period_xrun(&period),1)
+  PS_ASSERT_INTS(period.period,AKAU_PERIOD_DEFAULT*2)
+  for (i=0;i<period.shrink_after*2;i++) akau_period_ok(&period);
+  PS_ASSERT_INTS(period.period,AKAU_PERIOD_DEFAULT)
+
+  return 0;
+}
+
+/* Simulate a machine that can't keep up below some period size.
+ * Low-latency mode should settle at it, and probe below it ever more rarely.
+ * 2M periods of 512 frames is about six hours.
+ */
+
+PS_TEST(test_akau_period_settles,akau) {
+  struct akau_period period={0};
+  PS_ASSERT_CALL(akau_period_init(&period,44100,1,0))
+  const int tolerable=512;
+  int i,changec=0;
+  for (i=0;i<2000000;i++) {
+    int change;
+    if (period.period<tolerable) change=akau_period_xrun(&period);
+    else change=akau_period_ok(&period);
+    if (change) changec++;
+  }
+  PS_ASSERT_INTS(period.period,tolerable)
+  PS_ASSERT_INTS_OP(changec,<,40)
+  PS_ASSERT_INTS_OP(period.xrunc,<,20)
+  return 0;
+}
+
+/* Driver status passes through akau.
+ */
+
+static int test_akau_period_driver_init(const char *device,int rate,int chanc,akau_cb_fn cb) { return 0; }
+static void test_akau_period_driver_quit() {}
+static int test_akau_period_driver_lock() { return 0; }
+static int test_akau_period_driver_unlock() { return 0; }
+static int test_akau_period_driver_get_status(struct akau_driver_status *status) {
+  status->period=256;
+  status->latency_us=11609;
+  status->xrunc=3;
+  return 0;
+}
+
+PS_TEST(test_akau_driver_status,akau) {
+  struct akau_driver driver={
+    .init=test_akau_period_driver_init,
+    .quit=test_akau_period_driver_quit,
+    .lock=test_akau_period_driver_lock,
+    .unlock=test_akau_period_driver_unlock,
+  };
+  struct akau_driver_status status={0};
+
+  akau_quit();
+  PS_ASSERT_FAILURE(akau_get_driver_status(&status))
+  PS_ASSERT_CALL(akau_init(&driver,0,0,44100,2))
+  PS_ASSERT_FAILURE(akau_get_driver_status(&status))
+  akau_quit();
+
+  driver.get_status=test_akau_period_driver_get_status;
+  PS_ASSERT_CALL(akau_init(&driver,0,0,44100,2))
+  PS_ASSERT_CALL(akau_get_driver_status(&status))
+  PS_ASSERT_INTS(status.period,256)
+  PS_ASSERT_INTS(status.latency_us,11609)
+  PS_ASSERT_INTS(status.xrunc,3)
+  akau_quit();
+  return 0;
+}
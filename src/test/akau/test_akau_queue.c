@@ -0,0 +1,145 @@
+#include "test/ps_test.h"
+#include "akau/akau.h"
+#include "akau/internal/akau_ring.h"
+#include <pthread.h>
+
+/* Ring buffer alone.
+ */
+
+PS_TEST(test_akau_ring_fifo,akau) {
+  struct akau_ring ring={0};
+  PS_ASSERT_FAILURE(akau_ring_init(&ring,sizeof(int),6))
+  PS_ASSERT_CALL(akau_ring_init(&ring,sizeof(int),4))
+  int i,v;
+
+  /* Run the indices around several times. */
+  for (i=0;i<10;i++) {
+    int a=i*3,b=i*3+1,c=i*3+2;
+    PS_ASSERT_CALL(akau_ring_push(&ring,&a))
+    PS_ASSERT_CALL(akau_ring_push(&ring,&b))
+    PS_ASSERT_CALL(akau_ring_push(&ring,&c))
+    PS_ASSERT_INTS(akau_ring_count(&ring),3)
+    PS_ASSERT_INTS(akau_ring_pop(&v,&ring),1) PS_ASSERT_INTS(v,a)
+    PS_ASSERT_INTS(akau_ring_pop(&v,&ring),1) PS_ASSERT_INTS(v,b)
+    PS_ASSERT_INTS(akau_ring_pop(&v,&ring),1) PS_ASSERT_INTS(v,c)
+    PS_ASSERT_INTS(akau_ring_pop(&v,&ring),0)
+  }
+
+  /* Full. */
+  for (i=0;i<4;i++) PS_ASSERT_CALL(akau_ring_push(&ring,&i))
+  PS_ASSERT_FAILURE(akau_ring_push(&ring,&i))
+  PS_ASSERT_INTS(akau_ring_pop(&v,&ring),1) PS_ASSERT_INTS(v,0)
+  PS_ASSERT_CALL(akau_ring_push(&ring,&i))
+
+  akau_ring_cleanup(&ring);
+  return 0;
+}
+
+#define TEST_AKAU_RING_COUNT 200000
+
+static void *test_akau_ring_producer(void *arg) {
+  struct akau_ring *ring=arg;
+  int i=0; while (i<TEST_AKAU_RING_COUNT) {
+    if (akau_ring_push(ring,&i)>=0) i++;
+  }
+  return 0;
+}
+
+PS_TEST(test_akau_ring_threads,akau) {
+  struct akau_ring ring={0};
+  PS_ASSERT_CALL(akau_ring_init(&ring,sizeof(int),16))
+  pthread_t thread;
+  PS_ASSERT_NOT(pthread_create(&thread,0,test_akau_ring_producer,&ring))
+  int expect=0,v;
+  while (expect<TEST_AKAU_RING_COUNT) {
+    if (akau_ring_pop(&v,&ring)<=0) continue;
+    PS_ASSERT_INTS(v,expect)
+    expect++;
+  }
+  pthread_join(thread,0);
+  PS_ASSERT_INTS(akau_ring_count(&ring),0)
+  akau_ring_cleanup(&ring);
+  return 0;
+}
+
+/* Global queue, with a driver that only runs the callback when we tell it to.
+ */
+
+static akau_cb_fn test_akau_queue_cb=0;
+static int test_akau_queue_lockc=0;
+
+static int test_akau_queue_init(const char *device,int rate,int chanc,akau_cb_fn cb) {
+  test_akau_queue_cb=cb;
+  return 0;
+}
+static void test_akau_queue_quit() { test_akau_queue_cb=0; }
+static int test_akau_queue_lock() { test_akau_queue_lockc++; return 0; }
+static int test_akau_queue_unlock() { return 0; }
+
+static const struct akau_driver test_akau_queue_driver={
+  .init=test_akau_queue_init,
+  .quit=test_akau_queue_quit,
+  .lock=test_akau_queue_lock,
+  .unlock=test_akau_queue_unlock,
+};
+
+static int test_akau_queue_sync_tokenc=0;
+
+static int test_akau_queue_cb_sync(uint16_t token,void *userdata) {
+  test_akau_queue_sync_tokenc++;
+  return 0;
+}
+
+PS_TEST(test_akau_queue_commands,akau) {
+  akau_quit();
+  PS_ASSERT_CALL(akau_init(&test_akau_queue_driver,0,0,44100,2))
+  PS_ASSERT(test_akau_queue_cb)
+  struct akau_mixer *mixer=akau_get_mixer();
+  PS_ASSERT_CALL(akau_mixer_set_print_songs(mixer,0))
+
+  struct akau_ipcm *ipcm=akau_ipcm_new(44100);
+  PS_ASSERT(ipcm)
+  PS_ASSERT_CALL(akau_store_add_ipcm(akau_get_store(),ipcm,1))
+  int16_t buf[512];
+
+  /* Nothing happens until the callback runs, and nobody takes the lock. */
+  test_akau_queue_lockc=0;
+  PS_ASSERT_CALL(akau_play_sound(1,0x80,0))
+  PS_ASSERT_CALL(akau_set_trim_for_intent(AKAU_INTENT_SFX,0x40))
+  PS_ASSERT_INTS(akau_get_trim_for_intent(AKAU_INTENT_SFX),0x40)
+  PS_ASSERT_INTS(akau_mixer_count_channels(mixer),0)
+  PS_ASSERT_INTS(test_akau_queue_lockc,0)
+  test_akau_queue_cb(buf,512);
+  PS_ASSERT_INTS(akau_mixer_count_channels(mixer),1)
+  PS_ASSERT_INTS(akau_mixer_get_trim_for_intent(mixer,AKAU_INTENT_SFX),0x40)
+
+  /* Overflow the queue and we fall back to the lock, executing everything in order. */
+  PS_ASSERT_CALL(akau_mixer_stop_all(mixer,0))
+  test_akau_queue_cb(buf,512);
+  int i=0; for (;i<300;i++) {
+    PS_ASSERT_CALL(akau_set_trim_for_intent(AKAU_INTENT_SFX,i&0xff))
+  }
+  PS_ASSERT_INTS_OP(test_akau_queue_lockc,>,0)
+  test_akau_queue_cb(buf,512);
+  PS_ASSERT_INTS(akau_mixer_get_trim_for_intent(mixer,AKAU_INTENT_SFX),299&0xff)
+
+  /* Disable queueing and it's immediate again. */
+  PS_ASSERT_CALL(akau_set_queue_commands(0))
+  PS_ASSERT_CALL(akau_set_trim_for_intent(AKAU_INTENT_SFX,0x33))
+  PS_ASSERT_INTS(akau_mixer_get_trim_for_intent(mixer,AKAU_INTENT_SFX),0x33)
+  PS_ASSERT_CALL(akau_set_queue_commands(1))
+
+  /* Sync tokens come back during akau_update(). */
+  PS_ASSERT_INTS_OP(akau_watch_sync_tokens(test_akau_queue_cb_sync,0,0),>,0)
+  test_akau_queue_sync_tokenc=0;
+  PS_ASSERT_CALL(akau_queue_sync_token(1))
+  PS_ASSERT_CALL(akau_queue_sync_token(2))
+  PS_ASSERT_INTS(test_akau_queue_sync_tokenc,0)
+  PS_ASSERT_CALL(akau_update())
+  PS_ASSERT_INTS(test_akau_queue_sync_tokenc,2)
+
+  /* Quit with commands pending doesn't leak or crash. */
+  PS_ASSERT_CALL(akau_play_sound(1,0x80,0))
+  akau_quit();
+  return 0;
+}
@@ -0,0 +1,229 @@
+#include "test/ps_test.h"
+#include "akau/akau.h"
+#include "akau/akau_mixer.h"
+#include "akau/akau_instrument.h"
+#include "akau/akau_pcm.h"
+#include <math.h>
+
+/* Sounds for the mixer to chew on.
+ * Instruments have a mix of short and long envelopes, so notes cross phase boundaries inside and between blocks.
+ * IPCMs are loud noise, some looping with loop points, some looping whole, some one-shot.
+ */
+
+#define TEST_MIXER_INSTRUMENT_COUNT 3
+#define TEST_MIXER_IPCM_COUNT 4
+#define TEST_MIXER_CHANID_LIMIT 64
+
+struct test_mixer_sounds {
+  struct akau_instrument *instrumentv[TEST_MIXER_INSTRUMENT_COUNT];
+  struct akau_ipcm *ipcmv[TEST_MIXER_IPCM_COUNT];
+  int loopv[TEST_MIXER_IPCM_COUNT];
+};
+
+static struct akau_instrument *test_mixer_new_instrument(int attack,int drawback,int decay) {
+  struct akau_fpcm *fpcm=akau_fpcm_new(1000);
+  if (!fpcm) return 0;
+  double *v=akau_fpcm_get_sample_buffer(fpcm);
+  int i=0; for (;i<1000;i++) v[i]=sin((i*M_PI*2.0)/1000.0)+0.3*sin((i*M_PI*6.0)/1000.0);
+  struct akau_instrument *instrument=akau_instrument_new(fpcm,attack,0.9,drawback,0.5,decay);
+  akau_fpcm_del(fpcm);
+  return instrument;
+}
+
+static struct akau_ipcm *test_mixer_new_ipcm(int c,int loopa,int loopz) {
+  struct akau_ipcm *ipcm=akau_ipcm_new(c);
+  if (!ipcm) return 0;
+  int16_t *v=akau_ipcm_get_sample_buffer(ipcm);
+  int i=0; for (;i<c;i++) v[i]=(rand()&0xffff)-0x8000;
+  if (loopz>loopa) {
+    if (akau_ipcm_set_loop(ipcm,loopa,loopz)<0) {
+      akau_ipcm_del(ipcm);
+      return 0;
+    }
+  }
+  return ipcm;
+}
+
+static int test_mixer_sounds_init(struct test_mixer_sounds *sounds) {
+  memset(sounds,0,sizeof(struct test_mixer_sounds));
+  if (!(sounds->instrumentv[0]=test_mixer_new_instrument(0,0,0))) return -1;
+  if (!(sounds->instrumentv[1]=test_mixer_new_instrument(100,300,500))) return -1;
+  if (!(sounds->instrumentv[2]=test_mixer_new_instrument(3000,2000,9000))) return -1;
+  if (!(sounds->ipcmv[0]=test_mixer_new_ipcm(700,0,0))) return -1;
+  if (!(sounds->ipcmv[1]=test_mixer_new_ipcm(5000,1200,3100))) return -1;
+  if (!(sounds->ipcmv[2]=test_mixer_new_ipcm(333,0,0))) return -1;
+  if (!(sounds->ipcmv[3]=test_mixer_new_ipcm(2000,0,2000))) return -1;
+  sounds->loopv[1]=1;
+  sounds->loopv[2]=1; // No loop points: loops whole.
+  sounds->loopv[3]=1;
+  return 0;
+}
+
+static void test_mixer_sounds_cleanup(struct test_mixer_sounds *sounds) {
+  int i;
+  for (i=0;i<TEST_MIXER_INSTRUMENT_COUNT;i++) akau_instrument_del(sounds->instrumentv[i]);
+  for (i=0;i<TEST_MIXER_IPCM_COUNT;i++) akau_ipcm_del(sounds->ipcmv[i]);
+}
+
+static int8_t test_mixer_random_pan() {
+  switch (rand()%10) {
+    case 0: return -128;
+    case 1: return 127;
+    case 2: return 0;
+    case 3: return -1;
+    case 4: return 1;
+    case 5: return -127;
+  }
+  return (rand()&0xff)-0x80;
+}
+
+static uint8_t test_mixer_random_trim() {
+  switch (rand()%5) {
+    case 0: return 0xff;
+    case 1: return 0;
+  }
+  return rand()&0xff;
+}
+
+/* Apply one random operation to both mixers.
+ * They must agree on the result, including which channel ID it produced.
+ */
+
+static int test_mixer_random_op(
+  struct akau_mixer *a,struct akau_mixer *b,
+  struct test_mixer_sounds *sounds,
+  int *chanidv,int *chanidc
+) {
+  int ra=0,rb=0;
+  switch (rand()%12) {
+
+    case 0: case 1: case 2: {
+        struct akau_instrument *instrument=sounds->instrumentv[rand()%TEST_MIXER_INSTRUMENT_COUNT];
+        uint8_t pitch=20+rand()%80,trim=test_mixer_random_trim();
+        int8_t pan=test_mixer_random_pan();
+        int duration=1+rand()%20000;
+        uint8_t intent=rand()%4;
+        ra=akau_mixer_play_note(a,instrument,pitch,trim,pan,duration,intent);
+        rb=akau_mixer_play_note(b,instrument,pitch,trim,pan,duration,intent);
+        if ((ra>0)&&(*chanidc<TEST_MIXER_CHANID_LIMIT)) chanidv[(*chanidc)++]=ra;
+      } break;
+
+    case 3: case 4: {
+        int ipcmp=rand()%TEST_MIXER_IPCM_COUNT;
+        uint8_t trim=test_mixer_random_trim();
+        int8_t pan=test_mixer_random_pan();
+        uint8_t intent=rand()%4;
+        ra=akau_mixer_play_ipcm(a,sounds->ipcmv[ipcmp],trim,pan,sounds->loopv[ipcmp],intent);
+        rb=akau_mixer_play_ipcm(b,sounds->ipcmv[ipcmp],trim,pan,sounds->loopv[ipcmp],intent);
+        if ((ra>0)&&(*chanidc<TEST_MIXER_CHANID_LIMIT)) chanidv[(*chanidc)++]=ra;
+      } break;
+
+    case 5: case 6: case 7: if (*chanidc) {
+        int chanid=chanidv[rand()%(*chanidc)];
+        uint8_t pitch=20+rand()%80,trim=test_mixer_random_trim();
+        int8_t pan=test_mixer_random_pan();
+        int duration=(rand()&1)?0:(rand()%3000);
+        ra=akau_mixer_adjust_channel(a,chanid,pitch,trim,pan,duration);
+        rb=akau_mixer_adjust_channel(b,chanid,pitch,trim,pan,duration);
+      } break;
+
+    case 8: if (*chanidc) {
+        int chanid=chanidv[rand()%(*chanidc)];
+        ra=akau_mixer_stop_channel(a,chanid);
+        rb=akau_mixer_stop_channel(b,chanid);
+      } break;
+
+    case 9: {
+        uint8_t intent=rand()%4,trim;
+        switch (rand()%3) {
+          case 0: trim=0; break;
+          case 1: trim=0xff; break;
+          default: trim=rand()&0xff;
+        }
+        ra=akau_mixer_set_trim_for_intent(a,intent,trim);
+        rb=akau_mixer_set_trim_for_intent(b,intent,trim);
+      } break;
+
+    case 10: if (!(rand()%4)) {
+        int duration=rand()%2000;
+        ra=akau_mixer_stop_all(a,duration);
+        rb=akau_mixer_stop_all(b,duration);
+      } break;
+
+    case 11: if (!(rand()%4)) {
+        uint8_t intent=rand()%4;
+        int duration=rand()%2000;
+        ra=akau_mixer_stop_by_intent(a,intent,duration);
+        rb=akau_mixer_stop_by_intent(b,intent,duration);
+      } break;
+
+  }
+  PS_ASSERT_INTS(ra,rb)
+  return 0;
+}
+
+/* Block mixing must produce exactly the same output as per-frame mixing.
+ * We drive both through the same random script, in stereo and mono, with awkward buffer sizes.
+ */
+
+PS_TEST(test_mixer_block_matches_per_frame,akau,mixer) {
+  struct test_mixer_sounds sounds;
+  srand(1234);
+  PS_ASSERT_CALL(test_mixer_sounds_init(&sounds))
+  int16_t *bufa=malloc(sizeof(int16_t)*4096);
+  int16_t *bufb=malloc(sizeof(int16_t)*4096);
+  PS_ASSERT(bufa&&bufb)
+
+  int stereo=2; while (stereo-->0) {
+    struct akau_mixer *a=akau_mixer_new();
+    struct akau_mixer *b=akau_mixer_new();
+    PS_ASSERT(a&&b)
+    PS_ASSERT_CALL(akau_mixer_set_print_songs(a,0))
+    PS_ASSERT_CALL(akau_mixer_set_print_songs(b,0))
+    PS_ASSERT_CALL(akau_mixer_set_stereo(a,stereo))
+    PS_ASSERT_CALL(akau_mixer_set_stereo(b,stereo))
+    PS_ASSERT_CALL(akau_mixer_set_block_mixing(a,1))
+    PS_ASSERT_CALL(akau_mixer_set_block_mixing(b,0))
+    int chanidv[TEST_MIXER_CHANID_LIMIT],chanidc=0;
+    int cliptotal=0;
+
+    int updatec=0; for (;updatec<600;updatec++) {
+      int opc=rand()%4; while (opc-->0) {
+        if (test_mixer_random_op(a,b,&sounds,chanidv,&chanidc)<0) return -1;
+      }
+      if (chanidc>=TEST_MIXER_CHANID_LIMIT) chanidc=0;
+
+      int dstc;
+      switch (rand()%4) {
+        case 0: dstc=2+rand()%8; break;
+        case 1: dstc=512; break;
+        case 2: dstc=514; break; // One frame over a stereo block.
+        default: dstc=2+rand()%4094;
+      }
+      memset(bufa,0,sizeof(int16_t)*4096);
+      memset(bufb,0,sizeof(int16_t)*4096);
+      PS_ASSERT_CALL(akau_mixer_update(bufa,dstc,a))
+      PS_ASSERT_CALL(akau_mixer_update(bufb,dstc,b))
+      PS_ASSERT_INTS(akau_mixer_count_channels(a),akau_mixer_count_channels(b),"update=%d",updatec)
+      int i=0; for (;i<dstc;i++) {
+        PS_ASSERT_INTS(bufa[i],bufb[i],"stereo=%d update=%d sample=%d/%d",stereo,updatec,i,dstc)
+      }
+
+      int al,ar,bl,br;
+      PS_ASSERT_CALL(akau_mixer_get_clip(&al,&ar,a))
+      PS_ASSERT_CALL(akau_mixer_get_clip(&bl,&br,b))
+      PS_ASSERT_INTS(al,bl,"update=%d",updatec)
+      PS_ASSERT_INTS(ar,br,"update=%d",updatec)
+      cliptotal+=al+ar;
+    }
+    PS_ASSERT_INTS_OP(cliptotal,>,0,"We're supposed to exercise clipping too.")
+
+    akau_mixer_del(a);
+    akau_mixer_del(b);
+  }
+
+  free(bufa);
+  free(bufb);
+  test_mixer_sounds_cleanup(&sounds);
+  return 0;
+}
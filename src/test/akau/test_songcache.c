@@ -0,0 +1,275 @@
+#include "test/ps_test.h"
+#include "akau/akau.h"
+#include "akau/akau_songcache.h"
+#include "akau/akau_songprinter.h"
+#include "res/ps_resmgr.h"
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static int ps_songcache_test_silent_init(const char *device,int rate,int chanc,akau_cb_fn cb) { return 0; }
+static void ps_songcache_test_silent_quit() {}
+static int ps_songcache_test_silent_lock() { return 0; }
+static int ps_songcache_test_silent_unlock() { return 0; }
+
+static const struct akau_driver ps_songcache_test_silent_driver={
+  .init=ps_songcache_test_silent_init,
+  .quit=ps_songcache_test_silent_quit,
+  .lock=ps_songcache_test_silent_lock,
+  .unlock=ps_songcache_test_silent_unlock,
+};
+
+/* An editable copy of a song resource, linked to the global store.
+ */
+
+static struct akau_song *ps_songcache_test_copy_song(const struct akau_song *src) {
+  void *serial=0;
+  int serialc=akau_song_encode(&serial,src);
+  if ((serialc<0)||!serial) return 0;
+  struct akau_song *song=akau_song_new();
+  if (!song) return 0;
+  if (
+    (akau_song_decode(song,serial,serialc)<0)||
+    (akau_song_link(song,akau_get_store())<0)
+  ) {
+    akau_song_del(song);
+    song=0;
+  }
+  free(serial);
+  return song;
+}
+
+/* Print with the cache and return a NEW reference to the output.
+ */
+
+static struct akau_ipcm *ps_songcache_test_print(struct akau_song *song,struct akau_songcache *cache) {
+  struct akau_songprinter *printer=akau_songprinter_new(song);
+  if (!printer) return 0;
+  struct akau_ipcm *ipcm=0;
+  uint64_t key;
+  if (
+    (akau_songcache_key(&key,song)>=0)&&
+    (akau_songprinter_set_cache(printer,cache,key)>=0)&&
+    (akau_songprinter_finish(printer)>=0)
+  ) {
+    ipcm=akau_songprinter_get_ipcm(printer);
+    if (akau_ipcm_ref(ipcm)<0) ipcm=0;
+  }
+  akau_songprinter_del(printer);
+  return ipcm;
+}
+
+static struct akau_ipcm *ps_songcache_test_new_ipcm(int samplec,int seed) {
+  struct akau_ipcm *ipcm=akau_ipcm_new(samplec);
+  if (!ipcm) return 0;
+  int16_t *v=akau_ipcm_get_sample_buffer(ipcm);
+  int i=0; for (;i<samplec;i++) v[i]=(i*seed*7919)^(i>>3);
+  return ipcm;
+}
+
+/* Delete our files from a test directory and return how many bytes they were.
+ * With (remove) zero, only measure.
+ */
+
+static int ps_songcache_test_scan_dir(int *filec,const char *path,int remove) {
+  *filec=0;
+  DIR *dir=opendir(path);
+  if (!dir) return 0;
+  int total=0;
+  struct dirent *de;
+  while (de=readdir(dir)) {
+    int namec=0; while (de->d_name[namec]) namec++;
+    if ((namec<8)||memcmp(de->d_name+namec-8,".akaupcm",8)) continue;
+    char subpath[1024];
+    snprintf(subpath,sizeof(subpath),"%s/%s",path,de->d_name);
+    struct stat st;
+    if (stat(subpath,&st)<0) continue;
+    total+=st.st_size;
+    (*filec)++;
+    if (remove) unlink(subpath);
+  }
+  closedir(dir);
+  return total;
+}
+
+/* Editing a song, or anything it's linked to, must change its key and miss the cache.
+ * Putting it back the way it was must hit again.
+ */
+
+PS_TEST(test_songcache_edit_invalidates_entry,akau,songcache) {
+  akau_quit();
+  PS_ASSERT_CALL(akau_init(&ps_songcache_test_silent_driver,0,0,44100,2))
+  ps_resmgr_quit();
+  PS_ASSERT_CALL(ps_resmgr_init("src/data",0))
+
+  struct akau_song *original=ps_res_get(PS_RESTYPE_SONG,1);
+  PS_ASSERT(original)
+  struct akau_song *song=ps_songcache_test_copy_song(original);
+  PS_ASSERT(song)
+  struct akau_songcache *cache=akau_songcache_new();
+  PS_ASSERT(cache)
+
+  uint64_t key,origkey;
+  PS_ASSERT_CALL(akau_songcache_key(&origkey,original))
+  PS_ASSERT_CALL(akau_songcache_key(&key,song))
+  PS_ASSERT(key==origkey,"Identical content must produce identical keys.")
+
+  /* First print goes in the cache. Second comes out of it. */
+  struct akau_ipcm *printed=ps_songcache_test_print(song,cache);
+  PS_ASSERT(printed)
+  PS_ASSERT_INTS(akau_songcache_count_entries(cache),1)
+  PS_ASSERT_INTS(akau_songcache_get_memory_usage(cache),akau_ipcm_get_sample_count(printed)*2)
+  struct akau_songprinter *printer=akau_songprinter_new(song);
+  PS_ASSERT(printer)
+  PS_ASSERT_CALL(akau_songprinter_set_cache(printer,cache,key))
+  PS_ASSERT_CALL(akau_songprinter_begin(printer))
+  PS_ASSERT_INTS(akau_songprinter_get_progress(printer),AKAU_SONGPRINTER_PROGRESS_READY,"Cache hit must be ready immediately.")
+  PS_ASSERT(akau_songprinter_get_ipcm(printer)==printed)
+  akau_songprinter_del(printer);
+
+  /* Change one note's trim. */
+  int cmdc=akau_song_count_commands(song);
+  union akau_song_command cmd;
+  int cmdp=0; for (;cmdp<cmdc;cmdp++) {
+    PS_ASSERT_CALL(akau_song_get_command(&cmd,song,cmdp))
+    if (cmd.op==AKAU_SONG_OP_NOTE) break;
+  }
+  PS_ASSERT(cmdp<cmdc,"Expected a note in song 1.")
+  uint8_t trim0=cmd.NOTE.trim;
+  cmd.NOTE.trim=trim0^0x40;
+  PS_ASSERT_CALL(akau_song_set_command(song,cmdp,&cmd))
+  uint64_t editkey;
+  PS_ASSERT_CALL(akau_songcache_key(&editkey,song))
+  PS_ASSERT(editkey!=key)
+  PS_ASSERT_NOT(akau_songcache_get(cache,editkey))
+  struct akau_ipcm *edited=ps_songcache_test_print(song,cache);
+  PS_ASSERT(edited)
+  PS_ASSERT(edited!=printed)
+  PS_ASSERT_INTS(akau_songcache_count_entries(cache),2)
+  PS_ASSERT(memcmp(
+    akau_ipcm_get_sample_buffer(edited),akau_ipcm_get_sample_buffer(printed),akau_ipcm_get_sample_count(printed)*2
+  ),"Edited song printed the same as the original?")
+  akau_ipcm_del(edited);
+
+  /* Change it back. */
+  cmd.NOTE.trim=trim0;
+  PS_ASSERT_CALL(akau_song_set_command(song,cmdp,&cmd))
+  PS_ASSERT_CALL(akau_songcache_key(&editkey,song))
+  PS_ASSERT(editkey==key)
+
+  /* Relink a drum to different samples. The serial form doesn't change, but the key must. */
+  if (akau_song_count_drums(song)>0) {
+    struct akau_store *store=akau_get_store();
+    int ipcmid=akau_song_get_drum_ipcmid(song,0);
+    int i=akau_store_count_ipcm(store),otherid=0;
+    while (i-->0) {
+      int id=akau_store_get_ipcm_id_by_index(store,i);
+      if (id!=ipcmid) { otherid=id; break; }
+    }
+    PS_ASSERT(otherid)
+    PS_ASSERT_CALL(akau_song_set_drum(song,0,otherid))
+    PS_ASSERT_CALL(akau_song_link(song,store))
+    PS_ASSERT_CALL(akau_songcache_key(&editkey,song))
+    PS_ASSERT(editkey!=key)
+    PS_ASSERT_NOT(akau_songcache_get(cache,editkey))
+  }
+
+  akau_ipcm_del(printed);
+  akau_songcache_del(cache);
+  akau_song_del(song);
+  ps_resmgr_quit();
+  akau_quit();
+  return 0;
+}
+
+/* An entry written to disk by one cache can be loaded by another, sample for sample.
+ */
+
+PS_TEST(test_songcache_disk_round_trip,akau,songcache) {
+  const char *path="mid/test/songcache";
+  int filec;
+  ps_songcache_test_scan_dir(&filec,path,1);
+
+  struct akau_ipcm *ipcm=ps_songcache_test_new_ipcm(12345,3);
+  PS_ASSERT(ipcm)
+  PS_ASSERT_CALL(akau_ipcm_set_loop(ipcm,100,12000))
+  struct akau_songcache *writer=akau_songcache_new();
+  PS_ASSERT(writer)
+  PS_ASSERT_CALL(akau_songcache_set_path(writer,path))
+  PS_ASSERT_CALL(akau_songcache_add(writer,0x0123456789abcdefull,ipcm))
+  akau_songcache_del(writer);
+  ps_songcache_test_scan_dir(&filec,path,0);
+  PS_ASSERT_INTS(filec,1)
+
+  struct akau_songcache *reader=akau_songcache_new();
+  PS_ASSERT(reader)
+  PS_ASSERT_CALL(akau_songcache_set_path(reader,path))
+  PS_ASSERT_NOT(akau_songcache_get(reader,0x0123456789abcdefull),"Not in memory until loaded.")
+  PS_ASSERT_INTS(akau_songcache_load(reader,0x0123456789abcdeeull),0)
+  PS_ASSERT_INTS(akau_songcache_load(reader,0x0123456789abcdefull),1)
+  struct akau_ipcm *loaded=akau_songcache_get(reader,0x0123456789abcdefull);
+  PS_ASSERT(loaded)
+  PS_ASSERT_INTS(akau_ipcm_get_sample_count(loaded),12345)
+  PS_ASSERT_INTS(akau_ipcm_get_loop_start(loaded),100)
+  PS_ASSERT_INTS(akau_ipcm_get_loop_end(loaded),12000)
+  PS_ASSERT_NOT(memcmp(akau_ipcm_get_sample_buffer(loaded),akau_ipcm_get_sample_buffer(ipcm),12345*2))
+
+  akau_ipcm_del(loaded);
+  akau_ipcm_del(ipcm);
+  akau_songcache_del(reader);
+  ps_songcache_test_scan_dir(&filec,path,1);
+  return 0;
+}
+
+/* Each tier stays within its limit, and memory drops the least recently used entry first.
+ */
+
+PS_TEST(test_songcache_eviction,akau,songcache) {
+  const char *path="mid/test/songcache-eviction";
+  int filec;
+  ps_songcache_test_scan_dir(&filec,path,1);
+
+  struct akau_ipcm *ipcmv[4];
+  int i; for (i=0;i<4;i++) PS_ASSERT(ipcmv[i]=ps_songcache_test_new_ipcm(1000,i+1))
+  struct akau_songcache *cache=akau_songcache_new();
+  PS_ASSERT(cache)
+  PS_ASSERT_CALL(akau_songcache_set_limits(cache,3*2000,2*(24+2000)+100))
+  PS_ASSERT_CALL(akau_songcache_set_path(cache,path))
+
+  for (i=0;i<3;i++) PS_ASSERT_CALL(akau_songcache_add(cache,i+1,ipcmv[i]))
+  PS_ASSERT_INTS(akau_songcache_count_entries(cache),3)
+  PS_ASSERT_INTS(akau_songcache_get_memory_usage(cache),3*2000)
+
+  /* Touch the oldest, so the second is least recently used when the fourth goes in. */
+  struct akau_ipcm *ipcm=akau_songcache_get(cache,1);
+  PS_ASSERT(ipcm==ipcmv[0])
+  akau_ipcm_del(ipcm);
+  PS_ASSERT_CALL(akau_songcache_add(cache,4,ipcmv[3]))
+  PS_ASSERT_INTS(akau_songcache_count_entries(cache),3)
+  PS_ASSERT_INTS_OP(akau_songcache_get_memory_usage(cache),<=,3*2000)
+  PS_ASSERT_NOT(akau_songcache_get(cache,2))
+  const int keepv[]={1,3,4};
+  for (i=0;i<3;i++) {
+    PS_ASSERT(ipcm=akau_songcache_get(cache,keepv[i]),"key=%d",keepv[i])
+    akau_ipcm_del(ipcm);
+  }
+
+  int total=ps_songcache_test_scan_dir(&filec,path,0);
+  PS_ASSERT_INTS(filec,2)
+  PS_ASSERT_INTS_OP(total,<=,2*(24+2000)+100)
+
+  /* Shrinking the memory limit evicts immediately. Too big to fit at all, it isn't added. */
+  PS_ASSERT_CALL(akau_songcache_set_limits(cache,2000,0))
+  PS_ASSERT_INTS(akau_songcache_count_entries(cache),1)
+  struct akau_ipcm *big=ps_songcache_test_new_ipcm(1001,9);
+  PS_ASSERT(big)
+  PS_ASSERT_CALL(akau_songcache_add(cache,5,big))
+  PS_ASSERT_NOT(akau_songcache_get(cache,5))
+  PS_ASSERT_INTS(akau_songcache_count_entries(cache),1)
+  akau_ipcm_del(big);
+
+  akau_songcache_del(cache);
+  for (i=0;i<4;i++) akau_ipcm_del(ipcmv[i]);
+  ps_songcache_test_scan_dir(&filec,path,1);
+  return 0;
+}
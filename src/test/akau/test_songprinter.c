@@ -147,3 +147,80 @@ PS_TEST(test_songprinter_asynchronous,ignore,songprinter) {
   akau_quit();
   return 0;
 }
+
+/* A driver that never plays anything, so we can load real songs without an audio device.
+ */
+
+static int ps_songprinter_test_silent_init(const char *device,int rate,int chanc,akau_cb_fn cb) { return 0; }
+static void ps_songprinter_test_silent_quit() {}
+static int ps_songprinter_test_silent_lock() { return 0; }
+static int ps_songprinter_test_silent_unlock() { return 0; }
+
+static const struct akau_driver ps_songprinter_test_silent_driver={
+  .init=ps_songprinter_test_silent_init,
+  .quit=ps_songprinter_test_silent_quit,
+  .lock=ps_songprinter_test_silent_lock,
+  .unlock=ps_songprinter_test_silent_unlock,
+};
+
+/* Print a song the old way: Straight through one mixer.
+ */
+
+static struct akau_ipcm *ps_songprinter_test_print_serially(struct akau_song *song,int samplec) {
+  struct akau_ipcm *ipcm=akau_ipcm_new(samplec);
+  struct akau_mixer *mixer=akau_mixer_new();
+  if (!ipcm||!mixer) return 0;
+  if (akau_mixer_set_stereo(mixer,0)<0) return 0;
+  if (akau_mixer_set_print_songs(mixer,0)<0) return 0;
+  if (akau_mixer_play_song(mixer,song,1,0)<0) return 0;
+  if (akau_mixer_update(akau_ipcm_get_sample_buffer(ipcm),samplec,mixer)<0) return 0;
+  akau_mixer_del(mixer);
+  return ipcm;
+}
+
+/* Printing in parallel ranges must produce exactly the same output as one pass, whatever the thread count.
+ */
+
+PS_TEST(test_songprinter_parallel_matches_serial,songprinter) {
+  akau_quit();
+  PS_ASSERT_CALL(akau_init(&ps_songprinter_test_silent_driver,ps_songprinter_test_log,0,44100,2))
+  ps_resmgr_quit();
+  PS_ASSERT_CALL(ps_resmgr_init("src/data",0))
+
+  int songc=0,songid=1; for (;songid<100;songid++) {
+    struct akau_song *song=ps_res_get(PS_RESTYPE_SONG,songid);
+    if (!song) continue;
+    songc++;
+
+    const int threadcv[]={1,3,8};
+    int i=0; for (;i<sizeof(threadcv)/sizeof(int);i++) {
+      struct akau_songprinter *printer=akau_songprinter_new(song);
+      PS_ASSERT(printer)
+      PS_ASSERT_CALL(akau_songprinter_set_thread_count(printer,threadcv[i]))
+      if (i&1) {
+        PS_ASSERT_CALL(akau_songprinter_begin(printer))
+      }
+      PS_ASSERT_CALL(akau_songprinter_finish(printer),"song=%d threads=%d",songid,threadcv[i])
+      struct akau_ipcm *ipcm=akau_songprinter_get_ipcm(printer);
+      PS_ASSERT(ipcm)
+      int samplec=akau_ipcm_get_sample_count(ipcm);
+      PS_ASSERT_INTS(akau_songprinter_get_ready_sample_count(printer),samplec)
+
+      struct akau_ipcm *expect=ps_songprinter_test_print_serially(song,samplec);
+      PS_ASSERT(expect)
+      const int16_t *a=akau_ipcm_get_sample_buffer(expect);
+      const int16_t *b=akau_ipcm_get_sample_buffer(ipcm);
+      int p=0; for (;p<samplec;p++) {
+        PS_ASSERT_INTS(a[p],b[p],"song=%d threads=%d sample=%d/%d",songid,threadcv[i],p,samplec)
+      }
+
+      akau_ipcm_del(expect);
+      akau_songprinter_del(printer);
+    }
+  }
+  PS_ASSERT_INTS_OP(songc,>,1)
+
+  ps_resmgr_quit();
+  akau_quit();
+  return 0;
+}
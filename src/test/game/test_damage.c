@@ -0,0 +1,178 @@
+#include "test/ps_test.h"
+#include "game/ps_game.h"
+#include "game/ps_broadphase.h"
+#include "game/ps_sprite.h"
+
+/* A sprite type that records every hit against it.
+ * Reactions vary by sprite, so the groups change under the damage pass the same ways real sprites make them change.
+ */
+
+#define TEST_DAMAGE_REACTION_NONE     0 /* Take the hit and stay put, like an invincible hero. */
+#define TEST_DAMAGE_REACTION_UNFRAGILE 1 /* Leave FRAGILE, like the default for monsters. */
+#define TEST_DAMAGE_REACTION_VANISH   2 /* Leave every group, like a sprite killed outright. */
+#define TEST_DAMAGE_REACTION_KNOCKBACK 3 /* Move away, so a victim index built before the hit is stale. */
+#define TEST_DAMAGE_REACTION_RECRUIT  4 /* Put some other sprite in FRAGILE, like a blueberry splitting. */
+#define TEST_DAMAGE_REACTION_COUNT    5
+
+#define TEST_DAMAGE_CALL_LIMIT 4096
+
+struct test_damage_sprite {
+  struct ps_sprite hdr;
+  int id;
+  int reaction;
+  uint32_t grpmask; // Membership at the start of the frame.
+  double x0,y0; // Position at the start of the frame.
+};
+
+static struct test_damage_call {
+  int victimid,assailantid;
+} test_damage_callv[TEST_DAMAGE_CALL_LIMIT];
+static int test_damage_callc=0;
+static struct ps_sprgrp *test_damage_all=0;
+
+static int _test_damage_hurt(struct ps_game *game,struct ps_sprite *spr,struct ps_sprite *assailant) {
+  struct test_damage_sprite *SPR=(struct test_damage_sprite*)spr;
+  if (test_damage_callc>=TEST_DAMAGE_CALL_LIMIT) return -1;
+  test_damage_callv[test_damage_callc].victimid=SPR->id;
+  test_damage_callv[test_damage_callc].assailantid=((struct test_damage_sprite*)assailant)->id;
+  test_damage_callc++;
+  switch (SPR->reaction) {
+    case TEST_DAMAGE_REACTION_UNFRAGILE: return ps_sprgrp_remove_sprite(game->grpv+PS_SPRGRP_FRAGILE,spr);
+    case TEST_DAMAGE_REACTION_VANISH: return ps_game_set_group_mask_for_sprite(game,spr,0);
+    case TEST_DAMAGE_REACTION_KNOCKBACK: spr->x+=PS_TILESIZE*2; return 0;
+    case TEST_DAMAGE_REACTION_RECRUIT: {
+        struct ps_sprite *recruit=test_damage_all->sprv[(SPR->id*7)%test_damage_all->sprc];
+        return ps_sprgrp_add_sprite(game->grpv+PS_SPRGRP_FRAGILE,recruit);
+      }
+  }
+  return 0;
+}
+
+static const struct ps_sprtype test_sprtype_damage={
+  .name="test_damage",
+  .objlen=sizeof(struct test_damage_sprite),
+  .radius=PS_TILESIZE>>1,
+  .shape=PS_SPRITE_SHAPE_CIRCLE,
+  .hurt=_test_damage_hurt,
+};
+
+/* Compose a bare-bones game with (sprc) sprites crowded pseudo-randomly into the middle of the screen.
+ * Each sprite picks its groups independently, so plenty are both HAZARD and FRAGILE, or HERO but not FRAGILE.
+ * (all) retains every sprite, so they survive leaving the game's groups.
+ */
+
+static struct ps_game *new_mock_game(struct ps_sprgrp *all,int sprc,unsigned int seed) {
+  struct ps_game *game=calloc(1,sizeof(struct ps_game));
+  if (!game) return 0;
+  int i; for (i=0;i<PS_SPRGRP_COUNT;i++) game->grpv[i].mask=1<<i;
+
+  test_damage_all=all;
+  srand(seed);
+  for (i=0;i<sprc;i++) {
+    struct ps_sprite *spr=ps_sprite_new(&test_sprtype_damage);
+    if (!spr) return 0;
+    struct test_damage_sprite *SPR=(struct test_damage_sprite*)spr;
+    SPR->id=i;
+    SPR->reaction=rand()%TEST_DAMAGE_REACTION_COUNT;
+    spr->x=(PS_SCREENW>>2)+rand()%(PS_SCREENW>>1);
+    spr->y=(PS_SCREENH>>2)+rand()%(PS_SCREENH>>1);
+    spr->radius=2+rand()%16;
+    spr->shape=(rand()&1)?PS_SPRITE_SHAPE_CIRCLE:PS_SPRITE_SHAPE_SQUARE;
+    switch (i%50) { // A few oddballs: huge, and far offscreen.
+      case 7: spr->radius=PS_TILESIZE*3; break;
+      case 13: spr->x=-1000.0; break;
+      case 29: spr->y=PS_SCREENH+1000.0; break;
+    }
+    SPR->x0=spr->x;
+    SPR->y0=spr->y;
+    SPR->grpmask=1<<PS_SPRGRP_KEEPALIVE;
+    if (rand()%3==0) SPR->grpmask|=1<<PS_SPRGRP_HAZARD;
+    if (rand()%2==0) SPR->grpmask|=1<<PS_SPRGRP_FRAGILE;
+    if (rand()%6==0) SPR->grpmask|=1<<PS_SPRGRP_HERO;
+    if (rand()%6==0) SPR->grpmask|=1<<PS_SPRGRP_HEROHAZARD;
+    if (ps_sprgrp_add_sprite(all,spr)<0) return 0;
+    ps_sprite_del(spr);
+  }
+  return game;
+}
+
+static void del_mock_game(struct ps_game *game,struct ps_sprgrp *all) {
+  int i;
+  for (i=PS_SPRGRP_COUNT;i-->0;) ps_sprgrp_cleanup(game->grpv+i);
+  ps_broadphase_del(game->damage_index_fragile);
+  ps_broadphase_del(game->damage_index_hero);
+  free(game);
+  ps_sprgrp_clear(all);
+}
+
+static int reset_mock_game(struct ps_game *game,struct ps_sprgrp *all) {
+  int i; for (i=0;i<all->sprc;i++) {
+    struct test_damage_sprite *SPR=(struct test_damage_sprite*)all->sprv[i];
+    SPR->hdr.x=SPR->x0;
+    SPR->hdr.y=SPR->y0;
+    if (ps_game_set_group_mask_for_sprite(game,all->sprv[i],SPR->grpmask)<0) return -1;
+  }
+  test_damage_callc=0;
+  return 0;
+}
+
+/* The indexed damage pass must deliver exactly the same hits in the same order as the naive one.
+ * For each recorded frame, we run naive, restore everyone's groups, run indexed, and compare.
+ */
+
+PS_TEST(test_damage_index_matches_naive,game) {
+  struct test_damage_call *naivev=malloc(sizeof(test_damage_callv));
+  struct ps_sprgrp *all=ps_sprgrp_new();
+  PS_ASSERT(naivev&&all)
+  int sprc;
+  for (sprc=2;sprc<=400;sprc*=3) {
+    unsigned int seed=sprc*13+5;
+    for (;seed<sprc*13+10;seed++) {
+      struct ps_game *game=new_mock_game(all,sprc,seed);
+      PS_ASSERT(game)
+
+      PS_ASSERT_CALL(reset_mock_game(game,all))
+      PS_ASSERT_CALL(ps_game_enable_damage_index(game,0))
+      PS_ASSERT_NOT(game->damage_index_fragile)
+      PS_ASSERT_CALL(ps_game_check_for_damage(game))
+      int naivec=test_damage_callc;
+      memcpy(naivev,test_damage_callv,sizeof(struct test_damage_call)*naivec);
+
+      PS_ASSERT_CALL(reset_mock_game(game,all))
+      PS_ASSERT_CALL(ps_game_enable_damage_index(game,1))
+      PS_ASSERT(game->damage_index_fragile&&game->damage_index_hero)
+      PS_ASSERT_CALL(ps_game_check_for_damage(game))
+      PS_ASSERT_INTS(naivec,test_damage_callc,"sprc=%d seed=%u",sprc,seed)
+      int i; for (i=0;i<naivec;i++) {
+        PS_ASSERT_INTS(naivev[i].victimid,test_damage_callv[i].victimid,"sprc=%d seed=%u call=%d",sprc,seed,i)
+        PS_ASSERT_INTS(naivev[i].assailantid,test_damage_callv[i].assailantid,"sprc=%d seed=%u call=%d",sprc,seed,i)
+      }
+      if (sprc>=100) PS_ASSERT_INTS_OP(naivec,>,0)
+
+      del_mock_game(game,all);
+    }
+  }
+  ps_sprgrp_del(all);
+  free(naivev);
+  return 0;
+}
+
+/* A sprite that is both HAZARD and FRAGILE must not hurt itself.
+ */
+
+PS_TEST(test_damage_index_no_self_harm,game) {
+  struct ps_sprgrp *all=ps_sprgrp_new();
+  PS_ASSERT(all)
+  struct ps_game *game=new_mock_game(all,300,4242);
+  PS_ASSERT(game)
+  PS_ASSERT_CALL(reset_mock_game(game,all))
+  PS_ASSERT_CALL(ps_game_enable_damage_index(game,1))
+  PS_ASSERT_CALL(ps_game_check_for_damage(game))
+  PS_ASSERT_INTS_OP(test_damage_callc,>,0)
+  int i; for (i=0;i<test_damage_callc;i++) {
+    PS_ASSERT(test_damage_callv[i].victimid!=test_damage_callv[i].assailantid,"call=%d id=%d",i,test_damage_callv[i].victimid)
+  }
+  del_mock_game(game,all);
+  ps_sprgrp_del(all);
+  return 0;
+}
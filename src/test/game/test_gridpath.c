@@ -0,0 +1,133 @@
+#include "test/ps_test.h"
+#include "game/ps_gridpath.h"
+#include "game/ps_path.h"
+#include "scenario/ps_grid.h"
+#include "scenario/ps_blueprint.h"
+#include "util/ps_geometry.h"
+
+#define SOLID_MASK (1<<PS_BLUEPRINT_CELL_SOLID)
+
+/* Every step is one orthogonal move, and every cell in the grid is passable.
+ */
+
+static int validate_path(const struct ps_path *path,const struct ps_grid *grid,int dstx,int dsty,int srcx,int srcy,uint16_t impassable) {
+  PS_ASSERT(path->c>0)
+  PS_ASSERT_INTS(path->v[0].x,srcx)
+  PS_ASSERT_INTS(path->v[0].y,srcy)
+  PS_ASSERT_INTS(path->v[path->c-1].x,dstx)
+  PS_ASSERT_INTS(path->v[path->c-1].y,dsty)
+  int i=0; for (;i<path->c;i++) {
+    const struct ps_path_entry *entry=path->v+i;
+    if ((entry->x>=0)&&(entry->y>=0)&&(entry->x<PS_GRID_COLC)&&(entry->y<PS_GRID_ROWC)) {
+      uint8_t physics=grid->cellv[entry->y*PS_GRID_COLC+entry->x].physics;
+      PS_ASSERT(!((1<<physics)&impassable),"Path enters (%d,%d), physics %d",entry->x,entry->y,physics)
+    }
+    if (i) {
+      int dx=entry->x-entry[-1].x,dy=entry->y-entry[-1].y;
+      PS_ASSERT_INTS(dx*dx+dy*dy,1,"Step %d: (%d,%d) to (%d,%d)",i,entry[-1].x,entry[-1].y,entry->x,entry->y)
+    }
+  }
+  return 0;
+}
+
+PS_TEST(test_gridpath_finds_shortest_path,game) {
+  struct ps_gridpath *gridpath=ps_gridpath_new();
+  PS_ASSERT(gridpath)
+  struct ps_grid *grid=ps_grid_new();
+  PS_ASSERT(grid)
+  struct ps_path path={0};
+
+  /* A wall down column 10 with a gap at the bottom.
+   * The greedy search we used to have goes up first and backtracks; the shortest path is 26 steps.
+   */
+  int row; for (row=0;row<PS_GRID_ROWC-1;row++) grid->cellv[row*PS_GRID_COLC+10].physics=PS_BLUEPRINT_CELL_SOLID;
+  PS_ASSERT_CALL(ps_gridpath_compose(&path,gridpath,grid,15,5,5,5,SOLID_MASK))
+  PS_ASSERT_CALL(validate_path(&path,grid,15,5,5,5,SOLID_MASK))
+  PS_ASSERT_INTS(path.c,27)
+
+  /* A field from the destination agrees, and the next query to the same place follows it. */
+  const uint16_t *distv=ps_gridpath_get_field(gridpath,grid,15,5,SOLID_MASK);
+  PS_ASSERT(distv)
+  PS_ASSERT_INTS(distv[5*PS_GRID_COLC+5],26)
+  PS_ASSERT_INTS(distv[5*PS_GRID_COLC+10],PS_GRIDPATH_UNREACHABLE)
+  PS_ASSERT_INTS(ps_gridpath_field_direction(distv,5,5),PS_DIRECTION_SOUTH)
+  PS_ASSERT_INTS(ps_gridpath_field_direction(distv,15,5),0)
+  PS_ASSERT(ps_gridpath_get_field(gridpath,grid,15,5,SOLID_MASK)==distv)
+  PS_ASSERT_INTS(gridpath->field_buildc,1)
+  int hitc0=gridpath->field_hitc;
+  PS_ASSERT_CALL(ps_gridpath_compose(&path,gridpath,grid,15,5,3,2,SOLID_MASK))
+  PS_ASSERT_CALL(validate_path(&path,grid,15,5,3,2,SOLID_MASK))
+  PS_ASSERT_INTS(path.c,1+distv[2*PS_GRID_COLC+3])
+  PS_ASSERT_INTS(gridpath->field_hitc,hitc0+1)
+
+  /* From offscreen, walk straight in. */
+  PS_ASSERT_CALL(ps_gridpath_compose(&path,gridpath,grid,3,5,-2,5,SOLID_MASK))
+  PS_ASSERT_CALL(validate_path(&path,grid,3,5,-2,5,SOLID_MASK))
+  PS_ASSERT_INTS(path.c,6)
+
+  /* Close the gap: Now there's no path, and the field says so. */
+  grid->cellv[(PS_GRID_ROWC-1)*PS_GRID_COLC+10].physics=PS_BLUEPRINT_CELL_SOLID;
+  ps_gridpath_invalidate(gridpath);
+  PS_ASSERT_FAILURE(ps_gridpath_compose(&path,gridpath,grid,15,5,5,5,SOLID_MASK))
+  PS_ASSERT_INTS(path.c,0)
+  PS_ASSERT((distv=ps_gridpath_get_field(gridpath,grid,15,5,SOLID_MASK)))
+  PS_ASSERT_INTS(distv[5*PS_GRID_COLC+5],PS_GRIDPATH_UNREACHABLE)
+  PS_ASSERT_INTS(ps_gridpath_field_direction(distv,5,5),-1)
+
+  /* Impassable endpoints. */
+  PS_ASSERT_FAILURE(ps_gridpath_compose(&path,gridpath,grid,10,5,5,5,SOLID_MASK))
+  PS_ASSERT(!ps_gridpath_get_field(gridpath,grid,10,5,SOLID_MASK))
+  PS_ASSERT_CALL(ps_gridpath_compose(&path,gridpath,grid,10,5,5,5,0))
+
+  ps_path_cleanup(&path);
+  ps_grid_del(grid);
+  ps_gridpath_del(gridpath);
+  return 0;
+}
+
+/* On random grids, A* always agrees with a breadth-first field about the length of the shortest path.
+ */
+
+PS_TEST(test_gridpath_matches_field_on_random_grids,game) {
+  struct ps_gridpath *gridpath=ps_gridpath_new();
+  PS_ASSERT(gridpath)
+  struct ps_grid *grid=ps_grid_new();
+  PS_ASSERT(grid)
+  struct ps_path path={0};
+  int foundc=0,missc=0;
+
+  srand(1234);
+  int trial=0; for (;trial<50;trial++) {
+    int i=0; for (;i<PS_GRID_SIZE;i++) {
+      grid->cellv[i].physics=(rand()%10<3)?PS_BLUEPRINT_CELL_SOLID:PS_BLUEPRINT_CELL_VACANT;
+    }
+    ps_gridpath_invalidate(gridpath);
+    for (i=0;i<20;i++) {
+      int srcx=rand()%PS_GRID_COLC,srcy=rand()%PS_GRID_ROWC;
+      int dstx=rand()%PS_GRID_COLC,dsty=rand()%PS_GRID_ROWC;
+      grid->cellv[srcy*PS_GRID_COLC+srcx].physics=PS_BLUEPRINT_CELL_VACANT;
+      grid->cellv[dsty*PS_GRID_COLC+dstx].physics=PS_BLUEPRINT_CELL_VACANT;
+      ps_gridpath_invalidate(gridpath);
+      int err=ps_gridpath_compose(&path,gridpath,grid,dstx,dsty,srcx,srcy,SOLID_MASK);
+      const uint16_t *distv=ps_gridpath_get_field(gridpath,grid,dstx,dsty,SOLID_MASK);
+      PS_ASSERT(distv)
+      uint16_t dist=distv[srcy*PS_GRID_COLC+srcx];
+      if (dist==PS_GRIDPATH_UNREACHABLE) {
+        PS_ASSERT(err<0,"trial %d: (%d,%d) to (%d,%d)",trial,srcx,srcy,dstx,dsty)
+        missc++;
+      } else {
+        PS_ASSERT_CALL(err,"trial %d: (%d,%d) to (%d,%d)",trial,srcx,srcy,dstx,dsty)
+        PS_ASSERT_CALL(validate_path(&path,grid,dstx,dsty,srcx,srcy,SOLID_MASK))
+        PS_ASSERT_INTS(path.c,dist+1,"trial %d: (%d,%d) to (%d,%d)",trial,srcx,srcy,dstx,dsty)
+        foundc++;
+      }
+    }
+  }
+  PS_ASSERT(foundc>0)
+  PS_ASSERT(missc>0)
+
+  ps_path_cleanup(&path);
+  ps_grid_del(grid);
+  ps_gridpath_del(gridpath);
+  return 0;
+}
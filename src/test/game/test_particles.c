@@ -0,0 +1,125 @@
+#include "test/ps_test.h"
+#include "game/ps_particles.h"
+#include "akgl/akgl.h"
+
+/* Motion, expiry, and the derived alpha/size/color.
+ */
+
+PS_TEST(test_particles_update_and_compose,game) {
+  struct ps_particles *particles=ps_particles_new();
+  PS_ASSERT(particles)
+
+  struct ps_particle particle={
+    .x=100.0,
+    .y=50.0,
+    .dx=2.0,
+    .dy=-1.0,
+    .ttl=10,
+    .tsid=4,
+    .tileid=0x0a,
+    .t=0x10,
+    .dt=0x0180,
+    .size=20,
+    .shrink=5,
+    .rgba=0xff000000,
+    .rgbz=0x00ff0000,
+    .fadein=2,
+    .fadeout=4,
+  };
+  PS_ASSERT_INTS(ps_particles_add(particles,&particle),1)
+  particle.ttl=3;
+  particle.tsid=5;
+  PS_ASSERT_INTS(ps_particles_add(particles,&particle),1)
+  particle.ttl=0;
+  PS_ASSERT_INTS(ps_particles_add(particles,&particle),0)
+  PS_ASSERT_INTS(particles->c,2)
+
+  /* Fresh: fully transparent, full size, initial color. */
+  struct akgl_vtx_maxtile *vtxv=0;
+  PS_ASSERT_INTS(ps_particles_compose(&vtxv,particles,4,0,0,0),1)
+  PS_ASSERT_INTS(vtxv[0].x,100)
+  PS_ASSERT_INTS(vtxv[0].y,50)
+  PS_ASSERT_INTS(vtxv[0].tileid,0x0a)
+  PS_ASSERT_INTS(vtxv[0].t,0x10)
+  PS_ASSERT_INTS(vtxv[0].a,0)
+  PS_ASSERT_INTS(vtxv[0].size,20)
+  PS_ASSERT_INTS(vtxv[0].pr,0xff)
+  PS_ASSERT_INTS(vtxv[0].pg,0x00)
+
+  /* Three frames: the short one expires, the other moves. */
+  int i=3; while (i-->0) PS_ASSERT_CALL(ps_particles_update(particles))
+  PS_ASSERT_INTS(particles->c,1)
+  PS_ASSERT_INTS(ps_particles_compose(&vtxv,particles,5,0,0,0),0)
+  PS_ASSERT_INTS(ps_particles_compose(&vtxv,particles,4,0,-10,20),1)
+  PS_ASSERT_INTS(vtxv[0].x,96)
+  PS_ASSERT_INTS(vtxv[0].y,67)
+  PS_ASSERT_INTS(vtxv[0].t,0x14)
+  PS_ASSERT_INTS(vtxv[0].a,0xff)
+  PS_ASSERT_INTS(vtxv[0].size,20)
+  PS_ASSERT_INTS(vtxv[0].pr,0xff-(0xff*3)/10)
+
+  /* Near the end, fading and shrinking. */
+  i=5; while (i-->0) PS_ASSERT_CALL(ps_particles_update(particles))
+  PS_ASSERT_INTS(ps_particles_compose(&vtxv,particles,4,0,0,0),1)
+  PS_ASSERT_INTS(vtxv[0].a,(2*0xff)/4)
+  PS_ASSERT_INTS(vtxv[0].size,1+(2*19)/5)
+
+  i=2; while (i-->0) PS_ASSERT_CALL(ps_particles_update(particles))
+  PS_ASSERT_INTS(particles->c,0)
+
+  ps_particles_del(particles);
+  return 0;
+}
+
+/* Expiry keeps the survivors in order, and we stop at the limit.
+ */
+
+PS_TEST(test_particles_order_and_limit,game) {
+  struct ps_particles *particles=ps_particles_new();
+  PS_ASSERT(particles)
+
+  struct ps_particle particle={.size=1};
+  int i=0; for (;i<100;i++) {
+    particle.ttl=(i&1)?1:5;
+    particle.tileid=i;
+    PS_ASSERT_INTS(ps_particles_add(particles,&particle),1)
+  }
+  PS_ASSERT_CALL(ps_particles_update(particles))
+  PS_ASSERT_INTS(particles->c,50)
+  for (i=0;i<50;i++) PS_ASSERT_INTS(particles->tileidv[i],i*2)
+
+  PS_ASSERT_CALL(ps_particles_clear(particles))
+  particle.ttl=5;
+  for (i=0;i<PS_PARTICLES_LIMIT;i++) PS_ASSERT_INTS(ps_particles_add(particles,&particle),1)
+  PS_ASSERT_INTS(ps_particles_add(particles,&particle),0)
+  PS_ASSERT_INTS(particles->c,PS_PARTICLES_LIMIT)
+
+  ps_particles_del(particles);
+  return 0;
+}
+
+/* Each layer composes alone, and we can walk the layers in use from the bottom.
+ */
+
+PS_TEST(test_particles_layers,game) {
+  struct ps_particles *particles=ps_particles_new();
+  PS_ASSERT(particles)
+  PS_ASSERT_INTS(ps_particles_next_layer(particles,INT_MIN),INT_MAX)
+
+  struct ps_particle particle={.ttl=5,.tsid=4,.size=1};
+  particle.layer=200; PS_ASSERT_INTS(ps_particles_add(particles,&particle),1)
+  particle.layer=150; PS_ASSERT_INTS(ps_particles_add(particles,&particle),1)
+  particle.layer=200; PS_ASSERT_INTS(ps_particles_add(particles,&particle),1)
+
+  PS_ASSERT_INTS(ps_particles_next_layer(particles,INT_MIN),150)
+  PS_ASSERT_INTS(ps_particles_next_layer(particles,150),200)
+  PS_ASSERT_INTS(ps_particles_next_layer(particles,200),INT_MAX)
+
+  struct akgl_vtx_maxtile *vtxv=0;
+  PS_ASSERT_INTS(ps_particles_compose(&vtxv,particles,4,150,0,0),1)
+  PS_ASSERT_INTS(ps_particles_compose(&vtxv,particles,4,200,0,0),2)
+  PS_ASSERT_INTS(ps_particles_compose(&vtxv,particles,4,100,0,0),0)
+
+  ps_particles_del(particles);
+  return 0;
+}
@@ -0,0 +1,208 @@
+#include "test/ps_test.h"
+#include "game/ps_physics.h"
+#include "game/ps_broadphase.h"
+#include "game/ps_sprite.h"
+#include "scenario/ps_grid.h"
+#include "scenario/ps_blueprint.h"
+
+/* Compose a physics object with (sprc) solid sprites scattered pseudo-randomly around the screen.
+ * There's a grid with a few solid cells, some rounded, and most sprites can't walk on them.
+ * The same (seed) always produces the same layout.
+ */
+
+static struct ps_physics *new_mock_physics(int sprc,unsigned int seed) {
+  struct ps_physics *physics=ps_physics_new();
+  if (!physics) return 0;
+  struct ps_sprgrp *grp_physics=ps_sprgrp_new();
+  struct ps_sprgrp *grp_solid=ps_sprgrp_new();
+  if (!grp_physics||!grp_solid) return 0;
+  if (ps_physics_set_sprgrp_physics(physics,grp_physics)<0) return 0;
+  if (ps_physics_set_sprgrp_solid(physics,grp_solid)<0) return 0;
+  ps_sprgrp_del(grp_physics);
+  ps_sprgrp_del(grp_solid);
+
+  srand(seed);
+  struct ps_grid *grid=ps_grid_new();
+  if (!grid) return 0;
+  int i=0; for (;i<PS_GRID_SIZE;i++) {
+    if (rand()%8) continue;
+    grid->cellv[i].physics=PS_BLUEPRINT_CELL_SOLID;
+    grid->cellv[i].shape=rand()&PS_GRID_CELL_SHAPE_CIRCLE;
+  }
+  if (ps_physics_set_grid(physics,grid)<0) return 0;
+  ps_grid_del(grid);
+
+  for (i=0;i<sprc;i++) {
+    struct ps_sprite *spr=ps_sprite_new(&ps_sprtype_dummy);
+    if (!spr) return 0;
+    spr->x=(rand()%(PS_SCREENW+PS_TILESIZE*4))-PS_TILESIZE*2;
+    spr->y=(rand()%(PS_SCREENH+PS_TILESIZE*4))-PS_TILESIZE*2;
+    spr->radius=2+rand()%8;
+    spr->shape=(rand()&1)?PS_SPRITE_SHAPE_CIRCLE:PS_SPRITE_SHAPE_SQUARE;
+    spr->collide_sprites=(rand()%10)?1:0;
+    spr->impassable=(rand()%4)?(1<<PS_BLUEPRINT_CELL_SOLID):0;
+    switch (i%50) { // A few oddballs: huge, and far offscreen.
+      case 7: spr->radius=PS_TILESIZE*3; break;
+      case 13: spr->x=-1000.0; break;
+      case 29: spr->y=PS_SCREENH+1000.0; break;
+    }
+    if (ps_sprgrp_add_sprite(physics->grp_physics,spr)<0) return 0;
+    if (ps_sprgrp_add_sprite(physics->grp_solid,spr)<0) return 0;
+    ps_sprite_del(spr);
+  }
+
+  return physics;
+}
+
+static void del_mock_physics(struct ps_physics *physics) {
+  if (!physics) return;
+  ps_sprgrp_kill(physics->grp_physics);
+  ps_physics_del(physics);
+}
+
+/* Broadphase must produce exactly the same result as the naive all-pairs check.
+ * Resolution order matters, so both must run against the same group.
+ * For each frame, we run with broadphase, rewind, run without, and compare.
+ */
+
+PS_TEST(test_physics_broadphase_matches_naive,physics) {
+  int sprc;
+  for (sprc=2;sprc<=400;sprc*=3) {
+    struct ps_physics *physics=new_mock_physics(sprc,sprc*17+1);
+    PS_ASSERT(physics)
+    PS_ASSERT_INTS(physics->grp_solid->sprc,sprc)
+    double *startv=malloc(sizeof(double)*sprc*2);
+    double *fastv=malloc(sizeof(double)*sprc*2);
+    PS_ASSERT(startv&&fastv)
+
+    int framec=5; while (framec-->0) {
+      int i;
+      for (i=0;i<sprc;i++) {
+        startv[i*2]=physics->grp_solid->sprv[i]->x;
+        startv[i*2+1]=physics->grp_solid->sprv[i]->y;
+      }
+
+      PS_ASSERT_CALL(ps_physics_enable_broadphase(physics,1))
+      PS_ASSERT(physics->broadphase)
+      PS_ASSERT_CALL(ps_physics_update(physics))
+      int fast_eventc=physics->eventc;
+      for (i=0;i<sprc;i++) {
+        fastv[i*2]=physics->grp_solid->sprv[i]->x;
+        fastv[i*2+1]=physics->grp_solid->sprv[i]->y;
+        physics->grp_solid->sprv[i]->x=startv[i*2];
+        physics->grp_solid->sprv[i]->y=startv[i*2+1];
+      }
+
+      PS_ASSERT_CALL(ps_physics_enable_broadphase(physics,0))
+      PS_ASSERT_NOT(physics->broadphase)
+      PS_ASSERT_CALL(ps_physics_update(physics))
+      PS_ASSERT_INTS(fast_eventc,physics->eventc,"sprc=%d",sprc)
+      for (i=0;i<sprc;i++) {
+        const struct ps_sprite *spr=physics->grp_solid->sprv[i];
+        PS_ASSERT(spr->x==fastv[i*2],"sprc=%d i=%d x=%f,%f",sprc,i,spr->x,fastv[i*2])
+        PS_ASSERT(spr->y==fastv[i*2+1],"sprc=%d i=%d y=%f,%f",sprc,i,spr->y,fastv[i*2+1])
+      }
+    }
+
+    free(startv);
+    free(fastv);
+    del_mock_physics(physics);
+  }
+  return 0;
+}
+
+/* Every pair of overlapping sprites must be reported, and no pair twice.
+ */
+
+PS_TEST(test_broadphase_pairs_unique_and_complete,physics) {
+  struct ps_physics *physics=new_mock_physics(300,12345);
+  PS_ASSERT(physics)
+  struct ps_broadphase *broadphase=ps_broadphase_new();
+  PS_ASSERT(broadphase)
+  PS_ASSERT_CALL(ps_broadphase_rebuild(broadphase,physics->grp_solid,0))
+  PS_ASSERT_INTS(broadphase->entryc,300)
+  PS_ASSERT_CALL(ps_broadphase_find_pairs(broadphase))
+
+  int i; for (i=1;i<broadphase->pairc;i++) {
+    const struct ps_broadphase_pair *pv=broadphase->pairv+i-1,*pair=broadphase->pairv+i;
+    PS_ASSERT((pv->a<pair->a)||((pv->a==pair->a)&&(pv->b<pair->b)),"Pairs must be sorted and unique.")
+  }
+
+  int collidec=0;
+  for (i=0;i<broadphase->entryc;i++) {
+    int j; for (j=i+1;j<broadphase->entryc;j++) {
+      if (!ps_sprites_collide(broadphase->entryv[i].spr,broadphase->entryv[j].spr)) continue;
+      collidec++;
+      int found=0,k;
+      for (k=0;k<broadphase->pairc;k++) {
+        if ((broadphase->pairv[k].a==i)&&(broadphase->pairv[k].b==j)) { found=1; break; }
+      }
+      PS_ASSERT(found,"Colliding pair %d,%d missing from broadphase.",i,j)
+    }
+  }
+  PS_ASSERT_INTS_OP(collidec,>,0)
+  PS_ASSERT_INTS_OP(broadphase->pairc,>=,collidec)
+
+  ps_broadphase_del(broadphase);
+  del_mock_physics(physics);
+  return 0;
+}
+
+/* Incremental detection must find the same collisions as a full pass, while testing fewer pairs.
+ */
+
+PS_TEST(test_physics_incremental_matches_full,physics) {
+  int sprc;
+  for (sprc=2;sprc<=400;sprc*=3) {
+    struct ps_physics *physics=new_mock_physics(sprc,sprc*31+7);
+    PS_ASSERT(physics)
+    double *startv=malloc(sizeof(double)*sprc*2);
+    double *fastv=malloc(sizeof(double)*sprc*2);
+    PS_ASSERT(startv&&fastv)
+    struct ps_physics_stats fast_stats={0},full_stats={0};
+
+    int framec=5; while (framec-->0) {
+      int i;
+      for (i=0;i<sprc;i++) {
+        startv[i*2]=physics->grp_solid->sprv[i]->x;
+        startv[i*2+1]=physics->grp_solid->sprv[i]->y;
+      }
+
+      memset(&physics->stats,0,sizeof(struct ps_physics_stats));
+      PS_ASSERT_CALL(ps_physics_enable_incremental(physics,1))
+      PS_ASSERT_CALL(ps_physics_update(physics))
+      int fast_eventc=physics->eventc;
+      fast_stats.passc+=physics->stats.passc;
+      fast_stats.pairc_tested+=physics->stats.pairc_tested;
+      for (i=0;i<sprc;i++) {
+        fastv[i*2]=physics->grp_solid->sprv[i]->x;
+        fastv[i*2+1]=physics->grp_solid->sprv[i]->y;
+        physics->grp_solid->sprv[i]->x=startv[i*2];
+        physics->grp_solid->sprv[i]->y=startv[i*2+1];
+      }
+
+      memset(&physics->stats,0,sizeof(struct ps_physics_stats));
+      PS_ASSERT_CALL(ps_physics_enable_incremental(physics,0))
+      PS_ASSERT_CALL(ps_physics_update(physics))
+      full_stats.passc+=physics->stats.passc;
+      full_stats.pairc_tested+=physics->stats.pairc_tested;
+      PS_ASSERT_INTS(fast_eventc,physics->eventc,"sprc=%d",sprc)
+      for (i=0;i<sprc;i++) {
+        const struct ps_sprite *spr=physics->grp_solid->sprv[i];
+        PS_ASSERT(spr->x==fastv[i*2],"sprc=%d i=%d x=%f,%f",sprc,i,spr->x,fastv[i*2])
+        PS_ASSERT(spr->y==fastv[i*2+1],"sprc=%d i=%d y=%f,%f",sprc,i,spr->y,fastv[i*2+1])
+      }
+    }
+
+    PS_ASSERT(fast_stats.passc<=full_stats.passc)
+    PS_ASSERT(fast_stats.pairc_tested<=full_stats.pairc_tested)
+    if (sprc>=100) {
+      PS_ASSERT(fast_stats.pairc_tested<full_stats.pairc_tested,"sprc=%d",sprc)
+    }
+
+    free(startv);
+    free(fastv);
+    del_mock_physics(physics);
+  }
+  return 0;
+}
@@ -0,0 +1,158 @@
+#include "test/ps_test.h"
+#include "game/ps_game.h"
+#include "game/ps_sprite.h"
+
+/* Groups with a mask must stay in sync with the sprite's (grpmask) through every kind of addition and removal.
+ */
+
+PS_TEST(test_sprgrp_mask_tracks_membership,sprgrp) {
+  struct ps_sprgrp grpv[3]={0};
+  grpv[0].mask=0x01;
+  grpv[1].mask=0x02;
+  grpv[1].order=PS_SPRGRP_ORDER_RENDER;
+  struct ps_sprgrp *plain=ps_sprgrp_new(); // No mask; uses the search.
+  PS_ASSERT(plain)
+
+  struct ps_sprite *spr=ps_sprite_new(&ps_sprtype_dummy);
+  PS_ASSERT(spr)
+  PS_ASSERT_INTS(spr->grpmask,0)
+
+  PS_ASSERT_INTS(ps_sprgrp_add_sprite(grpv+0,spr),1)
+  PS_ASSERT_INTS(ps_sprgrp_add_sprite(grpv+1,spr),1)
+  PS_ASSERT_INTS(ps_sprgrp_add_sprite(grpv+2,spr),1)
+  PS_ASSERT_INTS(ps_sprgrp_add_sprite(plain,spr),1)
+  PS_ASSERT_INTS(spr->grpmask,0x03)
+  PS_ASSERT(ps_sprgrp_has_sprite(grpv+0,spr))
+  PS_ASSERT(ps_sprgrp_has_sprite(grpv+1,spr))
+  PS_ASSERT(ps_sprgrp_has_sprite(grpv+2,spr))
+  PS_ASSERT(ps_sprgrp_has_sprite(plain,spr))
+
+  PS_ASSERT_INTS(ps_sprgrp_remove_sprite(grpv+1,spr),1)
+  PS_ASSERT_INTS(spr->grpmask,0x01)
+  PS_ASSERT_NOT(ps_sprgrp_has_sprite(grpv+1,spr))
+  PS_ASSERT_INTS(ps_sprgrp_remove_sprite(grpv+1,spr),0)
+  PS_ASSERT_INTS(spr->grpmask,0x01)
+
+  PS_ASSERT_CALL(ps_sprgrp_clear(grpv+0))
+  PS_ASSERT_INTS(spr->grpmask,0)
+  PS_ASSERT_NOT(ps_sprgrp_has_sprite(grpv+0,spr))
+
+  PS_ASSERT_INTS(ps_sprgrp_add_sprite(grpv+0,spr),1)
+  PS_ASSERT_INTS(ps_sprgrp_add_sprite(grpv+1,spr),1)
+  PS_ASSERT_INTS(spr->grpmask,0x03)
+  PS_ASSERT_CALL(ps_sprite_kill(spr))
+  PS_ASSERT_INTS(spr->grpmask,0)
+  PS_ASSERT_INTS(spr->grpc,0)
+  PS_ASSERT_NOT(ps_sprgrp_has_sprite(plain,spr))
+
+  PS_ASSERT_INTS(ps_sprgrp_add_sprite(grpv+1,spr),1)
+  PS_ASSERT_INTS(spr->grpmask,0x02)
+  PS_ASSERT_CALL(ps_sprgrp_kill(grpv+1))
+  PS_ASSERT_INTS(spr->grpmask,0)
+
+  ps_sprite_del(spr);
+  ps_sprgrp_del(plain);
+  int i; for (i=0;i<3;i++) ps_sprgrp_cleanup(grpv+i);
+  return 0;
+}
+
+/* A RENDER group must be in exact (layer,y) order after every sort, however fast sprites move.
+ * Sprites join and leave between sorts, like they do during an update.
+ */
+
+static int assert_render_order(const struct ps_sprgrp *grp,int frame) {
+  int i; for (i=1;i<grp->sprc;i++) {
+    const struct ps_sprite *a=grp->sprv[i-1],*b=grp->sprv[i];
+    PS_ASSERT(
+      (a->layer<b->layer)||((a->layer==b->layer)&&(a->y<=b->y)),
+      "frame=%d i=%d: (%d,%f) before (%d,%f)",frame,i,a->layer,a->y,b->layer,b->y
+    )
+  }
+  return 0;
+}
+
+PS_TEST(test_sprgrp_render_order_exact_every_frame,sprgrp) {
+  struct ps_sprgrp *keepalive=ps_sprgrp_new();
+  struct ps_sprgrp *visible=ps_sprgrp_new();
+  PS_ASSERT(keepalive&&visible)
+  visible->order=PS_SPRGRP_ORDER_RENDER;
+  srand(99);
+
+  int frame=0; for (;frame<200;frame++) {
+    int i=rand()%8; while (i-->0) {
+      struct ps_sprite *spr=ps_sprite_new(&ps_sprtype_dummy);
+      PS_ASSERT(spr)
+      spr->layer=(rand()%3)*100;
+      spr->y=rand()%PS_SCREENH;
+      PS_ASSERT_CALL(ps_sprgrp_add_sprite(keepalive,spr))
+      PS_ASSERT_INTS(ps_sprgrp_add_sprite(visible,spr),1)
+      ps_sprite_del(spr);
+    }
+    if ((visible->sprc>0)&&(rand()%3==0)) {
+      struct ps_sprite *spr=visible->sprv[rand()%visible->sprc];
+      PS_ASSERT_CALL(ps_sprite_kill(spr))
+    }
+    for (i=0;i<keepalive->sprc;i++) {
+      struct ps_sprite *spr=keepalive->sprv[i];
+      spr->y+=(rand()%33)-16;
+      if (rand()%50==0) spr->layer=(rand()%3)*100;
+    }
+    PS_ASSERT_CALL(ps_sprgrp_sort(visible))
+    PS_ASSERT_INTS(visible->sprc,keepalive->sprc)
+    if (assert_render_order(visible,frame)<0) return -1;
+  }
+
+  PS_ASSERT_CALL(ps_sprgrp_kill(keepalive))
+  PS_ASSERT_INTS(visible->sprc,0)
+  ps_sprgrp_del(keepalive);
+  ps_sprgrp_del(visible);
+  return 0;
+}
+
+/* Sprites come from a per-type free list, and keep their group list inline until it outgrows PS_SPRITE_GRPV_INLINE.
+ * A recycled sprite must come back zeroed and with its inline list, whatever its previous life looked like.
+ */
+
+PS_TEST(test_sprite_pool_recycles_and_spills,sprgrp) {
+  struct ps_sprgrp grpv[PS_SPRITE_GRPV_INLINE+3]={0};
+  const int grpc=sizeof(grpv)/sizeof(struct ps_sprgrp);
+  struct ps_sprite_pool_stats before,after;
+  ps_sprite_pool_get_stats(&before);
+
+  struct ps_sprite *spr=ps_sprite_new(&ps_sprtype_dummy);
+  PS_ASSERT(spr)
+  PS_ASSERT(spr->grpv==spr->grpv_inline)
+  int i; for (i=0;i<grpc;i++) {
+    PS_ASSERT_INTS(ps_sprgrp_add_sprite(grpv+i,spr),1)
+  }
+  PS_ASSERT(spr->grpv!=spr->grpv_inline)
+  PS_ASSERT_INTS(spr->grpc,grpc)
+  for (i=0;i<grpc;i++) PS_ASSERT(ps_sprgrp_has_sprite(grpv+i,spr))
+  spr->x=123.0;
+  spr->switchid=7;
+  ps_sprite_pool_get_stats(&after);
+  PS_ASSERT_INTS(after.spillc,before.spillc+1)
+  PS_ASSERT_INTS(after.livec,before.livec+1)
+
+  struct ps_sprite *old=spr;
+  PS_ASSERT_CALL(ps_sprite_kill(spr))
+  ps_sprite_del(spr);
+  ps_sprite_pool_get_stats(&after);
+  PS_ASSERT_INTS(after.livec,before.livec)
+
+  // Last freed is first reused.
+  before=after;
+  PS_ASSERT(spr=ps_sprite_new(&ps_sprtype_dummy))
+  PS_ASSERT(spr==old)
+  PS_ASSERT(spr->grpv==spr->grpv_inline)
+  PS_ASSERT_INTS(spr->grpc,0)
+  PS_ASSERT_INTS(spr->grpmask,0)
+  PS_ASSERT_INTS(spr->switchid,0)
+  PS_ASSERT(spr->x==0.0)
+  ps_sprite_pool_get_stats(&after);
+  PS_ASSERT_INTS(after.reusec,before.reusec+1)
+  ps_sprite_del(spr);
+
+  for (i=0;i<grpc;i++) ps_sprgrp_cleanup(grpv+i);
+  return 0;
+}
@@ -0,0 +1,101 @@
+#include "test/ps_test.h"
+#include "opt/alsa/ps_alsa.h"
+#include "akau/akau_driver.h"
+#include "akau/akau_period.h"
+#include "util/ps_perfmon.h"
+#include <unistd.h>
+
+/* Device "null" needs no sound card, so this runs anywhere ALSA is built.
+ * It consumes instantly and never underruns on its own.
+ * We force underruns with ps_alsa_simulate_xrun(), which goes through the driver's real recovery path.
+ * The callback paces itself at 100 us per period, so each size lasts long enough to observe (1024 periods = 0.1 s).
+ */
+
+#define RATE 44100
+#define CHANC 2
+
+/* Record each period size the driver asks for, once per change.
+ */
+
+static struct {
+  int dstcv[16];
+  int dstcc;
+  int callc;
+} test_alsa_period_record={0};
+
+static void cb_record(int16_t *dst,int dstc) {
+  test_alsa_period_record.callc++;
+  int c=test_alsa_period_record.dstcc;
+  if (!c||(test_alsa_period_record.dstcv[c-1]!=dstc)) {
+    if (c<16) test_alsa_period_record.dstcv[test_alsa_period_record.dstcc++]=dstc;
+  }
+  memset(dst,0,dstc*sizeof(int16_t));
+  usleep(100);
+}
+
+/* Status source for perfmon, the same shape as ps_main's.
+ */
+
+static int cb_status(int *latency_us,int *xrunc) {
+  struct akau_driver_status status={0};
+  if (ps_alsa_get_status(&status)<0) return -1;
+  *latency_us=status.latency_us;
+  *xrunc=status.xrunc;
+  return 0;
+}
+
+/* Wait up to 5 s for the driver to reach a given period and underrun count.
+ */
+
+static int wait_for_status(int period,int xrunc) {
+  int i=5000; for (;i-->0;) {
+    struct akau_driver_status status={0};
+    if (ps_alsa_get_status(&status)<0) return -1;
+    if ((status.period==period)&&(status.xrunc==xrunc)) return 0;
+    usleep(1000);
+  }
+  return -1;
+}
+
+/* Underrun grows the period, and a clean stretch shrinks it again, without stopping the stream.
+ */
+
+PS_TEST(test_alsa_period_adapts_on_null_device,alsa,functional) {
+  memset(&test_alsa_period_record,0,sizeof(test_alsa_period_record));
+  PS_ASSERT_CALL(ps_alsa_set_period(1,64))
+  PS_ASSERT_CALL(ps_alsa_init("null",RATE,CHANC,cb_record))
+
+  struct ps_perfmon *perfmon=ps_perfmon_new();
+  PS_ASSERT(perfmon)
+  PS_ASSERT_CALL(ps_perfmon_set_audio_status_source(perfmon,cb_status))
+  PS_ASSERT_CALL(ps_perfmon_finish_load(perfmon))
+  PS_ASSERT_INTS(ps_perfmon_count_audio_underruns(perfmon),0)
+
+  /* First clean stretch takes us from 64 down to the floor. */
+  PS_ASSERT_CALL(wait_for_status(AKAU_PERIOD_MIN,0),"Never shrank from 64 to %d frames.",AKAU_PERIOD_MIN)
+
+  /* One underrun doubles it. */
+  PS_ASSERT_CALL(ps_alsa_simulate_xrun())
+  PS_ASSERT_CALL(wait_for_status(AKAU_PERIOD_MIN*2,1),"Underrun didn't grow the period.")
+
+  /* And the next, longer, clean stretch brings it back down. */
+  PS_ASSERT_CALL(wait_for_status(AKAU_PERIOD_MIN,1),"Never shrank again after the underrun.")
+
+  struct akau_driver_status status={0};
+  PS_ASSERT_CALL(ps_alsa_get_status(&status))
+  PS_ASSERT_INTS(status.latency_us,(AKAU_PERIOD_MIN*AKAU_PERIOD_COUNT*1000000)/RATE)
+  PS_ASSERT_INTS(ps_perfmon_count_audio_underruns(perfmon),1)
+  PS_ASSERT_CALL(ps_perfmon_log(perfmon))
+
+  ps_alsa_quit();
+
+  /* Each reconfigure refilled the new buffer straight away; the callback saw each size exactly once, in order. */
+  PS_ASSERT_INTS(test_alsa_period_record.dstcc,4)
+  PS_ASSERT_INTS(test_alsa_period_record.dstcv[0],64*CHANC)
+  PS_ASSERT_INTS(test_alsa_period_record.dstcv[1],AKAU_PERIOD_MIN*CHANC)
+  PS_ASSERT_INTS(test_alsa_period_record.dstcv[2],AKAU_PERIOD_MIN*2*CHANC)
+  PS_ASSERT_INTS(test_alsa_period_record.dstcv[3],AKAU_PERIOD_MIN*CHANC)
+
+  ps_perfmon_del(perfmon);
+  return 0;
+}
@@ -348,7 +348,14 @@ PS_TEST(test_defect_userconfig_assigns_sound_to_soft_render,userconfig) {
     "sound=198\n"
     "kiosk=0\n"
     "tshirt=0\n"
+    "video-vbo=0\n"
+    "audio-rate=44100\n"
     "highscores=\n"
+    "audio-chanc=2\n"
+    "audio-device=\n"
+    "audio-period=0\n"
+    "video-device=\n"
+    "audio-low-latency=0\n"
   ,-1)
 
   ps_buffer_cleanup(&buffer);
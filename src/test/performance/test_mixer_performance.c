@@ -0,0 +1,105 @@
+/* test_mixer_performance.c
+ *
+ * Mix a crowd of channels, half held notes and half looping IPCMs, with assorted trims and pans.
+ * We run each crowd per-frame and block-mixed, and report processor time per 512-frame stereo buffer.
+ * "static" leaves the channels alone; "sliding" retrims every channel over 256 frames at each buffer,
+ * so half of each buffer goes through the per-frame fallback.
+ * Each log entry is: channel count, scenario, microseconds per buffer per-frame, block-mixed.
+ *
+ * TEST RESULTS: Linux x86_64, -O2.
+TEST:INFO:      8 static         37.4        9.7
+TEST:INFO:      8 sliding        45.0       28.7
+TEST:INFO:     32 static        172.1       50.5
+TEST:INFO:     32 sliding       159.6      130.3
+TEST:INFO:    128 static        729.6      197.6
+TEST:INFO:    128 sliding       494.2      365.6
+ */
+
+#include "test/ps_test.h"
+#include "akau/akau.h"
+#include "akau/akau_mixer.h"
+#include "akau/akau_instrument.h"
+#include "akau/akau_pcm.h"
+#include <math.h>
+#include <time.h>
+
+#define BUFFERS_PER_TEST 400
+#define SAMPLES_PER_BUFFER 1024
+
+struct mixer_crowd {
+  struct akau_mixer *mixer;
+  int chanidv[256];
+  int chanidc;
+};
+
+static int populate_crowd(struct mixer_crowd *crowd,int chanc,struct akau_instrument *instrument,struct akau_ipcm **ipcmv,int block) {
+  if (!(crowd->mixer=akau_mixer_new())) return -1;
+  if (akau_mixer_set_print_songs(crowd->mixer,0)<0) return -1;
+  if (akau_mixer_set_block_mixing(crowd->mixer,block)<0) return -1;
+  crowd->chanidc=0;
+  srand(chanc);
+  int i=0; for (;i<chanc;i++) {
+    uint8_t trim=0x10+rand()%0x20;
+    int8_t pan=(i%3)?((rand()&0xff)-0x80):0;
+    int chanid;
+    if (i&1) chanid=akau_mixer_play_ipcm(crowd->mixer,ipcmv[i>>1],trim,pan,1,0);
+    else chanid=akau_mixer_play_note(crowd->mixer,instrument,30+rand()%60,trim,pan,INT_MAX>>1,0);
+    if (chanid<1) return -1;
+    crowd->chanidv[crowd->chanidc++]=chanid;
+  }
+  return 0;
+}
+
+static double time_crowd(struct mixer_crowd *crowd,int sliding) {
+  int16_t buf[SAMPLES_PER_BUFFER];
+  clock_t elapsed=0;
+  int i=0; for (;i<BUFFERS_PER_TEST;i++) {
+    if (sliding) {
+      int j=0; for (;j<crowd->chanidc;j++) {
+        if (akau_mixer_adjust_channel(crowd->mixer,crowd->chanidv[j],0,0x10+((i+j)&0x1f),0,256)<0) return -1.0;
+      }
+    }
+    clock_t start=clock();
+    if (akau_mixer_update(buf,SAMPLES_PER_BUFFER,crowd->mixer)<0) return -1.0;
+    elapsed+=clock()-start;
+  }
+  return (elapsed*1000000.0)/((double)CLOCKS_PER_SEC*BUFFERS_PER_TEST);
+}
+
+PS_TEST(test_mixer_block_performance,ignore,performance,mixer) {
+  const int chancv[]={8,32,128};
+
+  struct akau_fpcm *fpcm=akau_fpcm_new(1000);
+  PS_ASSERT(fpcm)
+  double *v=akau_fpcm_get_sample_buffer(fpcm);
+  int i=0; for (;i<1000;i++) v[i]=sin((i*M_PI*2.0)/1000.0);
+  struct akau_instrument *instrument=akau_instrument_new(fpcm,500,0.9,500,0.5,1000);
+  PS_ASSERT(instrument)
+  akau_fpcm_del(fpcm);
+
+  struct akau_ipcm *ipcmv[64];
+  for (i=0;i<64;i++) {
+    PS_ASSERT(ipcmv[i]=akau_ipcm_new(4410+i*37))
+    int16_t *dst=akau_ipcm_get_sample_buffer(ipcmv[i]);
+    int j=0; for (;j<4410+i*37;j++) dst[j]=(rand()&0xffff)-0x8000;
+  }
+
+  for (i=0;i<sizeof(chancv)/sizeof(int);i++) {
+    int sliding=0; for (;sliding<2;sliding++) {
+      struct mixer_crowd slow={0},fast={0};
+      PS_ASSERT_CALL(populate_crowd(&slow,chancv[i],instrument,ipcmv,0))
+      PS_ASSERT_CALL(populate_crowd(&fast,chancv[i],instrument,ipcmv,1))
+      double slowus=time_crowd(&slow,sliding);
+      double fastus=time_crowd(&fast,sliding);
+      PS_ASSERT(slowus>=0.0)
+      PS_ASSERT(fastus>=0.0)
+      ps_log(TEST,INFO,"%6d %-8s %10.1f %10.1f",chancv[i],sliding?"sliding":"static",slowus,fastus);
+      akau_mixer_del(slow.mixer);
+      akau_mixer_del(fast.mixer);
+    }
+  }
+
+  akau_instrument_del(instrument);
+  for (i=0;i<64;i++) akau_ipcm_del(ipcmv[i]);
+  return 0;
+}
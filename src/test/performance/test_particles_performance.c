@@ -0,0 +1,91 @@
+/* test_particles_performance.c
+ *
+ * test_particles_performance:
+ * A real game, headless, with several monsters' worth of fireworks (20 particles, 60 frames each) every frame.
+ * Each log entry is: bursts per frame, live particles at the end,
+ * microseconds per frame for ps_game_update(), for composing the particle vertices, and for a full soft render.
+ * Rendering is sampled every tenth frame; soft rasterizing tens of thousands of tiles is not what we're measuring.
+ *
+ * TEST RESULTS: Linux x86_64, -O2, soft render.
+ * For comparison, one burst per frame as sprites cost 60.90 us/frame to update (test_sprite_pool_performance.c).
+ * Update includes creating the bursts and the rest of the game. Draw is almost all rasterization.
+TEST:INFO:   bursts     live     update    compose       draw
+TEST:INFO:        1     1180       5.91       5.57    8483.58
+TEST:INFO:        5     5900      28.13      34.41   46414.58
+TEST:INFO:       20    23600     108.14     130.23  188209.45
+ */
+
+#include "test/ps_test.h"
+#include "game/ps_game.h"
+#include "game/ps_particles.h"
+#include "video/ps_video.h"
+#include "input/ps_input.h"
+#include "res/ps_resmgr.h"
+#include "os/ps_userconfig.h"
+#include "akgl/akgl.h"
+#include <time.h>
+
+#define PARTICLES_FRAMEC 1200
+#define PARTICLES_DRAW_INTERVAL 10
+
+static int particles_measure(struct ps_game *game,int burstc) {
+  PS_ASSERT_CALL(ps_game_restart(game))
+  clock_t update=0,compose=0,draw=0;
+  int drawc=0;
+  int framep=0; for (;framep<PARTICLES_FRAMEC;framep++) {
+    clock_t starttime=clock();
+    int i=burstc; while (i-->0) {
+      PS_ASSERT_CALL(ps_game_create_fireworks(game,PS_SCREENW>>1,PS_SCREENH>>1))
+    }
+    PS_ASSERT_CALL(ps_game_update(game))
+    clock_t t1=clock();
+    update+=t1-starttime;
+    struct akgl_vtx_maxtile *vtxv=0;
+    PS_ASSERT_CALL(ps_particles_compose(&vtxv,game->particles,0x04,200,0,0))
+    clock_t t2=clock();
+    compose+=t2-t1;
+    if (!(framep%PARTICLES_DRAW_INTERVAL)) {
+      PS_ASSERT_CALL(ps_video_draw_to_framebuffer())
+      draw+=clock()-t2;
+      drawc++;
+    }
+  }
+  ps_log(TEST,INFO,"%8d %8d %10.2f %10.2f %10.2f",
+    burstc,game->particles->c,
+    (update*1000000.0)/((double)CLOCKS_PER_SEC*PARTICLES_FRAMEC),
+    (compose*1000000.0)/((double)CLOCKS_PER_SEC*PARTICLES_FRAMEC),
+    (draw*1000000.0)/((double)CLOCKS_PER_SEC*drawc)
+  );
+  return 0;
+}
+
+PS_TEST(test_particles_performance,ignore,performance,game) {
+  ps_resmgr_quit();
+  ps_video_quit();
+  PS_ASSERT_CALL(ps_video_init_headless())
+  PS_ASSERT_CALL(ps_input_init())
+  PS_ASSERT_CALL(ps_resmgr_init("src/data",0))
+
+  struct ps_userconfig *userconfig=ps_userconfig_new();
+  PS_ASSERT(userconfig)
+  PS_ASSERT_CALL(ps_userconfig_declare_default_fields(userconfig))
+  struct ps_game *game=ps_game_new(userconfig);
+  PS_ASSERT(game)
+  PS_ASSERT_CALL(ps_game_set_player_count(game,1))
+  PS_ASSERT_CALL(ps_game_configure_player(game,1,1,0,0))
+  PS_ASSERT_CALL(ps_game_set_seed(game,1234))
+  PS_ASSERT_CALL(ps_game_generate_test(game,-1,2,1))
+
+  ps_log(TEST,INFO,"%8s %8s %10s %10s %10s","bursts","live","update","compose","draw");
+  const int burstv[]={1,5,20};
+  int i=0; for (;i<sizeof(burstv)/sizeof(int);i++) {
+    PS_ASSERT_CALL(particles_measure(game,burstv[i]))
+  }
+
+  ps_game_del(game);
+  ps_userconfig_del(userconfig);
+  ps_resmgr_quit();
+  ps_input_quit();
+  ps_video_quit();
+  return 0;
+}
@@ -0,0 +1,133 @@
+/* test_physics_performance.c
+ *
+ * Scatter a crowd of solid sprites randomly around the screen and run physics on them.
+ * Positions are re-randomized each frame so every update does real work.
+ * We run each crowd size with and without broadphase, and report processor time per update.
+ * Each log entry is: sprite count, pairs tested with broadphase, microseconds per update naive, with broadphase.
+ * The dense end is far beyond anything the game produces; most of that time goes to resolving real collisions.
+ *
+ * TEST RESULTS: Linux x86_64, -O2.
+ * test_physics_broadphase_scaling: count, pairs, naive us, broadphase us
+TEST:INFO:     10        1          2.0          4.1
+TEST:INFO:     50       15         88.0         31.0
+TEST:INFO:    100       79        767.8         88.0
+TEST:INFO:    200      328       3769.7        492.4
+TEST:INFO:    500     1770      27390.3       3156.3
+TEST:INFO:   1000     6737     101645.0      10736.0
+TEST:INFO:   2000    25471     562636.7     151404.4
+ * test_physics_incremental_savings: count, passes, tested full, tested incremental, skipped, full us, incremental us
+ * Past a few hundred sprites, the crowd is so dense that nearly everything moves on every pass.
+TEST:INFO:     10   1.1          1          0         50          4.5          2.4
+TEST:INFO:     50   4.6         86         42       5592         23.4         18.2
+TEST:INFO:    100   9.8        710        247      48015         86.2         66.3
+TEST:INFO:    200  10.0       3068       1845     197154        362.1        312.6
+TEST:INFO:    500  10.0      18224      17353    1230146       2572.4       2533.2
+TEST:INFO:   1000  10.0      70036      69986    4925013      10952.6      10006.6
+TEST:INFO:   2000  10.0     272990     272985   19717014     149794.4     153639.5
+ */
+
+#include "test/ps_test.h"
+#include "game/ps_physics.h"
+#include "game/ps_broadphase.h"
+#include "game/ps_sprite.h"
+#include <time.h>
+
+#define FRAMES_PER_TEST 20
+
+static struct ps_physics *new_crowd(int sprc) {
+  struct ps_physics *physics=ps_physics_new();
+  if (!physics) return 0;
+  struct ps_sprgrp *grp=ps_sprgrp_new();
+  if (!grp) return 0;
+  if (ps_physics_set_sprgrp_physics(physics,grp)<0) return 0;
+  if (ps_physics_set_sprgrp_solid(physics,grp)<0) return 0;
+  ps_sprgrp_del(grp);
+  while (sprc-->0) {
+    struct ps_sprite *spr=ps_sprite_new(&ps_sprtype_dummy);
+    if (!spr) return 0;
+    spr->radius=4+rand()%4;
+    spr->shape=(rand()&1)?PS_SPRITE_SHAPE_CIRCLE:PS_SPRITE_SHAPE_SQUARE;
+    if (ps_sprgrp_add_sprite(grp,spr)<0) return 0;
+    ps_sprite_del(spr);
+  }
+  return physics;
+}
+
+static void scatter_crowd(struct ps_physics *physics,unsigned int seed) {
+  srand(seed);
+  int i=physics->grp_solid->sprc; while (i-->0) {
+    struct ps_sprite *spr=physics->grp_solid->sprv[i];
+    spr->x=rand()%PS_SCREENW;
+    spr->y=rand()%PS_SCREENH;
+  }
+}
+
+static double time_crowd(struct ps_physics *physics) {
+  clock_t elapsed=0;
+  int i=0; for (;i<FRAMES_PER_TEST;i++) {
+    scatter_crowd(physics,i+1);
+    clock_t start=clock();
+    if (ps_physics_update(physics)<0) return -1.0;
+    elapsed+=clock()-start;
+  }
+  return (elapsed*1000000.0)/((double)CLOCKS_PER_SEC*FRAMES_PER_TEST);
+}
+
+PS_TEST(test_physics_broadphase_scaling,ignore,performance,physics) {
+  const int sprcv[]={10,50,100,200,500,1000,2000};
+  int i=0; for (;i<sizeof(sprcv)/sizeof(int);i++) {
+    struct ps_physics *physics=new_crowd(sprcv[i]);
+    PS_ASSERT(physics)
+
+    PS_ASSERT_CALL(ps_physics_enable_broadphase(physics,0))
+    double naive=time_crowd(physics);
+    PS_ASSERT(naive>=0.0)
+
+    PS_ASSERT_CALL(ps_physics_enable_broadphase(physics,1))
+    PS_ASSERT_CALL(ps_physics_enable_incremental(physics,0))
+    double fast=time_crowd(physics);
+    PS_ASSERT(fast>=0.0)
+
+    ps_log(TEST,INFO,"%6d %8d %12.1f %12.1f",sprcv[i],physics->broadphase->pairc,naive,fast);
+    ps_sprgrp_kill(physics->grp_solid);
+    ps_physics_del(physics);
+  }
+  return 0;
+}
+
+/* Same crowds, comparing full and incremental detection on each relaxation pass.
+ * Each log entry is: sprite count, passes per update, pairs tested per update full, incremental,
+ * pairs skipped per update (relative to naive) incremental, microseconds per update full, incremental.
+ */
+
+PS_TEST(test_physics_incremental_savings,ignore,performance,physics) {
+  const int sprcv[]={10,50,100,200,500,1000,2000};
+  int i=0; for (;i<sizeof(sprcv)/sizeof(int);i++) {
+    struct ps_physics *physics=new_crowd(sprcv[i]);
+    PS_ASSERT(physics)
+
+    PS_ASSERT_CALL(ps_physics_enable_incremental(physics,0))
+    memset(&physics->stats,0,sizeof(struct ps_physics_stats));
+    double full=time_crowd(physics);
+    PS_ASSERT(full>=0.0)
+    struct ps_physics_stats full_stats=physics->stats;
+
+    PS_ASSERT_CALL(ps_physics_enable_incremental(physics,1))
+    memset(&physics->stats,0,sizeof(struct ps_physics_stats));
+    double fast=time_crowd(physics);
+    PS_ASSERT(fast>=0.0)
+    struct ps_physics_stats fast_stats=physics->stats;
+
+    ps_log(TEST,INFO,"%6d %5.1f %10lld %10lld %10lld %12.1f %12.1f",
+      sprcv[i],
+      (double)fast_stats.passc/fast_stats.updatec,
+      (long long)(full_stats.pairc_tested/full_stats.updatec),
+      (long long)(fast_stats.pairc_tested/fast_stats.updatec),
+      (long long)(fast_stats.pairc_skipped/fast_stats.updatec),
+      full,fast
+    );
+    ps_sprgrp_kill(physics->grp_solid);
+    ps_physics_del(physics);
+  }
+  return 0;
+}
@@ -6,6 +6,7 @@
  * In particular, I want to see if it is worth optimizing the software renderer further.
  *
  * With the test running, press B to create an explosion (lots of bells-and-whistles sprites).
+ * Press A to toggle akgl's vertex buffer (GL only), to compare against client-side arrays.
  * It will draw each frame repeatedly and record the processor time spent on each cycle.
  * Our timing only records time spent in this process, not calendar time.
  * And it doesn't record the game's update, the final video delivery, or any other processing.
@@ -179,6 +180,62 @@ MAIN:INFO:        500   11271718         81 0.022543436 [src/test/performance/te
 MAIN:INFO:        500   11071621         81 0.022143242 [src/test/performance/test_rendering_performance.c:228]
 MAIN:INFO:        500   10802269         81 0.021604538 [src/test/performance/test_rendering_performance.c:228]
 MAIN:INFO:        500   10526867         81 0.021053734 [src/test/performance/test_rendering_performance.c:228]
+ *
+ * test_rendering_sprite_cost, at the bottom, measures the soft blitter alone and runs headless.
+ * Each log entry is: kind of sprite, microseconds per sprite with the generic pixel loop, same with the specialized kernels, speedup.
+ * Rotated sprites and same-size RGBX tiles don't use the kernels, and are there for reference.
+ *
+ * TEST RESULTS: Linux x86_64, -O2, SSE2.
+TEST:INFO: sprite                   generic us  kernel us  speedup
+TEST:INFO: maxtile plain 16              1.115      0.224     4.99
+TEST:INFO: maxtile effects 16            2.545      1.554     1.64
+TEST:INFO: maxtile effects 24           12.431      2.610     4.76
+TEST:INFO: maxtile rotated 16            7.746      7.853     0.99
+TEST:INFO: mintile RGBX 16               0.100      0.098     1.02
+TEST:INFO: mintile RGBX 32               5.057      1.754     2.88
+TEST:INFO: mintile RGBA 32               6.668      2.368     2.82
+TEST:INFO: textile 8x16                  0.653      0.399     1.64
+TEST:INFO: textile 12x24                 1.872      1.144     1.64
+ *
+ * test_rendering_grid_cost, also headless, draws just the grid through the video layer, with and without the cached background.
+ * Each log entry is: what changed between frames, microseconds per frame drawing every tile, same with the cache, speedup.
+ * Changing every cell every frame is the cache's worst case (all tiles plus a full-screen blit), and never happens in play.
+ * No GL numbers: the cache in GL mode is a framebuffer object drawn as one quad, same as the slide capture.
+ *
+ * TEST RESULTS: Linux x86_64, -O2, soft render (headless).
+TEST:INFO: frame                     direct us  cached us  speedup
+TEST:INFO: static                       83.332     12.094     6.89
+TEST:INFO: 1 cell changed               83.361     12.038     6.92
+TEST:INFO: 8 cells changed              83.298     15.282     5.45
+TEST:INFO: two screens alternating      82.366     11.915     6.91
+TEST:INFO: every cell changed           87.875    107.105     0.82
+ *
+ * test_rendering_draw_calls, headless, counts akgl draw commands per frame in a real game, with and without the tilesheet atlas.
+ * Each log entry is: scene, visible sprites, draw calls per frame without the atlas, same with, microseconds per frame each way.
+ * The soft renderer has no per-call cost to speak of, so its times only show that the atlas costs nothing.
+ * A GL driver pays for each call and texture bind; that's where the savings would show.
+ *
+ * TEST RESULTS: Linux x86_64, -O2, soft render (headless).
+TEST:INFO: scene                     sprites    calls    atlas         us   atlas us
+TEST:INFO: start                           1      2.0      2.0      23.53      16.95
+TEST:INFO: 5 deaths                        6      3.0      2.0     917.45     950.23
+TEST:INFO: crowd of 20                    20     10.0      2.0      41.27      44.03
+TEST:INFO: crowd of 100                  123     11.0      2.0    2095.72    2188.68
+TEST:INFO: crowd of 100, 5 deaths        127     11.0      2.0    3153.15    3014.78
+ *
+ * Vertex buffer vs client-side arrays, GL 2 on Mesa llvmpipe (LLVM 15, surfaceless EGL, no window).
+ * This isn't a test here; I drove akgl_program_maxtile_draw directly, 4 draws per frame, glFinish after each frame.
+ * Each entry is: vertices per frame, processor microseconds per frame with client arrays, same with the VBO.
+ * Three runs; the second with VBO measured first, the third with LP_NUM_THREADS=0.
+ *   sprites   client      vbo   client      vbo   client      vbo
+ *       100     72.0     77.7     61.8     69.8     69.9     99.7
+ *      1000    579.8    650.0    633.8    666.0    614.8    662.3
+ *      5000   3938.0   4309.6   4516.5   4186.8   5249.3   4955.8
+ *     20000  26450.4  22463.2  27460.3  24365.4  30626.7  24661.4
+ * llvmpipe spends nearly all its time rasterizing, so the copy we save only shows up with very large batches (~15% at 20k).
+ * At the sprite counts we actually draw, it's a wash, slightly worse if anything.
+ * Hardware drivers are where the VBO should pay off, since there the client-array copy blocks the CPU at every draw.
+ * Until that's measured, client arrays stay the default and the VBO is opt-in.
  *
  */
 
@@ -190,8 +247,15 @@ MAIN:INFO:        500   10526867         81 0.021053734 [src/test/performance/te
 #include "input/ps_input.h"
 #include "input/ps_input_button.h"
 #include "res/ps_resmgr.h"
+#include "res/ps_res_internal.h"
+#include "video/ps_video_layer.h"
+#include "scenario/ps_grid.h"
+#include "scenario/ps_region.h"
 #include "game/ps_game.h"
+#include "game/ps_sprite.h"
+#include "game/ps_particles.h"
 #include "akgl/akgl.h"
+#include "sdraw/ps_sdraw.h"
 #include <time.h>
 
 #if PS_USE_macioc
@@ -383,6 +447,8 @@ static void ps_main_quit() {
  */
 
 static int button_pressed=0;
+static int vbo_button_pressed=0;
+static int vbo_enabled=0;
 
 static int ps_main_update() {
   //ps_log(MAIN,TRACE,"%s",__func__);
@@ -403,6 +469,18 @@ static int ps_main_update() {
     button_pressed=0;
   }
 
+  /* Toggle the vertex buffer when A button pressed. */
+  if (ps_get_player_buttons(0)&PS_PLRBTN_A) {
+    if (!vbo_button_pressed) {
+      vbo_button_pressed=1;
+      vbo_enabled=vbo_enabled?0:1;
+      ps_log(MAIN,INFO,"Vertex buffer %s.",vbo_enabled?"enabled":"disabled");
+      akgl_set_vbo_enabled(vbo_enabled);
+    }
+  } else {
+    vbo_button_pressed=0;
+  }
+
   if (ps_game_update(ps_game)<0) return -1;
 
   /* Here is the bulk of the test: */
@@ -433,3 +511,282 @@ PS_TEST(test_rendering_performance,ignore) {
   if (err) return -1;
   return 0;
 }
+
+/* Per-sprite cost of the software blitter alone, headless.
+ * Draws each kind of sprite repeatedly onto a screen-sized RGBX framebuffer, with and without the specialized kernels.
+ */
+
+#define SPRITE_COST_DRAWC 200000
+
+static struct ps_sdraw_image *sprite_cost_sheet(int fmt,int w,int h) {
+  struct ps_sdraw_image *image=ps_sdraw_image_new();
+  if (!image) return 0;
+  if (ps_sdraw_image_realloc(image,fmt,w,h)<0) return 0;
+  int colw=w>>4,rowh=h>>4;
+  int y=0; for (;y<h;y++) {
+    uint8_t *p=image->pixels+y*image->rowstride;
+    int x=0; for (;x<w;x++,p+=image->colstride) {
+      // A disc in each tile, soft at the edge, part gray so primary color does something.
+      int dx=2*(x%colw)-colw+1,dy=2*(y%rowh)-rowh+1;
+      int d2=dx*dx+dy*dy,r2=colw*colw;
+      int a=(d2>=r2)?0:(d2>=(r2*3)/4)?0x80:0xff;
+      if (fmt==PS_SDRAW_FMT_A) { p[0]=a; continue; }
+      if (x&4) { p[0]=p[1]=p[2]=y*4; } else { p[0]=x; p[1]=y; p[2]=x^y; }
+      if (fmt==PS_SDRAW_FMT_RGBA) p[3]=a;
+    }
+  }
+  return image;
+}
+
+static double sprite_cost_maxtile(struct ps_sdraw_image *fb,struct ps_sdraw_image *sheet,const struct akgl_vtx_maxtile *vtx) {
+  struct akgl_vtx_maxtile vtxv[32];
+  int i=0; for (;i<32;i++) {
+    vtxv[i]=*vtx;
+    vtxv[i].x=(i*53)%PS_SCREENW;
+    vtxv[i].y=(i*31)%PS_SCREENH;
+    vtxv[i].tileid=i;
+  }
+  clock_t starttime=clock();
+  for (i=SPRITE_COST_DRAWC/32;i-->0;) {
+    if (ps_sdraw_blit_maxtiles(fb,vtxv,32,sheet)<0) return -1.0;
+  }
+  clock_t elapsed=clock()-starttime;
+  return (elapsed*1000000.0)/((double)CLOCKS_PER_SEC*(SPRITE_COST_DRAWC/32)*32);
+}
+
+static double sprite_cost_mintile(struct ps_sdraw_image *fb,struct ps_sdraw_image *sheet,int size) {
+  int srccolw=sheet->w>>4,srcrowh=sheet->h>>4;
+  clock_t starttime=clock();
+  int i=0; for (;i<SPRITE_COST_DRAWC;i++) {
+    int x=(i*53)%PS_SCREENW,y=(i*31)%PS_SCREENH,tileid=i&0xff;
+    if (ps_sdraw_blit(fb,x,y,size,size,sheet,(tileid&15)*srccolw,(tileid>>4)*srcrowh,srccolw,srcrowh)<0) return -1.0;
+  }
+  clock_t elapsed=clock()-starttime;
+  return (elapsed*1000000.0)/((double)CLOCKS_PER_SEC*SPRITE_COST_DRAWC);
+}
+
+static double sprite_cost_textile(struct ps_sdraw_image *fb,struct ps_sdraw_image *sheet,int size) {
+  int srccolw=sheet->w>>4,srcrowh=sheet->h>>4;
+  struct ps_sdraw_rgba rgba=ps_sdraw_rgba(0xff,0xc0,0x40,0xff);
+  clock_t starttime=clock();
+  int i=0; for (;i<SPRITE_COST_DRAWC;i++) {
+    int x=(i*53)%PS_SCREENW,y=(i*31)%PS_SCREENH,tileid=i&0xff;
+    if (ps_sdraw_blit_replacergb(
+      fb,x,y,size>>1,size,sheet,(tileid&15)*srccolw,(tileid>>4)*srcrowh,srccolw,srcrowh,rgba
+    )<0) return -1.0;
+  }
+  clock_t elapsed=clock()-starttime;
+  return (elapsed*1000000.0)/((double)CLOCKS_PER_SEC*SPRITE_COST_DRAWC);
+}
+
+PS_TEST(test_rendering_sprite_cost,ignore,performance,sdraw) {
+  struct ps_sdraw_image *fb=ps_sdraw_image_new();
+  PS_ASSERT(fb)
+  PS_ASSERT_CALL(ps_sdraw_image_realloc(fb,PS_SDRAW_FMT_RGBX,PS_SCREENW,PS_SCREENH))
+  struct ps_sdraw_image *sprites=sprite_cost_sheet(PS_SDRAW_FMT_RGBA,256,256);
+  struct ps_sdraw_image *tiles=sprite_cost_sheet(PS_SDRAW_FMT_RGBX,256,256);
+  struct ps_sdraw_image *font=sprite_cost_sheet(PS_SDRAW_FMT_A,128,256);
+  PS_ASSERT(sprites&&tiles&&font)
+
+  const struct akgl_vtx_maxtile plain={.size=16,.pr=0x80,.pg=0x80,.pb=0x80,.a=0xff};
+  struct akgl_vtx_maxtile fancy=plain;
+  fancy.tr=0xff; fancy.ta=0x60; fancy.pr=0xc0; fancy.pb=0x20; fancy.a=0xc0; fancy.xform=AKGL_XFORM_FLOP;
+  struct akgl_vtx_maxtile scaled=fancy;
+  scaled.size=24; scaled.xform=AKGL_XFORM_90;
+  struct akgl_vtx_maxtile rotated=fancy;
+  rotated.t=40;
+
+  ps_log(TEST,INFO,"%-24s %10s %10s %8s","sprite","generic us","kernel us","speedup");
+  int enable;
+  #define MEASURE(label,expr) { \
+    double costv[2]; \
+    for (enable=0;enable<2;enable++) { \
+      ps_sdraw_set_kernels_enabled(enable); \
+      costv[enable]=expr; \
+      PS_ASSERT(costv[enable]>=0.0) \
+    } \
+    ps_log(TEST,INFO,"%-24s %10.3f %10.3f %8.2f",label,costv[0],costv[1],costv[0]/costv[1]); \
+  }
+  MEASURE("maxtile plain 16",sprite_cost_maxtile(fb,sprites,&plain))
+  MEASURE("maxtile effects 16",sprite_cost_maxtile(fb,sprites,&fancy))
+  MEASURE("maxtile effects 24",sprite_cost_maxtile(fb,sprites,&scaled))
+  MEASURE("maxtile rotated 16",sprite_cost_maxtile(fb,sprites,&rotated))
+  MEASURE("mintile RGBX 16",sprite_cost_mintile(fb,tiles,16))
+  MEASURE("mintile RGBX 32",sprite_cost_mintile(fb,tiles,32))
+  MEASURE("mintile RGBA 32",sprite_cost_mintile(fb,sprites,32))
+  MEASURE("textile 8x16",sprite_cost_textile(fb,font,16))
+  MEASURE("textile 12x24",sprite_cost_textile(fb,font,24))
+  #undef MEASURE
+  ps_sdraw_set_kernels_enabled(1);
+
+  ps_sdraw_image_del(fb);
+  ps_sdraw_image_del(sprites);
+  ps_sdraw_image_del(tiles);
+  ps_sdraw_image_del(font);
+  return 0;
+}
+
+/* Cost of drawing the grid background alone, headless, with and without the cached background layer.
+ * Each case draws one frame's grid repeatedly through the real video layer machinery.
+ * (changec) cells change before each frame, or all of them if negative.
+ */
+
+#define GRID_COST_DRAWC 20000
+
+static struct ps_grid *grid_cost_grid=0;
+
+static int grid_cost_layer_draw(struct ps_video_layer *layer) {
+  return ps_video_draw_grid(grid_cost_grid,0,0);
+}
+
+static double grid_cost_measure(struct ps_grid *grida,struct ps_grid *gridb,int changec,int alternate) {
+  clock_t starttime=clock();
+  int i=0; for (;i<GRID_COST_DRAWC;i++) {
+    if (changec<0) {
+      int j=PS_GRID_SIZE; while (j-->0) grida->cellv[j].tileid++;
+    } else {
+      int j=changec; while (j-->0) grida->cellv[rand()%PS_GRID_SIZE].tileid=rand();
+    }
+    grid_cost_grid=(alternate&&(i&1))?gridb:grida;
+    if (ps_video_test_draw(1)<0) return -1.0;
+  }
+  clock_t elapsed=clock()-starttime;
+  return (elapsed*1000000.0)/((double)CLOCKS_PER_SEC*GRID_COST_DRAWC);
+}
+
+PS_TEST(test_rendering_grid_cost,ignore,performance,video) {
+  ps_resmgr_quit();
+  ps_video_quit();
+  PS_ASSERT_CALL(ps_video_init_headless())
+  PS_ASSERT_CALL(ps_resmgr_init("src/data",0))
+
+  struct ps_restype *regions=ps_resmgr.typev+PS_RESTYPE_REGION;
+  PS_ASSERT_INTS_OP(regions->resc,>,0)
+  struct ps_region *region=ps_res_get(PS_RESTYPE_REGION,regions->resv[0].id);
+  PS_ASSERT(region)
+
+  struct ps_video_layer *layer=ps_video_layer_new(sizeof(struct ps_video_layer));
+  PS_ASSERT(layer)
+  layer->blackout=1;
+  layer->draw=grid_cost_layer_draw;
+  PS_ASSERT_CALL(ps_video_install_layer(layer,-1))
+  ps_video_layer_del(layer);
+
+  struct ps_grid *grida=ps_grid_new();
+  struct ps_grid *gridb=ps_grid_new();
+  PS_ASSERT(grida&&gridb)
+  grida->region=region;
+  gridb->region=region;
+  int i=0; for (;i<PS_GRID_SIZE;i++) {
+    grida->cellv[i].tileid=rand();
+    gridb->cellv[i].tileid=rand();
+  }
+
+  ps_log(TEST,INFO,"%-24s %10s %10s %8s","frame","direct us","cached us","speedup");
+  int enable;
+  #define MEASURE(label,changec,alternate) { \
+    double costv[2]; \
+    for (enable=0;enable<2;enable++) { \
+      ps_video_set_grid_cache_enabled(enable); \
+      costv[enable]=grid_cost_measure(grida,gridb,changec,alternate); \
+      PS_ASSERT(costv[enable]>=0.0) \
+    } \
+    ps_log(TEST,INFO,"%-24s %10.3f %10.3f %8.2f",label,costv[0],costv[1],costv[0]/costv[1]); \
+  }
+  MEASURE("static",0,0)
+  MEASURE("1 cell changed",1,0)
+  MEASURE("8 cells changed",8,0)
+  MEASURE("two screens alternating",0,1)
+  MEASURE("every cell changed",-1,0)
+  #undef MEASURE
+  ps_video_set_grid_cache_enabled(1);
+
+  grid_cost_grid=0;
+  ps_grid_del(grida);
+  ps_grid_del(gridb);
+  ps_resmgr_quit();
+  ps_video_quit();
+  return 0;
+}
+
+/* Draw calls per frame in a real game, headless, with and without the tilesheet atlas.
+ * Each scene is the test game with optionally some monster deaths (fireworks and prizes),
+ * and a crowd instantiated round-robin from every sprdef, which mixes tilesheets about as badly as a busy screen can.
+ * Then a few updates, so every sprite has been through its type's update before drawing.
+ */
+
+#define DRAW_CALLS_FRAMEC 60
+
+static int draw_calls_measure(int *cmdc,clock_t *elapsed,struct ps_game *game,int updatec,int deathc,int crowdc) {
+  PS_ASSERT_CALL(ps_game_restart(game))
+  PS_ASSERT_CALL(ps_particles_clear(game->particles)) // Restart leaves the fireworks from last time.
+  srand(1234);
+  int i=deathc; while (i-->0) {
+    PS_ASSERT_CALL(ps_game_decorate_monster_death(game,40+(i*97)%(PS_SCREENW-80),40+(i*61)%(PS_SCREENH-80)))
+  }
+  const struct ps_restype *sprdefs=ps_resmgr.typev+PS_RESTYPE_SPRDEF;
+  PS_ASSERT_INTS_OP(sprdefs->resc,>,0)
+  for (i=0;i<crowdc;i++) {
+    struct ps_sprdef *sprdef=sprdefs->resv[i%sprdefs->resc].obj;
+    int x=16+rand()%(PS_SCREENW-32),y=16+rand()%(PS_SCREENH-32);
+    PS_ASSERT(ps_sprdef_instantiate(game,sprdef,0,0,x,y))
+  }
+  for (i=updatec;i-->0;) {
+    PS_ASSERT_CALL(ps_game_update(game))
+  }
+  akgl_log_command_count();
+  clock_t starttime=clock();
+  PS_ASSERT_CALL(ps_video_test_draw(DRAW_CALLS_FRAMEC))
+  *elapsed=clock()-starttime;
+  *cmdc=akgl_get_command_count();
+  return 0;
+}
+
+PS_TEST(test_rendering_draw_calls,ignore,performance,video) {
+  ps_resmgr_quit();
+  ps_video_quit();
+  PS_ASSERT_CALL(ps_video_init_headless())
+  PS_ASSERT_CALL(ps_input_init())
+  PS_ASSERT_CALL(ps_resmgr_init("src/data",0))
+
+  struct ps_userconfig *userconfig=ps_userconfig_new();
+  PS_ASSERT(userconfig)
+  PS_ASSERT_CALL(ps_userconfig_declare_default_fields(userconfig))
+  struct ps_game *game=ps_game_new(userconfig);
+  PS_ASSERT(game)
+  PS_ASSERT_CALL(ps_game_set_player_count(game,1))
+  PS_ASSERT_CALL(ps_game_configure_player(game,1,1,0,0))
+  PS_ASSERT_CALL(ps_game_set_seed(game,1234))
+  PS_ASSERT_CALL(ps_game_generate_test(game,-1,2,1))
+
+  ps_log(TEST,INFO,"%-24s %8s %8s %8s %10s %10s","scene","sprites","calls","atlas","us","atlas us");
+  int enable;
+  #define MEASURE(label,updatec,deathc,crowdc) { \
+    int cmdcv[2]; \
+    clock_t elapsedv[2]; \
+    for (enable=0;enable<2;enable++) { \
+      ps_video_set_atlas_enabled(enable); \
+      PS_ASSERT_CALL(draw_calls_measure(cmdcv+enable,elapsedv+enable,game,updatec,deathc,crowdc)) \
+    } \
+    ps_log(TEST,INFO,"%-24s %8d %8.1f %8.1f %10.2f %10.2f", \
+      label,game->grpv[PS_SPRGRP_VISIBLE].sprc, \
+      cmdcv[0]/(double)DRAW_CALLS_FRAMEC,cmdcv[1]/(double)DRAW_CALLS_FRAMEC, \
+      (elapsedv[0]*1000000.0)/((double)CLOCKS_PER_SEC*DRAW_CALLS_FRAMEC), \
+      (elapsedv[1]*1000000.0)/((double)CLOCKS_PER_SEC*DRAW_CALLS_FRAMEC) \
+    ); \
+  }
+  MEASURE("start",5,0,0)
+  MEASURE("5 deaths",5,5,0)
+  MEASURE("crowd of 20",5,0,20)
+  MEASURE("crowd of 100",5,0,100)
+  MEASURE("crowd of 100, 5 deaths",5,5,100)
+  #undef MEASURE
+  ps_video_set_atlas_enabled(1);
+
+  ps_game_del(game);
+  ps_userconfig_del(userconfig);
+  ps_resmgr_quit();
+  ps_input_quit();
+  ps_video_quit();
+  return 0;
+}
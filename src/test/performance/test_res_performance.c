@@ -0,0 +1,176 @@
+/* test_res_performance.c
+ *
+ * Compare startup against the old whole-archive zlib format and the indexed format.
+ * We export both from src/data (minus IPCM and SONG, which only encode in respack's fallback mode),
+ * then load each one in a fresh child process so the resident sizes don't contaminate each other.
+ * Each log entry is: format, archive size, microseconds per ps_resmgr_init,
+ * resident KB gained by init, and resident KB gained after decoding everything too.
+ *
+ * TEST RESULTS: Linux x86_64, -O2, headless (tilesheets keep their pixels in memory).
+TEST:INFO: zlib       180750 bytes    7090 us init   2452 KB init   2452 KB all [src/test/performance/test_res_performance.c:115]
+TEST:INFO: indexed    181344 bytes      16 us init    296 KB init   2428 KB all [src/test/performance/test_res_performance.c:115]
+TEST:INFO: zlib       180750 bytes    5711 us init   2372 KB init   2372 KB all [src/test/performance/test_res_performance.c:115]
+TEST:INFO: indexed    181344 bytes      12 us init    288 KB init   2348 KB all [src/test/performance/test_res_performance.c:115]
+ *
+ * test_res_parallel_decode:
+ * Microseconds to load everything, by decoder thread count. Same build, but on a single-core machine,
+ * so this only shows that the extra threads cost nothing; expect tilesheets and images to divide on real hardware.
+TEST:INFO:              1 thread  2 threads  4 threads [src/test/performance/test_res_performance.c:151]
+TEST:INFO: directory       19128      20410      20773 [src/test/performance/test_res_performance.c:163]
+TEST:INFO: zlib            11906      11355       9351 [src/test/performance/test_res_performance.c:163]
+TEST:INFO: indexed          8531       8371       9064 [src/test/performance/test_res_performance.c:163]
+ */
+
+#include "test/ps_test.h"
+#include "res/ps_res_internal.h"
+#include "os/ps_fs.h"
+#include "os/ps_clockassist.h"
+
+#if PS_ARCH!=PS_ARCH_mswin
+  #include <unistd.h>
+  #include <sys/wait.h>
+#endif
+
+#define TEST_RES_PERF_ZLIB "mid/test/res/perf-zlib"
+#define TEST_RES_PERF_INDEXED "mid/test/res/perf-indexed"
+#define TEST_RES_PERF_REPC 20
+
+struct test_res_perf_result {
+  int64_t us;
+  int64_t init_kb;
+  int64_t all_kb;
+};
+
+#if PS_ARCH!=PS_ARCH_mswin
+
+static int64_t test_res_perf_rss_kb() {
+  FILE *f=fopen("/proc/self/statm","r");
+  if (!f) return -1;
+  long long pages=0,resident=0;
+  int c=fscanf(f,"%lld %lld",&pages,&resident);
+  fclose(f);
+  if (c<2) return -1;
+  return (resident*sysconf(_SC_PAGESIZE))>>10;
+}
+
+/* Runs in the child process.
+ * One untimed load for the resident-size figures, then a batch of timed loads.
+ */
+
+static int test_res_perf_measure(struct test_res_perf_result *result,const char *path) {
+  ps_resmgr_quit();
+  int64_t rss0=test_res_perf_rss_kb();
+  if (ps_resmgr_init(path,0)<0) return -1;
+  result->init_kb=test_res_perf_rss_kb()-rss0;
+  int tid=0; for (;tid<PS_RESTYPE_COUNT;tid++) {
+    if (ps_restype_require_all(ps_resmgr.typev+tid)<0) return -1;
+  }
+  result->all_kb=test_res_perf_rss_kb()-rss0;
+  ps_resmgr_quit();
+
+  int64_t elapsed=0;
+  int i=0; for (;i<TEST_RES_PERF_REPC;i++) {
+    int64_t start=ps_time_now();
+    if (ps_resmgr_init(path,0)<0) return -1;
+    elapsed+=ps_time_now()-start;
+    ps_resmgr_quit();
+  }
+  result->us=elapsed/TEST_RES_PERF_REPC;
+  return 0;
+}
+
+static int test_res_perf_fork(struct test_res_perf_result *result,const char *path) {
+  int fdv[2];
+  if (pipe(fdv)<0) return -1;
+  pid_t pid=fork();
+  if (pid<0) return -1;
+  if (!pid) {
+    close(fdv[0]);
+    ps_log_level_by_domain[PS_LOG_DOMAIN_RES]=PS_LOG_LEVEL_WARN;
+    if (test_res_perf_measure(result,path)<0) _exit(1);
+    if (write(fdv[1],result,sizeof(struct test_res_perf_result))!=sizeof(struct test_res_perf_result)) _exit(1);
+    _exit(0);
+  }
+  close(fdv[1]);
+  int c=read(fdv[0],result,sizeof(struct test_res_perf_result));
+  close(fdv[0]);
+  int status=0;
+  waitpid(pid,&status,0);
+  if (c!=sizeof(struct test_res_perf_result)) return -1;
+  return 0;
+}
+
+#endif
+
+PS_TEST(test_res_startup_cost,ignore,performance,res) {
+  #if PS_ARCH!=PS_ARCH_mswin
+    ps_resmgr_quit();
+    PS_ASSERT_CALL(ps_resmgr_init("src/data",0))
+    PS_ASSERT_CALL(ps_restype_clear(ps_resmgr.typev+PS_RESTYPE_IPCM))
+    PS_ASSERT_CALL(ps_restype_clear(ps_resmgr.typev+PS_RESTYPE_SONG))
+    PS_ASSERT_CALL(ps_mkdir_parents(TEST_RES_PERF_ZLIB))
+    PS_ASSERT_CALL(ps_res_export_archive(TEST_RES_PERF_ZLIB))
+    PS_ASSERT_CALL(ps_res_export_indexed_archive(TEST_RES_PERF_INDEXED))
+    ps_resmgr_quit();
+
+    const char *namev[2]={"zlib","indexed"};
+    const char *pathv[2]={TEST_RES_PERF_ZLIB,TEST_RES_PERF_INDEXED};
+    int i=0; for (;i<2;i++) {
+      struct test_res_perf_result result={0};
+      PS_ASSERT_CALL(test_res_perf_fork(&result,pathv[i]),"%s",pathv[i])
+      void *serial=0;
+      int serialc=ps_file_read(&serial,pathv[i]);
+      PS_ASSERT_INTS_OP(serialc,>,0)
+      free(serial);
+      ps_log(TEST,INFO,"%-8s %8d bytes %7d us init %6d KB init %6d KB all",
+        namev[i],serialc,(int)result.us,(int)result.init_kb,(int)result.all_kb
+      );
+    }
+  #endif
+  return 0;
+}
+
+/* Wall-clock load time by decoder thread count.
+ * "indexed" is init plus ps_resmgr_require_all(), which is the only batched decode for that format.
+ */
+
+static int test_res_perf_load(const char *path,int require_all) {
+  if (ps_resmgr_init(path,0)<0) return -1;
+  if (require_all&&(ps_resmgr_require_all()<0)) return -1;
+  ps_resmgr_quit();
+  return 0;
+}
+
+PS_TEST(test_res_parallel_decode,ignore,performance,res) {
+  ps_resmgr_quit();
+  PS_ASSERT_CALL(ps_resmgr_init("src/data",0))
+  PS_ASSERT_CALL(ps_restype_clear(ps_resmgr.typev+PS_RESTYPE_IPCM))
+  PS_ASSERT_CALL(ps_restype_clear(ps_resmgr.typev+PS_RESTYPE_SONG))
+  PS_ASSERT_CALL(ps_mkdir_parents(TEST_RES_PERF_ZLIB))
+  PS_ASSERT_CALL(ps_res_export_archive(TEST_RES_PERF_ZLIB))
+  PS_ASSERT_CALL(ps_res_export_indexed_archive(TEST_RES_PERF_INDEXED))
+  ps_resmgr_quit();
+
+  int loglevel=ps_log_level_by_domain[PS_LOG_DOMAIN_RES];
+  ps_log_level_by_domain[PS_LOG_DOMAIN_RES]=PS_LOG_LEVEL_WARN;
+  const char *namev[3]={"directory","zlib","indexed"};
+  const char *pathv[3]={"src/data",TEST_RES_PERF_ZLIB,TEST_RES_PERF_INDEXED};
+  const int threadcv[3]={1,2,4};
+  ps_log(TEST,INFO,"%-10s %10s %10s %10s","","1 thread","2 threads","4 threads");
+  int i=0; for (;i<3;i++) {
+    double usv[3];
+    int t=0; for (;t<3;t++) {
+      ps_resmgr_set_decode_thread_count(threadcv[t]);
+      PS_ASSERT_CALL(test_res_perf_load(pathv[i],i==2),"%s",pathv[i])
+      int64_t start=ps_time_now();
+      int r=0; for (;r<TEST_RES_PERF_REPC;r++) {
+        PS_ASSERT_CALL(test_res_perf_load(pathv[i],i==2),"%s",pathv[i])
+      }
+      usv[t]=(double)(ps_time_now()-start)/TEST_RES_PERF_REPC;
+    }
+    ps_log(TEST,INFO,"%-10s %10.0f %10.0f %10.0f",namev[i],usv[0],usv[1],usv[2]);
+  }
+  ps_log_level_by_domain[PS_LOG_DOMAIN_RES]=loglevel;
+  ps_resmgr_set_decode_thread_count(0);
+  return 0;
+}
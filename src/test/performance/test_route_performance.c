@@ -0,0 +1,153 @@
+/* test_route_performance.c
+ *
+ * Generate worlds at every length and compare the bloodhound's question, "which way to the nearest treasure?",
+ * answered the old way (depth-first search over every simple path, once per treasure)
+ * against the scenario's route table.
+ * We ask once from every screen in the world.
+ * Each log entry is: length, world size, screen count, treasure count,
+ * microseconds to build the table, then microseconds per question for search and for table.
+ *
+ * The old search isn't exponential on these worlds only because scgen makes them nearly trees.
+ *
+ * TEST RESULTS: Linux x86_64, -O2.
+TEST:INFO: length  size screens treasures   build us    search us   table us [src/test/performance/test_route_performance.c:102]
+TEST:INFO:      1  3x4       12         1          2        0.833      0.250 [src/test/performance/test_route_performance.c:132]
+TEST:INFO:      2  4x4       16         2          4        3.062      0.000 [src/test/performance/test_route_performance.c:132]
+TEST:INFO:      3  5x4       20         3          5        4.350      0.100 [src/test/performance/test_route_performance.c:132]
+TEST:INFO:      4  6x5       30         5         12        8.000      0.000 [src/test/performance/test_route_performance.c:132]
+TEST:INFO:      5  6x6       36         6         15       11.389      0.167 [src/test/performance/test_route_performance.c:132]
+TEST:INFO:      6  9x6       54         9         39       27.537      0.093 [src/test/performance/test_route_performance.c:132]
+TEST:INFO:      7  9x8       72        12         71       49.514      0.194 [src/test/performance/test_route_performance.c:132]
+TEST:INFO:      8 10x8       80        14         88      103.888      0.237 [src/test/performance/test_route_performance.c:132]
+TEST:INFO:      9 12x9      108        16        140       97.102      0.315 [src/test/performance/test_route_performance.c:132]
+ */
+
+#include "test/ps_test.h"
+#include "res/ps_resmgr.h"
+#include "scenario/ps_scgen.h"
+#include "scenario/ps_scenario.h"
+#include "scenario/ps_screen.h"
+#include "game/ps_path.h"
+#include "os/ps_clockassist.h"
+
+/* The search we used to do, verbatim save for names.
+ */
+
+static int test_route_dfs_1(int *distance,const struct ps_scenario *scenario,int dstx,int dsty,int srcx,int srcy,struct ps_path *path) {
+  if ((srcx<0)||(srcx>=scenario->w)) return -1;
+  if ((srcy<0)||(srcy>=scenario->h)) return -1;
+  if ((dstx==srcx)&&(dsty==srcy)) return 0;
+  if (ps_path_has(path,srcx,srcy)) return -1;
+  if (ps_path_add(path,srcx,srcy)<0) return -1;
+
+  (*distance)++;
+  int distance0=(*distance);
+  int screenc0=path->c,eastd=INT_MAX,westd=INT_MAX,northd=INT_MAX,southd=INT_MAX;
+  const struct ps_screen *screen=scenario->screenv+srcy*scenario->w+srcx;
+
+  if (screen->doorw==PS_DOOR_OPEN) {
+    path->c=screenc0;
+    *distance=distance0;
+    if (test_route_dfs_1(distance,scenario,dstx,dsty,srcx-1,srcy,path)>=0) westd=*distance;
+  }
+  if (screen->doore==PS_DOOR_OPEN) {
+    path->c=screenc0;
+    *distance=distance0;
+    if (test_route_dfs_1(distance,scenario,dstx,dsty,srcx+1,srcy,path)>=0) eastd=*distance;
+  }
+  if (screen->doorn==PS_DOOR_OPEN) {
+    path->c=screenc0;
+    *distance=distance0;
+    if (test_route_dfs_1(distance,scenario,dstx,dsty,srcx,srcy-1,path)>=0) northd=*distance;
+  }
+  if (screen->doors==PS_DOOR_OPEN) {
+    path->c=screenc0;
+    *distance=distance0;
+    if (test_route_dfs_1(distance,scenario,dstx,dsty,srcx,srcy+1,path)>=0) southd=*distance;
+  }
+
+  if ((westd<=eastd)&&(westd<=northd)&&(westd<=southd)) { *distance=westd; return PS_DIRECTION_WEST; }
+  if ((eastd<=northd)&&(eastd<=southd)) { *distance=eastd; return PS_DIRECTION_EAST; }
+  if (northd<=southd) { *distance=northd; return PS_DIRECTION_NORTH; }
+  if (southd<INT_MAX) { *distance=southd; return PS_DIRECTION_SOUTH; }
+  return -1;
+}
+
+static int test_route_dfs(int *distance,const struct ps_scenario *scenario,int dstx,int dsty,int srcx,int srcy) {
+  if ((dstx==srcx)&&(dsty==srcy)) { *distance=0; return 0; }
+  struct ps_path path={0};
+  *distance=0;
+  int direction=test_route_dfs_1(distance,scenario,dstx,dsty,srcx,srcy,&path);
+  ps_path_cleanup(&path);
+  return direction;
+}
+
+/* Nearest treasure from (srcx,srcy), by either method.
+ */
+
+static int test_route_nearest_treasure(struct ps_scenario *scenario,int srcx,int srcy,int use_table) {
+  int best_direction=-1,best_distance=INT_MAX;
+  const struct ps_screen *screen=scenario->screenv;
+  int i=scenario->w*scenario->h; for (;i-->0;screen++) {
+    if (!(screen->features&PS_SCREEN_FEATURE_TREASURE)) continue;
+    int distance=0,direction;
+    if (use_table) {
+      if ((distance=ps_scenario_get_route(&direction,scenario,screen->x,screen->y,srcx,srcy))<0) continue;
+    } else {
+      if ((direction=test_route_dfs(&distance,scenario,screen->x,screen->y,srcx,srcy))<0) continue;
+    }
+    if (distance<best_distance) {
+      best_distance=distance;
+      best_direction=direction;
+    }
+  }
+  return best_direction;
+}
+
+PS_TEST(test_route_table_cost,ignore,performance,scenario) {
+  ps_log_level_by_domain[PS_LOG_DOMAIN_RES]=PS_LOG_LEVEL_WARN;
+  ps_log_level_by_domain[PS_LOG_DOMAIN_GENERATOR]=PS_LOG_LEVEL_WARN;
+  ps_resmgr_quit();
+  PS_ASSERT_CALL(ps_resmgr_init("src/data",0))
+  struct ps_scgen *scgen=ps_scgen_new();
+  PS_ASSERT(scgen)
+  ps_log(TEST,INFO,"%6s %5s %7s %9s %10s %12s %10s","length","size","screens","treasures","build us","search us","table us");
+
+  int length=PS_LENGTH_MIN; for (;length<=PS_LENGTH_MAX;length++) {
+    scgen->seed=length;
+    scgen->playerc=2;
+    scgen->skills=PS_SKILL_HOOKSHOT|PS_SKILL_ARROW|PS_SKILL_SWORD|PS_SKILL_COMBAT;
+    scgen->difficulty=5;
+    scgen->length=length;
+    PS_ASSERT_CALL(ps_scgen_generate(scgen),"length=%d: %.*s",length,scgen->msgc,scgen->msg)
+    struct ps_scenario *scenario=scgen->scenario;
+    int screenc=scenario->w*scenario->h;
+    int treasurec=0,i;
+    for (i=0;i<screenc;i++) if (scenario->screenv[i].features&PS_SCREEN_FEATURE_TREASURE) treasurec++;
+
+    int64_t start=ps_time_now();
+    PS_ASSERT_CALL(ps_scenario_build_routes(scenario))
+    int64_t build_us=ps_time_now()-start;
+
+    int64_t search_us=0,table_us=0;
+    for (i=0;i<screenc;i++) {
+      int x=i%scenario->w,y=i/scenario->w;
+      start=ps_time_now();
+      int expect=test_route_nearest_treasure(scenario,x,y,0);
+      search_us+=ps_time_now()-start;
+      start=ps_time_now();
+      int actual=test_route_nearest_treasure(scenario,x,y,1);
+      table_us+=ps_time_now()-start;
+      PS_ASSERT_INTS(actual,expect,"length=%d from (%d,%d)",length,x,y)
+    }
+
+    ps_log(TEST,INFO,"%6d %2dx%-2d %7d %9d %10d %12.3f %10.3f",
+      length,scenario->w,scenario->h,screenc,treasurec,(int)build_us,
+      (double)search_us/screenc,(double)table_us/screenc
+    );
+  }
+
+  ps_scgen_del(scgen);
+  ps_resmgr_quit();
+  return 0;
+}
@@ -0,0 +1,135 @@
+/* test_scgen_performance.c
+ *
+ * Generate a pool of scenarios at every difficulty and length with ps_scgen_batch, validate them all,
+ * and report generation time percentiles for each combination.
+ * Each percentile entry is: difficulty, length, scenarios, failures, then p50, p95, p99 in microseconds.
+ * After that, throughput of the whole pool at 1 thread and at one per core.
+ * Watch p99 for regressions; a single pathological seed shows up there long before it moves the median.
+ *
+ * With 32 per cell, p99 is effectively the worst seed.
+ * This machine has one core, so "cores" is one worker plus pool overhead; expect it to scale on real hardware.
+ *
+ * TEST RESULTS: Linux x86_64, -O2, 1 core. Percentiles trimmed to a few rows.
+TEST:INFO: diff length   count fail      p50 us      p95 us      p99 us [src/test/performance/test_scgen_performance.c:93]
+TEST:INFO:    1      1      32    0        3571        4732        4820 [src/test/performance/test_scgen_performance.c:109]
+TEST:INFO:    1      9      32    0       35113       40904       42500 [src/test/performance/test_scgen_performance.c:109]
+TEST:INFO:    5      5      32    0       13029       14102       14722 [src/test/performance/test_scgen_performance.c:109]
+TEST:INFO:    9      1      32    0        4896        5219        8061 [src/test/performance/test_scgen_performance.c:109]
+TEST:INFO:    9      9      32    0       40673       42548       48378 [src/test/performance/test_scgen_performance.c:109]
+TEST:INFO: threads   count    wall ms  scenarios/s [src/test/performance/test_scgen_performance.c:119]
+TEST:INFO:       1    2592      45294         57.2 [src/test/performance/test_scgen_performance.c:126]
+TEST:INFO:   cores    2592      47324         54.8 [src/test/performance/test_scgen_performance.c:126]
+ */
+
+#include "test/ps_test.h"
+#include "res/ps_resmgr.h"
+#include "scenario/ps_scgen.h"
+#include "scenario/ps_scgen_batch.h"
+#include "scenario/ps_scenario.h"
+#include "os/ps_clockassist.h"
+
+#define TEST_SCGEN_POOL_PER_CELL 32
+#define TEST_SCGEN_CELLC ((PS_DIFFICULTY_MAX-PS_DIFFICULTY_MIN+1)*(PS_LENGTH_MAX-PS_LENGTH_MIN+1))
+#define TEST_SCGEN_JOBC (TEST_SCGEN_CELLC*TEST_SCGEN_POOL_PER_CELL)
+
+static int test_scgen_cmp_int64(const void *a,const void *b) {
+  int64_t A=*(const int64_t*)a,B=*(const int64_t*)b;
+  if (A<B) return -1;
+  if (A>B) return 1;
+  return 0;
+}
+
+/* Nearest-rank percentile of a sorted list.
+ */
+
+static int64_t test_scgen_percentile(const int64_t *v,int c,int pct) {
+  if (c<1) return 0;
+  int p=(c*pct+99)/100-1;
+  if (p<0) p=0;
+  if (p>=c) p=c-1;
+  return v[p];
+}
+
+/* Fill (jobv) with a fixed pool: every difficulty and length, a spread of party sizes and skills, distinct seeds.
+ */
+
+static void test_scgen_populate_jobs(struct ps_scgen_batch_job *jobv) {
+  const uint16_t skillsv[]={
+    PS_SKILL_SWORD|PS_SKILL_COMBAT,
+    PS_SKILL_ARROW|PS_SKILL_HOOKSHOT|PS_SKILL_COMBAT,
+    PS_SKILL_SWORD|PS_SKILL_HOOKSHOT|PS_SKILL_FLAME|PS_SKILL_COMBAT,
+    PS_SKILL_SWORD|PS_SKILL_ARROW|PS_SKILL_HOOKSHOT|PS_SKILL_FLAME|PS_SKILL_HEAL|PS_SKILL_FLY|PS_SKILL_COMBAT,
+  };
+  const int skillsc=sizeof(skillsv)/sizeof(skillsv[0]);
+  struct ps_scgen_batch_job *job=jobv;
+  uint32_t seed=1;
+  int difficulty,length,i;
+  for (difficulty=PS_DIFFICULTY_MIN;difficulty<=PS_DIFFICULTY_MAX;difficulty++) {
+    for (length=PS_LENGTH_MIN;length<=PS_LENGTH_MAX;length++) {
+      for (i=0;i<TEST_SCGEN_POOL_PER_CELL;i++,job++) {
+        job->difficulty=difficulty;
+        job->length=length;
+        job->playerc=1+i%4;
+        job->skills=skillsv[i%skillsc];
+        job->seed=seed++;
+      }
+    }
+  }
+}
+
+PS_TEST(test_scgen_batch_throughput,ignore,performance,scgen) {
+  ps_log_level_by_domain[PS_LOG_DOMAIN_RES]=PS_LOG_LEVEL_WARN;
+  ps_log_level_by_domain[PS_LOG_DOMAIN_GENERATOR]=PS_LOG_LEVEL_WARN;
+  ps_resmgr_quit();
+  PS_ASSERT_CALL(ps_resmgr_init("src/data",0))
+
+  struct ps_scgen_batch_job *jobv=calloc(TEST_SCGEN_JOBC,sizeof(struct ps_scgen_batch_job));
+  PS_ASSERT(jobv)
+  test_scgen_populate_jobs(jobv);
+
+  /* Percentiles per difficulty and length, from a run with one worker per core. */
+  int failc=ps_scgen_batch_run(jobv,TEST_SCGEN_JOBC,0);
+  PS_ASSERT_CALL(failc)
+  ps_log(TEST,INFO,"%4s %6s %7s %4s %11s %11s %11s","diff","length","count","fail","p50 us","p95 us","p99 us");
+  int cellp=0; for (;cellp<TEST_SCGEN_CELLC;cellp++) {
+    const struct ps_scgen_batch_job *job=jobv+cellp*TEST_SCGEN_POOL_PER_CELL;
+    int64_t elapsedv[TEST_SCGEN_POOL_PER_CELL];
+    int elapsedc=0,cellfailc=0,i;
+    for (i=0;i<TEST_SCGEN_POOL_PER_CELL;i++,job++) {
+      if (job->result<0) {
+        ps_log(TEST,ERROR,"difficulty=%d length=%d playerc=%d skills=0x%04x seed=%u: %s",
+          job->difficulty,job->length,job->playerc,job->skills,job->seed,job->msg
+        );
+        cellfailc++;
+      }
+      if (job->scenario) elapsedv[elapsedc++]=job->elapsed_us;
+    }
+    qsort(elapsedv,elapsedc,sizeof(int64_t),test_scgen_cmp_int64);
+    job-=TEST_SCGEN_POOL_PER_CELL;
+    ps_log(TEST,INFO,"%4d %6d %7d %4d %11d %11d %11d",
+      job->difficulty,job->length,TEST_SCGEN_POOL_PER_CELL,cellfailc,
+      (int)test_scgen_percentile(elapsedv,elapsedc,50),
+      (int)test_scgen_percentile(elapsedv,elapsedc,95),
+      (int)test_scgen_percentile(elapsedv,elapsedc,99)
+    );
+  }
+  PS_ASSERT_INTS(failc,0,"Some generated scenarios were invalid.")
+
+  /* Throughput of the whole pool, serial and parallel. */
+  ps_log(TEST,INFO,"%7s %7s %10s %12s","threads","count","wall ms","scenarios/s");
+  int threadcv[]={1,0};
+  int i; for (i=0;i<2;i++) {
+    int64_t start=ps_time_now();
+    PS_ASSERT_INTS(ps_scgen_batch_run(jobv,TEST_SCGEN_JOBC,threadcv[i]),0)
+    int64_t elapsed=ps_time_now()-start;
+    if (elapsed<1) elapsed=1;
+    ps_log(TEST,INFO,"%7s %7d %10d %12.1f",
+      threadcv[i]?"1":"cores",TEST_SCGEN_JOBC,(int)(elapsed/1000),(TEST_SCGEN_JOBC*1000000.0)/elapsed
+    );
+  }
+
+  ps_scgen_batch_cleanup(jobv,TEST_SCGEN_JOBC);
+  free(jobv);
+  ps_resmgr_quit();
+  return 0;
+}
@@ -0,0 +1,116 @@
+/* test_songprinter_performance.c
+ *
+ * Print every song in src/data with 1, 2, 4, and 8 worker threads, and the old way through one mixer for reference.
+ * Times are wall clock, since the point is to spread work across cores.
+ * Each log entry is: threads, total ms to print all songs, speedup over serial, mean ms until ready to stream.
+ * Each range skips through a few beats of preroll first, so one thread runs slightly slower than serial.
+ * Speedup can only approach the core count: The results below are from a single-core machine, so they show the overhead only.
+ *
+ * TEST RESULTS: Linux x86_64, -O2, 1 core.
+TEST:INFO:  serial      204.2     1.00          -
+TEST:INFO:       1      217.5     0.94        1.8
+TEST:INFO:       2      227.5     0.90        5.5
+TEST:INFO:       4      243.5     0.84       10.3
+TEST:INFO:       8      338.1     0.60       23.4
+ */
+
+#include "test/ps_test.h"
+#include "akau/akau.h"
+#include "akau/akau_songprinter.h"
+#include "res/ps_resmgr.h"
+#include "os/ps_clockassist.h"
+
+static int silent_init(const char *device,int rate,int chanc,akau_cb_fn cb) { return 0; }
+static void silent_quit() {}
+static int silent_lock() { return 0; }
+static int silent_unlock() { return 0; }
+
+static const struct akau_driver silent_driver={
+  .init=silent_init,
+  .quit=silent_quit,
+  .lock=silent_lock,
+  .unlock=silent_unlock,
+};
+
+static int64_t print_serially(struct akau_song *song) {
+  int64_t start=ps_time_now();
+  struct akau_songprinter *printer=akau_songprinter_new(song); // Only to size the output.
+  if (!printer) return -1;
+  struct akau_ipcm *ipcm=akau_songprinter_get_ipcm_even_if_incomplete(printer);
+  struct akau_mixer *mixer=akau_mixer_new();
+  if (!mixer) return -1;
+  if (akau_mixer_set_stereo(mixer,0)<0) return -1;
+  if (akau_mixer_set_print_songs(mixer,0)<0) return -1;
+  if (akau_mixer_play_song(mixer,song,1,0)<0) return -1;
+  if (akau_mixer_update(akau_ipcm_get_sample_buffer(ipcm),akau_ipcm_get_sample_count(ipcm),mixer)<0) return -1;
+  akau_mixer_del(mixer);
+  akau_songprinter_del(printer);
+  return ps_time_now()-start;
+}
+
+/* Print asynchronously and poll for readiness to stream, like the mixer does.
+ */
+
+static int64_t print_parallel(int64_t *stream_time,struct akau_song *song,int threadc) {
+  int64_t start=ps_time_now();
+  struct akau_songprinter *printer=akau_songprinter_new(song);
+  if (!printer) return -1;
+  if (akau_songprinter_set_thread_count(printer,threadc)<0) return -1;
+  if (akau_songprinter_begin(printer)<0) return -1;
+  *stream_time=-1;
+  while (1) {
+    int progress=akau_songprinter_get_progress(printer);
+    if (progress<0) return -1;
+    if ((*stream_time<0)&&akau_songprinter_ready_to_stream(printer)) *stream_time=ps_time_now()-start;
+    if (progress>=AKAU_SONGPRINTER_PROGRESS_READY) break;
+    ps_time_sleep(1000);
+  }
+  if (akau_songprinter_finish(printer)<0) return -1;
+  akau_songprinter_del(printer);
+  return ps_time_now()-start;
+}
+
+PS_TEST(test_songprinter_parallel_performance,ignore,performance,songprinter) {
+  akau_quit();
+  PS_ASSERT_CALL(akau_init(&silent_driver,0,0,44100,2))
+  ps_resmgr_quit();
+  PS_ASSERT_CALL(ps_resmgr_init("src/data",0))
+
+  struct akau_song *songv[100];
+  int songc=0,songid=1;
+  for (;songid<100;songid++) {
+    struct akau_song *song=ps_res_get(PS_RESTYPE_SONG,songid);
+    if (song) songv[songc++]=song;
+  }
+  PS_ASSERT_INTS_OP(songc,>,0)
+
+  int64_t serial=0;
+  int i=0; for (;i<songc;i++) {
+    int64_t elapsed=print_serially(songv[i]);
+    PS_ASSERT(elapsed>=0)
+    serial+=elapsed;
+  }
+  ps_log(TEST,INFO,"%7s %10.1f %8.2f %10s",
+    "serial",serial/1000.0,1.0,"-"
+  );
+
+  const int threadcv[]={1,2,4,8};
+  for (i=0;i<sizeof(threadcv)/sizeof(int);i++) {
+    int64_t total=0,stream_total=0;
+    int songp=0; for (;songp<songc;songp++) {
+      int64_t stream_time;
+      int64_t elapsed=print_parallel(&stream_time,songv[songp],threadcv[i]);
+      PS_ASSERT(elapsed>=0)
+      PS_ASSERT(stream_time>=0)
+      total+=elapsed;
+      stream_total+=stream_time;
+    }
+    ps_log(TEST,INFO,"%7d %10.1f %8.2f %10.1f",
+      threadcv[i],total/1000.0,(double)serial/total,stream_total/(songc*1000.0)
+    );
+  }
+
+  ps_resmgr_quit();
+  akau_quit();
+  return 0;
+}
@@ -0,0 +1,206 @@
+/* test_sprgrp_performance.c
+ *
+ * Compare ps_sprgrp_has_sprite() on masked groups against the unmasked search, for groups of various sizes.
+ * Each sprite is in a handful of groups, like a typical monster, so the search has something to do.
+ * We query every sprite in the group, half of them against a group they aren't in.
+ * Each log entry is: group size, group order, nanoseconds per query with search, with mask.
+ *
+ * TEST RESULTS: Linux x86_64, -O2.
+TEST:INFO:     50 ADDR         8.61     3.26
+TEST:INFO:     50 EXPLICIT     9.62     3.28
+TEST:INFO:     50 RENDER       9.24     3.37
+TEST:INFO:    500 ADDR         9.74     3.23
+TEST:INFO:    500 EXPLICIT     9.29     3.10
+TEST:INFO:    500 RENDER       9.04     3.29
+TEST:INFO:   5000 ADDR         8.95     2.83
+TEST:INFO:   5000 EXPLICIT     9.34     3.19
+TEST:INFO:   5000 RENDER       9.55     3.29
+ * test_sprgrp_render_sort_performance: count, motion, old us, old misordered, new us, new misordered
+ * At game scale and speed, the complete sort costs the same as the old single pass, and leaves nothing out of order.
+ * Crowded or fast groups cost more to sort, because that's exactly when the old pass left the order visibly wrong.
+TEST:INFO:     50 walk       0.66        0.2       0.68        0.0
+TEST:INFO:     50 fast       0.83       11.8       1.28        0.0
+TEST:INFO:    500 walk       5.65      123.0      10.02        0.0
+TEST:INFO:    500 fast       2.36      229.7      15.44        0.0
+TEST:INFO:   5000 walk      18.68     1962.8     128.55        0.0
+TEST:INFO:   5000 fast      16.11     2419.7     123.05        0.0
+ */
+
+#include "test/ps_test.h"
+#include "game/ps_game.h"
+#include "game/ps_sprite.h"
+#include <time.h>
+
+#define QUERIES_PER_TEST 5000000
+
+static double time_queries(const struct ps_sprgrp *yes,const struct ps_sprgrp *no) {
+  int hitc=0,i=0,sprp=0;
+  clock_t start=clock();
+  for (;i<QUERIES_PER_TEST;i++) {
+    const struct ps_sprite *spr=yes->sprv[sprp];
+    if (ps_sprgrp_has_sprite((i&1)?no:yes,spr)) hitc++;
+    if (++sprp>=yes->sprc) sprp=0;
+  }
+  clock_t elapsed=clock()-start;
+  if (hitc!=QUERIES_PER_TEST>>1) return -1.0;
+  return (elapsed*1000000000.0)/((double)CLOCKS_PER_SEC*QUERIES_PER_TEST);
+}
+
+static void set_masks(struct ps_sprgrp *grpv,int enable) {
+  int i=0; for (;i<PS_SPRGRP_COUNT;i++) grpv[i].mask=enable?(1<<i):0;
+}
+
+PS_TEST(test_sprgrp_has_sprite_performance,ignore,performance,sprgrp) {
+  const int sprcv[]={50,500,5000};
+  const int orderv[]={PS_SPRGRP_ORDER_ADDR,PS_SPRGRP_ORDER_EXPLICIT,PS_SPRGRP_ORDER_RENDER};
+  const char *ordernamev[]={"ADDR","EXPLICIT","RENDER"};
+  int sprci=0; for (;sprci<sizeof(sprcv)/sizeof(int);sprci++) {
+    int orderi=0; for (;orderi<sizeof(orderv)/sizeof(int);orderi++) {
+      struct ps_sprgrp grpv[PS_SPRGRP_COUNT]={0};
+      grpv[PS_SPRGRP_FRAGILE].order=orderv[orderi];
+      const int joinv[]={PS_SPRGRP_KEEPALIVE,PS_SPRGRP_VISIBLE,PS_SPRGRP_UPDATE,PS_SPRGRP_PHYSICS,PS_SPRGRP_FRAGILE,PS_SPRGRP_SOLID};
+
+      /* Search cost depends only on the sprite's group count, but mask them anyway, to prove the point. */
+      int mode=0; double resultv[2];
+      for (;mode<2;mode++) {
+        set_masks(grpv,mode);
+        int i=sprcv[sprci]; while (i-->0) {
+          struct ps_sprite *spr=ps_sprite_new(&ps_sprtype_dummy);
+          PS_ASSERT(spr)
+          spr->y=rand()%PS_SCREENH;
+          int j=0; for (;j<sizeof(joinv)/sizeof(int);j++) {
+            PS_ASSERT_CALL(ps_sprgrp_add_sprite(grpv+joinv[j],spr))
+          }
+          ps_sprite_del(spr);
+        }
+        resultv[mode]=time_queries(grpv+PS_SPRGRP_FRAGILE,grpv+PS_SPRGRP_HERO);
+        PS_ASSERT(resultv[mode]>=0.0)
+        ps_sprgrp_kill(grpv+PS_SPRGRP_KEEPALIVE);
+      }
+      ps_log(TEST,INFO,"%6d %-8s %8.2f %8.2f",sprcv[sprci],ordernamev[orderi],resultv[0],resultv[1]);
+
+      int i; for (i=0;i<PS_SPRGRP_COUNT;i++) ps_sprgrp_cleanup(grpv+i);
+    }
+  }
+  return 0;
+}
+
+/* Render order with sprites in vertical motion, across three layers.
+ * "walk" is about how fast things really move (0..2 pixels per frame), "fast" is 4..24, much worse than the game ever gets.
+ * We compare the single cocktail-shaker pass that ps_sprgrp_sort() used to do, against today's complete sort.
+ * Each log entry is: group size, motion, microseconds per frame and misordered neighbors after the old pass, same for the new sort.
+ */
+
+#define RENDER_FRAMES_PER_TEST 2000
+
+static int old_sortd=1;
+
+static int render_before(const struct ps_sprite *a,const struct ps_sprite *b) {
+  if (a->layer<b->layer) return -1;
+  if (a->layer>b->layer) return 1;
+  if (a->y<b->y) return -1;
+  if (a->y>b->y) return 1;
+  return 0;
+}
+
+static void old_render_pass(struct ps_sprgrp *grp) {
+  int first,last,i;
+  if (old_sortd==1) { first=0; last=grp->sprc-1; }
+  else { old_sortd=-1; first=grp->sprc-1; last=0; }
+  for (i=first;i!=last;i+=old_sortd) {
+    if (render_before(grp->sprv[i],grp->sprv[i+old_sortd])==old_sortd) {
+      struct ps_sprite *tmp=grp->sprv[i];
+      grp->sprv[i]=grp->sprv[i+old_sortd];
+      grp->sprv[i+old_sortd]=tmp;
+    }
+  }
+  old_sortd=-old_sortd;
+}
+
+static int count_misordered(const struct ps_sprgrp *grp) {
+  int c=0,i=1; for (;i<grp->sprc;i++) {
+    if (render_before(grp->sprv[i-1],grp->sprv[i])>0) c++;
+  }
+  return c;
+}
+
+/* (keepalive) is in address order, which doesn't change, so (dyv) lines up with it.
+ */
+
+static void move_vertically(struct ps_sprgrp *keepalive,double *dyv) {
+  int i=0; for (;i<keepalive->sprc;i++) {
+    struct ps_sprite *spr=keepalive->sprv[i];
+    double *dy=dyv+i;
+    spr->y+=*dy;
+    if ((spr->y<0.0)||(spr->y>=PS_SCREENH)) { *dy=-*dy; spr->y+=*dy*2.0; }
+  }
+}
+
+static double time_render_sort(struct ps_sprgrp *keepalive,struct ps_sprgrp *grp,double *dyv,int old,double *misordered) {
+  clock_t elapsed=0;
+  long long misorderedc=0;
+  int i=0; for (;i<RENDER_FRAMES_PER_TEST;i++) {
+    move_vertically(keepalive,dyv);
+    clock_t start=clock();
+    if (old) old_render_pass(grp);
+    else if (ps_sprgrp_sort(grp)<0) return -1.0;
+    elapsed+=clock()-start;
+    misorderedc+=count_misordered(grp);
+  }
+  *misordered=(double)misorderedc/RENDER_FRAMES_PER_TEST;
+  return (elapsed*1000000.0)/((double)CLOCKS_PER_SEC*RENDER_FRAMES_PER_TEST);
+}
+
+static int populate_render_group(struct ps_sprgrp *keepalive,struct ps_sprgrp *grp,double *dyv,int sprc,int dylo,int dyhi) {
+  srand(sprc);
+  int i=0; for (;i<sprc;i++) {
+    struct ps_sprite *spr=ps_sprite_new(&ps_sprtype_dummy);
+    if (!spr) return -1;
+    spr->layer=(rand()%3)*100;
+    spr->y=rand()%PS_SCREENH;
+    if (ps_sprgrp_add_sprite(keepalive,spr)<0) return -1;
+    if (ps_sprgrp_add_sprite(grp,spr)<0) return -1;
+    ps_sprite_del(spr);
+  }
+  for (i=0;i<sprc;i++) {
+    dyv[i]=dylo+rand()%(dyhi-dylo+1);
+    if (rand()&1) dyv[i]=-dyv[i];
+  }
+  return ps_sprgrp_sort(grp);
+}
+
+PS_TEST(test_sprgrp_render_sort_performance,ignore,performance,sprgrp) {
+  const int sprcv[]={50,500,5000};
+  const struct { const char *name; int dylo,dyhi; } motionv[]={
+    {"walk",0,2},
+    {"fast",4,24},
+  };
+  int sprci=0; for (;sprci<sizeof(sprcv)/sizeof(int);sprci++) {
+    int motioni=0; for (;motioni<sizeof(motionv)/sizeof(motionv[0]);motioni++) {
+      int sprc=sprcv[sprci],dylo=motionv[motioni].dylo,dyhi=motionv[motioni].dyhi;
+      double *dyv=malloc(sizeof(double)*sprc);
+      struct ps_sprgrp *keepalive=ps_sprgrp_new();
+      struct ps_sprgrp *grp=ps_sprgrp_new();
+      PS_ASSERT(dyv&&keepalive&&grp)
+      grp->order=PS_SPRGRP_ORDER_RENDER;
+      double old_us,old_misordered,new_us,new_misordered;
+
+      PS_ASSERT_CALL(populate_render_group(keepalive,grp,dyv,sprc,dylo,dyhi))
+      old_us=time_render_sort(keepalive,grp,dyv,1,&old_misordered);
+      PS_ASSERT(old_us>=0.0)
+      PS_ASSERT_CALL(ps_sprgrp_kill(keepalive))
+
+      PS_ASSERT_CALL(populate_render_group(keepalive,grp,dyv,sprc,dylo,dyhi))
+      new_us=time_render_sort(keepalive,grp,dyv,0,&new_misordered);
+      PS_ASSERT(new_us>=0.0)
+      PS_ASSERT(new_misordered==0.0)
+      PS_ASSERT_CALL(ps_sprgrp_kill(keepalive))
+
+      ps_log(TEST,INFO,"%6d %-4s %10.2f %10.1f %10.2f %10.1f",sprc,motionv[motioni].name,old_us,old_misordered,new_us,new_misordered);
+      ps_sprgrp_del(keepalive);
+      ps_sprgrp_del(grp);
+      free(dyv);
+    }
+  }
+  return 0;
+}
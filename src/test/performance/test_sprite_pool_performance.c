@@ -0,0 +1,151 @@
+/* test_sprite_pool_performance.c
+ *
+ * test_sprite_churn_performance:
+ * A steady population of short-lived decorations, like the aftermath of a big fight.
+ * Every step deletes the oldest and creates a new one of the same type, in the same groups as the real thing.
+ * Each log entry is: live sprites, nanoseconds per replacement.
+ *
+ * test_sprite_fireworks_scene_performance:
+ * A real game, headless, with one monster's worth of fireworks (20 of them, 60 frames each) every frame.
+ * Each log entry is: frames, live sprites at the end, microseconds per frame, sprites created and slabs allocated per frame.
+ *
+ * TEST RESULTS: Linux x86_64, -O2.
+ * Before ps_sprite_pool, when each sprite was a calloc and its group list a realloc:
+TEST:INFO:     live  ns/sprite
+TEST:INFO:       20      182.5
+TEST:INFO:      200      421.8
+TEST:INFO:     1200     1389.0
+TEST:INFO:   frames     live   us/frame
+TEST:INFO:     3000     1181      76.86
+ * After. About one slab per hundred frames while the population grows, then none:
+TEST:INFO:     live  ns/sprite
+TEST:INFO:       20      123.1
+TEST:INFO:      200      279.5
+TEST:INFO:     1200      916.0
+TEST:INFO:   frames     live   us/frame  new/frame slab/frame
+TEST:INFO:     3000     1181      60.90      20.00     0.0113
+ * Fireworks are particles now, not sprites (see test_particles_performance.c), and the churn uses dummies in their place.
+ * The scene test still tells us what death decorations cost:
+TEST:INFO:   frames     live   us/frame  new/frame slab/frame
+TEST:INFO:     3000        1       7.41       0.00     0.0000
+ */
+
+#include "test/ps_test.h"
+#include "game/ps_game.h"
+#include "game/ps_sprite.h"
+#include "video/ps_video.h"
+#include "input/ps_input.h"
+#include "res/ps_resmgr.h"
+#include "os/ps_userconfig.h"
+#include <time.h>
+
+/* Churn.
+ */
+
+#define CHURN_STEPC 2000000
+
+static const struct ps_sprtype *churn_typev[]={
+  &ps_sprtype_dummy,
+  &ps_sprtype_dummy,
+  &ps_sprtype_dummy,
+  &ps_sprtype_explosion,
+  &ps_sprtype_anim2,
+};
+
+static struct ps_sprite *churn_new(struct ps_game *game,int p) {
+  const struct ps_sprtype *type=churn_typev[p%(sizeof(churn_typev)/sizeof(void*))];
+  struct ps_sprite *spr=ps_sprite_new(type);
+  if (!spr) return 0;
+  if (ps_sprgrp_add_sprite(game->grpv+PS_SPRGRP_KEEPALIVE,spr)<0) return 0;
+  ps_sprite_del(spr);
+  if (ps_sprgrp_add_sprite(game->grpv+PS_SPRGRP_VISIBLE,spr)<0) return 0;
+  if (ps_sprgrp_add_sprite(game->grpv+PS_SPRGRP_UPDATE,spr)<0) return 0;
+  return spr;
+}
+
+static double churn_measure(struct ps_game *game,int livec) {
+  struct ps_sprite **ringv=calloc(livec,sizeof(void*));
+  if (!ringv) return -1.0;
+  int i=0; for (;i<livec;i++) {
+    if (!(ringv[i]=churn_new(game,i))) return -1.0;
+  }
+  clock_t starttime=clock();
+  int ringp=0;
+  for (i=0;i<CHURN_STEPC;i++) {
+    if (ps_sprite_kill(ringv[ringp])<0) return -1.0;
+    if (!(ringv[ringp]=churn_new(game,i))) return -1.0;
+    if (++ringp>=livec) ringp=0;
+  }
+  clock_t elapsed=clock()-starttime;
+  for (i=0;i<livec;i++) ps_sprite_kill(ringv[i]);
+  free(ringv);
+  return (elapsed*1000000000.0)/((double)CLOCKS_PER_SEC*CHURN_STEPC);
+}
+
+PS_TEST(test_sprite_churn_performance,ignore,performance,game) {
+  struct ps_game *game=calloc(1,sizeof(struct ps_game));
+  PS_ASSERT(game)
+  int i=0; for (;i<PS_SPRGRP_COUNT;i++) game->grpv[i].mask=1<<i;
+  game->grpv[PS_SPRGRP_VISIBLE].order=PS_SPRGRP_ORDER_RENDER;
+
+  ps_log(TEST,INFO,"%8s %10s","live","ns/sprite");
+  const int livev[]={20,200,1200};
+  for (i=0;i<sizeof(livev)/sizeof(int);i++) {
+    double ns=churn_measure(game,livev[i]);
+    PS_ASSERT(ns>=0.0)
+    ps_log(TEST,INFO,"%8d %10.1f",livev[i],ns);
+  }
+
+  for (i=0;i<PS_SPRGRP_COUNT;i++) ps_sprgrp_cleanup(game->grpv+i);
+  free(game);
+  return 0;
+}
+
+/* Fireworks in a real game.
+ */
+
+#define FIREWORKS_FRAMEC 3000
+
+PS_TEST(test_sprite_fireworks_scene_performance,ignore,performance,game) {
+  ps_resmgr_quit();
+  ps_video_quit();
+  PS_ASSERT_CALL(ps_video_init_headless())
+  PS_ASSERT_CALL(ps_input_init())
+  PS_ASSERT_CALL(ps_resmgr_init("src/data",0))
+
+  struct ps_userconfig *userconfig=ps_userconfig_new();
+  PS_ASSERT(userconfig)
+  PS_ASSERT_CALL(ps_userconfig_declare_default_fields(userconfig))
+  struct ps_game *game=ps_game_new(userconfig);
+  PS_ASSERT(game)
+  PS_ASSERT_CALL(ps_game_set_player_count(game,1))
+  PS_ASSERT_CALL(ps_game_configure_player(game,1,1,0,0))
+  PS_ASSERT_CALL(ps_game_set_seed(game,1234))
+  PS_ASSERT_CALL(ps_game_generate_test(game,-1,2,1))
+  PS_ASSERT_CALL(ps_game_restart(game))
+
+  struct ps_sprite_pool_stats before,after;
+  ps_sprite_pool_get_stats(&before);
+  clock_t starttime=clock();
+  int framep=0; for (;framep<FIREWORKS_FRAMEC;framep++) {
+    PS_ASSERT_CALL(ps_game_create_fireworks(game,PS_SCREENW>>1,PS_SCREENH>>1))
+    PS_ASSERT_CALL(ps_game_update(game))
+  }
+  clock_t elapsed=clock()-starttime;
+  ps_sprite_pool_get_stats(&after);
+  ps_log(TEST,INFO,"%8s %8s %10s %10s %10s","frames","live","us/frame","new/frame","slab/frame");
+  ps_log(TEST,INFO,"%8d %8d %10.2f %10.2f %10.4f",
+    FIREWORKS_FRAMEC,game->grpv[PS_SPRGRP_KEEPALIVE].sprc,
+    (elapsed*1000000.0)/((double)CLOCKS_PER_SEC*FIREWORKS_FRAMEC),
+    (after.allocc-before.allocc)/(double)FIREWORKS_FRAMEC,
+    (after.slabc-before.slabc)/(double)FIREWORKS_FRAMEC
+  );
+
+  ps_game_del(game);
+  ps_sprite_pool_release();
+  ps_userconfig_del(userconfig);
+  ps_resmgr_quit();
+  ps_input_quit();
+  ps_video_quit();
+  return 0;
+}
@@ -0,0 +1,185 @@
+#include "test/ps_test.h"
+#include "res/ps_res_internal.h"
+#include "os/ps_fs.h"
+#include "util/ps_buffer.h"
+#include "video/ps_image_decode.h"
+#include "akgl/akgl.h"
+
+#define TEST_RES_ARCHIVE_ZLIB "mid/test/res/archive-zlib"
+#define TEST_RES_ARCHIVE_INDEXED "mid/test/res/archive-indexed"
+
+/* Serialize every resource of each type, in order, into one buffer per type.
+ */
+
+static int test_res_archive_snapshot(struct ps_buffer *snapshotv) {
+  int tid=0; for (;tid<PS_RESTYPE_COUNT;tid++) {
+    struct ps_restype *restype=ps_resmgr_get_type_by_id(tid);
+    if (!restype) return -1;
+    struct ps_buffer *snapshot=snapshotv+tid;
+    snapshot->c=0;
+    int resp=0; for (;resp<restype->resc;resp++) {
+      const struct ps_res *res=restype->resv+resp;
+      if (!res->obj) return -1;
+      if (ps_buffer_append_be32(snapshot,res->id)<0) return -1;
+      if (!restype->encode) continue;
+      int len=restype->encode(0,0,res->obj);
+      if (len<0) return -1;
+      if (ps_buffer_require(snapshot,len)<0) return -1;
+      if (restype->encode(snapshot->v+snapshot->c,len,res->obj)!=len) return -1;
+      snapshot->c+=len;
+    }
+  }
+  return 0;
+}
+
+static int test_res_archive_compare(const struct ps_buffer *a,const struct ps_buffer *b) {
+  int tid=0; for (;tid<PS_RESTYPE_COUNT;tid++) {
+    if (a[tid].c!=b[tid].c) return -1;
+    if (memcmp(a[tid].v,b[tid].v,a[tid].c)) return -1;
+  }
+  return 0;
+}
+
+PS_TEST(test_res_archive_formats_round_trip,res) {
+  struct ps_buffer expect[PS_RESTYPE_COUNT]={0};
+  struct ps_buffer actual[PS_RESTYPE_COUNT]={0};
+
+  /* IPCM and SONG can only be exported in respack's fallback mode, which can't be undone in this process.
+   * Drop them; all that matters for audio is that those types decode eagerly.
+   */
+  ps_resmgr_quit();
+  PS_ASSERT_CALL(ps_resmgr_init("src/data",0))
+  PS_ASSERT(ps_resmgr.typev[PS_RESTYPE_IPCM].eager)
+  PS_ASSERT(ps_resmgr.typev[PS_RESTYPE_SONG].eager)
+  PS_ASSERT_CALL(ps_restype_clear(ps_resmgr.typev+PS_RESTYPE_IPCM))
+  PS_ASSERT_CALL(ps_restype_clear(ps_resmgr.typev+PS_RESTYPE_SONG))
+  PS_ASSERT_CALL(test_res_archive_snapshot(expect))
+  PS_ASSERT_CALL(ps_mkdir_parents(TEST_RES_ARCHIVE_ZLIB))
+  PS_ASSERT_CALL(ps_res_export_archive(TEST_RES_ARCHIVE_ZLIB))
+  PS_ASSERT_CALL(ps_res_export_indexed_archive(TEST_RES_ARCHIVE_INDEXED))
+  ps_resmgr_quit();
+
+  /* The old format still loads everything up front. */
+  PS_ASSERT_CALL(ps_resmgr_init(TEST_RES_ARCHIVE_ZLIB,0))
+  PS_ASSERT_NOT(ps_resmgr.archive)
+  PS_ASSERT_CALL(test_res_archive_snapshot(actual))
+  PS_ASSERT_CALL(test_res_archive_compare(expect,actual))
+  ps_resmgr_quit();
+
+  /* The indexed format leaves everything pending except audio, and decodes on demand. */
+  PS_ASSERT_CALL(ps_resmgr_init(TEST_RES_ARCHIVE_INDEXED,0))
+  PS_ASSERT(ps_resmgr.archive)
+  struct ps_restype *tilesheets=ps_resmgr.typev+PS_RESTYPE_TILESHEET;
+  PS_ASSERT_INTS_OP(tilesheets->resc,>,0)
+  PS_ASSERT_INTS(tilesheets->pendingc,tilesheets->resc)
+  int tsid=tilesheets->resv[0].id;
+  PS_ASSERT(ps_res_get(PS_RESTYPE_TILESHEET,tsid))
+  PS_ASSERT(tilesheets->resv[0].obj)
+  PS_ASSERT_INTS(tilesheets->pendingc,tilesheets->resc-1)
+  PS_ASSERT(ps_res_get(PS_RESTYPE_TILESHEET,tsid)==tilesheets->resv[0].obj)
+  PS_ASSERT_NOT(ps_res_get(PS_RESTYPE_TILESHEET,4000))
+
+  // Regions link to tilesheets and sprdefs, which decode in turn.
+  struct ps_restype *regions=ps_resmgr.typev+PS_RESTYPE_REGION;
+  PS_ASSERT_INTS_OP(regions->resc,>,0)
+  PS_ASSERT(ps_res_get(PS_RESTYPE_REGION,regions->resv[0].id))
+
+  PS_ASSERT_CALL(test_res_archive_snapshot(actual))
+  PS_ASSERT_CALL(test_res_archive_compare(expect,actual))
+  int tid=0; for (;tid<PS_RESTYPE_COUNT;tid++) {
+    PS_ASSERT_INTS(ps_resmgr.typev[tid].pendingc,0)
+  }
+
+  /* Reload drops the mapping and indexes again. */
+  PS_ASSERT_CALL(ps_resmgr_reload())
+  PS_ASSERT_INTS(tilesheets->pendingc,tilesheets->resc)
+  ps_resmgr_quit();
+
+  for (tid=0;tid<PS_RESTYPE_COUNT;tid++) {
+    ps_buffer_cleanup(expect+tid);
+    ps_buffer_cleanup(actual+tid);
+  }
+  return 0;
+}
+
+/* Decoding across any number of threads must give exactly what one thread does, from every source.
+ */
+
+#define TEST_RES_PARALLEL_ZLIB "mid/test/res/parallel-zlib"
+#define TEST_RES_PARALLEL_INDEXED "mid/test/res/parallel-indexed"
+
+PS_TEST(test_res_parallel_decode_matches_serial,res) {
+  struct ps_buffer expect[PS_RESTYPE_COUNT]={0};
+  struct ps_buffer actual[PS_RESTYPE_COUNT]={0};
+  int ipcmc,songc;
+
+  ps_resmgr_quit();
+  ps_resmgr_set_decode_thread_count(1);
+  PS_ASSERT_CALL(ps_resmgr_init("src/data",0))
+  ipcmc=ps_resmgr.typev[PS_RESTYPE_IPCM].resc;
+  songc=ps_resmgr.typev[PS_RESTYPE_SONG].resc;
+  PS_ASSERT_CALL(ps_restype_clear(ps_resmgr.typev+PS_RESTYPE_IPCM))
+  PS_ASSERT_CALL(ps_restype_clear(ps_resmgr.typev+PS_RESTYPE_SONG))
+  PS_ASSERT_CALL(test_res_archive_snapshot(expect))
+  PS_ASSERT_CALL(ps_mkdir_parents(TEST_RES_PARALLEL_ZLIB))
+  PS_ASSERT_CALL(ps_res_export_archive(TEST_RES_PARALLEL_ZLIB))
+  PS_ASSERT_CALL(ps_res_export_indexed_archive(TEST_RES_PARALLEL_INDEXED))
+  ps_resmgr_quit();
+
+  const int threadcv[]={2,4,7};
+  int i=0; for (;i<sizeof(threadcv)/sizeof(int);i++) {
+    ps_resmgr_set_decode_thread_count(threadcv[i]);
+
+    PS_ASSERT_CALL(ps_resmgr_init("src/data",0))
+    PS_ASSERT_INTS(ps_resmgr.typev[PS_RESTYPE_IPCM].resc,ipcmc)
+    PS_ASSERT_INTS(ps_resmgr.typev[PS_RESTYPE_SONG].resc,songc)
+    PS_ASSERT_CALL(ps_restype_clear(ps_resmgr.typev+PS_RESTYPE_IPCM))
+    PS_ASSERT_CALL(ps_restype_clear(ps_resmgr.typev+PS_RESTYPE_SONG))
+    PS_ASSERT_CALL(test_res_archive_snapshot(actual))
+    PS_ASSERT_CALL(test_res_archive_compare(expect,actual),"directory, %d threads",threadcv[i])
+    ps_resmgr_quit();
+
+    PS_ASSERT_CALL(ps_resmgr_init(TEST_RES_PARALLEL_ZLIB,0))
+    PS_ASSERT_CALL(test_res_archive_snapshot(actual))
+    PS_ASSERT_CALL(test_res_archive_compare(expect,actual),"zlib archive, %d threads",threadcv[i])
+    ps_resmgr_quit();
+
+    PS_ASSERT_CALL(ps_resmgr_init(TEST_RES_PARALLEL_INDEXED,0))
+    PS_ASSERT_CALL(ps_resmgr_require_all())
+    int tid=0; for (;tid<PS_RESTYPE_COUNT;tid++) {
+      PS_ASSERT_INTS(ps_resmgr.typev[tid].pendingc,0)
+    }
+    PS_ASSERT_CALL(test_res_archive_snapshot(actual))
+    PS_ASSERT_CALL(test_res_archive_compare(expect,actual),"indexed archive, %d threads",threadcv[i])
+    ps_resmgr_quit();
+  }
+
+  ps_resmgr_set_decode_thread_count(0);
+  for (i=0;i<PS_RESTYPE_COUNT;i++) {
+    ps_buffer_cleanup(expect+i);
+    ps_buffer_cleanup(actual+i);
+  }
+  return 0;
+}
+
+/* Archived images carry their own dimensions, so the decoder must not trust them.
+ * 65535x65535 overflows the body size for any format.
+ */
+
+PS_TEST(test_res_psimage_rejects_oversized,res) {
+  uint8_t src[16+64]={'P','S','I','M','G',0,0xff,0, 0xff,0xff, 0xff,0xff, AKGL_FMT_RGBA8};
+  void *pixels=0;
+  int fmt,w,h;
+  PS_ASSERT_INTS(ps_image_decode_pixels(&pixels,&fmt,&w,&h,src,sizeof(src)),-1)
+  PS_ASSERT_NOT(pixels)
+
+  /* Same header shrunk to 4x4 is fine. */
+  src[8]=0; src[9]=4; src[10]=0; src[11]=4;
+  PS_ASSERT_CALL(ps_image_decode_pixels(&pixels,&fmt,&w,&h,src,sizeof(src)))
+  PS_ASSERT(pixels)
+  PS_ASSERT_INTS(w,4)
+  PS_ASSERT_INTS(h,4)
+  PS_ASSERT_INTS(fmt,AKGL_FMT_RGBA8)
+  free(pixels);
+  return 0;
+}
@@ -25,7 +25,7 @@ static struct ps_scenario *generate_scenario() {
   /* Set random seed. */
   int seed=time(0);
   PS_LOG("Random seed %d",seed);
-  srand(seed);
+  scgen->seed=seed;
 
   /* Generate. */
   if (ps_scgen_generate(scgen)<0) {
@@ -176,3 +176,47 @@ PS_TEST(test_scenario_encode,scgen,functional,ignore) {
   ps_resmgr_quit();
   return 0;
 }
+
+/* The same inputs and seed must generate the same scenario, byte for byte.
+ */
+
+static int encode_seeded_scenario(void *dstpp,uint32_t seed) {
+  struct ps_scgen *scgen=ps_scgen_new();
+  if (!scgen) return -1;
+  scgen->playerc=2;
+  scgen->skills=PS_SKILL_HOOKSHOT|PS_SKILL_SWORD|PS_SKILL_COMBAT;
+  scgen->difficulty=5;
+  scgen->length=5;
+  scgen->seed=seed;
+  int serialc=-1;
+  if (ps_scgen_generate(scgen)>=0) serialc=ps_scenario_encode(dstpp,scgen->scenario);
+  ps_scgen_del(scgen);
+  return serialc;
+}
+
+PS_TEST(test_scenario_seed_repeatable,scgen) {
+
+  ps_log_level_by_domain[PS_LOG_DOMAIN_RES]=PS_LOG_LEVEL_WARN;
+  ps_log_level_by_domain[PS_LOG_DOMAIN_GENERATOR]=PS_LOG_LEVEL_WARN;
+
+  ps_resmgr_quit();
+  PS_ASSERT_CALL(ps_resmgr_init("src/data",0))
+
+  void *a=0,*b=0,*c=0;
+  int ac=encode_seeded_scenario(&a,1234);
+  int bc=encode_seeded_scenario(&b,1234);
+  int cc=encode_seeded_scenario(&c,1235);
+  PS_ASSERT_CALL(ac)
+  PS_ASSERT_CALL(bc)
+  PS_ASSERT_CALL(cc)
+
+  PS_ASSERT_INTS(ac,bc)
+  PS_ASSERT(!memcmp(a,b,ac),"Same seed produced different scenarios.")
+  PS_ASSERT((ac!=cc)||memcmp(a,c,ac),"Different seeds produced the same scenario.")
+
+  free(a);
+  free(b);
+  free(c);
+  ps_resmgr_quit();
+  return 0;
+}
@@ -0,0 +1,134 @@
+#include "test/ps_test.h"
+#include "scenario/ps_scenario.h"
+#include "scenario/ps_screen.h"
+#include "util/ps_geometry.h"
+
+/* Random world with symmetric doors.
+ */
+
+static int test_route_random_doors(struct ps_scenario *scenario,int w,int h,int percent_open) {
+  if (ps_scenario_reallocate_screens(scenario,w,h)<0) return -1;
+  struct ps_screen *screen=scenario->screenv;
+  int i=w*h; for (;i-->0;screen++) {
+    if (screen->x<w-1) {
+      screen->doore=screen[1].doorw=((rand()%100)<percent_open)?PS_DOOR_OPEN:PS_DOOR_CLOSED;
+    }
+    if (screen->y<h-1) {
+      screen->doors=screen[w].doorn=((rand()%100)<percent_open)?PS_DOOR_OPEN:PS_DOOR_CLOSED;
+    }
+  }
+  return 0;
+}
+
+/* Reference distances toward (dstp) by plain relaxation, INT_MAX if unreachable.
+ */
+
+static int test_route_door_open(const struct ps_screen *screen,int direction) {
+  switch (direction) {
+    case PS_DIRECTION_WEST: return screen->doorw==PS_DOOR_OPEN;
+    case PS_DIRECTION_EAST: return screen->doore==PS_DOOR_OPEN;
+    case PS_DIRECTION_NORTH: return screen->doorn==PS_DOOR_OPEN;
+    case PS_DIRECTION_SOUTH: return screen->doors==PS_DOOR_OPEN;
+  }
+  return 0;
+}
+
+static void test_route_reference(int *distv,const struct ps_scenario *scenario,int dstp) {
+  const int directionv[4]={PS_DIRECTION_WEST,PS_DIRECTION_EAST,PS_DIRECTION_NORTH,PS_DIRECTION_SOUTH};
+  int screenc=scenario->w*scenario->h,p,changed=1;
+  for (p=0;p<screenc;p++) distv[p]=INT_MAX;
+  distv[dstp]=0;
+  while (changed) {
+    changed=0;
+    for (p=0;p<screenc;p++) {
+      const struct ps_screen *screen=scenario->screenv+p;
+      int i=0; for (;i<4;i++) {
+        if (!test_route_door_open(screen,directionv[i])) continue;
+        struct ps_vector d=ps_vector_from_direction(directionv[i]);
+        int nx=screen->x+d.dx,ny=screen->y+d.dy;
+        if ((nx<0)||(ny<0)||(nx>=scenario->w)||(ny>=scenario->h)) continue;
+        int np=ny*scenario->w+nx;
+        if ((distv[np]<INT_MAX)&&(distv[np]+1<distv[p])) {
+          distv[p]=distv[np]+1;
+          changed=1;
+        }
+      }
+    }
+  }
+}
+
+/* Every pair agrees with the reference, and every first step is the preferred legal one.
+ */
+
+static int test_route_validate(struct ps_scenario *scenario) {
+  const int directionv[4]={PS_DIRECTION_WEST,PS_DIRECTION_EAST,PS_DIRECTION_NORTH,PS_DIRECTION_SOUTH};
+  int screenc=scenario->w*scenario->h;
+  int distv[PS_WORLD_W_LIMIT*PS_WORLD_H_LIMIT];
+  int dstp=0; for (;dstp<screenc;dstp++) {
+    test_route_reference(distv,scenario,dstp);
+    int dstx=dstp%scenario->w,dsty=dstp/scenario->w;
+    int srcp=0; for (;srcp<screenc;srcp++) {
+      const struct ps_screen *screen=scenario->screenv+srcp;
+      int direction=-1;
+      int distance=ps_scenario_get_route(&direction,scenario,dstx,dsty,screen->x,screen->y);
+      if (distv[srcp]==INT_MAX) {
+        PS_ASSERT_INTS(distance,-1,"(%d,%d) to (%d,%d)",screen->x,screen->y,dstx,dsty)
+        continue;
+      }
+      PS_ASSERT_INTS(distance,distv[srcp],"(%d,%d) to (%d,%d)",screen->x,screen->y,dstx,dsty)
+      if (!distance) {
+        PS_ASSERT_INTS(direction,0)
+        continue;
+      }
+      int expect=0,i=0;
+      for (;i<4;i++) {
+        if (!test_route_door_open(screen,directionv[i])) continue;
+        struct ps_vector d=ps_vector_from_direction(directionv[i]);
+        int nx=screen->x+d.dx,ny=screen->y+d.dy;
+        if ((nx<0)||(ny<0)||(nx>=scenario->w)||(ny>=scenario->h)) continue;
+        if (distv[ny*scenario->w+nx]==distance-1) {
+          expect=directionv[i];
+          break;
+        }
+      }
+      PS_ASSERT_INTS(direction,expect,"(%d,%d) to (%d,%d)",screen->x,screen->y,dstx,dsty)
+    }
+  }
+  return 0;
+}
+
+PS_TEST(test_scenario_routes_match_reference,scenario) {
+  struct ps_scenario *scenario=ps_scenario_new();
+  PS_ASSERT(scenario)
+  srand(11);
+  int repc=40; while (repc-->0) {
+    int w=1+rand()%8,h=1+rand()%8;
+    PS_ASSERT_CALL(test_route_random_doors(scenario,w,h,30+rand()%70))
+    PS_ASSERT_CALL(test_route_validate(scenario))
+  }
+  ps_scenario_del(scenario);
+  return 0;
+}
+
+PS_TEST(test_scenario_routes_follow_door_changes,scenario) {
+  struct ps_scenario *scenario=ps_scenario_new();
+  PS_ASSERT(scenario)
+  PS_ASSERT_CALL(test_route_random_doors(scenario,3,1,100))
+
+  int direction=0;
+  PS_ASSERT_INTS(ps_scenario_get_route(&direction,scenario,2,0,0,0),2)
+  PS_ASSERT_INTS(direction,PS_DIRECTION_EAST)
+  PS_ASSERT_INTS(ps_scenario_get_route(&direction,scenario,0,0,2,0),2)
+  PS_ASSERT_INTS(direction,PS_DIRECTION_WEST)
+  PS_ASSERT_INTS(ps_scenario_get_route(&direction,scenario,1,0,1,0),0)
+  PS_ASSERT_INTS(direction,0)
+  PS_ASSERT_INTS(ps_scenario_get_route(&direction,scenario,3,0,1,0),-1)
+
+  scenario->screenv[1].doore=scenario->screenv[2].doorw=PS_DOOR_CLOSED;
+  ps_scenario_invalidate_routes(scenario);
+  PS_ASSERT_INTS(ps_scenario_get_route(&direction,scenario,2,0,0,0),-1)
+  PS_ASSERT_INTS(ps_scenario_get_route(&direction,scenario,1,0,0,0),1)
+
+  ps_scenario_del(scenario);
+  return 0;
+}
@@ -0,0 +1,93 @@
+#include "test/ps_test.h"
+#include "res/ps_resmgr.h"
+#include "scenario/ps_scgen.h"
+#include "scenario/ps_scgen_async.h"
+#include "scenario/ps_scenario.h"
+
+/* Background generation must produce exactly what the foreground would, and only hand off a match.
+ */
+
+static int test_scgen_async_compare(struct ps_scenario *scenario,const struct ps_scgen_request *request) {
+  struct ps_scgen *scgen=ps_scgen_new();
+  PS_ASSERT(scgen)
+  scgen->playerc=request->playerc;
+  scgen->skills=request->skills;
+  scgen->difficulty=request->difficulty;
+  scgen->length=request->length;
+  scgen->seed=request->seed;
+  PS_ASSERT_CALL(ps_scgen_generate(scgen))
+  void *a=0,*b=0;
+  int ac=ps_scenario_encode(&a,scenario);
+  int bc=ps_scenario_encode(&b,scgen->scenario);
+  PS_ASSERT_CALL(ac)
+  PS_ASSERT_INTS(ac,bc)
+  PS_ASSERT(!memcmp(a,b,ac),"Background scenario differs from foreground.")
+  free(a);
+  free(b);
+  ps_scgen_del(scgen);
+  return 0;
+}
+
+PS_TEST(test_scgen_async_take,scgen) {
+
+  ps_log_level_by_domain[PS_LOG_DOMAIN_RES]=PS_LOG_LEVEL_WARN;
+  ps_log_level_by_domain[PS_LOG_DOMAIN_GENERATOR]=PS_LOG_LEVEL_WARN;
+
+  ps_resmgr_quit();
+  PS_ASSERT_CALL(ps_resmgr_init("src/data",0))
+
+  struct ps_scgen_async *async=ps_scgen_async_new();
+  PS_ASSERT(async)
+  struct ps_scenario *scenario=0;
+  uint32_t seed=0;
+  struct ps_scgen_async_status status={0};
+
+  struct ps_scgen_request a={
+    .playerc=2,
+    .skills=PS_SKILL_SWORD|PS_SKILL_HOOKSHOT|PS_SKILL_COMBAT,
+    .difficulty=4,
+    .length=6,
+    .seed=77,
+  };
+  struct ps_scgen_request b=a;
+  b.length=3;
+  b.seed=78;
+
+  /* Nothing requested, nothing to take. */
+  PS_ASSERT_INTS(ps_scgen_async_take(&scenario,&seed,async,&a),0)
+  PS_ASSERT_NOT(scenario)
+
+  /* Change settings mid-flight, then commit the second. Repeating a request is a noop. */
+  PS_ASSERT_CALL(ps_scgen_async_request(async,&a))
+  PS_ASSERT_CALL(ps_scgen_async_request(async,&b))
+  PS_ASSERT_CALL(ps_scgen_async_request(async,&b))
+  PS_ASSERT_INTS(ps_scgen_async_take(&scenario,&seed,async,&b),1)
+  PS_ASSERT(scenario)
+  PS_ASSERT_INTS(seed,78)
+  PS_ASSERT_CALL(test_scgen_async_compare(scenario,&b))
+  ps_scenario_del(scenario);
+  scenario=0;
+
+  PS_ASSERT_CALL(ps_scgen_async_get_status(&status,async))
+  PS_ASSERT_INTS(status.requestc,2)
+  PS_ASSERT_INTS(status.takec,1)
+  PS_ASSERT_INTS(status.missc,1)
+  PS_ASSERT_INTS_OP(status.finishc,>=,1)
+  PS_ASSERT_INTS_OP(status.finishc+status.abortc,<=,2,"(a) may have been replaced before it started")
+
+  /* Already taken; settings that were never requested don't match either. */
+  PS_ASSERT_INTS(ps_scgen_async_take(&scenario,&seed,async,&b),0)
+  PS_ASSERT_INTS(ps_scgen_async_take(&scenario,&seed,async,&a),0)
+
+  /* Cancel drops the request. */
+  PS_ASSERT_CALL(ps_scgen_async_request(async,&a))
+  PS_ASSERT_CALL(ps_scgen_async_cancel(async))
+  PS_ASSERT_INTS(ps_scgen_async_take(&scenario,&seed,async,&a),0)
+
+  /* Delete with a generation in flight must not hang or leak. */
+  PS_ASSERT_CALL(ps_scgen_async_request(async,&b))
+  ps_scgen_async_del(async);
+
+  ps_resmgr_quit();
+  return 0;
+}
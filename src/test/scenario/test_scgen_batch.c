@@ -0,0 +1,59 @@
+#include "test/ps_test.h"
+#include "res/ps_resmgr.h"
+#include "scenario/ps_scgen.h"
+#include "scenario/ps_scgen_batch.h"
+#include "scenario/ps_scenario.h"
+
+/* Generate a batch across threads, and check that each result matches the same seed generated alone.
+ */
+
+#define TEST_SCGEN_BATCH_JOBC 16
+
+PS_TEST(test_scgen_batch_matches_serial,scgen) {
+
+  ps_log_level_by_domain[PS_LOG_DOMAIN_RES]=PS_LOG_LEVEL_WARN;
+  ps_log_level_by_domain[PS_LOG_DOMAIN_GENERATOR]=PS_LOG_LEVEL_WARN;
+
+  ps_resmgr_quit();
+  PS_ASSERT_CALL(ps_resmgr_init("src/data",0))
+
+  struct ps_scgen_batch_job jobv[TEST_SCGEN_BATCH_JOBC]={0};
+  int i; for (i=0;i<TEST_SCGEN_BATCH_JOBC;i++) {
+    jobv[i].playerc=1+i%4;
+    jobv[i].skills=PS_SKILL_SWORD|PS_SKILL_ARROW|PS_SKILL_HOOKSHOT|PS_SKILL_FLAME|PS_SKILL_COMBAT;
+    jobv[i].difficulty=1+i%9;
+    jobv[i].length=1+(i*5)%9;
+    jobv[i].seed=1000+i;
+  }
+
+  PS_ASSERT_INTS(ps_scgen_batch_run(jobv,TEST_SCGEN_BATCH_JOBC,4),0)
+
+  for (i=0;i<TEST_SCGEN_BATCH_JOBC;i++) {
+    const struct ps_scgen_batch_job *job=jobv+i;
+    PS_ASSERT_INTS(job->result,0,"job %d: %s",i,job->msg)
+    PS_ASSERT(job->scenario)
+
+    struct ps_scgen *scgen=ps_scgen_new();
+    PS_ASSERT(scgen)
+    scgen->playerc=job->playerc;
+    scgen->skills=job->skills;
+    scgen->difficulty=job->difficulty;
+    scgen->length=job->length;
+    scgen->seed=job->seed;
+    PS_ASSERT_CALL(ps_scgen_generate(scgen))
+
+    void *a=0,*b=0;
+    int ac=ps_scenario_encode(&a,job->scenario);
+    int bc=ps_scenario_encode(&b,scgen->scenario);
+    PS_ASSERT_CALL(ac)
+    PS_ASSERT_INTS(ac,bc,"job %d",i)
+    PS_ASSERT(!memcmp(a,b,ac),"job %d differs from serial generation",i)
+    free(a);
+    free(b);
+    ps_scgen_del(scgen);
+  }
+
+  ps_scgen_batch_cleanup(jobv,TEST_SCGEN_BATCH_JOBC);
+  ps_resmgr_quit();
+  return 0;
+}
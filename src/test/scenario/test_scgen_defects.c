@@ -103,10 +103,10 @@ PS_TEST(test_defect_challenge_direction,scgen,ignore) {
     int seed=ps_time_now();
     //seed=1526682486;
     //PS_LOG("Random seed %d",seed);
-    srand(seed);
 
     struct ps_scgen *scgen=ps_scgen_new();
     PS_ASSERT(scgen)
+    scgen->seed=seed;
 
     /* Set input parameters for generator. */
     scgen->playerc=1;
@@ -403,7 +403,7 @@ PS_TEST(test_scgen_functional,scgen,functional,ignore) {
   int seed=time(0);
   seed=1526682486;
   PS_LOG("Random seed %d",seed);
-  srand(seed);
+  scgen->seed=seed;
 
   /* Generate. */
   if (ps_scgen_generate(scgen)<0) {
@@ -486,7 +486,7 @@ PS_TEST(test_scgen_blueprint_reuse,scgen,functional,ignore) {
 
   int seed=time(0);
   PS_LOG("Random seed %d",seed);
-  srand(seed);
+  scgen->seed=seed;
 
   PS_ASSERT_CALL(ps_scgen_generate(scgen))
 
@@ -535,7 +535,6 @@ PS_TEST(test_blueprint_chooser,scgen,functional,ignore) {
 
   int seed=time(0);
   PS_LOG("Random seed %d",seed);
-  srand(seed);
 
   int total_by_playerc[1+PS_PLAYER_LIMIT]={0};
   int total_by_difficulty[1+PS_DIFFICULTY_MAX]={0};
@@ -552,6 +551,7 @@ PS_TEST(test_blueprint_chooser,scgen,functional,ignore) {
       if (scgen->skills&(PS_SKILL_SWORD|PS_SKILL_ARROW|PS_SKILL_FLAME|PS_SKILL_BOMB)) scgen->skills|=PS_SKILL_COMBAT;
       scgen->difficulty=difficulty;
       scgen->length=4;
+      scgen->seed=seed++;
 
       PS_ASSERT_CALL(ps_scgen_generate(scgen))
 
@@ -0,0 +1,160 @@
+#include "test/ps_test.h"
+#include "sdraw/ps_sdraw.h"
+#include "akgl/akgl.h"
+
+/* Images to draw with.
+ * Source pixels favor the cases the kernels special-case: fully transparent, fully opaque, and pure gray.
+ */
+
+static uint8_t test_sdraw_random_alpha() {
+  switch (rand()&3) {
+    case 0: return 0;
+    case 1: return 0xff;
+  }
+  return rand();
+}
+
+static struct ps_sdraw_image *test_sdraw_random_image(int fmt,int w,int h) {
+  struct ps_sdraw_image *image=ps_sdraw_image_new();
+  if (!image) return 0;
+  if (ps_sdraw_image_realloc(image,fmt,w,h)<0) return 0;
+  int y=0; for (;y<h;y++) {
+    uint8_t *p=image->pixels+y*image->rowstride;
+    int x=0; for (;x<w;x++,p+=image->colstride) {
+      if (fmt==PS_SDRAW_FMT_A) {
+        p[0]=test_sdraw_random_alpha();
+        continue;
+      }
+      if (rand()&1) {
+        p[0]=p[1]=p[2]=rand();
+      } else {
+        p[0]=rand();
+        p[1]=rand();
+        p[2]=rand();
+      }
+      if (image->colstride==4) p[3]=test_sdraw_random_alpha();
+    }
+  }
+  return image;
+}
+
+/* Draw the same thing with and without kernels, and compare.
+ */
+
+#define TEST_SDRAW_SCREENW 200
+#define TEST_SDRAW_SCREENH 120
+
+struct test_sdraw_pair {
+  struct ps_sdraw_image *generic,*fast;
+};
+
+static int test_sdraw_pair_init(struct test_sdraw_pair *pair) {
+  if (!(pair->generic=test_sdraw_random_image(PS_SDRAW_FMT_RGBX,TEST_SDRAW_SCREENW,TEST_SDRAW_SCREENH))) return -1;
+  if (!(pair->fast=ps_sdraw_image_copy(pair->generic))) return -1;
+  return 0;
+}
+
+static int test_sdraw_pair_compare(const struct test_sdraw_pair *pair) {
+  int c=pair->generic->rowstride*pair->generic->h;
+  return memcmp(pair->generic->pixels,pair->fast->pixels,c);
+}
+
+static int test_sdraw_random_position(int limit) {
+  return (rand()%(limit+64))-32;
+}
+
+PS_TEST(test_sdraw_blit_kernels_match_generic,sdraw) {
+  const int srcfmtv[]={PS_SDRAW_FMT_RGBA,PS_SDRAW_FMT_RGBX,PS_SDRAW_FMT_RGB};
+  int i=0; for (;i<sizeof(srcfmtv)/sizeof(int);i++) {
+    struct ps_sdraw_image *src=test_sdraw_random_image(srcfmtv[i],64,48);
+    PS_ASSERT(src)
+    struct test_sdraw_pair pair;
+    PS_ASSERT_CALL(test_sdraw_pair_init(&pair))
+    int repc=500; while (repc-->0) {
+      int dstx=test_sdraw_random_position(TEST_SDRAW_SCREENW);
+      int dsty=test_sdraw_random_position(TEST_SDRAW_SCREENH);
+      int srcx=(rand()%80)-8,srcy=(rand()%60)-6;
+      int srcw=1+rand()%40,srch=1+rand()%40;
+      int dstw=srcw,dsth=srch;
+      switch (rand()%3) {
+        case 1: dstw=srcw*(1+rand()%4); dsth=srch*(1+rand()%4); break;
+        case 2: dstw=1+rand()%100; dsth=1+rand()%100; break;
+      }
+      ps_sdraw_set_kernels_enabled(0);
+      PS_ASSERT_CALL(ps_sdraw_blit(pair.generic,dstx,dsty,dstw,dsth,src,srcx,srcy,srcw,srch))
+      ps_sdraw_set_kernels_enabled(1);
+      PS_ASSERT_INTS(ps_sdraw_blit(pair.fast,dstx,dsty,dstw,dsth,src,srcx,srcy,srcw,srch),0)
+      PS_ASSERT_NOT(test_sdraw_pair_compare(&pair),
+        "fmt=%d dst=(%d,%d,%d,%d) src=(%d,%d,%d,%d)",srcfmtv[i],dstx,dsty,dstw,dsth,srcx,srcy,srcw,srch
+      )
+    }
+    ps_sdraw_image_del(pair.generic);
+    ps_sdraw_image_del(pair.fast);
+    ps_sdraw_image_del(src);
+  }
+  return 0;
+}
+
+PS_TEST(test_sdraw_blit_replacergb_kernels_match_generic,sdraw) {
+  struct ps_sdraw_image *src=test_sdraw_random_image(PS_SDRAW_FMT_A,64,64);
+  PS_ASSERT(src)
+  struct test_sdraw_pair pair;
+  PS_ASSERT_CALL(test_sdraw_pair_init(&pair))
+  int repc=500; while (repc-->0) {
+    int dstx=test_sdraw_random_position(TEST_SDRAW_SCREENW);
+    int dsty=test_sdraw_random_position(TEST_SDRAW_SCREENH);
+    int srcx=rand()%60,srcy=rand()%60;
+    int srcw=1+rand()%16,srch=1+rand()%16;
+    int dstw=srcw,dsth=srch;
+    if (rand()&1) { dsth=1+rand()%32; dstw=dsth>>1; }
+    struct ps_sdraw_rgba rgba=ps_sdraw_rgba(rand(),rand(),rand(),test_sdraw_random_alpha());
+    ps_sdraw_set_kernels_enabled(0);
+    PS_ASSERT_CALL(ps_sdraw_blit_replacergb(pair.generic,dstx,dsty,dstw,dsth,src,srcx,srcy,srcw,srch,rgba))
+    ps_sdraw_set_kernels_enabled(1);
+    PS_ASSERT_CALL(ps_sdraw_blit_replacergb(pair.fast,dstx,dsty,dstw,dsth,src,srcx,srcy,srcw,srch,rgba))
+    PS_ASSERT_NOT(test_sdraw_pair_compare(&pair),
+      "dst=(%d,%d,%d,%d) src=(%d,%d,%d,%d)",dstx,dsty,dstw,dsth,srcx,srcy,srcw,srch
+    )
+  }
+  ps_sdraw_image_del(pair.generic);
+  ps_sdraw_image_del(pair.fast);
+  ps_sdraw_image_del(src);
+  return 0;
+}
+
+PS_TEST(test_sdraw_blit_maxtile_kernels_match_generic,sdraw) {
+  struct ps_sdraw_image *src=test_sdraw_random_image(PS_SDRAW_FMT_RGBA,256,256);
+  PS_ASSERT(src)
+  struct test_sdraw_pair pair;
+  PS_ASSERT_CALL(test_sdraw_pair_init(&pair))
+  struct akgl_vtx_maxtile vtxv[8];
+  int repc=500; while (repc-->0) {
+    int vtxc=1+rand()%8,i;
+    for (i=0;i<vtxc;i++) {
+      struct akgl_vtx_maxtile *vtx=vtxv+i;
+      vtx->x=test_sdraw_random_position(TEST_SDRAW_SCREENW);
+      vtx->y=test_sdraw_random_position(TEST_SDRAW_SCREENH);
+      vtx->tileid=rand();
+      vtx->size=(rand()&1)?16:(1+rand()%64);
+      vtx->tr=rand(); vtx->tg=rand(); vtx->tb=rand();
+      vtx->ta=(rand()&1)?0:rand();
+      if (rand()&1) { vtx->pr=vtx->pg=vtx->pb=0x80; }
+      else { vtx->pr=rand(); vtx->pg=rand(); vtx->pb=rand(); }
+      vtx->a=(rand()&1)?0xff:rand();
+      vtx->t=(rand()%3)?0:rand();
+      vtx->xform=rand()&7;
+    }
+    ps_sdraw_set_kernels_enabled(0);
+    PS_ASSERT_CALL(ps_sdraw_blit_maxtiles(pair.generic,vtxv,vtxc,src))
+    ps_sdraw_set_kernels_enabled(1);
+    PS_ASSERT_CALL(ps_sdraw_blit_maxtiles(pair.fast,vtxv,vtxc,src))
+    PS_ASSERT_NOT(test_sdraw_pair_compare(&pair),
+      "vtx[0]: (%d,%d) size=%d xform=%d t=%d ta=%d a=%d",
+      vtxv[0].x,vtxv[0].y,vtxv[0].size,vtxv[0].xform,vtxv[0].t,vtxv[0].ta,vtxv[0].a
+    )
+  }
+  ps_sdraw_image_del(pair.generic);
+  ps_sdraw_image_del(pair.fast);
+  ps_sdraw_image_del(src);
+  return 0;
+}
@@ -0,0 +1,48 @@
+#include "test/ps_test.h"
+#include "util/ps_prng.h"
+
+/* Same seed, same sequence; different seeds, different sequences.
+ */
+
+PS_TEST(test_prng_repeatable,prng) {
+  struct ps_prng a,b;
+  ps_prng_init(&a,12345);
+  ps_prng_init(&b,12345);
+  int i=0; for (;i<1000;i++) PS_ASSERT_INTS(ps_prng_next(&a),ps_prng_next(&b))
+
+  ps_prng_init(&a,0);
+  ps_prng_init(&b,1);
+  int samec=0;
+  for (i=0;i<1000;i++) if (ps_prng_next(&a)==ps_prng_next(&b)) samec++;
+  PS_ASSERT_INTS_OP(samec,<,3)
+
+  /* A zero seed must still produce something. */
+  ps_prng_init(&a,0);
+  uint32_t bits=0;
+  for (i=0;i<16;i++) bits|=ps_prng_next(&a);
+  PS_ASSERT_INTS(bits,0xffffffff)
+  return 0;
+}
+
+/* Integers stay in range and cover it fairly evenly.
+ */
+
+PS_TEST(test_prng_int_range,prng) {
+  struct ps_prng prng;
+  ps_prng_init(&prng,99);
+  PS_ASSERT_INTS(ps_prng_int(&prng,0),0)
+  PS_ASSERT_INTS(ps_prng_int(&prng,-5),0)
+  PS_ASSERT_INTS(ps_prng_int(&prng,1),0)
+
+  int countv[10]={0};
+  int i=0; for (;i<100000;i++) {
+    int n=ps_prng_int(&prng,10);
+    PS_ASSERT(n>=0&&n<10,"n=%d",n)
+    countv[n]++;
+  }
+  for (i=0;i<10;i++) {
+    PS_ASSERT_INTS_OP(countv[i],>,9500)
+    PS_ASSERT_INTS_OP(countv[i],<,10500)
+  }
+  return 0;
+}
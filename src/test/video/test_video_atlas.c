@@ -0,0 +1,108 @@
+#include "test/ps_test.h"
+#include "video/ps_video.h"
+#include "video/ps_video_layer.h"
+#include "res/ps_res_internal.h"
+#include "akgl/akgl.h"
+#include "sdraw/ps_sdraw.h"
+
+/* A layer that draws tiles and sprites hopping between tilesheets, the worst case for batching.
+ */
+
+#define TEST_ATLAS_VTXC 48
+
+static int test_atlas_layer_draw(struct ps_video_layer *layer) {
+  const uint8_t max_tsidv[]={3,4,1};
+  const uint8_t min_tsidv[]={2,5};
+  /* Some sprites are translucent, so each capture must start from the same background. */
+  if (ps_video_draw_rect(0,0,PS_SCREENW,PS_SCREENH,0x000000ff)<0) return -1;
+  int i=0; for (;i<TEST_ATLAS_VTXC;i++) {
+    struct akgl_vtx_mintile mintile={
+      .x=8+(i*37)%PS_SCREENW,
+      .y=8+(i*53)%PS_SCREENH,
+      .tileid=i*7,
+      .page=0xff, // Must be ignored.
+    };
+    if (ps_video_draw_mintile(&mintile,1,min_tsidv[i%sizeof(min_tsidv)])<0) return -1;
+  }
+  for (i=0;i<TEST_ATLAS_VTXC;i++) {
+    struct akgl_vtx_maxtile maxtile={
+      .x=(i*29)%PS_SCREENW,
+      .y=(i*41)%PS_SCREENH,
+      .tileid=i*5,
+      .size=(i%3)?16:24,
+      .tr=0xff,.ta=(i&1)?0x40:0,
+      .pr=0x80+i,.pg=0x80,.pb=0x80-i,
+      .a=(i%5)?0xff:0x80,
+      .t=(i%4)?0:i*9,
+      .xform=i%8,
+      .page=0xff, // Must be ignored.
+    };
+    if (ps_video_draw_maxtile(&maxtile,1,max_tsidv[i%sizeof(max_tsidv)])<0) return -1;
+  }
+  return 0;
+}
+
+static struct ps_sdraw_image *test_atlas_capture(int *cmdc,int enable) {
+  ps_video_set_atlas_enabled(enable);
+  akgl_log_command_count();
+  if (ps_video_draw_to_framebuffer()<0) return 0;
+  *cmdc=akgl_get_command_count();
+  return (struct ps_sdraw_image*)ps_video_capture_framebuffer();
+}
+
+/* Drawing through the atlas must be pixel-identical to drawing from each tilesheet, in fewer commands.
+ */
+
+PS_TEST(test_video_atlas_matches_tilesheets,video) {
+  ps_resmgr_quit();
+  ps_video_quit();
+  PS_ASSERT_CALL(ps_video_init_headless())
+  PS_ASSERT_CALL(ps_resmgr_init("src/data",0))
+
+  /* Every sheet in src/data is 256x256 RGBA except the font. */
+  struct ps_restype *tilesheets=ps_resmgr.typev+PS_RESTYPE_TILESHEET;
+  PS_ASSERT_INTS_OP(tilesheets->resc,>,5)
+  int i=0; for (;i<tilesheets->resc;i++) {
+    const struct ps_res_TILESHEET *tilesheet=tilesheets->resv[i].obj;
+    PS_ASSERT(tilesheet&&tilesheet->texture)
+    int w=0,h=0;
+    PS_ASSERT_CALL(akgl_texture_get_size(&w,&h,tilesheet->texture))
+    if ((w==256)&&(h==256)&&(akgl_texture_get_fmt(tilesheet->texture)==AKGL_FMT_RGBA8)) {
+      PS_ASSERT_INTS_OP(tilesheet->page,>=,0,"tilesheet:%d",tilesheets->resv[i].id)
+    } else {
+      PS_ASSERT_INTS_OP(tilesheet->page,<,0,"tilesheet:%d",tilesheets->resv[i].id)
+    }
+  }
+
+  struct ps_video_layer *layer=ps_video_layer_new(sizeof(struct ps_video_layer));
+  PS_ASSERT(layer)
+  layer->blackout=1;
+  layer->draw=test_atlas_layer_draw;
+  PS_ASSERT_CALL(ps_video_install_layer(layer,-1))
+  ps_video_layer_del(layer);
+
+  int atlas_cmdc=0,plain_cmdc=0;
+  struct ps_sdraw_image *atlas=test_atlas_capture(&atlas_cmdc,1);
+  struct ps_sdraw_image *plain=test_atlas_capture(&plain_cmdc,0);
+  PS_ASSERT(atlas&&plain)
+  PS_ASSERT_INTS(atlas->w,plain->w)
+  PS_ASSERT_INTS(atlas->h,plain->h)
+  int y=0; for (;y<atlas->h;y++) {
+    if (memcmp(
+      atlas->pixels+y*atlas->rowstride,plain->pixels+y*plain->rowstride,atlas->w*atlas->colstride
+    )) {
+      PS_FAIL("Atlas draw differs from tilesheets at row %d.",y)
+    }
+  }
+  ps_sdraw_image_del(atlas);
+  ps_sdraw_image_del(plain);
+
+  /* One batch per tilesheet change without the atlas; one of each kind with it. */
+  PS_ASSERT_INTS_OP(plain_cmdc,>=,TEST_ATLAS_VTXC*2)
+  PS_ASSERT_INTS_OP(atlas_cmdc,<=,2)
+
+  ps_video_set_atlas_enabled(1);
+  ps_resmgr_quit();
+  ps_video_quit();
+  return 0;
+}
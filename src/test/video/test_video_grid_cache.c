@@ -0,0 +1,159 @@
+#include "test/ps_test.h"
+#include "video/ps_video.h"
+#include "video/ps_video_layer.h"
+#include "res/ps_res_internal.h"
+#include "scenario/ps_grid.h"
+#include "scenario/ps_region.h"
+#include "sdraw/ps_sdraw.h"
+#include "os/ps_userconfig.h"
+
+/* A layer that draws only the grid.
+ */
+
+static struct ps_grid *test_grid=0;
+static int test_offx=0,test_offy=0;
+static int test_gl=0;
+
+static int test_grid_layer_draw(struct ps_video_layer *layer) {
+  return ps_video_draw_grid(test_grid,test_offx,test_offy);
+}
+
+/* Draw the test grid with or without the cache, and compare.
+ */
+
+static struct ps_sdraw_image *test_grid_capture(int cache) {
+  ps_video_set_grid_cache_enabled(cache);
+  if (ps_video_draw_to_framebuffer()<0) return 0;
+  if (!test_gl) return (struct ps_sdraw_image*)ps_video_capture_framebuffer();
+
+  /* Under GL, the captured texture lives on the GPU. Read back raw pixels instead. */
+  uint8_t *pixels=0;
+  if (ps_video_capture_framebuffer_raw(&pixels,0)<0) return 0;
+  struct ps_sdraw_image *image=ps_sdraw_image_new();
+  if (!image||(ps_sdraw_image_realloc(image,PS_SDRAW_FMT_RGBA,PS_SCREENW,PS_SCREENH)<0)) {
+    ps_sdraw_image_del(image);
+    free(pixels);
+    return 0;
+  }
+  int y=0; for (;y<PS_SCREENH;y++) {
+    memcpy(image->pixels+y*image->rowstride,pixels+y*PS_SCREENW*4,PS_SCREENW*4);
+  }
+  free(pixels);
+  return image;
+}
+
+static int test_grid_cache_matches_direct() {
+  struct ps_sdraw_image *cached=test_grid_capture(1);
+  struct ps_sdraw_image *direct=test_grid_capture(0);
+  PS_ASSERT(cached&&direct)
+  PS_ASSERT_INTS(cached->w,direct->w)
+  PS_ASSERT_INTS(cached->h,direct->h)
+  int y=0; for (;y<cached->h;y++) {
+    if (memcmp(
+      cached->pixels+y*cached->rowstride,direct->pixels+y*direct->rowstride,cached->w*cached->colstride
+    )) {
+      PS_FAIL("Cached grid differs from direct draw at row %d, offset (%d,%d).",y,test_offx,test_offy)
+    }
+  }
+  ps_sdraw_image_del(cached);
+  ps_sdraw_image_del(direct);
+  return 0;
+}
+
+static void test_grid_randomize(struct ps_grid *grid,int cellc) {
+  while (cellc-->0) {
+    grid->cellv[rand()%PS_GRID_SIZE].tileid=rand();
+  }
+}
+
+/* Every draw through the cache must be pixel-identical to drawing each tile.
+ * Video must be initialized; we load resources and install a layer.
+ */
+
+static int test_grid_cache_scenarios() {
+  PS_ASSERT_CALL(ps_resmgr_init("src/data",0))
+
+  struct ps_restype *regions=ps_resmgr.typev+PS_RESTYPE_REGION;
+  PS_ASSERT_INTS_OP(regions->resc,>,1)
+  struct ps_region *regiona=ps_res_get(PS_RESTYPE_REGION,regions->resv[0].id);
+  struct ps_region *regionb=ps_res_get(PS_RESTYPE_REGION,regions->resv[1].id);
+  PS_ASSERT(regiona&&regionb)
+
+  struct ps_video_layer *layer=ps_video_layer_new(sizeof(struct ps_video_layer));
+  PS_ASSERT(layer)
+  layer->blackout=1;
+  layer->draw=test_grid_layer_draw;
+  PS_ASSERT_CALL(ps_video_install_layer(layer,-1))
+  ps_video_layer_del(layer);
+
+  struct ps_grid *grida=ps_grid_new();
+  struct ps_grid *gridb=ps_grid_new();
+  PS_ASSERT(grida&&gridb)
+  grida->region=regiona;
+  gridb->region=regionb;
+  srand(12345);
+  test_grid_randomize(grida,PS_GRID_SIZE*4);
+  test_grid_randomize(gridb,PS_GRID_SIZE*4);
+
+  // Fresh grid, then a few cells changed, like a barrier opening.
+  test_grid=grida;
+  PS_ASSERT_CALL(test_grid_cache_matches_direct())
+  test_grid_randomize(grida,5);
+  PS_ASSERT_CALL(test_grid_cache_matches_direct())
+
+  // Another screen, then back to the first, which changed while we were away.
+  test_grid=gridb;
+  PS_ASSERT_CALL(test_grid_cache_matches_direct())
+  test_grid_randomize(grida,20);
+  test_grid=grida;
+  PS_ASSERT_CALL(test_grid_cache_matches_direct())
+
+  // Mid-slide, partly offscreen.
+  test_offx=-37;
+  test_offy=50;
+  PS_ASSERT_CALL(test_grid_cache_matches_direct())
+  test_offx=0;
+  test_offy=0;
+
+  // The same object reused for different content must not show stale tiles.
+  grida->region=regionb;
+  PS_ASSERT_CALL(test_grid_cache_matches_direct())
+
+  ps_video_set_grid_cache_enabled(1);
+  test_grid=0;
+  ps_grid_del(grida);
+  ps_grid_del(gridb);
+  ps_resmgr_quit();
+  return 0;
+}
+
+PS_TEST(test_video_grid_cache_matches_direct_draw,video) {
+  ps_resmgr_quit();
+  ps_video_quit();
+  PS_ASSERT_CALL(ps_video_init_headless())
+  test_gl=0;
+  PS_ASSERT_CALL(test_grid_cache_scenarios())
+  ps_video_quit();
+  return 0;
+}
+
+/* Same again with OpenGL, where the cache is a real framebuffer and the composite goes through a shader.
+ * Opens a window, so not run by default.
+ */
+
+PS_TEST(test_video_grid_cache_matches_direct_draw_gl,ignore,video) {
+  ps_resmgr_quit();
+  ps_video_quit();
+  struct ps_userconfig *userconfig=ps_userconfig_new();
+  PS_ASSERT(userconfig)
+  PS_ASSERT_CALL(ps_userconfig_declare_default_fields(userconfig))
+  PS_ASSERT_CALL(ps_userconfig_set(userconfig,"fullscreen",-1,"0",-1))
+  PS_ASSERT_CALL(ps_userconfig_set(userconfig,"soft-render",-1,"0",-1))
+  PS_ASSERT_CALL(ps_video_init(userconfig))
+  ps_userconfig_del(userconfig);
+  test_gl=1;
+  int err=test_grid_cache_scenarios();
+  test_gl=0;
+  ps_video_quit();
+  return err;
+}
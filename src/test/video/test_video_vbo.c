@@ -0,0 +1,117 @@
+#include "test/ps_test.h"
+#include "video/ps_video.h"
+#include "os/ps_userconfig.h"
+#include "akgl/akgl_internal.h"
+
+/* Draw the same scene with akgl's vertex buffer and with client-side arrays, and compare pixels.
+ * Small batches every frame wrap the ring several times, and one big batch in the middle forces it to grow.
+ * Needs GL, so it opens a window, and isn't run by default.
+ */
+
+#define TEST_VBO_FRAMEC 3000
+#define TEST_VBO_BIG_FRAME 1000
+#define TEST_VBO_BIGC 8000
+
+static struct akgl_vtx_maxtile test_vbo_bigv[TEST_VBO_BIGC];
+
+static int test_vbo_draw_scene(
+  uint8_t *pixels,int *wrapc,
+  struct akgl_framebuffer *framebuffer,struct akgl_program *maxtile,struct akgl_program *raw,struct akgl_texture *texture
+) {
+  srand(1234);
+  PS_ASSERT_CALL(akgl_framebuffer_use(framebuffer))
+  PS_ASSERT_CALL(akgl_clear(0x000000ff))
+  int vbop=akgl.vbop;
+  int frame=0; for (;frame<TEST_VBO_FRAMEC;frame++) {
+
+    struct akgl_vtx_maxtile vtxv[10]={0};
+    int i=0; for (;i<10;i++) {
+      vtxv[i].x=rand()%PS_SCREENW;
+      vtxv[i].y=rand()%PS_SCREENH;
+      vtxv[i].tileid=rand();
+      vtxv[i].size=16;
+      vtxv[i].pr=vtxv[i].pg=vtxv[i].pb=0x80;
+      vtxv[i].a=0xff;
+    }
+    PS_ASSERT_CALL(akgl_program_maxtile_draw(maxtile,texture,vtxv,10,1))
+
+    struct akgl_vtx_raw rawv[3]={
+      {rand()%PS_SCREENW,rand()%PS_SCREENH,0xff,0x00,0x00,0x80},
+      {rand()%PS_SCREENW,rand()%PS_SCREENH,0x00,0xff,0x00,0xff},
+      {rand()%PS_SCREENW,rand()%PS_SCREENH,0x00,0x00,0xff,0xff},
+    };
+    PS_ASSERT_CALL(akgl_program_raw_draw_triangle_strip(raw,rawv,3))
+
+    if (frame==TEST_VBO_BIG_FRAME) {
+      for (i=0;i<TEST_VBO_BIGC;i++) {
+        test_vbo_bigv[i]=vtxv[i%10];
+        test_vbo_bigv[i].x=(i*7)%PS_SCREENW;
+        test_vbo_bigv[i].y=(i*3)%PS_SCREENH;
+        test_vbo_bigv[i].size=4;
+      }
+      PS_ASSERT_CALL(akgl_program_maxtile_draw(maxtile,texture,test_vbo_bigv,TEST_VBO_BIGC,1))
+    }
+
+    if (akgl.vbop<vbop) (*wrapc)++;
+    vbop=akgl.vbop;
+  }
+  glReadPixels(0,0,PS_SCREENW,PS_SCREENH,GL_RGBA,GL_UNSIGNED_BYTE,pixels);
+  PS_ASSERT_CALL(akgl_framebuffer_use(0))
+  return 0;
+}
+
+PS_TEST(test_video_vbo_matches_client_arrays,ignore,video) {
+  ps_video_quit();
+  struct ps_userconfig *userconfig=ps_userconfig_new();
+  PS_ASSERT(userconfig)
+  PS_ASSERT_CALL(ps_userconfig_declare_default_fields(userconfig))
+  PS_ASSERT_CALL(ps_userconfig_set(userconfig,"fullscreen",-1,"0",-1))
+  PS_ASSERT_CALL(ps_userconfig_set(userconfig,"soft-render",-1,"0",-1))
+  PS_ASSERT_CALL(ps_video_init(userconfig))
+  ps_userconfig_del(userconfig);
+
+  struct akgl_framebuffer *framebuffer=akgl_framebuffer_new();
+  struct akgl_program *maxtile=akgl_program_maxtile_new();
+  struct akgl_program *raw=akgl_program_raw_new();
+  struct akgl_texture *texture=akgl_texture_new();
+  PS_ASSERT(framebuffer&&maxtile&&raw&&texture)
+  PS_ASSERT_CALL(akgl_framebuffer_resize(framebuffer,PS_SCREENW,PS_SCREENH))
+  uint8_t *sheet=malloc(256*256*4);
+  PS_ASSERT(sheet)
+  srand(5678);
+  int i=0; for (;i<256*256*4;i++) sheet[i]=rand();
+  PS_ASSERT_CALL(akgl_texture_load(texture,sheet,AKGL_FMT_RGBA8,256,256))
+  free(sheet);
+
+  uint8_t *client=malloc(PS_SCREENW*PS_SCREENH*4);
+  uint8_t *vbo=malloc(PS_SCREENW*PS_SCREENH*4);
+  PS_ASSERT(client&&vbo)
+  int wrapc=0;
+  akgl_set_vbo_enabled(0);
+  PS_ASSERT_CALL(test_vbo_draw_scene(client,&wrapc,framebuffer,maxtile,raw,texture))
+  PS_ASSERT_INTS(akgl.vboid,0,"Client arrays must not touch the buffer.")
+  akgl_set_vbo_enabled(1);
+  PS_ASSERT_CALL(test_vbo_draw_scene(vbo,&wrapc,framebuffer,maxtile,raw,texture))
+  PS_ASSERT(akgl.vboid,"Fell back to client arrays; see log.")
+  PS_ASSERT_INTS_OP(wrapc,>=,2,"Ring should wrap before and after growing.")
+  PS_ASSERT_INTS_OP(akgl.vboa,>=,(int)sizeof(test_vbo_bigv))
+  akgl_set_vbo_enabled(0);
+
+  int nonzeroc=0;
+  for (i=0;i<PS_SCREENW*PS_SCREENH*4;i++) if (client[i]) nonzeroc++;
+  PS_ASSERT_INTS_OP(nonzeroc,>,PS_SCREENW*PS_SCREENH,"Scene should not be blank.")
+  int y=0; for (;y<PS_SCREENH;y++) {
+    if (memcmp(client+y*PS_SCREENW*4,vbo+y*PS_SCREENW*4,PS_SCREENW*4)) {
+      PS_FAIL("Vertex buffer output differs from client arrays at row %d.",y)
+    }
+  }
+
+  free(client);
+  free(vbo);
+  akgl_texture_del(texture);
+  akgl_program_del(raw);
+  akgl_program_del(maxtile);
+  akgl_framebuffer_del(framebuffer);
+  ps_video_quit();
+  return 0;
+}
@@ -1,6 +1,7 @@
 #include "ps.h"
 #include "ps_perfmon.h"
 #include "os/ps_clockassist.h"
+#include "scenario/ps_scgen_async.h"
 
 /* Object.
  */
@@ -19,6 +20,13 @@ struct ps_perfmon {
   int64_t framec_recent;
 
   int64_t autolog;
+
+  int (*cb_audio)(int *latency_us,int *xrunc);
+  int xrunc_load; // Underrun count at finish_load.
+  int xrunc_recent; // Underrun count at last log.
+
+  int (*cb_generator)(struct ps_scgen_async_status *status);
+  int generator_finishc_recent; // (finishc+abortc+takec) at last log.
 };
 
 /* Reports.
@@ -42,6 +50,48 @@ static void ps_perfmon_report_recent(const struct ps_perfmon *perfmon,int64_t no
   }
 }
 
+static void ps_perfmon_report_audio_recent(struct ps_perfmon *perfmon) {
+  int latency_us=0,xrunc=0;
+  if (!perfmon->cb_audio) return;
+  if (perfmon->cb_audio(&latency_us,&xrunc)<0) return;
+  if (xrunc>perfmon->xrunc_recent) {
+    ps_log(AUDIO,WARN,"Audio latency %d us, %d new underruns",latency_us,xrunc-perfmon->xrunc_recent);
+  } else {
+    ps_log(AUDIO,DEBUG,"Audio latency %d us, no underruns",latency_us);
+  }
+  perfmon->xrunc_recent=xrunc;
+}
+
+static void ps_perfmon_report_audio_game(const struct ps_perfmon *perfmon) {
+  int latency_us=0,xrunc=0;
+  if (!perfmon->cb_audio) return;
+  if (perfmon->cb_audio(&latency_us,&xrunc)<0) return;
+  ps_log(AUDIO,INFO,"Audio latency %d us, %d underruns during play",latency_us,xrunc-perfmon->xrunc_load);
+}
+
+static void ps_perfmon_report_generator_recent(struct ps_perfmon *perfmon) {
+  struct ps_scgen_async_status status={0};
+  if (!perfmon->cb_generator) return;
+  if (perfmon->cb_generator(&status)<0) return;
+  int eventc=status.finishc+status.abortc+status.takec;
+  if (eventc==perfmon->generator_finishc_recent) return;
+  perfmon->generator_finishc_recent=eventc;
+  ps_log(CLOCK,DEBUG,
+    "Background generator: %d requested, %d abandoned, %d ready, %d used. Last took %d us, commit waited %d us.",
+    status.requestc,status.abortc,status.finishc,status.takec,(int)status.last_generate_us,(int)status.last_wait_us
+  );
+}
+
+static void ps_perfmon_report_generator_game(const struct ps_perfmon *perfmon) {
+  struct ps_scgen_async_status status={0};
+  if (!perfmon->cb_generator) return;
+  if (perfmon->cb_generator(&status)<0) return;
+  ps_log(CLOCK,INFO,
+    "Background generator: %d of %d requests used, %d abandoned, %d failed, %d commits generated in the foreground",
+    status.takec,status.requestc,status.abortc,status.failc,status.missc
+  );
+}
+
 static void ps_perfmon_report_game(const struct ps_perfmon *perfmon) {
   if (perfmon->framec>0) {
     int64_t elapsed=perfmon->t_finish-perfmon->t_load;
@@ -100,6 +150,25 @@ int ps_perfmon_set_autolog(struct ps_perfmon *perfmon,int64_t interval_us) {
   return 0;
 }
 
+int ps_perfmon_set_audio_status_source(struct ps_perfmon *perfmon,int (*cb)(int *latency_us,int *xrunc)) {
+  if (!perfmon) return -1;
+  perfmon->cb_audio=cb;
+  return 0;
+}
+
+int ps_perfmon_count_audio_underruns(const struct ps_perfmon *perfmon) {
+  if (!perfmon||!perfmon->cb_audio) return -1;
+  int latency_us=0,xrunc=0;
+  if (perfmon->cb_audio(&latency_us,&xrunc)<0) return -1;
+  return xrunc-perfmon->xrunc_load;
+}
+
+int ps_perfmon_set_generator_status_source(struct ps_perfmon *perfmon,int (*cb)(struct ps_scgen_async_status *status)) {
+  if (!perfmon) return -1;
+  perfmon->cb_generator=cb;
+  return 0;
+}
+
 /* Application lifecycle events.
  */
  
@@ -109,6 +178,13 @@ int ps_perfmon_finish_load(struct ps_perfmon *perfmon) {
   perfmon->t_recent=perfmon->t_load;
   perfmon->framec=0;
   perfmon->framec_recent=0;
+  if (perfmon->cb_audio) {
+    int latency_us=0,xrunc=0;
+    if (perfmon->cb_audio(&latency_us,&xrunc)>=0) {
+      perfmon->xrunc_load=xrunc;
+      perfmon->xrunc_recent=xrunc;
+    }
+  }
   ps_perfmon_report_load(perfmon);
   return 0;
 }
@@ -133,6 +209,8 @@ int ps_perfmon_begin_quit(struct ps_perfmon *perfmon) {
   if (!perfmon) return 0;
   perfmon->t_finish=ps_time_now();
   ps_perfmon_report_game(perfmon);
+  ps_perfmon_report_audio_game(perfmon);
+  ps_perfmon_report_generator_game(perfmon);
   return 0;
 }
 
@@ -143,6 +221,8 @@ int ps_perfmon_log(struct ps_perfmon *perfmon) {
   if (!perfmon) return -1;
   int64_t now=ps_time_now();
   ps_perfmon_report_recent(perfmon,now);
+  ps_perfmon_report_audio_recent(perfmon);
+  ps_perfmon_report_generator_recent(perfmon);
   perfmon->t_recent=now;
   perfmon->framec_recent=0;
   return 0;
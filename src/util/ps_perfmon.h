@@ -6,6 +6,7 @@
 #define PS_PERFMON_H
 
 struct ps_perfmon;
+struct ps_scgen_async_status;
 
 struct ps_perfmon *ps_perfmon_new();
 void ps_perfmon_del(struct ps_perfmon *perfmon);
@@ -15,6 +16,23 @@ int ps_perfmon_ref(struct ps_perfmon *perfmon);
  */
 int ps_perfmon_set_autolog(struct ps_perfmon *perfmon,int64_t interval_us);
 
+/* Optional source of audio status: Worst-case output latency, and underruns since audio started.
+ * Return <0 if audio isn't running or the driver doesn't know.
+ * Periodic logs include the latency and new underruns, and the final game report includes the total.
+ */
+int ps_perfmon_set_audio_status_source(struct ps_perfmon *perfmon,int (*cb)(int *latency_us,int *xrunc));
+
+/* Underruns since ps_perfmon_finish_load(), as the final game report counts them.
+ * <0 if there's no audio status source or it doesn't know.
+ */
+int ps_perfmon_count_audio_underruns(const struct ps_perfmon *perfmon);
+
+/* Optional source of background scenario generation status (see ps_scgen_async.h).
+ * Return <0 if there's no background generator.
+ * Periodic logs report new activity, and the final game report includes the totals.
+ */
+int ps_perfmon_set_generator_status_source(struct ps_perfmon *perfmon,int (*cb)(struct ps_scgen_async_status *status));
+
 /* Application lifecycle events.
  * Construction and destruction of the monitor itself are implicit events too.
  */
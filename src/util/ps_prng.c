@@ -0,0 +1,45 @@
+#include "ps.h"
+#include "ps_prng.h"
+
+/* Init.
+ * Expand the seed with splitmix32, which never yields the all-zero state xoshiro can't leave.
+ */
+
+void ps_prng_init(struct ps_prng *prng,uint32_t seed) {
+  if (!prng) return;
+  int i=0; for (;i<4;i++) {
+    uint32_t z=(seed+=0x9e3779b9);
+    z=(z^(z>>16))*0x85ebca6b;
+    z=(z^(z>>13))*0xc2b2ae35;
+    prng->s[i]=z^(z>>16);
+  }
+}
+
+/* Next.
+ */
+
+static inline uint32_t ps_prng_rotl(uint32_t x,int k) {
+  return (x<<k)|(x>>(32-k));
+}
+
+uint32_t ps_prng_next(struct ps_prng *prng) {
+  uint32_t *s=prng->s;
+  uint32_t result=ps_prng_rotl(s[1]*5,7)*9;
+  uint32_t t=s[1]<<9;
+  s[2]^=s[0];
+  s[3]^=s[1];
+  s[1]^=s[2];
+  s[0]^=s[3];
+  s[2]^=t;
+  s[3]=ps_prng_rotl(s[3],11);
+  return result;
+}
+
+/* Integer in range.
+ * Multiply-and-shift instead of modulus; the bias is negligible for our limits.
+ */
+
+int ps_prng_int(struct ps_prng *prng,int limit) {
+  if (!prng||(limit<1)) return 0;
+  return (int)(((uint64_t)ps_prng_next(prng)*(uint32_t)limit)>>32);
+}
@@ -0,0 +1,29 @@
+/* ps_prng.h
+ * Small seedable pseudo-random number generator (xoshiro128**).
+ * Each consumer owns one, so a seed reproduces the same sequence on every platform,
+ * and two generators never disturb each other, even on different threads.
+ * Use this instead of rand() for anything that should replay from a seed.
+ */
+
+#ifndef PS_PRNG_H
+#define PS_PRNG_H
+
+#include <stdint.h>
+
+struct ps_prng {
+  uint32_t s[4];
+};
+
+/* Any seed is fine, including zero.
+ */
+void ps_prng_init(struct ps_prng *prng,uint32_t seed);
+
+/* Next 32 random bits.
+ */
+uint32_t ps_prng_next(struct ps_prng *prng);
+
+/* Random integer in 0..limit-1, or zero if (limit<1).
+ */
+int ps_prng_int(struct ps_prng *prng,int limit);
+
+#endif
@@ -142,6 +142,49 @@ int ps_image_decode_pixels(
   if (!src) return -1;
   if (srcc<0) return -1;
   if (!pixelspp||!fmt||!w||!h) return -1;
+
+  /* psimage, as written by ps_image_encode() into archives. */
+  if ((srcc>=16)&&!memcmp(src,"PSIMG\0\xff\0",8)) {
+    const uint8_t *SRC=src;
+    int pw=(SRC[8]<<8)|SRC[9];
+    int ph=(SRC[10]<<8)|SRC[11];
+    int pixelsize=ps_pixelsize_for_akgl_fmt(SRC[12]);
+    if (!pw||!ph||(pixelsize<1)) return -1;
+    if (pw>(INT_MAX/ph)>>2) return -1;
+    int stride=pw*pixelsize;
+    if (stride>INT_MAX/ph) return -1;
+    int bodysize=stride*ph;
+    if (bodysize>INT_MAX-16) return -1;
+    if (srcc!=16+bodysize) return -1;
+    void *pixels=malloc(bodysize);
+    if (!pixels) return -1;
+    memcpy(pixels,SRC+16,bodysize);
+    *(void**)pixelspp=pixels;
+    *fmt=SRC[12];
+    *w=pw;
+    *h=ph;
+    return 0;
+  }
+  
+  /* Raw pixels, identified by length. */
+  const int tilesheet_size=(PS_TILESIZE*PS_TILESIZE)*256;
+  if ((srcc==tilesheet_size*1)||(srcc==tilesheet_size*2)||(srcc==tilesheet_size*3)||(srcc==tilesheet_size*4)) {
+    if ((srcc<8)||memcmp(src,"\x89PNG\r\n\x1a\n",8)) {
+      void *pixels=malloc(srcc);
+      if (!pixels) return -1;
+      memcpy(pixels,src,srcc);
+      *(void**)pixelspp=pixels;
+      switch (srcc/tilesheet_size) {
+        case 1: *fmt=AKGL_FMT_Y8; break;
+        case 2: *fmt=AKGL_FMT_YA8; break;
+        case 3: *fmt=AKGL_FMT_RGB8; break;
+        case 4: *fmt=AKGL_FMT_RGBA8; break;
+      }
+      *w=PS_TILESIZE*16;
+      *h=PS_TILESIZE*16;
+      return 0;
+    }
+  }
   
   struct akpng_image image={0};
 
@@ -165,6 +208,20 @@ int ps_image_decode_pixels(
   return 0;
 }
 
+/* Upload decoded pixels.
+ */
+
+struct akgl_texture *ps_image_upload_pixels(const void *pixels,int fmt,int w,int h) {
+  if (!pixels) return 0;
+  struct akgl_texture *texture=akgl_texture_new();
+  if (!texture) return 0;
+  if (akgl_texture_load(texture,pixels,fmt,w,h)<0) {
+    akgl_texture_del(texture);
+    return 0;
+  }
+  return texture;
+}
+
 /* Encode image to psimage format.
  */
  
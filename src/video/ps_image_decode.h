@@ -22,14 +22,19 @@ struct akgl_texture *ps_image_decode(
 );
 
 /* Same idea, but we stop at the raw image decode.
- * This should only be needed by tests.
- * Since it's not "production" code, it's incomplete. We only support PNG and don't log extensively.
+ * Accepts the same formats as ps_image_decode(), and doesn't touch the video backend, so it's safe from any thread.
+ * We don't log; caller should.
  */
 int ps_image_decode_pixels(
   void *pixelspp,int *fmt,int *w,int *h,
   const void *src,int srcc
 );
 
+/* Upload pixels from ps_image_decode_pixels() to a new texture.
+ * Video backend must be initialized first, and this is main thread only.
+ */
+struct akgl_texture *ps_image_upload_pixels(const void *pixels,int fmt,int w,int h);
+
 /* Encode to psimage format.
  */
 int ps_image_encode(void *dst,int dsta,const void *pixels,int w,int h,int fmt);
@@ -8,6 +8,7 @@
 struct ps_video_layer;
 struct ps_grid;
 struct ps_sprgrp;
+struct ps_sprite;
 struct akgl_vtx_mintile;
 struct akgl_vtx_maxtile;
 struct akgl_vtx_raw;
@@ -18,6 +19,11 @@ int ps_video_init(struct ps_userconfig *userconfig);
 void ps_video_quit();
 int ps_video_is_init();
 
+/* Initialize with the software renderer and no window, for the headless runner.
+ * Everything works as usual, except that nothing ever reaches a screen.
+ */
+int ps_video_init_headless();
+
 int ps_video_update();
 
 /* Draw one frame as usual but stop after filling the framebuffer.
@@ -68,9 +74,27 @@ int ps_video_text_addf(int size,uint32_t rgba,int x,int y,const char *fmt,...);
 int ps_video_text_addfv(int size,uint32_t rgba,int x,int y,const char *fmt,va_list vargs);
 int ps_video_text_end(int resid);
 
+/* The grid is rendered once into an offscreen buffer and we composite that each frame.
+ * Cells whose tile changed since the last draw (barriers, switches) are patched in place.
+ * Disabling the cache draws every tile every time, like the old days; only useful for measurement.
+ */
 int ps_video_draw_grid(const struct ps_grid *grid,int offx,int offy);
+void ps_video_set_grid_cache_enabled(int enable);
 int ps_video_draw_sprites(const struct ps_sprgrp *grp,int offx,int offy);
+int ps_video_draw_spritev(struct ps_sprite **sprv,int sprc,int offx,int offy);
 
+/* Tilesheets of the common size and format also live in one shared atlas texture.
+ * Sprites and tiles from any of those sheets then draw in one batch, regardless of tsid.
+ * ps_video_atlas_add() copies a tilesheet in and returns its page, or <0 if it doesn't fit.
+ * The tilesheet resource does this at load, and keeps its own texture for everything else.
+ * Disabling the atlas draws from each sheet's own texture; only useful for measurement.
+ */
+int ps_video_atlas_add(const void *pixels,int fmt,int w,int h);
+void ps_video_atlas_remove(int page);
+void ps_video_set_atlas_enabled(int enable);
+
+/* (page) in the vertices is ignored; we set it from (tsid).
+ */
 int ps_video_draw_mintile(const struct akgl_vtx_mintile *vtxv,int vtxc,uint8_t tsid);
 int ps_video_draw_maxtile(const struct akgl_vtx_maxtile *vtxv,int vtxc,uint8_t tsid);
 int ps_video_draw_line_strip(const struct akgl_vtx_raw *vtxv,int vtxc);
@@ -0,0 +1,62 @@
+#include "ps_video_internal.h"
+
+/* Enable or disable.
+ */
+
+void ps_video_set_atlas_enabled(int enable) {
+  ps_video.atlas_disabled=enable?0:1;
+}
+
+/* Create the atlas texture on first use.
+ */
+
+static int ps_video_atlas_require() {
+  if (ps_video.atlas) return 0;
+  if (!(ps_video.atlas=akgl_texture_new())) return -1;
+  int size=PS_VIDEO_ATLAS_COLC*PS_VIDEO_ATLAS_PAGE_SIZE;
+  if (akgl_texture_realloc(ps_video.atlas,AKGL_FMT_RGBA8,size,size)<0) {
+    akgl_texture_del(ps_video.atlas);
+    ps_video.atlas=0;
+    return -1;
+  }
+  return 0;
+}
+
+/* Add tilesheet.
+ */
+
+int ps_video_atlas_add(const void *pixels,int fmt,int w,int h) {
+  if (!ps_video.init) return -1;
+  if (!pixels) return -1;
+  if (fmt!=AKGL_FMT_RGBA8) return -1;
+  if ((w!=PS_VIDEO_ATLAS_PAGE_SIZE)||(h!=PS_VIDEO_ATLAS_PAGE_SIZE)) return -1;
+
+  int page=0;
+  while ((page<PS_VIDEO_ATLAS_PAGE_LIMIT)&&ps_video.atlas_usev[page]) page++;
+  if (page>=PS_VIDEO_ATLAS_PAGE_LIMIT) return -1;
+
+  if (ps_video_atlas_require()<0) {
+    ps_log(VIDEO,ERROR,"Failed to allocate tilesheet atlas.");
+    return -1;
+  }
+  if (akgl_texture_load_sub(
+    ps_video.atlas,pixels,
+    (page%PS_VIDEO_ATLAS_COLC)*PS_VIDEO_ATLAS_PAGE_SIZE,
+    (page/PS_VIDEO_ATLAS_COLC)*PS_VIDEO_ATLAS_PAGE_SIZE,
+    w,h
+  )<0) {
+    ps_log(VIDEO,ERROR,"Failed to copy tilesheet into atlas page %d.",page);
+    return -1;
+  }
+
+  ps_video.atlas_usev[page]=1;
+  return page;
+}
+
+/* Remove tilesheet.
+ */
+
+void ps_video_atlas_remove(int page) {
+  if ((page<0)||(page>=PS_VIDEO_ATLAS_PAGE_LIMIT)) return;
+  ps_video.atlas_usev[page]=0;
+}
@@ -146,25 +146,14 @@ int ps_video_text_end(int resid) {
   return 0;
 }
 
-/* Draw grid.
+/* Draw grid directly, every tile.
  */
- 
-int ps_video_draw_grid(const struct ps_grid *grid,int offx,int offy) {
-  if (!grid) return -1;
+
+static int ps_video_draw_grid_tiles(const struct ps_grid *grid,struct ps_res_TILESHEET *tilesheet,int offx,int offy) {
   if (ps_video_vtxv_reset(sizeof(struct akgl_vtx_mintile))<0) return -1;
   struct akgl_vtx_mintile *vtxv=ps_video_vtxv_add(PS_GRID_SIZE);
   if (!vtxv) return -1;
 
-  if (!grid->region) {
-    ps_log(VIDEO,ERROR,"Can't draw grid without region (is null)");
-    return -1;
-  }
-  struct ps_res_TILESHEET *tilesheet=ps_res_get(PS_RESTYPE_TILESHEET,grid->region->tsid);
-  if (!tilesheet) {
-    ps_log(VIDEO,ERROR,"Tilesheet %d not found, required for grid.",grid->region->tsid);
-    return -1;
-  }
-
   int x=PS_TILESIZE>>1,y=PS_TILESIZE>>1;
   x+=offx;
   y+=offy;
@@ -182,25 +171,188 @@ int ps_video_draw_grid(const struct ps_grid *grid,int offx,int offy) {
   }
 
   if (akgl_program_mintile_draw(
-    ps_video.program_mintile,tilesheet->texture,vtxv,PS_GRID_SIZE,PS_TILESIZE
+    ps_video.program_mintile,tilesheet->texture,vtxv,PS_GRID_SIZE,PS_TILESIZE,1
   )<0) return -1;
   
   return 0;
 }
 
+/* Grid cache.
+ */
+
+void ps_video_set_grid_cache_enabled(int enable) {
+  ps_video.grid_cache_disabled=enable?0:1;
+}
+
+void ps_video_drop_grid_cache() {
+  struct ps_video_grid_cache *cache=ps_video.grid_cachev;
+  int i=ps_video.grid_cachec; for (;i-->0;cache++) {
+    akgl_texture_del(cache->texture);
+    akgl_framebuffer_del(cache->framebuffer);
+  }
+  memset(ps_video.grid_cachev,0,sizeof(ps_video.grid_cachev));
+  ps_video.grid_cachec=0;
+  ps_video.grid_cachep=0;
+}
+
+static struct ps_video_grid_cache *ps_video_get_grid_cache(const struct ps_grid *grid) {
+
+  struct ps_video_grid_cache *cache=ps_video.grid_cachev;
+  int i=ps_video.grid_cachec; for (;i-->0;cache++) {
+    if (cache->grid==grid) return cache;
+  }
+
+  /* Take the next slot. Once they're all allocated, evict round-robin and keep its framebuffer. */
+  if (ps_video.grid_cachec<PS_VIDEO_GRID_CACHE_LIMIT) {
+    cache=ps_video.grid_cachev+ps_video.grid_cachec;
+    if (!(cache->framebuffer=akgl_framebuffer_new())) return 0;
+    if (
+      (akgl_framebuffer_resize(cache->framebuffer,PS_SCREENW,PS_SCREENH)<0)||
+      !(cache->texture=akgl_texture_from_framebuffer(cache->framebuffer))
+    ) {
+      akgl_framebuffer_del(cache->framebuffer);
+      cache->framebuffer=0;
+      return 0;
+    }
+    ps_video.grid_cachec++;
+  } else {
+    cache=ps_video.grid_cachev+ps_video.grid_cachep;
+    if (++(ps_video.grid_cachep)>=PS_VIDEO_GRID_CACHE_LIMIT) ps_video.grid_cachep=0;
+  }
+  cache->grid=grid;
+  cache->valid=0;
+  return cache;
+}
+
+/* Bring a cached background up to date with its grid, drawing only the cells that changed.
+ * A different grid at the same address is fine; it just looks like a lot of changed cells.
+ * We temporarily switch framebuffers, and restore the main one after.
+ */
+
+static int ps_video_refresh_grid_cache(struct ps_video_grid_cache *cache,const struct ps_grid *grid,struct ps_res_TILESHEET *tilesheet) {
+
+  if (cache->tiles!=tilesheet->texture) {
+    cache->tiles=tilesheet->texture;
+    cache->valid=0;
+  }
+
+  if (ps_video_vtxv_reset(sizeof(struct akgl_vtx_mintile))<0) return -1;
+  const struct ps_grid_cell *cell=grid->cellv;
+  uint8_t *tileid=cache->tileidv;
+  int row=0; for (;row<PS_GRID_ROWC;row++) {
+    int col=0; for (;col<PS_GRID_COLC;col++,cell++,tileid++) {
+      if (cache->valid&&(*tileid==cell->tileid)) continue;
+      struct akgl_vtx_mintile *vtx=ps_video_vtxv_add(1);
+      if (!vtx) return -1;
+      vtx->x=col*PS_TILESIZE+(PS_TILESIZE>>1);
+      vtx->y=row*PS_TILESIZE+(PS_TILESIZE>>1);
+      vtx->tileid=cell->tileid;
+      *tileid=cell->tileid;
+    }
+  }
+  if (!ps_video.vtxc) return 0;
+
+  if (ps_video_flush_cached_drawing()<0) return -1;
+  if (akgl_framebuffer_use(cache->framebuffer)<0) return -1;
+  cache->valid=0;
+
+  /* Tiles might be transparent, so wipe each changed cell first. */
+  if (ps_video.vtxc>=PS_GRID_SIZE) {
+    if (ps_video_draw_rect(0,0,PS_SCREENW,PS_SCREENH,0x000000ff)<0) return -1;
+  } else {
+    const struct akgl_vtx_mintile *vtx=(struct akgl_vtx_mintile*)ps_video.vtxv;
+    int i=ps_video.vtxc; for (;i-->0;vtx++) {
+      if (ps_video_draw_rect(vtx->x-(PS_TILESIZE>>1),vtx->y-(PS_TILESIZE>>1),PS_TILESIZE,PS_TILESIZE,0x000000ff)<0) return -1;
+    }
+  }
+  if (ps_video_flush_cached_drawing()<0) return -1;
+
+  if (akgl_program_mintile_draw(
+    ps_video.program_mintile,tilesheet->texture,(struct akgl_vtx_mintile*)ps_video.vtxv,ps_video.vtxc,PS_TILESIZE,1
+  )<0) return -1;
+
+  if (akgl_framebuffer_use(ps_video.framebuffer)<0) return -1;
+  cache->valid=1;
+  return 0;
+}
+
+/* Draw grid.
+ */
+ 
+int ps_video_draw_grid(const struct ps_grid *grid,int offx,int offy) {
+  if (!grid) return -1;
+
+  if (!grid->region) {
+    ps_log(VIDEO,ERROR,"Can't draw grid without region (is null)");
+    return -1;
+  }
+  struct ps_res_TILESHEET *tilesheet=ps_res_get(PS_RESTYPE_TILESHEET,grid->region->tsid);
+  if (!tilesheet) {
+    ps_log(VIDEO,ERROR,"Tilesheet %d not found, required for grid.",grid->region->tsid);
+    return -1;
+  }
+
+  if (ps_video.grid_cache_disabled) {
+    return ps_video_draw_grid_tiles(grid,tilesheet,offx,offy);
+  }
+
+  struct ps_video_grid_cache *cache=ps_video_get_grid_cache(grid);
+  if (!cache) {
+    ps_log(VIDEO,ERROR,"Failed to allocate grid background.");
+    return -1;
+  }
+  if (ps_video_refresh_grid_cache(cache,grid,tilesheet)<0) return -1;
+
+  /* Framebuffer textures are bottom-up, same as captures. */
+  return ps_video_draw_texture(cache->texture,offx,offy+PS_SCREENH,PS_SCREENW,-PS_SCREENH);
+}
+
+/* Texture and page for a tilesheet.
+ * Sheets in the atlas all resolve to the same texture, so switching among them doesn't break a batch.
+ */
+
+static struct akgl_texture *ps_video_get_tilesheet_texture(int *page,int *pagecolc,uint8_t tsid) {
+  struct ps_res_TILESHEET *tilesheet=ps_res_get(PS_RESTYPE_TILESHEET,tsid);
+  if (!tilesheet) {
+    ps_log(VIDEO,ERROR,"Tilesheet %d not found.",tsid);
+    return 0;
+  }
+  if (ps_video.atlas&&!ps_video.atlas_disabled&&(tilesheet->page>=0)) {
+    *page=tilesheet->page;
+    *pagecolc=PS_VIDEO_ATLAS_COLC;
+    return ps_video.atlas;
+  }
+  *page=0;
+  *pagecolc=1;
+  return tilesheet->texture;
+}
+
 /* Draw sprites.
  */
  
 int ps_video_draw_sprites(const struct ps_sprgrp *grp,int offx,int offy) {
-  if (!grp||(grp->sprc<1)) return 0;
-  int i=0; for (i=0;i<grp->sprc;i++) {
-    struct ps_sprite *spr=grp->sprv[i];
+  if (!grp) return 0;
+  return ps_video_draw_spritev(grp->sprv,grp->sprc,offx,offy);
+}
 
-    /* Flush all commands if the tilesheet has changed. */
-    if (ps_video.vtxc_maxtile&&(ps_video.tsid_maxtile!=spr->tsid)) {
+int ps_video_draw_spritev(struct ps_sprite **sprv,int sprc,int offx,int offy) {
+  if (sprc<1) return 0;
+  struct akgl_texture *texture=0;
+  int page=0,pagecolc=1;
+  uint8_t tsid=0;
+  int i=0; for (i=0;i<sprc;i++) {
+    struct ps_sprite *spr=sprv[i];
+
+    /* Flush all commands if the texture has changed. */
+    if (!texture||(spr->tsid!=tsid)) {
+      tsid=spr->tsid;
+      if (!(texture=ps_video_get_tilesheet_texture(&page,&pagecolc,tsid))) return -1;
+    }
+    if (ps_video.vtxc_maxtile&&(ps_video.texture_maxtile!=texture)) {
       if (ps_video_flush_cached_drawing()<0) return -1;
     }
-    ps_video.tsid_maxtile=spr->tsid;
+    ps_video.texture_maxtile=texture;
+    ps_video.pagecolc_maxtile=pagecolc;
 
     /* Let the sprite add its own vertices. */
     if (ps_video_vtxv_maxtile_require(1)<0) return -1;
@@ -210,9 +362,11 @@ int ps_video_draw_sprites(const struct ps_sprgrp *grp,int offx,int offy) {
       if (ps_video.vtxc_maxtile>ps_video.vtxa_maxtile-err) {
         if (ps_video_vtxv_maxtile_require(err)<0) return -1;
       } else {
-        int j=err; while (j-->0) {
-          ps_video.vtxv_maxtile[ps_video.vtxc_maxtile+j].x+=offx;
-          ps_video.vtxv_maxtile[ps_video.vtxc_maxtile+j].y+=offy;
+        struct akgl_vtx_maxtile *vtx=ps_video.vtxv_maxtile+ps_video.vtxc_maxtile;
+        int j=err; for (;j-->0;vtx++) {
+          vtx->x+=offx;
+          vtx->y+=offy;
+          vtx->page=page;
         }
         ps_video.vtxc_maxtile+=err;
         break;
@@ -230,14 +384,20 @@ int ps_video_draw_mintile(const struct akgl_vtx_mintile *vtxv,int vtxc,uint8_t t
   if ((vtxc<0)||(vtxc&&!vtxv)) return -1;
   if (!vtxc) return 0;
 
-  if (ps_video.vtxc_mintile&&(ps_video.tsid_mintile!=tsid)) {
+  int page,pagecolc;
+  struct akgl_texture *texture=ps_video_get_tilesheet_texture(&page,&pagecolc,tsid);
+  if (!texture) return -1;
+  if (ps_video.vtxc_mintile&&(ps_video.texture_mintile!=texture)) {
     if (ps_video_flush_cached_drawing()<0) return -1;
   }
-  ps_video.tsid_mintile=tsid;
+  ps_video.texture_mintile=texture;
+  ps_video.pagecolc_mintile=pagecolc;
 
   if (ps_video_vtxv_mintile_require(vtxc)<0) return -1;
-  memcpy(ps_video.vtxv_mintile+ps_video.vtxc_mintile,vtxv,sizeof(struct akgl_vtx_mintile)*vtxc);
+  struct akgl_vtx_mintile *dst=ps_video.vtxv_mintile+ps_video.vtxc_mintile;
+  memcpy(dst,vtxv,sizeof(struct akgl_vtx_mintile)*vtxc);
   ps_video.vtxc_mintile+=vtxc;
+  for (;vtxc-->0;dst++) dst->page=page;
   
   return 0;
 }
@@ -247,15 +407,22 @@ int ps_video_draw_mintile(const struct akgl_vtx_mintile *vtxv,int vtxc,uint8_t t
  
 int ps_video_draw_maxtile(const struct akgl_vtx_maxtile *vtxv,int vtxc,uint8_t tsid) {
   if ((vtxc<0)||(vtxc&&!vtxv)) return -1;
+  if (!vtxc) return 0;
 
-  if (ps_video.vtxc_maxtile&&(ps_video.tsid_maxtile!=tsid)) {
+  int page,pagecolc;
+  struct akgl_texture *texture=ps_video_get_tilesheet_texture(&page,&pagecolc,tsid);
+  if (!texture) return -1;
+  if (ps_video.vtxc_maxtile&&(ps_video.texture_maxtile!=texture)) {
     if (ps_video_flush_cached_drawing()<0) return -1;
   }
-  ps_video.tsid_maxtile=tsid;
+  ps_video.texture_maxtile=texture;
+  ps_video.pagecolc_maxtile=pagecolc;
 
   if (ps_video_vtxv_maxtile_require(vtxc)<0) return -1;
-  memcpy(ps_video.vtxv_maxtile+ps_video.vtxc_maxtile,vtxv,sizeof(struct akgl_vtx_maxtile)*vtxc);
+  struct akgl_vtx_maxtile *dst=ps_video.vtxv_maxtile+ps_video.vtxc_maxtile;
+  memcpy(dst,vtxv,sizeof(struct akgl_vtx_maxtile)*vtxc);
   ps_video.vtxc_maxtile+=vtxc;
+  for (;vtxc-->0;dst++) dst->page=page;
   
   return 0;
 }
@@ -309,24 +476,16 @@ int ps_video_flush_cached_drawing() {
   #endif
 
   if (ps_video.vtxc_mintile) {
-    struct ps_res_TILESHEET *tilesheet=ps_res_get(PS_RESTYPE_TILESHEET,ps_video.tsid_mintile);
-    if (!tilesheet) {
-      ps_log(VIDEO,ERROR,"Tilesheet %d not found.",ps_video.tsid_mintile);
-      return -1;
-    }
     if (akgl_program_mintile_draw(
-      ps_video.program_mintile,tilesheet->texture,ps_video.vtxv_mintile,ps_video.vtxc_mintile,PS_TILESIZE
+      ps_video.program_mintile,ps_video.texture_mintile,ps_video.vtxv_mintile,ps_video.vtxc_mintile,PS_TILESIZE,ps_video.pagecolc_mintile
     )<0) return -1;
     ps_video.vtxc_mintile=0;
   }
 
   if (ps_video.vtxc_maxtile) {
-    struct ps_res_TILESHEET *tilesheet=ps_res_get(PS_RESTYPE_TILESHEET,ps_video.tsid_maxtile);
-    if (!tilesheet) {
-      ps_log(RES,ERROR,"Tilesheet %d not found.",ps_video.tsid_maxtile);
-      return -1;
-    }
-    if (akgl_program_maxtile_draw(ps_video.program_maxtile,tilesheet->texture,ps_video.vtxv_maxtile,ps_video.vtxc_maxtile)<0) return -1;
+    if (akgl_program_maxtile_draw(
+      ps_video.program_maxtile,ps_video.texture_maxtile,ps_video.vtxv_maxtile,ps_video.vtxc_maxtile,ps_video.pagecolc_maxtile
+    )<0) return -1;
     ps_video.vtxc_maxtile=0;
   }
 
@@ -30,7 +30,8 @@ static int ps_video_init_akgl(int strategy) {
 
   switch (strategy) {
 
-    case AKGL_STRATEGY_SOFT: {
+    case AKGL_STRATEGY_SOFT:
+    case AKGL_STRATEGY_HEADLESS: {
       } break;
 
     case AKGL_STRATEGY_GL2: {
@@ -133,6 +134,30 @@ int ps_video_init(struct ps_userconfig *userconfig) {
   return 0;
 }
 
+/* Init without a window.
+ */
+
+int ps_video_init_headless() {
+
+  if (ps_video.init) return -1;
+  memset(&ps_video,0,sizeof(struct ps_video));
+  ps_video.init=1;
+  ps_video.headless=1;
+
+  ps_video.winw=PS_SCREENW;
+  ps_video.winh=PS_SCREENH;
+  ps_video.dstw=ps_video.winw;
+  ps_video.dsth=ps_video.winh;
+
+  if (ps_video_init_akgl(AKGL_STRATEGY_HEADLESS)<0) {
+    ps_log(VIDEO,ERROR,"Failed to initialize software renderer.");
+    ps_video_quit();
+    return -1;
+  }
+
+  return 0;
+}
+
 /* Quit.
  */
 
@@ -152,20 +177,24 @@ void ps_video_quit() {
   akgl_program_del(ps_video.program_maxtile);
   akgl_program_del(ps_video.program_textile);
   akgl_texture_del(ps_video.texture_minfont);
+  akgl_texture_del(ps_video.atlas);
+  ps_video_drop_grid_cache();
   akgl_framebuffer_del(ps_video.framebuffer);
   akgl_quit();
 
-  #if PS_USE_macwm
-    ps_macwm_quit();
-  #elif PS_USE_bcm
-    ps_bcm_quit();
-  #elif PS_USE_drm
-    ps_drm_quit();
-  #elif PS_USE_glx
-    ps_glx_quit();
-  #elif PS_USE_mswm
-    ps_mswm_quit();
-  #endif
+  if (!ps_video.headless) {
+    #if PS_USE_macwm
+      ps_macwm_quit();
+    #elif PS_USE_bcm
+      ps_bcm_quit();
+    #elif PS_USE_drm
+      ps_drm_quit();
+    #elif PS_USE_glx
+      ps_glx_quit();
+    #elif PS_USE_mswm
+      ps_mswm_quit();
+    #endif
+  }
 
   if (ps_video.vtxv) free(ps_video.vtxv);
   if (ps_video.vtxv_triangle) free(ps_video.vtxv_triangle);
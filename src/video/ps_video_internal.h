@@ -35,11 +35,33 @@
 
 #define PS_VIDEO_ASPECT_TOLERANCE 0.030
 
+/* How many screens of grid background we keep rendered at once.
+ * Normally only one grid is drawn per frame; the extras spare a redraw when players step back and forth across an edge.
+ */
+#define PS_VIDEO_GRID_CACHE_LIMIT 4
+
+/* Tilesheet atlas: So many pages in each direction, each one a 256x256 RGBA tilesheet.
+ * Sheets of any other size or format keep their own texture.
+ */
+#define PS_VIDEO_ATLAS_COLC 4
+#define PS_VIDEO_ATLAS_PAGE_LIMIT (PS_VIDEO_ATLAS_COLC*PS_VIDEO_ATLAS_COLC)
+#define PS_VIDEO_ATLAS_PAGE_SIZE 256
+
+struct ps_video_grid_cache {
+  const struct ps_grid *grid; // WEAK, only for matching. Never dereferenced.
+  struct akgl_framebuffer *framebuffer;
+  struct akgl_texture *texture; // View of (framebuffer).
+  const struct akgl_texture *tiles; // WEAK, only for matching: Tilesheet texture at the last draw.
+  int valid; // Nonzero if (tileidv) describes what's actually in (framebuffer).
+  uint8_t tileidv[PS_GRID_SIZE]; // Tile currently drawn in each cell.
+};
+
 /* Globals.
  *****************************************************************************/
 
 extern struct ps_video {
   int init;
+  int headless; // No window; don't quit the window manager.
   
   int winw,winh; // Size of the output graphics context (ie the main window)
   int dstx,dsty,dstw,dsth; // Boundaries for framebuffer copy, in (0,0)..(winw,winh).
@@ -73,10 +95,23 @@ extern struct ps_video {
   int vtxc_textile,vtxa_textile;
   struct akgl_vtx_maxtile *vtxv_maxtile;
   int vtxc_maxtile,vtxa_maxtile;
-  uint8_t tsid_maxtile;
+  struct akgl_texture *texture_maxtile; // WEAK: tilesheet or atlas.
+  int pagecolc_maxtile;
   struct akgl_vtx_mintile *vtxv_mintile;
   int vtxc_mintile,vtxa_mintile;
-  uint8_t tsid_mintile;
+  struct akgl_texture *texture_mintile; // WEAK: tilesheet or atlas.
+  int pagecolc_mintile;
+
+  // Tilesheet atlas, see ps_video_atlas_add().
+  struct akgl_texture *atlas;
+  uint8_t atlas_usev[PS_VIDEO_ATLAS_PAGE_LIMIT];
+  int atlas_disabled;
+
+  // Grid backgrounds, see ps_video_draw_grid().
+  struct ps_video_grid_cache grid_cachev[PS_VIDEO_GRID_CACHE_LIMIT];
+  int grid_cachec;
+  int grid_cachep; // Next to evict, once full.
+  int grid_cache_disabled;
   
 } ps_video;
 
@@ -99,4 +134,6 @@ int ps_video_vtxv_mintile_require(int addc);
 
 int ps_video_redraw_game_only();
 
+void ps_video_drop_grid_cache();
+
 #endif